@@ -1383,6 +1383,12 @@ void CCallStack::PrintBugReport(EXCEPTION_POINTERS* Exception, DWORD ThreadID, D
         PrintLine(param, buf, TRUE);
         sprintf(buf, "UseAsyncCopyAlg = %d", Configuration.UseAsyncCopyAlg);
         PrintLine(param, buf, TRUE);
+        sprintf(buf, "UseParallelCopy = %d", Configuration.UseParallelCopy);
+        PrintLine(param, buf, TRUE);
+        sprintf(buf, "HashCacheMaxItems = %u", Configuration.HashCacheMaxItems);
+        PrintLine(param, buf, TRUE);
+        sprintf(buf, "ThumbnailCacheMaxSize = %u", Configuration.ThumbnailCacheMaxSize);
+        PrintLine(param, buf, TRUE);
         sprintf(buf, "ReloadEnvVariables = %d", Configuration.ReloadEnvVariables);
         PrintLine(param, buf, TRUE);
         sprintf(buf, "AutoSave = %d", Configuration.AutoSave);
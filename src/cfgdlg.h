@@ -214,6 +214,7 @@ struct CConfiguration
         UseSalOpen,             // should salopen.exe be used (otherwise association runs directly)
         NetwareFastDirMove,     // should fast-dir-move (rename directories) be used on the Novell Netware? (otherwise rename files only, directories are created + old empty ones deleted) (REASON: for some users, fast-dir-move works on Novell and they don’t want to wait)
         UseAsyncCopyAlg,        // Win7+ only (older OS: always FALSE): should asynchronous file copy algorithm be used on network drives?
+        UseParallelCopy,        // should small files be copied by several threads at once (only between local fast disks)?
         ReloadEnvVariables,     // should we perform regeneration when environment variables change??
         QuickRenameSelectAll,   // Quick Rename/Pack selects everything (not just the name) (users disliked the new selection)
         EditNewSelectAll,       // EditNew should select everything (not just the name). users requested a separate option because some always create .TXT (and are fine with overwriting just the name) while others use different extensions and want to overwrite the entire filename
@@ -285,6 +286,9 @@ struct CConfiguration
 
     DWORD LastUsedSpeedLimit; // remembers the last used speed limit (users often repeat one number)
 
+    DWORD HashCacheMaxItems; // max. number of file digests kept in the persistent digest cache (see CFileHashCache); 0 = cache disabled
+    DWORD ThumbnailCacheMaxSize; // max. size (in MB) of thumbnails kept in the persistent thumbnail cache (see CThumbnailDiskCache); 0 = cache disabled
+
     BOOL QuickSearchEnterAlt; // if it is TRUE, Quick Search is activated via Alt+letter
 
     // for displaying the items in the panel
@@ -362,7 +366,8 @@ struct CConfiguration
 
     BOOL AutoCopySelection; // automatically copy selection to the clipboard
 
-    BOOL GoToOffsetIsHex; // TRUE = offset entered as hex, otherwise decimal
+    BOOL GoToOffsetIsHex;  // TRUE = offset entered as hex, otherwise decimal
+    BOOL GoToOffsetIsLine; // TRUE = a line number is entered instead of an offset
 
     // rebar
     int MenuIndex; // zero-based order of the band in the rebar
@@ -0,0 +1,61 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// ****************************************************************************
+// detection of the processor features that select the SIMD code paths; used by Salamander
+// and by its own plugins (not part of the plugin SDK), from both C and C++ sources
+// ****************************************************************************
+
+#pragma once
+
+#include <intrin.h>
+#include <immintrin.h>
+
+// bits returned by GetCPUFeatures()
+#define CPUF_SSE2 0x0001
+#define CPUF_SSSE3 0x0002
+#define CPUF_SSE41 0x0004
+#define CPUF_PCLMULQDQ 0x0008
+#define CPUF_AVX2 0x0010 // including the support of the system (it saves the YMM registers)
+#define CPUF_SHA 0x0020  // SHA extensions (SHA-NI)
+
+#define CPUF_DETECTED 0x80000000 // internal: the features were detected already
+
+// returns the CPUF_XXX features of the processor; they are detected on the first call in each
+// module, a race of several threads does not matter (all of them store the same value)
+static __inline unsigned int GetCPUFeatures(void)
+{
+    static volatile unsigned int features = 0;
+    if (features == 0)
+    {
+        unsigned int f = CPUF_DETECTED;
+        int info[4];
+        int maxLeaf;
+        __cpuid(info, 0);
+        maxLeaf = info[0];
+        if (maxLeaf >= 1)
+        {
+            __cpuid(info, 1);
+            if (info[3] & (1 << 26))
+                f |= CPUF_SSE2;
+            if (info[2] & (1 << 9))
+                f |= CPUF_SSSE3;
+            if (info[2] & (1 << 19))
+                f |= CPUF_SSE41;
+            if (info[2] & (1 << 1))
+                f |= CPUF_PCLMULQDQ;
+            if (maxLeaf >= 7)
+            {
+                int avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && // OSXSAVE + AVX
+                          (_xgetbv(0) & 6) == 6;                            // the system saves XMM and YMM registers
+                __cpuidex(info, 7, 0);
+                if (avx && (info[1] & (1 << 5)))
+                    f |= CPUF_AVX2;
+                if (info[1] & (1 << 29))
+                    f |= CPUF_SHA;
+            }
+        }
+        features = f;
+    }
+    return features;
+}
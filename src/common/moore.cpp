@@ -8,6 +8,9 @@
 #include <ostream>
 #include <limits.h>
 #include <commctrl.h> // potrebuju LPCOLORMAP
+#include <intrin.h>
+#include <emmintrin.h>
+#include <immintrin.h>
 
 #if defined(_DEBUG) && defined(_MSC_VER) // without passing file+line to 'new' operator, list of memory leaks shows only 'crtdbg.h(552)'
 #define new new (_NORMAL_BLOCK, __FILE__, __LINE__)
@@ -21,6 +24,7 @@
 
 #include "str.h"
 #include "moore.h"
+#include "cpufeat.h"
 
 //
 // ****************************************************************************
@@ -148,6 +152,7 @@ void CSearchData::SetFlags(WORD flags)
         }
     }
     Initialize();
+    InitializeSIMD();
 }
 
 void CSearchData::Set(const char* pattern, WORD flags)
@@ -203,3 +208,287 @@ void CSearchData::Set(const char* pattern, const int length, WORD flags)
     }
     SetFlags(flags);
 }
+
+//
+// ****************************************************************************
+// SIMD varianty hledani
+//
+// Misto posouvani vzorku podle Fail1/Fail2 se naraz testuje 16 (SSE2) nebo 32 (AVX2)
+// moznych zacatku vyskytu: porovna se prvni a posledni znak vyskytu se vsemi znaky
+// textu, ktere jim odpovidaji (pri hledani bez ohledu na velikost pismen jde o vsechny
+// znaky, ktere LowerCase mapuje na znak vzorku), a jen pozice, kde sedi oba, se overi
+// cele. AVX2 varianta je v samostatnych funkcich, aby se nemichaly VEX a SSE instrukce.
+
+int CSearchData::SIMDLevel = -1;
+
+int CSearchData::GetSIMDLevel()
+{
+    if (SIMDLevel == -1)
+    {
+        unsigned int features = GetCPUFeatures();
+        SIMDLevel = (features & CPUF_AVX2) != 0 ? 2 : (features & CPUF_SSE2) != 0 ? 1 : 0;
+    }
+    return SIMDLevel;
+}
+
+void CSearchData::InitializeSIMD()
+{
+    UseSIMD = FALSE;
+    FirstVariantsCount = LastVariantsCount = 0;
+    if (Pattern == NULL || Length <= 0 || GetSIMDLevel() == 0)
+        return;
+
+    BYTE first = (BYTE)Pattern[0];
+    BYTE last = (BYTE)Pattern[Length - 1];
+    if (Flags & sfCaseSensitive)
+    {
+        FirstVariants[FirstVariantsCount++] = first;
+        LastVariants[LastVariantsCount++] = last;
+    }
+    else
+    {
+        int c;
+        for (c = 0; c < 256; c++)
+        {
+            if (LowerCase[c] == first)
+            {
+                if (FirstVariantsCount == SEARCH_MAX_VARIANTS)
+                    return; // prilis mnoho variant, zustaneme u Boyer-Moora
+                FirstVariants[FirstVariantsCount++] = (BYTE)c;
+            }
+            if (LowerCase[c] == last)
+            {
+                if (LastVariantsCount == SEARCH_MAX_VARIANTS)
+                    return; // prilis mnoho variant, zustaneme u Boyer-Moora
+                LastVariants[LastVariantsCount++] = (BYTE)c;
+            }
+        }
+        if (FirstVariantsCount == 0 || LastVariantsCount == 0)
+            return; // LowerCase neni idempotentni, SIMD varianta by nic nenasla
+    }
+    UseSIMD = TRUE;
+}
+
+BOOL CSearchData::Verify(const BYTE* text, BOOL reversed)
+{
+    const BYTE* pat = (const BYTE*)Pattern;
+    int i;
+    if (!reversed)
+    {
+        if (Flags & sfCaseSensitive)
+            return memcmp(text, pat, Length) == 0;
+        for (i = 0; i < Length; i++)
+        {
+            if (LowerCase[text[i]] != pat[i])
+                return FALSE;
+        }
+    }
+    else
+    {
+        const BYTE* patEnd = pat + Length - 1;
+        if (Flags & sfCaseSensitive)
+        {
+            for (i = 0; i < Length; i++)
+            {
+                if (text[i] != patEnd[-i])
+                    return FALSE;
+            }
+        }
+        else
+        {
+            for (i = 0; i < Length; i++)
+            {
+                if (LowerCase[text[i]] != patEnd[-i])
+                    return FALSE;
+            }
+        }
+    }
+    return TRUE;
+}
+
+// vraci masku pozic v bloku 'block', kde je jeden ze znaku 'variants' ('count' je 1 az SEARCH_MAX_VARIANTS)
+static inline __m128i MatchVariantsSSE2(__m128i block, const __m128i* variants, int count)
+{
+    __m128i eq = _mm_cmpeq_epi8(block, variants[0]);
+    int k;
+    for (k = 1; k < count; k++)
+        eq = _mm_or_si128(eq, _mm_cmpeq_epi8(block, variants[k]));
+    return eq;
+}
+
+static inline __m256i MatchVariantsAVX2(__m256i block, const __m256i* variants, int count)
+{
+    __m256i eq = _mm256_cmpeq_epi8(block, variants[0]);
+    int k;
+    for (k = 1; k < count; k++)
+        eq = _mm256_or_si256(eq, _mm256_cmpeq_epi8(block, variants[k]));
+    return eq;
+}
+
+// AVX2 cast SearchForwardSIMD: testuje zacatky vyskytu od '*pos' po 32 dokud je
+// '*pos' + 31 <= 'last'; vraci pozici vyskytu nebo -1 (v '*pos' je pak pozice, kde
+// ma pokracovat SSE2 a skalarni cast)
+static int SearchForwardAVX2(const BYTE* t, int* pos, int last, int length,
+                             const BYTE* firstVariants, int firstCount,
+                             const BYTE* lastVariants, int lastCount,
+                             CSearchData* data)
+{
+    __m256i fv[SEARCH_MAX_VARIANTS];
+    __m256i lv[SEARCH_MAX_VARIANTS];
+    int k;
+    for (k = 0; k < firstCount; k++)
+        fv[k] = _mm256_set1_epi8((char)firstVariants[k]);
+    for (k = 0; k < lastCount; k++)
+        lv[k] = _mm256_set1_epi8((char)lastVariants[k]);
+    int p = *pos;
+    int found = -1;
+    while (found == -1 && p + 31 <= last)
+    {
+        __m256i ef = MatchVariantsAVX2(_mm256_loadu_si256((const __m256i*)(t + p)), fv, firstCount);
+        __m256i el = MatchVariantsAVX2(_mm256_loadu_si256((const __m256i*)(t + p + length - 1)), lv, lastCount);
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_and_si256(ef, el));
+        while (mask != 0)
+        {
+            unsigned long bit;
+            _BitScanForward(&bit, mask);
+            if (data->Verify(t + p + bit, FALSE))
+            {
+                found = p + (int)bit;
+                break;
+            }
+            mask &= mask - 1;
+        }
+        p += 32;
+    }
+    _mm256_zeroupper();
+    *pos = p;
+    return found;
+}
+
+// AVX2 cast SearchBackwardSIMD: testuje zacatky vyskytu od '*pos' dolu po 32 dokud je
+// '*pos' - 31 >= 0; vraci pozici vyskytu nebo -1 (v '*pos' je pak pozice, kde ma
+// pokracovat SSE2 a skalarni cast)
+static int SearchBackwardAVX2(const BYTE* t, int* pos, int length,
+                              const BYTE* firstVariants, int firstCount,
+                              const BYTE* lastVariants, int lastCount,
+                              CSearchData* data)
+{
+    __m256i fv[SEARCH_MAX_VARIANTS];
+    __m256i lv[SEARCH_MAX_VARIANTS];
+    int k;
+    for (k = 0; k < firstCount; k++)
+        fv[k] = _mm256_set1_epi8((char)firstVariants[k]);
+    for (k = 0; k < lastCount; k++)
+        lv[k] = _mm256_set1_epi8((char)lastVariants[k]);
+    int p = *pos;
+    int found = -1;
+    while (found == -1 && p - 31 >= 0)
+    {
+        int base = p - 31;
+        __m256i ef = MatchVariantsAVX2(_mm256_loadu_si256((const __m256i*)(t + base)), fv, firstCount);
+        __m256i el = MatchVariantsAVX2(_mm256_loadu_si256((const __m256i*)(t + base + length - 1)), lv, lastCount);
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_and_si256(ef, el));
+        while (mask != 0)
+        {
+            unsigned long bit;
+            _BitScanReverse(&bit, mask);
+            if (data->Verify(t + base + bit, TRUE))
+            {
+                found = base + (int)bit;
+                break;
+            }
+            mask &= ~(1u << bit);
+        }
+        p -= 32;
+    }
+    _mm256_zeroupper();
+    *pos = p;
+    return found;
+}
+
+int CSearchData::SearchForwardSIMD(const char* text, int length, int start)
+{
+    const BYTE* t = (const BYTE*)text;
+    int last = length - Length; // posledni mozny zacatek vyskytu
+    int p = start;
+    if (SIMDLevel == 2)
+    {
+        int found = SearchForwardAVX2(t, &p, last, Length, FirstVariants, FirstVariantsCount,
+                                      LastVariants, LastVariantsCount, this);
+        if (found != -1)
+            return found;
+    }
+
+    __m128i fv[SEARCH_MAX_VARIANTS];
+    __m128i lv[SEARCH_MAX_VARIANTS];
+    int k;
+    for (k = 0; k < FirstVariantsCount; k++)
+        fv[k] = _mm_set1_epi8((char)FirstVariants[k]);
+    for (k = 0; k < LastVariantsCount; k++)
+        lv[k] = _mm_set1_epi8((char)LastVariants[k]);
+    while (p + 15 <= last)
+    {
+        __m128i ef = MatchVariantsSSE2(_mm_loadu_si128((const __m128i*)(t + p)), fv, FirstVariantsCount);
+        __m128i el = MatchVariantsSSE2(_mm_loadu_si128((const __m128i*)(t + p + Length - 1)), lv, LastVariantsCount);
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(ef, el));
+        while (mask != 0)
+        {
+            unsigned long bit;
+            _BitScanForward(&bit, mask);
+            if (Verify(t + p + bit, FALSE))
+                return p + (int)bit;
+            mask &= mask - 1;
+        }
+        p += 16;
+    }
+    for (; p <= last; p++) // zbytek, na ktery uz nestaci cely blok
+    {
+        if (Verify(t + p, FALSE))
+            return p;
+    }
+    return -1;
+}
+
+int CSearchData::SearchBackwardSIMD(const char* text, int length)
+{
+    const BYTE* t = (const BYTE*)text;
+    int p = length - Length; // posledni mozny zacatek vyskytu, jdeme od nej dolu
+    // pri hledani pozpatku je Pattern obraceny: prvni znak vyskytu je Pattern[Length - 1]
+    if (SIMDLevel == 2)
+    {
+        int found = SearchBackwardAVX2(t, &p, Length, LastVariants, LastVariantsCount,
+                                       FirstVariants, FirstVariantsCount, this);
+        if (found != -1)
+            return found;
+    }
+
+    __m128i fv[SEARCH_MAX_VARIANTS];
+    __m128i lv[SEARCH_MAX_VARIANTS];
+    int k;
+    for (k = 0; k < LastVariantsCount; k++)
+        fv[k] = _mm_set1_epi8((char)LastVariants[k]);
+    for (k = 0; k < FirstVariantsCount; k++)
+        lv[k] = _mm_set1_epi8((char)FirstVariants[k]);
+    while (p - 15 >= 0)
+    {
+        int base = p - 15;
+        __m128i ef = MatchVariantsSSE2(_mm_loadu_si128((const __m128i*)(t + base)), fv, LastVariantsCount);
+        __m128i el = MatchVariantsSSE2(_mm_loadu_si128((const __m128i*)(t + base + Length - 1)), lv, FirstVariantsCount);
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(ef, el));
+        while (mask != 0)
+        {
+            unsigned long bit;
+            _BitScanReverse(&bit, mask);
+            if (Verify(t + base + bit, TRUE))
+                return base + (int)bit;
+            mask &= ~(1u << bit);
+        }
+        p -= 16;
+    }
+    for (; p >= 0; p--) // zbytek, na ktery uz nestaci cely blok
+    {
+        if (Verify(t + p, TRUE))
+            return p;
+    }
+    return -1;
+}
@@ -11,6 +11,10 @@
 #define sfCaseSensitive 0x01 // 0. bit = 1
 #define sfForward 0x02       // 1. bit = 1
 
+// maximalni pocet znaku, ktere se pri hledani bez ohledu na velikost pismen mapuji na jeden
+// znak vzorku (LowerCase); pri vetsim poctu se nepouziva SIMD varianta hledani
+#define SEARCH_MAX_VARIANTS 4
+
 // ****************************************************************************
 
 class CSearchData
@@ -23,6 +27,8 @@ public:
         Length = 0;
         Pattern = NULL;
         Flags = 0;
+        UseSIMD = FALSE;
+        FirstVariantsCount = LastVariantsCount = 0;
     }
 
     ~CSearchData()
@@ -56,6 +62,19 @@ public:
     inline int SearchForward(const char* text, int length, int start);
     inline int SearchBackward(const char* text, int length);
 
+    // varianty hledani bez Boyer-Moorova algoritmu: po 16 (SSE2) nebo 32 (AVX2) bytech se
+    // hledaji pozice, kde sedi prvni a posledni znak vzorku, a ty se pak overi cele;
+    // volaji se ze SearchForward/SearchBackward, pokud je UseSIMD TRUE
+    int SearchForwardSIMD(const char* text, int length, int start);
+    int SearchBackwardSIMD(const char* text, int length);
+
+    // vraci uroven SIMD instrukci pouzitelnych pro hledani: 0 = zadne, 1 = SSE2, 2 = AVX2
+    static int GetSIMDLevel();
+
+    // overi, jestli na 'text' zacina vyskyt vzorku (text musi mit aspon Length znaku);
+    // 'reversed' je TRUE pro SearchBackward (Pattern je obraceny)
+    BOOL Verify(const BYTE* text, BOOL reversed);
+
 protected:
     int Minimum(int a, int b) { return (a < b) ? a : b; }
     int Maximum(int a, int b) { return (a > b) ? a : b; }
@@ -66,8 +85,17 @@ protected:
     char* Pattern;         // vzorek ke hledani v prislusnem tvaru (Flag)
     int Length;            // delka vzorku
 
+    BOOL UseSIMD;                            // TRUE = hledat pres SearchForwardSIMD/SearchBackwardSIMD
+    BYTE FirstVariants[SEARCH_MAX_VARIANTS]; // znaky textu odpovidajici Pattern[0]
+    int FirstVariantsCount;                  // pocet platnych znaku ve FirstVariants
+    BYTE LastVariants[SEARCH_MAX_VARIANTS];  // znaky textu odpovidajici Pattern[Length - 1]
+    int LastVariantsCount;                   // pocet platnych znaku v LastVariants
+
+    static int SIMDLevel; // viz GetSIMDLevel(); -1 = jeste nezjisteno
+
 private:
-    BOOL Initialize(); // vola se jen ze SetFlags
+    BOOL Initialize();     // vola se jen ze SetFlags
+    void InitializeSIMD(); // vola se jen ze SetFlags
 
     WORD Flags; // menit pres SetFlags
 };
@@ -83,6 +111,8 @@ private:
 
 int CSearchData::SearchForward(const char* text, int length, int start)
 {
+    if (UseSIMD)
+        return SearchForwardSIMD(text, length, start);
     int l1 = Length - 1;
     int i, j = l1 + start;
     if (Flags & sfCaseSensitive)
@@ -128,6 +158,8 @@ int CSearchData::SearchForward(const char* text, int length, int start)
 
 int CSearchData::SearchBackward(const char* text, int length)
 {
+    if (UseSIMD)
+        return SearchBackwardSIMD(text, length);
     int l1 = Length - 1;
     int l2 = length - 1;
     int i, j = l1;
@@ -177,20 +177,85 @@ BOOL CRegularExpression::SetFlags(WORD flags)
             LastError = LastErrorText = RegExpErrorText(reeLowMemory);
     }
 
+    if (Expression != NULL && LastErrorText == NULL)
+        BuildDFA(pattern);
+    else
+        FreeDFA();
+
     if ((Flags & sfCaseSensitive) == 0)
         free(pattern);
     return Expression != NULL && LastErrorText == NULL;
 }
 
-BOOL CRegularExpression::SetLine(const char* start, const char* end)
+void CRegularExpression::BuildDFA(char* pattern)
+{
+    FreeDFA();
+
+    // pro dohledani zacatku shody je potreba program pro opacny smer cteni textu
+    const char* oldLastError = LastError;
+    const char* errText;
+    regexp* reverse = NULL;
+    if (Flags & sfForward)
+    {
+        int len = (int)strlen(pattern);
+        char* backwardPat = (char*)malloc(len + 1);
+        if (backwardPat != NULL)
+        {
+            char* end = backwardPat + len;
+            *end = 0;
+            ReverseRegExp(end, pattern, pattern + len);
+            reverse = regcomp(backwardPat, errText);
+            free(backwardPat);
+        }
+    }
+    else
+        reverse = regcomp(pattern, errText); // Expression je zkompilovany z obraceneho vyrazu
+    LastError = oldLastError;
+    if (reverse == NULL)
+        return; // zustaneme jen u backtrackingu
+
+    BOOL caseSensitive = (Flags & sfCaseSensitive) != 0;
+    DFA = new CRegExpDFA;
+    ReverseDFA = new CRegExpDFA;
+    if (DFA == NULL || ReverseDFA == NULL ||
+        !DFA->Init(Expression, caseSensitive, FALSE) ||
+        !ReverseDFA->Init(reverse, caseSensitive, TRUE))
+    {
+        FreeDFA();
+    }
+    free(reverse);
+}
+
+void CRegularExpression::FreeDFA()
 {
-    if (Allocated < (end - start) + 1)
+    if (DFA != NULL)
+        delete DFA;
+    DFA = NULL;
+    if (ReverseDFA != NULL)
+        delete ReverseDFA;
+    ReverseDFA = NULL;
+}
+
+BOOL CRegularExpression::SetLine(const char* start, const char* end, BOOL copyText)
+{
+    OrigLineStart = start;
+    LineLength = (int)(end - start);
+    LineCopied = FALSE;
+    if (DFA == NULL || copyText)
+        return CopyLine();
+    LastErrorText = NULL;
+    return TRUE;
+}
+
+BOOL CRegularExpression::CopyLine()
+{
+    if (Allocated < LineLength + 1)
     {
-        char* newLine = (char*)realloc(Line, (end - start) + 1);
+        char* newLine = (char*)realloc(Line, LineLength + 1);
         if (newLine != NULL)
         {
             Line = newLine;
-            Allocated = (int)(end - start) + 1;
+            Allocated = LineLength + 1;
         }
         else
         {
@@ -199,8 +264,8 @@ BOOL CRegularExpression::SetLine(const char* start, const char* end)
         }
     }
 
-    OrigLineStart = start;
-    LineLength = (int)(end - start);
+    const char* start = OrigLineStart;
+    const char* end = OrigLineStart + LineLength;
     if (Flags & sfForward)
     {
         if (Flags & sfCaseSensitive)
@@ -233,13 +298,55 @@ BOOL CRegularExpression::SetLine(const char* start, const char* end)
             *l = 0;
         }
     }
+    LineCopied = TRUE;
     LastErrorText = NULL;
     return TRUE;
 }
 
+int CRegularExpression::SearchDFA(int start, int& foundStart, int& foundEnd)
+{
+    // pozice 'i' prochazeneho textu je pri hledani dopredu znak OrigLineStart[i],
+    // pri hledani pozpatku znak OrigLineStart[LineLength - 1 - i]
+    const BYTE* text = (const BYTE*)OrigLineStart;
+    BOOL forward = (Flags & sfForward) != 0;
+
+    // konec prvni shody (stejne jako by ji nasel backtracking)
+    int len = DFA->Scan(forward ? text + start : text + LineLength - 1 - start, forward ? 1 : -1,
+                        LineLength - start, start == 0, TRUE);
+    if (len == -1)
+        return 0;
+    if (len < 0)
+        return -1;
+    foundEnd = start + len;
+
+    // zacatek shody: nejdelsi shoda obraceneho vyrazu ctena od konce shody zpet k 'start';
+    // konec radky je za shodou i tehdy, kdyz za ni nasleduje NUL (viz Scan)
+    BOOL endIsEOL = foundEnd == LineLength || (forward ? text[foundEnd] : text[LineLength - 1 - foundEnd]) == 0;
+    len = ReverseDFA->Scan(forward ? text + foundEnd - 1 : text + LineLength - foundEnd, forward ? -1 : 1,
+                           foundEnd - start, endIsEOL, start == 0);
+    if (len < 0)
+        return -1; // nemelo by nastat (shoda existuje), radsi to nechame na backtrackingu
+    foundStart = foundEnd - len;
+    return 1;
+}
+
 int CRegularExpression::SearchForward(int start, int& foundLen)
 {
-    if (start <= LineLength && regexec(Expression, Line, start) == 1)
+    if (start < 0 || start > LineLength)
+        return -1;
+    if (!LineCopied)
+    {
+        int foundStart, foundEnd;
+        int res = SearchDFA(start, foundStart, foundEnd);
+        if (res == 1)
+        {
+            foundLen = foundEnd - foundStart;
+            return foundStart;
+        }
+        if (res == 0 || !CopyLine())
+            return -1;
+    }
+    if (regexec(Expression, Line, start) == 1)
     {
         foundLen = (int)(Expression->endp[0] - Expression->startp[0]);
         return (int)(Expression->startp[0] - Line);
@@ -250,7 +357,21 @@ int CRegularExpression::SearchForward(int start, int& foundLen)
 
 int CRegularExpression::SearchBackward(int length, int& foundLen)
 {
-    if (length >= 0 && regexec(Expression, Line, LineLength - length) == 1)
+    if (length < 0 || length > LineLength)
+        return -1;
+    if (!LineCopied)
+    {
+        int foundStart, foundEnd;
+        int res = SearchDFA(LineLength - length, foundStart, foundEnd);
+        if (res == 1)
+        {
+            foundLen = foundEnd - foundStart;
+            return LineLength - foundEnd;
+        }
+        if (res == 0 || !CopyLine())
+            return -1;
+    }
+    if (regexec(Expression, Line, LineLength - length) == 1)
     {
         foundLen = (int)(Expression->endp[0] - Expression->startp[0]);
         return (int)(LineLength - (Expression->endp[0] - Line));
@@ -304,6 +425,8 @@ BOOL CRegularExpression::ExpandVariables(char* pattern, char* buffer, int bufSiz
 int CRegularExpression::ReplaceForward(int start, char* pattern, BOOL global,
                                        char* buffer, int bufSize)
 {
+    if (!LineCopied && !CopyLine()) // zachycene zavorky umi jen backtracking
+        return FALSE;
     BOOL ret = FALSE;
     char* output = buffer;
     int len;
@@ -1543,3 +1666,615 @@ char* regnext(char* p)
     else
         return (p + offset);
 }
+
+//*****************************************************************************
+//*****************************************************************************
+//
+// CRegExpDFA
+//
+//*****************************************************************************
+//*****************************************************************************
+
+#define DFA_MAX_MEMORY (1024 * 1024) // limit pameti pro cache stavu DFA (na jeden CRegExpDFA)
+#define DFA_HASH_SIZE 4096           // pocet slotu rozptylovaci tabulky stavu (mocnina dvou)
+#define DFA_MIN_FLUSH_DISTANCE 1024  // pri castejsim vyprazdnovani cache se DFA nevyplati
+
+// typy instrukci NFA
+#define riChar 0  // precte znak z mnoziny CharSet a pokracuje na Out
+#define riSplit 1 // pokracuje na Out a s nizsi prioritou na Out1
+#define riNop 2   // pokracuje na Out
+#define riBOL 3   // pokracuje na Out jen na zacatku radky
+#define riEOL 4   // pokracuje na Out jen na konci radky
+#define riMatch 5 // shoda nalezena
+#define riFail 6  // vlakno konci (uzel bez naslednika)
+
+struct CRegExpInst
+{
+    BYTE Type;   // riXXX
+    int Out;     // nasledujici instrukce
+    int Out1;    // mene prioritni vetev (jen riSplit)
+    int CharSet; // index mnoziny znaku v CharSets (jen riChar)
+};
+
+// stav DFA = usporadany (podle priority) seznam instrukci NFA, ktere cekaji na dalsi znak
+// (riChar) nebo na konec radky (riEOL)
+struct CRegExpDFAState
+{
+    CRegExpDFAState* HashNext; // dalsi stav ve stejnem slotu HashTable
+    DWORD Hash;
+    BOOL Match;             // v tomto miste textu konci shoda
+    BOOL Unanchored;        // na dalsich pozicich se pridavaji vlakna pro nove zacatky shody
+    int EOLMatch;           // -1 = nezjisteno, jinak TRUE/FALSE = shoda, pokud tu konci radka
+    int Count;              // pocet instrukci v Insts
+    CRegExpDFAState** Next; // prechody podle tridy znaku (NULL = jeste nespocitany)
+    int* Insts;             // instrukce NFA
+};
+
+CRegExpDFA::CRegExpDFA()
+{
+    Longest = FALSE;
+    Insts = NULL;
+    InstCount = 0;
+    StartInst = 0;
+    CharSets = NULL;
+    CharSetCount = 0;
+    ClassCount = 0;
+    HashTable = NULL;
+    StartStates[0] = StartStates[1] = NULL;
+    CacheSize = 0;
+    CacheFull = FALSE;
+    Mark = NULL;
+    Generation = 0;
+    Stack = NULL;
+    WorkList = NULL;
+    WorkCount = 0;
+    SaveList = NULL;
+}
+
+CRegExpDFA::~CRegExpDFA()
+{
+    Release();
+}
+
+void CRegExpDFA::Release()
+{
+    Flush();
+    if (HashTable != NULL)
+        free(HashTable);
+    HashTable = NULL;
+    if (Insts != NULL)
+        free(Insts);
+    Insts = NULL;
+    InstCount = 0;
+    if (CharSets != NULL)
+        free(CharSets);
+    CharSets = NULL;
+    CharSetCount = 0;
+    if (Mark != NULL)
+        free(Mark);
+    Mark = NULL;
+    if (Stack != NULL)
+        free(Stack);
+    Stack = NULL;
+    if (WorkList != NULL)
+        free(WorkList);
+    WorkList = NULL;
+    if (SaveList != NULL)
+        free(SaveList);
+    SaveList = NULL;
+}
+
+void CRegExpDFA::Flush()
+{
+    if (HashTable != NULL)
+    {
+        int i;
+        for (i = 0; i < DFA_HASH_SIZE; i++)
+        {
+            CRegExpDFAState* state = HashTable[i];
+            while (state != NULL)
+            {
+                CRegExpDFAState* next = state->HashNext;
+                free(state);
+                state = next;
+            }
+            HashTable[i] = NULL;
+        }
+    }
+    StartStates[0] = StartStates[1] = NULL;
+    CacheSize = 0;
+    CacheFull = FALSE;
+}
+
+int CRegExpDFA::AddInst(BYTE type, int out, int out1, int charSet)
+{
+    CRegExpInst* inst = Insts + InstCount;
+    inst->Type = type;
+    inst->Out = out;
+    inst->Out1 = out1;
+    inst->CharSet = charSet;
+    return InstCount++;
+}
+
+int CRegExpDFA::AddCharSet(BYTE c)
+{
+    BYTE* set = CharSets + 32 * CharSetCount;
+    memset(set, 0, 32);
+    if (c != 0)
+        set[c >> 3] |= (BYTE)(1 << (c & 7));
+    return CharSetCount++;
+}
+
+int CRegExpDFA::AddCharSet(char* node)
+{
+    BYTE* set = CharSets + 32 * CharSetCount;
+    char* s;
+    switch (OP(node))
+    {
+    case EXACTLY:
+        return AddCharSet((BYTE)UCHARAT(OPERAND(node)));
+
+    case ANYOF:
+    {
+        memset(set, 0, 32);
+        for (s = OPERAND(node); *s != '\0'; s++)
+            set[UCHARAT(s) >> 3] |= (BYTE)(1 << (UCHARAT(s) & 7));
+        break;
+    }
+
+    case ANYBUT:
+    {
+        memset(set, 0xFF, 32);
+        for (s = OPERAND(node); *s != '\0'; s++)
+            set[UCHARAT(s) >> 3] &= (BYTE)~(1 << (UCHARAT(s) & 7));
+        break;
+    }
+
+    default: // ANY
+        memset(set, 0xFF, 32);
+        break;
+    }
+    set[0] &= ~1; // znak 0 je pro backtracking konec radky, nevyhovuje nicemu
+    return CharSetCount++;
+}
+
+// vraci instrukci odpovidajici uzlu programu 'node'; pokud jeste neexistuje, vyhradi ji
+// a uzel zaradi do 'pending' k prevodu
+int CRegExpDFA::NodeInst(char* program, char* node, int* nodeInst, int* pending, int& pendingCount)
+{
+    if (node == NULL)
+        return AddInst(riFail, -1, -1, -1);
+    int offset = (int)(node - program);
+    if (nodeInst[offset] == -1)
+    {
+        nodeInst[offset] = AddInst(riFail, -1, -1, -1); // typ se doplni pri prevodu uzlu
+        pending[pendingCount++] = offset;
+    }
+    return nodeInst[offset];
+}
+
+BOOL CRegExpDFA::Init(regexp* prog, BOOL caseSensitive, BOOL longest)
+{
+    Release();
+    Longest = longest;
+    char* program = prog->program;
+    if (UCHARAT(program) != MAGIC)
+        return FALSE;
+
+    // delka programu: uzly lezi za sebou, posledni je END
+    char* p = program + 1;
+    while (OP(p) != END)
+    {
+        if (OP(p) == EXACTLY || OP(p) == ANYOF || OP(p) == ANYBUT)
+            p = OPERAND(p) + strlen(OPERAND(p)) + 1;
+        else
+            p = OPERAND(p);
+    }
+    int progSize = (int)(OPERAND(p) - program);
+
+    // kazdy uzel (3 byty) dava nejvys dve instrukce (STAR, PLUS) a jednu pripadnou riFail,
+    // EXACTLY dava jednu instrukci na znak
+    int maxInsts = 2 * progSize + 2;
+    Insts = (CRegExpInst*)malloc(maxInsts * sizeof(CRegExpInst));
+    CharSets = (BYTE*)malloc(maxInsts * 32);
+    HashTable = (CRegExpDFAState**)malloc(DFA_HASH_SIZE * sizeof(CRegExpDFAState*));
+    int* nodeInst = (int*)malloc(progSize * sizeof(int));
+    int* pending = (int*)malloc(progSize * sizeof(int));
+    if (Insts == NULL || CharSets == NULL || HashTable == NULL || nodeInst == NULL || pending == NULL)
+    {
+        if (nodeInst != NULL)
+            free(nodeInst);
+        if (pending != NULL)
+            free(pending);
+        Release();
+        return FALSE;
+    }
+    memset(HashTable, 0, DFA_HASH_SIZE * sizeof(CRegExpDFAState*));
+    int i;
+    for (i = 0; i < progSize; i++)
+        nodeInst[i] = -1;
+
+    // prevod uzlu programu na instrukce NFA; vetveni a opakovani odpovida poradi,
+    // ve kterem zkousi moznosti regmatch()
+    int pendingCount = 0;
+    StartInst = NodeInst(program, program + 1, nodeInst, pending, pendingCount);
+    while (pendingCount > 0)
+    {
+        char* node = program + pending[--pendingCount];
+        int idx = nodeInst[node - program];
+        char* next = regnext(node);
+        BYTE type = riNop;
+        int out = -1;
+        int out1 = -1;
+        int charSet = -1;
+        switch (OP(node))
+        {
+        case BOL:
+        case EOL:
+        {
+            type = (OP(node) == BOL) ? riBOL : riEOL;
+            out = NodeInst(program, next, nodeInst, pending, pendingCount);
+            break;
+        }
+
+        case ANY:
+        case ANYOF:
+        case ANYBUT:
+        {
+            type = riChar;
+            charSet = AddCharSet(node);
+            out = NodeInst(program, next, nodeInst, pending, pendingCount);
+            break;
+        }
+
+        case EXACTLY:
+        {
+            char* s = OPERAND(node);
+            type = riChar;
+            charSet = AddCharSet((BYTE)UCHARAT(s));
+            int last = idx;
+            while (*++s != '\0') // dalsi znaky retezce navazuji primo za sebe
+            {
+                int inst = AddInst(riChar, -1, -1, AddCharSet((BYTE)UCHARAT(s)));
+                if (last == idx)
+                    out = inst;
+                else
+                    Insts[last].Out = inst;
+                last = inst;
+            }
+            int nextInst = NodeInst(program, next, nodeInst, pending, pendingCount);
+            if (last == idx)
+                out = nextInst;
+            else
+                Insts[last].Out = nextInst;
+            break;
+        }
+
+        case BRANCH:
+        {
+            out = NodeInst(program, OPERAND(node), nodeInst, pending, pendingCount);
+            if (next != NULL && OP(next) == BRANCH) // jinak neni z ceho vybirat
+            {
+                type = riSplit;
+                out1 = NodeInst(program, next, nodeInst, pending, pendingCount);
+            }
+            break;
+        }
+
+        case STAR: // split(znak -> split, dal)
+        {
+            type = riSplit;
+            out = AddInst(riChar, idx, -1, AddCharSet(OPERAND(node)));
+            out1 = NodeInst(program, next, nodeInst, pending, pendingCount);
+            break;
+        }
+
+        case PLUS: // znak -> split(znak, dal)
+        {
+            type = riChar;
+            charSet = AddCharSet(OPERAND(node));
+            out = AddInst(riSplit, idx, -1, -1);
+            Insts[out].Out1 = NodeInst(program, next, nodeInst, pending, pendingCount);
+            break;
+        }
+
+        case END:
+            type = riMatch;
+            break;
+
+        default:
+        {
+            if (OP(node) == NOTHING || OP(node) == BACK ||
+                OP(node) > OPEN && OP(node) < OPEN + NSUBEXP ||
+                OP(node) > CLOSE && OP(node) < CLOSE + NSUBEXP)
+            {
+                out = NodeInst(program, next, nodeInst, pending, pendingCount);
+            }
+            else
+                type = riFail; // poskozeny program, regmatch() vraci neuspech
+            break;
+        }
+        }
+        CRegExpInst* inst = Insts + idx;
+        inst->Type = type;
+        inst->Out = out;
+        inst->Out1 = out1;
+        inst->CharSet = charSet;
+    }
+    free(nodeInst);
+    free(pending);
+
+    // rozdeleni znaku do trid: znaky, ktere lezi ve stejnych mnozinach, maji stejne prechody
+    int remap[2 * 256];
+    int b;
+    memset(ByteClass, 0, sizeof(ByteClass));
+    ClassCount = 1;
+    for (i = 0; i < CharSetCount; i++)
+    {
+        const BYTE* set = CharSets + 32 * i;
+        int count = 0;
+        for (b = 0; b < 2 * 256; b++)
+            remap[b] = -1;
+        for (b = 0; b < 256; b++)
+        {
+            BYTE c = caseSensitive ? (BYTE)b : (BYTE)LowerCase[b];
+            int key = 2 * ByteClass[b] + ((set[c >> 3] >> (c & 7)) & 1);
+            if (remap[key] == -1)
+                remap[key] = count++;
+            ByteClass[b] = (BYTE)remap[key];
+        }
+        ClassCount = count;
+    }
+    for (b = 0; b < 256; b++)
+        ClassRep[ByteClass[b]] = caseSensitive ? (BYTE)b : (BYTE)LowerCase[b];
+
+    Mark = (int*)malloc(InstCount * sizeof(int));
+    Stack = (int*)malloc((2 * InstCount + 2) * sizeof(int));
+    WorkList = (int*)malloc(InstCount * sizeof(int));
+    SaveList = (int*)malloc(InstCount * sizeof(int));
+    if (Mark == NULL || Stack == NULL || WorkList == NULL || SaveList == NULL)
+    {
+        Release();
+        return FALSE;
+    }
+    memset(Mark, 0, InstCount * sizeof(int));
+    Generation = 0;
+    return TRUE;
+}
+
+void CRegExpDFA::NextGeneration()
+{
+    if (++Generation == 0x7FFFFFFF)
+    {
+        memset(Mark, 0, InstCount * sizeof(int));
+        Generation = 1;
+    }
+    WorkCount = 0;
+}
+
+// prida do WorkList instrukce dosazitelne z 'inst' bez cteni znaku, v poradi, v jakem je
+// zkousi backtracking; instrukce uz pridane vlaknem s vyssi prioritou se preskakuji;
+// vraci TRUE, pokud vlakno dosahlo shody (pri !Longest se pak dalsi instrukce nepridavaji,
+// vlakna s nizsi prioritou uz nemohou vyhrat)
+BOOL CRegExpDFA::AddThread(int inst, BOOL atBOL, BOOL atEOL)
+{
+    BOOL match = FALSE;
+    int sp = 0;
+    Stack[sp++] = inst;
+    while (sp > 0)
+    {
+        int i = Stack[--sp];
+        if (Mark[i] == Generation)
+            continue;
+        Mark[i] = Generation;
+        CRegExpInst* in = Insts + i;
+        switch (in->Type)
+        {
+        case riChar:
+            WorkList[WorkCount++] = i;
+            break;
+
+        case riSplit:
+        {
+            Stack[sp++] = in->Out1;
+            Stack[sp++] = in->Out;
+            break;
+        }
+
+        case riNop:
+            Stack[sp++] = in->Out;
+            break;
+
+        case riBOL:
+        {
+            if (atBOL)
+                Stack[sp++] = in->Out;
+            break;
+        }
+
+        case riEOL:
+        {
+            if (atEOL)
+                Stack[sp++] = in->Out;
+            else
+                WorkList[WorkCount++] = i; // rozhodne se az podle dalsiho znaku
+            break;
+        }
+
+        case riMatch:
+        {
+            match = TRUE;
+            if (!Longest)
+                return TRUE;
+            break;
+        }
+        }
+    }
+    return match;
+}
+
+CRegExpDFAState* CRegExpDFA::FindState(BOOL match, BOOL unanchored)
+{
+    DWORD hash = 2166136261u;
+    int i;
+    for (i = 0; i < WorkCount; i++)
+        hash = (hash ^ (DWORD)WorkList[i]) * 16777619u;
+    hash = (hash ^ (match ? 1 : 0) ^ (unanchored ? 2 : 0)) * 16777619u;
+
+    CRegExpDFAState** slot = HashTable + (hash & (DFA_HASH_SIZE - 1));
+    CRegExpDFAState* state = *slot;
+    while (state != NULL)
+    {
+        if (state->Hash == hash && state->Count == WorkCount && state->Match == match &&
+            state->Unanchored == unanchored && memcmp(state->Insts, WorkList, WorkCount * sizeof(int)) == 0)
+        {
+            return state;
+        }
+        state = state->HashNext;
+    }
+
+    int size = sizeof(CRegExpDFAState) + ClassCount * sizeof(CRegExpDFAState*) + WorkCount * sizeof(int);
+    if (CacheSize + size > DFA_MAX_MEMORY)
+    {
+        CacheFull = TRUE;
+        return NULL;
+    }
+    state = (CRegExpDFAState*)malloc(size);
+    if (state == NULL)
+        return NULL;
+    CacheSize += size;
+    state->Hash = hash;
+    state->Match = match;
+    state->Unanchored = unanchored;
+    state->EOLMatch = -1;
+    state->Count = WorkCount;
+    state->Next = (CRegExpDFAState**)(state + 1);
+    memset(state->Next, 0, ClassCount * sizeof(CRegExpDFAState*));
+    state->Insts = (int*)(state->Next + ClassCount);
+    memcpy(state->Insts, WorkList, WorkCount * sizeof(int));
+    state->HashNext = *slot;
+    *slot = state;
+    return state;
+}
+
+CRegExpDFAState* CRegExpDFA::GetStartState(BOOL atBOL)
+{
+    CRegExpDFAState** start = StartStates + (atBOL ? 1 : 0);
+    if (*start == NULL)
+    {
+        NextGeneration();
+        BOOL match = AddThread(StartInst, atBOL, FALSE);
+        *start = FindState(match, !Longest);
+    }
+    return *start;
+}
+
+CRegExpDFAState* CRegExpDFA::ComputeNext(CRegExpDFAState* state, int cls)
+{
+    BYTE c = ClassRep[cls];
+    BOOL match = FALSE;
+    NextGeneration();
+    int i;
+    for (i = 0; i < state->Count; i++)
+    {
+        CRegExpInst* in = Insts + state->Insts[i];
+        if (in->Type == riChar && (CharSets[32 * in->CharSet + (c >> 3)] & (1 << (c & 7))) &&
+            AddThread(in->Out, FALSE, FALSE))
+        {
+            match = TRUE;
+            if (!Longest)
+                break;
+        }
+    }
+    // dokud neni nalezena shoda, muze shoda s nizsi prioritou zacinat i na dalsi pozici
+    BOOL unanchored = state->Unanchored && !state->Match;
+    if (unanchored && !match && AddThread(StartInst, FALSE, FALSE))
+        match = TRUE;
+    CRegExpDFAState* next = FindState(match, unanchored);
+    if (next != NULL)
+        state->Next[cls] = next;
+    return next;
+}
+
+BOOL CRegExpDFA::IsEOLMatch(CRegExpDFAState* state, BOOL atBOL)
+{
+    NextGeneration();
+    int i;
+    for (i = 0; i < state->Count; i++)
+    {
+        CRegExpInst* in = Insts + state->Insts[i];
+        if (in->Type == riEOL && AddThread(in->Out, atBOL, TRUE))
+            return TRUE;
+    }
+    return FALSE;
+}
+
+int CRegExpDFA::Scan(const BYTE* text, int step, int count, BOOL atBOL, BOOL eolAtEnd)
+{
+    CRegExpDFAState* state = GetStartState(atBOL);
+    if (state == NULL && CacheFull)
+    {
+        Flush();
+        state = GetStartState(atBOL);
+    }
+    if (state == NULL)
+        return -2;
+
+    int matched = -1;
+    int flushPos = -1; // kde se naposledy vyprazdnila cache
+    int i = 0;
+    while (TRUE)
+    {
+        if (state->Match)
+            matched = i;
+        if (i == count || *text == 0) // NUL konci radku, backtracking (regexec) za nej nevidi
+        {
+            if (eolAtEnd || i < count)
+            {
+                BOOL eolMatch;
+                if (i == 0 && atBOL)
+                    eolMatch = IsEOLMatch(state, TRUE);
+                else
+                {
+                    if (state->EOLMatch == -1)
+                        state->EOLMatch = IsEOLMatch(state, FALSE);
+                    eolMatch = state->EOLMatch;
+                }
+                if (eolMatch)
+                    matched = i;
+            }
+            break;
+        }
+        if (state->Count == 0 && (!state->Unanchored || state->Match))
+            break; // zadne vlakno uz nezije, delsi shoda neexistuje
+
+        int cls = ByteClass[*text];
+        CRegExpDFAState* next = state->Next[cls];
+        if (next == NULL)
+        {
+            next = ComputeNext(state, cls);
+            if (next == NULL)
+            {
+                if (!CacheFull || flushPos != -1 && i - flushPos < DFA_MIN_FLUSH_DISTANCE)
+                    return -2; // malo pameti nebo se stavy porad nevejdou, at hleda backtracking
+
+                // zahodime vsechny stavy krome aktualniho a pokracujeme
+                int saveCount = state->Count;
+                BOOL saveMatch = state->Match;
+                BOOL saveUnanchored = state->Unanchored;
+                memcpy(SaveList, state->Insts, saveCount * sizeof(int));
+                Flush();
+                flushPos = i;
+                memcpy(WorkList, SaveList, saveCount * sizeof(int));
+                WorkCount = saveCount;
+                state = FindState(saveMatch, saveUnanchored);
+                if (state == NULL || (next = ComputeNext(state, cls)) == NULL)
+                    return -2;
+            }
+        }
+        state = next;
+        text += step;
+        i++;
+    }
+    return matched;
+}
@@ -66,6 +66,76 @@ const char* RegExpErrorText(CRegExpErrors err);
 #define sfCaseSensitive 0x01 // 0. bit = 1
 #define sfForward 0x02       // 1. bit = 1
 
+//*****************************************************************************
+//
+// CRegExpDFA
+//
+// Hledani v linearnim case: z programu regexp se odvodi NFA a z nej se za behu
+// postupne (lazy) stavi DFA, jehoz stavy se cachuji; pri prekroceni limitu pameti
+// se cache zahodi a stavi se znovu. Text se cte primo z bufferu volajiciho (i
+// pozpatku), neni tedy potreba kopirovat radku. Neumi zjistit obsah zavorek, pro
+// ExpandVariables a ReplaceForward se dal pouziva backtracking (regexec).
+
+struct CRegExpInst;
+struct CRegExpDFAState;
+
+class CRegExpDFA
+{
+protected:
+    BOOL Longest;        // TRUE = nejdelsi shoda od zacatku textu, FALSE = prvni shoda (jako backtracking) kdekoliv v textu
+    CRegExpInst* Insts;  // instrukce NFA
+    int InstCount;       // pocet instrukci NFA
+    int StartInst;       // prvni instrukce NFA
+    BYTE* CharSets;      // bitove mnoziny znaku (32 bytu na mnozinu) pro instrukce NFA cteci znak
+    int CharSetCount;    // pocet mnozin v CharSets
+    BYTE ByteClass[256]; // trida kazdeho znaku textu (znaky ze stejne tridy maji stejne prechody)
+    BYTE ClassRep[256];  // zastupce kazde tridy (uz prevedeny pres LowerCase)
+    int ClassCount;      // pocet trid znaku
+
+    CRegExpDFAState** HashTable;     // rozptylovaci tabulka stavu DFA
+    CRegExpDFAState* StartStates[2]; // pocatecni stavy: [0] uprostred radky, [1] na zacatku radky
+    int CacheSize;                   // pamet zabrana stavy DFA
+    BOOL CacheFull;                  // TRUE = posledni stav se uz nevesel do limitu pameti
+
+    int* Mark;      // pro kazdou instrukci NFA generace, ve ktere byla naposledy pridana
+    int Generation; // aktualni generace pro Mark
+    int* Stack;     // zasobnik pro AddThread
+    int* WorkList;  // prave sestavovany seznam instrukci noveho stavu
+    int WorkCount;  // pocet instrukci ve WorkList
+    int* SaveList;  // zaloha seznamu instrukci stavu pri vyprazdneni cache
+
+public:
+    CRegExpDFA();
+    ~CRegExpDFA();
+
+    // postavi NFA z programu 'prog' (pri 'caseSensitive' FALSE musi byt zkompilovan z vyrazu
+    // prevedeneho pres LowerCase); 'longest' viz Longest; vraci FALSE pri nedostatku pameti
+    BOOL Init(regexp* prog, BOOL caseSensitive, BOOL longest);
+
+    // projde 'count' znaku textu od 'text' s krokem 'step' (1 nebo -1); 'atBOL' je TRUE pokud
+    // 'text' je na zacatku radky, 'eolAtEnd' je TRUE pokud za poslednim ctenym znakem je konec
+    // radky; znak NUL konci radku stejne jako v regexec (dal se necte, '$' se na nem shoduje);
+    // vraci pocet znaku do konce nalezene shody, -1 pokud shoda neexistuje nebo -2 pokud
+    // DFA nelze pouzit (prilis mnoho stavu, malo pameti) a je nutne hledat backtrackingem
+    int Scan(const BYTE* text, int step, int count, BOOL atBOL, BOOL eolAtEnd);
+
+protected:
+    void Release(); // uvolni vse vcetne NFA
+    void Flush();   // zahodi vsechny stavy DFA
+
+    int AddInst(BYTE type, int out, int out1, int charSet);
+    int NodeInst(char* program, char* node, int* nodeInst, int* pending, int& pendingCount);
+    int AddCharSet(char* node);
+    int AddCharSet(BYTE c);
+
+    void NextGeneration();
+    BOOL AddThread(int inst, BOOL atBOL, BOOL atEOL);
+    CRegExpDFAState* FindState(BOOL match, BOOL unanchored); // stav ze seznamu WorkList
+    CRegExpDFAState* GetStartState(BOOL atBOL);
+    CRegExpDFAState* ComputeNext(CRegExpDFAState* state, int cls);
+    BOOL IsEOLMatch(CRegExpDFAState* state, BOOL atBOL);
+};
+
 //*****************************************************************************
 //
 // CRegularExpression
@@ -82,10 +152,14 @@ protected:
     regexp* Expression; // nakompilovany regularni vyraz
     WORD Flags;
 
-    char* Line;                // buffer pro radek
+    char* Line;                // buffer pro radek (kopie pro backtracking, viz LineCopied)
     const char* OrigLineStart; // pointer na zacatek puvodniho textu (predaneho do SetLine() jako 'start')
     int Allocated;             // kolik bytu je alokovano
     int LineLength;            // aktualni delka radky
+    BOOL LineCopied;           // TRUE = Line obsahuje upravenou kopii aktualni radky
+
+    CRegExpDFA* DFA;        // hledani konce shody bez kopirovani radky (NULL = jen backtracking)
+    CRegExpDFA* ReverseDFA; // dohledani zacatku shody nalezene pres DFA (cte text opacnym smerem)
 
 public:
     CRegularExpression()
@@ -97,6 +171,9 @@ public:
         OrigLineStart = NULL;
         Allocated = 0;
         LineLength = 0;
+        LineCopied = FALSE;
+        DFA = NULL;
+        ReverseDFA = NULL;
         LastErrorText = NULL;
     }
 
@@ -108,21 +185,27 @@ public:
             free(OriginalPattern);
         if (Line != NULL)
             free(Line);
+        FreeDFA();
     }
 
     BOOL IsGood() const { return OriginalPattern != NULL && Expression != NULL; }
     const char* GetPattern() const { return OriginalPattern; }
+    WORD GetFlags() const { return Flags; }
 
     const char* GetLastErrorText() const { return LastErrorText; }
     BOOL Set(const char* pattern, WORD flags); // vraci FALSE pri chybe (volat metodu GetLastErrorText)
     BOOL SetFlags(WORD flags);                 // vraci FALSE pri chybe (volat metodu GetLastErrorText)
 
-    BOOL SetLine(const char* start, const char* end); // radek textu, ve kterem vyhledava, vraci FALSE pri chybe (volat metodu GetLastErrorText)
+    // radek textu, ve kterem vyhledava, vraci FALSE pri chybe (volat metodu GetLastErrorText);
+    // pokud neni 'copyText' TRUE, hleda se primo v textu volajiciho, ktery proto musi zustat
+    // platny, dokud se v radce hleda
+    BOOL SetLine(const char* start, const char* end, BOOL copyText = FALSE);
 
     int SearchForward(int start, int& foundLen);
     int SearchBackward(int length, int& foundLen);
 
     // nahradi promnene \1 ... \9 textem zachycenym odpovidajicima zavorkama
+    // (pri poslednim hledani backtrackingem, tedy v ReplaceForward)
     // 'pattern' je vzor kterym se nahrazuje nalezeny match, 'buffer' buffer
     // pro vystup, 'bufSize' maximalni velikost textu vcetne ukoncovaciho NULL
     // znaku, v promnene 'count' vraci pocet znaku zkopirovanych do bufferu
@@ -139,6 +222,15 @@ public:
                        char* buffer, int bufSize);
 
 protected:
+    BOOL CopyLine(); // pripravi v Line kopii radky pro backtracking, vraci FALSE pri nedostatku pameti
+    void BuildDFA(char* pattern);
+    void FreeDFA();
+
+    // hleda pres DFA v "prochazenem" textu (pri hledani pozpatku je to obracena radka) od pozice
+    // 'start'; vraci 1 = nalezeno ('foundStart' az 'foundEnd'), 0 = nenalezeno, -1 = je nutne
+    // hledat backtrackingem
+    int SearchDFA(int start, int& foundStart, int& foundEnd);
+
     // Obraci regularni vyraz - pro hledani od zadu
     // VYRAZ MUSI BYT SYNTAKTICKY SPRAVNY ! JINAK NEFUNGUJE SPRAVNE !
     // napr. "a)b(d)(" -> "((d)b)a" coz je chybne
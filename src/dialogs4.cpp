@@ -301,6 +301,7 @@ CConfiguration::CConfiguration()
     UseSalOpen = FALSE;
     NetwareFastDirMove = FALSE; // choose the slower but 100% working mode; power users can switch it
     UseAsyncCopyAlg = TRUE;
+    UseParallelCopy = TRUE;
     ReloadEnvVariables = TRUE;
     QuickRenameSelectAll = FALSE;
     EditNewSelectAll = TRUE;
@@ -371,6 +372,9 @@ CConfiguration::CConfiguration()
 
     LastUsedSpeedLimit = 1024 * 1024; // default 1 MB/s
 
+    HashCacheMaxItems = 200000;  // roughly tens of MB of the database
+    ThumbnailCacheMaxSize = 512; // thousands of thumbnails of the biggest size
+
     QuickSearchEnterAlt = FALSE;
 
     // for displaying items in the panel
@@ -460,6 +464,7 @@ CConfiguration::CConfiguration()
     DefaultConvert[0] = 0;
     AutoCopySelection = FALSE;
     GoToOffsetIsHex = TRUE;
+    GoToOffsetIsLine = FALSE;
 
     // Change drive
     ChangeDriveShowMyDoc = TRUE;
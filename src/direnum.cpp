@@ -0,0 +1,155 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "precomp.h"
+
+#include "direnum.h"
+
+//
+// *****************************************************************************
+// CDiskDirEnumerator
+//
+
+CDiskDirEnumerator::CDiskDirEnumerator()
+{
+    Dir = NULL;
+    Find = NULL;
+    Buffer = NULL;
+    Next = NULL;
+    CodePage = CP_ACP;
+}
+
+BOOL CDiskDirEnumerator::FindFirst(const char* fileName, WIN32_FIND_DATA* data)
+{
+    CALL_STACK_MESSAGE2("CDiskDirEnumerator::FindFirst(%s)", fileName);
+    Close();
+
+    int len = (int)strlen(fileName);
+    if (len >= 2 && len < MAX_PATH && fileName[len - 2] == '\\' && fileName[len - 1] == '*')
+    {
+        char path[MAX_PATH];
+        memcpy(path, fileName, len - 1); // we keep the backslash at the end (important for the root of a disk)
+        path[len - 1] = 0;
+        Dir = HANDLES_Q(CreateFile(path, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                   NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL));
+        if (Dir == INVALID_HANDLE_VALUE)
+            Dir = NULL;
+        else
+        {
+            Buffer = (BYTE*)malloc(DIRENUM_BUFFER_SIZE);
+            if (Buffer == NULL)
+                TRACE_E(LOW_MEMORY);
+            else
+            {
+                CodePage = AreFileApisANSI() ? CP_ACP : CP_OEMCP;
+                if (ReadBatch(TRUE))
+                    return FindNext(data);
+                if (GetLastError() == ERROR_NO_MORE_FILES) // FindFirstFile reports an empty directory this way
+                {
+                    Close();
+                    SetLastError(ERROR_FILE_NOT_FOUND);
+                    return FALSE;
+                }
+            }
+            Close(); // e.g. FileIdBothDirectoryInfo is not supported, let FindFirstFile handle it
+        }
+    }
+
+    // fallback: classic listing
+    HANDLE find = HANDLES_Q(FindFirstFile(fileName, data));
+    if (find == INVALID_HANDLE_VALUE)
+        return FALSE; // GetLastError() is set by FindFirstFile
+    Find = find;
+    return TRUE;
+}
+
+BOOL CDiskDirEnumerator::FindNext(WIN32_FIND_DATA* data)
+{
+    if (Find != NULL)
+        return FindNextFile(Find, data);
+    if (Dir == NULL)
+    {
+        TRACE_E("CDiskDirEnumerator::FindNext(): listing was not started!");
+        SetLastError(ERROR_INVALID_HANDLE);
+        return FALSE;
+    }
+    while (1)
+    {
+        if (Next == NULL && !ReadBatch(FALSE))
+            return FALSE; // GetLastError() is set by ReadBatch
+        if (GetRecord(data))
+            return TRUE;
+        // the name does not fit into WIN32_FIND_DATA, the record is skipped (it was traced)
+    }
+}
+
+void CDiskDirEnumerator::Close()
+{
+    if (Find != NULL)
+    {
+        HANDLES(FindClose(Find));
+        Find = NULL;
+    }
+    if (Dir != NULL)
+    {
+        HANDLES(CloseHandle(Dir));
+        Dir = NULL;
+    }
+    if (Buffer != NULL)
+    {
+        free(Buffer);
+        Buffer = NULL;
+    }
+    Next = NULL;
+}
+
+BOOL CDiskDirEnumerator::ReadBatch(BOOL first)
+{
+    Next = NULL;
+    if (!GetFileInformationByHandleEx(Dir, first ? FileIdBothDirectoryRestartInfo : FileIdBothDirectoryInfo,
+                                      Buffer, DIRENUM_BUFFER_SIZE))
+    {
+        return FALSE; // GetLastError() is set (ERROR_NO_MORE_FILES = end of listing)
+    }
+    Next = (FILE_ID_BOTH_DIR_INFO*)Buffer;
+    return TRUE;
+}
+
+BOOL CDiskDirEnumerator::GetRecord(WIN32_FIND_DATA* data)
+{
+    FILE_ID_BOTH_DIR_INFO* info = Next;
+    if (info->NextEntryOffset != 0)
+        Next = (FILE_ID_BOTH_DIR_INFO*)((BYTE*)info + info->NextEntryOffset);
+    else
+        Next = NULL; // the last record of the batch
+
+    int len = WideCharToMultiByte(CodePage, 0, info->FileName, info->FileNameLength / sizeof(WCHAR),
+                                  data->cFileName, MAX_PATH - 1, NULL, NULL);
+    if (len == 0 && info->FileNameLength > 0)
+    {
+        TRACE_E("CDiskDirEnumerator::GetRecord(): unable to convert file name, skipping it: " << GetErrorText(GetLastError()));
+        return FALSE;
+    }
+    data->cFileName[len] = 0;
+    len = 0;
+    if (info->ShortNameLength > 0)
+    {
+        len = WideCharToMultiByte(CodePage, 0, info->ShortName, info->ShortNameLength / sizeof(WCHAR),
+                                  data->cAlternateFileName, _countof(data->cAlternateFileName) - 1, NULL, NULL);
+    }
+    data->cAlternateFileName[len] = 0;
+
+    data->dwFileAttributes = info->FileAttributes;
+    data->ftCreationTime.dwLowDateTime = info->CreationTime.LowPart;
+    data->ftCreationTime.dwHighDateTime = info->CreationTime.HighPart;
+    data->ftLastAccessTime.dwLowDateTime = info->LastAccessTime.LowPart;
+    data->ftLastAccessTime.dwHighDateTime = info->LastAccessTime.HighPart;
+    data->ftLastWriteTime.dwLowDateTime = info->LastWriteTime.LowPart;
+    data->ftLastWriteTime.dwHighDateTime = info->LastWriteTime.HighPart;
+    data->nFileSizeLow = info->EndOfFile.LowPart;
+    data->nFileSizeHigh = info->EndOfFile.HighPart;
+    // FindFirstFile returns the reparse tag in dwReserved0 (the file system returns it in EaSize)
+    data->dwReserved0 = (info->FileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) ? info->EaSize : 0;
+    data->dwReserved1 = 0;
+    return TRUE;
+}
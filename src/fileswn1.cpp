@@ -555,6 +555,7 @@ unsigned IconThreadThreadFBody(void* parameter)
                 int lastVisArrVersion = -1;
                 BOOL someNameSkipped = FALSE;
                 int thumbnailFlag = 0;
+                BOOL thumbnailFromDiskCache = FALSE; // TRUE = the thumbnail in thumbMaker was taken from ThumbnailDiskCache
                 int i = 0;
                 while (1)
                 {
@@ -882,10 +883,19 @@ unsigned IconThreadThreadFBody(void* parameter)
                                             {
                                                 strcpy(name, s);
 
+                                                // a thumbnail stored in a previous session (or before the icon cache was flushed)
+                                                // is quality and its file has not changed, plug-ins need not decode the image again
+                                                const CQuadWord* fileSize = (const CQuadWord*)(s + size);
+                                                const FILETIME* lastWrite = (const FILETIME*)(s + size + sizeof(CQuadWord));
+                                                thumbMaker.Clear(window->GetThumbnailSize());
+                                                thumbnailFromDiskCache = thumbMaker.LoadFromDiskCache(path, *fileSize, *lastWrite);
+                                                if (thumbnailFromDiskCache)
+                                                    thumbnailFlag = 5 /* quality */;
+
                                                 //                          TRACE_I("Load thumbnail for: " << name << "...");
                                                 CPluginInterfaceForThumbLoaderEncapsulation** loader;
                                                 loader = (CPluginInterfaceForThumbLoaderEncapsulation**)(s + size + sizeof(CQuadWord) + sizeof(FILETIME));
-                                                while (*loader != NULL)
+                                                while (!thumbnailFromDiskCache && *loader != NULL)
                                                 {
                                                     int thumbnailSize = window->GetThumbnailSize();
                                                     thumbMaker.Clear(thumbnailSize);
@@ -898,7 +908,7 @@ unsigned IconThreadThreadFBody(void* parameter)
                                                     }
                                                     loader++; // try the next plug-in in line, it might load the thumbnail
                                                 }
-                                                if (*loader == NULL)
+                                                if (!thumbnailFromDiskCache && *loader == NULL)
                                                     thumbMaker.Clear(); // failed thumbnail -> clean it up
                                                                         //                          TRACE_I("Load thumbnail is done.");
                                             }
@@ -907,6 +917,7 @@ unsigned IconThreadThreadFBody(void* parameter)
                                                 *name = 0;
                                                 TRACE_I("Too long filename to get thumbnail from: " << path << s);
                                                 thumbMaker.Clear();
+                                                thumbnailFromDiskCache = FALSE; // do not keep the value of the previous file
                                             }
                                         }
                                     }
@@ -1044,6 +1055,16 @@ unsigned IconThreadThreadFBody(void* parameter)
                                                             break;
                                                         }
                                                     }
+
+                                                    // keep the quality thumbnail for the next time (after it is displayed)
+                                                    if (!thumbnailFromDiskCache && thumbnailFlag == 5)
+                                                    {
+                                                        char* s = iconData->NameAndData;
+                                                        int size = (int)strlen(s) + 4;
+                                                        size -= (size & 0x3); // size % 4 (alignment to four bytes)
+                                                        thumbMaker.StoreToDiskCache(path, *(CQuadWord*)(s + size),
+                                                                                    *(FILETIME*)(s + size + sizeof(CQuadWord)));
+                                                    }
                                                 }
                                             }
                                         }
@@ -17,6 +17,7 @@
 #include "snooper.h"
 #include "zip.h"
 #include "shiconov.h"
+#include "direnum.h"
 
 //
 // ****************************************************************************
@@ -267,11 +268,13 @@ BOOL CFilesWindow::ReadDirectory(HWND parent, BOOL isRefresh)
         file.CutToClip = 0;
         file.IconOverlayIndex = ICONOVERLAYINDEX_NOTUSED;
         file.IconOverlayDone = 0;
+        file.NameInArena = 1; // names are allocated in the arenas of Files and Dirs (released with the listing)
         int len;
 #ifndef _WIN64
         int foundWin64RedirectedDirs = 0;
         BOOL isWin64RedirectedDir = FALSE;
 #endif // _WIN64
+        CDiskDirEnumerator dirEnum; // fetches entries in batches (large directories, network paths)
 
     _TRY_AGAIN:
 
@@ -291,9 +294,9 @@ BOOL CFilesWindow::ReadDirectory(HWND parent, BOOL isRefresh)
 
         BOOL isUpDir = FALSE;
         WIN32_FIND_DATA fileData;
-        HANDLE search;
-        search = HANDLES_Q(FindFirstFile(fileName, &fileData));
-        if (search == INVALID_HANDLE_VALUE)
+        CDiskDirEnumerator* search; // NULL = the second/third pass (adding ".." or win64 redirected-dir)
+        search = dirEnum.FindFirst(fileName, &fileData) ? &dirEnum : NULL;
+        if (search == NULL)
         {
             DWORD err = GetLastError();
             DestroySafeWaitWindow();
@@ -486,13 +489,15 @@ BOOL CFilesWindow::ReadDirectory(HWND parent, BOOL isRefresh)
             ADD_ITEM: // to add ".."
 
                 //--- name
-                file.Name = (char*)malloc(len + 1); // allocation
+                CFilesArray* namesOwner;
+                namesOwner = (fileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ? Dirs : Files; // this is ptDisk
+                file.Name = namesOwner->AllocName(len + 1); // allocation
                 if (file.Name == NULL)
                 {
                     if (search != NULL)
                     {
                         DestroySafeWaitWindow();
-                        HANDLES(FindClose(search));
+                        search->Close();
                     }
                     TRACE_E(LOW_MEMORY);
                     SetCurrentDirectoryToSystem();
@@ -540,14 +545,13 @@ BOOL CFilesWindow::ReadDirectory(HWND parent, BOOL isRefresh)
                 if (fileData.cAlternateFileName[0] != 0)
                 {
                     int l = (int)strlen(fileData.cAlternateFileName) + 1;
-                    file.DosName = (char*)malloc(l);
+                    file.DosName = namesOwner->AllocName(l);
                     if (file.DosName == NULL)
                     {
-                        free(file.Name);
                         if (search != NULL)
                         {
                             DestroySafeWaitWindow();
-                            HANDLES(FindClose(search));
+                            search->Close();
                         }
                         TRACE_E(LOW_MEMORY);
                         SetCurrentDirectoryToSystem();
@@ -578,14 +582,7 @@ BOOL CFilesWindow::ReadDirectory(HWND parent, BOOL isRefresh)
                     if (len == 2 && *st == '.' && *(st + 1) == '.')
                     { // handling ".."
                         if (GetPath()[3] != 0)
-                            Dirs->Insert(0, file); // except of root...
-                        else
-                        {
-                            if (file.Name != NULL)
-                                free(file.Name);
-                            if (file.DosName != NULL)
-                                free(file.DosName);
-                        }
+                            Dirs->Insert(0, file); // except of root... (otherwise the names stay unused in the arena of Dirs)
                         addtoIconCache = FALSE;
                     }
                     else
@@ -603,7 +600,7 @@ BOOL CFilesWindow::ReadDirectory(HWND parent, BOOL isRefresh)
                         if (search != NULL)
                         {
                             DestroySafeWaitWindow();
-                            HANDLES(FindClose(search));
+                            search->Close();
                         }
                         SetCurrentDirectoryToSystem();
                         Files->DestroyMembers();
@@ -687,7 +684,7 @@ BOOL CFilesWindow::ReadDirectory(HWND parent, BOOL isRefresh)
                         if (search != NULL)
                         {
                             DestroySafeWaitWindow();
-                            HANDLES(FindClose(search));
+                            search->Close();
                         }
                         SetCurrentDirectoryToSystem();
                         Files->DestroyMembers();
@@ -843,13 +840,13 @@ BOOL CFilesWindow::ReadDirectory(HWND parent, BOOL isRefresh)
 #endif                     // _WIN64
                     break; // the second pass (adding ".." or win64 redirected-dir)
                 }
-            } while (FindNextFile(search, &fileData));
+            } while (search->FindNext(&fileData));
             DWORD err = GetLastError();
 
             if (search != NULL) // the first pass
             {
                 DestroySafeWaitWindow();
-                HANDLES(FindClose(search));
+                search->Close();
             }
 
             if (testFindNextErr && err != ERROR_NO_MORE_FILES)
@@ -866,11 +863,12 @@ BOOL CFilesWindow::ReadDirectory(HWND parent, BOOL isRefresh)
         {
             upDir = FALSE;
             *(fileNameEnd - 1) = 0; // it's not logical, but times ".." are from current directory
+            HANDLE find;
             if (!UNCRootUpDir)
-                search = HANDLES_Q(FindFirstFile(fileName, &fileData));
+                find = HANDLES_Q(FindFirstFile(fileName, &fileData));
             else
-                search = INVALID_HANDLE_VALUE;
-            if (search == INVALID_HANDLE_VALUE)
+                find = INVALID_HANDLE_VALUE;
+            if (find == INVALID_HANDLE_VALUE)
             {
                 fileData.dwFileAttributes = FILE_ATTRIBUTE_DIRECTORY; // this is ptDisk
                 SYSTEMTIME ltNone;
@@ -893,7 +891,7 @@ BOOL CFilesWindow::ReadDirectory(HWND parent, BOOL isRefresh)
                 fileData.dwReserved0 = fileData.dwReserved1 = 0;
             }
             else
-                HANDLES(FindClose(search));
+                HANDLES(FindClose(find));
             search = NULL;                                              // the second/third pass
             fileData.dwFileAttributes |= FILE_ATTRIBUTE_DIRECTORY;      // this is ptDisk
             fileData.dwFileAttributes &= ~FILE_ATTRIBUTE_REPARSE_POINT; // need to remove flag FILE_ATTRIBUTE_REPARSE_POINT, otherwise link overlay will be on ".."
@@ -1045,6 +1043,7 @@ BOOL CFilesWindow::ReadDirectory(HWND parent, BOOL isRefresh)
                 upDir.CutToClip = 0;
                 upDir.IconOverlayIndex = ICONOVERLAYINDEX_NOTUSED;
                 upDir.IconOverlayDone = 0;
+                upDir.NameInArena = 0;
 
                 if (PluginData.NotEmpty())
                     PluginData.GetFileDataForUpDir(GetZIPPath(), upDir);
@@ -873,6 +873,7 @@ BOOL _ReadDirectoryTree(HWND parent, char (&path)[MAX_PATH], char* name, CSalama
             newF.CutToClip = 0;
             newF.IconOverlayIndex = ICONOVERLAYINDEX_NOTUSED;
             newF.IconOverlayDone = 0;
+            newF.NameInArena = 0;
         }
         else
             memset(&newF, 0, sizeof(newF));
@@ -1097,6 +1098,7 @@ CSalamanderDirectory* ReadDirectoryTree(HWND parent, CPanelTmpEnumData* data, in
         newF.CutToClip = 0;
         newF.IconOverlayIndex = ICONOVERLAYINDEX_NOTUSED;
         newF.IconOverlayDone = 0;
+        newF.NameInArena = 0;
     }
     else
         memset(&newF, 0, sizeof(newF));
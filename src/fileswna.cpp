@@ -402,6 +402,7 @@ void CFilesWindow::DragDropToArcOrFS(CTmpDragDropOperData* data)
         newF.CutToClip = 0;
         newF.IconOverlayIndex = ICONOVERLAYINDEX_NOTUSED;
         newF.IconOverlayDone = 0;
+        newF.NameInArena = 0;
         BOOL testFindNextErr = TRUE;
 
         do
@@ -7,6 +7,7 @@
 #include "cfgdlg.h"
 #include "find.h"
 #include "md5.h"
+#include "hashcach.h"
 
 char* FindNamedHistory[FIND_NAMED_HISTORY_SIZE];
 char* FindLookInHistory[FIND_LOOKIN_HISTORY_SIZE];
@@ -656,6 +657,314 @@ BOOL CFindIgnore::Set(int index, BOOL enabled, const char* path)
     return TRUE;
 }
 
+//*********************************************************************************
+//
+// CDuplicateHasher
+//
+// Computes MD5 digests of duplicate candidates on several threads; every thread takes
+// the next file from the shared list. In the partial mode only the head and tail blocks
+// (DUPLICATES_PARTIAL_SIZE each) of large files are hashed, smaller files are hashed
+// completely. The digest is stored at (BYTE*)file->Group.
+//
+
+#define DUPLICATES_BUFFER_SIZE 262144 // buffer size for MD5 calculation (one per hashing thread)
+#define DUPLICATES_PARTIAL_SIZE 65536 // size of the head and tail blocks hashed in the partial mode
+#define DUPLICATES_MAX_THREADS 4      // upper limit for the number of hashing threads
+
+// files larger than this are hashed only partially in the first pass
+#define DUPLICATES_PARTIAL_LIMIT CQuadWord(2 * DUPLICATES_PARTIAL_SIZE, 0)
+// names of the digests in the persistent digest cache (see CFileHashCache)
+#define DUPLICATES_FULL_DIGEST "MD5"
+#define DUPLICATES_PARTIAL_DIGEST "MD5-HEAD-TAIL-64K" // depends on DUPLICATES_PARTIAL_SIZE
+
+class CDuplicateHasher
+{
+protected:
+    CGrepData* Data;
+    CFoundFilesData** Files; // files to hash (valid during Hash())
+    BOOL* Hashed;            // Hashed[i] is TRUE if the digest of Files[i] was computed
+    int Count;               // number of items in Files and Hashed
+    BOOL Partial;            // TRUE = hash only the head and tail blocks of large files
+    volatile LONG NextFile;  // index of the next file to hash
+
+    CRITICAL_SECTION ProgressCS; // guards ReadSize, TotalSize and Progress
+    CQuadWord ReadSize;          // number of bytes read so far across all files
+    CQuadWord TotalSize;         // total number of bytes to read
+    int Progress;                // numeric value shown in the status bar (optimized so we do
+                                 // not update the same progress repeatedly)
+
+public:
+    CDuplicateHasher(CGrepData* data);
+    ~CDuplicateHasher();
+
+    // computes digests of 'count' files 'files' (partially if 'partial' is TRUE); 'hashed' receives
+    // the result for each file: FALSE on read errors or when the user aborts the operation
+    // (then, the variable data->StopSearch is set to TRUE)
+    void Hash(CFoundFilesData** files, BOOL* hashed, int count, BOOL partial);
+
+    const CQuadWord& GetReadSize() { return ReadSize; }
+    void SetTotalSize(const CQuadWord& totalSize) { TotalSize = totalSize; }
+
+protected:
+    static DWORD WINAPI ThreadF(void* param);
+    static unsigned ThreadEH(void* param);
+    unsigned ThreadBody();
+
+    // compute MD5 from the file 'file' using 'buffer' (DUPLICATES_BUFFER_SIZE bytes)
+    // the method returns TRUE, if the MD5 value was successfully read; the digest is stored at
+    // (BYTE*)data->Group
+    // the method returns FALSE on read errors or when the user aborts the operation
+    BOOL GetMD5Digest(CFoundFilesData* file, BYTE* buffer);
+
+    // adds 'read' bytes to ReadSize and displays progress
+    void AddProgress(const CQuadWord& read);
+
+    // adds error 'textResID' (format with %s for the error text) for file 'fullPath' to the log
+    void LogError(int textResID, DWORD err, const char* fullPath);
+};
+
+CDuplicateHasher::CDuplicateHasher(CGrepData* data)
+{
+    HANDLES(InitializeCriticalSection(&ProgressCS));
+    Data = data;
+    Files = NULL;
+    Hashed = NULL;
+    Count = 0;
+    Partial = FALSE;
+    NextFile = 0;
+    ReadSize.Set(0, 0);
+    TotalSize.Set(0, 0);
+    Progress = -1;
+}
+
+CDuplicateHasher::~CDuplicateHasher()
+{
+    HANDLES(DeleteCriticalSection(&ProgressCS));
+}
+
+void CDuplicateHasher::Hash(CFoundFilesData** files, BOOL* hashed, int count, BOOL partial)
+{
+    Files = files;
+    Hashed = hashed;
+    Count = count;
+    Partial = partial;
+    NextFile = 0;
+    int i;
+    for (i = 0; i < count; i++)
+        hashed[i] = FALSE;
+
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    int threadsCount = (int)si.dwNumberOfProcessors;
+    if (threadsCount < 2)
+        threadsCount = 2; // threads wait for the disk most of the time, even a single CPU gains from two threads
+    if (threadsCount > DUPLICATES_MAX_THREADS)
+        threadsCount = DUPLICATES_MAX_THREADS;
+    if (threadsCount > count)
+        threadsCount = count;
+    HANDLE threads[DUPLICATES_MAX_THREADS];
+    int started = 0;
+    for (i = 0; i < threadsCount; i++)
+    {
+        DWORD threadID;
+        threads[started] = HANDLES(CreateThread(NULL, 0, ThreadF, this, 0, &threadID));
+        if (threads[started] == NULL)
+        {
+            TRACE_E("Unable to start duplicates hashing thread.");
+            break;
+        }
+        started++;
+    }
+    if (started == 0)
+        ThreadBody(); // hash the files in this thread
+    else
+    {
+        WaitForMultipleObjects(started, threads, TRUE, INFINITE);
+        for (i = 0; i < started; i++)
+            HANDLES(CloseHandle(threads[i]));
+    }
+    Files = NULL;
+    Hashed = NULL;
+}
+
+DWORD WINAPI CDuplicateHasher::ThreadF(void* param)
+{
+#ifndef CALLSTK_DISABLE
+    CCallStack stack;
+#endif // CALLSTK_DISABLE
+    SetThreadNameInVCAndTrace("DuplicatesHasher");
+    return ThreadEH(param);
+}
+
+unsigned CDuplicateHasher::ThreadEH(void* param)
+{
+#ifndef CALLSTK_DISABLE
+    __try
+    {
+#endif // CALLSTK_DISABLE
+        return ((CDuplicateHasher*)param)->ThreadBody();
+#ifndef CALLSTK_DISABLE
+    }
+    __except (CCallStack::HandleException(GetExceptionInformation()))
+    {
+        TRACE_I("Thread DuplicatesHasher: calling ExitProcess(1).");
+        //    ExitProcess(1);
+        TerminateProcess(GetCurrentProcess(), 1); // harder exit (this call still performs some operations)
+        return 1;
+    }
+#endif // CALLSTK_DISABLE
+}
+
+unsigned CDuplicateHasher::ThreadBody()
+{
+    CALL_STACK_MESSAGE1("CDuplicateHasher::ThreadBody()");
+
+    BYTE* buffer = (BYTE*)malloc(DUPLICATES_BUFFER_SIZE);
+    if (buffer == NULL)
+    {
+        TRACE_E(LOW_MEMORY); // files not hashed by other threads are excluded as unreadable
+        return 0;
+    }
+    while (!Data->StopSearch)
+    {
+        int i = (int)InterlockedIncrement(&NextFile) - 1;
+        if (i >= Count)
+            break;
+        Hashed[i] = GetMD5Digest(Files[i], buffer);
+    }
+    free(buffer);
+    return 0;
+}
+
+void CDuplicateHasher::AddProgress(const CQuadWord& read)
+{
+    HANDLES(EnterCriticalSection(&ProgressCS));
+    // compute and display progress (if the 'progress' value changed)
+    ReadSize += read;
+    int newProgress = ReadSize >= TotalSize ? (TotalSize.Value == 0 ? 0 : 100) : (int)((ReadSize * CQuadWord(100, 0)) / TotalSize).Value;
+    if (newProgress != Progress)
+    {
+        Progress = newProgress;
+        char buff[100];
+        buff[0] = (BYTE)newProgress; // pass the numeric value directly instead of a string
+        buff[1] = 0;
+        Data->SearchingText2->Set(buff); // update the total progress
+    }
+    HANDLES(LeaveCriticalSection(&ProgressCS));
+}
+
+void CDuplicateHasher::LogError(int textResID, DWORD err, const char* fullPath)
+{
+    char buf[MAX_PATH + 100];
+    sprintf(buf, LoadStr(textResID), GetErrorText(err));
+    FIND_LOG_ITEM log;
+    log.Flags = FLI_ERROR;
+    log.Text = buf;
+    log.Path = fullPath;
+    SendMessage(Data->HWindow, WM_USER_ADDLOG, (WPARAM)&log, 0);
+}
+
+BOOL CDuplicateHasher::GetMD5Digest(CFoundFilesData* file, BYTE* buffer)
+{
+    // build full path to the file
+    char fullPath[MAX_PATH];
+    lstrcpyn(fullPath, file->Path, MAX_PATH);
+    SalPathAppend(fullPath, file->Name, MAX_PATH);
+
+    Data->SearchingText->Set(fullPath); // set the current file
+
+    // only the head and tail blocks of large files are read in the partial mode
+    BOOL partial = Partial && file->Size > DUPLICATES_PARTIAL_LIMIT;
+
+    // open the file for reading with sequential access
+    HANDLE hFile = HANDLES_Q(CreateFile(fullPath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                                        NULL, OPEN_EXISTING, partial ? 0 : FILE_FLAG_SEQUENTIAL_SCAN, NULL));
+    if (hFile != INVALID_HANDLE_VALUE)
+    {
+        // use the digest from the persistent cache if the file was not changed since it was computed
+        const char* algorithm = partial ? DUPLICATES_PARTIAL_DIGEST : DUPLICATES_FULL_DIGEST;
+        CSalamanderFileDigestKey key;
+        BOOL keyOK = CFileHashCache::GetKey(hFile, &key);
+        int digestLen;
+        if (keyOK && FileHashCache.Lookup(fullPath, &key, algorithm, (BYTE*)file->Group, MD5_DIGEST_SIZE, &digestLen) &&
+            digestLen == MD5_DIGEST_SIZE)
+        {
+            HANDLES(CloseHandle(hFile));
+            AddProgress(partial ? DUPLICATES_PARTIAL_LIMIT : file->Size); // the same amount as when reading the file
+            return TRUE;
+        }
+
+        MD5 context;
+        DWORD read;     // number of bytes that were actually read
+        int blocks = 0; // number of blocks read in the partial mode
+        // in the partial mode each read takes one whole block
+        DWORD toRead = partial ? DUPLICATES_PARTIAL_SIZE : DUPLICATES_BUFFER_SIZE;
+        while (TRUE)
+        {
+            // read a segment from a file 'file' into 'buffer'
+            if (!ReadFile(hFile, buffer, toRead, &read, NULL))
+            {
+                // error reading the file
+                DWORD err = GetLastError();
+                HANDLES(CloseHandle(hFile));
+                LogError(IDS_ERROR_READING_FILE2, err, fullPath);
+                return FALSE;
+            }
+
+            // does the user want to stop the operation?
+            if (Data->StopSearch)
+            {
+                HANDLES(CloseHandle(hFile));
+                return FALSE;
+            }
+
+            // if anything was read, update the MD5
+            if (read > 0)
+            {
+                context.update(buffer, read);
+                AddProgress(CQuadWord(read, 0));
+            }
+
+            if (partial)
+            {
+                // after the head block continue with the tail block, then we are done
+                if (++blocks == 2 || read != toRead)
+                    break;
+                CQuadWord tail = file->Size - CQuadWord(DUPLICATES_PARTIAL_SIZE, 0);
+                LONG high = (LONG)tail.HiDWord;
+                if (SetFilePointer(hFile, tail.LoDWord, &high, FILE_BEGIN) == INVALID_SET_FILE_POINTER &&
+                    GetLastError() != NO_ERROR)
+                {
+                    DWORD err = GetLastError();
+                    HANDLES(CloseHandle(hFile));
+                    LogError(IDS_ERROR_READING_FILE2, err, fullPath);
+                    return FALSE;
+                }
+            }
+            else
+            {
+                // if fewer bytes were read than the buffer size, we are done
+                if (read != toRead)
+                    break;
+            }
+        }
+        HANDLES(CloseHandle(hFile));
+
+        context.finalize();
+        memcpy((BYTE*)file->Group, context.digest, MD5_DIGEST_SIZE);
+        if (keyOK)
+            FileHashCache.Store(fullPath, &key, algorithm, (BYTE*)file->Group, MD5_DIGEST_SIZE);
+
+        return TRUE;
+    }
+    else
+    {
+        // error occured while opening the file
+        LogError(IDS_ERROR_OPENING_FILE2, GetLastError(), fullPath);
+        return FALSE;
+    }
+}
+
 //*********************************************************************************
 //
 // CDuplicateCandidates
@@ -664,8 +973,9 @@ BOOL CFindIgnore::Set(int index, BOOL enabled, const char* path)
 // 1) In the first phase, all files matching the Find criteria are added
 //    to the CDuplicateCandidates object using the Add method.
 // 2) Then the Examine() method is called which sorts the array using data->FindDupFlags criteria. If file contents
-//    are compared, MD5 digests are calculated for potentially identical files.
-//    Then, the array is sorted again and single files are removed so
+//    are compared, MD5 digests are calculated for potentially identical files in two passes: the first one
+//    hashes only the head and tail blocks of large files, the second one hashes completely only large files
+//    whose partial digests match. After each pass, the array is sorted again and single files are removed so
 //    Only files that appear at least twice remain in the array.
 //    These get a Group variable so that sets can be distinguished in the result window.
 //
@@ -703,18 +1013,12 @@ protected:
     // Group values; groups are numbered increasingly (0, 1, 2, 3, 4, 5, ...)
     void SetGroupByDifferentFlag();
 
-    // compute MD5 from the file 'file'
-    // 'progress' is the numeric value shown in the status bar (optimized so we do not
-    // update the same porgress repeatedly)
-    // 'readSize' holds the number of bytes read so far across all files
-    // 'totalSize' is the total number of bytes of all files for which the MD5 digest
-    // will be determined
-    // the method returns TRUE, if the MD5 value was successfully read; the digest is stored at
-    // (BYTE*)data->Group
-    // the method returns FALSE on read errors or when the user aborts the operation
-    // (then, the variable data->StopSearch is set to TRUE)
-    BOOL GetMD5Digest(CGrepData* data, CFoundFilesData* file,
-                      int* progress, CQuadWord* readSize, const CQuadWord* totalSize);
+    // computes MD5 digests of stored files using 'hasher': in the first pass ('partial' is TRUE)
+    // of all files (only the head and tail blocks of large files), in the second pass
+    // completely of large files; files that could not be read are removed, then the array
+    // is sorted using byMD5 and single files are removed
+    // returns FALSE on low memory (the array is not changed)
+    BOOL HashCandidates(CGrepData* data, CDuplicateHasher* hasher, BOOL partial, BOOL byName, BOOL bySize);
 };
 
 int CDuplicateCandidates::CompareFunc(CFoundFilesData* f1, CFoundFilesData* f2,
@@ -817,97 +1121,70 @@ LABEL_QuickSort:
     }
 }
 
-#define DUPLICATES_BUFFER_SIZE 16384 // buffer size for MD5 calculation
-
-BOOL CDuplicateCandidates::GetMD5Digest(CGrepData* data, CFoundFilesData* file,
-                                        int* progress, CQuadWord* readSize, const CQuadWord* totalSize)
+BOOL CDuplicateCandidates::HashCandidates(CGrepData* data, CDuplicateHasher* hasher, BOOL partial,
+                                          BOOL byName, BOOL bySize)
 {
-    // build full path to the file
-    char fullPath[MAX_PATH];
-    lstrcpyn(fullPath, file->Path, MAX_PATH);
-    SalPathAppend(fullPath, file->Name, MAX_PATH);
-
-    data->SearchingText->Set(fullPath); // set the current file
+    if (Count == 0)
+        return TRUE;
 
-    // open the file for reading with sequential access
-    HANDLE hFile = HANDLES_Q(CreateFile(fullPath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
-                                        NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL));
-    if (hFile != INVALID_HANDLE_VALUE)
+    // collect files whose digest is computed in this pass
+    CFoundFilesData** files = (CFoundFilesData**)malloc(Count * sizeof(CFoundFilesData*));
+    int* indexes = (int*)malloc(Count * sizeof(int));
+    BOOL* hashed = (BOOL*)malloc(Count * sizeof(BOOL));
+    if (files == NULL || indexes == NULL || hashed == NULL)
     {
-        BYTE buffer[DUPLICATES_BUFFER_SIZE];
-        MD5 context;
-        DWORD read; // number of bytes that were actually read
-        while (TRUE)
+        TRACE_E(LOW_MEMORY);
+        if (files != NULL)
+            free(files);
+        if (indexes != NULL)
+            free(indexes);
+        if (hashed != NULL)
+            free(hashed);
+        return FALSE;
+    }
+    int count = 0;
+    int i;
+    for (i = 0; i < Count; i++)
+    {
+        CFoundFilesData* file = At(i);
+        // the first pass hashes all files, the second one only large files, whose digests are partial
+        if (partial ? file->Size > CQuadWord(0, 0) : file->Size > DUPLICATES_PARTIAL_LIMIT)
         {
-            // read a segment from a file 'file' into 'buffer'
-            if (!ReadFile(hFile, buffer, DUPLICATES_BUFFER_SIZE, &read, NULL))
-            {
-                // error reading the file
-                DWORD err = GetLastError();
-                HANDLES(CloseHandle(hFile));
-
-                char buf[MAX_PATH + 100];
-                sprintf(buf, LoadStr(IDS_ERROR_READING_FILE2), GetErrorText(err));
-                FIND_LOG_ITEM log;
-                log.Flags = FLI_ERROR;
-                log.Text = buf;
-                log.Path = fullPath;
-                SendMessage(data->HWindow, WM_USER_ADDLOG, (WPARAM)&log, 0);
-
-                return FALSE;
-            }
-
-            // does the user want to stop the operation?
-            if (data->StopSearch)
-            {
-                HANDLES(CloseHandle(hFile));
-                return FALSE;
-            }
-
-            // if anything was read, update the MD5
-            if (read > 0)
-            {
-                context.update(buffer, read);
+            files[count] = file;
+            indexes[count] = i;
+            count++;
+        }
+    }
 
-                // compute and display progress (if the 'progress' value changed)
-                *readSize += CQuadWord(read, 0);
-                char buff[100];
-                int newProgress = *readSize >= *totalSize ? (totalSize->Value == 0 ? 0 : 100) : (int)((*readSize * CQuadWord(100, 0)) / *totalSize).Value;
-                if (newProgress != *progress)
-                {
-                    *progress = newProgress;
-                    buff[0] = (BYTE)newProgress; // pass the numeric value directly instead of a string
-                    buff[1] = 0;
-                    data->SearchingText2->Set(buff); // update the total progress
-                }
-            }
+    if (count > 0)
+    {
+        hasher->Hash(files, hashed, count, partial);
 
-            // if fewer bytes were read than the buffer size, we are done
-            if (read != DUPLICATES_BUFFER_SIZE)
-                break;
+        // exclude files that could not be read; if the user stopped searching, exclude also files
+        // with unknown or only partial digests, so at least the duplicates that have been already
+        // found are shown
+        BOOL stop = data->StopSearch;
+        for (i = count - 1; i >= 0; i--)
+        {
+            if (!hashed[i] || (stop && partial && files[i]->Size > DUPLICATES_PARTIAL_LIMIT))
+                Delete(indexes[i]);
         }
-        HANDLES(CloseHandle(hFile));
-
-        context.finalize();
-        memcpy((BYTE*)file->Group, context.digest, MD5_DIGEST_SIZE);
 
-        return TRUE;
-    }
-    else
-    {
-        // error occured while opening the file
-        DWORD err = GetLastError();
+        // search finished, preparing results
+        data->SearchingText->Set(LoadStr(IDS_FIND_DUPS_RESULTS));
 
-        char buf[MAX_PATH + 100];
-        sprintf(buf, LoadStr(IDS_ERROR_OPENING_FILE2), GetErrorText(err));
-        FIND_LOG_ITEM log;
-        log.Flags = FLI_ERROR;
-        log.Text = buf;
-        log.Path = fullPath;
-        SendMessage(data->HWindow, WM_USER_ADDLOG, (WPARAM)&log, 0);
+        // sort the files again
+        if (Count > 0)
+            QuickSort(0, Count - 1, byName, bySize, TRUE);
 
-        return FALSE;
+        // remove items that occur only once
+        RemoveSingleFiles(byName, bySize, TRUE);
     }
+
+    free(files);
+    free(indexes);
+    free(hashed);
+    return TRUE;
 }
 
 void CDuplicateCandidates::RemoveSingleFiles(BOOL byName, BOOL bySize, BOOL byMD5)
@@ -1065,46 +1342,39 @@ void CDuplicateCandidates::Examine(CGrepData* data)
                     file->Group = 0;
             }
 
-            // determine total file size for progress
+            // determine the number of bytes to read for progress: small files are read once, large
+            // files by the head and tail blocks and then completely (we will see how many of them)
             CQuadWord totalSize(0, 0);
             for (i = 0; i < Count; i++)
-                totalSize += At(i)->Size;
-
-            // retrieve the MD5 digest of files
-            CQuadWord readSize(0, 0);
-            int progress = -1;
-            for (i = Count - 1; i >= 0; i--)
             {
                 CFoundFilesData* file = At(i);
-                if (file->Size > CQuadWord(0, 0))
+                if (file->Size > DUPLICATES_PARTIAL_LIMIT)
+                    totalSize += DUPLICATES_PARTIAL_LIMIT;
+                totalSize += file->Size;
+            }
+            CDuplicateHasher hasher(data);
+            hasher.SetTotalSize(totalSize);
+
+            // the first pass: hashing complete small files and the head and tail blocks of large files
+            BOOL ok = HashCandidates(data, &hasher, TRUE, byName, bySize);
+            if (ok && !data->StopSearch)
+            {
+                // the second pass: hashing complete large files whose partial digests match
+                totalSize = hasher.GetReadSize();
+                for (i = 0; i < Count; i++)
                 {
-                    if (!GetMD5Digest(data, file, &progress, &readSize, &totalSize))
-                    {
-                        if (data->StopSearch)
-                        {
-                            // the user wants to stop searching
-                            // trim the unprocessed items
-                            int j;
-                            for (j = 0; j <= i; j++)
-                                Delete(0);
-                            break; // show at least the duplicates that have been already found
-                        }
-                        // an error occurred during reading the file but the user wants to continue
-                        // exclude the file from candidates
-                        Delete(i);
-                    }
+                    CFoundFilesData* file = At(i);
+                    if (file->Size > DUPLICATES_PARTIAL_LIMIT)
+                        totalSize += file->Size;
                 }
+                hasher.SetTotalSize(totalSize);
+                ok = HashCandidates(data, &hasher, FALSE, byName, bySize);
+            }
+            if (!ok)
+            {
+                free(digest);
+                return;
             }
-
-            // search finished, preparing results
-            data->SearchingText->Set(LoadStr(IDS_FIND_DUPS_RESULTS));
-
-            // sort the files again
-            if (Count > 0)
-                QuickSort(0, Count - 1, byName, bySize, TRUE);
-
-            // remove items that occur only once
-            RemoveSingleFiles(byName, bySize, TRUE);
         }
     }
 
@@ -1185,8 +1455,10 @@ int SearchForward(CGrepData* data, char* txt, int size, int off)
 //
 // ****************************************************************************
 
+// 'regExp' is data->RegExp or its copy owned by the calling thread (SetLine modifies the object)
 BOOL TestFileContentAux(BOOL& ok, CQuadWord& fileOffset, const CQuadWord& totalSize,
-                        DWORD viewSize, const char* path, char* txt, CGrepData* data)
+                        DWORD viewSize, const char* path, char* txt, CGrepData* data,
+                        CRegularExpression* regExp)
 {
     __try
     {
@@ -1254,13 +1526,13 @@ BOOL TestFileContentAux(BOOL& ok, CQuadWord& fileOffset, const CQuadWord& totalS
                 }
 
                 // line beg->end
-                if (data->RegExp.SetLine(beg, end))
+                if (regExp->SetLine(beg, end))
                 {
                     int foundLen, start = 0;
 
                 GREP_REGEXP_NEXT:
 
-                    int found = data->RegExp.SearchForward(start, foundLen);
+                    int found = regExp->SearchForward(start, foundLen);
                     if (found != -1)
                     {
                         if (data->WholeWords)
@@ -1287,7 +1559,7 @@ BOOL TestFileContentAux(BOOL& ok, CQuadWord& fileOffset, const CQuadWord& totalS
                 {
                     FIND_LOG_ITEM log;
                     log.Flags = FLI_ERROR;
-                    log.Text = data->RegExp.GetLastErrorText();
+                    log.Text = regExp->GetLastErrorText();
                     log.Path = NULL;
                     SendMessage(data->HWindow, WM_USER_ADDLOG, (WPARAM)&log, 0);
                     return FALSE; // do not search this file further
@@ -1356,7 +1628,8 @@ BOOL TestFileContentAux(BOOL& ok, CQuadWord& fileOffset, const CQuadWord& totalS
     }
 }
 
-BOOL TestFileContent(DWORD sizeLow, DWORD sizeHigh, const char* path, CGrepData* data, BOOL isLink)
+BOOL TestFileContent(DWORD sizeLow, DWORD sizeHigh, const char* path, CGrepData* data, BOOL isLink,
+                     CRegularExpression* regExp)
 {
     CQuadWord totalSize(sizeLow, sizeHigh);
     CQuadWord fileOffset(0, 0);
@@ -1404,7 +1677,7 @@ BOOL TestFileContent(DWORD sizeLow, DWORD sizeHigh, const char* path, CGrepData*
                             // let the file view be examined
                             DWORD diff = (DWORD)(fileOffset - mapFileOffset).Value;
                             BOOL err2 = !TestFileContentAux(ok, fileOffset, totalSize, viewSize - diff,
-                                                            path, txt + diff, data);
+                                                            path, txt + diff, data, regExp);
                             HANDLES(UnmapViewOfFile(txt));
                             if (err2 || ok)
                                 break;
@@ -1612,7 +1885,8 @@ void SearchDirectory(char (&path)[MAX_PATH], char* end, int startPathLen,
                                     // links: file.nFileSizeLow == 0 && file.nFileSizeHigh == 0, the file size
                                     // must be additionally obtained via SalGetFileSize()
                                     BOOL isLink = (file.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0;
-                                    ok = TestFileContent(file.nFileSizeLow, file.nFileSizeHigh, path, data, isLink);
+                                    ok = TestFileContent(file.nFileSizeLow, file.nFileSizeHigh, path, data, isLink,
+                                                         &data->RegExp);
                                 }
                             }
                             else
@@ -1787,6 +2061,511 @@ void SearchDirectory(char (&path)[MAX_PATH], char* end, int startPathLen,
     *end = 0;
 }
 
+//*********************************************************************************
+//
+// CParallelGrep
+//
+// Content search (data->Grep) of new data on several threads: a shared queue of
+// directories for enumeration plus a queue of files waiting for content testing;
+// every thread prefers files (so the number of waiting files stays bounded) and
+// enumerates another directory only when no file is waiting. Found files are
+// passed to AddFoundItem (only one thread at a time), so the list view is refreshed
+// through FoundVisibleCount/NeedRefresh the same way as from SearchDirectory.
+// Unlike SearchDirectory the order of found files is not deterministic.
+
+#define GREP_MAX_THREADS 8 // upper limit for the number of search threads
+
+struct CGrepFileTask
+{
+    char* Path; // directory in the form used by AddFoundItem (without trailing backslash except for root)
+    char* Name; // file name
+    DWORD SizeLow;
+    DWORD SizeHigh;
+    DWORD Attr;
+    FILETIME LastWrite;
+
+    CGrepFileTask()
+    {
+        Path = NULL;
+        Name = NULL;
+    }
+    ~CGrepFileTask()
+    {
+        if (Path != NULL)
+            free(Path);
+        if (Name != NULL)
+            free(Name);
+    }
+};
+
+class CParallelGrep
+{
+protected:
+    CRITICAL_SECTION QueueCS;            // guards Dirs, Files, ActiveThreads and Done
+    TDirectArray<char*> Dirs;            // directories to enumerate (full path with trailing backslash, allocated by malloc)
+    TIndirectArray<CGrepFileTask> Files; // files waiting for content testing
+    int ActiveThreads;                   // number of threads working on a task taken from the queues
+    BOOL Done;                           // TRUE = everything was searched or the search was stopped
+    HANDLE WorkChanged;                  // manual-reset event: new task was added or Done was set
+
+    CRITICAL_SECTION ResultCS; // serializes AddFoundItem (list view data and NeedRefresh)
+
+    // search parameters (valid for all threads, read-only during the search)
+    CGrepData* Data;
+    CMaskGroup* MasksGroup;
+    BOOL IncludeSubDirs;
+    int StartPathLen;
+    CFindIgnore* IgnoreList;
+
+public:
+    CParallelGrep(CGrepData* data, CMaskGroup* masksGroup, BOOL includeSubDirs, int startPathLen,
+                  CFindIgnore* ignoreList);
+    ~CParallelGrep();
+
+    // searches directory 'path' (with trailing backslash) and, if IncludeSubDirs is TRUE,
+    // its subdirectories; returns after all threads finish; returns FALSE if the threads
+    // could not be started (the caller should use SearchDirectory instead)
+    BOOL Search(const char* path);
+
+protected:
+    static DWORD WINAPI ThreadF(void* param);
+    static unsigned ThreadEH(void* param);
+    unsigned ThreadBody();
+
+    // enumerates one directory 'path' (with trailing backslash); adds found files
+    // and subdirectories to the queues
+    void EnumDirectory(char (&path)[MAX_PATH], char (&message)[2 * MAX_PATH]);
+
+    // tests the content of file 'task' and adds it to the list of found files if it matches
+    void TestFile(CGrepFileTask* task, CRegularExpression* regExp);
+};
+
+CParallelGrep::CParallelGrep(CGrepData* data, CMaskGroup* masksGroup, BOOL includeSubDirs, int startPathLen,
+                             CFindIgnore* ignoreList) : Dirs(1000, 1000), Files(1000, 1000)
+{
+    HANDLES(InitializeCriticalSection(&QueueCS));
+    HANDLES(InitializeCriticalSection(&ResultCS));
+    ActiveThreads = 0;
+    Done = FALSE;
+    WorkChanged = HANDLES(CreateEvent(NULL, TRUE, FALSE, NULL));
+    Data = data;
+    MasksGroup = masksGroup;
+    IncludeSubDirs = includeSubDirs;
+    StartPathLen = startPathLen;
+    IgnoreList = ignoreList;
+}
+
+CParallelGrep::~CParallelGrep()
+{
+    int i;
+    for (i = 0; i < Dirs.Count; i++) // only after the search was stopped
+        free(Dirs[i]);
+    if (WorkChanged != NULL)
+        HANDLES(CloseHandle(WorkChanged));
+    HANDLES(DeleteCriticalSection(&ResultCS));
+    HANDLES(DeleteCriticalSection(&QueueCS));
+}
+
+BOOL CParallelGrep::Search(const char* path)
+{
+    if (WorkChanged == NULL)
+        return FALSE;
+    char* root = DupStr(path);
+    if (root == NULL)
+        return FALSE;
+    Dirs.Add(root);
+    if (!Dirs.IsGood())
+    {
+        Dirs.ResetState();
+        free(root);
+        return FALSE;
+    }
+
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    int count = (int)si.dwNumberOfProcessors;
+    if (count < 2)
+        count = 2; // threads wait for the disk most of the time, even a single CPU gains from two threads
+    if (count > GREP_MAX_THREADS)
+        count = GREP_MAX_THREADS;
+    HANDLE threads[GREP_MAX_THREADS];
+    int started = 0;
+    int i;
+    for (i = 0; i < count; i++)
+    {
+        DWORD threadID;
+        threads[started] = HANDLES(CreateThread(NULL, 0, ThreadF, this, 0, &threadID));
+        if (threads[started] == NULL)
+        {
+            TRACE_E("Unable to start Grep worker thread.");
+            break;
+        }
+        started++;
+    }
+    if (started == 0)
+    {
+        free(Dirs[0]);
+        Dirs.Delete(0);
+        return FALSE;
+    }
+    WaitForMultipleObjects(started, threads, TRUE, INFINITE);
+    for (i = 0; i < started; i++)
+        HANDLES(CloseHandle(threads[i]));
+    return TRUE;
+}
+
+DWORD WINAPI CParallelGrep::ThreadF(void* param)
+{
+#ifndef CALLSTK_DISABLE
+    CCallStack stack;
+#endif // CALLSTK_DISABLE
+    return ThreadEH(param);
+}
+
+unsigned CParallelGrep::ThreadEH(void* param)
+{
+#ifndef CALLSTK_DISABLE
+    __try
+    {
+#endif // CALLSTK_DISABLE
+        return ((CParallelGrep*)param)->ThreadBody();
+#ifndef CALLSTK_DISABLE
+    }
+    __except (CCallStack::HandleException(GetExceptionInformation()))
+    {
+        TRACE_I("Thread Grep Worker: calling ExitProcess(1).");
+        //    ExitProcess(1);
+        TerminateProcess(GetCurrentProcess(), 1); // harder exit (this call still performs some operations)
+        return 1;
+    }
+#endif // CALLSTK_DISABLE
+}
+
+unsigned CParallelGrep::ThreadBody()
+{
+    CALL_STACK_MESSAGE1("CParallelGrep::ThreadBody()");
+    SetThreadNameInVCAndTrace("GrepWorker");
+
+    // SetLine modifies the regular expression object, each thread needs its own copy
+    CRegularExpression regExp;
+    if (Data->Regular && !regExp.Set(Data->RegExp.GetPattern(), Data->RegExp.GetFlags()))
+    {
+        TRACE_E("CParallelGrep::ThreadBody(): unable to compile regular expression: " << regExp.GetLastErrorText());
+        Data->StopSearch = TRUE;
+    }
+
+    char path[MAX_PATH];
+    char message[2 * MAX_PATH];
+    HANDLES(EnterCriticalSection(&QueueCS));
+    while (1)
+    {
+        if (Data->StopSearch && !Done)
+        {
+            Done = TRUE;
+            SetEvent(WorkChanged);
+        }
+        if (Done)
+            break;
+
+        if (Files.Count > 0) // files first, so the queue of waiting files cannot grow too much
+        {
+            CGrepFileTask* task = Files[Files.Count - 1];
+            Files.Detach(Files.Count - 1);
+            if (!Files.IsGood())
+                Files.ResetState(); // Detach cannot fail, it only could not shrink the array
+            ActiveThreads++;
+            HANDLES(LeaveCriticalSection(&QueueCS));
+
+            TestFile(task, &regExp);
+            delete task;
+
+            HANDLES(EnterCriticalSection(&QueueCS));
+            ActiveThreads--;
+            continue;
+        }
+
+        if (Dirs.Count > 0)
+        {
+            char* dir = Dirs[Dirs.Count - 1];
+            Dirs.Delete(Dirs.Count - 1);
+            if (!Dirs.IsGood())
+                Dirs.ResetState(); // Delete cannot fail, it only could not shrink the array
+            ActiveThreads++;
+            HANDLES(LeaveCriticalSection(&QueueCS));
+
+            lstrcpyn(path, dir, MAX_PATH);
+            free(dir);
+            EnumDirectory(path, message);
+
+            HANDLES(EnterCriticalSection(&QueueCS));
+            ActiveThreads--;
+            continue;
+        }
+
+        if (ActiveThreads == 0) // queues are empty and nobody can add anything, we are done
+        {
+            Done = TRUE;
+            SetEvent(WorkChanged);
+            break;
+        }
+
+        // wait for a task from other threads; StopSearch is not signaled, so we test it periodically
+        ResetEvent(WorkChanged);
+        HANDLES(LeaveCriticalSection(&QueueCS));
+        WaitForSingleObject(WorkChanged, 100);
+        HANDLES(EnterCriticalSection(&QueueCS));
+    }
+    HANDLES(LeaveCriticalSection(&QueueCS));
+
+    if (Data->NeedRefresh) // let the last found items be displayed
+    {
+        HANDLES(EnterCriticalSection(&ResultCS));
+        if (Data->NeedRefresh)
+        {
+            SendMessage(Data->HWindow, WM_USER_ADDFILE, 0, 0);
+            Data->NeedRefresh = FALSE;
+        }
+        HANDLES(LeaveCriticalSection(&ResultCS));
+    }
+    return 0;
+}
+
+void CParallelGrep::EnumDirectory(char (&path)[MAX_PATH], char (&message)[2 * MAX_PATH])
+{
+    SLOW_CALL_STACK_MESSAGE2("CParallelGrep::EnumDirectory(%s, )", path);
+
+    if (IgnoreList != NULL && IgnoreList->Contains(path, StartPathLen))
+    {
+        FIND_LOG_ITEM log;
+        log.Flags = FLI_INFO;
+        log.Text = LoadStr(IDS_FINDLOG_SKIP);
+        log.Path = path;
+        SendMessage(Data->HWindow, WM_USER_ADDLOG, (WPARAM)&log, 0);
+        return;
+    }
+
+    char* end = path + strlen(path);
+    if ((end - path) + 1 < _countof(path))
+        strcpy_s(end, _countof(path) - (end - path), "*");
+    else
+    {
+        FIND_LOG_ITEM log;
+        log.Flags = FLI_ERROR;
+        log.Text = LoadStr(IDS_TOOLONGNAME);
+        log.Path = path;
+        SendMessage(Data->HWindow, WM_USER_ADDLOG, (WPARAM)&log, 0);
+        return;
+    }
+
+    // directory in the form used by AddFoundItem (without trailing backslash except for root)
+    char dirPath[MAX_PATH];
+    lstrcpyn(dirPath, path, (int)(end - path) + 1);
+    if (end - path > 3)
+        dirPath[end - path - 1] = 0;
+
+    WIN32_FIND_DATA file;
+    HANDLE find = HANDLES_Q(FindFirstFile(path, &file));
+    *end = 0;
+    if (find == INVALID_HANDLE_VALUE)
+    {
+        DWORD err = GetLastError();
+        if (err != ERROR_FILE_NOT_FOUND && err != ERROR_NO_MORE_FILES)
+        {
+            sprintf(message, LoadStr(IDS_DIRERRORFORMAT), GetErrorText(err));
+
+            FIND_LOG_ITEM log;
+            log.Flags = FLI_ERROR | FLI_IGNORE;
+            log.Text = message;
+            log.Path = dirPath;
+            SendMessage(Data->HWindow, WM_USER_ADDLOG, (WPARAM)&log, 0);
+        }
+        return;
+    }
+
+    Data->SearchingText->Set(dirPath); // set the current path
+
+    // found files and subdirectories are collected locally and added to the queues at once
+    TIndirectArray<CGrepFileTask> files(100, 500);
+    TDirectArray<char*> dirs(50, 200);
+    BOOL lowMemory = FALSE;
+    BOOL testFindNextErr = TRUE;
+    do
+    {
+        BOOL isDir = (file.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        if (file.cFileName[0] == 0 ||
+            isDir && (lstrcmp(file.cFileName, ".") == 0 || lstrcmp(file.cFileName, "..") == 0))
+        {
+            continue;
+        }
+        if ((end - path) + lstrlen(file.cFileName) >= _countof(path)) // too long file-name
+        {
+            FIND_LOG_ITEM log;
+            log.Flags = FLI_ERROR;
+            log.Text = LoadStr(IDS_TOOLONGNAME);
+            strcpy_s(message, path);
+            strcat_s(message, file.cFileName);
+            log.Path = message;
+            SendMessage(Data->HWindow, WM_USER_ADDLOG, (WPARAM)&log, 0);
+            continue;
+        }
+
+        // after finding an item without displaying it and once 0.5 s have passed since the last redraw,
+        // we request the listview to redraw
+        if (Data->NeedRefresh && GetTickCount() - Data->FoundVisibleTick >= 500)
+        {
+            HANDLES(EnterCriticalSection(&ResultCS));
+            if (Data->NeedRefresh)
+            {
+                SendMessage(Data->HWindow, WM_USER_ADDFILE, 0, 0);
+                Data->NeedRefresh = FALSE;
+            }
+            HANDLES(LeaveCriticalSection(&ResultCS));
+        }
+
+        if (!isDir) // a directory cannot be grepped
+        {
+            // test the criteria attributes, size, date and time + file name
+            CQuadWord size(file.nFileSizeLow, file.nFileSizeHigh);
+            if (Data->Criteria.Test(file.dwFileAttributes, &size, &file.ftLastWriteTime) &&
+                MasksGroup->AgreeMasks(file.cFileName, NULL))
+            {
+                CGrepFileTask* task = new CGrepFileTask;
+                if (task != NULL)
+                {
+                    task->Path = DupStr(dirPath);
+                    task->Name = DupStr(file.cFileName);
+                    task->SizeLow = file.nFileSizeLow;
+                    task->SizeHigh = file.nFileSizeHigh;
+                    task->Attr = file.dwFileAttributes;
+                    task->LastWrite = file.ftLastWriteTime;
+                    if (task->Path != NULL && task->Name != NULL)
+                        files.Add(task);
+                    if (task->Path == NULL || task->Name == NULL || !files.IsGood())
+                    {
+                        files.ResetState();
+                        delete task;
+                        lowMemory = TRUE;
+                    }
+                }
+                else
+                    lowMemory = TRUE;
+            }
+        }
+        else
+        {
+            if (IncludeSubDirs)
+            {
+                int l = (int)strlen(file.cFileName);
+                if ((end - path) + l + 1 /* 1 for backslash */ < _countof(path))
+                {
+                    strcpy_s(end, _countof(path) - (end - path), file.cFileName);
+                    strcat_s(end, _countof(path) - (end - path), "\\");
+                    char* dir = DupStr(path);
+                    *end = 0;
+                    if (dir != NULL)
+                        dirs.Add(dir);
+                    if (dir == NULL || !dirs.IsGood())
+                    {
+                        dirs.ResetState();
+                        if (dir != NULL)
+                            free(dir);
+                        lowMemory = TRUE;
+                    }
+                }
+                else
+                {
+                    FIND_LOG_ITEM log;
+                    log.Flags = FLI_ERROR;
+                    log.Text = LoadStr(IDS_TOOLONGNAME);
+                    strcpy_s(end, _countof(path) - (end - path), file.cFileName);
+                    log.Path = path;
+                    SendMessage(Data->HWindow, WM_USER_ADDLOG, (WPARAM)&log, 0);
+                    *end = 0;
+                }
+            }
+        }
+        if (Data->StopSearch || lowMemory)
+        {
+            testFindNextErr = FALSE;
+            break;
+        }
+    } while (FindNextFile(find, &file));
+    DWORD err = GetLastError();
+    HANDLES(FindClose(find));
+
+    if (testFindNextErr && err != ERROR_NO_MORE_FILES)
+    {
+        sprintf(message, LoadStr(IDS_DIRERRORFORMAT), GetErrorText(err));
+        FIND_LOG_ITEM log;
+        log.Flags = FLI_ERROR;
+        log.Text = message;
+        log.Path = dirPath;
+        SendMessage(Data->HWindow, WM_USER_ADDLOG, (WPARAM)&log, 0);
+    }
+
+    // hand over the collected tasks to the other threads
+    HANDLES(EnterCriticalSection(&QueueCS));
+    int i;
+    for (i = dirs.Count - 1; !lowMemory && i >= 0; i--) // reversed, so the first subdirectory is taken first
+    {
+        Dirs.Add(dirs[i]);
+        if (!Dirs.IsGood())
+        {
+            Dirs.ResetState();
+            lowMemory = TRUE;
+            break;
+        }
+        dirs.Delete(i);
+    }
+    for (i = files.Count - 1; !lowMemory && i >= 0; i--)
+    {
+        Files.Add(files[i]);
+        if (!Files.IsGood())
+        {
+            Files.ResetState();
+            lowMemory = TRUE;
+            break;
+        }
+        files.Detach(i);
+    }
+    if (dirs.Count > 0 || files.Count > 0) // no room in the queues; 'files' destroys the remaining tasks
+    {
+        for (i = 0; i < dirs.Count; i++)
+            free(dirs[i]);
+    }
+    SetEvent(WorkChanged);
+    HANDLES(LeaveCriticalSection(&QueueCS));
+
+    if (lowMemory)
+    {
+        FIND_LOG_ITEM log;
+        log.Flags = FLI_ERROR;
+        log.Text = LoadStr(IDS_CANTSHOWRESULTS);
+        log.Path = NULL;
+        SendMessage(Data->HWindow, WM_USER_ADDLOG, (WPARAM)&log, 0);
+
+        Data->StopSearch = TRUE;
+    }
+}
+
+void CParallelGrep::TestFile(CGrepFileTask* task, CRegularExpression* regExp)
+{
+    char fullPath[MAX_PATH];
+    lstrcpyn(fullPath, task->Path, MAX_PATH);
+    if (!SalPathAppend(fullPath, task->Name, MAX_PATH))
+        return; // cannot happen, EnumDirectory tests the length of names
+    // links: file.nFileSizeLow == 0 && file.nFileSizeHigh == 0, the file size
+    // must be additionally obtained via SalGetFileSize()
+    BOOL isLink = (task->Attr & FILE_ATTRIBUTE_REPARSE_POINT) != 0;
+    if (TestFileContent(task->SizeLow, task->SizeHigh, fullPath, Data, isLink, regExp))
+    {
+        HANDLES(EnterCriticalSection(&ResultCS));
+        AddFoundItem(task->Path, task->Name, task->SizeLow, task->SizeHigh, task->Attr,
+                     &task->LastWrite, FALSE, Data, NULL);
+        HANDLES(LeaveCriticalSection(&ResultCS));
+    }
+}
+
 void RefineData(CMaskGroup* masksGroup, CGrepData* data)
 {
     int refineCount = data->FoundFilesListView->GetDataForRefineCount();
@@ -1836,7 +2615,7 @@ void RefineData(CMaskGroup* masksGroup, CGrepData* data)
                 // links: refineData->Size == 0, the file size must be additionally obtained via SalGetFileSize()
                 BOOL isLink = (refineData->Attr & FILE_ATTRIBUTE_REPARSE_POINT) != 0; // size == 0, the file size must be obtained via SalGetFileSize()
                 ok = TestFileContent(refineData->Size.LoDWord, refineData->Size.HiDWord,
-                                     fullPath, data, isLink);
+                                     fullPath, data, isLink, &data->RegExp);
             }
         }
 
@@ -1952,9 +2731,18 @@ unsigned GrepThreadFBody(void* ptr)
                     }
                 }
 
-                char message[2 * MAX_PATH];
-                SearchDirectory(path, end, (int)(end - path), mg, includeSubDirs, data, dirStack, 0,
-                                duplicateCandidates, ignoreList, message);
+                BOOL searched = FALSE;
+                if (data->Grep && duplicateCandidates == NULL) // content search: use more threads (files are opened and tested in parallel)
+                {
+                    CParallelGrep parallelGrep(data, mg, includeSubDirs, (int)(end - path), ignoreList);
+                    searched = parallelGrep.Search(path);
+                }
+                if (!searched)
+                {
+                    char message[2 * MAX_PATH];
+                    SearchDirectory(path, end, (int)(end - path), mg, includeSubDirs, data, dirStack, 0,
+                                    duplicateCandidates, ignoreList, message);
+                }
 
                 if (ignoreList != NULL)
                     delete ignoreList;
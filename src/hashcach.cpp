@@ -0,0 +1,588 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "precomp.h"
+
+#include "cfgdlg.h"
+#include "shiconov.h"
+#include "hashcach.h"
+#include "plugins\shared\sqlite\sqlite3.h"
+
+CFileHashCache FileHashCache;
+CThumbnailDiskCache ThumbnailDiskCache;
+
+// after how many stored digests the number of items in the database is compared with the limit
+#define HASHCACHE_LIMIT_CHECK_PERIOD 1000
+
+// how often (in seconds) the last use time of a digest is updated when the digest is read
+// (the least recently used digests are dropped first, a precise time is not needed)
+#define HASHCACHE_TOUCH_PERIOD (24 * 60 * 60)
+
+// after how many stored thumbnails the total size of thumbnails in the database is compared with the limit
+#define THUMBCACHE_LIMIT_CHECK_PERIOD 100
+
+//
+// *****************************************************************************
+// CHashCacheSQLite
+//
+
+typedef int (*FT_sqlite3_open_v2)(const char* filename, sqlite3** ppDb, int flags, const char* zVfs);
+typedef int (*FT_sqlite3_close)(sqlite3*);
+typedef int (*FT_sqlite3_exec)(sqlite3*, const char* sql, int (*callback)(void*, int, char**, char**),
+                               void*, char** errmsg);
+typedef int (*FT_sqlite3_busy_timeout)(sqlite3*, int ms);
+typedef int (*FT_sqlite3_prepare_v2)(sqlite3* db, const char* zSql, int nByte, sqlite3_stmt** ppStmt, const char** pzTail);
+typedef int (*FT_sqlite3_step)(sqlite3_stmt*);
+typedef int (*FT_sqlite3_reset)(sqlite3_stmt* pStmt);
+typedef int (*FT_sqlite3_finalize)(sqlite3_stmt* pStmt);
+typedef int (*FT_sqlite3_bind_text)(sqlite3_stmt*, int, const char*, int, void (*)(void*));
+typedef int (*FT_sqlite3_bind_int64)(sqlite3_stmt*, int, sqlite3_int64);
+typedef int (*FT_sqlite3_bind_blob)(sqlite3_stmt*, int, const void*, int n, void (*)(void*));
+typedef sqlite3_int64 (*FT_sqlite3_column_int64)(sqlite3_stmt*, int iCol);
+typedef const void* (*FT_sqlite3_column_blob)(sqlite3_stmt*, int iCol);
+typedef int (*FT_sqlite3_column_bytes)(sqlite3_stmt*, int iCol);
+
+struct CHashCacheSQLite : public CSQLite3DynLoadBase
+{
+    FT_sqlite3_open_v2 open_v2;
+    FT_sqlite3_close close;
+    FT_sqlite3_exec exec;
+    FT_sqlite3_busy_timeout busy_timeout;
+    FT_sqlite3_prepare_v2 prepare_v2;
+    FT_sqlite3_step step;
+    FT_sqlite3_reset reset;
+    FT_sqlite3_finalize finalize;
+    FT_sqlite3_bind_text bind_text;
+    FT_sqlite3_bind_int64 bind_int64;
+    FT_sqlite3_bind_blob bind_blob;
+    FT_sqlite3_column_int64 column_int64;
+    FT_sqlite3_column_blob column_blob;
+    FT_sqlite3_column_bytes column_bytes;
+
+    CHashCacheSQLite();
+};
+
+CHashCacheSQLite::CHashCacheSQLite()
+{
+    char sqlitePath[MAX_PATH];
+    if (GetSQLitePath(sqlitePath, MAX_PATH))
+    {
+        SQLite3DLL = HANDLES(LoadLibrary(sqlitePath));
+        if (SQLite3DLL != NULL)
+        {
+            open_v2 = (FT_sqlite3_open_v2)GetProcAddress(SQLite3DLL, "sqlite3_open_v2");
+            close = (FT_sqlite3_close)GetProcAddress(SQLite3DLL, "sqlite3_close");
+            exec = (FT_sqlite3_exec)GetProcAddress(SQLite3DLL, "sqlite3_exec");
+            busy_timeout = (FT_sqlite3_busy_timeout)GetProcAddress(SQLite3DLL, "sqlite3_busy_timeout");
+            prepare_v2 = (FT_sqlite3_prepare_v2)GetProcAddress(SQLite3DLL, "sqlite3_prepare_v2");
+            step = (FT_sqlite3_step)GetProcAddress(SQLite3DLL, "sqlite3_step");
+            reset = (FT_sqlite3_reset)GetProcAddress(SQLite3DLL, "sqlite3_reset");
+            finalize = (FT_sqlite3_finalize)GetProcAddress(SQLite3DLL, "sqlite3_finalize");
+            bind_text = (FT_sqlite3_bind_text)GetProcAddress(SQLite3DLL, "sqlite3_bind_text");
+            bind_int64 = (FT_sqlite3_bind_int64)GetProcAddress(SQLite3DLL, "sqlite3_bind_int64");
+            bind_blob = (FT_sqlite3_bind_blob)GetProcAddress(SQLite3DLL, "sqlite3_bind_blob");
+            column_int64 = (FT_sqlite3_column_int64)GetProcAddress(SQLite3DLL, "sqlite3_column_int64");
+            column_blob = (FT_sqlite3_column_blob)GetProcAddress(SQLite3DLL, "sqlite3_column_blob");
+            column_bytes = (FT_sqlite3_column_bytes)GetProcAddress(SQLite3DLL, "sqlite3_column_bytes");
+            OK = open_v2 != NULL && close != NULL && exec != NULL && busy_timeout != NULL &&
+                 prepare_v2 != NULL && step != NULL && reset != NULL && finalize != NULL &&
+                 bind_text != NULL && bind_int64 != NULL && bind_blob != NULL &&
+                 column_int64 != NULL && column_blob != NULL && column_bytes != NULL;
+            if (!OK)
+                TRACE_E("Cannot get sqlite.dll exports!");
+        }
+        else
+            TRACE_E("Cannot load sqlite.dll!");
+    }
+    else
+        TRACE_E("Cannot find path with sqlite.dll!");
+}
+
+//
+// *****************************************************************************
+// CSQLiteCacheBase
+//
+
+// current time in seconds (used to find the least recently used items)
+static sqlite3_int64 GetHashCacheTime()
+{
+    FILETIME ft;
+    GetSystemTimeAsFileTime(&ft);
+    return (sqlite3_int64)((((unsigned __int64)ft.dwHighDateTime << 32) | ft.dwLowDateTime) / 10000000);
+}
+
+CSQLiteCacheBase::CSQLiteCacheBase()
+{
+    HANDLES(InitializeCriticalSection(&CS));
+    OpenAttempted = FALSE;
+    Lib = NULL;
+    Db = NULL;
+    Select = NULL;
+    Touch = NULL;
+    Insert = NULL;
+    Stats = NULL;
+    Trim = NULL;
+    StoresToLimitCheck = 0;
+}
+
+CSQLiteCacheBase::~CSQLiteCacheBase()
+{
+    if (Lib != NULL)
+        TRACE_E("CSQLiteCacheBase::~CSQLiteCacheBase(): Release() was not called!");
+    HANDLES(DeleteCriticalSection(&CS));
+}
+
+BOOL CSQLiteCacheBase::GetPathKey(const char* fileName, char* buf, int bufSize)
+{
+    // paths are compared case-insensitively, the database gets them in upper case
+    WCHAR widePath[MAX_PATH];
+    if (!ConvertA2U(fileName, -1, widePath, _countof(widePath)))
+        return FALSE;
+    CharUpperBuffW(widePath, lstrlenW(widePath));
+    return ConvertU2A(widePath, -1, buf, bufSize, FALSE, CP_UTF8) != 0;
+}
+
+BOOL CSQLiteCacheBase::GetDatabasePath(const char* dbName, char* utf8Path, int bufSize)
+{
+    // the databases live in our folder in the local application data (digests and thumbnails
+    // are valid only on this machine, they must not roam with the profile)
+    char dbPath[MAX_PATH];
+    if (SHGetFolderPath(NULL, CSIDL_LOCAL_APPDATA, NULL, 0 /* SHGFP_TYPE_CURRENT */, dbPath) != S_OK ||
+        !SalPathAppend(dbPath, "Open Salamander", MAX_PATH))
+    {
+        TRACE_E("CSQLiteCacheBase::GetDatabasePath(): cannot get value of CSIDL_LOCAL_APPDATA!");
+        return FALSE;
+    }
+    CreateDirectory(dbPath, NULL); // if it already exists, the error is ignored
+    if (!SalPathAppend(dbPath, dbName, MAX_PATH))
+    {
+        TRACE_E("CSQLiteCacheBase::GetDatabasePath(): too long path to the database!");
+        return FALSE;
+    }
+    // sqlite3_open_v2 requires an UTF8 path, convert it from ANSI
+    WCHAR widePath[MAX_PATH];
+    if (!ConvertA2U(dbPath, -1, widePath, _countof(widePath)) ||
+        !ConvertU2A(widePath, -1, utf8Path, bufSize, FALSE, CP_UTF8))
+    {
+        TRACE_E("CSQLiteCacheBase::GetDatabasePath(): cannot convert path to UTF8: " << dbPath);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void CSQLiteCacheBase::OpenDatabase(const char* dbName, const char* initSql, const char* selectSql,
+                                    const char* touchSql, const char* insertSql, const char* statsSql,
+                                    const char* trimSql)
+{
+    CALL_STACK_MESSAGE2("CSQLiteCacheBase::OpenDatabase(%s, , , , , ,)", dbName);
+    OpenAttempted = TRUE;
+
+    char dbPath[3 * MAX_PATH]; // UTF8
+    if (!GetDatabasePath(dbName, dbPath, _countof(dbPath)))
+        return;
+
+    Lib = new CHashCacheSQLite();
+    if (Lib == NULL || !Lib->OK)
+    {
+        if (Lib == NULL)
+            TRACE_E(LOW_MEMORY);
+        Close();
+        return;
+    }
+
+    // the connection is used from many threads, but always inside the section CS
+    if (Lib->open_v2(dbPath, &Db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX, NULL) != SQLITE_OK)
+    {
+        TRACE_E("CSQLiteCacheBase::OpenDatabase(): cannot open " << dbPath);
+        Close();
+        return;
+    }
+    Lib->busy_timeout(Db, 2000); // the database can be shared by several running Salamanders
+
+    // WAL + synchronous=NORMAL: storing an item does not wait for flushing to disk (losing the last
+    // items on a crash only means computing them again)
+    if (Lib->exec(Db, "PRAGMA journal_mode=WAL;PRAGMA synchronous=NORMAL;", NULL, NULL, NULL) != SQLITE_OK ||
+        Lib->exec(Db, initSql, NULL, NULL, NULL) != SQLITE_OK ||
+        Lib->prepare_v2(Db, selectSql, -1, &Select, NULL) != SQLITE_OK ||
+        Lib->prepare_v2(Db, touchSql, -1, &Touch, NULL) != SQLITE_OK ||
+        Lib->prepare_v2(Db, insertSql, -1, &Insert, NULL) != SQLITE_OK ||
+        Lib->prepare_v2(Db, statsSql, -1, &Stats, NULL) != SQLITE_OK ||
+        Lib->prepare_v2(Db, trimSql, -1, &Trim, NULL) != SQLITE_OK)
+    {
+        TRACE_E("CSQLiteCacheBase::OpenDatabase(): cannot initialize " << dbPath);
+        Close();
+        return;
+    }
+    StoresToLimitCheck = 0; // check the limit right on the first store (it could have been lowered)
+}
+
+void CSQLiteCacheBase::Close()
+{
+    if (Lib != NULL)
+    {
+        sqlite3_stmt** stmts[] = {&Select, &Touch, &Insert, &Stats, &Trim};
+        int i;
+        for (i = 0; i < _countof(stmts); i++)
+        {
+            if (*stmts[i] != NULL)
+            {
+                Lib->finalize(*stmts[i]);
+                *stmts[i] = NULL;
+            }
+        }
+        if (Db != NULL)
+        {
+            Lib->close(Db); // also closes the database if opening it failed
+            Db = NULL;
+        }
+        delete Lib;
+        Lib = NULL;
+    }
+}
+
+void CSQLiteCacheBase::Release()
+{
+    HANDLES(EnterCriticalSection(&CS));
+    Close();
+    OpenAttempted = TRUE; // do not open the database again
+    HANDLES(LeaveCriticalSection(&CS));
+}
+
+BOOL CSQLiteCacheBase::IsLimitCheckDue(int period)
+{
+    if (--StoresToLimitCheck > 0)
+        return FALSE;
+    StoresToLimitCheck = period;
+    return TRUE;
+}
+
+BOOL CSQLiteCacheBase::DropOldest(__int64 drop)
+{
+    BOOL ret = Lib->bind_int64(Trim, 1, drop) == SQLITE_OK && Lib->step(Trim) == SQLITE_DONE;
+    Lib->reset(Trim);
+    return ret;
+}
+
+//
+// *****************************************************************************
+// CFileHashCache
+//
+
+BOOL CFileHashCache::GetKey(HANDLE file, CSalamanderFileDigestKey* key)
+{
+    BY_HANDLE_FILE_INFORMATION fi;
+    if (!GetFileInformationByHandle(file, &fi))
+    {
+        DWORD err = GetLastError();
+        TRACE_I("CFileHashCache::GetKey(): GetFileInformationByHandle() failed: " << GetErrorText(err));
+        return FALSE;
+    }
+    key->Size.Set(fi.nFileSizeLow, fi.nFileSizeHigh);
+    key->LastWrite = fi.ftLastWriteTime;
+    key->VolumeSerialNumber = fi.dwVolumeSerialNumber;
+    key->FileIndexHigh = fi.nFileIndexHigh;
+    key->FileIndexLow = fi.nFileIndexLow;
+    return TRUE;
+}
+
+void CFileHashCache::Open()
+{
+    OpenDatabase("hashcache.db",
+                 "CREATE TABLE IF NOT EXISTS digests ("
+                 "path TEXT NOT NULL, algorithm TEXT NOT NULL, size INTEGER NOT NULL, "
+                 "lastwrite INTEGER NOT NULL, volume INTEGER NOT NULL, fileindex INTEGER NOT NULL, "
+                 "digest BLOB NOT NULL, used INTEGER NOT NULL, PRIMARY KEY (path, algorithm));"
+                 "CREATE INDEX IF NOT EXISTS digests_used ON digests (used);",
+                 "SELECT size, lastwrite, volume, fileindex, digest, used FROM digests "
+                 "WHERE path = ?1 AND algorithm = ?2;",
+                 "UPDATE digests SET used = ?3 WHERE path = ?1 AND algorithm = ?2;",
+                 "INSERT OR REPLACE INTO digests "
+                 "(path, algorithm, size, lastwrite, volume, fileindex, digest, used) "
+                 "VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8);",
+                 "SELECT COUNT(*) FROM digests;",
+                 "DELETE FROM digests WHERE rowid IN "
+                 "(SELECT rowid FROM digests ORDER BY used LIMIT ?1);");
+}
+
+BOOL CFileHashCache::BindPathAndAlgorithm(sqlite3_stmt* stmt, const char* path, const char* algorithm)
+{
+    return Lib->bind_text(stmt, 1, path, -1, SQLITE_STATIC) == SQLITE_OK &&
+           Lib->bind_text(stmt, 2, algorithm, -1, SQLITE_STATIC) == SQLITE_OK;
+}
+
+BOOL CFileHashCache::Lookup(const char* fileName, const CSalamanderFileDigestKey* key, const char* algorithm,
+                            BYTE* digest, int digestSize, int* digestLen)
+{
+    CALL_STACK_MESSAGE3("CFileHashCache::Lookup(%s, , %s, , ,)", fileName, algorithm);
+    *digestLen = 0;
+    if (Configuration.HashCacheMaxItems == 0)
+        return FALSE; // the cache is disabled
+
+    char path[3 * MAX_PATH];
+    if (!GetPathKey(fileName, path, _countof(path)))
+        return FALSE;
+
+    BOOL ret = FALSE;
+    HANDLES(EnterCriticalSection(&CS));
+    if (!OpenAttempted)
+        Open();
+    if (Db != NULL && BindPathAndAlgorithm(Select, path, algorithm) &&
+        Lib->step(Select) == SQLITE_ROW)
+    {
+        sqlite3_int64 lastWrite = ((sqlite3_int64)key->LastWrite.dwHighDateTime << 32) | key->LastWrite.dwLowDateTime;
+        sqlite3_int64 fileIndex = ((sqlite3_int64)key->FileIndexHigh << 32) | key->FileIndexLow;
+        int len = Lib->column_bytes(Select, 4);
+        if ((unsigned __int64)Lib->column_int64(Select, 0) == key->Size.Value &&
+            Lib->column_int64(Select, 1) == lastWrite &&
+            Lib->column_int64(Select, 2) == (sqlite3_int64)key->VolumeSerialNumber &&
+            Lib->column_int64(Select, 3) == fileIndex &&
+            len > 0 && len <= digestSize)
+        {
+            memcpy(digest, Lib->column_blob(Select, 4), len);
+            *digestLen = len;
+            ret = TRUE;
+
+            sqlite3_int64 now = GetHashCacheTime();
+            if (now - Lib->column_int64(Select, 5) >= HASHCACHE_TOUCH_PERIOD)
+            {
+                Lib->reset(Select); // release the read lock before writing
+                if (BindPathAndAlgorithm(Touch, path, algorithm) &&
+                    Lib->bind_int64(Touch, 3, now) == SQLITE_OK)
+                {
+                    Lib->step(Touch);
+                }
+                Lib->reset(Touch);
+            }
+        }
+        // otherwise the file was changed; the caller computes the digest again and replaces it by Store()
+    }
+    if (Db != NULL)
+        Lib->reset(Select);
+    HANDLES(LeaveCriticalSection(&CS));
+    return ret;
+}
+
+void CFileHashCache::Store(const char* fileName, const CSalamanderFileDigestKey* key, const char* algorithm,
+                           const BYTE* digest, int digestLen)
+{
+    CALL_STACK_MESSAGE4("CFileHashCache::Store(%s, , %s, , %d)", fileName, algorithm, digestLen);
+    if (Configuration.HashCacheMaxItems == 0 || digestLen <= 0)
+        return; // the cache is disabled
+
+    char path[3 * MAX_PATH];
+    if (!GetPathKey(fileName, path, _countof(path)))
+        return;
+
+    HANDLES(EnterCriticalSection(&CS));
+    if (!OpenAttempted)
+        Open();
+    if (Db != NULL)
+    {
+        if (!BindPathAndAlgorithm(Insert, path, algorithm) ||
+            Lib->bind_int64(Insert, 3, (sqlite3_int64)key->Size.Value) != SQLITE_OK ||
+            Lib->bind_int64(Insert, 4, ((sqlite3_int64)key->LastWrite.dwHighDateTime << 32) | key->LastWrite.dwLowDateTime) != SQLITE_OK ||
+            Lib->bind_int64(Insert, 5, (sqlite3_int64)key->VolumeSerialNumber) != SQLITE_OK ||
+            Lib->bind_int64(Insert, 6, ((sqlite3_int64)key->FileIndexHigh << 32) | key->FileIndexLow) != SQLITE_OK ||
+            Lib->bind_blob(Insert, 7, digest, digestLen, SQLITE_STATIC) != SQLITE_OK ||
+            Lib->bind_int64(Insert, 8, GetHashCacheTime()) != SQLITE_OK ||
+            Lib->step(Insert) != SQLITE_DONE)
+        {
+            TRACE_E("CFileHashCache::Store(): cannot store digest of " << fileName);
+        }
+        Lib->reset(Insert);
+
+        if (IsLimitCheckDue(HASHCACHE_LIMIT_CHECK_PERIOD))
+            CheckLimit();
+    }
+    HANDLES(LeaveCriticalSection(&CS));
+}
+
+void CFileHashCache::CheckLimit()
+{
+    sqlite3_int64 count = 0;
+    if (Lib->step(Stats) == SQLITE_ROW)
+        count = Lib->column_int64(Stats, 0);
+    Lib->reset(Stats);
+
+    sqlite3_int64 maxItems = (sqlite3_int64)(DWORD)Configuration.HashCacheMaxItems;
+    if (count > maxItems)
+    {
+        // drop the least recently used digests so that the limit is not reached again right
+        // after the next few stored digests
+        sqlite3_int64 drop = count - maxItems + maxItems / 10;
+        if (drop > count)
+            drop = count;
+        if (!DropOldest(drop))
+            TRACE_E("CFileHashCache::CheckLimit(): cannot drop old digests");
+    }
+}
+
+//
+// *****************************************************************************
+// CThumbnailDiskCache
+//
+
+void CThumbnailDiskCache::Open()
+{
+    OpenDatabase("thumbcache.db",
+                 "CREATE TABLE IF NOT EXISTS thumbnails ("
+                 "path TEXT NOT NULL, thumbsize INTEGER NOT NULL, size INTEGER NOT NULL, "
+                 "lastwrite INTEGER NOT NULL, width INTEGER NOT NULL, height INTEGER NOT NULL, "
+                 "bits BLOB NOT NULL, used INTEGER NOT NULL, PRIMARY KEY (path, thumbsize));"
+                 "CREATE INDEX IF NOT EXISTS thumbnails_used ON thumbnails (used);",
+                 "SELECT size, lastwrite, width, height, bits, used FROM thumbnails "
+                 "WHERE path = ?1 AND thumbsize = ?2;",
+                 "UPDATE thumbnails SET used = ?3 WHERE path = ?1 AND thumbsize = ?2;",
+                 "INSERT OR REPLACE INTO thumbnails "
+                 "(path, thumbsize, size, lastwrite, width, height, bits, used) "
+                 "VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8);",
+                 "SELECT COUNT(*), TOTAL(LENGTH(bits)) FROM thumbnails;",
+                 "DELETE FROM thumbnails WHERE rowid IN "
+                 "(SELECT rowid FROM thumbnails ORDER BY used LIMIT ?1);");
+}
+
+BOOL CThumbnailDiskCache::BindPathAndSize(sqlite3_stmt* stmt, const char* path, int thumbnailSize)
+{
+    return Lib->bind_text(stmt, 1, path, -1, SQLITE_STATIC) == SQLITE_OK &&
+           Lib->bind_int64(stmt, 2, thumbnailSize) == SQLITE_OK;
+}
+
+BOOL CThumbnailDiskCache::Lookup(const char* fileName, const CQuadWord& fileSize, const FILETIME& lastWrite,
+                                 int thumbnailSize, DWORD* bits, int maxPixels, int* width, int* height)
+{
+    CALL_STACK_MESSAGE3("CThumbnailDiskCache::Lookup(%s, , , %d, , , ,)", fileName, thumbnailSize);
+    *width = 0;
+    *height = 0;
+    if (Configuration.ThumbnailCacheMaxSize == 0)
+        return FALSE; // the cache is disabled
+
+    char path[3 * MAX_PATH];
+    if (!GetPathKey(fileName, path, _countof(path)))
+        return FALSE;
+
+    BOOL ret = FALSE;
+    HANDLES(EnterCriticalSection(&CS));
+    if (!OpenAttempted)
+        Open();
+    if (Db != NULL && BindPathAndSize(Select, path, thumbnailSize) &&
+        Lib->step(Select) == SQLITE_ROW)
+    {
+        sqlite3_int64 w = Lib->column_int64(Select, 2);
+        sqlite3_int64 h = Lib->column_int64(Select, 3);
+        int len = Lib->column_bytes(Select, 4);
+        if ((unsigned __int64)Lib->column_int64(Select, 0) == fileSize.Value &&
+            Lib->column_int64(Select, 1) == (((sqlite3_int64)lastWrite.dwHighDateTime << 32) | lastWrite.dwLowDateTime) &&
+            w > 0 && h > 0 && w * h <= maxPixels && len == w * h * 3)
+        {
+            // 24-bit RGB -> 32-bit RGB
+            const BYTE* src = (const BYTE*)Lib->column_blob(Select, 4);
+            DWORD* dst = bits;
+            DWORD* end = bits + (int)(w * h);
+            while (dst < end)
+            {
+                *dst++ = src[0] | (src[1] << 8) | (src[2] << 16);
+                src += 3;
+            }
+            *width = (int)w;
+            *height = (int)h;
+            ret = TRUE;
+
+            sqlite3_int64 now = GetHashCacheTime();
+            if (now - Lib->column_int64(Select, 5) >= HASHCACHE_TOUCH_PERIOD)
+            {
+                Lib->reset(Select); // release the read lock before writing
+                if (BindPathAndSize(Touch, path, thumbnailSize) &&
+                    Lib->bind_int64(Touch, 3, now) == SQLITE_OK)
+                {
+                    Lib->step(Touch);
+                }
+                Lib->reset(Touch);
+            }
+        }
+        // otherwise the file was changed; the thumbnail is made again and replaced by Store()
+    }
+    if (Db != NULL)
+        Lib->reset(Select);
+    HANDLES(LeaveCriticalSection(&CS));
+    return ret;
+}
+
+void CThumbnailDiskCache::Store(const char* fileName, const CQuadWord& fileSize, const FILETIME& lastWrite,
+                                int thumbnailSize, const DWORD* bits, int width, int height)
+{
+    CALL_STACK_MESSAGE5("CThumbnailDiskCache::Store(%s, , , %d, , %d, %d)", fileName, thumbnailSize, width, height);
+    if (Configuration.ThumbnailCacheMaxSize == 0 || width <= 0 || height <= 0)
+        return; // the cache is disabled
+
+    char path[3 * MAX_PATH];
+    if (!GetPathKey(fileName, path, _countof(path)))
+        return;
+
+    // 32-bit RGB -> 24-bit RGB (the upper byte is not used by thumbnails)
+    int len = width * height * 3;
+    BYTE* data = (BYTE*)malloc(len);
+    if (data == NULL)
+    {
+        TRACE_E(LOW_MEMORY);
+        return;
+    }
+    BYTE* dst = data;
+    const DWORD* src = bits;
+    const DWORD* end = bits + width * height;
+    while (src < end)
+    {
+        DWORD pixel = *src++;
+        dst[0] = (BYTE)pixel;
+        dst[1] = (BYTE)(pixel >> 8);
+        dst[2] = (BYTE)(pixel >> 16);
+        dst += 3;
+    }
+
+    HANDLES(EnterCriticalSection(&CS));
+    if (!OpenAttempted)
+        Open();
+    if (Db != NULL)
+    {
+        if (!BindPathAndSize(Insert, path, thumbnailSize) ||
+            Lib->bind_int64(Insert, 3, (sqlite3_int64)fileSize.Value) != SQLITE_OK ||
+            Lib->bind_int64(Insert, 4, ((sqlite3_int64)lastWrite.dwHighDateTime << 32) | lastWrite.dwLowDateTime) != SQLITE_OK ||
+            Lib->bind_int64(Insert, 5, width) != SQLITE_OK ||
+            Lib->bind_int64(Insert, 6, height) != SQLITE_OK ||
+            Lib->bind_blob(Insert, 7, data, len, SQLITE_STATIC) != SQLITE_OK ||
+            Lib->bind_int64(Insert, 8, GetHashCacheTime()) != SQLITE_OK ||
+            Lib->step(Insert) != SQLITE_DONE)
+        {
+            TRACE_E("CThumbnailDiskCache::Store(): cannot store thumbnail of " << fileName);
+        }
+        Lib->reset(Insert);
+
+        if (IsLimitCheckDue(THUMBCACHE_LIMIT_CHECK_PERIOD))
+            CheckLimit();
+    }
+    HANDLES(LeaveCriticalSection(&CS));
+    free(data);
+}
+
+void CThumbnailDiskCache::CheckLimit()
+{
+    sqlite3_int64 count = 0;
+    sqlite3_int64 total = 0;
+    if (Lib->step(Stats) == SQLITE_ROW)
+    {
+        count = Lib->column_int64(Stats, 0);
+        total = Lib->column_int64(Stats, 1);
+    }
+    Lib->reset(Stats);
+
+    sqlite3_int64 maxSize = (sqlite3_int64)(DWORD)Configuration.ThumbnailCacheMaxSize * 1024 * 1024;
+    if (total > maxSize && count > 0)
+    {
+        // drop the least recently used thumbnails so that only 90% of the limit is used (thumbnails
+        // have similar sizes, the number of dropped thumbnails is estimated from the average size)
+        sqlite3_int64 drop = (count * (total - maxSize + maxSize / 10) + total - 1) / total;
+        if (drop > count)
+            drop = count;
+        if (!DropOldest(drop))
+            TRACE_E("CThumbnailDiskCache::CheckLimit(): cannot drop old thumbnails");
+    }
+}
@@ -0,0 +1,153 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+struct sqlite3;
+struct sqlite3_stmt;
+struct CHashCacheSQLite;
+
+//
+// ****************************************************************************
+// CSQLiteCacheBase
+//
+// Common part of the persistent caches stored in SQLite databases (sqlite.dll is loaded on
+// first use) in our folder in the local application data: opening and closing the database,
+// the prepared statements and the section CS guarding them. The descendants add the table,
+// lookups and stores of their items; the least recently used items are dropped first when
+// the cache exceeds its limit (see DropOldest()).
+
+class CSQLiteCacheBase
+{
+protected:
+    CRITICAL_SECTION CS;    // guards access to all following members (also of the descendants)
+    BOOL OpenAttempted;     // TRUE = Open() was already called (it is not repeated after a failure)
+    CHashCacheSQLite* Lib;  // functions of sqlite.dll; NULL = not loaded
+    sqlite3* Db;            // opened database; NULL = the cache is not available
+    sqlite3_stmt* Select;   // prepared statements (see OpenDatabase())
+    sqlite3_stmt* Touch;    //
+    sqlite3_stmt* Insert;   //
+    sqlite3_stmt* Stats;    //
+    sqlite3_stmt* Trim;     //
+    int StoresToLimitCheck; // number of stores left until the limit is checked
+
+public:
+    CSQLiteCacheBase();
+    ~CSQLiteCacheBase();
+
+    // closes the database and unloads sqlite.dll; the cache is not available afterwards
+    void Release();
+
+    // converts 'fileName' to the key used in the database (upper-case UTF-8) in 'buf' of size
+    // 'bufSize'; returns FALSE if the name cannot be converted
+    static BOOL GetPathKey(const char* fileName, char* buf, int bufSize);
+
+    // returns in 'utf8Path' (buffer of 'bufSize' chars) the UTF-8 name of database 'dbName'
+    // in our folder in the local application data (the folder is created if needed)
+    static BOOL GetDatabasePath(const char* dbName, char* utf8Path, int bufSize);
+
+protected:
+    // loads sqlite.dll, opens (creates) database 'dbName', runs 'initSql' (creates the table)
+    // and prepares the statements Select, Touch, Insert, Stats and Trim from the given SQL;
+    // Trim must delete the number of least recently used items given as parameter 1;
+    // on failure the cache stays unavailable; called from the section CS
+    void OpenDatabase(const char* dbName, const char* initSql, const char* selectSql,
+                      const char* touchSql, const char* insertSql, const char* statsSql,
+                      const char* trimSql);
+
+    // closes the database (if opened) and unloads sqlite.dll; called from the section CS
+    void Close();
+
+    // returns TRUE if it is time to check the limit after a store ('period' = number of stores
+    // between the checks); called from the section CS
+    BOOL IsLimitCheckDue(int period);
+
+    // drops 'drop' least recently used items by statement Trim; returns FALSE on error;
+    // called from the section CS
+    BOOL DropOldest(__int64 drop);
+};
+
+//
+// ****************************************************************************
+// CFileHashCache
+//
+// Persistent cache of file digests (MD5 digests computed when searching for duplicate files,
+// digests computed by plugins via CSalamanderGeneralAbstract::GetCachedFileDigest() and
+// StoreFileDigest()). Digests are stored in database "hashcache.db" (see CSQLiteCacheBase).
+// A stored digest is used only while the file keeps its size, last write time and file ID,
+// otherwise it is recomputed by the caller and replaced. The number of stored digests is
+// limited by Configuration.HashCacheMaxItems (0 = the cache is disabled), the least recently
+// used digests are dropped first. All methods can be called from any thread.
+
+class CFileHashCache : public CSQLiteCacheBase
+{
+public:
+    // fills 'key' with the content identification of file opened as 'file'; returns FALSE on error
+    static BOOL GetKey(HANDLE file, CSalamanderFileDigestKey* key);
+
+    // looks up the digest of file 'fileName' (full name) with identification 'key' computed by
+    // 'algorithm' (e.g. "MD5"); on success returns TRUE, the digest in 'digest' (buffer of
+    // 'digestSize' bytes) and its length in 'digestLen'
+    BOOL Lookup(const char* fileName, const CSalamanderFileDigestKey* key, const char* algorithm,
+                BYTE* digest, int digestSize, int* digestLen);
+
+    // stores digest 'digest' ('digestLen' bytes) of file 'fileName' (full name) with identification
+    // 'key' computed by 'algorithm'; errors are only traced
+    void Store(const char* fileName, const CSalamanderFileDigestKey* key, const char* algorithm,
+               const BYTE* digest, int digestLen);
+
+protected:
+    // opens the database with the table of digests; called from the section CS
+    void Open();
+
+    // binds the path and algorithm (parameters 1 and 2) to 'stmt'; called from the section CS
+    BOOL BindPathAndAlgorithm(sqlite3_stmt* stmt, const char* path, const char* algorithm);
+
+    // drops the least recently used digests if there are more than Configuration.HashCacheMaxItems;
+    // called from the section CS
+    void CheckLimit();
+};
+
+extern CFileHashCache FileHashCache;
+
+//
+// ****************************************************************************
+// CThumbnailDiskCache
+//
+// Persistent cache of thumbnails made by plugin thumbnail loaders, so that whole images are not
+// decoded again when a directory is revisited (after a restart, after the icon cache is flushed).
+// Thumbnails are stored in database "thumbcache.db" (see CSQLiteCacheBase), keyed by the full
+// file name and the thumbnail size; a stored thumbnail is used only while the file keeps its
+// size and last write time. Pixels are stored as 24-bit RGB. Total size of stored thumbnails is
+// limited by Configuration.ThumbnailCacheMaxSize (0 = the cache is disabled), the least recently
+// used thumbnails are dropped first. All methods can be called from any thread.
+
+class CThumbnailDiskCache : public CSQLiteCacheBase
+{
+public:
+    // looks up the thumbnail of file 'fileName' (full name) of size 'fileSize' with last write
+    // time 'lastWrite' made for thumbnail size 'thumbnailSize'; on success returns TRUE, pixels
+    // (32-bit RGB, top-down) in 'bits' (buffer for 'maxPixels' pixels) and the dimensions
+    // in 'width' and 'height'
+    BOOL Lookup(const char* fileName, const CQuadWord& fileSize, const FILETIME& lastWrite,
+                int thumbnailSize, DWORD* bits, int maxPixels, int* width, int* height);
+
+    // stores the thumbnail 'bits' ('width' x 'height' pixels, 32-bit RGB, top-down) of file
+    // 'fileName' (full name) of size 'fileSize' with last write time 'lastWrite' made for
+    // thumbnail size 'thumbnailSize'; errors are only traced
+    void Store(const char* fileName, const CQuadWord& fileSize, const FILETIME& lastWrite,
+               int thumbnailSize, const DWORD* bits, int width, int height);
+
+protected:
+    // opens the database with the table of thumbnails; called from the section CS
+    void Open();
+
+    // binds the path and thumbnail size (parameters 1 and 2) to 'stmt'; called from the section CS
+    BOOL BindPathAndSize(sqlite3_stmt* stmt, const char* path, int thumbnailSize);
+
+    // drops the least recently used thumbnails if their total size exceeds
+    // Configuration.ThumbnailCacheMaxSize; called from the section CS
+    void CheckLimit();
+};
+
+extern CThumbnailDiskCache ThumbnailDiskCache;
@@ -417,6 +417,7 @@ const char* CONFIG_SAVECMDLINEHISTORY_REG = "Save CmdLine History";
 const char* CONFIG_USESALOPEN_REG = "Use salopen.exe";
 const char* CONFIG_NETWAREFASTDIRMOVE_REG = "Netware Fast Dir Move";
 const char* CONFIG_ASYNCCOPYALG_REG = "Async Copy Alg On Network";
+const char* CONFIG_PARALLELCOPY_REG = "Parallel Copy Of Small Files";
 const char* CONFIG_RELOAD_ENV_VARS_REG = "Reload Environment Variables";
 const char* CONFIG_QUICKRENAME_SELALL_REG = "Quick Rename Select All";
 const char* CONFIG_EDITNEW_SELALL_REG = "Edit New File Select All";
@@ -449,6 +450,8 @@ const char* CONFIG_IFPATHISINACCESSIBLEGOTOISMYDOCS_REG = "If Path Is Inaccessib
 const char* CONFIG_IFPATHISINACCESSIBLEGOTO_REG = "If Path Is Inaccessible Go To";
 const char* CONFIG_HOTPATH_AUTOCONFIG = "Auto Configurate Hot Paths";
 const char* CONFIG_LASTUSEDSPEEDLIM_REG = "Speed Limit";
+const char* CONFIG_HASHCACHEMAXITEMS_REG = "Digest Cache Max Items";
+const char* CONFIG_THUMBCACHEMAXSIZE_REG = "Thumbnail Cache Max Size";
 const char* CONFIG_QUICKSEARCHENTER_REG = "Quick Search Enter Alt";
 const char* CONFIG_CHD_SHOWMYDOC = "Change Drive Show My Documents";
 const char* CONFIG_CHD_SHOWANOTHER = "Change Drive Show Another";
@@ -602,6 +605,7 @@ const char* VIEWER_CPAUTOSELECT_REG = "Auto-Select";
 const char* VIEWER_DEFAULTCONVERT_REG = "Default Convert";
 const char* VIEWER_AUTOCOPYSELECTION_REG = "Auto-Copy Selection";
 const char* VIEWER_GOTOOFFSETISHEX_REG = "Go to Offset Is Hex";
+const char* VIEWER_GOTOOFFSETISLINE_REG = "Go to Offset Is Line";
 
 const char* VIEWER_CONFIGSAVEWINPOS_REG = "Save Window Position";
 const char* VIEWER_CONFIGWNDLEFT_REG = "Left";
@@ -1799,6 +1803,10 @@ void CMainWindow::SaveConfig(HWND parent)
                          &Configuration.HotPathAutoConfig, sizeof(DWORD));
                 SetValue(actKey, CONFIG_LASTUSEDSPEEDLIM_REG, REG_DWORD,
                          &Configuration.LastUsedSpeedLimit, sizeof(DWORD));
+                SetValue(actKey, CONFIG_HASHCACHEMAXITEMS_REG, REG_DWORD,
+                         &Configuration.HashCacheMaxItems, sizeof(DWORD));
+                SetValue(actKey, CONFIG_THUMBCACHEMAXSIZE_REG, REG_DWORD,
+                         &Configuration.ThumbnailCacheMaxSize, sizeof(DWORD));
                 SetValue(actKey, CONFIG_QUICKSEARCHENTER_REG, REG_DWORD,
                          &Configuration.QuickSearchEnterAlt, sizeof(DWORD));
                 SetValue(actKey, CONFIG_CHD_SHOWMYDOC, REG_DWORD,
@@ -1822,6 +1830,8 @@ void CMainWindow::SaveConfig(HWND parent)
                 if (Windows7AndLater)
                     SetValue(actKey, CONFIG_ASYNCCOPYALG_REG, REG_DWORD,
                              &Configuration.UseAsyncCopyAlg, sizeof(DWORD));
+                SetValue(actKey, CONFIG_PARALLELCOPY_REG, REG_DWORD,
+                         &Configuration.UseParallelCopy, sizeof(DWORD));
                 SetValue(actKey, CONFIG_RELOAD_ENV_VARS_REG, REG_DWORD,
                          &Configuration.ReloadEnvVariables, sizeof(DWORD));
                 SetValue(actKey, CONFIG_QUICKRENAME_SELALL_REG, REG_DWORD,
@@ -2165,6 +2175,8 @@ void CMainWindow::SaveConfig(HWND parent)
                          &Configuration.AutoCopySelection, sizeof(DWORD));
                 SetValue(actKey, VIEWER_GOTOOFFSETISHEX_REG, REG_DWORD,
                          &Configuration.GoToOffsetIsHex, sizeof(DWORD));
+                SetValue(actKey, VIEWER_GOTOOFFSETISLINE_REG, REG_DWORD,
+                         &Configuration.GoToOffsetIsLine, sizeof(DWORD));
 
                 SetValue(actKey, VIEWER_CONFIGSAVEWINPOS_REG, REG_DWORD,
                          &Configuration.SavePosition, sizeof(DWORD));
@@ -3313,6 +3325,10 @@ BOOL CMainWindow::LoadConfig(BOOL importingOldConfig, const CCommandLineParams*
                      &Configuration.HotPathAutoConfig, sizeof(DWORD));
             GetValue(actKey, CONFIG_LASTUSEDSPEEDLIM_REG, REG_DWORD,
                      &Configuration.LastUsedSpeedLimit, sizeof(DWORD));
+            GetValue(actKey, CONFIG_HASHCACHEMAXITEMS_REG, REG_DWORD,
+                     &Configuration.HashCacheMaxItems, sizeof(DWORD));
+            GetValue(actKey, CONFIG_THUMBCACHEMAXSIZE_REG, REG_DWORD,
+                     &Configuration.ThumbnailCacheMaxSize, sizeof(DWORD));
             GetValue(actKey, CONFIG_QUICKSEARCHENTER_REG, REG_DWORD,
                      &Configuration.QuickSearchEnterAlt, sizeof(DWORD));
             GetValue(actKey, CONFIG_CHD_SHOWMYDOC, REG_DWORD,
@@ -3350,6 +3366,8 @@ BOOL CMainWindow::LoadConfig(BOOL importingOldConfig, const CCommandLineParams*
             if (Windows7AndLater)
                 GetValue(actKey, CONFIG_ASYNCCOPYALG_REG, REG_DWORD,
                          &Configuration.UseAsyncCopyAlg, sizeof(DWORD));
+            GetValue(actKey, CONFIG_PARALLELCOPY_REG, REG_DWORD,
+                     &Configuration.UseParallelCopy, sizeof(DWORD));
             GetValue(actKey, CONFIG_RELOAD_ENV_VARS_REG, REG_DWORD,
                      &Configuration.ReloadEnvVariables, sizeof(DWORD));
             GetValue(actKey, CONFIG_SHIFTFORHOTPATHS_REG, REG_DWORD,
@@ -3787,6 +3805,8 @@ BOOL CMainWindow::LoadConfig(BOOL importingOldConfig, const CCommandLineParams*
                      &Configuration.AutoCopySelection, sizeof(DWORD));
             GetValue(actKey, VIEWER_GOTOOFFSETISHEX_REG, REG_DWORD,
                      &Configuration.GoToOffsetIsHex, sizeof(DWORD));
+            GetValue(actKey, VIEWER_GOTOOFFSETISLINE_REG, REG_DWORD,
+                     &Configuration.GoToOffsetIsLine, sizeof(DWORD));
 
             GetValue(actKey, VIEWER_CONFIGSAVEWINPOS_REG, REG_DWORD,
                      &Configuration.SavePosition, sizeof(DWORD));
@@ -618,6 +618,7 @@ BOOL ReadDirsAndFilesAux(HWND hWindow, DWORD flags, CCmpDirProgressDialog* progr
                 file.CutToClip = 0;
                 file.IconOverlayIndex = ICONOVERLAYINDEX_NOTUSED;
                 file.IconOverlayDone = 0;
+                file.NameInArena = 0;
                 file.Hidden = 0;
                 file.IsLink = 0;
                 file.IsOffline = 0;
@@ -2331,6 +2331,15 @@ public:
     virtual BOOL WINAPI IsCriticalShutdown();
 
     virtual void WINAPI CloseAllOwnedEnabledDialogs(HWND parent, DWORD tid = 0);
+
+    virtual BOOL WINAPI GetFileDigestKey(HANDLE file, CSalamanderFileDigestKey* key);
+
+    virtual BOOL WINAPI GetCachedFileDigest(const char* fileName, const CSalamanderFileDigestKey* key,
+                                            const char* algorithm, BYTE* digest, int digestSize,
+                                            int* digestLen);
+
+    virtual void WINAPI StoreFileDigest(const char* fileName, const CSalamanderFileDigestKey* key,
+                                        const char* algorithm, const BYTE* digest, int digestLen);
 };
 
 //
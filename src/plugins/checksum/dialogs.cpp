@@ -7,13 +7,12 @@
 #include "checksum.rh2"
 #include "lang\lang.rh"
 #include "dialogs.h"
+#include "hashpipe.h"
 #include "misc.h"
 
 CWindowQueue ModelessQueue("CheckSum Modeless Windows");  // list of all modeless windows
 CThreadQueue ThreadQueue("CheckSum Dialogs and Workers"); // list of all dialog and worker threads
 
-#define BUFSIZE (4 * 65536) // buffer size for reading
-
 #define GET_X_LPARAM(lp) ((int)(short)LOWORD(lp))
 #define GET_Y_LPARAM(lp) ((int)(short)HIWORD(lp))
 
@@ -648,6 +647,88 @@ protected:
     CCalculateDialog* dialog;
 };
 
+// formats digest 'digest' ('len' bytes) as a hexadecimal string into 'text' (2 * len + 1 chars)
+static void DigestToText(const char* digest, int len, char* text)
+{
+    text[0] = 0;
+    int k;
+    for (k = 0; k < len; k++)
+        sprintf(text + k * 2, "%02X", digest[k]);
+}
+
+class CCalculatePipeline : public CHashPipeline
+{
+public:
+    // 'algorithms' are names of the algorithms in the order of factories passed to Start()
+    // (used as names of the digests in Salamander's digest cache)
+    CCalculatePipeline(CCalculateDialog* dlg, BOOL* terminate, const char** algorithms)
+        : CHashPipeline(dlg, terminate, dlg->FileList.Count)
+    {
+        dialog = dlg;
+        Algorithms = algorithms;
+    }
+
+    // the owner thread: if the digest cache contains all digests of file 'path' with identification
+    // 'key' (the file is on row 'row'), stores them into the list and returns TRUE; 'count' is
+    // the number of computed algorithms
+    BOOL UseCachedDigests(int row, const char* path, const CSalamanderFileDigestKey* key, int count)
+    {
+        char digests[HT_COUNT][DIGEST_MAX_SIZE];
+        int lens[HT_COUNT];
+        int j;
+        for (j = 0; j < count; j++)
+        {
+            if (!SalamanderGeneral->GetCachedFileDigest(path, key, Algorithms[j], (BYTE*)digests[j],
+                                                        DIGEST_MAX_SIZE, &lens[j]))
+            {
+                return FALSE; // the file must be read anyway, compute all digests
+            }
+        }
+        char text[2 * DIGEST_MAX_SIZE + 1];
+        for (j = 0; j < count; j++)
+        {
+            DigestToText(digests[j], lens[j], text);
+            dialog->SetItemTextAndIcon(row, 2 + j, text);
+        }
+        return TRUE;
+    }
+
+protected:
+    virtual void OnFileDone(int row, const CSalamanderFileDigestKey* key, CHashAlgo** hashes,
+                            int count, BOOL hashed)
+    {
+        // store the results in the list
+        if (hashed)
+        {
+            char digest[DIGEST_MAX_SIZE];
+            char text[2 * DIGEST_MAX_SIZE + 1];
+
+            // FileList and SourcePath do not change while the thread runs
+            char path[MAX_PATH];
+            strcpy(path, dialog->SourcePath);
+            BOOL store = key != NULL && SalamanderGeneral->SalPathAppend(path, dialog->FileList[row]->Name, MAX_PATH);
+
+            int j;
+            for (j = 0; j < count; j++)
+            {
+                int len = hashes[j]->GetDigest(digest, SizeOf(digest));
+                DigestToText(digest, len, text);
+                dialog->SetItemTextAndIcon(row, 2 + j, text);
+                if (store)
+                    SalamanderGeneral->StoreFileDigest(path, key, Algorithms[j], (BYTE*)digest, len);
+            }
+        }
+        else
+        {
+            if (*Terminate)
+                dialog->SetItemTextAndIcon(row, 2, LoadStr(IDS_CANCELED));
+        }
+    }
+
+    CCalculateDialog* dialog;
+    const char** Algorithms;
+};
+
 unsigned CCalculateThread::Body()
 {
     CALL_STACK_MESSAGE1("CCalculateThread::Body()");
@@ -656,7 +737,8 @@ unsigned CCalculateThread::Body()
     BOOL skippedReadError = FALSE;
     BOOL skipAllReadErrors = FALSE;
     BOOL skip;
-    CHashAlgo* pCalculators[HT_COUNT];
+    THashFactory factories[HT_COUNT];
+    const char* algorithms[HT_COUNT];
     int nCalculators = 0;
 
     int ii;
@@ -664,11 +746,10 @@ unsigned CCalculateThread::Body()
     {
         if (dialog->HashInfo[ii].bCalculate)
         {
-            pCalculators[nCalculators] = dialog->HashInfo[ii].Factory();
-            if (!pCalculators[nCalculators])
+            // the algorithms are created per file by the pipeline, just verify they can be created
+            CHashAlgo* probe = dialog->HashInfo[ii].Factory();
+            if (!probe)
             {
-                while (nCalculators-- > 0)
-                    delete pCalculators[nCalculators];
                 TRACE_E("Could not initialize " << dialog->HashInfo[ii].sRegID);
                 if (dialog->FileList.Count > 0)
                     dialog->SetItemTextAndIcon(0, 2, LoadStr(IDS_CANCELED));
@@ -676,17 +757,31 @@ unsigned CCalculateThread::Body()
                 PostMessage(dialog->HWindow, WM_USER_ENDWORK, 0, 0);
                 return 0;
             }
-            nCalculators++;
+            delete probe;
+            algorithms[nCalculators] = dialog->HashInfo[ii].sRegID;
+            factories[nCalculators++] = dialog->HashInfo[ii].Factory;
         }
     }
 
+    CCalculatePipeline pipeline(dialog, Terminate, algorithms);
+    if (!pipeline.Start(factories, nCalculators))
+    {
+        pipeline.Finish();
+        if (dialog->FileList.Count > 0)
+            dialog->SetItemTextAndIcon(0, 2, LoadStr(IDS_CANCELED));
+        TRACE_I("End");
+        PostMessage(dialog->HWindow, WM_USER_ENDWORK, 0, 0);
+        return 0;
+    }
+
     // while the worker thread runs, the array is not modified (the number of items + indices do
     // not change = no need to synchronize access to them)
     int silent = 0;
     for (int i = 0; i < dialog->FileList.Count && !*Terminate; i++)
     {
-        // scroll to the current item (only if the previous one is visible, i.e. the user did not jump to the top)
-        dialog->ScrollToItem(i);
+        // scroll to the current item (the pipeline keeps the scroll position on the first
+        // row whose hashes are not stored yet)
+        pipeline.BeginRow(i);
 
         // open the file
         HANDLE hFile;
@@ -697,11 +792,15 @@ unsigned CCalculateThread::Body()
         if (!SalamanderGeneral->SalPathAppend(path, dialog->FileList[i]->Name, MAX_PATH))
         {
             TRACE_E("CCalculateThread::Body(): unexpected situation: SalPathAppend() has failed");
+            pipeline.EndRow();
             break;
         }
         if (!SafeOpenCreateFile(path, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
                                 &hFile, &skip, &silent, dialog->HWindow))
+        {
+            pipeline.EndRow();
             break;
+        }
         if (skip)
         {
             dialog->SetItemTextAndIcon(i, 2, LoadStr(IDS_SKIPPED));
@@ -721,20 +820,37 @@ unsigned CCalculateThread::Body()
                 }
                 dialog->IncreaseProgress(size + CQuadWord(FILE_SIZE_FIX, 0));
             }
+            pipeline.EndRow();
             continue;
         }
 
-        // Now calculates the hashes
-        int j;
-        for (j = 0; j < nCalculators; j++)
-            pCalculators[j]->Init();
+        // digests of files not changed since their last computation are taken from Salamander's digest cache
+        CSalamanderFileDigestKey key;
+        BOOL keyOK = SalamanderGeneral->GetFileDigestKey(hFile, &key);
+        if (keyOK && pipeline.UseCachedDigests(i, path, &key, nCalculators))
+        {
+            CloseHandle(hFile);
+            dialog->IncreaseProgress(key.Size + CQuadWord(FILE_SIZE_FIX, 0));
+            pipeline.EndRow();
+            continue;
+        }
+
+        // Now calculates the hashes (the data are hashed by the pipeline helper threads)
+        if (!pipeline.BeginFile(keyOK ? &key : NULL))
+        {
+            CloseHandle(hFile);
+            *Terminate = TRUE;
+            dialog->SetItemTextAndIcon(i, 2, LoadStr(IDS_CANCELED));
+            pipeline.EndRow();
+            break;
+        }
 
         DWORD nr;
         CQuadWord done(0, 0);
         do
         {
-            char buffer[BUFSIZE];
-            if (!SafeReadFile(hFile, buffer, BUFSIZE, &nr, path, dialog->HWindow, &skippedReadError, &skipAllReadErrors))
+            char* buffer = pipeline.GetBuffer();
+            if (!SafeReadFile(hFile, buffer, HASH_CHUNK_SIZE, &nr, path, dialog->HWindow, &skippedReadError, &skipAllReadErrors))
             {
                 nr = 0; // read error
                 if (skippedReadError)
@@ -764,47 +880,18 @@ unsigned CCalculateThread::Body()
                 else
                     *Terminate = TRUE;
             }
-            if (nr > 0)
-            {
-                for (int j2 = 0; j2 < nCalculators; j2++)
-                    pCalculators[j2]->Update(buffer, nr);
-                dialog->IncreaseProgress(CQuadWord(nr, 0));
-                done += CQuadWord(nr, 0);
-            }
-        } while (nr == BUFSIZE && !*Terminate && !skippedReadError);
+            pipeline.PutBuffer(nr); // progress is advanced once the data are hashed
+            done += CQuadWord(nr, 0);
+        } while (nr == HASH_CHUNK_SIZE && !*Terminate && !skippedReadError);
         if (!*Terminate)
             dialog->IncreaseProgress(CQuadWord(FILE_SIZE_FIX, 0));
         CloseHandle(hFile);
 
-        // store the results in the list
-        if (!*Terminate && !skippedReadError)
-        {
-            for (int k = 0; k < nCalculators; k++)
-                pCalculators[k]->Finalize();
-
-            char digest[DIGEST_MAX_SIZE];
-            char text[2 * DIGEST_MAX_SIZE + 1];
-
-            int j2;
-            for (j2 = 0; j2 < nCalculators; j2++)
-            {
-                int len = pCalculators[j2]->GetDigest(digest, SizeOf(digest));
-                text[0] = 0;
-                int k2;
-                for (k2 = 0; k2 < len; k2++)
-                    sprintf(text + k2 * 2, "%02X", digest[k2]);
-                dialog->SetItemTextAndIcon(i, 2 + j2, text);
-            }
-        }
-        else
-        {
-            if (*Terminate)
-                dialog->SetItemTextAndIcon(i, 2, LoadStr(IDS_CANCELED));
-        }
+        // the results are stored in the list by CCalculatePipeline::OnFileDone()
+        pipeline.EndFile(*Terminate || skippedReadError);
     }
 
-    while (nCalculators > 0)
-        delete pCalculators[--nCalculators];
+    pipeline.Finish();
     TRACE_I("End");
     PostMessage(dialog->HWindow, WM_USER_ENDWORK, 0, 0);
     return 0;
@@ -1700,6 +1787,39 @@ protected:
     CVerifyDialog* dialog;
 };
 
+class CVerifyPipeline : public CHashPipeline
+{
+public:
+    CVerifyPipeline(CVerifyDialog* dlg, BOOL* terminate)
+        : CHashPipeline(dlg, terminate, dlg->fileList.Count) { dialog = dlg; }
+
+protected:
+    virtual void OnFileDone(int row, const CSalamanderFileDigestKey* key, CHashAlgo** hashes,
+                            int count, BOOL hashed)
+    {
+        // store the results into the list
+        if (hashed)
+        {
+            char digest[DIGEST_MAX_SIZE];
+            int len = hashes[0]->GetDigest(digest, SizeOf(digest));
+            BOOL ok = (len > 0) && !memcmp(dialog->fileList[row]->digest, digest, len);
+            if (key != NULL)
+            {
+                SalamanderGeneral->StoreFileDigest(dialog->fileList[row]->fileName, key,
+                                                   dialog->pHashInfo->sRegID, (BYTE*)digest, len);
+            }
+
+            dialog->SetItemTextAndIcon(row, 2, LoadStr(ok ? IDS_OK : IDS_CORRUPT), ok ? 3 : 2);
+            if (!ok)
+                dialog->nCorrupt++; // OnFileDone() calls are serialized + the main thread reads it when the thread is not running -> no sync
+        }
+        else
+            dialog->SetItemTextAndIcon(row, 2, LoadStr(IDS_CANCELED));
+    }
+
+    CVerifyDialog* dialog;
+};
+
 unsigned CVerifyThread::Body()
 {
     CALL_STACK_MESSAGE1("CVerifyThread::Body()");
@@ -1717,8 +1837,22 @@ unsigned CVerifyThread::Body()
         PostMessage(dialog->HWindow, WM_USER_ENDWORK, 0, 0);
         return 0;
     }
+    delete pCalculator; // the algorithm is created per file by the pipeline, it was just verified it can be created
+
+    CVerifyPipeline pipeline(dialog, Terminate);
+    if (!pipeline.Start(&dialog->pHashInfo->Factory, 1))
+    {
+        pipeline.Finish();
+        if (dialog->fileList.Count > 0)
+            dialog->SetItemTextAndIcon(0, 2, LoadStr(IDS_CANCELED));
+        dialog->bCanceled = TRUE;
+        TRACE_I("End");
+        PostMessage(dialog->HWindow, WM_USER_ENDWORK, 0, 0);
+        return 0;
+    }
 
     BOOL skip;
+    int cachedCorrupt = 0; // corrupt files found using the digest cache
 
     // while the worker thread runs, the array is not modified (item count + indices
     // do not change = no need to synchronize access)
@@ -1727,12 +1861,13 @@ unsigned CVerifyThread::Body()
         FILEINFO* info = dialog->fileList[i];
 
         // scroll to the current item
-        dialog->ScrollToItem(i);
+        pipeline.BeginRow(i);
 
         if (!info->bFileExist)
         {
             dialog->SetItemTextAndIcon(i, 0, NULL, 1);
             dialog->nMissing++; // used only from the thread + from the main thread when it is not running -> no sync
+            pipeline.EndRow();
             continue;
         }
 
@@ -1743,6 +1878,7 @@ unsigned CVerifyThread::Body()
         {
             dialog->SetItemTextAndIcon(i, 2, LoadStr(IDS_CANCELED));
             dialog->bCanceled = TRUE;
+            pipeline.EndRow();
             break;
         }
         if (skip)
@@ -1751,49 +1887,59 @@ unsigned CVerifyThread::Body()
             // advance progress by the size of the skipped file
             dialog->IncreaseProgress(info->size + CQuadWord(FILE_SIZE_FIX, 0));
             dialog->nSkipped++; // used only from the thread + from the main thread when it is not running -> no sync
+            pipeline.EndRow();
+            continue;
+        }
+
+        // digests of files not changed since their last computation are taken from Salamander's digest cache
+        CSalamanderFileDigestKey key;
+        BOOL keyOK = SalamanderGeneral->GetFileDigestKey(hFile, &key);
+        char digest[DIGEST_MAX_SIZE];
+        int len;
+        if (keyOK && SalamanderGeneral->GetCachedFileDigest(info->fileName, &key, dialog->pHashInfo->sRegID,
+                                                            (BYTE*)digest, DIGEST_MAX_SIZE, &len))
+        {
+            CloseHandle(hFile);
+            BOOL ok = !memcmp(info->digest, digest, len);
+            dialog->SetItemTextAndIcon(i, 2, LoadStr(ok ? IDS_OK : IDS_CORRUPT), ok ? 3 : 2);
+            if (!ok)
+                cachedCorrupt++; // OnFileDone() may change dialog->nCorrupt now, it is added after Finish()
+            dialog->IncreaseProgress(key.Size + CQuadWord(FILE_SIZE_FIX, 0));
+            pipeline.EndRow();
             continue;
         }
 
-        // compute CRC or MD5
-        pCalculator->Init();
+        // compute CRC or MD5 (the data are hashed by the pipeline helper threads)
+        if (!pipeline.BeginFile(keyOK ? &key : NULL))
+        {
+            CloseHandle(hFile);
+            dialog->SetItemTextAndIcon(i, 2, LoadStr(IDS_CANCELED));
+            dialog->bCanceled = TRUE;
+            *Terminate = TRUE;
+            pipeline.EndRow();
+            break;
+        }
         DWORD nr;
         do
         {
-            char buffer[BUFSIZE];
-            if (!SafeReadFile(hFile, buffer, BUFSIZE, &nr, info->fileName, dialog->HWindow))
+            char* buffer = pipeline.GetBuffer();
+            if (!SafeReadFile(hFile, buffer, HASH_CHUNK_SIZE, &nr, info->fileName, dialog->HWindow))
             {
                 dialog->bCanceled = TRUE;
                 *Terminate = TRUE;
             }
-            if (!*Terminate)
-            {
-                dialog->IncreaseProgress(CQuadWord(nr, 0));
-                pCalculator->Update(buffer, nr);
-            }
-        } while (nr == BUFSIZE && !*Terminate);
+            pipeline.PutBuffer(*Terminate ? 0 : nr); // progress is advanced once the data are hashed
+        } while (nr == HASH_CHUNK_SIZE && !*Terminate);
         if (!*Terminate)
-        {
-            pCalculator->Finalize();
             dialog->IncreaseProgress(CQuadWord(FILE_SIZE_FIX, 0));
-        }
         CloseHandle(hFile);
 
-        // store the results into the list
-        if (!*Terminate)
-        {
-            char digest[DIGEST_MAX_SIZE];
-            int len = pCalculator->GetDigest(digest, SizeOf(digest));
-            BOOL ok = (len > 0) && !memcmp(info->digest, digest, len);
-
-            dialog->SetItemTextAndIcon(i, 2, LoadStr(ok ? IDS_OK : IDS_CORRUPT), ok ? 3 : 2);
-            if (!ok)
-                dialog->nCorrupt++; // used only from the thread + from the main thread when it is not running -> no sync
-        }
-        else
-            dialog->SetItemTextAndIcon(i, 2, LoadStr(IDS_CANCELED));
+        // the result is stored in the list by CVerifyPipeline::OnFileDone()
+        pipeline.EndFile(*Terminate);
     }
 
-    delete pCalculator;
+    pipeline.Finish();
+    dialog->nCorrupt += cachedCorrupt;
     TRACE_I("End");
     PostMessage(dialog->HWindow, WM_USER_ENDWORK, 0, 0);
     return 0;
@@ -99,6 +99,9 @@ protected:
     friend class CCalculateThread;
     friend class CVerifyThread;
     friend class CSFVMD5ListView;
+    friend class CHashPipeline;
+    friend class CCalculatePipeline;
+    friend class CVerifyPipeline;
 };
 
 class CSFVMD5ListView : public CWindow
@@ -161,6 +164,7 @@ protected:
     DWORD RefreshCounter;
 
     friend class CCalculateThread;
+    friend class CCalculatePipeline;
 };
 
 #define DIGEST_MAX_SIZE 64
@@ -197,6 +201,7 @@ protected:
     int nCorrupt, nMissing, nSkipped;
 
     friend class CVerifyThread;
+    friend class CVerifyPipeline;
 };
 
 BOOL OpenCalculateDialog(HWND parent);
@@ -0,0 +1,381 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "precomp.h"
+#include "checksum.h"
+#include "dialogs.h"
+#include "hashpipe.h"
+
+struct CHashChunk
+{
+    CHashChunk* Next; // next chunk of the same file (NULL = not read yet); link in FreeChunks for free buffers
+    char* Data;       // HASH_CHUNK_SIZE bytes
+    DWORD Size;       // number of valid bytes in Data
+    int Refs;         // streams which have not hashed the chunk yet + 1 while it is the last chunk of its file
+};
+
+// one algorithm of one file; its chunks are hashed in order and by one thread at a time
+struct CHashStream
+{
+    CHashAlgo* Algo;
+    CHashFile* File;
+    CHashChunk* Chunk;      // chunk to hash next (NULL = waiting for data)
+    BOOL Busy;              // a helper thread is hashing 'Chunk'
+    CHashStream* ReadyNext; // link in the ready queue
+};
+
+struct CHashFile
+{
+    int Row;
+    CSalamanderFileDigestKey Key; // content identification of the file (valid if KeyValid is TRUE)
+    BOOL KeyValid;
+    CHashStream Streams[HT_COUNT];
+    CHashChunk* Last; // last chunk read (holds an extra reference until the next chunk or EndFile())
+    int Pending;      // chunks not hashed yet, summed over all streams
+    BOOL ReadDone;    // EndFile() was called
+    BOOL Failed;      // the file was not read completely
+};
+
+class CHashWorkerThread : public CThread
+{
+public:
+    CHashWorkerThread(CHashPipeline* pipeline) : CThread("Hash Helper Thread") { Pipeline = pipeline; }
+
+    virtual unsigned Body()
+    {
+        CALL_STACK_MESSAGE1("CHashWorkerThread::Body()");
+        Pipeline->WorkerBody();
+        return 0;
+    }
+
+protected:
+    CHashPipeline* Pipeline;
+};
+
+//****************************************************************************
+//
+// CHashPipeline
+//
+
+CHashPipeline::CHashPipeline(CSFVMD5Dialog* dialog, BOOL* terminate, int rowCount)
+{
+    Dialog = dialog;
+    Terminate = terminate;
+    HANDLES(InitializeCriticalSection(&CS));
+    WorkReady = NULL;
+    BufferFreed = NULL;
+    StopWorkers = FALSE;
+    FactoryCount = 0;
+    Chunks = NULL;
+    FreeChunks = NULL;
+    CurrentChunk = NULL;
+    CurrentFile = NULL;
+    ReadyHead = ReadyTail = NULL;
+    WorkerCount = 0;
+    RowDone = NULL;
+    RowCount = rowCount;
+    FirstPendingRow = 0;
+    ReaderRow = 0;
+}
+
+CHashPipeline::~CHashPipeline()
+{
+    if (WorkerCount > 0)
+        TRACE_E("CHashPipeline::~CHashPipeline(): Finish() was not called!");
+    if (Chunks != NULL)
+    {
+        int i;
+        for (i = 0; i < HASH_READ_AHEAD; i++)
+        {
+            if (Chunks[i].Data != NULL)
+                free(Chunks[i].Data);
+        }
+        delete[] Chunks;
+    }
+    if (RowDone != NULL)
+        free(RowDone);
+    if (WorkReady != NULL)
+        HANDLES(CloseHandle(WorkReady));
+    if (BufferFreed != NULL)
+        HANDLES(CloseHandle(BufferFreed));
+    HANDLES(DeleteCriticalSection(&CS));
+}
+
+BOOL CHashPipeline::Start(const THashFactory* factories, int count)
+{
+    CALL_STACK_MESSAGE2("CHashPipeline::Start(, %d)", count);
+    FactoryCount = count;
+    memcpy(Factories, factories, count * sizeof(THashFactory));
+
+    RowDone = (BYTE*)malloc(RowCount + 1);
+    Chunks = new CHashChunk[HASH_READ_AHEAD];
+    WorkReady = HANDLES(CreateSemaphore(NULL, 0, 0x7FFFFFFF, NULL));
+    BufferFreed = HANDLES(CreateEvent(NULL, FALSE, FALSE, NULL));
+    if (RowDone == NULL || Chunks == NULL || WorkReady == NULL || BufferFreed == NULL)
+    {
+        TRACE_E(LOW_MEMORY);
+        return FALSE;
+    }
+    memset(RowDone, 0, RowCount + 1);
+    int i;
+    for (i = 0; i < HASH_READ_AHEAD; i++)
+        Chunks[i].Data = NULL;
+    for (i = 0; i < HASH_READ_AHEAD; i++)
+    {
+        Chunks[i].Data = (char*)malloc(HASH_CHUNK_SIZE);
+        if (Chunks[i].Data == NULL)
+        {
+            TRACE_E(LOW_MEMORY);
+            return FALSE;
+        }
+        Chunks[i].Next = FreeChunks;
+        FreeChunks = Chunks + i;
+    }
+
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    int workers = (int)si.dwNumberOfProcessors;
+    if (workers > HASH_MAX_WORKERS)
+        workers = HASH_MAX_WORKERS;
+    if (workers < 1)
+        workers = 1;
+    while (WorkerCount < workers)
+    {
+        CHashWorkerThread* thread = new CHashWorkerThread(this);
+        HANDLE handle;
+        if (thread == NULL || (handle = thread->Create(ThreadQueue)) == NULL)
+        {
+            TRACE_E("CHashPipeline::Start(): Failed to create helper thread.");
+            if (thread != NULL)
+                delete thread; // on failure the thread object needs to be deallocated
+            break;
+        }
+        Workers[WorkerCount++] = handle;
+    }
+    if (WorkerCount == 0)
+        return FALSE;
+    return TRUE;
+}
+
+void CHashPipeline::PushReady(CHashStream* stream)
+{
+    stream->ReadyNext = NULL;
+    if (ReadyTail != NULL)
+        ReadyTail->ReadyNext = stream;
+    else
+        ReadyHead = stream;
+    ReadyTail = stream;
+    ReleaseSemaphore(WorkReady, 1, NULL);
+}
+
+void CHashPipeline::ReleaseChunk(CHashChunk* chunk)
+{
+    if (--chunk->Refs == 0)
+    {
+        Dialog->IncreaseProgress(CQuadWord(chunk->Size, 0));
+        chunk->Next = FreeChunks;
+        FreeChunks = chunk;
+        SetEvent(BufferFreed);
+    }
+}
+
+void CHashPipeline::MarkRowDone(int row)
+{
+    RowDone[row] = TRUE;
+    while (FirstPendingRow < RowCount && RowDone[FirstPendingRow])
+        FirstPendingRow++;
+    Dialog->ScrollToItem(min(FirstPendingRow, ReaderRow));
+}
+
+void CHashPipeline::FileDone(CHashFile* file)
+{
+    BOOL hashed = !file->Failed && !*Terminate;
+    CHashAlgo* hashes[HT_COUNT];
+    int i;
+    for (i = 0; i < FactoryCount; i++)
+    {
+        hashes[i] = file->Streams[i].Algo;
+        if (hashed)
+            hashes[i]->Finalize();
+    }
+    OnFileDone(file->Row, file->KeyValid ? &file->Key : NULL, hashes, FactoryCount, hashed);
+    for (i = 0; i < FactoryCount; i++)
+        delete hashes[i];
+    MarkRowDone(file->Row);
+    delete file;
+}
+
+void CHashPipeline::BeginRow(int row)
+{
+    HANDLES(EnterCriticalSection(&CS));
+    ReaderRow = row;
+    Dialog->ScrollToItem(min(FirstPendingRow, ReaderRow));
+    HANDLES(LeaveCriticalSection(&CS));
+}
+
+void CHashPipeline::EndRow()
+{
+    HANDLES(EnterCriticalSection(&CS));
+    MarkRowDone(ReaderRow);
+    HANDLES(LeaveCriticalSection(&CS));
+}
+
+BOOL CHashPipeline::BeginFile(const CSalamanderFileDigestKey* key)
+{
+    CHashFile* file = new CHashFile;
+    if (file == NULL)
+    {
+        TRACE_E(LOW_MEMORY);
+        return FALSE;
+    }
+    file->Row = ReaderRow;
+    file->KeyValid = key != NULL;
+    if (key != NULL)
+        file->Key = *key;
+    file->Last = NULL;
+    file->Pending = 0;
+    file->ReadDone = FALSE;
+    file->Failed = FALSE;
+    int i;
+    for (i = 0; i < FactoryCount; i++)
+    {
+        CHashStream* stream = file->Streams + i;
+        stream->Algo = Factories[i]();
+        if (stream->Algo == NULL)
+        {
+            TRACE_E(LOW_MEMORY);
+            while (i-- > 0)
+                delete file->Streams[i].Algo;
+            delete file;
+            return FALSE;
+        }
+        stream->Algo->Init();
+        stream->File = file;
+        stream->Chunk = NULL;
+        stream->Busy = FALSE;
+        stream->ReadyNext = NULL;
+    }
+    CurrentFile = file; // helper threads see the file only after PutBuffer()
+    return TRUE;
+}
+
+char* CHashPipeline::GetBuffer()
+{
+    while (TRUE)
+    {
+        HANDLES(EnterCriticalSection(&CS));
+        if (FreeChunks != NULL)
+        {
+            CurrentChunk = FreeChunks;
+            FreeChunks = FreeChunks->Next;
+            HANDLES(LeaveCriticalSection(&CS));
+            return CurrentChunk->Data;
+        }
+        HANDLES(LeaveCriticalSection(&CS));
+        WaitForSingleObject(BufferFreed, INFINITE); // helper threads always free buffers, no deadlock
+    }
+}
+
+void CHashPipeline::PutBuffer(DWORD size)
+{
+    HANDLES(EnterCriticalSection(&CS));
+    CHashChunk* chunk = CurrentChunk;
+    CurrentChunk = NULL;
+    if (size == 0)
+    {
+        chunk->Next = FreeChunks;
+        FreeChunks = chunk;
+    }
+    else
+    {
+        CHashFile* file = CurrentFile;
+        chunk->Next = NULL;
+        chunk->Size = size;
+        chunk->Refs = FactoryCount + 1;
+        if (file->Last != NULL)
+        {
+            file->Last->Next = chunk;
+            ReleaseChunk(file->Last);
+        }
+        file->Last = chunk;
+        file->Pending += FactoryCount;
+        int i;
+        for (i = 0; i < FactoryCount; i++)
+        {
+            CHashStream* stream = file->Streams + i;
+            if (stream->Chunk == NULL) // the stream has hashed everything read so far
+            {
+                stream->Chunk = chunk;
+                PushReady(stream);
+            }
+        }
+    }
+    HANDLES(LeaveCriticalSection(&CS));
+}
+
+void CHashPipeline::EndFile(BOOL failed)
+{
+    HANDLES(EnterCriticalSection(&CS));
+    CHashFile* file = CurrentFile;
+    CurrentFile = NULL;
+    if (failed)
+        file->Failed = TRUE;
+    file->ReadDone = TRUE;
+    if (file->Last != NULL)
+        ReleaseChunk(file->Last);
+    if (file->Pending == 0)
+        FileDone(file);
+    HANDLES(LeaveCriticalSection(&CS));
+}
+
+void CHashPipeline::Finish()
+{
+    CALL_STACK_MESSAGE1("CHashPipeline::Finish()");
+    HANDLES(EnterCriticalSection(&CS));
+    StopWorkers = TRUE;
+    HANDLES(LeaveCriticalSection(&CS));
+    ReleaseSemaphore(WorkReady, WorkerCount, NULL);
+    while (WorkerCount > 0)
+        ThreadQueue.WaitForExit(Workers[--WorkerCount], INFINITE);
+}
+
+void CHashPipeline::WorkerBody()
+{
+    CALL_STACK_MESSAGE1("CHashPipeline::WorkerBody()");
+    while (TRUE)
+    {
+        WaitForSingleObject(WorkReady, INFINITE);
+        HANDLES(EnterCriticalSection(&CS));
+        CHashStream* stream = ReadyHead;
+        if (stream == NULL)
+        {
+            BOOL stop = StopWorkers;
+            HANDLES(LeaveCriticalSection(&CS));
+            if (stop)
+                break; // everything is hashed
+            continue;
+        }
+        ReadyHead = stream->ReadyNext;
+        if (ReadyHead == NULL)
+            ReadyTail = NULL;
+        stream->Busy = TRUE;
+        CHashChunk* chunk = stream->Chunk;
+        BOOL skip = stream->File->Failed || *Terminate;
+        HANDLES(LeaveCriticalSection(&CS));
+
+        if (!skip)
+            stream->Algo->Update(chunk->Data, chunk->Size);
+
+        HANDLES(EnterCriticalSection(&CS));
+        CHashFile* file = stream->File;
+        stream->Busy = FALSE;
+        stream->Chunk = chunk->Next; // the chunk cannot be released yet, we hold a reference
+        ReleaseChunk(chunk);
+        file->Pending--;
+        if (stream->Chunk != NULL)
+            PushReady(stream);
+        if (file->ReadDone && file->Pending == 0)
+            FileDone(file);
+        HANDLES(LeaveCriticalSection(&CS));
+    }
+}
@@ -0,0 +1,110 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#define HASH_CHUNK_SIZE (16 * 65536) // size of one read-ahead buffer
+#define HASH_READ_AHEAD 8            // number of read-ahead buffers (bounds the number of files hashed at once)
+#define HASH_MAX_WORKERS 8           // max. number of hashing threads
+
+struct CHashChunk;
+struct CHashStream;
+struct CHashFile;
+
+//****************************************************************************
+//
+// CHashPipeline
+//
+// The owner thread opens and reads the files one after another (error dialogs stay
+// in that thread) into large read-ahead buffers; helper threads run the hash
+// algorithms. Every algorithm of every file is a separate stream whose chunks are
+// hashed in order, so several algorithms of one file and several small files are
+// computed at the same time on different cores.
+//
+// Progress: the size of a chunk is passed to IncreaseProgress() once all algorithms
+// have hashed it, FILE_SIZE_FIX and sizes of skipped files are added by the owner thread.
+//
+// Rows: the dialog reads results only before ScrollIndex, so the scroll position is
+// kept on the first row whose results are not written yet.
+
+class CHashPipeline
+{
+public:
+    CHashPipeline(CSFVMD5Dialog* dialog, BOOL* terminate, int rowCount);
+    virtual ~CHashPipeline();
+
+    // allocates buffers and starts helper threads; 'factories' ('count' items) create
+    // the algorithms computed for every file; returns FALSE on error
+    BOOL Start(const THashFactory* factories, int count);
+
+    // the following methods are called only from the owner thread:
+
+    // the owner thread starts processing row 'row' (rows go in ascending order)
+    void BeginRow(int row);
+
+    // the current row is finished without hashing (skipped, missing file, etc.)
+    void EndRow();
+
+    // the file of the current row is going to be read; 'key' is the content identification
+    // of the file for the digest cache (NULL = unknown), it is passed to OnFileDone();
+    // returns FALSE on low memory; the row is finished by EndFile()
+    BOOL BeginFile(const CSalamanderFileDigestKey* key);
+
+    // returns a free buffer of HASH_CHUNK_SIZE bytes, waits if all buffers are in use
+    char* GetBuffer();
+
+    // hands 'size' bytes read into the buffer from GetBuffer() over to the hashing threads
+    // (0 = nothing was read, the buffer is just returned)
+    void PutBuffer(DWORD size);
+
+    // all data of the current file were passed; 'failed' is TRUE if the file was not read
+    // completely (OnFileDone() is then called with 'hashed' FALSE)
+    void EndFile(BOOL failed);
+
+    // waits until all files are hashed and stops the helper threads
+    void Finish();
+
+    // body of the helper threads
+    void WorkerBody();
+
+protected:
+    // called once all data of the file on row 'row' were hashed (from any thread, but
+    // always only one at a time); 'key' is the identification passed to BeginFile();
+    // 'hashes' ('count' items in the order of factories passed to Start()) are finalized
+    // if 'hashed' is TRUE; if 'hashed' is FALSE, the file was not read completely or
+    // the work was canceled (see Terminate)
+    virtual void OnFileDone(int row, const CSalamanderFileDigestKey* key, CHashAlgo** hashes,
+                            int count, BOOL hashed) = 0;
+
+    void PushReady(CHashStream* stream);
+    void ReleaseChunk(CHashChunk* chunk);
+    void FileDone(CHashFile* file);
+    void MarkRowDone(int row);
+
+    CSFVMD5Dialog* Dialog;
+    BOOL* Terminate;
+
+    CRITICAL_SECTION CS; // guards all data below
+    HANDLE WorkReady;    // semaphore: number of streams in the ready queue (+ stop requests)
+    HANDLE BufferFreed;  // auto-reset event: a buffer was returned to FreeChunks
+    BOOL StopWorkers;    // TRUE = helper threads should end once the ready queue is empty
+
+    THashFactory Factories[HT_COUNT];
+    int FactoryCount;
+
+    CHashChunk* Chunks;       // HASH_READ_AHEAD buffers
+    CHashChunk* FreeChunks;   // list of free buffers
+    CHashChunk* CurrentChunk; // buffer returned by GetBuffer() and not yet passed to PutBuffer()
+    CHashFile* CurrentFile;   // file being read by the owner thread
+
+    CHashStream* ReadyHead; // queue of streams which have a chunk to hash and are not being hashed
+    CHashStream* ReadyTail;
+
+    HANDLE Workers[HASH_MAX_WORKERS];
+    int WorkerCount;
+
+    BYTE* RowDone;       // TRUE for rows whose results are written
+    int RowCount;        // number of rows
+    int FirstPendingRow; // first row whose results are not written yet
+    int ReaderRow;       // row processed by the owner thread
+};
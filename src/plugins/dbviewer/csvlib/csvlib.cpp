@@ -26,11 +26,6 @@ extern BOOL IsAlpha[256];
 
 #define SizeOf(x) (sizeof(x) / sizeof(x[0]))
 
-//****************************************************************************
-//
-// CCSVParserCore
-//
-
 /*BOOL IsTextQualifier(char p, CCSVParserTextQualifier tq)
 {
   if (tq == CSVTQ_NONE)
@@ -42,57 +37,323 @@ extern BOOL IsAlpha[256];
   return FALSE;
 }*/
 
-// block size used when reading the file
-#define READ_BUFFER_SIZE 60 * 1024
+// block size indexed before the file is shown, the rest is indexed in the background
+#define CSV_INDEX_FIRST_PART (1024 * 1024)
+// block size indexed by one thread at once
+#define CSV_INDEX_CHUNK_SIZE (8 * 1024 * 1024)
+// maximum number of threads indexing the file
+#define CSV_INDEX_MAX_THREADS 8
+// minimum size of the view used by FetchRecord
+#define CSV_FETCH_VIEW_SIZE (1024 * 1024)
+
+// copies 'size' bytes from a mapped view; returns FALSE on a read error
+static BOOL CopyFromView(void* dest, const void* src, size_t size)
+{
+    __try
+    {
+        memcpy(dest, src, size);
+    }
+    __except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH)
+    {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+//****************************************************************************
+//
+// CCSVRowIndex
+//
+
+CCSVRowIndex::CCSVRowIndex() : BlockOffset(1000, 4096), BlockData(1000, 4096)
+{
+    Count = 0;
+    Data = NULL;
+    DataLen = 0;
+    DataSize = 0;
+    LastOffset = 0;
+    CacheIndex = -1;
+}
+
+CCSVRowIndex::~CCSVRowIndex()
+{
+    if (Data != NULL)
+        free(Data);
+}
+
+void CCSVRowIndex::Clear()
+{
+    Count = 0;
+    if (Data != NULL)
+        free(Data);
+    Data = NULL;
+    DataLen = 0;
+    DataSize = 0;
+    BlockOffset.DestroyMembers();
+    BlockData.DestroyMembers();
+    LastOffset = 0;
+    CacheIndex = -1;
+}
+
+BOOL CCSVRowIndex::Add(__int64 offset)
+{
+    if (Count % CSV_ROW_INDEX_BLOCK == 0)
+    {
+        // the first row of a block is stored as is
+        BlockOffset.Add(offset);
+        if (!BlockOffset.IsGood())
+        {
+            BlockOffset.ResetState();
+            return FALSE;
+        }
+        BlockData.Add(DataLen);
+        if (!BlockData.IsGood())
+        {
+            BlockData.ResetState();
+            BlockOffset.Delete(BlockOffset.Count - 1);
+            return FALSE;
+        }
+    }
+    else
+    {
+        if (DataSize - DataLen < 10) // the longest code of a 64-bit difference
+        {
+            size_t size = DataSize == 0 ? 64 * 1024 : DataSize * 2;
+            BYTE* data = (BYTE*)realloc(Data, size);
+            if (data == NULL)
+                return FALSE;
+            Data = data;
+            DataSize = size;
+        }
+        unsigned __int64 diff = (unsigned __int64)(offset - LastOffset);
+        BYTE* p = Data + DataLen;
+        while (diff >= 0x80)
+        {
+            *p++ = (BYTE)(diff | 0x80);
+            diff >>= 7;
+        }
+        *p++ = (BYTE)diff;
+        DataLen = p - Data;
+    }
+    LastOffset = offset;
+    Count++;
+    return TRUE;
+}
+
+BOOL CCSVRowIndex::Add(CCSVRowIndex* index)
+{
+    int i;
+    for (i = 0; i < index->Count; i++)
+    {
+        if (!Add(index->Get(i)))
+            return FALSE;
+    }
+    return TRUE;
+}
 
-enum CReadingStateEnum
+__int64 CCSVRowIndex::Get(int index)
 {
-    rsNewLine,
-    rsNewLineR,
-    rsNewLineN,
-    rsData,
-    rsQualifiedData,
-    rsQualifiedDataFirst,
-    rsPostQualifiedData,
-};
+    int block = index / CSV_ROW_INDEX_BLOCK;
+    int last = index % CSV_ROW_INDEX_BLOCK;
+    int i;
+    __int64 offset;
+    size_t pos;
+    if (CacheIndex != -1 && CacheIndex <= index && CacheIndex / CSV_ROW_INDEX_BLOCK == block)
+    { // continue from the previous row
+        i = CacheIndex % CSV_ROW_INDEX_BLOCK;
+        offset = CacheOffset;
+        pos = CachePos;
+    }
+    else
+    {
+        i = 0;
+        offset = BlockOffset[block];
+        pos = BlockData[block];
+    }
+    for (; i < last; i++)
+    {
+        unsigned __int64 diff = 0;
+        int shift = 0;
+        BYTE b;
+        do
+        {
+            b = Data[pos++];
+            diff |= (unsigned __int64)(b & 0x7F) << shift;
+            shift += 7;
+        } while (b & 0x80);
+        offset += diff;
+    }
+    CacheIndex = index;
+    CacheOffset = offset;
+    CachePos = pos;
+    return offset;
+}
+
+//****************************************************************************
+//
+// CCSVParserCore
+//
 
-CCSVParserCore::CCSVParserCore() : Rows(5000, 10000), Columns(500, 500)
+CCSVParserCore::CCSVParserCore() : Columns(500, 500), IndexColumns(500, 500)
 {
     Status = CSVE_OK;
+    File = NULL;
+    Mapping = NULL;
+    FileSize = 0;
+    FileChars = 0;
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    AllocationGranularity = si.dwAllocationGranularity;
+    BufferSize = 0;
+    View = NULL;
+    ViewOffset = 0;
+    ViewSize = 0;
+    InitializeCriticalSection(&IndexCS);
+    IndexedEnd = 0;
+    IndexRunning = FALSE;
+    IndexThread = NULL;
+    IndexTerminate = FALSE;
+    IndexPos = 0;
+    IndexState.RS = rsData;
+    IndexState.ColumnLen = 0;
+    IndexState.ColumnIndex = 0;
+    IndexState.RowStart = 0;
+    FirstRow = 0;
+    RecordsCnt = 0;
 }
 
 CCSVParserCore::~CCSVParserCore()
 {
+    StopIndexing();
     int i;
     for (i = 0; i < Columns.Count; i++)
     {
         if (Columns[i].Name != NULL)
             free(Columns[i].Name);
     }
+    if (View != NULL)
+        UnmapViewOfFile(View);
+    if (Mapping != NULL)
+        CloseHandle(Mapping);
     if (File != NULL)
-        fclose(File);
+        CloseHandle(File);
+    DeleteCriticalSection(&IndexCS);
+}
+
+BOOL CCSVParserCore::OpenFile(const char* filename)
+{
+    File = CreateFile(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (File == INVALID_HANDLE_VALUE)
+    {
+        File = NULL;
+        Status = (CCSVParserStatus)(GetLastError() | CSVE_SYSTEM_ERROR);
+        //Status = CSVE_FILE_NOT_FOUND;
+        return FALSE;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(File, &size))
+    {
+        Status = (CCSVParserStatus)(GetLastError() | CSVE_SYSTEM_ERROR);
+        return FALSE;
+    }
+    FileSize = size.QuadPart;
+    if (FileSize > 0) // an empty file cannot be mapped
+    {
+        Mapping = CreateFileMapping(File, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (Mapping == NULL)
+        {
+            Status = (CCSVParserStatus)(GetLastError() | CSVE_SYSTEM_ERROR);
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+const BYTE* CCSVParserCore::MapView(__int64 offset, DWORD size, void** view)
+{
+    __int64 begin = offset - offset % AllocationGranularity;
+    *view = MapViewOfFile(Mapping, FILE_MAP_READ, (DWORD)(begin >> 32), (DWORD)begin,
+                          (SIZE_T)(offset - begin + size));
+    if (*view == NULL)
+        return NULL;
+    return (const BYTE*)*view + (offset - begin);
+}
+
+void CCSVParserCore::StopIndexing()
+{
+    if (IndexThread != NULL)
+    {
+        IndexTerminate = TRUE;
+        WaitForSingleObject(IndexThread, INFINITE);
+        CloseHandle(IndexThread);
+        IndexThread = NULL;
+    }
 }
 
-BOOL CCSVParserCore::SetLongerColumn(int columnIndex, DWORD columnLen)
+BOOL CCSVParserCore::RefreshIndex()
 {
-    if (columnIndex >= Columns.Count)
+    if (IndexThread == NULL)
+        return FALSE;
+    EnterCriticalSection(&IndexCS);
+    BOOL changed = UpdateColumns();
+    if (RecordsCnt != (DWORD)(Rows.Count - FirstRow))
+    {
+        RecordsCnt = Rows.Count - FirstRow;
+        changed = TRUE;
+    }
+    BOOL running = IndexRunning;
+    LeaveCriticalSection(&IndexCS);
+    if (!running)
     {
-        CCSVColumn column;
-        column.First = 0;
-        column.Length = 0;
-        column.MaxLength = columnLen;
-        column.Name = NULL;
-        Columns.Add(column);
-        if (!Columns.IsGood())
+        StopIndexing(); // just closes the finished thread
+        changed = TRUE;
+    }
+    return changed;
+}
+
+BOOL CCSVParserCore::UpdateColumns()
+{
+    BOOL added = FALSE;
+    int i;
+    for (i = 0; i < IndexColumns.Count; i++)
+    {
+        if (i >= Columns.Count)
         {
-            Columns.ResetState();
+            CCSVColumn column;
+            column.First = 0;
+            column.Length = 0;
+            column.MaxLength = IndexColumns[i];
+            column.Name = NULL;
+            Columns.Add(column);
+            if (!Columns.IsGood())
+            {
+                Columns.ResetState();
+                break;
+            }
+            added = TRUE;
+        }
+        else
+            Columns[i].MaxLength = IndexColumns[i];
+    }
+    return added;
+}
+
+BOOL CCSVParserCore::SetLongerColumn(TDirectArray<DWORD>* maxLengths, int columnIndex, DWORD columnLen)
+{
+    if (columnIndex >= maxLengths->Count)
+    {
+        maxLengths->Add(columnLen);
+        if (!maxLengths->IsGood())
+        {
+            maxLengths->ResetState();
             return FALSE;
         }
     }
     else
     {
-        if (Columns[columnIndex].MaxLength < columnLen)
-            Columns[columnIndex].MaxLength = columnLen;
+        if (maxLengths->At(columnIndex) < columnLen)
+            maxLengths->At(columnIndex) = columnLen;
     }
     return TRUE;
 }
@@ -171,46 +432,34 @@ CCSVParser<CChar>::CCSVParser(const char* filename,
     __int64 rowSeek = 0; // row position within the file
 
     Buffer = NULL;
+    bIsBigEndian = false;
 
-    File = fopen(filename, "rb");
-    if (File == NULL)
-    {
-        Status = (CCSVParserStatus)(GetLastError() | CSVE_SYSTEM_ERROR);
-        //Status = CSVE_FILE_NOT_FOUND;
+    if (!OpenFile(filename))
         return;
-    }
-
-    // retrieve the file size
-    fseek(File, 0, SEEK_END);
-    fgetpos(File, &FileSize);
-    fseek(File, 0, SEEK_SET);
+    FileChars = FileSize / sizeof(CChar);
 
+    BYTE bom[3];
+    DWORD bomRead = 0;
+    if (!ReadFile(File, bom, 3, &bomRead, NULL))
+        bomRead = 0;
     if (sizeof(CChar) == 2)
     {
-        WORD BOM;
-
-        fread(&BOM, 1, 2, File); // Read BOM
-        rowSeek = 1;             // in # of characters
-        bIsBigEndian = BOM == 0xFFFE;
+        rowSeek = 1; // in # of characters
+        bIsBigEndian = bomRead >= 2 && *(WORD*)bom == 0xFFFE;
     }
     else
     { // Detect UTF8
-        BYTE b[3];
-        fread(b, 1, 3, File);
-        if (!memcmp(b, "\xEF\xBB\xBF", 3))
+        if (bomRead == 3 && !memcmp(bom, "\xEF\xBB\xBF", 3))
         {                // Skip UTF8 BOM
             rowSeek = 3; // in # of characters
         }
-        else
-        {
-            fseek(File, 0, SEEK_SET);
-        }
     }
 
     if (autoSeparator || autoQualifier || autoFirstRowAsName)
     {
         // the user wants to detect some of the parameters
-        AnalyseFile(autoSeparator, &separator,
+        AnalyseFile(rowSeek,
+                    autoSeparator, &separator,
                     autoQualifier, &textQualifier,
                     autoFirstRowAsName, &firstRowAsColumnNames);
     }
@@ -218,187 +467,415 @@ CCSVParser<CChar>::CCSVParser(const char* filename,
     Separator = separator;
     TextQualifier = textQualifier;
 
-    CChar buffer[READ_BUFFER_SIZE];
-
-    size_t bytesRead; // number of characters actually read into the buffer
+    // index the beginning of the file (at least the first row) so that it can be shown at once
+    IndexPos = rowSeek;
+    IndexState.RowStart = rowSeek;
+    IndexedEnd = rowSeek;
+    __int64 end = rowSeek;
+    do
+    {
+        end = min(FileChars, end + CSV_INDEX_FIRST_PART / sizeof(CChar));
+        Status = IndexPart(end);
+        if (Status != CSVE_OK)
+            return;
+    } while (end < FileChars && Rows.Count == 0);
+    if (end >= FileChars)
+    {
+        Status = FinishIndex();
+        if (Status != CSVE_OK)
+            return;
+    }
+    UpdateColumns();
+    RecordsCnt = Rows.Count;
 
-    // where the iterator is currently positioned
-    CReadingStateEnum rs = rsData;
+    if (firstRowAsColumnNames && RecordsCnt > 0)
+    {
+        FetchRecord(0);
+        int i;
+        for (i = 0; i < Columns.Count; i++)
+        {
+            size_t textLen;
+            const CChar* text = (const CChar*)GetCellText(i, &textLen);
+            Columns[i].Name = (char*)malloc((textLen + 1) * sizeof(CChar));
+            if (Columns[i].Name == NULL)
+                goto SKIP_ROW_CONVERT;
+            memcpy(Columns[i].Name, text, textLen * sizeof(CChar));
+            ((CChar*)Columns[i].Name)[textLen] = 0;
+        }
+        FirstRow = 1;
+        RecordsCnt--;
+    }
+SKIP_ROW_CONVERT:
 
-    int rowLen = 0;      // length of the row currently being read
-    int maxRowLen = 0;   // length of the longest row
-    DWORD columnLen = 0; // number of characters in the current column
-    int columnIndex = 0; // current column index
+    // the rest of the file is indexed in the background, see RefreshIndex()
+    if (end < FileChars)
+    {
+        IndexRunning = TRUE;
+        DWORD id;
+        IndexThread = CreateThread(NULL, 0, IndexThreadF, this, 0, &id);
+        if (IndexThread == NULL) // index it right now
+        {
+            IndexRest();
+            UpdateColumns();
+            RecordsCnt = Rows.Count - FirstRow;
+        }
+    }
+}
 
-    fseek(File, (long)rowSeek * sizeof(CChar), SEEK_SET);
+template <class CChar>
+CCSVParser<CChar>::~CCSVParser()
+{
+    StopIndexing(); // IndexThread uses the methods of this class
+    if (Buffer != NULL)
+        free(Buffer);
+}
 
-    do
+template <class CChar>
+size_t CCSVParser<CChar>::Scan(const CChar* text, size_t count, __int64 offset, CCSVScanState* state,
+                               CCSVRowIndex* rows, TDirectArray<DWORD>* maxLengths, __int64* eol,
+                               CCSVParserStatus* status)
+{
+    CChar qualifier = 0; // zero cannot be a qualifier, it always ends the row
+    if (TextQualifier == CSVTQ_QUOTE)
+        qualifier = '\"';
+    else if (TextQualifier == CSVTQ_SINGLEQUOTE)
+        qualifier = '\'';
+    CChar separator = Separator;
+    BOOL swap = sizeof(CChar) == 2 && bIsBigEndian;
+
+    CReadingStateEnum rs = state->RS;
+    DWORD columnLen = state->ColumnLen;
+    int columnIndex = state->ColumnIndex;
+    __int64 rowStart = state->RowStart;
+
+    size_t index;
+    for (index = 0; index < count; index++)
     {
-        // read in windows of READ_BUFFER_SIZE
-        bytesRead = fread(buffer, sizeof(CChar), SizeOf(buffer), File);
-        if (bytesRead > 0)
+        CChar c = text[index];
+        if (swap)
+            c = (CChar)(((WORD)c >> 8) | ((WORD)c << 8));
+        // Enable CR/LF inside quoted text
+        if (c == 0 || ((c == '\r' || c == '\n') && (rs != rsQualifiedData)))
         {
-            if (bIsBigEndian && (sizeof(CChar) == 2))
-                SwapWords((char*)buffer, bytesRead);
-            size_t index;
-            for (index = 0; index < bytesRead; index++)
+            // if this is the end of a row
+            if ((rs == rsNewLineR && c == '\n') ||
+                (rs == rsNewLineN && c == '\r'))
             {
-                CChar c = buffer[index];
-                // Enable CR/LF inside quoted text
-                if (c == 0 || ((c == '\r' || c == '\n') && (rs != rsQualifiedData)))
+                // if it's the second character, just skip over it
+                rowStart = offset + index + 1;
+                rs = rsNewLine;
+            }
+            else
+            {
+                // if it's the first character, add the row
+                if (rows != NULL)
                 {
-                    // if this is the end of a row
-                    if ((rs == rsNewLineR && c == '\n') ||
-                        (rs == rsNewLineN && c == '\r'))
+                    // if there is a new column, store it
+                    if (!rows->Add(rowStart) || !SetLongerColumn(maxLengths, columnIndex, columnLen))
                     {
-                        // if it's the second character, just skip over it
-                        rowSeek++;
-                        rs = rsNewLine;
+                        *status = CSVE_OOM;
+                        break;
                     }
-                    else
-                    {
-                        // if it's the first character, add the row
-                        Rows.Add(rowSeek);
-                        if (!Rows.IsGood())
-                        {
-                            Rows.ResetState();
-                            Status = CSVE_OOM;
-                            return;
-                        }
-                        // if there is a new column, store it
-                        if (!SetLongerColumn(columnIndex, columnLen))
-                        {
-                            Status = CSVE_OOM;
-                            return;
-                        }
+                }
 
-                        rowSeek += rowLen + 1;
-                        rowLen = 0;
-                        columnLen = 0;
-                        columnIndex = 0;
-                        // prepare to receive the second character of the line ending
-                        switch (c)
-                        {
-                        case 0:
-                            rs = rsNewLine;
-                            break;
-                        case '\r':
-                            rs = rsNewLineR;
-                            break;
-                        case '\n':
-                            rs = rsNewLineN;
-                            break;
-                        }
-                    }
-                    continue;
+                rowStart = offset + index + 1;
+                columnLen = 0;
+                columnIndex = 0;
+                // prepare to receive the second character of the line ending
+                switch (c)
+                {
+                case 0:
+                    rs = rsNewLine;
+                    break;
+                case '\r':
+                    rs = rsNewLineR;
+                    break;
+                case '\n':
+                    rs = rsNewLineN;
+                    break;
                 }
+                if (eol != NULL)
+                {
+                    *eol = offset + index;
+                    index++;
+                    break;
+                }
+            }
+            continue;
+        }
 
-                // the second character of the line ending might not arrive -> reset the state
-                if (rs == rsNewLine || rs == rsNewLineR || rs == rsNewLineN)
-                    rs = rsData;
+        // the second character of the line ending might not arrive -> reset the state
+        if (rs == rsNewLine || rs == rsNewLineR || rs == rsNewLineN)
+            rs = rsData;
 
-                rowLen++;
-                if (rowLen > maxRowLen)
-                    maxRowLen = rowLen;
+        if (c == qualifier)
+        {
+            if (rs == rsData && columnLen == 0)
+            {
+                rs = rsQualifiedData;
+                continue;
+            }
 
-                if ((TextQualifier == CSVTQ_QUOTE && c == '\"') ||
-                    (TextQualifier == CSVTQ_SINGLEQUOTE && c == '\''))
-                {
-                    if (rs == rsData && columnLen == 0)
-                    {
-                        rs = rsQualifiedData;
-                        continue;
-                    }
+            if (rs == rsQualifiedData)
+            {
+                rs = rsQualifiedDataFirst;
+                continue;
+            }
 
-                    if (rs == rsQualifiedData)
-                    {
-                        rs = rsQualifiedDataFirst;
-                        continue;
-                    }
+            if (rs == rsQualifiedDataFirst)
+            {
+                rs = rsQualifiedData;
+                columnLen++;
+                continue;
+            }
 
-                    if (rs == rsQualifiedDataFirst)
-                    {
-                        rs = rsQualifiedData;
-                        columnLen++;
-                        continue;
-                    }
+            columnLen++;
 
-                    columnLen++;
+            continue;
+        }
 
-                    continue;
-                }
+        if (rs != rsQualifiedData && c == separator)
+        {
+            // if there is a new column, store it
+            if (maxLengths != NULL && !SetLongerColumn(maxLengths, columnIndex, columnLen))
+            {
+                *status = CSVE_OOM;
+                break;
+            }
 
-                if (rs != rsQualifiedData && c == separator)
-                {
-                    // if there is a new column, store it
-                    if (!SetLongerColumn(columnIndex, columnLen))
-                    {
-                        Status = CSVE_OOM;
-                        return;
-                    }
+            columnIndex++;
+            columnLen = 0;
+            rs = rsData;
+            continue;
+        }
 
-                    columnIndex++;
-                    columnLen = 0;
-                    rs = rsData;
-                    continue;
-                }
+        columnLen++;
+    }
 
-                columnLen++;
-            }
+    state->RS = rs;
+    state->ColumnLen = columnLen;
+    state->ColumnIndex = columnIndex;
+    state->RowStart = rowStart;
+    return index;
+}
+
+template <class CChar>
+size_t CCSVParser<CChar>::ScanGuarded(const CChar* text, size_t count, __int64 offset, CCSVScanState* state,
+                                      CCSVRowIndex* rows, TDirectArray<DWORD>* maxLengths, __int64* eol,
+                                      CCSVParserStatus* status)
+{
+    __try
+    {
+        return Scan(text, count, offset, state, rows, maxLengths, eol, status);
+    }
+    __except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ? EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH)
+    {
+        *status = CSVE_READ_ERROR;
+        return 0;
+    }
+}
+
+template <class CChar>
+CCSVParserStatus CCSVParser<CChar>::IndexPart(__int64 end)
+{
+    CCSVParserStatus status = CSVE_OK;
+    while (status == CSVE_OK && IndexPos < end)
+    {
+        __int64 partEnd = min(end, IndexPos + CSV_INDEX_CHUNK_SIZE / sizeof(CChar));
+        void* view;
+        const CChar* text = (const CChar*)MapView(IndexPos * sizeof(CChar),
+                                                  (DWORD)((partEnd - IndexPos) * sizeof(CChar)), &view);
+        if (text == NULL)
+            return CSVE_READ_ERROR;
+        ScanGuarded(text, (size_t)(partEnd - IndexPos), IndexPos, &IndexState, &Rows, &IndexColumns, NULL, &status);
+        UnmapViewOfFile(view);
+        IndexPos = partEnd;
+        IndexedEnd = IndexState.RowStart;
+    }
+    return status;
+}
+
+template <class CChar>
+void CCSVParser<CChar>::IndexChunk(CCSVIndexChunk* chunk)
+{
+    chunk->Text = MapView(chunk->Begin * sizeof(CChar), (DWORD)((chunk->End - chunk->Begin) * sizeof(CChar)),
+                          &chunk->View);
+    if (chunk->Text == NULL)
+    {
+        chunk->Status = CSVE_READ_ERROR;
+        return;
+    }
+    const CChar* text = (const CChar*)chunk->Text;
+    size_t count = (size_t)(chunk->End - chunk->Begin);
+
+    // guess that the chunk begins inside a column outside of a qualified text and skip
+    // to the first end of row; from there on the state of the scanner is exact if the
+    // guess leads to the same end of row as the real state (checked by MergeIndexChunk)
+    CCSVScanState state;
+    state.RS = rsData;
+    state.ColumnLen = 1;
+    state.ColumnIndex = 0;
+    state.RowStart = chunk->Begin;
+    chunk->FirstEOL = -1;
+    size_t done = ScanGuarded(text, count, chunk->Begin, &state, NULL, NULL, &chunk->FirstEOL, &chunk->Status);
+    if (chunk->Status == CSVE_OK && chunk->FirstEOL != -1)
+    {
+        chunk->FirstEOLRS = state.RS;
+        ScanGuarded(text + done, count - done, chunk->Begin + done, &state, &chunk->Rows, &chunk->MaxLengths,
+                    NULL, &chunk->Status);
+    }
+    chunk->EndState = state;
+}
+
+template <class CChar>
+CCSVParserStatus CCSVParser<CChar>::MergeIndexChunk(CCSVIndexChunk* chunk)
+{
+    if (chunk->Status != CSVE_OK)
+        return chunk->Status;
+    const CChar* text = (const CChar*)chunk->Text;
+    size_t count = (size_t)(chunk->End - chunk->Begin);
+
+    // scan from the real state up to the first end of row
+    CCSVParserStatus status = CSVE_OK;
+    CCSVScanState state = IndexState;
+    __int64 eol = -1;
+    EnterCriticalSection(&IndexCS);
+    size_t done = ScanGuarded(text, count, chunk->Begin, &state, &Rows, &IndexColumns, &eol, &status);
+    IndexedEnd = state.RowStart;
+    LeaveCriticalSection(&IndexCS);
+
+    if (status == CSVE_OK && eol != -1)
+    {
+        if (eol != chunk->FirstEOL || state.RS != chunk->FirstEOLRS)
+        { // the guess was wrong (e.g. the chunk begins inside a qualified text with an end of row), index the rest again
+            chunk->Rows.Clear();
+            chunk->MaxLengths.DestroyMembers();
+            ScanGuarded(text + done, count - done, chunk->Begin + done, &state, &chunk->Rows, &chunk->MaxLengths,
+                        NULL, &status);
+            chunk->EndState = state;
         }
-        else
+        if (status == CSVE_OK)
         {
-            if (ferror(File))
+            EnterCriticalSection(&IndexCS);
+            if (!Rows.Add(&chunk->Rows))
+                status = CSVE_OOM;
+            int i;
+            for (i = 0; status == CSVE_OK && i < chunk->MaxLengths.Count; i++)
             {
-                Status = CSVE_READ_ERROR;
-                return;
+                if (!SetLongerColumn(&IndexColumns, i, chunk->MaxLengths[i]))
+                    status = CSVE_OOM;
             }
+            IndexedEnd = chunk->EndState.RowStart;
+            LeaveCriticalSection(&IndexCS);
         }
-    } while (bytesRead > 0);
+        state = chunk->EndState;
+    }
+    IndexState = state;
+    IndexPos = chunk->End;
+    return status;
+}
 
-    if (rs != rsNewLine && rs != rsNewLineR && rs != rsNewLineN && FileSize > 0)
+template <class CChar>
+void CCSVParser<CChar>::IndexRest()
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    int threads = max(1, min(CSV_INDEX_MAX_THREADS, (int)si.dwNumberOfProcessors));
+    CCSVParserStatus status = CSVE_OK;
+    CCSVIndexChunk* chunks = new CCSVIndexChunk[threads];
+    if (chunks == NULL)
+        status = CSVE_OOM;
+    HANDLE handles[CSV_INDEX_MAX_THREADS];
+    while (status == CSVE_OK && !IndexTerminate && IndexPos < FileChars)
     {
-        Rows.Add(rowSeek);
-        if (!Rows.IsGood())
+        // split the next part of the file into chunks
+        int count = 0;
+        __int64 pos = IndexPos;
+        while (count < threads && pos < FileChars)
         {
-            Rows.ResetState();
-            Status = CSVE_OOM;
-            return;
+            CCSVIndexChunk* chunk = &chunks[count++];
+            chunk->Begin = pos;
+            chunk->End = min(FileChars, pos + CSV_INDEX_CHUNK_SIZE / sizeof(CChar));
+            chunk->View = NULL;
+            chunk->Text = NULL;
+            chunk->Rows.Clear();
+            chunk->MaxLengths.DestroyMembers();
+            chunk->Status = CSVE_OK;
+            chunk->Parser = this;
+            pos = chunk->End;
         }
-        // if there is a new column, store it
-        if (!SetLongerColumn(columnIndex, columnLen))
+
+        // index them in parallel, the last one in this thread
+        int started;
+        for (started = 0; started < count - 1; started++)
         {
-            Status = CSVE_OOM;
-            return;
+            DWORD id;
+            handles[started] = CreateThread(NULL, 0, IndexChunkThreadF, &chunks[started], 0, &id);
+            if (handles[started] == NULL)
+                break;
+        }
+        int i;
+        for (i = started; i < count; i++)
+            IndexChunk(&chunks[i]);
+        if (started > 0)
+        {
+            WaitForMultipleObjects(started, handles, TRUE, INFINITE);
+            for (i = 0; i < started; i++)
+                CloseHandle(handles[i]);
+        }
+
+        // join the chunks in order of the file
+        for (i = 0; i < count; i++)
+        {
+            if (status == CSVE_OK && !IndexTerminate)
+                status = MergeIndexChunk(&chunks[i]);
+            if (chunks[i].View != NULL)
+                UnmapViewOfFile(chunks[i].View);
         }
     }
+    if (status == CSVE_OK && !IndexTerminate && IndexPos >= FileChars)
+        FinishIndex();
+    if (chunks != NULL)
+        delete[] chunks;
+
+    EnterCriticalSection(&IndexCS);
+    IndexRunning = FALSE; // on an error, the rows indexed so far remain
+    LeaveCriticalSection(&IndexCS);
+}
 
-    BufferSize = maxRowLen;
-    if (firstRowAsColumnNames && Rows.Count > 0)
+template <class CChar>
+CCSVParserStatus CCSVParser<CChar>::FinishIndex()
+{
+    CCSVParserStatus status = CSVE_OK;
+    EnterCriticalSection(&IndexCS);
+    CReadingStateEnum rs = IndexState.RS;
+    if (rs != rsNewLine && rs != rsNewLineR && rs != rsNewLineN && FileSize > 0)
     {
-        FetchRecord(0);
-        int i;
-        for (i = 0; i < Columns.Count; i++)
+        // if there is a new column, store it
+        if (!Rows.Add(IndexState.RowStart) ||
+            !SetLongerColumn(&IndexColumns, IndexState.ColumnIndex, IndexState.ColumnLen))
         {
-            size_t textLen;
-            const CChar* text = (const CChar*)GetCellText(i, &textLen);
-            Columns[i].Name = (char*)malloc((textLen + 1) * sizeof(CChar));
-            if (Columns[i].Name == NULL)
-                goto SKIP_ROW_CONVERT;
-            memcpy(Columns[i].Name, text, textLen * sizeof(CChar));
-            ((CChar*)Columns[i].Name)[textLen] = 0;
+            status = CSVE_OOM;
         }
-        Rows.Delete(0);
     }
-SKIP_ROW_CONVERT:
-    return;
+    IndexedEnd = FileChars;
+    LeaveCriticalSection(&IndexCS);
+    return status;
 }
 
 template <class CChar>
-CCSVParser<CChar>::~CCSVParser()
+DWORD WINAPI CCSVParser<CChar>::IndexThreadF(void* param)
 {
-    if (Buffer != NULL)
-        free(Buffer);
+    ((CCSVParser<CChar>*)param)->IndexRest();
+    return 0;
+}
+
+template <class CChar>
+DWORD WINAPI CCSVParser<CChar>::IndexChunkThreadF(void* param)
+{
+    CCSVIndexChunk* chunk = (CCSVIndexChunk*)param;
+    ((CCSVParser<CChar>*)chunk->Parser)->IndexChunk(chunk);
+    return 0;
 }
 
 // Attempts to detect the text qualifier.
@@ -625,7 +1102,7 @@ BOOL CCSVParser<CChar>::AnalyseFirstRowAsColumnName(const CChar* buffer, TDirect
 }
 
 template <class CChar>
-void CCSVParser<CChar>::AnalyseFile(BOOL autoSeparator, CChar* separator,
+void CCSVParser<CChar>::AnalyseFile(__int64 start, BOOL autoSeparator, CChar* separator,
                                     BOOL autoQualifier, CCSVParserTextQualifier* textQualifier,
                                     BOOL autoFirstRowAsName, BOOL* firstRowAsColumnNames)
 {
@@ -639,8 +1116,20 @@ void CCSVParser<CChar>::AnalyseFile(BOOL autoSeparator, CChar* separator,
 
     size_t bytesRead; // number of characters actually read into the buffer
 
-    bytesRead = fread(buffer, sizeof(CChar), SAMPLE_BUFFER_SIZE, File);
-    fseek(File, 0, SEEK_SET);
+    bytesRead = (size_t)max(0, min(SAMPLE_BUFFER_SIZE, FileChars - start));
+    if (bytesRead > 0)
+    {
+        void* view;
+        const BYTE* text = MapView(start * sizeof(CChar), (DWORD)(bytesRead * sizeof(CChar)), &view);
+        if (text == NULL)
+            bytesRead = 0;
+        else
+        {
+            if (!CopyFromView(buffer, text, bytesRead * sizeof(CChar)))
+                bytesRead = 0;
+            UnmapViewOfFile(view);
+        }
+    }
     int row = 0;
     if (bytesRead > 0)
     {
@@ -712,29 +1201,52 @@ CCSVParser<CChar>::FetchRecord(DWORD index)
 {
     if (Status != CSVE_OK)
         return Status;
-    if ((int)index >= Rows.Count)
+    if (index >= RecordsCnt)
     {
         Status = CSVE_SEEK_ERROR;
         return Status;
     }
-    if (Buffer == NULL)
+    EnterCriticalSection(&IndexCS);
+    int row = (int)index + FirstRow;
+    __int64 rowBegin = Rows.Get(row);
+    __int64 rowEnd = row < Rows.Count - 1 ? Rows.Get(row + 1) : IndexedEnd;
+    LeaveCriticalSection(&IndexCS);
+
+    __int64 len = min(rowEnd, FileChars) - rowBegin;
+    size_t lineLen = len > 0 ? (size_t)len : 0;
+    if (Buffer == NULL || lineLen > (size_t)BufferSize)
     {
-        Buffer = (CChar*)malloc((BufferSize + 1) * sizeof(CChar)); // space for two terminators
-        if (Buffer == NULL)
+        CChar* buffer = (CChar*)realloc(Buffer, (lineLen + 1) * sizeof(CChar)); // space for the terminator
+        if (buffer == NULL)
         {
             Status = CSVE_OOM;
             return Status;
         }
+        Buffer = buffer;
+        BufferSize = (int)lineLen;
+    }
+    if (lineLen > 0)
+    {
+        __int64 offset = rowBegin * sizeof(CChar);
+        DWORD size = (DWORD)(lineLen * sizeof(CChar));
+        if (View == NULL || offset < ViewOffset || offset + size > ViewOffset + ViewSize)
+        {
+            if (View != NULL)
+                UnmapViewOfFile(View);
+            ViewOffset = offset - offset % AllocationGranularity;
+            ViewSize = (DWORD)(min(FileSize, max(offset + size, ViewOffset + CSV_FETCH_VIEW_SIZE)) - ViewOffset);
+            if (MapView(ViewOffset, ViewSize, &View) == NULL)
+            {
+                View = NULL;
+                Status = CSVE_READ_ERROR;
+                return Status;
+            }
+        }
+        if (!CopyFromView(Buffer, (const BYTE*)View + (offset - ViewOffset), size))
+            lineLen = 0; // the file might have changed and the row may no longer exist
     }
-    __int64 pos = Rows[index] * sizeof(CChar);
-    fsetpos(File, &pos);
-
-    __int64 end = (int)index < Rows.Count - 1 ? Rows[index + 1] : FileSize;
-    size_t lineLen = (size_t)min(BufferSize, (end - Rows[index]));
-    size_t bytesRead = fread(Buffer, sizeof(CChar), lineLen, File);
     if (bIsBigEndian && (sizeof(CChar) == 2))
-        SwapWords((char*)Buffer, bytesRead);
-    lineLen = min(lineLen, bytesRead); // the file might have changed and the row may no longer exist
+        SwapWords((char*)Buffer, lineLen);
     // append null terminators at the end
     CChar* p = Buffer + lineLen;
     *p = 0;
@@ -30,6 +30,100 @@ struct CCSVColumn
     DWORD First;
     DWORD Length;
 };
+
+//****************************************************************************
+//
+// CCSVRowIndex
+//
+// Offsets of row beginnings (in characters) in ascending order. Only the first
+// offset of every CSV_ROW_INDEX_BLOCK rows is stored as is, the others are stored
+// as differences from the previous row in a variable-length code (7 bits per byte),
+// so a typical row costs one or two bytes instead of eight.
+//
+
+#define CSV_ROW_INDEX_BLOCK 64
+
+class CCSVRowIndex
+{
+public:
+    int Count; // number of rows
+
+protected:
+    BYTE* Data;                        // differences between neighbouring rows
+    size_t DataLen;                    // used bytes in Data
+    size_t DataSize;                   // allocated bytes in Data
+    TDirectArray<__int64> BlockOffset; // offset of the first row of each block
+    TDirectArray<size_t> BlockData;    // where the differences of each block begin in Data
+    __int64 LastOffset;                // offset of the last added row
+
+    // the last row returned by Get(); rows are mostly read one after another
+    int CacheIndex; // -1 = empty
+    __int64 CacheOffset;
+    size_t CachePos; // position of the next difference in Data
+
+public:
+    CCSVRowIndex();
+    ~CCSVRowIndex();
+
+    // adds the offset of the next row; returns FALSE on low memory
+    BOOL Add(__int64 offset);
+
+    // adds all rows of 'index' (they must follow the rows of this index); returns FALSE on low memory
+    BOOL Add(CCSVRowIndex* index);
+
+    // returns the offset of row 'index'
+    __int64 Get(int index);
+
+    void Clear();
+};
+
+//****************************************************************************
+//
+// CCSVScanState
+//
+// State of the row scanner between two parts of the file.
+//
+
+enum CReadingStateEnum
+{
+    rsNewLine,
+    rsNewLineR,
+    rsNewLineN,
+    rsData,
+    rsQualifiedData,
+    rsQualifiedDataFirst,
+    rsPostQualifiedData,
+};
+
+struct CCSVScanState
+{
+    CReadingStateEnum RS; // where the scanner is currently positioned
+    DWORD ColumnLen;      // number of characters in the current column
+    int ColumnIndex;      // current column index
+    __int64 RowStart;     // offset of the current row (in characters)
+};
+
+// part of the file indexed by one thread; the thread does not know the state of the
+// scanner at Begin, so it skips everything up to the first end of row and indexes the
+// rest; CCSVParser::MergeIndexChunk() then checks that the real state leads to the
+// same end of row, otherwise it indexes the chunk again
+struct CCSVIndexChunk
+{
+    __int64 Begin; // first character of the chunk
+    __int64 End;   // character behind the chunk
+    void* View;    // mapped view containing the chunk
+    const BYTE* Text;
+
+    __int64 FirstEOL;               // offset of the first end of row; -1 = the chunk has none
+    CReadingStateEnum FirstEOLRS;   // state of the scanner behind FirstEOL
+    CCSVRowIndex Rows;              // rows beginning behind FirstEOL
+    TDirectArray<DWORD> MaxLengths; // column lengths in these rows
+    CCSVScanState EndState;         // state at End
+    CCSVParserStatus Status;        // CSVE_READ_ERROR or CSVE_OOM on an error
+    void* Parser;                   // CCSVParser<CChar> owning the chunk
+
+    CCSVIndexChunk() : MaxLengths(100, 100) {}
+};
 //****************************************************************************
 //
 // CCSVParser
@@ -47,19 +141,48 @@ public:
     virtual DWORD GetColumnsCnt(void) = 0;
     virtual CCSVParserStatus FetchRecord(DWORD index) = 0;
     virtual void* GetCellText(DWORD index, size_t* textLen) = 0;
+    // returns TRUE while the rest of the file is being indexed in the background;
+    // GetRecordsCnt() and GetColumnsCnt() then return what was found so far
+    virtual BOOL IsIndexing() = 0;
+    // takes over the records and columns indexed in the background since the last call;
+    // returns TRUE if something has changed (also when the indexing has finished)
+    virtual BOOL RefreshIndex() = 0;
 };
 
 class CCSVParserCore : public CCSVParserBase
 {
 protected:
     CCSVParserStatus Status;
-    FILE* File;
-    __int64 FileSize;
-    int BufferSize;
-    TDirectArray<__int64> Rows;
+    HANDLE File;
+    HANDLE Mapping;
+    __int64 FileSize;  // in bytes
+    __int64 FileChars; // in characters
+    DWORD AllocationGranularity;
+    int BufferSize; // allocated characters of Buffer
     TDirectArray<CCSVColumn> Columns;
     CCSVParserTextQualifier TextQualifier;
 
+    // view used by FetchRecord
+    void* View;
+    __int64 ViewOffset; // in bytes
+    DWORD ViewSize;
+
+    // index of the rows; the beginning of the file is indexed by the constructor,
+    // the rest by IndexThread
+    CRITICAL_SECTION IndexCS;         // guards Rows, IndexedEnd, IndexColumns and IndexRunning
+    CCSVRowIndex Rows;                // beginnings of all rows indexed so far
+    __int64 IndexedEnd;               // end of the last indexed row
+    TDirectArray<DWORD> IndexColumns; // lengths of columns found by the indexing
+    BOOL IndexRunning;                // TRUE = IndexThread has not finished yet
+
+    HANDLE IndexThread;           // NULL = no background indexing (any more)
+    volatile BOOL IndexTerminate; // TRUE = IndexThread should end as soon as possible
+    __int64 IndexPos;             // where the indexing continues (IndexThread only)
+    CCSVScanState IndexState;     // state of the scanner at IndexPos (IndexThread only)
+
+    int FirstRow;     // 1 = the first row contains names of columns and is skipped
+    DWORD RecordsCnt; // number of records returned by GetRecordsCnt()
+
 public:
     CCSVParserCore();
     virtual ~CCSVParserCore();
@@ -69,18 +192,35 @@ public:
     virtual DWORD GetColumnMaxLen(int index) { return Columns[index].MaxLength; };
     // returns NULL if not assigned; otherwise returns a pointer to a null-terminated name
     virtual const char* GetColumnName(DWORD index) { return Columns[index].Name; };
-    virtual DWORD GetRecordsCnt(void) { return Rows.Count; };
+    virtual DWORD GetRecordsCnt(void) { return RecordsCnt; };
     virtual DWORD GetColumnsCnt(void) { return Columns.Count; };
 
     virtual CCSVParserStatus FetchRecord(DWORD index) = 0;
 
+    virtual BOOL IsIndexing() { return IndexThread != NULL; }
+    virtual BOOL RefreshIndex();
+
 protected:
+    // opens and maps the file; returns FALSE on an error (see Status)
+    BOOL OpenFile(const char* filename);
+
+    // maps the part of the file from byte 'offset' of 'size' bytes; returns a pointer to
+    // 'offset' and the view to unmap in 'view' or NULL on an error
+    const BYTE* MapView(__int64 offset, DWORD size, void** view);
+
+    // stops the background indexing
+    void StopIndexing();
+
     // if the column does not exist at columnIndex, add a new one with MaxLength = columnLen
     // returns FALSE if the column could not be added to the array
     // if the column already exists, extend columnLen only when it is larger than
     // the current MaxLength value in that column
     // returns TRUE if the addition/update of the column succeeded
-    BOOL SetLongerColumn(int columnIndex, DWORD columnLen);
+    static BOOL SetLongerColumn(TDirectArray<DWORD>* maxLengths, int columnIndex, DWORD columnLen);
+
+    // copies the column lengths found by the indexing into Columns; returns TRUE if
+    // a column was added; call from within IndexCS
+    BOOL UpdateColumns();
 
     struct CLineRating
     {
@@ -119,11 +259,41 @@ public:
 
 private:
     // automatic detection of selected values
-    // assumes that File is open; rewinds its pointer to the beginning
-    void AnalyseFile(BOOL autoSeparator, CChar* separator,
+    // the analysed sample begins at character 'start'
+    void AnalyseFile(__int64 start, BOOL autoSeparator, CChar* separator,
                      BOOL autoQualifier, CCSVParserTextQualifier* textQualifier,
                      BOOL autoFirstRowAsName, BOOL* firstRowAsColumnNames);
 
+    // scans 'count' characters of 'text' beginning at character 'offset' of the file from 'state';
+    // beginnings of finished rows are added to 'rows' and lengths of columns to 'maxLengths' (both
+    // can be NULL); if 'eol' is not NULL, it stops right behind the first end of row and stores its
+    // offset into 'eol'; returns the number of scanned characters; sets 'status' to CSVE_OOM on low
+    // memory; the mapped file must only be scanned through ScanGuarded()
+    size_t Scan(const CChar* text, size_t count, __int64 offset, CCSVScanState* state,
+                CCSVRowIndex* rows, TDirectArray<DWORD>* maxLengths, __int64* eol, CCSVParserStatus* status);
+
+    // Scan() that also catches read errors of the mapped file (sets 'status' to CSVE_READ_ERROR)
+    size_t ScanGuarded(const CChar* text, size_t count, __int64 offset, CCSVScanState* state,
+                       CCSVRowIndex* rows, TDirectArray<DWORD>* maxLengths, __int64* eol, CCSVParserStatus* status);
+
+    // indexes the file from IndexPos to 'end' in the calling thread; only before IndexThread starts
+    CCSVParserStatus IndexPart(__int64 end);
+
+    // indexes 'chunk' in a worker thread, see CCSVIndexChunk
+    void IndexChunk(CCSVIndexChunk* chunk);
+
+    // adds the rows of 'chunk' indexed by IndexChunk() to the index; 'chunk' begins at IndexPos
+    CCSVParserStatus MergeIndexChunk(CCSVIndexChunk* chunk);
+
+    // indexes the rest of the file from IndexPos in parallel (the body of IndexThread)
+    void IndexRest();
+
+    // adds the last row if the file does not end with an end of row
+    CCSVParserStatus FinishIndex();
+
+    static DWORD WINAPI IndexThreadF(void* param);
+    static DWORD WINAPI IndexChunkThreadF(void* param);
+
     // automatic detection of the text qualifier
     CCSVParserTextQualifier AnalyseTextQualifier(const CChar* buffer, TDirectArray<WORD>* rows);
 
@@ -156,6 +326,8 @@ public:
 
     virtual CCSVParserStatus FetchRecord(DWORD index) { return parser.FetchRecord(index); };
     virtual void* GetCellText(DWORD index, size_t* textLen);
+    virtual BOOL IsIndexing() { return parser.IsIndexing(); };
+    virtual BOOL RefreshIndex() { return parser.RefreshIndex(); };
 
 private:
     CCSVParser<char> parser;
@@ -64,86 +64,12 @@ BOOL CDatabase::Open(const char* fileName)
         if (status == psOK)
         {
             Columns.DestroyMembers();
-
-            CDatabaseColumn column;
-            CFieldInfo fieldInfo;
-
-            char type[100];
-            fieldInfo.Type = type;
-
-            HDC hDC = GetDC(NULL);
-            HFONT oldFont = (HFONT)SelectObject(hDC, Renderer->HFont);
-            SIZE sz;
-
-            int skippedColumns = 0;
-            DWORD i;
-            for (i = 0; i < Parser->GetFieldCount(); i++)
+            if (!AddColumns(0))
             {
-                // retrieve the required buffer size for the column name
-                fieldInfo.Name = NULL;
-                if (!Parser->GetFieldInfo(i, &fieldInfo))
-                    break;
-
-                fieldInfo.Name = (char*)malloc(fieldInfo.NameMax);
-                if (fieldInfo.Name == NULL)
-                {
-                    Parser->ShowParserError(Renderer->HWindow, psOOM);
-                    break;
-                }
-                column.Type = SalGeneral->DupStr(type);
-                if (column.Type == NULL)
-                {
-                    Parser->ShowParserError(Renderer->HWindow, psOOM);
-                    break;
-                }
-
-                // retrieve the column name
-                Parser->GetFieldInfo(i, &fieldInfo);
-
-                column.Name = fieldInfo.Name;
-                column.LeftAlign = fieldInfo.LeftAlign;
-                column.Length = fieldInfo.TextMax;
-                column.FieldLen = fieldInfo.FieldLen;
-                column.Decimals = fieldInfo.Decimals;
-
-                // compute the column width from the number of characters in the column
-                // if the column header is wider, use that instead
-                if (!IsUnicode)
-                    GetTextExtentPoint32A(hDC, column.Name, (int)strlen(column.Name), &sz);
-                else
-                    GetTextExtentPoint32W(hDC, (LPWSTR)column.Name, (int)wcslen((LPWSTR)column.Name), &sz);
-                column.Width = sz.cx;
-
-                // if the parser can estimate the maximum number of characters, estimate the column width
-                if (fieldInfo.TextMax > 0)
-                {
-                    int width = Renderer->CharAvgWidth * fieldInfo.TextMax;
-                    if (width > column.Width)
-                        column.Width = width;
-                }
-                column.Width += 2 * Renderer->LeftTextMargin + 1;
-
-                column.OriginalIndex = i;
-                column.Visible = TRUE;
-
-                Columns.Add(column);
-                if (!Columns.IsGood())
-                {
-                    Columns.ResetState();
-                    free(column.Name);
-                    SelectObject(hDC, oldFont);
-                    ReleaseDC(NULL, hDC);
-                    Close();
-                    ret = FALSE;
-                    Parser->ShowParserError(Renderer->HWindow, psOOM);
-                    break;
-                }
-                ColumnsDirty = TRUE;
+                Close();
+                return FALSE;
             }
 
-            SelectObject(hDC, oldFont);
-            ReleaseDC(NULL, hDC);
-
             FileName = SalGeneral->DupStr(fileName);
             if (FileName == NULL)
             {
@@ -181,6 +107,87 @@ BOOL CDatabase::Open(const char* fileName)
     return ret;
 }
 
+BOOL CDatabase::AddColumns(DWORD first)
+{
+    BOOL ret = TRUE;
+    CDatabaseColumn column;
+    CFieldInfo fieldInfo;
+
+    char type[100];
+    fieldInfo.Type = type;
+
+    HDC hDC = GetDC(NULL);
+    HFONT oldFont = (HFONT)SelectObject(hDC, Renderer->HFont);
+    SIZE sz;
+
+    int skippedColumns = 0;
+    DWORD i;
+    for (i = first; i < Parser->GetFieldCount(); i++)
+    {
+        // retrieve the required buffer size for the column name
+        fieldInfo.Name = NULL;
+        if (!Parser->GetFieldInfo(i, &fieldInfo))
+            break;
+
+        fieldInfo.Name = (char*)malloc(fieldInfo.NameMax);
+        if (fieldInfo.Name == NULL)
+        {
+            Parser->ShowParserError(Renderer->HWindow, psOOM);
+            break;
+        }
+        column.Type = SalGeneral->DupStr(type);
+        if (column.Type == NULL)
+        {
+            Parser->ShowParserError(Renderer->HWindow, psOOM);
+            break;
+        }
+
+        // retrieve the column name
+        Parser->GetFieldInfo(i, &fieldInfo);
+
+        column.Name = fieldInfo.Name;
+        column.LeftAlign = fieldInfo.LeftAlign;
+        column.Length = fieldInfo.TextMax;
+        column.FieldLen = fieldInfo.FieldLen;
+        column.Decimals = fieldInfo.Decimals;
+
+        // compute the column width from the number of characters in the column
+        // if the column header is wider, use that instead
+        if (!IsUnicode)
+            GetTextExtentPoint32A(hDC, column.Name, (int)strlen(column.Name), &sz);
+        else
+            GetTextExtentPoint32W(hDC, (LPWSTR)column.Name, (int)wcslen((LPWSTR)column.Name), &sz);
+        column.Width = sz.cx;
+
+        // if the parser can estimate the maximum number of characters, estimate the column width
+        if (fieldInfo.TextMax > 0)
+        {
+            int width = Renderer->CharAvgWidth * fieldInfo.TextMax;
+            if (width > column.Width)
+                column.Width = width;
+        }
+        column.Width += 2 * Renderer->LeftTextMargin + 1;
+
+        column.OriginalIndex = i;
+        column.Visible = TRUE;
+
+        Columns.Add(column);
+        if (!Columns.IsGood())
+        {
+            Columns.ResetState();
+            free(column.Name);
+            Parser->ShowParserError(Renderer->HWindow, psOOM);
+            ret = FALSE;
+            break;
+        }
+        ColumnsDirty = TRUE;
+    }
+
+    SelectObject(hDC, oldFont);
+    ReleaseDC(NULL, hDC);
+    return ret;
+}
+
 void CDatabase::Close()
 {
     if (FileName != NULL)
@@ -235,6 +242,34 @@ int CDatabase::GetRowCount()
     return Parser->GetRecordCount();
 }
 
+BOOL CDatabase::IsIndexing()
+{
+    return Parser != NULL && Parser->IsIndexing();
+}
+
+BOOL CDatabase::RefreshIndex()
+{
+    if (Parser == NULL || !Parser->RefreshIndex())
+        return FALSE;
+
+    // the longest text of already known columns may have grown; the search relies
+    // on Length, the widths stay as they are so the table does not jump under the user
+    CFieldInfo fieldInfo;
+    int i;
+    for (i = 0; i < Columns.Count; i++)
+    {
+        CDatabaseColumn* column = &Columns[i];
+        fieldInfo.Name = NULL;
+        fieldInfo.Type = NULL;
+        if (Parser->GetFieldInfo(column->OriginalIndex, &fieldInfo))
+            column->Length = fieldInfo.TextMax;
+    }
+    // append columns found in the rest of the file
+    if ((DWORD)Columns.Count < Parser->GetFieldCount())
+        AddColumns(Columns.Count);
+    return TRUE;
+}
+
 void CDatabase::UpdateColumnsInfo()
 {
     if (ColumnsDirty)
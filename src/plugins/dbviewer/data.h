@@ -55,6 +55,10 @@ private:
     int VisibleColumnCount;
     int VisibleColumnsWidth;
 
+    // append columns from 'first' to the last column of the parser; returns FALSE
+    // if a column could not be stored (the error has already been shown)
+    BOOL AddColumns(DWORD first);
+
 public:
     CDatabase();
     ~CDatabase();
@@ -68,6 +72,11 @@ public:
     // return TRUE if the database is open and all variables are initialized
     BOOL IsOpened() { return Parser != NULL; }
 
+    // TRUE while the parser is still indexing the rest of the file in the background
+    BOOL IsIndexing();
+    // take over the rows and columns indexed so far; returns TRUE if the table changed
+    BOOL RefreshIndex();
+
     // "", "dbf", "csv"
     const char* GetParserName();
 
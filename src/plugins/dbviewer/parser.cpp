@@ -1156,3 +1156,13 @@ BOOL CParserInterfaceCSV::IsRecordDeleted()
     // the CSV format does not support this state
     return FALSE;
 }
+
+BOOL CParserInterfaceCSV::IsIndexing()
+{
+    return Csv != NULL && Csv->IsIndexing();
+}
+
+BOOL CParserInterfaceCSV::RefreshIndex()
+{
+    return Csv != NULL && Csv->RefreshIndex();
+}
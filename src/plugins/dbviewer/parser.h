@@ -81,6 +81,13 @@ public:
     // called after FetchRecord and returns TRUE if the row is marked as deleted
     virtual BOOL IsRecordDeleted() = 0;
 
+    // returns TRUE while the rest of the file is indexed in the background
+    virtual BOOL IsIndexing() { return FALSE; }
+
+    // takes over rows and columns indexed in the background; returns TRUE if
+    // GetRecordCount, GetFieldCount or GetFieldInfo results have changed
+    virtual BOOL RefreshIndex() { return FALSE; }
+
     void ShowParserError(HWND hParent, CParserStatusEnum status);
 
 protected:
@@ -170,6 +177,8 @@ public:
     virtual const char* GetCellText(DWORD index, size_t* textLen);
     virtual const wchar_t* GetCellTextW(DWORD index, size_t* textLen);
     virtual BOOL IsRecordDeleted();
+    virtual BOOL IsIndexing();
+    virtual BOOL RefreshIndex();
 
 private:
     // helpers
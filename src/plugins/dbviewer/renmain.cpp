@@ -15,6 +15,7 @@
 #define GET_Y_LPARAM(lp) ((int)(short)HIWORD(lp))
 
 #define TIMER_SCROLL_ID 1
+#define TIMER_INDEX_ID 2 // polls the parser while it indexes the rest of the file
 
 BOOL IsAlphaNumeric[256]; // TRUE/FALSE table for characters (FALSE = neither a letter nor a digit)
 BOOL IsAlpha[256];
@@ -327,6 +328,10 @@ BOOL CRendererWindow::OpenFile(const char* name, BOOL useDefaultConfig)
     SetupScrollBars();
     InvalidateRect(HWindow, NULL, TRUE);
 
+    // a large CSV file is shown as soon as its beginning is indexed, the rest comes later
+    if (Database.IsIndexing())
+        SetTimer(HWindow, TIMER_INDEX_ID, 250, NULL);
+
     Viewer->UpdateEnablers();
 
     return ret;
@@ -1094,6 +1099,19 @@ void CRendererWindow::OnTimer(WPARAM wParam)
         if (xDelta != 0 || yDelta != 0)
             PostMessage(HWindow, WM_MOUSEMOVE, MK_LBUTTON | MK_RBUTTON, MAKEWPARAM(p.x, p.y));
     }
+    else if (wParam == TIMER_INDEX_ID)
+    {
+        if (Database.RefreshIndex())
+        {
+            int focusX, focusY;
+            Selection.GetFocus(&focusX, &focusY);
+            Viewer->UpdateRowNumberOnToolBar(Database.GetRowCount() ? focusY : -1, Database.GetRowCount());
+            SetupScrollBars();
+            InvalidateRect(HWindow, NULL, FALSE);
+        }
+        if (!Database.IsIndexing())
+            KillTimer(HWindow, TIMER_INDEX_ID);
+    }
 }
 
 void CRendererWindow::OnVScroll(int scrollCode, int pos)
@@ -14,6 +14,8 @@ const TCHAR szDiskMapViewClass[] = TEXT("Zar.DM.DMView.WC");
 #define IDT_ANIMTIMER 1
 #define ANIMTIMER_TIME 10
 
+#define PARTIALMAP_TIME 1000 //minimal time between two maps shown while populating (ms)
+
 class CLogger;
 
 class CDiskMapView : public CChildWindow
@@ -47,6 +49,9 @@ protected:
 
     BOOL _tooltipEnabled;
 
+    DWORD _partialTime; //when the last partial map was shown (or populating started)
+    DWORD _partialWait; //time until the next one, longer when preparing the map takes long
+
     HWND DoCreate(int left, int top, int width, int height)
     {
         return MyCreateWindow(
@@ -336,6 +341,21 @@ protected:
                 this->Repaint();
             }
         }
+        if (this->_diskmap && this->_diskmap->CanAbort() && GetTickCount() - this->_partialTime >= this->_partialWait)
+        {
+            //show what has been read so far, the map grows until populating finishes
+            DWORD start = GetTickCount();
+            if (this->_diskmap->ShowPartial())
+            {
+                if (this->_anim)
+                    delete this->_anim;
+                this->_anim = NULL;
+                this->_loadAnim = NULL;
+                this->UpdateMapView();
+            }
+            this->_partialTime = GetTickCount();
+            this->_partialWait = max((DWORD)PARTIALMAP_TIME, 4 * (this->_partialTime - start));
+        }
     }
     CCushionHitInfo* SelectCushionByPos(int x, int y)
     {
@@ -445,6 +465,9 @@ public:
 
         this->_tooltipEnabled = TRUE;
 
+        this->_partialTime = 0;
+        this->_partialWait = PARTIALMAP_TIME;
+
         //CTreeMapRendererBase *renderer = new CTreeMapRendererBase(dsSquare);
         //CTreeMapRendererBase *renderer = new CTreeMapRendererMaxRatio(dsSquare, 0);//Sequoia
         //CTreeMapRendererBase *renderer = new CTreeMapRendererMaxRatio(dsLonger, 2.5);KDirStat
@@ -713,7 +736,7 @@ public:
         }
         return FALSE;
     }
-    BOOL UpdateFileList()
+    BOOL UpdateFileList(BOOL rescan = FALSE) //rescan: read only the directories changed since the last time
     {
         if (this->_diskmap)
         {
@@ -726,13 +749,16 @@ public:
                 this->_loadAnim = new CLoadAnimation();
                 this->_anim = this->_loadAnim;
 
+                this->_partialTime = GetTickCount();
+                this->_partialWait = PARTIALMAP_TIME;
+
 #ifdef SALAMANDER
                 int cs = 512;
                 if (this->_connector->GetSalamander() != NULL)
                     cs = this->_connector->GetSalamander()->GetClusterSize(this->_path->GetString());
-                this->_diskmap->PopulateAsync(this->_path->GetString(), this->_path->GetLength(), cs);
+                this->_diskmap->PopulateAsync(this->_path->GetString(), this->_path->GetLength(), cs, FILESIZE_DISK, rescan);
 #else
-                this->_diskmap->PopulateAsync(this->_path->GetString(), this->_path->GetLength());
+                this->_diskmap->PopulateAsync(this->_path->GetString(), this->_path->GetLength(), FILESIZE_DISK, rescan);
 #endif
 
                 return TRUE;
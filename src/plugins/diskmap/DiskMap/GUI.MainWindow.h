@@ -194,7 +194,11 @@ protected:
             return TRUE;
         case IDM_FILE_REFRESH:
             this->_logger->Clear();
-            this->_diskMap->UpdateFileList();
+            this->_diskMap->UpdateFileList(TRUE);
+            return TRUE;
+        case IDM_FILE_RESCAN: //reads all directories again, the time stamps of directories need not show every change
+            this->_logger->Clear();
+            this->_diskMap->UpdateFileList(FALSE);
             return TRUE;
         case IDM_FILE_OPEN:
             this->_diskMap->OpenSelectedFile();
@@ -244,7 +248,9 @@ protected:
             BOOL isFileSelected = this->_diskMap->IsFileSelected();
             EnableMenuItem(hMenu, IDM_FILE_OPEN, MF_BYCOMMAND | (isFileSelected ? MF_ENABLED : MF_GRAYED));
             EnableMenuItem(hMenu, IDM_FILE_ABORT, MF_BYCOMMAND | (this->_diskMap->CanAbort() ? MF_ENABLED : MF_GRAYED));
-            EnableMenuItem(hMenu, IDM_FILE_REFRESH, MF_BYCOMMAND | (this->_diskMap->CanPopulate() ? MF_ENABLED : MF_GRAYED));
+            BOOL canPopulate = this->_diskMap->CanPopulate();
+            EnableMenuItem(hMenu, IDM_FILE_REFRESH, MF_BYCOMMAND | (canPopulate ? MF_ENABLED : MF_GRAYED));
+            EnableMenuItem(hMenu, IDM_FILE_RESCAN, MF_BYCOMMAND | (canPopulate ? MF_ENABLED : MF_GRAYED));
             EnableMenuItem(hMenu, IDM_VIEW_ZOOMIN, MF_BYCOMMAND | (this->_diskMap->CanZoomIn() ? MF_ENABLED : MF_GRAYED));
             BOOL canZoomOut = this->_diskMap->CanZoomOut();
             EnableMenuItem(hMenu, IDM_VIEW_ZOOMOUT, MF_BYCOMMAND | (canZoomOut ? MF_ENABLED : MF_GRAYED));
@@ -340,7 +346,7 @@ protected:
             this->_diskMap->ZoomIn();
             return TRUE;
         case APPCOMMAND_BROWSER_REFRESH:
-            this->_diskMap->UpdateFileList();
+            this->_diskMap->UpdateFileList(TRUE);
             return TRUE;
         case APPCOMMAND_BROWSER_STOP:
             this->_diskMap->Abort();
@@ -294,9 +294,9 @@ public:
     }
     //FIXME: clustersize hack
 #ifdef SALAMANDER
-    void PopulateAsync(TCHAR const* name, size_t namelen, int clustersize, int sortorder = FILESIZE_DISK)
+    void PopulateAsync(TCHAR const* name, size_t namelen, int clustersize, int sortorder = FILESIZE_DISK, BOOL rescan = FALSE)
 #else
-    void PopulateAsync(TCHAR const* name, size_t namelen = 0, int sortorder = FILESIZE_DISK)
+    void PopulateAsync(TCHAR const* name, size_t namelen = 0, int sortorder = FILESIZE_DISK, BOOL rescan = FALSE)
 #endif
 
     {
@@ -315,12 +315,20 @@ public:
         //this->_selectedCushion = NULL;
         //this->_selectedOverlay->ClearCushion();
 
+        //when rescanning, only the directories changed since the previous scan are read
+        CZRoot* previous = NULL;
+        if (rescan && this->_populateworker == NULL && this->_rootdir != NULL && _tcscmp(this->_rootdir->GetName(), name) == 0)
+        {
+            previous = this->_rootdir;
+            this->_rootdir = NULL;
+        }
+
         if (this->_rootdir)
             delete this->_rootdir;
         this->_rootdir = NULL;
         this->_viewdir = NULL;
 
-        this->_rootdir = new CZRoot(name, this->_logger, sortorder);
+        this->_rootdir = new CZRoot(name, this->_logger, sortorder, previous);
 #ifdef SALAMANDER
         this->_rootdir->SetClusterSize(clustersize);
 #endif
@@ -336,7 +344,8 @@ public:
         {
             delete this->_populateworker;
             this->_populateworker = NULL;
-            this->_viewdir = this->_rootdir;
+            if (this->_viewdir == NULL) //may be zoomed in already in the partial map
+                this->_viewdir = this->_rootdir;
         }
         else
         {
@@ -345,6 +354,20 @@ public:
         }
     }
 
+    BOOL ShowPartial() //while populating: returns TRUE if the map of what has been read so far can be shown
+    {
+        if (this->_populateworker == NULL || this->_rootdir == NULL)
+            return FALSE;
+        int filecount, dircount;
+        INT64 size;
+        this->_rootdir->GetStats(filecount, dircount, size);
+        if (size <= 0)
+            return FALSE;
+        if (this->_viewdir == NULL)
+            this->_viewdir = this->_rootdir;
+        return TRUE;
+    }
+
     BOOL GetDirectoryOverlayVisibility()
     {
         return this->_directoryOverlayVisible;
@@ -401,6 +424,10 @@ public:
         }
         if (this->_map)
         {
+            //the scanning threads keep adding to the tree until it is populated
+            CRWLock* lock = (this->_populateworker != NULL) ? this->_rootdir->GetRWLock() : NULL;
+            if (lock)
+                lock->EnterRead();
 
 #ifdef TIMINGTEST
             LARGE_INTEGER lt1, lt2, lf;
@@ -410,6 +437,9 @@ public:
 
             this->_map->Prepare(FILESIZE_DISK); //TODO: optimize!
 
+            if (lock)
+                lock->LeaveRead();
+
 #ifdef TIMINGTEST
             QueryPerformanceCounter(&lt2);
             this->_calctime = (double)(lt2.QuadPart - lt1.QuadPart) / lf.QuadPart;
@@ -583,6 +613,7 @@ public:
             return FALSE;
 
         this->_rootdir = NULL;
+        this->_viewdir = NULL; //the partial map goes away with the root
         this->_populateworker = NULL;
         wrk->SetSelfDelete(TRUE);
         wrk->Abort(TRUE); //TODO: do I really want to wait?
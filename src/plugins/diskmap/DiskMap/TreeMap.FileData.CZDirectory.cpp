@@ -118,230 +118,53 @@ void CZDirectory::TEST()
     }
 }
 
-INT64 CZDirectory::PopulateDir(CWorkerThread* mythread, TCHAR* path, int pos, size_t pathsize)
+void CZDirectory::SortFiles(TAutoIndirectArray<CZFile>* files, int sortorder)
 {
-    if (this->_root == NULL)
-        Beep(1000, 100);
-    if (pathsize < 2 * MAX_PATH)
-        Beep(1000, 100);
-
-    WIN32_FIND_DATA FindFileData;
-    HANDLE hFind = INVALID_HANDLE_VALUE;
-    DWORD dwError;
-
-    int dircount = 0;
-    int filecount = 0;
-    INT64 tsize = 0;
-
-    int sortorder = this->_root->GetSortOrder();
-
-    //append the current name
-    if ((pos + this->_namelen + 1) < pathsize)
-    {
-        if (pos && path[pos - 1] != TEXT('\\'))
-        {
-            path[pos] = TEXT('\\');
-            pos++;
-        }
-        _tcscpy(path + pos, this->_name);
-        pos += (int)this->_namelen;
-    }
-    if (!pos || path[pos - 1] != TEXT('\\'))
-        path[pos++] = TEXT('\\');
-
-    //check the length
-    if (pos >= MAX_PATH)
+    int cnt = files->GetCount();
+    for (int i = 1; i < cnt; i++)
     {
-        //ERROR
-        this->_root->Log(LOG_ERROR, TEXT("Path is too long."), this);
-        return -1;
-    }
-
-    TCHAR* filepart = &path[pos]; //pointer to the start of the area for appending the file name
+        CZFile* f = files->At(i);
+        INT64 sortsize = f->GetSizeEx(sortorder);
 
-    path[pos] = TEXT('*');
-    path[pos + 1] = TEXT('\0');
-    /*
-	int radixHistorgram[2048 * 6];
-	radixHistorgram[0] = 0;
-	for (int i = 1; i < 2048 * 6; i++)
-	{
-		radixHistorgram[i] = radixHistorgram[i - 1] + 1;
-	}
-	path[MAX_PATH] = (char)radixHistorgram[2048];
-*/
-    hFind = FindFirstFile(path, &FindFileData);
-    if (hFind == INVALID_HANDLE_VALUE)
-    {
-        //ERROR
-        this->_root->LogLastError(this);
-        return -1;
-    }
-    else
-    {
-        DWORD lastTime = GetTickCount();
-        do
+        int fre = i;
+        while (fre > 0)
         {
-            if (FindFileData.cFileName[0] == '.' && (FindFileData.cFileName[1] == '\0' || (FindFileData.cFileName[1] == '.' && FindFileData.cFileName[2] == '\0')))
-                continue;
-            INT64 datasize = 0;
-            INT64 realsize = 0;
-            INT64 disksize = 0;
-
-            CZFile* f = NULL;
-            if ((FindFileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+            int parent = (fre - 1) / 2;
+            if (files->At(parent)->GetSizeEx(sortorder) > sortsize) //if the parent is larger, it violates the MIN-HEAP
             {
-                if ((FindFileData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) == 0)
-                {
-                    f = new CZDirectory(this, FindFileData.cFileName, &FindFileData.ftCreationTime, &FindFileData.ftLastWriteTime);
-                    datasize = ((CZDirectory*)f)->PopulateDir(mythread, path, pos, pathsize);
-                    if (datasize < 0) //error!
-                    {
-                        //this->_root->Log(LOG_ERROR, TEXT("Negative size of directory contents."), f);
-                        delete f;
-                        f = NULL;
-                        datasize = 0;
-                        realsize = 0;
-                        disksize = 0;
-                    }
-                    else if (datasize == 0) //everything ok, but empty
-                    {
-                        this->_dircount++;
-                        dircount++;
-                        this->_dircount += ((CZDirectory*)f)->GetSubDirsCount(); //count empty ones so we match Explorer's results
-                        this->_filecount += ((CZDirectory*)f)->GetSubFileCount();
-
-                        delete f;
-                        f = NULL;
-                        datasize = 0;
-                        realsize = 0;
-                        disksize = 0;
-                    }
-                    else
-                    {
-                        this->_dircount++;
-                        dircount++;
-                        datasize = f->GetSizeEx(FILESIZE_DATA);
-                        realsize = f->GetSizeEx(FILESIZE_REAL);
-                        disksize = f->GetSizeEx(FILESIZE_DISK);
-                        this->_dircount += ((CZDirectory*)f)->GetSubDirsCount();
-                        this->_filecount += ((CZDirectory*)f)->GetSubFileCount();
-                    }
-                }
-                else
-                {
-                    f = new CZDirectory(this, FindFileData.cFileName, &FindFileData.ftCreationTime, &FindFileData.ftLastWriteTime);
-                    this->_root->Log(LOG_WARNING, TEXT("Ignoring Reparse Point."), f);
-                    delete f;
-                    f = NULL;
-                }
+                files->Copy(fre, parent);
+                fre = parent;
             }
             else
             {
-                datasize = ((INT64)FindFileData.nFileSizeHigh * ((INT64)(MAXDWORD) + 1)) + FindFileData.nFileSizeLow;
-                if ((FindFileData.dwFileAttributes & (FILE_ATTRIBUTE_SPARSE_FILE | FILE_ATTRIBUTE_COMPRESSED)) != 0)
-                {
-                    DWORD lo, hi;
-                    _tcscpy(filepart, FindFileData.cFileName);
-                    lo = GetCompressedFileSize(path, &hi);
-                    if (lo == INVALID_FILE_SIZE)
-                    {
-                        //ErrorExit(FindFileData.cFileName);
-                        realsize = datasize;
-                    }
-                    else
-                    {
-                        realsize = ((INT64)hi * ((INT64)(MAXDWORD) + 1)) + lo;
-                    }
-                }
-                else
-                {
-                    realsize = datasize;
-                }
-                //always count them so we match Explorer's numbers
-                this->_filecount++;
-                filecount++;
-                if (datasize > 0)
-                {
-                    disksize = this->_root->GetDiskSize(realsize);
-
-                    f = new CZFile(this, FindFileData.cFileName, datasize, realsize, disksize, &FindFileData.ftCreationTime, &FindFileData.ftLastWriteTime);
-                    tsize += f->GetSizeEx(sortorder);
-                }
+                break;
             }
-            if (datasize > 0)
-            {
-                this->_datasize += datasize;
-                this->_realsize += realsize;
-                this->_disksize += disksize;
-
-                INT64 sortsize = f->GetSizeEx(sortorder);
+        }
+        files->At(fre) = f;
+    }
 
-                int fre = this->_files->Add(f);
-                while (fre > 0)
-                {
-                    int parent = (fre - 1) / 2;
-                    if (this->_files->At(parent)->GetSizeEx(sortorder) > sortsize) //if the parent is larger, it violates the MIN-HEAP
-                    {
-                        this->_files->Copy(fre, parent);
-                        fre = parent;
-                    }
-                    else
-                    {
-                        break;
-                    }
-                }
-                this->_files->At(fre) = f;
-            }
-            //if (((filecount + dircount) > MAXREPORTEDFILES) || (GetTickCount() - lastTime > 500)) //either many files or 0.5 sec elapsed
-            if ((GetTickCount() - lastTime > 250) && (filecount + dircount) > 0) //if 0.25 sec elapsed and at least something new was found
+    for (int i = 1; i <= cnt; i++)
+    {
+        int end = cnt - i;
+        CZFile* f = files->At(end);
+        files->Copy(end, 0);
+        int fre = 0;
+        end--;
+        while (fre * 2 + 1 <= end)
+        {
+            int child = fre * 2 + 1; //left
+            if ((child < end) && (files->At(child)->GetSizeEx(sortorder) > files->At(child + 1)->GetSizeEx(sortorder)))
+                child++;
+            if (files->At(child)->GetSizeEx(sortorder) < f->GetSizeEx(sortorder)) //if the child is smaller, it violates the MIN-HEAP
             {
-                this->_root->IncStats(filecount, dircount, tsize);
-                lastTime = GetTickCount();
-                dircount = 0;
-                filecount = 0;
-                tsize = 0;
+                files->Copy(fre, child);
+                fre = child;
             }
-        } while ((FindNextFile(hFind, &FindFileData) != 0) && (mythread == NULL || !mythread->Aborting()));
-
-        this->_root->IncStats(filecount, dircount, tsize);
-
-        dwError = GetLastError();
-        FindClose(hFind);
-
-        int cnt = this->_files->GetCount();
-        for (int i = 1; i <= cnt; i++)
-        {
-            int end = cnt - i;
-            CZFile* f = this->_files->At(end);
-            this->_files->Copy(end, 0);
-            int fre = 0;
-            end--;
-            while (fre * 2 + 1 <= end)
+            else
             {
-                int child = fre * 2 + 1; //left
-                if ((child < end) && (this->_files->At(child)->GetSizeEx(sortorder) > this->_files->At(child + 1)->GetSizeEx(sortorder)))
-                    child++;
-                if (this->_files->At(child)->GetSizeEx(sortorder) < f->GetSizeEx(sortorder)) //if the child is smaller, it violates the MIN-HEAP
-                {
-                    this->_files->Copy(fre, child);
-                    fre = child;
-                }
-                else
-                {
-                    break;
-                }
+                break;
             }
-            this->_files->At(fre) = f;
-        }
-
-        if (dwError != ERROR_NO_MORE_FILES)
-        {
-            //ERROR
-            this->_root->LogError(this, dwError);
-            return -1;
         }
+        files->At(fre) = f;
     }
-
-    return this->_realsize;
 }
\ No newline at end of file
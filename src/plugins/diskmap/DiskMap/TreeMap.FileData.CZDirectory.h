@@ -18,14 +18,24 @@ class CZRoot;
 class CZDirectory : public CZFile
 {
 protected:
+    friend class CZScanner;
+
     TAutoIndirectArray<CZFile>* _files;
 
     int _filecount;
     int _dircount;
+    int _ownfilecount; //files right in the directory, including the empty ones
 
     CZRoot* _root;
 
-    INT64 PopulateDir(CWorkerThread* mythread, TCHAR* path, int pos, size_t pathsize);
+    //used by CZScanner while the directory is being read
+    CZDirectory* _base;     //the same directory in the previous scan (rescan), or NULL
+    volatile LONG _pending; //the directory itself and its subdirectories not read yet
+    BOOL _failed;           //the directory could not be read
+    FILETIME _scantime;     //last write time of the directory itself read before its entries (zero = unknown)
+
+    //sorts the files from the largest to the smallest
+    static void SortFiles(TAutoIndirectArray<CZFile>* files, int sortorder);
 
     CZDirectory(CZDirectory* parent, TCHAR const* name, FILETIME* createtime, FILETIME* modifytime) : CZFile(parent, name, 0, 0, 0, createtime, modifytime)
     {
@@ -33,6 +43,13 @@ protected:
 
         this->_filecount = 0;
         this->_dircount = 0;
+        this->_ownfilecount = 0;
+
+        this->_base = NULL;
+        this->_pending = 0;
+        this->_failed = FALSE;
+        this->_scantime.dwLowDateTime = 0;
+        this->_scantime.dwHighDateTime = 0;
 
         if (parent != NULL)
         {
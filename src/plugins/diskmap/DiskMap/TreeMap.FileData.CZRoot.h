@@ -8,6 +8,7 @@
 #include "System.WorkerThread.h"
 #include "TreeMap.FileData.CZFile.h"
 #include "TreeMap.FileData.CZDirectory.h"
+#include "TreeMap.FileData.CZScanner.h"
 #include "System.CLogger.h"
 #include "Utils.CZString.h"
 
@@ -24,6 +25,7 @@ class CZRoot : public CZDirectory
 {
 protected:
     friend class CZDirectory;
+    friend class CZScanner;
 
     int _sortorder;
 
@@ -37,13 +39,22 @@ protected:
     int _clustersize;
     int _minimalfilesize; //determine whether NTFS, because then it equals 512
 
-    CRWLock* GetRWLock() { return this->_lock; }
+    CZRoot* _previous; //result of the previous scan of the same path, only the changed directories are read again
+
+    void DropPrevious()
+    {
+        if (this->_previous)
+            delete this->_previous;
+        this->_previous = NULL;
+        this->_base = NULL;
+    }
 
     static DWORD_PTR WINAPI PopulateThreadProc(CWorkerThread* mythread, LPVOID lpParam)
     {
         CZRoot* self = (CZRoot*)lpParam;
-        TCHAR path[2 * MAX_PATH + 3]; //fits a MAX_PATH path + MAX_PATH-long file name + some margin
-        self->PopulateDir(mythread, path, 0, ARRAYSIZE(path));
+        CZScanner scanner(self, mythread);
+        scanner.Run(CZScanner::GetThreadCount());
+        self->DropPrevious();
         if (mythread->Aborting() && mythread->IsSelfDelete())
         {
             delete self;
@@ -86,7 +97,7 @@ protected:
     }
 
 public:
-    CZRoot(TCHAR const* name, CLogger* logger, int sortorder = FILESIZE_DISK) : CZDirectory(NULL, name, NULL, NULL)
+    CZRoot(TCHAR const* name, CLogger* logger, int sortorder = FILESIZE_DISK, CZRoot* previous = NULL) : CZDirectory(NULL, name, NULL, NULL)
     {
         this->_clustersize = 0;
         this->_minimalfilesize = 0; //TODO: pro NTFS = 512
@@ -102,13 +113,21 @@ public:
         this->_logger = logger;
 
         this->_root = this;
+
+        this->_previous = previous;
+        this->_base = previous;
     }
     virtual ~CZRoot()
     {
+        this->DropPrevious();
         delete this->_lock;
     }
     int GetSortOrder() { return this->_sortorder; }
 
+    //the scanning threads change the tree only inside the write lock; hold the read lock
+    //while walking the tree before the population finishes
+    CRWLock* GetRWLock() { return this->_lock; }
+
     //FIXME: toto je hack :(
     void SetClusterSize(int clustersize)
     {
@@ -156,8 +175,10 @@ public:
 
     INT64 SyncPopulate()
     {
-        TCHAR path[2 * MAX_PATH + 3]; //fits a MAX_PATH path + MAX_PATH-long file name + some margin
-        return this->PopulateDir(NULL, path, 0, ARRAYSIZE(path));
+        CZScanner scanner(this, NULL);
+        INT64 res = scanner.Run(1);
+        this->DropPrevious();
+        return res;
     }
 
     CWorkerThread* BeginAsyncPopulate(HWND owner, UINT msg)
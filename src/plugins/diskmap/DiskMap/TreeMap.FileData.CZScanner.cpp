@@ -0,0 +1,503 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "precomp.h"
+#include "TreeMap.FileData.CZScanner.h"
+#include "TreeMap.FileData.CZRoot.h"
+
+static int CompareDirs(const void* a, const void* b)
+{
+    return _tcscmp((*(CZDirectory**)a)->GetName(), (*(CZDirectory**)b)->GetName());
+}
+
+static int CompareDirName(const void* name, const void* dir)
+{
+    return _tcscmp((TCHAR const*)name, (*(CZDirectory**)dir)->GetName());
+}
+
+CZScanner::CZScanner(CZRoot* root, CWorkerThread* thread)
+{
+    this->_root = root;
+    this->_thread = thread;
+    this->_sortorder = root->GetSortOrder();
+    this->_incremental = FALSE;
+
+    this->_threadcount = 0;
+    this->_lastid = 0;
+
+    this->_outstanding = 0;
+    this->_idle = 0;
+    this->_stop = FALSE;
+    this->_workready = NULL;
+}
+
+CZScanner::~CZScanner()
+{
+    if (this->_workready != NULL)
+        CloseHandle(this->_workready);
+}
+
+int CZScanner::GetThreadCount()
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    //the threads mostly wait for the disk or the file server, so there are more of them than processors
+    return max(1, min(SCANNER_MAX_THREADS, 2 * (int)si.dwNumberOfProcessors));
+}
+
+INT64 CZScanner::Run(int threads)
+{
+    //find out the cluster size before the threads share it
+    this->_root->GetDiskSize(1);
+
+    //without reliable time stamps everything is read again
+    this->_incremental = this->CheckIncremental();
+    if (!this->_incremental)
+        this->_root->_base = NULL;
+
+    this->_threadcount = max(1, min(SCANNER_MAX_THREADS, threads));
+    if (this->_threadcount > 1)
+    {
+        this->_workready = CreateSemaphore(NULL, 0, 0x7FFFFFFF, NULL);
+        if (this->_workready == NULL)
+            this->_threadcount = 1;
+    }
+
+    this->_root->_pending = 1;
+    this->_outstanding = 1;
+    if (!this->_queues[0].Push(this->_root))
+        return -1;
+
+    int started = 0;
+    for (int i = 1; i < this->_threadcount; i++)
+    {
+        DWORD id;
+        this->_threads[started] = CreateThread(NULL, 0, CZScanner::s_ThreadProc, this, 0, &id);
+        if (this->_threads[started] != NULL)
+            started++;
+    }
+
+    this->Work(0);
+
+    if (started > 0)
+    {
+        WaitForMultipleObjects(started, this->_threads, TRUE, INFINITE);
+        for (int i = 0; i < started; i++)
+            CloseHandle(this->_threads[i]);
+    }
+
+    if (this->_root->_failed)
+        return -1;
+    return this->_root->GetSizeEx(FILESIZE_REAL);
+}
+
+unsigned WINAPI CZScanner::s_ThreadBody(void* param)
+{
+    CZScanner* self = (CZScanner*)param;
+    self->Work(InterlockedIncrement(&self->_lastid));
+    return 0;
+}
+
+DWORD WINAPI CZScanner::s_ThreadProc(LPVOID lpParam)
+{
+    return SalamanderDebug->CallWithCallStack(CZScanner::s_ThreadBody, lpParam);
+}
+
+BOOL CZScanner::CheckIncremental()
+{
+    TCHAR path[MAX_PATH + 1];
+    TCHAR volume[MAX_PATH + 1];
+    TCHAR fsname[MAX_PATH + 1];
+    size_t pos = this->_root->GetFullName(path, MAX_PATH - 2);
+    if (!pos)
+        return FALSE;
+    if (path[pos - 1] != TEXT('\\'))
+        path[pos++] = TEXT('\\');
+    path[pos] = TEXT('\0');
+    if (!GetVolumePathName(path, volume, ARRAYSIZE(volume)) ||
+        !GetVolumeInformation(volume, NULL, 0, NULL, NULL, NULL, fsname, ARRAYSIZE(fsname)))
+    {
+        return FALSE;
+    }
+    //only these keep the last write time of a directory in step with its entries
+    return _tcsicmp(fsname, TEXT("NTFS")) == 0 || _tcsicmp(fsname, TEXT("ReFS")) == 0;
+}
+
+void CZScanner::Stop()
+{
+    InterlockedExchange(&this->_stop, TRUE);
+    if (this->_workready != NULL)
+        ReleaseSemaphore(this->_workready, this->_threadcount, NULL);
+}
+
+void CZScanner::Work(int self)
+{
+    TCHAR path[2 * MAX_PATH + 3]; //fits a MAX_PATH path + MAX_PATH-long file name + some margin
+    TAutoIndirectArray<CZFile> files(ARRAY_BLOCKSIZE_CFILELIST, TRUE);
+
+    CZDirectory* dir;
+    while ((dir = this->GetWork(self)) != NULL)
+    {
+        this->ScanDir(self, dir, path, ARRAYSIZE(path), &files);
+        if (InterlockedDecrement(&this->_outstanding) == 0) //nothing is queued and nobody reads, so nothing will be queued
+            this->Stop();
+    }
+}
+
+CZDirectory* CZScanner::GetWork(int self)
+{
+    while (!this->_stop)
+    {
+        if (this->Aborting())
+        {
+            this->Stop();
+            break;
+        }
+
+        CZDirectory* dir = this->_queues[self].PopLast();
+        if (dir == NULL)
+            dir = this->Steal(self);
+        if (dir != NULL)
+            return dir;
+
+        //only this thread fills its queue, a new directory can appear only in the others;
+        //a thread queueing one after the check below sees _idle and wakes us up
+        InterlockedIncrement(&this->_idle);
+        dir = this->Steal(self);
+        if (dir == NULL && !this->_stop && this->_workready != NULL)
+            WaitForSingleObject(this->_workready, INFINITE);
+        InterlockedDecrement(&this->_idle);
+        if (dir != NULL)
+            return dir;
+    }
+    return NULL;
+}
+
+CZDirectory* CZScanner::Steal(int self)
+{
+    for (int i = 1; i < this->_threadcount; i++)
+    {
+        CZDirectory* dir = this->_queues[(self + i) % this->_threadcount].PopFirst();
+        if (dir != NULL)
+            return dir;
+    }
+    return NULL;
+}
+
+void CZScanner::Queue(int self, CZDirectory* dir)
+{
+    dir->_pending = 1;
+    InterlockedIncrement(&this->_outstanding);
+    if (!this->_queues[self].Push(dir))
+    {
+        //ERROR
+        this->_root->Log(LOG_ERROR, TEXT("Not enough memory."), dir);
+        dir->_failed = TRUE;
+        this->Complete(dir);
+        InterlockedDecrement(&this->_outstanding); //the directory of the caller is still outstanding
+        return;
+    }
+    if (this->_idle > 0)
+        ReleaseSemaphore(this->_workready, 1, NULL);
+}
+
+void CZScanner::ScanDir(int self, CZDirectory* dir, TCHAR* path, size_t pathsize, TAutoIndirectArray<CZFile>* files)
+{
+    size_t pos = dir->GetFullName(path, pathsize - 2);
+    if (!pos || path[pos - 1] != TEXT('\\'))
+        path[pos++] = TEXT('\\');
+
+    BOOL ok = FALSE;
+    int ownfiles = 0;
+
+    //check the length
+    if (pos >= MAX_PATH)
+    {
+        //ERROR
+        this->_root->Log(LOG_ERROR, TEXT("Path is too long."), dir);
+    }
+    else
+    {
+        //the time stamp of the directory itself is read before its entries, the one in the
+        //listing of the parent may not be current (NTFS updates it lazily); the root is
+        //always read
+        if (this->_incremental && dir->GetParent() != NULL &&
+            dir->_scantime.dwLowDateTime == 0 && dir->_scantime.dwHighDateTime == 0)
+        {
+            WIN32_FILE_ATTRIBUTE_DATA fad;
+            path[pos - 1] = TEXT('\0');
+            if (GetFileAttributesEx(path, GetFileExInfoStandard, &fad))
+                dir->_scantime = fad.ftLastWriteTime;
+            path[pos - 1] = TEXT('\\');
+        }
+
+        //nothing was added, removed or renamed in a directory keeping its time stamp
+        CZDirectory* base = dir->_base;
+        if (base != NULL && !base->_failed &&
+            (base->_scantime.dwLowDateTime != 0 || base->_scantime.dwHighDateTime != 0) &&
+            CompareFileTime(&dir->_scantime, &base->_scantime) == 0)
+        {
+            ok = this->CopyDir(dir, path, pos, files, ownfiles);
+        }
+        else
+        {
+            ok = this->ReadDir(dir, path, pos, files, ownfiles);
+        }
+    }
+
+    if (ok)
+    {
+        this->Attach(self, dir, files, ownfiles);
+    }
+    else
+    {
+        files->Destroy();
+        dir->_failed = TRUE;
+    }
+    this->Complete(dir);
+}
+
+BOOL CZScanner::ReadDir(CZDirectory* dir, TCHAR* path, size_t pos, TAutoIndirectArray<CZFile>* files, int& ownfiles)
+{
+    WIN32_FIND_DATA FindFileData;
+    HANDLE hFind = INVALID_HANDLE_VALUE;
+    DWORD dwError;
+
+    int dircount = 0;
+    int filecount = 0;
+    INT64 tsize = 0;
+
+    TCHAR* filepart = &path[pos]; //pointer to the start of the area for appending the file name
+
+    path[pos] = TEXT('*');
+    path[pos + 1] = TEXT('\0');
+
+    hFind = FindFirstFile(path, &FindFileData);
+    if (hFind == INVALID_HANDLE_VALUE)
+    {
+        //ERROR
+        this->_root->LogLastError(dir);
+        return FALSE;
+    }
+
+    //subdirectories from the previous scan, sorted by name
+    CZDirectory** bases = NULL;
+    int basecount = 0;
+    if (dir->_base != NULL)
+    {
+        int cnt = dir->_base->GetFileCount();
+        bases = (CZDirectory**)malloc(max(1, cnt) * sizeof(CZDirectory*));
+        if (bases != NULL)
+        {
+            for (int i = 0; i < cnt; i++)
+            {
+                CZFile* f = dir->_base->GetFile(i);
+                if (f->IsDirectory())
+                    bases[basecount++] = (CZDirectory*)f;
+            }
+            qsort(bases, basecount, sizeof(CZDirectory*), CompareDirs);
+        }
+    }
+
+    DWORD lastTime = GetTickCount();
+    do
+    {
+        if (FindFileData.cFileName[0] == '.' && (FindFileData.cFileName[1] == '\0' || (FindFileData.cFileName[1] == '.' && FindFileData.cFileName[2] == '\0')))
+            continue;
+
+        if ((FindFileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+        {
+            CZDirectory* sub = new CZDirectory(dir, FindFileData.cFileName, &FindFileData.ftCreationTime, &FindFileData.ftLastWriteTime);
+            if ((FindFileData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) == 0)
+            {
+                if (basecount > 0)
+                {
+                    CZDirectory** base = (CZDirectory**)bsearch(FindFileData.cFileName, bases, basecount, sizeof(CZDirectory*), CompareDirName);
+                    if (base != NULL)
+                        sub->_base = *base;
+                }
+                files->Add(sub);
+                dircount++;
+            }
+            else
+            {
+                this->_root->Log(LOG_WARNING, TEXT("Ignoring Reparse Point."), sub);
+                delete sub;
+            }
+        }
+        else
+        {
+            INT64 datasize = ((INT64)FindFileData.nFileSizeHigh * ((INT64)(MAXDWORD) + 1)) + FindFileData.nFileSizeLow;
+            INT64 realsize;
+            if ((FindFileData.dwFileAttributes & (FILE_ATTRIBUTE_SPARSE_FILE | FILE_ATTRIBUTE_COMPRESSED)) != 0)
+            {
+                DWORD lo, hi;
+                _tcscpy(filepart, FindFileData.cFileName);
+                lo = GetCompressedFileSize(path, &hi);
+                if (lo == INVALID_FILE_SIZE)
+                {
+                    realsize = datasize;
+                }
+                else
+                {
+                    realsize = ((INT64)hi * ((INT64)(MAXDWORD) + 1)) + lo;
+                }
+            }
+            else
+            {
+                realsize = datasize;
+            }
+            //always count them so we match Explorer's numbers
+            ownfiles++;
+            filecount++;
+            if (datasize > 0)
+            {
+                INT64 disksize = this->_root->GetDiskSize(realsize);
+
+                CZFile* f = new CZFile(dir, FindFileData.cFileName, datasize, realsize, disksize, &FindFileData.ftCreationTime, &FindFileData.ftLastWriteTime);
+                files->Add(f);
+                tsize += f->GetSizeEx(this->_sortorder);
+            }
+        }
+        if ((GetTickCount() - lastTime > 250) && (filecount + dircount) > 0) //if 0.25 sec elapsed and at least something new was found
+        {
+            this->_root->IncStats(filecount, dircount, tsize);
+            lastTime = GetTickCount();
+            dircount = 0;
+            filecount = 0;
+            tsize = 0;
+        }
+    } while ((FindNextFile(hFind, &FindFileData) != 0) && !this->Aborting());
+
+    this->_root->IncStats(filecount, dircount, tsize);
+
+    dwError = GetLastError();
+    FindClose(hFind);
+
+    if (bases != NULL)
+        free(bases);
+
+    if (this->Aborting())
+        return FALSE;
+    if (dwError != ERROR_NO_MORE_FILES)
+    {
+        //ERROR
+        this->_root->LogError(dir, dwError);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+BOOL CZScanner::CopyDir(CZDirectory* dir, TCHAR* path, size_t pos, TAutoIndirectArray<CZFile>* files, int& ownfiles)
+{
+    CZDirectory* base = dir->_base;
+
+    int dircount = 0;
+    INT64 tsize = 0;
+
+    int cnt = base->GetFileCount();
+    for (int i = 0; i < cnt && !this->Aborting(); i++)
+    {
+        CZFile* f = base->GetFile(i);
+        if (f->IsDirectory())
+        {
+            //a change inside a subdirectory does not touch the time stamp of this one, so
+            //the subdirectory is queued with its current time stamp to be checked as well
+            WIN32_FILE_ATTRIBUTE_DATA fad;
+            _tcscpy(path + pos, f->GetName());
+            if (GetFileAttributesEx(path, GetFileExInfoStandard, &fad) &&
+                (fad.dwFileAttributes & (FILE_ATTRIBUTE_DIRECTORY | FILE_ATTRIBUTE_REPARSE_POINT)) == FILE_ATTRIBUTE_DIRECTORY)
+            {
+                CZDirectory* sub = new CZDirectory(dir, f->GetName(), &fad.ftCreationTime, &fad.ftLastWriteTime);
+                sub->_scantime = fad.ftLastWriteTime; //read before its entries, ScanDir does not read it again
+                sub->_base = (CZDirectory*)f;
+                files->Add(sub);
+                dircount++;
+            }
+            //otherwise it is gone, although the time stamp of this directory says nothing changed
+            //(the file system does not keep it exactly)
+        }
+        else
+        {
+            files->Add(new CZFile(dir, f->GetName(), f->GetSizeEx(FILESIZE_DATA), f->GetSizeEx(FILESIZE_REAL), f->GetSizeEx(FILESIZE_DISK), f->GetCreateTime(), f->GetModifyTime()));
+            tsize += f->GetSizeEx(this->_sortorder);
+        }
+    }
+    ownfiles = base->_ownfilecount;
+
+    this->_root->IncStats(ownfiles, dircount, tsize);
+
+    return !this->Aborting();
+}
+
+void CZScanner::Attach(int self, CZDirectory* dir, TAutoIndirectArray<CZFile>* files, int ownfiles)
+{
+    INT64 datasize = 0;
+    INT64 realsize = 0;
+    INT64 disksize = 0;
+    int subdirs = 0;
+
+    int cnt = files->GetCount();
+    for (int i = 0; i < cnt; i++)
+    {
+        CZFile* f = files->At(i);
+        if (f->IsDirectory())
+        {
+            subdirs++;
+        }
+        else
+        {
+            datasize += f->GetSizeEx(FILESIZE_DATA);
+            realsize += f->GetSizeEx(FILESIZE_REAL);
+            disksize += f->GetSizeEx(FILESIZE_DISK);
+        }
+    }
+    //the subdirectories are empty yet, they go to the end until the directory is complete
+    CZDirectory::SortFiles(files, this->_sortorder);
+
+    //the subdirectories have to be read before the directory is complete
+    InterlockedExchangeAdd(&dir->_pending, subdirs);
+
+    CRWLock* lock = this->_root->GetRWLock();
+    lock->EnterWrite();
+    for (int i = 0; i < cnt; i++)
+        dir->_files->Add(files->At(i));
+    dir->_ownfilecount = ownfiles;
+    for (CZDirectory* d = dir; d != NULL; d = d->GetParent())
+    {
+        d->_datasize += datasize;
+        d->_realsize += realsize;
+        d->_disksize += disksize;
+        d->_filecount += ownfiles;
+        if (d != dir)
+            d->_dircount++; //count empty ones so we match Explorer's results
+    }
+    lock->LeaveWrite();
+
+    for (int i = 0; i < cnt; i++)
+    {
+        CZFile* f = files->At(i);
+        files->At(i) = NULL; //the directory owns it now
+        if (f->IsDirectory())
+            this->Queue(self, (CZDirectory*)f);
+    }
+    files->Destroy();
+}
+
+void CZScanner::Complete(CZDirectory* dir)
+{
+    //whoever completes the last subdirectory completes the parent
+    while (dir != NULL && InterlockedDecrement(&dir->_pending) == 0)
+    {
+        //the sizes of the subdirectories are final now
+        if (dir->_dircount > 0)
+        {
+            CRWLock* lock = this->_root->GetRWLock();
+            lock->EnterWrite();
+            CZDirectory::SortFiles(dir->_files, this->_sortorder);
+            lock->LeaveWrite();
+        }
+        dir->_base = NULL;
+        dir = dir->GetParent();
+    }
+}
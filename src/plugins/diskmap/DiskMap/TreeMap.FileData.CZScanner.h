@@ -0,0 +1,153 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include "Utils.Array.h"
+#include "System.Lock.h"
+#include "System.WorkerThread.h"
+
+#define SCANNER_MAX_THREADS 16 //upper limit of the scanning threads
+#define SCANNER_QUEUE_BLOCKSIZE 64
+
+class CZFile;
+class CZDirectory;
+class CZRoot;
+
+//directories waiting to be read, one queue per scanning thread; the owner takes the ones
+//it added last (depth first, the paths stay in the cache), the other threads steal the
+//oldest ones (the largest subtrees remaining)
+class CZScanQueue
+{
+protected:
+    CLock* _lock;
+    CZDirectory** _items;
+    int _alloc;
+    int _head; //first item not stolen yet
+    int _count;
+
+public:
+    CZScanQueue()
+    {
+        this->_lock = new CLock();
+        this->_items = NULL;
+        this->_alloc = 0;
+        this->_head = 0;
+        this->_count = 0;
+    }
+    ~CZScanQueue()
+    {
+        if (this->_items)
+            free(this->_items);
+        delete this->_lock;
+    }
+    BOOL Push(CZDirectory* dir)
+    {
+        BOOL res = TRUE;
+        this->_lock->Enter();
+        if (this->_count == this->_alloc)
+        {
+            if (this->_head > 0)
+            {
+                memmove(this->_items, this->_items + this->_head, (this->_count - this->_head) * sizeof(CZDirectory*));
+                this->_count -= this->_head;
+                this->_head = 0;
+            }
+            else
+            {
+                CZDirectory** items = (CZDirectory**)realloc(this->_items, (this->_alloc + SCANNER_QUEUE_BLOCKSIZE) * sizeof(CZDirectory*));
+                if (items != NULL)
+                {
+                    this->_items = items;
+                    this->_alloc += SCANNER_QUEUE_BLOCKSIZE;
+                }
+                else
+                {
+                    res = FALSE;
+                }
+            }
+        }
+        if (res)
+            this->_items[this->_count++] = dir;
+        this->_lock->Leave();
+        return res;
+    }
+    CZDirectory* PopLast()
+    {
+        CZDirectory* dir = NULL;
+        this->_lock->Enter();
+        if (this->_count > this->_head)
+            dir = this->_items[--this->_count];
+        if (this->_count == this->_head)
+            this->_count = this->_head = 0;
+        this->_lock->Leave();
+        return dir;
+    }
+    CZDirectory* PopFirst()
+    {
+        CZDirectory* dir = NULL;
+        this->_lock->Enter();
+        if (this->_count > this->_head)
+            dir = this->_items[this->_head++];
+        if (this->_count == this->_head)
+            this->_count = this->_head = 0;
+        this->_lock->Leave();
+        return dir;
+    }
+};
+
+//Reads the directory tree of a CZRoot on several threads. Each thread reads a directory,
+//attaches its files and subdirectories to the tree and queues the subdirectories; a thread
+//without work steals it from the others. The tree can be shown while it grows (see
+//CZRoot::GetRWLock), the sizes of the directories always include everything read below
+//them. When rescanning, a directory whose time stamp did not change since the previous
+//scan is taken from it and only its subdirectories are checked. This is done only on NTFS
+//and ReFS; FAT and exFAT do not update the time stamp of a directory when its entries
+//change, so everything is read again there.
+class CZScanner
+{
+protected:
+    CZRoot* _root;
+    CWorkerThread* _thread; //to find out about an abort, may be NULL
+    int _sortorder;
+    BOOL _incremental; //the time stamps of the directories can be trusted, see CheckIncremental
+
+    CZScanQueue _queues[SCANNER_MAX_THREADS];
+    HANDLE _threads[SCANNER_MAX_THREADS];
+    int _threadcount;
+    volatile LONG _lastid;
+
+    volatile LONG _outstanding; //directories queued or being read
+    volatile LONG _idle;        //threads waiting for work
+    volatile LONG _stop;
+    HANDLE _workready; //semaphore, released when work is queued while a thread is idle
+
+    static unsigned WINAPI s_ThreadBody(void* param);
+    static DWORD WINAPI s_ThreadProc(LPVOID lpParam);
+
+    BOOL Aborting() { return this->_thread != NULL && this->_thread->Aborting(); }
+    BOOL CheckIncremental();
+    void Stop();
+
+    void Work(int self);
+    CZDirectory* GetWork(int self);
+    CZDirectory* Steal(int self);
+    void Queue(int self, CZDirectory* dir);
+
+    void ScanDir(int self, CZDirectory* dir, TCHAR* path, size_t pathsize, TAutoIndirectArray<CZFile>* files);
+    BOOL ReadDir(CZDirectory* dir, TCHAR* path, size_t pos, TAutoIndirectArray<CZFile>* files, int& ownfiles);
+    BOOL CopyDir(CZDirectory* dir, TCHAR* path, size_t pos, TAutoIndirectArray<CZFile>* files, int& ownfiles);
+    void Attach(int self, CZDirectory* dir, TAutoIndirectArray<CZFile>* files, int ownfiles);
+    void Complete(CZDirectory* dir);
+
+public:
+    CZScanner(CZRoot* root, CWorkerThread* thread);
+    ~CZScanner();
+
+    //returns the number of threads worth starting
+    static int GetThreadCount();
+
+    //reads the whole tree using up to 'threads' threads (including the calling one);
+    //returns the size of the root or -1 if it could not be read
+    INT64 Run(int threads);
+};
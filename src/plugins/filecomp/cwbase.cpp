@@ -6,6 +6,123 @@
 
 using namespace std;
 
+// ****************************************************************************
+//
+// CParallelJob
+//
+
+#define PARALLEL_JOB_MAX_THREADS 8 // upper limit for the number of helper threads of one job
+
+class CParallelJobThread : public CThread
+{
+public:
+    CParallelJobThread(CParallelJob* job) : CThread("FileComp Helper Thread") { Job = job; }
+
+    virtual unsigned Body()
+    {
+        CALL_STACK_MESSAGE1("CParallelJobThread::Body()");
+        Job->RunParts();
+        return 0;
+    }
+
+protected:
+    CParallelJob* Job;
+};
+
+int CParallelJob::GetPartCount(size_t items, size_t minItems)
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    size_t parts = items / minItems;
+    if (parts > si.dwNumberOfProcessors)
+        parts = si.dwNumberOfProcessors;
+    if (parts > PARALLEL_JOB_MAX_THREADS)
+        parts = PARALLEL_JOB_MAX_THREADS;
+    return parts < 1 ? 1 : int(parts);
+}
+
+void CParallelJob::Execute(int partCount)
+{
+    CALL_STACK_MESSAGE2("CParallelJob::Execute(%d)", partCount);
+    NextPart = 0;
+    PartCount = partCount;
+
+    HANDLE threads[PARALLEL_JOB_MAX_THREADS];
+    int count = 0;
+    while (count < partCount - 1 && count < PARALLEL_JOB_MAX_THREADS)
+    {
+        CParallelJobThread* thread = new CParallelJobThread(this);
+        if (thread == NULL || (threads[count] = thread->Create(ThreadQueue)) == NULL)
+        {
+            TRACE_E("CParallelJob::Execute(): Failed to create helper thread.");
+            if (thread != NULL)
+                delete thread; // on failure the thread object needs to be deallocated
+            break;              // the remaining parts are processed by the running threads
+        }
+        count++;
+    }
+    RunParts();
+    while (count > 0)
+        ThreadQueue.WaitForExit(threads[--count], INFINITE);
+}
+
+void CParallelJob::RunParts()
+{
+    int part;
+    while ((part = InterlockedIncrement(&NextPart) - 1) < PartCount)
+        Run(part);
+}
+
+// ****************************************************************************
+//
+// CFindLinesJob -- finds beginnings of lines in a part of a file
+//
+
+#define FIND_LINES_MIN_PART_SIZE (4 * 1024 * 1024) // smaller files are searched by one thread
+
+template <class CChar>
+class CFindLinesJob : public CParallelJob
+{
+public:
+    vector<vector<CChar*>> Parts; // beginnings of lines (positions following '\n') found in each part
+    bool LowMemory;               // true = some part could not store all the lines found
+
+    CFindLinesJob(CChar* begin, CChar* end, int parts, const int& cancelFlag)
+        : Parts(parts), LowMemory(false), Begin(begin), End(end), CancelFlag(cancelFlag) {}
+
+protected:
+    CChar* Begin;
+    CChar* End;
+    const int& CancelFlag;
+
+    virtual void Run(int part)
+    {
+        size_t partSize = (End - Begin) / Parts.size();
+        CChar* iterator = Begin + part * partSize;
+        CChar* end = part == int(Parts.size()) - 1 ? End : iterator + partSize;
+        vector<CChar*>& lines = Parts[part];
+        try
+        {
+            while (iterator < end)
+            {
+                CChar* blockEnd = end - iterator > 65536 ? iterator + 65536 : end;
+                for (; iterator < blockEnd; ++iterator)
+                {
+                    if (*iterator == '\n')
+                        lines.push_back(iterator + 1);
+                }
+                if (CancelFlag)
+                    return; // the caller throws CAbortByUserException
+            }
+        }
+        catch (bad_alloc&) // exceptions must not leave the helper thread
+        {
+            vector<CChar*>().swap(lines);
+            LowMemory = true;
+        }
+    }
+};
+
 // ****************************************************************************
 //
 // CFilecompCoWorkerBase
@@ -41,37 +158,47 @@ void CFilecompCoWorkerBase<CChar>::ReadFilesAndFindLines(CTextFileReader (&reade
         binaryIdentical = memcmp(md5_1, md5_2, 16) == 0;
     }
 
-    // find the beginnings of lines
+    // find the beginnings of lines; large files are split into parts searched on several threads
     for (i = 0; i < 2; i++)
     {
         CChar* lineStart = Files[i].Begin;
         // skip BOM
         if (lineStart < Files[i].End && TCharSpecific<CChar>::IsBOM(*lineStart))
             lineStart++;
-        for (CChar* iterator = lineStart; iterator < Files[i].End;)
+        CFindLinesJob<CChar> job(lineStart, Files[i].End,
+                                 CParallelJob::GetPartCount((Files[i].End - lineStart) * sizeof(CChar),
+                                                            FIND_LINES_MIN_PART_SIZE),
+                                 CancelFlag);
+        job.Execute(int(job.Parts.size()));
+        if (CancelFlag)
+            throw CFilecompWorker::CAbortByUserException();
+        if (job.LowMemory)
+            CFilecompWorker::CException::Raise(IDS_LOWMEM, 0);
+
+        // the first line starts at 'lineStart', every other one after '\n'; the last item
+        // is the pointer past the last line
+        size_t count = 1;
+        size_t p;
+        for (p = 0; p < job.Parts.size(); p++)
+            count += job.Parts[p].size();
+        Files[i].Lines.reserve(count + 1);
+        Files[i].Lines.push_back(lineStart);
+        for (p = 0; p < job.Parts.size(); p++)
         {
-            if (*iterator == '\n')
-            {
-                Files[i].Lines.push_back(lineStart);
-                lineStart = ++iterator;
-                if (CancelFlag)
-                    throw CFilecompWorker::CAbortByUserException();
-            }
-            else
-                ++iterator;
+            Files[i].Lines.insert(Files[i].Lines.end(), job.Parts[p].begin(), job.Parts[p].end());
+            vector<CChar*>().swap(job.Parts[p]); // release memory right away
         }
-        // pointer past the last line
-        Files[i].Lines.push_back(lineStart);
-    }
 
-    // just for peace of mind
-    if (Files[i].Lines.size() >= size_t(CLineSpec::MaxLines()))
-        CFilecompWorker::CException::Raise(IDS_MAXLINES, 0);
+        // just for peace of mind
+        if (Files[i].Lines.size() >= size_t(CLineSpec::MaxLines()))
+            CFilecompWorker::CException::Raise(IDS_MAXLINES, 0);
+    }
 }
 
 template <class CChar>
 void CFilecompCoWorkerBase<CChar>::SendResults(CLineScript (&lineScript)[2],
-                                               CIntIndexes& changesToLines, CIntIndexes& changesLengths, CEditScript& changes, CTextFileReader (&reader)[2])
+                                               CIntIndexes& changesToLines, CIntIndexes& changesLengths, CEditScript& changes, CTextFileReader (&reader)[2],
+                                               bool approximate)
 {
     CTextCompareResults<CChar> results(Options);
     int i;
@@ -86,6 +213,7 @@ void CFilecompCoWorkerBase<CChar>::SendResults(CLineScript (&lineScript)[2],
     results.ChangesToLines.swap(changesToLines);
     results.ChangesLengths.swap(changesLengths);
     results.Changes.swap(changes);
+    results.Approximate = approximate;
     _CrtCheckMemory();
     if (SendMessage(MainWindow, WM_USER_WORKERNOTIFIES,
                     TCharSpecific<CChar>::IsUnicode() ? WN_UNICODE_FILES_DIFFER : WN_TEXT_FILES_DIFFER,
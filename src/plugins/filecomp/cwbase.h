@@ -3,6 +3,37 @@
 
 #pragma once
 
+// ****************************************************************************
+//
+// CParallelJob
+//
+// Runs Run(part) for parts 0 .. partCount - 1 on helper threads, the calling thread
+// takes part too. Run() must not throw exceptions; when the user cancels the comparison
+// it should just return, the caller tests the cancel flag after Execute().
+//
+
+class CParallelJob
+{
+public:
+    virtual ~CParallelJob() {}
+
+    // returns after all 'partCount' parts were processed
+    void Execute(int partCount);
+
+    // suitable number of parts for a job over 'items' items with at least 'minItems'
+    // items per part
+    static int GetPartCount(size_t items, size_t minItems);
+
+    // processes parts until there are none left (called from all threads)
+    void RunParts();
+
+protected:
+    virtual void Run(int part) = 0;
+
+    volatile LONG NextPart;
+    int PartCount;
+};
+
 // ****************************************************************************
 //
 // CFilecompCoWorkerBase
@@ -60,8 +91,10 @@ protected:
     } Strict;
 
     void ReadFilesAndFindLines(CTextFileReader (&reader)[2], bool& binaryIdentical);
+    // 'approximate' - the differences need not be minimal (large files, see CAnchoredDiff)
     void SendResults(CLineScript (&lineScript)[2], CIntIndexes& changesToLines,
-                     CIntIndexes& changesLengths, CEditScript& changes, CTextFileReader (&reader)[2]);
+                     CIntIndexes& changesLengths, CEditScript& changes, CTextFileReader (&reader)[2],
+                     bool approximate);
     void ScrictCompare(size_t (&firstLines)[2], size_t (&lenghts)[2],
                        CLineScript (&script)[2], int lcCommon);
     void RemoveSingleCharMatches();
@@ -131,40 +131,300 @@ struct CLineEqual
     }
 };
 
+// line with its precomputed hash (the lines are hashed on several threads, see CHashLinesJob)
+template <class CChar>
+struct CHashedLine
+{
+    const CChar* Line;
+    size_t Hash;
+    CHashedLine(const CChar* line, size_t hash) : Line(line), Hash(hash) {}
+};
+
+template <class CChar>
+struct CHashedLineHash
+{
+    size_t operator()(const CHashedLine<CChar>& line) const { return line.Hash; }
+};
+
+template <class CChar, class CLineIterator, class CCaseConverter>
+struct CHashedLineEqual
+{
+    CLineEqual<CChar, CLineIterator, CCaseConverter> LineEqual;
+    bool operator()(const CHashedLine<CChar>& first, const CHashedLine<CChar>& second) const
+    {
+        return first.Hash == second.Hash && LineEqual(first.Line, second.Line);
+    }
+};
+
+#define HASH_LINES_MIN_PART_SIZE 65536 // min. number of lines hashed by one thread
+
+// computes hashes of 'count' lines 'lines' into 'hashes'
+template <class CChar, class CLineIterator, class CCaseConverter>
+class CHashLinesJob : public CParallelJob
+{
+public:
+    CHashLinesJob(CChar* const* lines, size_t count, size_t* hashes, const int& cancel)
+        : Lines(lines), Count(count), Hashes(hashes), Cancel(cancel) {}
+
+    void Execute() { CParallelJob::Execute(CParallelJob::GetPartCount(Count, HASH_LINES_MIN_PART_SIZE)); }
+
+protected:
+    CChar* const* Lines;
+    size_t Count;
+    size_t* Hashes;
+    const int& Cancel;
+    CHash<CChar, CLineIterator, CCaseConverter> Hash;
+
+    virtual void Run(int part)
+    {
+        size_t partSize = Count / PartCount;
+        size_t line = part * partSize;
+        size_t end = part == PartCount - 1 ? Count : line + partSize;
+        for (; line < end; ++line)
+        {
+            Hashes[line] = Hash(Lines[line]);
+            if ((line & 0xFFF) == 0 && Cancel)
+                return; // the caller throws CAbortByUserException
+        }
+    }
+};
+
 template <class CChar>
 template <class CCaseConverter, class CLineIterator>
-void CFilecompCoWorkerOptimized<CChar>::IdentifyLines(CFilecompCoWorkerBase<CChar>::CFCFileData (&files)[2], CIndexes (&compareData)[2], const int& cancel)
+size_t CFilecompCoWorkerOptimized<CChar>::IdentifyLines(CFilecompCoWorkerBase<CChar>::CFCFileData (&files)[2], CIndexes (&compareData)[2], const int& cancel)
 {
-    typedef vector<CChar*> CLineBuffer;
     typedef unordered_map<
-        const CChar*, size_t,
-        CHash<CChar, CLineIterator, CCaseConverter>,
-        CLineEqual<CChar, CLineIterator, CCaseConverter>>
+        CHashedLine<CChar>, size_t,
+        CHashedLineHash<CChar>,
+        CHashedLineEqual<CChar, CLineIterator, CCaseConverter>>
         CLineClasses;
 
+    // hashing is the expensive part, run it on all cores; compareData temporarily holds the hashes
+    int i;
+    for (i = 0; i < 2; ++i)
+    {
+        compareData[i].resize(files[i].Lines.size() - 1);
+        if (!compareData[i].empty())
+        {
+            CHashLinesJob<CChar, CLineIterator, CCaseConverter>(&files[i].Lines[0], compareData[i].size(),
+                                                                &compareData[i][0], cancel)
+                .Execute();
+        }
+        if (cancel)
+            throw CFilecompWorker::CAbortByUserException();
+    }
+
     CLineClasses classes;
+    classes.reserve(max(compareData[0].size(), compareData[1].size()));
     size_t next = 0; // next class ID
 
-    int i;
     for (i = 0; i < 2; ++i)
     {
-        // reserve space
-        compareData[i].resize(files[i].Lines.size() - 1);
         // indentify each line
-        typename CLineBuffer::iterator line = files[i].Lines.begin();
-        CIndexes::iterator eqvclass = compareData[i].begin();
-        for (; line < files[i].Lines.end() - 1; ++line, ++eqvclass)
+        size_t line;
+        for (line = 0; line < compareData[i].size(); ++line)
         {
-
-            std::pair<CLineClasses::iterator, bool> ir =
-                classes.insert(CLineClasses::value_type(*line, next));
+            std::pair<typename CLineClasses::iterator, bool> ir =
+                classes.insert(typename CLineClasses::value_type(
+                    CHashedLine<CChar>(files[i].Lines[line], compareData[i][line]), next));
             if (ir.second)
                 next++; // new class created
-            *eqvclass = ir.first->second;
-            if (cancel)
+            compareData[i][line] = ir.first->second;
+            if ((line & 0xFFF) == 0 && cancel)
                 throw CFilecompWorker::CAbortByUserException();
         }
     }
+    return next;
+}
+
+// ****************************************************************************
+//
+// CAnchoredDiff
+//
+// Large files are not passed to diff() as a whole: the running time of diff() grows with
+// the product of the length and the number of differences, which takes minutes for large
+// data dumps. Instead, lines that occur exactly once in both files are found and the longest
+// sequence of them keeping their order in both files is used as anchors (so-called patience
+// diff). The anchors are matched lines, so diff() is run only on the regions between them
+// (a region is anchored again if it is still large). The resulting edit script need not
+// be the shortest one, but for files with many unique lines (logs, CSV exports) it is the
+// same or better readable; the main window tells the user that such differences are
+// approximate (see Approximate()). Sequences shorter than ANCHORED_DIFF_MIN_LINES are
+// compared by diff() directly, so the results for common files do not change.
+//
+// Memory: besides the line classes (compareData) the comparison needs 1 + 1 + sizeof(size_t)
+// bytes per line class (Count, PositionB) and the buffer of diff(), which is linear in the
+// size of the region. A region keeps only its anchors while its subregions are compared;
+// the subregions lie between the anchors, so the anchors of all regions being compared at
+// once take at most 2 * (n + m) indexes. The whole comparison thus needs memory linear in
+// the number of lines (the texts and their line arrays are held by the viewer anyway).
+//
+
+#define ANCHORED_DIFF_MIN_LINES 20000 // regions with fewer lines (in both files) go to diff() directly
+#define ANCHORED_DIFF_MAX_DEPTH 32    // regions nested deeper go to diff() directly
+
+class CAnchoredDiff
+{
+public:
+    CAnchoredDiff(CIndexes (&compareData)[2], size_t classCount, CEditScript& editScript, const int& cancel)
+        : Data(compareData), ClassCount(classCount), EditScript(editScript), Cancel(cancel), Distance(0),
+          Anchored(false) {}
+
+    // fills the edit script, returns the number of differing lines (0 = no difference)
+    // or -1 on error
+    ptrdiff_t Compare();
+
+    // returns true if some region was anchored, so the edit script need not be the shortest one
+    bool Approximate() const { return Anchored; }
+
+protected:
+    CIndexes (&Data)[2];
+    size_t ClassCount;
+    CEditScript& EditScript;
+    const int& Cancel;
+    ptrdiff_t Distance;
+    bool Anchored;
+
+    std::vector<BYTE> Count[2]; // number of occurrences of each class in the region (0, 1, 2 = more), zeroed after use
+    CIndexes PositionB;         // position of the class in the second sequence (valid for Count[1] == 1)
+    std::vector<ptrdiff_t> Buf; // buffer for diff()
+
+    // compares 'n' lines from 'a' with 'm' lines from 'b'; returns false on error
+    bool CompareRegion(size_t a, size_t n, size_t b, size_t m, int depth);
+
+    // compares the region by diff(); returns false on error
+    bool DiffRegion(size_t a, size_t n, size_t b, size_t m);
+};
+
+ptrdiff_t CAnchoredDiff::Compare()
+{
+    size_t n = Data[0].size();
+    size_t m = Data[1].size();
+    if (n + m >= ANCHORED_DIFF_MIN_LINES)
+    {
+        Count[0].resize(ClassCount);
+        Count[1].resize(ClassCount);
+        PositionB.resize(ClassCount);
+    }
+    return CompareRegion(0, n, 0, m, 0) ? Distance : -1;
+}
+
+bool CAnchoredDiff::CompareRegion(size_t a, size_t n, size_t b, size_t m, int depth)
+{
+    // matching lines at the beginning and at the end of the region need no search
+    while (n > 0 && m > 0 && Data[0][a] == Data[1][b])
+        a++, b++, n--, m--;
+    while (n > 0 && m > 0 && Data[0][a + n - 1] == Data[1][b + m - 1])
+        n--, m--;
+    if (n == 0 || m == 0 || n + m < ANCHORED_DIFF_MIN_LINES || depth >= ANCHORED_DIFF_MAX_DEPTH)
+        return DiffRegion(a, n, b, m);
+
+    // count occurrences of the classes in the region
+    size_t i;
+    for (i = a; i < a + n; i++)
+    {
+        BYTE& count = Count[0][Data[0][i]];
+        if (count < 2)
+            count++;
+    }
+    for (i = b; i < b + m; i++)
+    {
+        BYTE& count = Count[1][Data[1][i]];
+        if (count < 2)
+            count++;
+        PositionB[Data[1][i]] = i;
+    }
+
+    // lines unique in both sequences (in the order of the first sequence)
+    CIndexes uniqueA;
+    CIndexes uniqueB;
+    for (i = a; i < a + n; i++)
+    {
+        size_t c = Data[0][i];
+        if (Count[0][c] == 1 && Count[1][c] == 1)
+        {
+            uniqueA.push_back(i);
+            uniqueB.push_back(PositionB[c]);
+        }
+    }
+    for (i = a; i < a + n; i++)
+        Count[0][Data[0][i]] = 0;
+    for (i = b; i < b + m; i++)
+        Count[1][Data[1][i]] = 0;
+    if (Cancel)
+        throw CFilecompWorker::CAbortByUserException();
+    if (uniqueA.empty())
+        return DiffRegion(a, n, b, m);
+
+    // the longest increasing subsequence of uniqueB (patience sorting): 'tails[k]' is the index
+    // of the smallest last item of an increasing subsequence of length k + 1, 'previous' links
+    // the items of the subsequences
+    CIndexes tails;
+    std::vector<ptrdiff_t> previous(uniqueB.size());
+    for (i = 0; i < uniqueB.size(); i++)
+    {
+        size_t low = 0;
+        size_t high = tails.size();
+        while (low < high)
+        {
+            size_t middle = (low + high) / 2;
+            if (uniqueB[tails[middle]] < uniqueB[i])
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        previous[i] = low > 0 ? ptrdiff_t(tails[low - 1]) : -1;
+        if (low == tails.size())
+            tails.push_back(i);
+        else
+            tails[low] = i;
+    }
+    CIndexes anchorsA(tails.size());
+    CIndexes anchorsB(tails.size());
+    ptrdiff_t k = tails.back();
+    for (i = anchorsA.size(); i-- > 0; k = previous[k])
+    {
+        anchorsA[i] = uniqueA[k];
+        anchorsB[i] = uniqueB[k];
+    }
+    // release the work vectors before going deeper, only the anchors are kept (see Memory above)
+    CIndexes().swap(uniqueA);
+    CIndexes().swap(uniqueB);
+    CIndexes().swap(tails);
+    std::vector<ptrdiff_t>().swap(previous);
+    Anchored = true;
+
+    // compare the regions between the anchors (the anchors themselves are matched lines)
+    size_t nextA = a;
+    size_t nextB = b;
+    for (i = 0; i < anchorsA.size(); i++)
+    {
+        size_t anchorA = anchorsA[i];
+        size_t anchorB = anchorsB[i];
+        if (!CompareRegion(nextA, anchorA - nextA, nextB, anchorB - nextB, depth + 1))
+            return false;
+        nextA = anchorA + 1;
+        nextB = anchorB + 1;
+    }
+    return CompareRegion(nextA, a + n - nextA, nextB, b + m - nextB, depth + 1);
+}
+
+bool CAnchoredDiff::DiffRegion(size_t a, size_t n, size_t b, size_t m)
+{
+    if (n == 0 && m == 0)
+        return true;
+    ptrdiff_t d = diff(
+        a, n,
+        b, m,
+        sequence_comparator(
+            Data[0].begin(),
+            Data[1].begin()),
+        CEditScriptBuilder(EditScript, a, b),
+        Cancel, INT_MAX, Buf);
+    if (d == -1)
+        return false;
+    Distance += d;
+    return true;
 }
 
 template <class CChar>
@@ -198,40 +458,37 @@ void CFilecompCoWorkerOptimized<CChar>::Compare(CTextFileReader (&reader)[2])
 
     CEditScript editScript;
     ptrdiff_t d = 0;
+    bool approximate = false; // differences of large files found by CAnchoredDiff need not be minimal
     if (!binaryIdentical)
     {
         // do the comparison
 
         // prepare compare data
         CIndexes compareData[2];
+        size_t classCount;
         if (this->Options.IgnoreCase)
         {
             if (this->Options.IgnoreAllSpace)
-                IdentifyLines<CToLowerCase<CChar>, CIgnoringSpace<CChar>>(this->Files, compareData, this->CancelFlag);
+                classCount = IdentifyLines<CToLowerCase<CChar>, CIgnoringSpace<CChar>>(this->Files, compareData, this->CancelFlag);
             elif (this->Options.IgnoreSpaceChange)
-                IdentifyLines<CToLowerCase<CChar>, CIgnoringSpaceChange<CChar>>(this->Files, compareData, this->CancelFlag);
-            else IdentifyLines<CToLowerCase<CChar>, const CChar*>(this->Files, compareData, this->CancelFlag);
+                classCount = IdentifyLines<CToLowerCase<CChar>, CIgnoringSpaceChange<CChar>>(this->Files, compareData, this->CancelFlag);
+            else classCount = IdentifyLines<CToLowerCase<CChar>, const CChar*>(this->Files, compareData, this->CancelFlag);
         }
         else
         {
             if (this->Options.IgnoreAllSpace)
-                IdentifyLines<::identity<CChar>, CIgnoringSpace<CChar>>(this->Files, compareData, this->CancelFlag);
+                classCount = IdentifyLines<::identity<CChar>, CIgnoringSpace<CChar>>(this->Files, compareData, this->CancelFlag);
             elif (this->Options.IgnoreSpaceChange)
-                IdentifyLines<::identity<CChar>, CIgnoringSpaceChange<CChar>>(this->Files, compareData, this->CancelFlag);
-            else IdentifyLines<::identity<CChar>, const CChar*>(this->Files, compareData, this->CancelFlag);
+                classCount = IdentifyLines<::identity<CChar>, CIgnoringSpaceChange<CChar>>(this->Files, compareData, this->CancelFlag);
+            else classCount = IdentifyLines<::identity<CChar>, const CChar*>(this->Files, compareData, this->CancelFlag);
         }
 
-        // compare the two sequences sequence
-        d = diff(
-            0, compareData[0].size(),
-            0, compareData[1].size(),
-            sequence_comparator(
-                compareData[0].begin(),
-                compareData[1].begin()),
-            CEditScriptBuilder(editScript),
-            this->CancelFlag);
+        // compare the two sequences sequence (large ones are anchored on unique lines first)
+        CAnchoredDiff anchoredDiff(compareData, classCount, editScript, this->CancelFlag);
+        d = anchoredDiff.Compare();
         if (d == -1)
             CFilecompWorker::CException::Raise(IDS_INTERNALERROR, 0);
+        approximate = anchoredDiff.Approximate();
         /*  if (d == 0) We now let the file display
     {
       throw CFilecompWorker::CFilesDontDifferException();
@@ -334,7 +591,7 @@ void CFilecompCoWorkerOptimized<CChar>::Compare(CTextFileReader (&reader)[2])
         d = 0;
     }
     // send results
-    this->SendResults(script, changesToLines, changesLengths, changes, reader);
+    this->SendResults(script, changesToLines, changesLengths, changes, reader, approximate);
     if (d == 0)
     {
         if (binaryIdentical)
@@ -15,8 +15,9 @@ class CFilecompCoWorkerOptimized : public CFilecompCoWorkerBase<CChar>
 
 public:
     CFilecompCoWorkerOptimized(HWND mainWindow, CCompareOptions& options, const int& cancelFlag);
+    // replaces lines with IDs of classes of equal lines in 'compareData', returns the number of classes
     template <class CCaseConverter, class CLineIterator>
-    void IdentifyLines(CFilecompCoWorkerBase<CChar>::CFCFileData (&files)[2], CIndexes (&compareData)[2], const int& cancel);
+    size_t IdentifyLines(CFilecompCoWorkerBase<CChar>::CFCFileData (&files)[2], CIndexes (&compareData)[2], const int& cancel);
     bool IsChangeIgnorable(const CChange& change);
     void Compare(CTextFileReader (&reader)[2]);
 
@@ -33,6 +33,7 @@ CMainWindow::CMainWindow(char* path1, char* path2, CCompareOptions* options, UIN
     FirstCompare = TRUE;
     Options = *options;
     DifferencesCount = 0;
+    ApproximateDifferences = FALSE;
     ViewMode = ::Configuration.ViewMode;
     ShowWhiteSpace = ::Configuration.ShowWhiteSpace;
     ShowCaret = FALSE;
@@ -924,6 +925,7 @@ bool CMainWindow::TextFilesDiffer(CTextCompareResults<CChar>* res, char* message
     res->ChangesToLines.swap(ChangesToLines[0]);
     res->ChangesLengths.swap(ChangesLengths);
     res->Changes.swap(TextChanges);
+    ApproximateDifferences = res->Approximate;
 
     // ensure the file view control uses the correct type
     if (FileView[fviLeft])
@@ -2108,6 +2110,11 @@ CMainWindow::WindowProc(UINT uMsg, WPARAM wParam, LPARAM lParam)
             else
                 _tcscpy(fmt, LoadStr((WN_NO_DIFFERENCE == wParam) ? IDS_MAINWNDHEADER_NODIF : IDS_MAINWNDHEADERCOMPUTING2));
             _stprintf(buf, fmt, SG->SalPathFindFileName(Path1), encoding[0], SG->SalPathFindFileName(Path2), encoding[1], DifferencesCount);
+            if (DifferencesCount && ApproximateDifferences &&
+                (wParam == WN_TEXT_FILES_DIFFER || wParam == WN_UNICODE_FILES_DIFFER))
+            {
+                _tcscat(buf, LoadStr(IDS_MAINWNDHEADER_APPROX));
+            }
             //        }
             //        else
             //        {
@@ -70,6 +70,7 @@ protected:
     CIntIndexes ChangesLengths;
     CEditScript TextChanges; // data to fill combo box
     int DifferencesCount;
+    BOOL ApproximateDifferences; // the text differences need not be minimal (large files, see CAnchoredDiff)
     LONG Height;
     LONG Width;
     double SplitProp, PrevSplitProp;
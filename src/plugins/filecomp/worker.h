@@ -228,8 +228,9 @@ struct CTextCompareResults
     CIntIndexes ChangesToLines;
     CIntIndexes ChangesLengths;
     CEditScript Changes; // data to fill combo-box
+    bool Approximate;    // the differences need not be minimal (large files compared by CAnchoredDiff)
 
-    CTextCompareResults(CCompareOptions& options) : Options(options) {}
+    CTextCompareResults(CCompareOptions& options) : Options(options), Approximate(false) {}
 };
 
 // ****************************************************************************
@@ -242,6 +243,9 @@ class CEditScriptBuilder
 public:
     CEditScriptBuilder(CEditScript& editScript)
         : EditScript(editScript), DeletePos(0), InsertPos(0) {}
+    // builds the script of a part of the sequences starting at 'deletePos' and 'insertPos'
+    CEditScriptBuilder(CEditScript& editScript, size_t deletePos, size_t insertPos)
+        : EditScript(editScript), DeletePos(deletePos), InsertPos(insertPos) {}
 
     void operator()(char op, size_t off, size_t len);
 
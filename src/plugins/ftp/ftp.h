@@ -486,6 +486,10 @@ public:
     BOOL ContainsTypeName(const char* typeName, CServerType* exclude, int* index = NULL);
 };
 
+// adds the built-in server types (columns + rules for parsing) to 'serverTypeList'; it is in its
+// own module (srvtypes.cpp) so that the parser tester (tests\parstest.cpp) can use the rules too
+void AddDefaultServerTypes(CServerTypeList* serverTypeList);
+
 //
 // ****************************************************************************
 // CFTPServerList
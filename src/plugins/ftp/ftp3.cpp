@@ -620,1367 +620,7 @@ BOOL CConfiguration::InitWithSalamanderGeneral()
                             "ftp.altap.cz",
                             "/pub/altap/salamand");
 
-    // description of the string in the array: "visible,ID,nameStrID,nameStr,descrStrID,descrStr,colType,emptyValue,leftAlignment,fixedWidth,width"
-    const char* unix1Columns[] = {"1,name,0,\\0,0,\\0,1,\\0",    // name
-                                  "1,ext,1,\\0,1,\\0,2,\\0",     // extension
-                                  "1,size,2,\\0,2,\\0,3,\\0",    // size
-                                  "0,type,5,\\0,5,\\0,6,\\0",    // type
-                                  "1,date,3,\\0,3,\\0,4,\\0",    // date
-                                  "1,time,4,\\0,4,\\0,9,\\0,0",  // time
-                                  "1,rights,6,\\0,6,\\0,7,\\0",  // rights
-                                  "1,link,12,\\0,12,\\0,7,\\0",  // link target
-                                  "1,user,7,\\0,7,\\0,7,\\0",    // user
-                                  "1,group,8,\\0,8,\\0,7,\\0",   // group
-                                  "0,device,9,\\0,9,\\0,7,\\0"}; // device minor/major number
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("UNIX1", "not syst_contains(\"z/VM \") and not syst_contains(\"OS/2 \") "
-                                          "and not syst_contains(\" MACOS \") and not syst_contains(\"Windows_NT\")",
-                                 11, unix1Columns,
-                                 "# parse lines with files and directories\r\n"
-                                 "* if(next_char!=\"l\"), assign(<is_dir>, next_char==\"d\"), word(<rights>),\r\n"
-                                 "  white_spaces(), word(), white_spaces(), word(<user>), white_spaces(),\r\n"
-                                 "  word(<group>), white_spaces(), positive_number(<size>), white_spaces(),\r\n"
-                                 "  month_3(<date>), white_spaces(), day(<date>), white_spaces(),\r\n"
-                                 "  year(<date>), white_spaces(2),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with files and directories\r\n"
-                                 "* if(next_char!=\"l\"), assign(<is_dir>, next_char==\"d\"), word(<rights>),\r\n"
-                                 "  white_spaces(), word(), white_spaces(), word(<user>), white_spaces(),\r\n"
-                                 "  word(<group>), white_spaces(), positive_number(<size>), white_spaces(),\r\n"
-                                 "  month_3(<date>), white_spaces(), day(<date>), white_spaces(),\r\n"
-                                 "  year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with links\r\n"
-                                 "* if(next_char==\"l\"), assign(<is_link>, true), word(<rights>), white_spaces(),\r\n"
-                                 "  word(), white_spaces(), word(<user>), white_spaces(), word(<group>),\r\n"
-                                 "  white_spaces(), word(), white_spaces(),\r\n"
-                                 "  month_3(<date>), white_spaces(), day(<date>), white_spaces(),\r\n"
-                                 "  year(<date>), white_spaces(2),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), unix_link(<is_dir>, <name>, <link>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with links\r\n"
-                                 "* if(next_char==\"l\"), assign(<is_link>, true), word(<rights>), white_spaces(),\r\n"
-                                 "  word(), white_spaces(), word(<user>), white_spaces(), word(<group>),\r\n"
-                                 "  white_spaces(), word(), white_spaces(),\r\n"
-                                 "  month_3(<date>), white_spaces(), day(<date>), white_spaces(),\r\n"
-                                 "  year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), unix_link(<is_dir>, <name>, <link>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with devices\r\n"
-                                 "* word(<rights>), white_spaces(), word(), white_spaces(), word(<user>),\r\n"
-                                 "  white_spaces(), word(<group>), white_spaces(), unix_device(<device>),\r\n"
-                                 "  white_spaces(), month_3(<date>), white_spaces(), day(<date>), white_spaces(),\r\n"
-                                 "  year(<date>), white_spaces(2),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with devices\r\n"
-                                 "* word(<rights>), white_spaces(), word(), white_spaces(), word(<user>),\r\n"
-                                 "  white_spaces(), word(<group>), white_spaces(), unix_device(<device>),\r\n"
-                                 "  white_spaces(), month_3(<date>), white_spaces(), day(<date>), white_spaces(),\r\n"
-                                 "  year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with files and directories (skipping user+group with more spaces)\r\n"
-                                 "* if(next_char!=\"l\"), assign(<is_dir>, next_char==\"d\"), word(<rights>),\r\n"
-                                 "  white_spaces(), word(), skip_to_number(), positive_number(<size>),\r\n"
-                                 "  white_spaces(), month_3(<date>), white_spaces(), day(<date>),\r\n"
-                                 "  white_spaces(), year(<date>), white_spaces(2),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with files and directories (skipping user+group with more spaces)\r\n"
-                                 "* if(next_char!=\"l\"), assign(<is_dir>, next_char==\"d\"), word(<rights>),\r\n"
-                                 "  white_spaces(), word(), skip_to_number(), positive_number(<size>),\r\n"
-                                 "  white_spaces(), month_3(<date>), white_spaces(), day(<date>), white_spaces(),\r\n"
-                                 "  year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with links (skipping user+group with more spaces)\r\n"
-                                 "* if(next_char==\"l\"), assign(<is_link>, true), word(<rights>), white_spaces(),\r\n"
-                                 "  word(), skip_to_number(), word(), white_spaces(), month_3(<date>),\r\n"
-                                 "  white_spaces(), day(<date>), white_spaces(), year(<date>), white_spaces(2),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), unix_link(<is_dir>, <name>, <link>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with links (skipping user+group with more spaces)\r\n"
-                                 "* if(next_char==\"l\"), assign(<is_link>, true), word(<rights>), white_spaces(),\r\n"
-                                 "  word(), skip_to_number(), word(), white_spaces(), month_3(<date>),\r\n"
-                                 "  white_spaces(), day(<date>), white_spaces(), year_or_time(<date>, <time>),\r\n"
-                                 "  white_spaces(1), assign(<is_hidden>, next_char==\".\"),\r\n"
-                                 "  unix_link(<is_dir>, <name>, <link>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with devices (skipping user+group with more spaces)\r\n"
-                                 "* word(<rights>), white_spaces(), word(), skip_to_number(),\r\n"
-                                 "  unix_device(<device>), white_spaces(), month_3(<date>), white_spaces(),\r\n"
-                                 "  day(<date>), white_spaces(), year(<date>), white_spaces(2),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with devices (skipping user+group with more spaces)\r\n"
-                                 "* word(<rights>), white_spaces(), word(), skip_to_number(),\r\n"
-                                 "  unix_device(<device>), white_spaces(), month_3(<date>), white_spaces(),\r\n"
-                                 "  day(<date>), white_spaces(), year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# skip first line \"total ????\" - up to 3 words\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("UNIX2", "not syst_contains(\"z/VM \") and not syst_contains(\"OS/2 \") "
-                                          "and not syst_contains(\" MACOS \") and not syst_contains(\"Windows_NT\")",
-                                 11, unix1Columns,
-                                 "# parse lines with files and directories\r\n"
-                                 "* if(next_char!=\"l\"), assign(<is_dir>, next_char==\"d\"), word(<rights>),\r\n"
-                                 "  white_spaces(), word(), white_spaces(), word(<user>), white_spaces(),\r\n"
-                                 "  word(<group>), white_spaces(), positive_number(<size>), white_spaces(),\r\n"
-                                 "  month_3(<date>), white_spaces(), day(<date>), white_spaces(),\r\n"
-                                 "  year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with links\r\n"
-                                 "* if(next_char==\"l\"), assign(<is_link>, true), word(<rights>), white_spaces(),\r\n"
-                                 "  word(), white_spaces(), word(<user>), white_spaces(), word(<group>),\r\n"
-                                 "  white_spaces(), word(), white_spaces(),\r\n"
-                                 "  month_3(<date>), white_spaces(), day(<date>), white_spaces(),\r\n"
-                                 "  year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), unix_link(<is_dir>, <name>, <link>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with devices\r\n"
-                                 "* word(<rights>), white_spaces(), word(), white_spaces(), word(<user>),\r\n"
-                                 "  white_spaces(), word(<group>), white_spaces(), unix_device(<device>),\r\n"
-                                 "  white_spaces(), month_3(<date>), white_spaces(), day(<date>), white_spaces(),\r\n"
-                                 "  year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with files and directories (skipping user+group with more spaces)\r\n"
-                                 "* if(next_char!=\"l\"), assign(<is_dir>, next_char==\"d\"), word(<rights>),\r\n"
-                                 "  white_spaces(), word(), skip_to_number(), positive_number(<size>),\r\n"
-                                 "  white_spaces(), month_3(<date>), white_spaces(), day(<date>), white_spaces(),\r\n"
-                                 "  year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with links (skipping user+group with more spaces)\r\n"
-                                 "* if(next_char==\"l\"), assign(<is_link>, true), word(<rights>), white_spaces(),\r\n"
-                                 "  word(), skip_to_number(), word(), white_spaces(), month_3(<date>),\r\n"
-                                 "  white_spaces(), day(<date>), white_spaces(), year_or_time(<date>, <time>),\r\n"
-                                 "  white_spaces(1), assign(<is_hidden>, next_char==\".\"),\r\n"
-                                 "  unix_link(<is_dir>, <name>, <link>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with devices (skipping user+group with more spaces)\r\n"
-                                 "* word(<rights>), white_spaces(), word(), skip_to_number(),\r\n"
-                                 "  unix_device(<device>), white_spaces(), month_3(<date>), white_spaces(),\r\n"
-                                 "  day(<date>), white_spaces(), year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# skip first line \"total ????\" - up to 3 words\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    const char* unix3Columns[] = {"1,name,0,\\0,0,\\0,1,\\0",    // name
-                                  "1,ext,1,\\0,1,\\0,2,\\0",     // extension
-                                  "1,size,2,\\0,2,\\0,3,\\0",    // size
-                                  "0,type,5,\\0,5,\\0,6,\\0",    // type
-                                  "1,date,3,\\0,3,\\0,4,\\0",    // date
-                                  "1,time,4,\\0,4,\\0,9,\\0,0",  // time
-                                  "1,rights,6,\\0,6,\\0,7,\\0",  // rights
-                                  "1,link,12,\\0,12,\\0,7,\\0",  // link target
-                                  "1,user,7,\\0,7,\\0,7,\\0",    // user
-                                  "0,device,9,\\0,9,\\0,7,\\0"}; // device minor/major number
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("UNIX3",
-                                 "(not welcome_contains(\" NW \") or not welcome_contains(\" HellSoft.\")) "
-                                 "and not syst_contains(\"z/VM \") and not syst_contains(\"OS/2 \") "
-                                 "and not syst_contains(\" MACOS \") and not syst_contains(\"Windows_NT\")",
-                                 10, unix3Columns,
-                                 "# parse lines with files and directories\r\n"
-                                 "* if(next_char!=\"l\"), assign(<is_dir>, next_char==\"d\"), word(<rights>),\r\n"
-                                 "  white_spaces(), word(), white_spaces(), word(<user>), white_spaces(),\r\n"
-                                 "  positive_number(<size>), white_spaces(), month_3(<date>), white_spaces(),\r\n"
-                                 "  day(<date>), white_spaces(), year_or_time(<date>, <time>),\r\n"
-                                 "  white_spaces(1), assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with links\r\n"
-                                 "* if(next_char==\"l\"), assign(<is_link>, true), word(<rights>), white_spaces(),\r\n"
-                                 "  word(), white_spaces(), word(<user>), white_spaces(), word(), white_spaces(),\r\n"
-                                 "  month_3(<date>), white_spaces(), day(<date>), white_spaces(),\r\n"
-                                 "  year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), unix_link(<is_dir>, <name>, <link>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with devices\r\n"
-                                 "* word(<rights>), white_spaces(), word(), white_spaces(), word(<user>),\r\n"
-                                 "  white_spaces(), unix_device(<device>), white_spaces(), month_3(<date>),\r\n"
-                                 "  white_spaces(), day(<date>), white_spaces(), year_or_time(<date>, <time>),\r\n"
-                                 "  white_spaces(1), assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with files and directories (skipping user with more spaces)\r\n"
-                                 "* if(next_char!=\"l\"), assign(<is_dir>, next_char==\"d\"), word(<rights>),\r\n"
-                                 "  white_spaces(), word(), skip_to_number(), positive_number(<size>),\r\n"
-                                 "  white_spaces(), month_3(<date>), white_spaces(), day(<date>),\r\n"
-                                 "  white_spaces(), year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with links (skipping user with more spaces)\r\n"
-                                 "* if(next_char==\"l\"), assign(<is_link>, true), word(<rights>), white_spaces(),\r\n"
-                                 "  word(), skip_to_number(), word(), white_spaces(), month_3(<date>),\r\n"
-                                 "  white_spaces(), day(<date>), white_spaces(), year_or_time(<date>, <time>),\r\n"
-                                 "  white_spaces(1), assign(<is_hidden>, next_char==\".\"),\r\n"
-                                 "  unix_link(<is_dir>, <name>, <link>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with devices (skipping user with more spaces)\r\n"
-                                 "* word(<rights>), white_spaces(), word(), skip_to_number(),\r\n"
-                                 "  unix_device(<device>), white_spaces(), month_3(<date>), white_spaces(),\r\n"
-                                 "  day(<date>), white_spaces(), year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# skip first line \"total ????\" - up to 3 words\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("UNIX4", "not syst_contains(\"z/VM \") and not syst_contains(\"OS/2 \") "
-                                          "and not syst_contains(\" MACOS \") and not syst_contains(\"Windows_NT\")",
-                                 11, unix1Columns,
-                                 "# parse lines with files and directories\r\n"
-                                 "* if(next_char!=\"l\"), assign(<is_dir>, next_char==\"d\"), word(<rights>),\r\n"
-                                 "  white_spaces(), word(), white_spaces(), word(<user>), white_spaces(),\r\n"
-                                 "  word(<group>), white_spaces(), positive_number(<size>), white_spaces(),\r\n"
-                                 "  day(<date>), all(1), skip_white_spaces(), month_txt(<date>), all(1),\r\n"
-                                 "  skip_white_spaces(), year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with links\r\n"
-                                 "* if(next_char==\"l\"), assign(<is_link>, true), word(<rights>), white_spaces(),\r\n"
-                                 "  word(), white_spaces(), word(<user>), white_spaces(), word(<group>),\r\n"
-                                 "  white_spaces(), word(), white_spaces(), day(<date>), all(1), skip_white_spaces(),\r\n"
-                                 "  month_txt(<date>), all(1), skip_white_spaces(), year_or_time(<date>, <time>),\r\n"
-                                 "  white_spaces(1), assign(<is_hidden>, next_char==\".\"),\r\n"
-                                 "  unix_link(<is_dir>, <name>, <link>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with devices\r\n"
-                                 "* word(<rights>), white_spaces(), word(), white_spaces(), word(<user>),\r\n"
-                                 "  white_spaces(), word(<group>), white_spaces(), unix_device(<device>),\r\n"
-                                 "  white_spaces(), day(<date>), all(1), skip_white_spaces(), month_txt(<date>),\r\n"
-                                 "  all(1), skip_white_spaces(), year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with files and directories (skipping user+group with more spaces)\r\n"
-                                 "* if(next_char!=\"l\"), assign(<is_dir>, next_char==\"d\"), word(<rights>),\r\n"
-                                 "  white_spaces(), word(), skip_to_number(), positive_number(<size>),\r\n"
-                                 "  white_spaces(), day(<date>), all(1), skip_white_spaces(), month_txt(<date>),\r\n"
-                                 "  all(1), skip_white_spaces(), year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with links (skipping user+group with more spaces)\r\n"
-                                 "* if(next_char==\"l\"), assign(<is_link>, true), word(<rights>), white_spaces(),\r\n"
-                                 "  word(), skip_to_number(), word(), white_spaces(), day(<date>), all(1),\r\n"
-                                 "  skip_white_spaces(), month_txt(<date>), all(1), skip_white_spaces(),\r\n"
-                                 "  year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), unix_link(<is_dir>, <name>, <link>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with devices (skipping user+group with more spaces)\r\n"
-                                 "* word(<rights>), white_spaces(), word(), skip_to_number(),\r\n"
-                                 "  unix_device(<device>), white_spaces(), day(<date>), all(1),\r\n"
-                                 "  skip_white_spaces(), month_txt(<date>), all(1), skip_white_spaces(),\r\n"
-                                 "  year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# skip first line \"total ????\" - up to 3 words\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("UNIX5", "not syst_contains(\"z/VM \") and not syst_contains(\"OS/2 \") "
-                                          "and not syst_contains(\" MACOS \") and not syst_contains(\"Windows_NT\")",
-                                 11, unix1Columns,
-                                 "# parse lines with files and directories\r\n"
-                                 "* if(next_char!=\"l\"), assign(<is_dir>, next_char==\"d\"), word(<rights>),\r\n"
-                                 "  white_spaces(), word(), white_spaces(), word(<user>), white_spaces(),\r\n"
-                                 "  word(<group>), white_spaces(), positive_number(<size>), white_spaces(),\r\n"
-                                 "  day(<date>), white_spaces(), month_3(<date>), white_spaces(),\r\n"
-                                 "  year(<date>), white_spaces(2),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with files and directories\r\n"
-                                 "* if(next_char!=\"l\"), assign(<is_dir>, next_char==\"d\"), word(<rights>),\r\n"
-                                 "  white_spaces(), word(), white_spaces(), word(<user>), white_spaces(),\r\n"
-                                 "  word(<group>), white_spaces(), positive_number(<size>), white_spaces(),\r\n"
-                                 "  day(<date>), white_spaces(), month_3(<date>), white_spaces(),\r\n"
-                                 "  year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with links\r\n"
-                                 "* if(next_char==\"l\"), assign(<is_link>, true), word(<rights>), white_spaces(),\r\n"
-                                 "  word(), white_spaces(), word(<user>), white_spaces(), word(<group>),\r\n"
-                                 "  white_spaces(), word(), white_spaces(),\r\n"
-                                 "  day(<date>), white_spaces(), month_3(<date>), white_spaces(),\r\n"
-                                 "  year(<date>), white_spaces(2),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), unix_link(<is_dir>, <name>, <link>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with links\r\n"
-                                 "* if(next_char==\"l\"), assign(<is_link>, true), word(<rights>), white_spaces(),\r\n"
-                                 "  word(), white_spaces(), word(<user>), white_spaces(), word(<group>),\r\n"
-                                 "  white_spaces(), word(), white_spaces(),\r\n"
-                                 "  day(<date>), white_spaces(), month_3(<date>), white_spaces(),\r\n"
-                                 "  year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), unix_link(<is_dir>, <name>, <link>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with devices\r\n"
-                                 "* word(<rights>), white_spaces(), word(), white_spaces(), word(<user>),\r\n"
-                                 "  white_spaces(), word(<group>), white_spaces(), unix_device(<device>),\r\n"
-                                 "  white_spaces(), day(<date>), white_spaces(), month_3(<date>), white_spaces(),\r\n"
-                                 "  year(<date>), white_spaces(2),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with devices\r\n"
-                                 "* word(<rights>), white_spaces(), word(), white_spaces(), word(<user>),\r\n"
-                                 "  white_spaces(), word(<group>), white_spaces(), unix_device(<device>),\r\n"
-                                 "  white_spaces(), day(<date>), white_spaces(), month_3(<date>), white_spaces(),\r\n"
-                                 "  year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with files and directories (skipping user+group with more spaces)\r\n"
-                                 "* if(next_char!=\"l\"), assign(<is_dir>, next_char==\"d\"), word(<rights>),\r\n"
-                                 "  white_spaces(), word(), skip_to_number(), positive_number(<size>),\r\n"
-                                 "  white_spaces(), day(<date>), white_spaces(), month_3(<date>), white_spaces(),\r\n"
-                                 "  year(<date>), white_spaces(2),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with files and directories (skipping user+group with more spaces)\r\n"
-                                 "* if(next_char!=\"l\"), assign(<is_dir>, next_char==\"d\"), word(<rights>),\r\n"
-                                 "  white_spaces(), word(), skip_to_number(), positive_number(<size>),\r\n"
-                                 "  white_spaces(), day(<date>), white_spaces(), month_3(<date>), white_spaces(),\r\n"
-                                 "  year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with links (skipping user+group with more spaces)\r\n"
-                                 "* if(next_char==\"l\"), assign(<is_link>, true), word(<rights>), white_spaces(),\r\n"
-                                 "  word(), skip_to_number(), word(), white_spaces(), day(<date>), white_spaces(),\r\n"
-                                 "  month_3(<date>), white_spaces(), year(<date>), white_spaces(2),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), unix_link(<is_dir>, <name>, <link>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with links (skipping user+group with more spaces)\r\n"
-                                 "* if(next_char==\"l\"), assign(<is_link>, true), word(<rights>), white_spaces(),\r\n"
-                                 "  word(), skip_to_number(), word(), white_spaces(), day(<date>), white_spaces(),\r\n"
-                                 "  month_3(<date>), white_spaces(), year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), unix_link(<is_dir>, <name>, <link>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with devices (skipping user+group with more spaces)\r\n"
-                                 "* word(<rights>), white_spaces(), word(), skip_to_number(),\r\n"
-                                 "  unix_device(<device>), white_spaces(), day(<date>), white_spaces(),\r\n"
-                                 "  month_3(<date>), white_spaces(), year(<date>), white_spaces(2),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with devices (skipping user+group with more spaces)\r\n"
-                                 "* word(<rights>), white_spaces(), word(), skip_to_number(),\r\n"
-                                 "  unix_device(<device>), white_spaces(), day(<date>), white_spaces(),\r\n"
-                                 "  month_3(<date>), white_spaces(), year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# skip first line \"total ????\" - up to 3 words\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    const char* xbox360Columns[] = {"1,name,0,\\0,0,\\0,1,\\0",   // name
-                                    "1,ext,1,\\0,1,\\0,2,\\0",    // extension
-                                    "1,size,2,\\0,2,\\0,3,\\0",   // size
-                                    "0,type,5,\\0,5,\\0,6,\\0",   // type
-                                    "1,date,3,\\0,3,\\0,4,\\0",   // date
-                                    "1,time,4,\\0,4,\\0,5,\\0,0", // time
-                                    "1,rights,6,\\0,6,\\0,7,\\0", // rights
-                                    "1,user,7,\\0,7,\\0,7,\\0",   // user
-                                    "1,group,8,\\0,8,\\0,7,\\0"}; // group
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("Xbox 360", "not syst_contains(\"z/VM \") and not syst_contains(\"OS/2 \") "
-                                             "and not syst_contains(\" MACOS \") and not syst_contains(\"Windows_NT\")",
-                                 9, xbox360Columns,
-                                 "# parse lines with files and directories\r\n"
-                                 "* if(next_char!=\"l\"), assign(<is_dir>, next_char==\"d\"), word(<rights>),\r\n"
-                                 "  white_spaces(), word(), white_spaces(), word(<user>), white_spaces(),\r\n"
-                                 "  word(<group>), white_spaces(), positive_number(<size>), white_spaces(),\r\n"
-                                 "  year(<date>), all(1), month(<date>), all(1), day(<date>), all(1), time(<time>),\r\n"
-                                 "  white_spaces(1), assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    const char* unix6Columns[] = {"1,name,0,\\0,0,\\0,1,\\0",    // name
-                                  "1,ext,1,\\0,1,\\0,2,\\0",     // extension
-                                  "1,size,2,\\0,2,\\0,3,\\0",    // size
-                                  "0,type,5,\\0,5,\\0,6,\\0",    // type
-                                  "1,rights,6,\\0,6,\\0,7,\\0",  // rights
-                                  "1,link,12,\\0,12,\\0,7,\\0",  // link target
-                                  "1,user,7,\\0,7,\\0,7,\\0",    // user
-                                  "1,group,8,\\0,8,\\0,7,\\0",   // group
-                                  "0,device,9,\\0,9,\\0,7,\\0"}; // device minor/major number
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("UNIX6", "not syst_contains(\"z/VM \") and not syst_contains(\"OS/2 \") "
-                                          "and not syst_contains(\" MACOS \") and not syst_contains(\"Windows_NT\")",
-                                 9, unix6Columns,
-                                 "# parse lines with files and directories\r\n"
-                                 "* if(next_char!=\"l\"), assign(<is_dir>, next_char==\"d\"), word(<rights>),\r\n"
-                                 "  white_spaces(), word(), white_spaces(), word(<user>), white_spaces(),\r\n"
-                                 "  word(<group>), white_spaces(), positive_number(<size>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with links\r\n"
-                                 "* if(next_char==\"l\"), assign(<is_link>, true), word(<rights>), white_spaces(),\r\n"
-                                 "  word(), white_spaces(), word(<user>), white_spaces(), word(<group>),\r\n"
-                                 "  white_spaces(), word(), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), unix_link(<is_dir>, <name>, <link>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with devices\r\n"
-                                 "* word(<rights>), white_spaces(), word(), white_spaces(), word(<user>),\r\n"
-                                 "  white_spaces(), word(<group>), white_spaces(), unix_device(<device>),\r\n"
-                                 "  white_spaces(1), assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with files and directories (skipping user+group with more spaces)\r\n"
-                                 "* if(next_char!=\"l\"), assign(<is_dir>, next_char==\"d\"), word(<rights>),\r\n"
-                                 "  white_spaces(), word(), skip_to_number(), positive_number(<size>),\r\n"
-                                 "  white_spaces(1), assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with links (skipping user+group with more spaces)\r\n"
-                                 "* if(next_char==\"l\"), assign(<is_link>, true), word(<rights>), white_spaces(),\r\n"
-                                 "  word(), skip_to_number(), word(), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), unix_link(<is_dir>, <name>, <link>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with devices (skipping user+group with more spaces)\r\n"
-                                 "* word(<rights>), white_spaces(), word(), skip_to_number(),\r\n"
-                                 "  unix_device(<device>), white_spaces(1),\r\n"
-                                 "  assign(<is_hidden>, next_char==\".\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# skip first line \"total ????\" - up to 3 words\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    const char* netwareColumns[] = {"1,name,0,\\0,0,\\0,1,\\0",   // name
-                                    "1,ext,1,\\0,1,\\0,2,\\0",    // extension
-                                    "1,size,2,\\0,2,\\0,3,\\0",   // size
-                                    "0,type,5,\\0,5,\\0,6,\\0",   // type
-                                    "1,date,3,\\0,3,\\0,4,\\0",   // date
-                                    "1,time,4,\\0,4,\\0,9,\\0,0", // time
-                                    "1,rights,6,\\0,6,\\0,7,\\0", // rights
-                                    "1,user,7,\\0,7,\\0,7,\\0"};  // user
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("Netware", "not syst_contains(\"z/VM \") and not syst_contains(\"OS/2 \") "
-                                            "and not syst_contains(\" MACOS \") and not syst_contains(\"Windows_NT\")",
-                                 8, netwareColumns,
-                                 "# parse lines from NETWARE FTP server\r\n"
-                                 "* assign(<is_dir>, next_char==\"d\"), all(1), white_spaces(1), all_to(\"[\"),\r\n"
-                                 "  all_up_to(<rights>, \"]\"), white_spaces(1), all(<user>, 28),\r\n"
-                                 "  cut_white_spaces_end(<user>), white_spaces(), positive_number(<size>),\r\n"
-                                 "  white_spaces(), month_3(<date>), white_spaces(), day(<date>),\r\n"
-                                 "  white_spaces(), year_or_time(<date>, <time>), white_spaces(1),\r\n"
-                                 "  rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines from Hellsoft FTP server\r\n"
-                                 "* assign(<is_dir>, next_char==\"d\"), all_to(\"[\"), all_up_to(<rights>, \"]\"),\r\n"
-                                 "  white_spaces(), word(), white_spaces(), word(<user>),\r\n"
-                                 "  white_spaces(), positive_number(<size>), white_spaces(), month_3(<date>),\r\n"
-                                 "  white_spaces(), day(<date>), white_spaces(),\r\n"
-                                 "  year_or_time(<date>, <time>), white_spaces(1), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# skip first line e.g. \"total ???\" or \"--- listing ---\" - up to 3 words\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    const char* vms1Columns[] = {"1,name,0,\\0,0,\\0,1,\\0",         // name
-                                 "1,ext,1,\\0,1,\\0,2,\\0",          // extension
-                                 "1,blksize,10,\\0,10,\\0,10,\\0,0", // block size
-                                 "0,type,5,\\0,5,\\0,6,\\0",         // type
-                                 "1,date,3,\\0,3,\\0,8,\\0,0",       // date
-                                 "1,time,4,\\0,4,\\0,9,\\0,0",       // time
-                                 "1,rights,6,\\0,6,\\0,7,\\0",       // rights
-                                 "1,user,7,\\0,7,\\0,7,\\0"};        // user
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("VMS1", "syst_contains(\" VMS \")",
-                                 8, vms1Columns,
-                                 "# parse lines with directories\r\n"
-                                 "* all_up_to(<name>, \".DIR;1\"), assign(<is_dir>, true),\r\n"
-                                 "  white_spaces_and_line_ends(), number(<blksize>),\r\n"
-                                 "  white_spaces(), day(<date>), all(1), month_3(<date>), all(1),\r\n"
-                                 "  year(<date>), white_spaces(), time(<time>), all_to(\"[\"),\r\n"
-                                 "  all_up_to(<user>, \"]\"), all_to(\"(\"), all_up_to(<rights>, \")\");\r\n"
-                                 "\r\n"
-                                 "# parse lines with directories with corrupted user string\r\n"
-                                 "* all_up_to(<name>, \".DIR;1\"), assign(<is_dir>, true),\r\n"
-                                 "  white_spaces_and_line_ends(), number(<blksize>),\r\n"
-                                 "  white_spaces(), day(<date>), all(1), month_3(<date>), all(1),\r\n"
-                                 "  year(<date>), white_spaces(), time(<time>), all_to(\"[\"),\r\n"
-                                 "  all_up_to(<user>, \"(\"), cut_white_spaces_end(<user>),\r\n"
-                                 "  all_up_to(<rights>, \")\");\r\n"
-                                 "\r\n"
-                                 "# parse lines with files\r\n"
-                                 "* word(<name>), white_spaces_and_line_ends(), number(<blksize>),\r\n"
-                                 "  white_spaces(), day(<date>), all(1), month_3(<date>),\r\n"
-                                 "  all(1), year(<date>), white_spaces(), time(<time>), all_to(\"[\"),\r\n"
-                                 "  all_up_to(<user>, \"]\"), all_to(\"(\"), all_up_to(<rights>, \")\");\r\n"
-                                 "\r\n"
-                                 "# parse lines with files with corrupted user string\r\n"
-                                 "* word(<name>), white_spaces_and_line_ends(), number(<blksize>),\r\n"
-                                 "  white_spaces(), day(<date>), all(1), month_3(<date>),\r\n"
-                                 "  all(1), year(<date>), white_spaces(), time(<time>), all_to(\"[\"),\r\n"
-                                 "  all_up_to(<user>, \"(\"), cut_white_spaces_end(<user>),\r\n"
-                                 "  all_up_to(<rights>, \")\");\r\n"
-                                 "\r\n"
-                                 "# skip first line e.g. \"Directory ???:[???]\" - up to 3 words\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "\r\n"
-                                 "# skip last line e.g. \"Total of ??? files, ??? blocks.\"\r\n"
-                                 "* if(last_nonempty_line), if(first_nonempty_line == false), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# skip last line containing \"Total of ???\"\r\n"
-                                 "* if(last_nonempty_line), skip_white_spaces(), if(next_word eq \"Total\"),\r\n"
-                                 "  word(), skip_white_spaces(), if(next_word eq \"of\"), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# parse lines with inaccessible directories (based on char \"%\")\r\n"
-                                 "* all_up_to(<name>, \".DIR;1\"), assign(<is_dir>, true),\r\n"
-                                 "  white_spaces_and_line_ends(), if(next_char==\"%\"), rest_of_line(<rights>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with inaccessible directories (based on word \"privilege\")\r\n"
-                                 "* all_up_to(<name>, \".DIR;1\"), assign(<is_dir>, true),\r\n"
-                                 "  white_spaces_and_line_ends(), all_to(<rights>, \"privilege\"),\r\n"
-                                 "  add_string_to_column(<rights>, rest_of_line), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# parse lines with inaccessible files (based on char \"%\")\r\n"
-                                 "* word(<name>), white_spaces_and_line_ends(), if(next_char==\"%\"),\r\n"
-                                 "  rest_of_line(<rights>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with inaccessible files (based on word \"privilege\")\r\n"
-                                 "* word(<name>), white_spaces_and_line_ends(), all_to(<rights>, \"privilege\"),\r\n"
-                                 "  add_string_to_column(<rights>, rest_of_line), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    const char* vms2Columns[] = {"1,name,0,\\0,0,\\0,1,\\0",            // name
-                                 "1,ext,1,\\0,1,\\0,2,\\0",             // extension
-                                 "1,blksize,10,\\0,10,\\0,10,\\0,0",    // block size
-                                 "0,type,5,\\0,5,\\0,6,\\0",            // type
-                                 "1,date,3,\\0,3,\\0,8,\\0,0",          // date
-                                 "1,time,4,\\0,4,\\0,9,\\0,0",          // time
-                                 "1,rights,6,\\0,6,\\0,7,\\0",          // rights
-                                 "1,user,7,\\0,7,\\0,7,\\0",            // user
-                                 "1,allocblks,11,\\0,11,\\0,10,\\0,0"}; // allocated blocks
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("VMS2", "syst_contains(\" VMS \")",
-                                 9, vms2Columns,
-                                 "# parse lines with directories\r\n"
-                                 "* all_up_to(<name>, \".DIR;1\"), assign(<is_dir>, true),\r\n"
-                                 "  white_spaces_and_line_ends(), number(<blksize>),\r\n"
-                                 "  all(1), number(<allocblks>), white_spaces(), day(<date>), all(1),\r\n"
-                                 "  month_3(<date>), all(1), year(<date>), white_spaces(), time(<time>),\r\n"
-                                 "  all_to(\"[\"), all_up_to(<user>, \"]\"), all_to(\"(\"), all_up_to(<rights>, \")\");\r\n"
-                                 "\r\n"
-                                 "# parse lines with directories with corrupted user string\r\n"
-                                 "* all_up_to(<name>, \".DIR;1\"), assign(<is_dir>, true),\r\n"
-                                 "  white_spaces_and_line_ends(), number(<blksize>),\r\n"
-                                 "  all(1), number(<allocblks>), white_spaces(), day(<date>), all(1),\r\n"
-                                 "  month_3(<date>), all(1), year(<date>), white_spaces(), time(<time>),\r\n"
-                                 "  all_to(\"[\"), all_up_to(<user>, \"(\"), cut_white_spaces_end(<user>),\r\n"
-                                 "  all_up_to(<rights>, \")\");\r\n"
-                                 "\r\n"
-                                 "# parse lines with files\r\n"
-                                 "* word(<name>), white_spaces_and_line_ends(), number(<blksize>),\r\n"
-                                 "  all(1), number(<allocblks>), white_spaces(), day(<date>), all(1),\r\n"
-                                 "  month_3(<date>), all(1), year(<date>), white_spaces(), time(<time>),\r\n"
-                                 "  all_to(\"[\"), all_up_to(<user>, \"]\"), all_to(\"(\"), all_up_to(<rights>, \")\");\r\n"
-                                 "\r\n"
-                                 "# parse lines with files with corrupted user string\r\n"
-                                 "* word(<name>), white_spaces_and_line_ends(), number(<blksize>),\r\n"
-                                 "  all(1), number(<allocblks>), white_spaces(), day(<date>), all(1),\r\n"
-                                 "  month_3(<date>), all(1), year(<date>), white_spaces(), time(<time>),\r\n"
-                                 "  all_to(\"[\"), all_up_to(<user>, \"(\"), cut_white_spaces_end(<user>),\r\n"
-                                 "  all_up_to(<rights>, \")\");\r\n"
-                                 "\r\n"
-                                 "# skip first line e.g. \"Directory ???:[???]\" - up to 3 words\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "\r\n"
-                                 "# skip last line e.g. \"Total of ??? files, ??? blocks.\"\r\n"
-                                 "* if(last_nonempty_line), if(first_nonempty_line == false), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# skip last line containing \"Total of ???\"\r\n"
-                                 "* if(last_nonempty_line), skip_white_spaces(), if(next_word eq \"Total\"),\r\n"
-                                 "  word(), skip_white_spaces(), if(next_word eq \"of\"), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# parse lines with inaccessible directories (based on char \"%\")\r\n"
-                                 "* all_up_to(<name>, \".DIR;1\"), assign(<is_dir>, true),\r\n"
-                                 "  white_spaces_and_line_ends(), if(next_char==\"%\"), rest_of_line(<rights>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with inaccessible directories (based on word \"privilege\")\r\n"
-                                 "* all_up_to(<name>, \".DIR;1\"), assign(<is_dir>, true),\r\n"
-                                 "  white_spaces_and_line_ends(), all_to(<rights>, \"privilege\"),\r\n"
-                                 "  add_string_to_column(<rights>, rest_of_line), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# parse lines with inaccessible files (based on char \"%\")\r\n"
-                                 "* word(<name>), white_spaces_and_line_ends(), if(next_char==\"%\"),\r\n"
-                                 "  rest_of_line(<rights>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with inaccessible files (based on word \"privilege\")\r\n"
-                                 "* word(<name>), white_spaces_and_line_ends(), all_to(<rights>, \"privilege\"),\r\n"
-                                 "  add_string_to_column(<rights>, rest_of_line), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    const char* vms3Columns[] = {"1,name,0,\\0,0,\\0,1,\\0",          // name
-                                 "1,ext,1,\\0,1,\\0,2,\\0",           // extension
-                                 "1,size,2,\\0,2,\\0,3,\\0",          // size
-                                 "0,type,5,\\0,5,\\0,6,\\0",          // type
-                                 "1,date,3,\\0,3,\\0,8,\\0,0",        // date
-                                 "1,time,4,\\0,4,\\0,9,\\0,0",        // time
-                                 "1,rights,6,\\0,6,\\0,7,\\0",        // rights
-                                 "1,blksize,10,\\0,10,\\0,10,\\0,0"}; // block size
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("VMS3", "syst_contains(\" VMS \")",
-                                 8, vms3Columns,
-                                 "# parse lines with directories\r\n"
-                                 "* all_up_to(<name>, \".DIR;1\"), assign(<is_dir>, true),\r\n"
-                                 "  white_spaces_and_line_ends(), day(<date>), all(1),\r\n"
-                                 "  month_3(<date>), all(1), year(<date>), white_spaces(), time(<time>),\r\n"
-                                 "  white_spaces(), positive_number(<size>), all(1), number(<blksize>), all_to(\"(\"),\r\n"
-                                 "  all_up_to(<rights>, \")\");\r\n"
-                                 "\r\n"
-                                 "# parse lines with files\r\n"
-                                 "* word(<name>), white_spaces_and_line_ends(), day(<date>),\r\n"
-                                 "  all(1), month_3(<date>), all(1), year(<date>), white_spaces(), time(<time>),\r\n"
-                                 "  white_spaces(), positive_number(<size>), all(1), number(<blksize>), all_to(\"(\"),\r\n"
-                                 "  all_up_to(<rights>, \")\");\r\n"
-                                 "\r\n"
-                                 "# skip first line e.g. \"Directory ???:[???]\" - up to 3 words\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "\r\n"
-                                 "# skip last line e.g. \"Total of ??? files, ??? blocks.\"\r\n"
-                                 "* if(last_nonempty_line), if(first_nonempty_line == false), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# skip last line containing \"Total of ???\"\r\n"
-                                 "* if(last_nonempty_line), skip_white_spaces(), if(next_word eq \"Total\"),\r\n"
-                                 "  word(), skip_white_spaces(), if(next_word eq \"of\"), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# parse lines with inaccessible directories (based on char \"%\")\r\n"
-                                 "* all_up_to(<name>, \".DIR;1\"), assign(<is_dir>, true),\r\n"
-                                 "  white_spaces_and_line_ends(), if(next_char==\"%\"), rest_of_line(<rights>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with inaccessible directories (based on word \"privilege\")\r\n"
-                                 "* all_up_to(<name>, \".DIR;1\"), assign(<is_dir>, true),\r\n"
-                                 "  white_spaces_and_line_ends(), all_to(<rights>, \"privilege\"),\r\n"
-                                 "  add_string_to_column(<rights>, rest_of_line), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# parse lines with inaccessible files (based on char \"%\")\r\n"
-                                 "* word(<name>), white_spaces_and_line_ends(), if(next_char==\"%\"),\r\n"
-                                 "  rest_of_line(<rights>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with inaccessible files (based on word \"privilege\")\r\n"
-                                 "* word(<name>), white_spaces_and_line_ends(), all_to(<rights>, \"privilege\"),\r\n"
-                                 "  add_string_to_column(<rights>, rest_of_line), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    const char* vms4Columns[] = {"1,name,0,\\0,0,\\0,1,\\0",         // name
-                                 "1,ext,1,\\0,1,\\0,2,\\0",          // extension
-                                 "1,blksize,10,\\0,10,\\0,10,\\0,0", // block size
-                                 "0,type,5,\\0,5,\\0,6,\\0",         // type
-                                 "1,date,3,\\0,3,\\0,8,\\0,0",       // date
-                                 "1,time,4,\\0,4,\\0,9,\\0,0"};      // time
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("VMS4", "syst_contains(\" VMS \")",
-                                 6, vms4Columns,
-                                 "# parse lines with directories\r\n"
-                                 "* all_up_to(<name>, \".DIR;1\"), assign(<is_dir>, true),\r\n"
-                                 "  white_spaces_and_line_ends(), number(<blksize>),\r\n"
-                                 "  white_spaces(), day(<date>), all(1), month_3(<date>), all(1),\r\n"
-                                 "  year(<date>), white_spaces(), time(<time>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with files\r\n"
-                                 "* word(<name>), white_spaces_and_line_ends(), number(<blksize>),\r\n"
-                                 "  white_spaces(), day(<date>), all(1), month_3(<date>),\r\n"
-                                 "  all(1), year(<date>), white_spaces(), time(<time>);\r\n"
-                                 "\r\n"
-                                 "# skip first line e.g. \"Directory ???:[???]\" - up to 3 words\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces();\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), word(), skip_white_spaces(),\r\n"
-                                 "  word(), skip_white_spaces(), word(), skip_white_spaces();\r\n"
-                                 "\r\n"
-                                 "# skip last line e.g. \"Total of ??? files, ??? blocks.\"\r\n"
-                                 "* if(last_nonempty_line), if(first_nonempty_line == false), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# skip last line containing \"Total of ???\"\r\n"
-                                 "* if(last_nonempty_line), skip_white_spaces(), if(next_word eq \"Total\"),\r\n"
-                                 "  word(), skip_white_spaces(), if(next_word eq \"of\"), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# parse lines with inaccessible directories (based on char \"%\")\r\n"
-                                 "* all_up_to(<name>, \".DIR;1\"), assign(<is_dir>, true),\r\n"
-                                 "  white_spaces_and_line_ends(), if(next_char==\"%\"), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# parse lines with inaccessible directories (based on word \"privilege\")\r\n"
-                                 "* all_up_to(<name>, \".DIR;1\"), assign(<is_dir>, true),\r\n"
-                                 "  white_spaces_and_line_ends(), all_to(\"privilege\"), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# parse lines with inaccessible files (based on char \"%\")\r\n"
-                                 "* word(<name>), white_spaces_and_line_ends(), if(next_char==\"%\"),\r\n"
-                                 "  rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# parse lines with inaccessible files (based on word \"privilege\")\r\n"
-                                 "* word(<name>), white_spaces_and_line_ends(), all_to(\"privilege\"),\r\n"
-                                 "  rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    const char* netPrezColumns[] = {"1,name,0,\\0,0,\\0,1,\\0",    // name
-                                    "1,ext,1,\\0,1,\\0,2,\\0",     // extension
-                                    "1,size,2,\\0,2,\\0,3,\\0",    // size
-                                    "0,type,5,\\0,5,\\0,6,\\0",    // type
-                                    "1,date,3,\\0,3,\\0,4,\\0",    // date
-                                    "1,time,4,\\0,4,\\0,9,\\0,0",  // time
-                                    "1,rights,6,\\0,6,\\0,7,\\0"}; // rights
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("NetPresenz", "welcome_contains(\" NetPresenz \") and syst_contains(\" MACOS \")",
-                                 7, netPrezColumns,
-                                 "# parse lines with files\r\n"
-                                 "* if(next_char!=\"d\"), all(<rights>, 10), white_spaces(), word(),\r\n"
-                                 "  white_spaces(), word(), white_spaces(), positive_number(<size>),\r\n"
-                                 "  white_spaces(), month_3(<date>), white_spaces(),\r\n"
-                                 "  day(<date>), white_spaces(), year_or_time(<date>, <time>),\r\n"
-                                 "  white_spaces(1), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with directories\r\n"
-                                 "* if(next_char==\"d\"), assign(<is_dir>, true), all(<rights>, 10), white_spaces(),\r\n"
-                                 "  word(), white_spaces(), positive_number(<size>), white_spaces(),\r\n"
-                                 "  month_3(<date>), white_spaces(), day(<date>), white_spaces(),\r\n"
-                                 "  year_or_time(<date>, <time>), white_spaces(1), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    const char* IBMz_VM1Columns[] = {"1,name,0,\\0,0,\\0,1,\\0",         // name
-                                     "1,ext,5,\\0,5,\\0,2,\\0",          // type (extension)
-                                     "1,format,13,\\0,13,\\0,7,\\0",     // format
-                                     "1,lrecl,14,\\0,14,\\0,10,\\0,0",   // lrecl
-                                     "1,records,15,\\0,15,\\0,10,\\0,0", // records
-                                     "1,blocks,10,\\0,10,\\0,10,\\0,0",  // blocks
-                                     "1,date,3,\\0,3,\\0,8,\\0",         // date
-                                     "1,time,4,\\0,4,\\0,9,\\0,0"};      // time
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("IBM z/VM (CMS) 1", NULL,
-                                 8, IBMz_VM1Columns,
-                                 "# parse lines with directories\r\n"
-                                 "* word(<name>), all_to(\" DIR\"), assign(<is_dir>, true), white_spaces(),\r\n"
-                                 "  word(), white_spaces(), word(), white_spaces(), word(), white_spaces(),\r\n"
-                                 "  year(<date>), all(1), month(<date>), all(1), day(<date>),\r\n"
-                                 "  white_spaces(), time(<time>), white_spaces(), word();\r\n"
-                                 "\r\n"
-                                 "# parse lines with files\r\n"
-                                 "* word(<name>), white_spaces(), add_string_to_column(<name>, \".\"),\r\n"
-                                 "  add_string_to_column(<name>, next_word), word(), white_spaces(),\r\n"
-                                 "  word(<format>), white_spaces(), number(<lrecl>), white_spaces(),\r\n"
-                                 "  number(<records>), white_spaces(), number(<blocks>), white_spaces(),\r\n"
-                                 "  year(<date>), all(1), month(<date>), all(1), day(<date>),\r\n"
-                                 "  white_spaces(), time(<time>), white_spaces(), word();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    const char* IBMz_VM2Columns[] = {"1,name,0,\\0,0,\\0,1,\\0",         // name
-                                     "1,ext,5,\\0,5,\\0,2,\\0",          // type (extension)
-                                     "1,format,13,\\0,13,\\0,7,\\0",     // format
-                                     "1,lrecl,14,\\0,14,\\0,10,\\0,0",   // lrecl
-                                     "1,records,15,\\0,15,\\0,10,\\0,0", // records
-                                     "1,blocks,10,\\0,10,\\0,10,\\0,0",  // blocks
-                                     "1,date,3,\\0,3,\\0,8,\\0",         // date
-                                     "1,time,4,\\0,4,\\0,9,\\0,0",       // time
-                                     "1,user,7,\\0,7,\\0,7,\\0"};        // user
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("IBM z/VM (CMS) 2", NULL,
-                                 9, IBMz_VM2Columns,
-                                 "# parse lines with directories\r\n"
-                                 "* word(<name>), all_to(\" DISK\"), assign(<is_dir>, true), white_spaces(),\r\n"
-                                 "  word(<format>), white_spaces(), number(<lrecl>), white_spaces(),\r\n"
-                                 "  number(<records>), white_spaces(), number(<blocks>), white_spaces(),\r\n"
-                                 "  month(<date>), all(1), day(<date>), all(1), year(<date>),\r\n"
-                                 "  white_spaces(), time(<time>), white_spaces(), word(<user>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with files\r\n"
-                                 "* word(<name>), white_spaces(), add_string_to_column(<name>, \".\"),\r\n"
-                                 "  add_string_to_column(<name>, next_word), word(), white_spaces(),\r\n"
-                                 "  word(<format>), white_spaces(), number(<lrecl>), white_spaces(),\r\n"
-                                 "  number(<records>), white_spaces(), number(<blocks>), white_spaces(),\r\n"
-                                 "  month(<date>), all(1), day(<date>), all(1), year(<date>),\r\n"
-                                 "  white_spaces(), time(<time>), white_spaces(), word(<user>);\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    const char* IBMz_VM3Columns[] = {"1,name,0,\\0,0,\\0,1,\\0",         // name
-                                     "1,ext,5,\\0,5,\\0,2,\\0",          // type (extension)
-                                     "1,fm,16,\\0,16,\\0,7,\\0",         // filemode
-                                     "1,format,13,\\0,13,\\0,7,\\0",     // format
-                                     "1,lrecl,14,\\0,14,\\0,10,\\0,0",   // lrecl
-                                     "1,records,15,\\0,15,\\0,10,\\0,0", // records
-                                     "1,blocks,10,\\0,10,\\0,10,\\0,0",  // blocks
-                                     "1,date,3,\\0,3,\\0,8,\\0",         // date
-                                     "1,time,4,\\0,4,\\0,9,\\0,0"};      // time
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("IBM z/VM (CMS) 3", "syst_contains(\"z/VM\")",
-                                 9, IBMz_VM3Columns,
-                                 "# parse lines with directories\r\n"
-                                 "* word(<name>), white_spaces(), word(<fm>), all_to(\" DIR\"),\r\n"
-                                 "  assign(<is_dir>, true), white_spaces(), word(), white_spaces(),\r\n"
-                                 "  word(), white_spaces(), word(), white_spaces(), month(<date>),\r\n"
-                                 "  all(1), day(<date>), all(1), year(<date>), white_spaces(),\r\n"
-                                 "  time(<time>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with files\r\n"
-                                 "* word(<name>), white_spaces(), add_string_to_column(<name>, \".\"),\r\n"
-                                 "  add_string_to_column(<name>, next_word), word(), white_spaces(),\r\n"
-                                 "  word(<fm>), white_spaces(), word(<format>), white_spaces(),\r\n"
-                                 "  number(<lrecl>), white_spaces(), number(<records>), white_spaces(),\r\n"
-                                 "  number(<blocks>), white_spaces(), month(<date>), all(1),\r\n"
-                                 "  day(<date>), all(1), year(<date>), white_spaces(), time(<time>);\r\n"
-                                 "\r\n"
-                                 "# skip first line \"Filename FileType Fm ...\"\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), if (next_word eq \"Filename\"), word(),\r\n"
-                                 "  skip_white_spaces(), if (next_word eq \"FileType\"), word(), skip_white_spaces(),\r\n"
-                                 "  if (next_word eq \"Fm\"), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    const char* mvs1Columns[] = {"1,name,0,\\0,0,\\0,1,\\0",         // name
-                                 "1,dsorg,23,\\0,23,\\0,7,\\0",      // dsorg
-                                 "1,date,3,\\0,3,\\0,8,\\0,0",       // date
-                                 "1,volume,17,\\0,17,\\0,7,\\0",     // volume
-                                 "1,unit,18,\\0,18,\\0,7,\\0",       // unit
-                                 "1,extents,19,\\0,19,\\0,10,\\0,0", // extents
-                                 "1,used,20,\\0,20,\\0,10,\\0,0",    // used
-                                 "1,recfm,21,\\0,21,\\0,7,\\0",      // recfm
-                                 "1,lrecl,14,\\0,14,\\0,10,\\0,0",   // lrecl
-                                 "1,blksz,22,\\0,22,\\0,10,\\0,0"};  // blksz
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("MVS1", "syst_contains(\" MVS \")",
-                                 10, mvs1Columns,
-                                 "# data sets\r\n"
-                                 "* word(<volume>), white_spaces(), word(<unit>), white_spaces(), year(<date>),\r\n"
-                                 "  all(1), month(<date>), all(1), day(<date>), white_spaces(), number(<extents>),\r\n"
-                                 "  white_spaces(), number(<used>), white_spaces(), word(<recfm>), white_spaces(),\r\n"
-                                 "  number(<lrecl>), white_spaces(), number(<blksz>), white_spaces(),\r\n"
-                                 "  word(<dsorg>), assign(<is_dir>, <dsorg> eq \"PO\"), white_spaces(), word(<name>);\r\n"
-                                 "\r\n"
-                                 "# data sets with \"**NONE**\" date\r\n"
-                                 "* word(<volume>), white_spaces(), word(<unit>), white_spaces(),\r\n"
-                                 "  if(next_word eq \"**NONE**\"), word(), white_spaces(), number(<extents>),\r\n"
-                                 "  white_spaces(), number(<used>), white_spaces(), word(<recfm>),\r\n"
-                                 "  white_spaces(), number(<lrecl>), white_spaces(), number(<blksz>),\r\n"
-                                 "  white_spaces(), word(<dsorg>), assign(<is_dir>, <dsorg> eq \"PO\"),\r\n"
-                                 "  white_spaces(), word(<name>);\r\n"
-                                 "\r\n"
-                                 "# \"Migrated\" data sets\r\n"
-                                 "* if(next_word eq \"Migrated\"), word(<unit>), white_spaces(),\r\n"
-                                 "  word(<name>);\r\n"
-                                 "\r\n"
-                                 "# \"MIGRAT\" lines\r\n"
-                                 "* if(next_word eq \"MIGRAT\"), all(<unit>, 55), white_spaces(),\r\n"
-                                 "  cut_white_spaces_end(<unit>), word(<name>);\r\n"
-                                 "\r\n"
-                                 "# \"ARCIVE\" lines\r\n"
-                                 "* if(next_word eq \"ARCIVE\"), all(<unit>, 55), white_spaces(),\r\n"
-                                 "  cut_white_spaces_end(<unit>), word(<name>);\r\n"
-                                 "\r\n"
-                                 "# data sets with joined numbers from \"Ext\" and \"Used\" columns\r\n"
-                                 "* word(<volume>), white_spaces(), word(<unit>), white_spaces(), year(<date>),\r\n"
-                                 "  all(1), month(<date>), all(1), day(<date>), white_spaces(), word(),\r\n"
-                                 "  white_spaces(), word(<recfm>), white_spaces(), number(<lrecl>), white_spaces(),\r\n"
-                                 "  number(<blksz>), white_spaces(), word(<dsorg>), assign(<is_dir>, <dsorg> eq \"PO\"),\r\n"
-                                 "  white_spaces(), word(<name>);\r\n"
-                                 "\r\n"
-                                 "# data sets with \"**NONE**\" date and with joined numbers from \"Ext\" and \"Used\" columns\r\n"
-                                 "* word(<volume>), white_spaces(), word(<unit>), white_spaces(),\r\n"
-                                 "  if(next_word eq \"**NONE**\"), word(), white_spaces(), word(), white_spaces(),\r\n"
-                                 "  word(<recfm>), white_spaces(), number(<lrecl>), white_spaces(), number(<blksz>),\r\n"
-                                 "  white_spaces(), word(<dsorg>), assign(<is_dir>, <dsorg> eq \"PO\"),\r\n"
-                                 "  white_spaces(), word(<name>);\r\n"
-                                 "\r\n"
-                                 "# \"Pseudo directories\"\r\n"
-                                 "* if(next_word eq \"Pseudo\"), word(), white_spaces(1), if(next_word eq \"Directory\"),\r\n"
-                                 "  assign(<is_dir>, true), word(), white_spaces(), word(<name>);\r\n"
-                                 "\r\n"
-                                 "# \"Error determining attributes\"\r\n"
-                                 "* if(next_word eq \"Error\"), word(), white_spaces(1), if(next_word eq \"determining\"),\r\n"
-                                 "  word(), white_spaces(1), if(next_word eq \"attributes\"), word(), white_spaces(),\r\n"
-                                 "  assign(<unit>, \"Error determining attributes\"), word(<name>);\r\n"
-                                 "\r\n"
-                                 "# Volume + \"Error determining attributes\"\r\n"
-                                 "* word(<volume>), white_spaces(), if(next_word eq \"Error\"), word(),\r\n"
-                                 "  white_spaces(1), if(next_word eq \"determining\"), word(), white_spaces(1),\r\n"
-                                 "  if(next_word eq \"attributes\"), word(), white_spaces(),\r\n"
-                                 "  assign(<unit>, \"Error determining attributes\"), word(<name>);\r\n"
-                                 "\r\n"
-                                 "# Volume + \"Not Mounted\"\r\n"
-                                 "* word(<volume>), white_spaces(), if(next_word eq \"Not\"), word(),\r\n"
-                                 "  white_spaces(1), if(next_word eq \"Mounted\"), word(), white_spaces(),\r\n"
-                                 "  assign(<unit>, \"Not Mounted\"), word(<name>);\r\n"
-                                 "\r\n"
-                                 "# Volume + Unit + \"<\" + any error message + \" > \" + Dsname\r\n"
-                                 "* all(<volume>, 6), white_spaces(1), all(<unit>, 6), white_spaces(),\r\n"
-                                 "  if(next_word == \"<\"), all_to(<name>, \" > \"), cut_white_spaces(<volume>),\r\n"
-                                 "  cut_white_spaces(<unit>), add_string_to_column(<unit>, \" \"),\r\n"
-                                 "  add_string_to_column(<unit>, <name>), cut_white_spaces_end(<unit>),\r\n"
-                                 "  skip_white_spaces(), word(<name>);\r\n"
-                                 "\r\n"
-                                 "# optional columns: Volume + Unit + Recfm + Dsorg; Dsname is necessary\r\n"
-                                 "* all(<volume>, 6), white_spaces(1), all(<unit>, 6), white_spaces(20),\r\n"
-                                 "  all(<recfm>, 5), white_spaces(12), all(<dsorg>, 5), white_spaces(),\r\n"
-                                 "  word(<name>), cut_white_spaces(<volume>), cut_white_spaces(<unit>),\r\n"
-                                 "  cut_white_spaces(<recfm>), cut_white_spaces(<dsorg>);\r\n"
-                                 "\r\n"
-                                 "# skip first line \"Volume Unit Referred ...\"\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), if (next_word eq \"Volume\"), word(),\r\n"
-                                 "  skip_white_spaces(), if (next_word eq \"Unit\"), word(), skip_white_spaces(),\r\n"
-                                 "  if (next_word eq \"Referred\"), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("MVS2", "syst_contains(\" MVS \")",
-                                 10, mvs1Columns,
-                                 "# data sets\r\n"
-                                 "* word(<volume>), white_spaces(), word(<unit>), white_spaces(), month(<date>),\r\n"
-                                 "  all(1), day(<date>), all(1), year(<date>), white_spaces(), number(<extents>),\r\n"
-                                 "  white_spaces(), number(<used>), white_spaces(), word(<recfm>), white_spaces(),\r\n"
-                                 "  number(<lrecl>), white_spaces(), number(<blksz>), white_spaces(),\r\n"
-                                 "  word(<dsorg>), assign(<is_dir>, <dsorg> eq \"PO\"), white_spaces(), word(<name>);\r\n"
-                                 "\r\n"
-                                 "# data sets with \"**NONE**\" date\r\n"
-                                 "* word(<volume>), white_spaces(), word(<unit>), white_spaces(),\r\n"
-                                 "  if(next_word eq \"**NONE**\"), word(), white_spaces(), number(<extents>),\r\n"
-                                 "  white_spaces(), number(<used>), white_spaces(), word(<recfm>),\r\n"
-                                 "  white_spaces(), number(<lrecl>), white_spaces(), number(<blksz>),\r\n"
-                                 "  white_spaces(), word(<dsorg>), assign(<is_dir>, <dsorg> eq \"PO\"),\r\n"
-                                 "  white_spaces(), word(<name>);\r\n"
-                                 "\r\n"
-                                 "# \"Migrated\" data sets\r\n"
-                                 "* if(next_word eq \"Migrated\"), word(<unit>), white_spaces(),\r\n"
-                                 "  word(<name>);\r\n"
-                                 "\r\n"
-                                 "# \"MIGRAT\" lines\r\n"
-                                 "* if(next_word eq \"MIGRAT\"), all(<unit>, 53), white_spaces(),\r\n"
-                                 "  cut_white_spaces_end(<unit>), word(<name>);\r\n"
-                                 "\r\n"
-                                 "# \"ARCIVE\" lines\r\n"
-                                 "* if(next_word eq \"ARCIVE\"), all(<unit>, 53), white_spaces(),\r\n"
-                                 "  cut_white_spaces_end(<unit>), word(<name>);\r\n"
-                                 "\r\n"
-                                 "# \"Pseudo directories\"\r\n"
-                                 "* if(next_word eq \"Pseudo\"), word(), white_spaces(1), if(next_word eq \"Directory\"),\r\n"
-                                 "  assign(<is_dir>, true), word(), white_spaces(), word(<name>);\r\n"
-                                 "\r\n"
-                                 "# \"Error determining attributes\"\r\n"
-                                 "* if(next_word eq \"Error\"), word(), white_spaces(1), if(next_word eq \"determining\"),\r\n"
-                                 "  word(), white_spaces(1), if(next_word eq \"attributes\"), word(), white_spaces(),\r\n"
-                                 "  assign(<unit>, \"Error determining attributes\"), word(<name>);\r\n"
-                                 "\r\n"
-                                 "# Volume + \"Error determining attributes\"\r\n"
-                                 "* word(<volume>), white_spaces(), if(next_word eq \"Error\"), word(),\r\n"
-                                 "  white_spaces(1), if(next_word eq \"determining\"), word(), white_spaces(1),\r\n"
-                                 "  if(next_word eq \"attributes\"), word(), white_spaces(),\r\n"
-                                 "  assign(<unit>, \"Error determining attributes\"), word(<name>);\r\n"
-                                 "\r\n"
-                                 "# Volume + \"Not Mounted\"\r\n"
-                                 "* word(<volume>), white_spaces(), if(next_word eq \"Not\"), word(),\r\n"
-                                 "  white_spaces(1), if(next_word eq \"Mounted\"), word(), white_spaces(),\r\n"
-                                 "  assign(<unit>, \"Not Mounted\"), word(<name>);\r\n"
-                                 "\r\n"
-                                 "# Volume + Unit + \"<\" + any error message + \" > \" + Dsname\r\n"
-                                 "* all(<volume>, 6), white_spaces(1), all(<unit>, 4), white_spaces(),\r\n"
-                                 "  if(next_word == \"<\"), all_to(<name>, \" > \"), cut_white_spaces(<volume>),\r\n"
-                                 "  cut_white_spaces(<unit>), add_string_to_column(<unit>, \" \"),\r\n"
-                                 "  add_string_to_column(<unit>, <name>), cut_white_spaces_end(<unit>),\r\n"
-                                 "  skip_white_spaces(), word(<name>);\r\n"
-                                 "\r\n"
-                                 "# optional columns: Volume + Unit + Recfm + Dsorg; Dsname is necessary\r\n"
-                                 "* all(<volume>, 6), white_spaces(1), all(<unit>, 4), white_spaces(19),\r\n"
-                                 "  all(<recfm>, 5), white_spaces(13), all(<dsorg>, 5), white_spaces(),\r\n"
-                                 "  word(<name>), cut_white_spaces(<volume>), cut_white_spaces(<unit>),\r\n"
-                                 "  cut_white_spaces(<recfm>), cut_white_spaces(<dsorg>);\r\n"
-                                 "\r\n"
-                                 "# skip first line \"Volume Unit Referred ...\"\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), if (next_word eq \"Volume\"), word(),\r\n"
-                                 "  skip_white_spaces(), if (next_word eq \"Unit\"), word(), skip_white_spaces(),\r\n"
-                                 "  if (next_word eq \"Referred\"), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    const char* mvsPO1Columns[] = {"1,name,0,\\0,0,\\0,1,\\0",        // name
-                                   "1,size,15,\\0,15,\\0,10,\\0,0",   // size
-                                   "1,vvmm,24,\\0,24,\\0,7,\\0",      // VV.MM
-                                   "1,created,25,\\0,25,\\0,8,\\0,0", // created
-                                   "1,ch_date,3,\\0,3,\\0,8,\\0,0",   // changed date
-                                   "1,ch_time,4,\\0,4,\\0,9,\\0,0",   // changed time
-                                   "1,init,26,\\0,26,\\0,10,\\0,0",   // init size
-                                   "1,mod,27,\\0,27,\\0,10,\\0,0",    // mod
-                                   "1,id,28,\\0,28,\\0,7,\\0"};       // id
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("MVS PO 1", "syst_contains(\" MVS \")",
-                                 9, mvsPO1Columns,
-                                 "# members\r\n"
-                                 "* word(<name>), white_spaces(), word(<vvmm>), white_spaces(), year(<created>),\r\n"
-                                 "  all(1), month(<created>), all(1), day(<created>), white_spaces(),\r\n"
-                                 "  year(<ch_date>), all(1), month(<ch_date>), all(1), day(<ch_date>),\r\n"
-                                 "  white_spaces(), time(<ch_time>), white_spaces(), number(<size>),\r\n"
-                                 "  white_spaces(), number(<init>), white_spaces(), number(<mod>),\r\n"
-                                 "  white_spaces(), word(<id>), skip_white_spaces();\r\n"
-                                 "\r\n"
-                                 "# members without any other info\r\n"
-                                 "* word(<name>), skip_white_spaces();\r\n"
-                                 "\r\n"
-                                 "# skip first line \"Name VV.MM Created ...\"\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), if (next_word eq \"Name\"), word(),\r\n"
-                                 "  skip_white_spaces(), if (next_word eq \"VV.MM\"), word(), skip_white_spaces(),\r\n"
-                                 "  if (next_word eq \"Created\"), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("MVS PO 2", "syst_contains(\" MVS \")",
-                                 9, mvsPO1Columns,
-                                 "# members\r\n"
-                                 "* word(<name>), white_spaces(), word(<vvmm>), white_spaces(),\r\n"
-                                 "  month(<created>), all(1), day(<created>), all(1), year(<created>),\r\n"
-                                 "  white_spaces(), month(<ch_date>), all(1), day(<ch_date>), all(1),\r\n"
-                                 "  year(<ch_date>), white_spaces(), time(<ch_time>), white_spaces(),\r\n"
-                                 "  number(<size>), white_spaces(), number(<init>), white_spaces(),\r\n"
-                                 "  number(<mod>), white_spaces(), word(<id>), skip_white_spaces();\r\n"
-                                 "\r\n"
-                                 "# members without any other info\r\n"
-                                 "* word(<name>), skip_white_spaces();\r\n"
-                                 "\r\n"
-                                 "# skip first line \"Name VV.MM Created ...\"\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), if (next_word eq \"Name\"), word(),\r\n"
-                                 "  skip_white_spaces(), if (next_word eq \"VV.MM\"), word(), skip_white_spaces(),\r\n"
-                                 "  if (next_word eq \"Created\"), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    const char* mvsPO3Columns[] = {"1,name,0,\\0,0,\\0,1,\\0",      // name
-                                   "1,size,15,\\0,15,\\0,10,\\0,0", // size
-                                   "1,vvmm,24,\\0,24,\\0,7,\\0",    // VV.MM
-                                   "1,ch_date,3,\\0,3,\\0,8,\\0,0", // changed date
-                                   "1,ch_time,4,\\0,4,\\0,9,\\0,0", // changed time
-                                   "1,init,26,\\0,26,\\0,10,\\0,0", // init size
-                                   "1,mod,27,\\0,27,\\0,10,\\0,0",  // mod
-                                   "1,id,28,\\0,28,\\0,7,\\0"};     // id
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("MVS PO 3", "syst_contains(\" MVS \")",
-                                 8, mvsPO3Columns,
-                                 "# members\r\n"
-                                 "* word(<name>), white_spaces(), word(<vvmm>), white_spaces(),\r\n"
-                                 "  year(<ch_date>), all(1), month(<ch_date>), all(1), day(<ch_date>),\r\n"
-                                 "  white_spaces(), time(<ch_time>), white_spaces(), number(<size>),\r\n"
-                                 "  white_spaces(), number(<init>), white_spaces(), number(<mod>),\r\n"
-                                 "  white_spaces(), word(<id>), skip_white_spaces();\r\n"
-                                 "\r\n"
-                                 "# members without any other info\r\n"
-                                 "* word(<name>), skip_white_spaces();\r\n"
-                                 "\r\n"
-                                 "# skip first line \"NAME VV.MM CHANGED ...\"\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), if (next_word eq \"NAME\"), word(),\r\n"
-                                 "  skip_white_spaces(), if (next_word eq \"VV.MM\"), word(), skip_white_spaces(),\r\n"
-                                 "  if (next_word eq \"CHANGED\"), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    const char* mvsPO4Columns[] = {"1,name,0,\\0,0,\\0,1,\\0",     // name
-                                   "1,size,15,\\0,15,\\0,7,\\0",   // size
-                                   "1,ttr,29,\\0,29,\\0,7,\\0",    // TTR
-                                   "1,alias,30,\\0,30,\\0,7,\\0",  // alias-of
-                                   "1,ac,31,\\0,31,\\0,7,\\0",     // AC
-                                   "1,attr,32,\\0,32,\\0,7,\\0",   // attr
-                                   "1,amode,33,\\0,33,\\0,7,\\0",  // amode
-                                   "1,rmode,34,\\0,34,\\0,7,\\0"}; // rmode
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("MVS PO 4", "syst_contains(\" MVS \")",
-                                 8, mvsPO4Columns,
-                                 "#datasets\r\n"
-                                 "* word(<name>), white_spaces(), word(<size>), white_spaces(), word(<ttr>),\r\n"
-                                 "  white_spaces(1), all(<alias>, 8), white_spaces(1), all(<ac>, 2), white_spaces(1),\r\n"
-                                 "  all(<attr>, 30), cut_white_spaces_end(<alias>), cut_white_spaces_end(<ac>),\r\n"
-                                 "  cut_white_spaces_end(<attr>), white_spaces(), word(<amode>), white_spaces(),\r\n"
-                                 "  word(<rmode>), skip_white_spaces();\r\n"
-                                 "\r\n"
-                                 "# skip first line \"Name Size TTR ...\"\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), if (next_word eq \"Name\"), word(),\r\n"
-                                 "  skip_white_spaces(), if (next_word eq \"Size\"), word(), skip_white_spaces(),\r\n"
-                                 "  if (next_word eq \"TTR\"), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    const char* IISColumns[] = {"1,name,0,\\0,0,\\0,1,\\0",  // name
-                                "1,ext,1,\\0,1,\\0,2,\\0",   // extension
-                                "1,size,2,\\0,2,\\0,3,\\0",  // size
-                                "0,type,5,\\0,5,\\0,6,\\0",  // type
-                                "1,date,3,\\0,3,\\0,4,\\0",  // date
-                                "1,time,4,\\0,4,\\0,5,\\0"}; // time
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("Microsoft IIS", NULL,
-                                 6, IISColumns,
-                                 "# parse lines with files\r\n"
-                                 "* month(<date>), all(1), day(<date>), all(1), year(<date>), white_spaces(),\r\n"
-                                 "  time(<time>), white_spaces(), positive_number(<size>), white_spaces(),\r\n"
-                                 "  rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with directories\r\n"
-                                 "* month(<date>), all(1), day(<date>), all(1), year(<date>), white_spaces(),\r\n"
-                                 "  time(<time>), white_spaces(), if(next_word eq \"<dir>\"), all(5),\r\n"
-                                 "  assign(<is_dir>, true), white_spaces(), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# skip lines with files without name\r\n"
-                                 "* month(<date>), all(1), day(<date>), all(1), year(<date>), white_spaces(),\r\n"
-                                 "  time(<time>), white_spaces(), positive_number(<size>), white_spaces();\r\n"
-                                 "\r\n"
-                                 "# skip lines with directories without name\r\n"
-                                 "* month(<date>), all(1), day(<date>), all(1), year(<date>), white_spaces(),\r\n"
-                                 "  time(<time>), white_spaces(), if(next_word eq \"<dir>\"), all(5),\r\n"
-                                 "  assign(<is_dir>, true), white_spaces();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    const char* os2Columns[] = {"1,name,0,\\0,0,\\0,1,\\0",     // name
-                                "1,ext,1,\\0,1,\\0,2,\\0",      // extension
-                                "1,size,2,\\0,2,\\0,3,\\0",     // size
-                                "0,type,5,\\0,5,\\0,6,\\0",     // type
-                                "1,date,3,\\0,3,\\0,4,\\0",     // date
-                                "1,time,4,\\0,4,\\0,9,\\0,0",   // time
-                                "1,attrs,32,\\0,32,\\0,7,\\0"}; // attributes
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("OS/2", NULL,
-                                 7, os2Columns,
-                                 "# parse lines with files and directories\r\n"
-                                 "* skip_white_spaces(), positive_number(<size>), white_spaces(1), all(<attrs>, 9),\r\n"
-                                 "  cut_white_spaces(<attrs>), white_spaces(1),\r\n"
-                                 "  assign(<is_dir>, next_word eq \"DIR\"), all(3), white_spaces(),\r\n"
-                                 "  month(<date>), all(1), day(<date>), all(1), year(<date>),\r\n"
-                                 "  white_spaces(), time(<time>), white_spaces(), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    const char* vxWorksColumns[] = {"1,name,0,\\0,0,\\0,1,\\0",    // name
-                                    "1,ext,1,\\0,1,\\0,2,\\0",     // extension
-                                    "1,size,2,\\0,2,\\0,3,\\0",    // size
-                                    "0,type,5,\\0,5,\\0,6,\\0",    // type
-                                    "1,date,3,\\0,3,\\0,4,\\0",    // date
-                                    "1,time,4,\\0,4,\\0,9,\\0,0"}; // time
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("VxWorks", "welcome_contains(\" VxWorks \")",
-                                 6, vxWorksColumns,
-                                 "# parse lines with directories\r\n"
-                                 "* skip_white_spaces(), positive_number(<size>), white_spaces(), month_3(<date>),\r\n"
-                                 "  all(1), day(<date>), all(1), year(<date>), white_spaces(), time(<time>),\r\n"
-                                 "  white_spaces(), all_up_to(<name>, \"<\"), cut_white_spaces_end(<name>),\r\n"
-                                 "  if(next_word eq \"DIR>\"), all(4), assign(<is_dir>, true), skip_white_spaces();\r\n"
-                                 "\r\n"
-                                 "# parse lines with files\r\n"
-                                 "* skip_white_spaces(), positive_number(<size>), white_spaces(), month_3(<date>),\r\n"
-                                 "  all(1), day(<date>), all(1), year(<date>), white_spaces(), time(<time>),\r\n"
-                                 "  white_spaces(), rest_of_line(<name>), cut_white_spaces_end(<name>),\r\n"
-                                 "  if(\"<\" not_in <name>);\r\n"
-                                 "\r\n"
-                                 "# skip first line \"size date time ...\"\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), if (next_word eq \"size\"), word(),\r\n"
-                                 "  skip_white_spaces(), if (next_word eq \"date\"), word(), skip_white_spaces(),\r\n"
-                                 "  if (next_word eq \"time\"), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# skip second line \"--------  ------ ...\"\r\n"
-                                 "* if(\"----\" in next_word), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    // description of the string in the array: "visible,ID,nameStrID,nameStr,descrStrID,descrStr,colType,emptyValue,leftAlignment,fixedWidth,width"
-    const char* tandemColumns[] = {"1,name,0,\\0,0,\\0,1,\\0",      // name
-                                   "1,code,35,\\0,35,\\0,10,\\0,0", // code
-                                   "1,size,2,\\0,2,\\0,3,\\0",      // size
-                                   "1,date,3,\\0,3,\\0,4,\\0",      // date
-                                   "1,time,4,\\0,4,\\0,5,\\0",      // time
-                                   "1,user,7,\\0,7,\\0,7,\\0",      // user
-                                   "1,RWEP,36,\\0,36,\\0,7,\\0"};   // RWEP
-
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("Tandem", NULL, 7, tandemColumns,
-                                 "# parse lines with files\r\n"
-                                 "* word(<name>), white_spaces(), number(<code>), white_spaces(), positive_number(<size>),\r\n"
-                                 "  white_spaces(), day(<date>), all(1), month_3(<date>), all(1), year(<date>), white_spaces(),\r\n"
-                                 "  time(<time>), white_spaces(), all_up_to(<user>, \"\\\"\"), cut_white_spaces_end(<user>),\r\n"
-                                 "  all_up_to(<RWEP>, \"\\\"\");\r\n"
-                                 "\r\n"
-                                 "# skip first line \"File Code EOF ...\"\r\n"
-                                 "* if(first_nonempty_line), skip_white_spaces(), if (next_word eq \"file\"), word(),\r\n"
-                                 "  skip_white_spaces(), if (next_word eq \"code\"), word(), skip_white_spaces(),\r\n"
-                                 "  if (next_word eq \"eof\"), rest_of_line();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    // description of the string in the array: "visible,ID,nameStrID,nameStr,descrStrID,descrStr,colType,emptyValue,leftAlignment,fixedWidth,width"
-    const char* IBM_AS_400Columns[] = {"1,name,0,\\0,0,\\0,1,\\0",     // name
-                                       "1,ext,1,\\0,1,\\0,2,\\0",      // extension
-                                       "1,size,2,\\0,2,\\0,10,\\0,0",  // size
-                                       "0,win_type,5,\\0,5,\\0,6,\\0", // windows file type
-                                       "1,date,3,\\0,3,\\0,8,\\0,0",   // date
-                                       "1,time,4,\\0,4,\\0,9,\\0,0",   // time
-                                       "1,type,5,\\0,5,\\0,7,\\0",     // AS/400 file type
-                                       "1,user,7,\\0,7,\\0,7,\\0"};    // user
-
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("IBM iSeries/i5, AS/400 (EN)", "syst_contains(\" OS/400 \")", 8, IBM_AS_400Columns,
-                                 "# parse lines with files\r\n"
-                                 "* word(<user>), skip_white_spaces(), positive_number(<size>), skip_white_spaces(),\r\n"
-                                 "  month(<date>), all(1), day(<date>), all(1), year(<date>), white_spaces(),\r\n"
-                                 "  time(<time>), skip_white_spaces(), word(<type>), skip_white_spaces(),\r\n"
-                                 "  if(rest_of_line not_end_with \"/\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with files without size+date+time\r\n"
-                                 "* word(<user>), skip_white_spaces(), word(<type>), skip_white_spaces(),\r\n"
-                                 "  if(rest_of_line not_end_with \"/\"), if(\" \" not_in rest_of_line),\r\n"
-                                 "  rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with files without user+type+size+date+time\r\n"
-                                 "* white_spaces(40), skip_white_spaces(), if(rest_of_line not_end_with \"/\"),\r\n"
-                                 "  rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with directories\r\n"
-                                 "* word(<user>), skip_white_spaces(), positive_number(<size>), skip_white_spaces(),\r\n"
-                                 "  month(<date>), all(1), day(<date>), all(1), year(<date>), white_spaces(),\r\n"
-                                 "  time(<time>), skip_white_spaces(), word(<type>), skip_white_spaces(),\r\n"
-                                 "  if(rest_of_line end_with \"/\"), assign(<is_dir>, true), rest_of_line(<name>),\r\n"
-                                 "  cut_end_of_string(<name>, 1);\r\n"
-                                 "\r\n"
-                                 "# parse lines with directories without user\r\n"
-                                 "* skip_white_spaces(), positive_number(<size>), skip_white_spaces(),\r\n"
-                                 "  month(<date>), all(1), day(<date>), all(1), year(<date>), white_spaces(),\r\n"
-                                 "  time(<time>), skip_white_spaces(), word(<type>), skip_white_spaces(),\r\n"
-                                 "  if(rest_of_line end_with \"/\"), assign(<is_dir>, true), rest_of_line(<name>),\r\n"
-                                 "  cut_end_of_string(<name>, 1);\r\n"
-                                 "\r\n"
-                                 "# parse lines with directories without user+type+size+date+time\r\n"
-                                 "* white_spaces(40), skip_white_spaces(), if(rest_of_line end_with \"/\"),\r\n"
-                                 "  assign(<is_dir>, true), rest_of_line(<name>), cut_end_of_string(<name>, 1);\r\n"
-                                 "\r\n"
-                                 "# parse lines with file without name (only on the first row)\r\n"
-                                 "* if(first_nonempty_line), word(), skip_white_spaces(), positive_number(<size>),\r\n"
-                                 "  skip_white_spaces(), month(<date>), all(1), day(<date>), all(1), year(<date>),\r\n"
-                                 "  white_spaces(), time(<time>), skip_white_spaces(), if(next_word eq \"*FILE\"),\r\n"
-                                 "  word(), skip_white_spaces();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
-
-    // no need to use LockServerTypeList() and UnlockServerTypeList(), no other threads are running yet
-    ServerTypeList.AddServerType("IBM iSeries/i5, AS/400 (CZ)", "syst_contains(\" OS/400 \")", 8, IBM_AS_400Columns,
-                                 "# parse lines with files\r\n"
-                                 "* word(<user>), skip_white_spaces(), positive_number(<size>), skip_white_spaces(),\r\n"
-                                 "  day(<date>), all(1), month(<date>), all(1), year(<date>), white_spaces(),\r\n"
-                                 "  time(<time>), skip_white_spaces(), word(<type>), skip_white_spaces(),\r\n"
-                                 "  if(rest_of_line not_end_with \"/\"), rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with files without size+date+time\r\n"
-                                 "* word(<user>), skip_white_spaces(), word(<type>), skip_white_spaces(),\r\n"
-                                 "  if(rest_of_line not_end_with \"/\"), if(\" \" not_in rest_of_line),\r\n"
-                                 "  rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with files without user+type+size+date+time\r\n"
-                                 "* white_spaces(40), skip_white_spaces(), if(rest_of_line not_end_with \"/\"),\r\n"
-                                 "  rest_of_line(<name>);\r\n"
-                                 "\r\n"
-                                 "# parse lines with directories\r\n"
-                                 "* word(<user>), skip_white_spaces(), positive_number(<size>), skip_white_spaces(),\r\n"
-                                 "  day(<date>), all(1), month(<date>), all(1), year(<date>), white_spaces(),\r\n"
-                                 "  time(<time>), skip_white_spaces(), word(<type>), skip_white_spaces(),\r\n"
-                                 "  if(rest_of_line end_with \"/\"), assign(<is_dir>, true), rest_of_line(<name>),\r\n"
-                                 "  cut_end_of_string(<name>, 1);\r\n"
-                                 "\r\n"
-                                 "# parse lines with directories without user\r\n"
-                                 "* skip_white_spaces(), positive_number(<size>), skip_white_spaces(),\r\n"
-                                 "  day(<date>), all(1), month(<date>), all(1), year(<date>), white_spaces(),\r\n"
-                                 "  time(<time>), skip_white_spaces(), word(<type>), skip_white_spaces(),\r\n"
-                                 "  if(rest_of_line end_with \"/\"), assign(<is_dir>, true), rest_of_line(<name>),\r\n"
-                                 "  cut_end_of_string(<name>, 1);\r\n"
-                                 "\r\n"
-                                 "# parse lines with directories without user+type+size+date+time\r\n"
-                                 "* white_spaces(40), skip_white_spaces(), if(rest_of_line end_with \"/\"),\r\n"
-                                 "  assign(<is_dir>, true), rest_of_line(<name>), cut_end_of_string(<name>, 1);\r\n"
-                                 "\r\n"
-                                 "# parse lines with file without name (only on the first row)\r\n"
-                                 "* if(first_nonempty_line), word(), skip_white_spaces(), positive_number(<size>),\r\n"
-                                 "  skip_white_spaces(), day(<date>), all(1), month(<date>), all(1), year(<date>),\r\n"
-                                 "  white_spaces(), time(<time>), skip_white_spaces(), if(next_word eq \"*FILE\"),\r\n"
-                                 "  word(), skip_white_spaces();\r\n"
-                                 "\r\n"
-                                 "# skip empty lines anywhere\r\n"
-                                 "* skip_white_spaces();\r\n");
+    AddDefaultServerTypes(&ServerTypeList);
 
     if ((CommandHistory[0] = _strdup("HELP")) != NULL)
         CommandHistory[1] = _strdup("CDUP");
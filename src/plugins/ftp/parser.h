@@ -55,6 +55,7 @@ enum CFTPParserParameterType
 #define COL_IND_ISLINK -3   // standard column "is_link"
 #define COL_IND_ISHIDDEN -2 // standard column "is_hidden"
 #define COL_IND_ISDIR -1    // standard column "is_dir"
+#define COL_IND_NONE -4     // no column (compiled rule: the instruction does not assign the value to any column)
 
 // constants for operand types when testing correct operator usage in an expression
 enum CFTPParserOperandType
@@ -239,6 +240,8 @@ enum CFTPParserFunctionCode
 
 class CFTPParserFunction
 {
+    friend class CFTPParserRule; // CFTPParserRule::CompileToInstructions() reads Function+Parameters
+
 protected:
     CFTPParserFunctionCode Function;
 
@@ -312,15 +315,50 @@ protected:
 // CFTPParserRule
 //
 
+// operation codes of the instructions of a compiled rule (see CFTPParserRule::CompileToInstructions)
+enum CFTPParserOpCode
+{
+    popCallFunction,    // generic function: calls CFTPParserFunction::UseFunction()
+    popSkipWhiteSpaces, // skip_white_spaces()
+    popSkipToNumber,    // skip_to_number()
+    popWhiteSpaces,     // white_spaces() - at least one white-space
+    popWhiteSpacesN,    // white_spaces(N) - exactly N white-spaces
+    popRestOfLine,      // rest_of_line() or rest_of_line(column)
+    popWord,            // word() or word(column)
+    popNumber,          // number() or number(column)
+    popPositiveNumber,  // positive_number() or positive_number(column)
+    popAllN,            // all(N) or all(column, N)
+};
+
+// one instruction of a compiled rule
+struct CFTPParserInstruction
+{
+    CFTPParserOpCode OpCode;
+    BOOL SkipWhiteSpacesAfter;    // TRUE = the following skip_white_spaces() is merged into this instruction
+    int Column;                   // index of the column that receives the value (COL_IND_NONE = no column)
+    int Number;                   // count of characters for popWhiteSpacesN and popAllN
+    CFTPParserFunction* Function; // function for popCallFunction (the function is owned by CFTPParserRule::Functions)
+};
+
 class CFTPParserRule
 {
 protected:
     TIndirectArray<CFTPParserFunction> Functions; // list of all functions of the rule
 
+    // compiled form of 'Functions' used for parsing: a linear list of instructions, the most
+    // common functions have their own opcodes with the column index already resolved and
+    // skip_white_spaces() is merged into the preceding instruction; other functions are
+    // called through popCallFunction
+    TDirectArray<CFTPParserInstruction> Code;
+
 public:
-    CFTPParserRule() : Functions(5, 5) {}
+    CFTPParserRule() : Functions(5, 5), Code(5, 5) {}
+
+    BOOL IsGood() { return Functions.IsGood() && Code.IsGood(); }
 
-    BOOL IsGood() { return Functions.IsGood(); }
+    // builds 'Code' from 'Functions'; called after the whole rule is compiled; returns FALSE
+    // on out of memory (sets 'lowMem' (if not NULL) to TRUE)
+    BOOL CompileToInstructions(BOOL* lowMem);
 
     // returns TRUE if the function in the rule was compiled successfully (up to the ')' symbol);
     // on error returns FALSE and sets 'errorResID' (number of the string describing
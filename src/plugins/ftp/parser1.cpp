@@ -242,7 +242,7 @@ BOOL CFTPParser::CompileNewRule(const char*& rules, const char* rulesEnd,
                         return FALSE;
                     }
                     rules++;
-                    return TRUE; // with this, the rule is compiled
+                    return ruleObj->CompileToInstructions(lowMem); // with this, the rule is compiled
                 }
                 else // a function has to start here
                 {
@@ -792,6 +792,119 @@ BOOL CFTPParserRule::CompileNewFunction(CFTPParserFunctionCode func, const char*
     return FALSE;
 }
 
+BOOL CFTPParserRule::CompileToInstructions(BOOL* lowMem)
+{
+    CALL_STACK_MESSAGE1("CFTPParserRule::CompileToInstructions()");
+    int i;
+    for (i = 0; i < Functions.Count; i++)
+    {
+        CFTPParserFunction* func = Functions[i];
+        CFTPParserInstruction instr;
+        instr.OpCode = popCallFunction;
+        instr.SkipWhiteSpacesAfter = FALSE;
+        instr.Column = COL_IND_NONE;
+        instr.Number = 0;
+        instr.Function = func;
+
+        // only the functions with simple parameters (a column or a number constant) get their own opcode
+        CFTPParserParameter* par0 = func->Parameters.Count > 0 ? func->Parameters[0] : NULL;
+        CFTPParserParameter* par1 = func->Parameters.Count > 1 ? func->Parameters[1] : NULL;
+        switch (func->Function)
+        {
+        case fpfSkip_white_spaces:
+            instr.OpCode = popSkipWhiteSpaces;
+            break;
+
+        case fpfSkip_to_number:
+            instr.OpCode = popSkipToNumber;
+            break;
+
+        case fpfWhite_spaces:
+        {
+            if (par0 == NULL)
+                instr.OpCode = popWhiteSpaces;
+            else
+            {
+                if (par1 == NULL && par0->Type == pptNumber)
+                {
+                    instr.OpCode = popWhiteSpacesN;
+                    instr.Number = (int)par0->GetNumber();
+                }
+            }
+            break;
+        }
+
+        case fpfRest_of_line:
+        case fpfWord:
+        case fpfNumber:
+        case fpfPositiveNumber:
+        {
+            if (par0 == NULL || par1 == NULL && par0->Type == pptColumnID)
+            {
+                switch (func->Function)
+                {
+                case fpfRest_of_line:
+                    instr.OpCode = popRestOfLine;
+                    break;
+                case fpfWord:
+                    instr.OpCode = popWord;
+                    break;
+                case fpfNumber:
+                    instr.OpCode = popNumber;
+                    break;
+                default:
+                    instr.OpCode = popPositiveNumber;
+                    break;
+                }
+                if (par0 != NULL)
+                    instr.Column = par0->GetColumnIndex();
+            }
+            break;
+        }
+
+        case fpfAll:
+        {
+            if (par0 != NULL && par1 == NULL && par0->Type == pptNumber)
+            {
+                instr.OpCode = popAllN;
+                instr.Number = (int)par0->GetNumber();
+            }
+            else
+            {
+                if (par1 != NULL && par0->Type == pptColumnID &&
+                    par1->Type == pptNumber)
+                {
+                    instr.OpCode = popAllN;
+                    instr.Column = par0->GetColumnIndex();
+                    instr.Number = (int)par1->GetNumber();
+                }
+            }
+            break;
+        }
+        }
+
+        // skip_white_spaces() after a function that cannot set CFTPParser::SkipThisLineItIsIncomlete
+        // is merged into the preceding instruction (typical sequences "word, skip_white_spaces"
+        // and "number, skip_white_spaces")
+        if (instr.OpCode != popCallFunction && instr.OpCode != popSkipWhiteSpaces &&
+            i + 1 < Functions.Count && Functions[i + 1]->Function == fpfSkip_white_spaces)
+        {
+            instr.SkipWhiteSpacesAfter = TRUE;
+            i++;
+        }
+
+        Code.Add(instr);
+        if (!Code.IsGood())
+        {
+            Code.ResetState();
+            if (lowMem != NULL)
+                *lowMem = TRUE;
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
 //
 // ****************************************************************************
 // CFTPParserFunction
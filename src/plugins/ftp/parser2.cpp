@@ -392,6 +392,13 @@ BOOL CFTPParser::GetNextItemFromListing(CFileData* file, BOOL* isDir,
 // CFTPParserRule
 //
 
+BOOL AssignNumberToColumn(int col, TIndirectArray<CSrvTypeColumn>* columns, BOOL minus, __int64 number,
+                          DWORD* emptyCol, CFileData* file, CFTPListingPluginDataInterface* dataIface,
+                          BOOL onlyPositiveNumber);
+BOOL AssignStringToColumn(int col, TIndirectArray<CSrvTypeColumn>* columns, const char* beg,
+                          const char* end, BOOL* lowMemErr, DWORD* emptyCol,
+                          CFileData* file, CFTPListingPluginDataInterface* dataIface);
+
 BOOL CFTPParserRule::UseRule(CFileData* file, BOOL* isDir,
                              CFTPListingPluginDataInterface* dataIface,
                              TIndirectArray<CSrvTypeColumn>* columns,
@@ -401,11 +408,115 @@ BOOL CFTPParserRule::UseRule(CFileData* file, BOOL* isDir,
     DEBUG_SLOW_CALL_STACK_MESSAGE1("CFTPParserRule::UseRule()");
     const char* s = *listing;
     int i;
-    for (i = 0; !(actualParser->SkipThisLineItIsIncomlete) && i < Functions.Count; i++)
+    for (i = 0; !(actualParser->SkipThisLineItIsIncomlete) && i < Code.Count; i++)
     {
-        if (!Functions[i]->UseFunction(file, isDir, dataIface, columns, &s, listingEnd,
-                                       actualParser, lowMemErr, emptyCol))
+        // the opcodes implement exactly the same as the corresponding cases in CFTPParserFunction::UseFunction()
+        CFTPParserInstruction* instr = &Code[i];
+        const char* beg = s;
+        BOOL ok = TRUE;
+        switch (instr->OpCode)
+        {
+        case popSkipWhiteSpaces:
+            break; // white-spaces are skipped below
+
+        case popSkipToNumber:
+        {
+            while (s < listingEnd && ((*s < '0' || *s > '9') && *s != '\r' && *s != '\n'))
+                s++;
+            break;
+        }
+
+        case popWhiteSpaces:
+        {
+            while (s < listingEnd && (*s <= ' ' && *s != '\r' && *s != '\n'))
+                s++;
+            ok = s != beg; // success only if the "pointer" advances
+            break;
+        }
+
+        case popWhiteSpacesN:
+        {
+            int num = instr->Number;
+            while (num-- && s < listingEnd && (*s <= ' ' && *s != '\r' && *s != '\n'))
+                s++;
+            ok = num == -1; // success only if the "pointer" advances by 'num'
+            break;
+        }
+
+        case popRestOfLine:
+        case popWord:
+        {
+            if (instr->OpCode == popWord)
+            {
+                while (s < listingEnd && *s > ' ')
+                    s++;
+            }
+            else
+            {
+                while (s < listingEnd && *s != '\r' && *s != '\n')
+                    s++;
+            }
+            ok = s != beg && // success only if the "pointer" advances
+                 (instr->Column == COL_IND_NONE ||
+                  AssignStringToColumn(instr->Column, columns, beg, s, lowMemErr, emptyCol, file, dataIface));
             break;
+        }
+
+        case popNumber:
+        case popPositiveNumber:
+        {
+            BOOL minus = FALSE;
+            if (s < listingEnd)
+            {
+                if (*s == '+')
+                    s++;
+                else
+                {
+                    if (*s == '-')
+                    {
+                        s++;
+                        minus = TRUE;
+                    }
+                }
+            }
+            const char* numBeg = s;
+            __int64 num = 0;
+            while (s < listingEnd && *s >= '0' && *s <= '9')
+                num = num * 10 + (*s++ - '0');
+            if (minus)
+                num = -num;
+            ok = s != numBeg && (s == listingEnd || !IsCharAlpha(*s)) && // success only if the number exists (at least one digit) and does not end with a letter
+                 (instr->Column == COL_IND_NONE ||
+                  AssignNumberToColumn(instr->Column, columns, minus, num, emptyCol, file, dataIface,
+                                       instr->OpCode == popPositiveNumber));
+            break;
+        }
+
+        case popAllN:
+        {
+            int num = instr->Number;
+            while (num-- && s < listingEnd && *s != '\r' && *s != '\n')
+                s++;
+            ok = num == -1 && // success only if the "pointer" advances by 'num'
+                 (instr->Column == COL_IND_NONE ||
+                  AssignStringToColumn(instr->Column, columns, beg, s, lowMemErr, emptyCol, file, dataIface));
+            break;
+        }
+
+        default: // popCallFunction
+        {
+            ok = instr->Function->UseFunction(file, isDir, dataIface, columns, &s, listingEnd,
+                                              actualParser, lowMemErr, emptyCol);
+            break;
+        }
+        }
+        if (!ok)
+            break;
+        if (instr->OpCode == popSkipWhiteSpaces || instr->SkipWhiteSpacesAfter)
+        {
+            while (s < listingEnd && (*s <= ' ' && *s != '\r' && *s != '\n'))
+                s++;
+        }
     }
     // if all functions of the rule are successfully used and the "pointer" is at the end
     // of the listing or at the end of the line, report success
@@ -416,7 +527,7 @@ BOOL CFTPParserRule::UseRule(CFileData* file, BOOL* isDir,
             ret = TRUE;
         else
         {
-            if (!(*lowMemErr) && i == Functions.Count && (s == listingEnd || *s == '\r' || *s == '\n'))
+            if (!(*lowMemErr) && i == Code.Count && (s == listingEnd || *s == '\r' || *s == '\n'))
             {
                 ret = TRUE;
                 // skip a possible end of line
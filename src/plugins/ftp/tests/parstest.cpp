@@ -0,0 +1,607 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+//
+// ****************************************************************************
+// parstest - tester of the compiled rules of the FTP listing parser (parser1.cpp, parser2.cpp)
+//
+// Compiles the rules of all built-in server types (srvtypes.cpp) twice: once as the plugin does
+// (CFTPParserRule::CompileToInstructions) and once with every function of the rule called through
+// CFTPParserFunction::UseFunction(), which is how UseRule() interpreted the rules before. Then it
+// parses every listing from the given directory (ftp\servers\tests) with every server type by
+// both parsers in lockstep, checks that they return the same items (names, sizes, dates, all
+// columns) and stop at the same position, and measures the parsing time of the server type that
+// parses the listing completely.
+//
+// The parser is compiled into this program; the few services it needs from the rest of the plugin
+// (memory allocation, the columns of server types and the data interface of the listing) are
+// replaced below by simple implementations, the empty values of columns are not filled in (they
+// are the same for both parsers).
+//
+// Build (Visual Studio command prompt, in src\plugins\ftp\tests):
+//   cl /nologo /O2 /EHsc /J /DNDEBUG /DCALLSTK_DISABLE /D_CRT_SECURE_NO_WARNINGS /DWINVER=0x0601
+//      /D_WIN32_WINNT=0x0601 /D_WIN32_IE=0x0800 /I.. /I..\..\shared parstest.cpp user32.lib
+//
+// Usage: parstest [listings_directory [repeat_count]]
+
+#include "precomp.h"
+
+// the parser allocates its strings through SalamanderGeneral, which does not exist in this program
+class CTesterGeneral
+{
+public:
+    void* Alloc(int size) { return malloc(size); }
+    void Free(void* ptr) { free(ptr); }
+    char* DupStr(const char* str)
+    {
+        if (str == NULL)
+            return NULL;
+        char* s = (char*)malloc(strlen(str) + 1);
+        if (s != NULL)
+            strcpy(s, str);
+        return s;
+    }
+    int StrNICmp(const char* s1, const char* s2, int n) { return _strnicmp(s1, s2, n); }
+};
+
+CTesterGeneral TesterGeneral;
+
+#define SalamanderGeneral (&TesterGeneral)
+
+#include "../parser1.cpp"
+#include "../parser2.cpp"
+#include "../srvtypes.cpp"
+
+int SortByExtDirsAsFiles = FALSE;
+
+static unsigned char LowerCaseTable[256];
+unsigned char* LowerCase = LowerCaseTable; // filled in main(), the plugin gets it from Salamander
+
+char* HandleNULLStr(char* str)
+{
+    static char emptyBuff[] = "";
+    return str == NULL ? emptyBuff : str;
+}
+
+BOOL GetColumnEmptyValue(const char* empty, CSrvTypeColumnTypes type, CQuadWord* qwVal,
+                         __int64* int64Val, SYSTEMTIME* stVal, BOOL skipDateCheck)
+{
+    return FALSE; // empty values are not filled in
+}
+
+//
+// ****************************************************************************
+// server types
+//
+
+CSrvTypeColumn::CSrvTypeColumn(CSrvTypeColWidths* colWidths)
+{
+    Visible = FALSE;
+    ID = NULL;
+    NameID = -1;
+    NameStr = NULL;
+    DescrID = -1;
+    DescrStr = NULL;
+    Type = stctNone;
+    EmptyValue = NULL;
+    LeftAlignment = TRUE;
+    ColWidths = NULL;
+}
+
+CSrvTypeColumn::~CSrvTypeColumn()
+{
+    free(ID);
+    free(EmptyValue);
+}
+
+// reads the 'index'-th item of the column description "visible,ID,nameStrID,nameStr,descrStrID,
+// descrStr,colType,emptyValue,..." (see srvtypes.cpp); returns NULL for "\0"
+static char* GetColumnItem(const char* str, int index)
+{
+    while (index-- > 0)
+    {
+        while (*str != 0 && *str != ',')
+        {
+            if (*str == '\\' && str[1] != 0)
+                str++;
+            str++;
+        }
+        if (*str == ',')
+            str++;
+    }
+    if (str[0] == '\\' && str[1] == '0' && (str[2] == ',' || str[2] == 0))
+        return NULL;
+    char* item = (char*)malloc(strlen(str) + 1);
+    char* d = item;
+    while (*str != 0 && *str != ',')
+    {
+        if (*str == '\\' && str[1] != 0)
+            str++;
+        *d++ = *str++;
+    }
+    *d = 0;
+    return item;
+}
+
+struct CTestServerType
+{
+    const char* Name;
+    const char* Rules;
+    TIndirectArray<CSrvTypeColumn>* Columns;
+};
+
+static CTestServerType ServerTypes[100];
+static int ServerTypesCount = 0;
+
+BOOL CServerTypeList::AddServerType(const char* typeName, const char* autodetectCond, int columnsCount,
+                                    const char* columnsStr[], const char* rulesForParsing)
+{
+    if (ServerTypesCount >= (int)ARRAYSIZE(ServerTypes))
+        return FALSE;
+    CTestServerType* type = &ServerTypes[ServerTypesCount++];
+    type->Name = typeName;
+    type->Rules = rulesForParsing;
+    type->Columns = new TIndirectArray<CSrvTypeColumn>(10, 10);
+    int i;
+    for (i = 0; i < columnsCount; i++)
+    {
+        CSrvTypeColumn* col = new CSrvTypeColumn;
+        col->ID = GetColumnItem(columnsStr[i], 1);
+        char* colType = GetColumnItem(columnsStr[i], 6);
+        col->Type = (CSrvTypeColumnTypes)atoi(colType);
+        free(colType);
+        col->EmptyValue = GetColumnItem(columnsStr[i], 7);
+        type->Columns->Add(col);
+    }
+    return TRUE;
+}
+
+void CServerType::Release()
+{
+}
+
+//
+// ****************************************************************************
+// CFTPListingPluginDataInterface
+//
+// CFileData::PluginData points to an array of CTestColumnValue (one for each column)
+
+struct CTestColumnValue
+{
+    char* Str;
+    __int64 Number;
+    CFTPDate Date;
+    CFTPTime Time;
+};
+
+CFTPListingPluginDataInterface::CFTPListingPluginDataInterface(TIndirectArray<CSrvTypeColumn>* columns, BOOL deleteColumns,
+                                                               DWORD validDataMask, BOOL isVMS)
+{
+    Columns = columns;
+    DeleteColumns = FALSE;
+    ItemDataSize = columns->Count * sizeof(CTestColumnValue);
+    DataOffsets = NULL;
+    ValidDataMask = validDataMask;
+    BytesColumnOffset = BlocksColumnOffset = DateColumnOffset = TimeColumnOffset = -1;
+    IsVMS = isVMS;
+}
+
+CFTPListingPluginDataInterface::~CFTPListingPluginDataInterface()
+{
+}
+
+BOOL CFTPListingPluginDataInterface::AllocPluginData(CFileData& file)
+{
+    file.PluginData = (DWORD_PTR)calloc(1, ItemDataSize);
+    return file.PluginData != 0;
+}
+
+void CFTPListingPluginDataInterface::ClearPluginData(CFileData& file)
+{
+    CTestColumnValue* values = (CTestColumnValue*)file.PluginData;
+    int i;
+    for (i = 0; i < Columns->Count; i++)
+        free(values[i].Str);
+    memset(values, 0, ItemDataSize);
+}
+
+void WINAPI CFTPListingPluginDataInterface::ReleasePluginData(CFileData& file, BOOL isDir)
+{
+    if (file.PluginData != 0)
+    {
+        ClearPluginData(file);
+        free((void*)file.PluginData);
+        file.PluginData = 0;
+    }
+}
+
+void CFTPListingPluginDataInterface::StoreStringToColumn(CFileData& file, int column, char* str)
+{
+    CTestColumnValue* v = (CTestColumnValue*)file.PluginData + column;
+    free(v->Str);
+    v->Str = str;
+}
+
+void CFTPListingPluginDataInterface::StoreDayToColumn(CFileData& file, int column, BYTE day)
+{
+    ((CTestColumnValue*)file.PluginData)[column].Date.Day = day;
+}
+
+void CFTPListingPluginDataInterface::StoreMonthToColumn(CFileData& file, int column, BYTE month)
+{
+    ((CTestColumnValue*)file.PluginData)[column].Date.Month = month;
+}
+
+void CFTPListingPluginDataInterface::StoreYearToColumn(CFileData& file, int column, WORD year)
+{
+    ((CTestColumnValue*)file.PluginData)[column].Date.Year = year;
+}
+
+void CFTPListingPluginDataInterface::StoreDateToColumn(CFileData& file, int column, BYTE day, BYTE month, WORD year)
+{
+    CFTPDate* d = &((CTestColumnValue*)file.PluginData)[column].Date;
+    d->Day = day;
+    d->Month = month;
+    d->Year = year;
+}
+
+void CFTPListingPluginDataInterface::StoreTimeToColumn(CFileData& file, int column, BYTE hour, BYTE minute,
+                                                       BYTE second, WORD millisecond)
+{
+    CFTPTime* t = &((CTestColumnValue*)file.PluginData)[column].Time;
+    t->Hour = hour;
+    t->Minute = minute;
+    t->Second = second;
+    t->Millisecond = millisecond;
+}
+
+void CFTPListingPluginDataInterface::StoreNumberToColumn(CFileData& file, int column, __int64 number)
+{
+    ((CTestColumnValue*)file.PluginData)[column].Number = number;
+}
+
+char* CFTPListingPluginDataInterface::GetStringFromColumn(const CFileData& file, int column)
+{
+    return ((CTestColumnValue*)file.PluginData)[column].Str;
+}
+
+void CFTPListingPluginDataInterface::GetDateFromColumn(const CFileData& file, int column, SYSTEMTIME* stVal)
+{
+    CFTPDate* d = &((CTestColumnValue*)file.PluginData)[column].Date;
+    stVal->wYear = d->Year;
+    stVal->wMonth = d->Month;
+    stVal->wDay = d->Day;
+}
+
+void CFTPListingPluginDataInterface::GetDateFromColumn(const CFileData& file, int column, CFTPDate* date)
+{
+    *date = ((CTestColumnValue*)file.PluginData)[column].Date;
+}
+
+void CFTPListingPluginDataInterface::GetTimeFromColumn(const CFileData& file, int column, SYSTEMTIME* stVal)
+{
+    CFTPTime* t = &((CTestColumnValue*)file.PluginData)[column].Time;
+    stVal->wHour = t->Hour;
+    stVal->wMinute = t->Minute;
+    stVal->wSecond = t->Second;
+    stVal->wMilliseconds = t->Millisecond;
+}
+
+void CFTPListingPluginDataInterface::GetTimeFromColumn(const CFileData& file, int column, CFTPTime* time)
+{
+    *time = ((CTestColumnValue*)file.PluginData)[column].Time;
+}
+
+__int64
+CFTPListingPluginDataInterface::GetNumberFromColumn(const CFileData& file, int column)
+{
+    return ((CTestColumnValue*)file.PluginData)[column].Number;
+}
+
+void WINAPI CFTPListingPluginDataInterface::SetupView(BOOL leftPanel, CSalamanderViewAbstract* view, const char* archivePath,
+                                                      const CFileData* upperDir)
+{
+}
+
+void WINAPI CFTPListingPluginDataInterface::ColumnFixedWidthShouldChange(BOOL leftPanel, const CColumn* column, int newFixedWidth)
+{
+}
+
+void WINAPI CFTPListingPluginDataInterface::ColumnWidthWasChanged(BOOL leftPanel, const CColumn* column, int newWidth)
+{
+}
+
+BOOL WINAPI CFTPListingPluginDataInterface::GetInfoLineContent(int panel, const CFileData* file, BOOL isDir, int selectedFiles,
+                                                               int selectedDirs, BOOL displaySize, const CQuadWord& selectedSize,
+                                                               char* buffer, DWORD* hotTexts, int& hotTextsCount)
+{
+    return FALSE;
+}
+
+BOOL WINAPI CFTPListingPluginDataInterface::GetByteSize(const CFileData* file, BOOL isDir, CQuadWord* size)
+{
+    return FALSE;
+}
+
+BOOL WINAPI CFTPListingPluginDataInterface::GetLastWriteDate(const CFileData* file, BOOL isDir, SYSTEMTIME* date)
+{
+    return FALSE;
+}
+
+BOOL WINAPI CFTPListingPluginDataInterface::GetLastWriteTime(const CFileData* file, BOOL isDir, SYSTEMTIME* time)
+{
+    return FALSE;
+}
+
+//
+// ****************************************************************************
+// the interpreted parser
+//
+
+class CTestParserRule : public CFTPParserRule
+{
+public:
+    // replaces the compiled instructions by calls of UseFunction() for all functions of the rule,
+    // so UseRule() does exactly what it did before the rules were compiled
+    BOOL Interpret()
+    {
+        Code.DestroyMembers();
+        int i;
+        for (i = 0; i < Functions.Count; i++)
+        {
+            CFTPParserInstruction instr;
+            instr.OpCode = popCallFunction;
+            instr.SkipWhiteSpacesAfter = FALSE;
+            instr.Column = COL_IND_NONE;
+            instr.Number = 0;
+            instr.Function = Functions[i];
+            Code.Add(instr);
+        }
+        return Code.IsGood();
+    }
+};
+
+class CTestParser : public CFTPParser
+{
+public:
+    BOOL Interpret()
+    {
+        int i;
+        for (i = 0; i < Rules.Count; i++)
+        {
+            if (!((CTestParserRule*)Rules[i])->Interpret())
+                return FALSE;
+        }
+        return TRUE;
+    }
+};
+
+//
+// ****************************************************************************
+// comparison and benchmark
+//
+
+static double GetSeconds()
+{
+    LARGE_INTEGER c, f;
+    QueryPerformanceCounter(&c);
+    QueryPerformanceFrequency(&f);
+    return (double)c.QuadPart / (double)f.QuadPart;
+}
+
+static void StartParsing(CFTPParser* parser, const char* listing, const char* listingEnd)
+{
+    parser->BeforeParsing(listing, listingEnd, 2024, 6, 15, FALSE);
+}
+
+static BOOL SameItems(CFileData* a, BOOL isDirA, CFileData* b, BOOL isDirB, int columnsCount)
+{
+    if (isDirA != isDirB || strcmp(a->Name, b->Name) != 0 || a->NameLen != b->NameLen ||
+        a->Ext - a->Name != b->Ext - b->Name || a->Size.Value != b->Size.Value || a->Attr != b->Attr ||
+        a->LastWrite.dwLowDateTime != b->LastWrite.dwLowDateTime ||
+        a->LastWrite.dwHighDateTime != b->LastWrite.dwHighDateTime ||
+        a->Hidden != b->Hidden || a->IsLink != b->IsLink)
+    {
+        return FALSE;
+    }
+    CTestColumnValue* va = (CTestColumnValue*)a->PluginData;
+    CTestColumnValue* vb = (CTestColumnValue*)b->PluginData;
+    int i;
+    for (i = 0; i < columnsCount; i++)
+    {
+        if ((va[i].Str == NULL) != (vb[i].Str == NULL) || va[i].Str != NULL && strcmp(va[i].Str, vb[i].Str) != 0 ||
+            va[i].Number != vb[i].Number || memcmp(&va[i].Date, &vb[i].Date, sizeof(CFTPDate)) != 0 ||
+            memcmp(&va[i].Time, &vb[i].Time, sizeof(CFTPTime)) != 0)
+        {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+// parses the listing by both parsers in lockstep; returns the count of parsed items or -1 if
+// the parsers differ; 'complete' returns TRUE if the whole listing was parsed
+static int CompareParsers(const char* fileName, CTestServerType* type, CFTPParser* compiled, CFTPParser* interpreted,
+                          const char* listing, const char* listingEnd, BOOL* complete)
+{
+    TIndirectArray<CSrvTypeColumn>* columns = type->Columns;
+    CFTPListingPluginDataInterface dataIface(columns, FALSE, 0, FALSE);
+    DWORD* emptyColA = new DWORD[columns->Count];
+    DWORD* emptyColB = new DWORD[columns->Count];
+    const char* sA = listing;
+    const char* sB = listing;
+    StartParsing(compiled, listing, listingEnd);
+    StartParsing(interpreted, listing, listingEnd);
+    int items = 0;
+    BOOL differ = FALSE;
+    while (1)
+    {
+        CFileData fileA, fileB;
+        BOOL isDirA, isDirB;
+        BOOL errA = FALSE, errB = FALSE;
+        BOOL retA = compiled->GetNextItemFromListing(&fileA, &isDirA, &dataIface, columns, &sA, listingEnd, NULL, &errA, emptyColA);
+        BOOL retB = interpreted->GetNextItemFromListing(&fileB, &isDirB, &dataIface, columns, &sB, listingEnd, NULL, &errB, emptyColB);
+        if (retA != retB || sA != sB || errA != errB ||
+            retA && !SameItems(&fileA, isDirA, &fileB, isDirB, columns->Count))
+        {
+            printf("MISMATCH: %s parsed as %s: item %d (offset %d / %d)\n", fileName, type->Name, items,
+                   (int)(sA - listing), (int)(sB - listing));
+            differ = TRUE;
+        }
+        if (retA)
+        {
+            dataIface.ReleasePluginData(fileA, isDirA);
+            free(fileA.Name);
+        }
+        if (retB)
+        {
+            dataIface.ReleasePluginData(fileB, isDirB);
+            free(fileB.Name);
+        }
+        if (!retA || !retB || differ)
+            break;
+        items++;
+    }
+    *complete = !differ && sA == listingEnd;
+    delete[] emptyColA;
+    delete[] emptyColB;
+    return differ ? -1 : items;
+}
+
+// returns the time (in seconds) of 'repeat' parsings of the listing
+static double MeasureParser(CTestServerType* type, CFTPParser* parser, const char* listing, const char* listingEnd,
+                            int repeat)
+{
+    TIndirectArray<CSrvTypeColumn>* columns = type->Columns;
+    CFTPListingPluginDataInterface dataIface(columns, FALSE, 0, FALSE);
+    DWORD* emptyCol = new DWORD[columns->Count];
+    double t = GetSeconds();
+    int r;
+    for (r = 0; r < repeat; r++)
+    {
+        const char* s = listing;
+        StartParsing(parser, listing, listingEnd);
+        CFileData file;
+        BOOL isDir;
+        BOOL err = FALSE;
+        while (parser->GetNextItemFromListing(&file, &isDir, &dataIface, columns, &s, listingEnd, NULL, &err, emptyCol))
+        {
+            dataIface.ReleasePluginData(file, isDir);
+            free(file.Name);
+        }
+    }
+    t = GetSeconds() - t;
+    delete[] emptyCol;
+    return t;
+}
+
+static char* LoadListing(const char* name, int* size)
+{
+    FILE* f = fopen(name, "rb");
+    if (f == NULL)
+        return NULL;
+    fseek(f, 0, SEEK_END);
+    *size = (int)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* buf = (char*)malloc(*size + 1);
+    if (buf != NULL && (int)fread(buf, 1, *size, f) != *size)
+    {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    return buf;
+}
+
+int main(int argc, char* argv[])
+{
+    const char* dir = argc > 1 ? argv[1] : "..\\servers\\tests";
+    int repeat = argc > 2 ? atoi(argv[2]) : 2000;
+
+    int i;
+    for (i = 0; i < 256; i++)
+        LowerCaseTable[i] = (unsigned char)(UINT_PTR)CharLower((LPTSTR)(UINT_PTR)i);
+
+    CServerTypeList serverTypeList;
+    AddDefaultServerTypes(&serverTypeList);
+
+    CFTPParser* compiled[ARRAYSIZE(ServerTypes)];
+    CFTPParser* interpreted[ARRAYSIZE(ServerTypes)];
+    for (i = 0; i < ServerTypesCount; i++)
+    {
+        compiled[i] = CompileParsingRules(ServerTypes[i].Rules, ServerTypes[i].Columns, NULL, NULL, NULL);
+        interpreted[i] = CompileParsingRules(ServerTypes[i].Rules, ServerTypes[i].Columns, NULL, NULL, NULL);
+        if (compiled[i] == NULL || interpreted[i] == NULL || !((CTestParser*)interpreted[i])->Interpret())
+        {
+            printf("Unable to compile the rules of server type %s.\n", ServerTypes[i].Name);
+            return 1;
+        }
+    }
+
+    char mask[MAX_PATH];
+    _snprintf_s(mask, _TRUNCATE, "%s\\*.txt", dir);
+    WIN32_FIND_DATA data;
+    HANDLE find = FindFirstFile(mask, &data);
+    if (find == INVALID_HANDLE_VALUE)
+    {
+        printf("No listings found in %s.\n", dir);
+        return 1;
+    }
+
+    printf("%-16s %-30s %6s %14s %14s %8s\n", "listing", "server type", "items", "interpreted us", "compiled us", "speedup");
+    int listings = 0, failures = 0;
+    double totalInterpreted = 0, totalCompiled = 0;
+    do
+    {
+        char name[MAX_PATH];
+        _snprintf_s(name, _TRUNCATE, "%s\\%s", dir, data.cFileName);
+        int size;
+        char* listing = LoadListing(name, &size);
+        if (listing == NULL)
+        {
+            printf("Unable to read %s.\n", name);
+            failures++;
+            continue;
+        }
+        listings++;
+
+        // all server types must give the same results; the first one that parses the whole listing is measured
+        int measured = -1;
+        int measuredItems = 0;
+        for (i = 0; i < ServerTypesCount; i++)
+        {
+            BOOL complete;
+            int items = CompareParsers(data.cFileName, &ServerTypes[i], compiled[i], interpreted[i], listing,
+                                       listing + size, &complete);
+            if (items < 0)
+                failures++;
+            else
+            {
+                if (complete && items > 0 && measured == -1)
+                {
+                    measured = i;
+                    measuredItems = items;
+                }
+            }
+        }
+        if (measured != -1 && repeat > 0)
+        {
+            double tInterpreted = MeasureParser(&ServerTypes[measured], interpreted[measured], listing, listing + size, repeat);
+            double tCompiled = MeasureParser(&ServerTypes[measured], compiled[measured], listing, listing + size, repeat);
+            totalInterpreted += tInterpreted;
+            totalCompiled += tCompiled;
+            printf("%-16s %-30s %6d %14.1f %14.1f %8.2f\n", data.cFileName, ServerTypes[measured].Name, measuredItems,
+                   tInterpreted * 1e6 / repeat, tCompiled * 1e6 / repeat, tCompiled > 0 ? tInterpreted / tCompiled : 0.0);
+        }
+        else
+            printf("%-16s %-30s\n", data.cFileName, measured == -1 ? "(not parsed completely)" : ServerTypes[measured].Name);
+        free(listing);
+    } while (FindNextFile(find, &data));
+    FindClose(find);
+
+    printf("\n%d listings, %d server types, %d mismatches\n", listings, ServerTypesCount, failures);
+    if (totalCompiled > 0)
+        printf("total: interpreted %.1f ms, compiled %.1f ms, speedup %.2f\n", totalInterpreted * 1e3,
+               totalCompiled * 1e3, totalInterpreted / totalCompiled);
+    return failures == 0 ? 0 : 1;
+}
@@ -230,6 +230,7 @@ struct CFileData // nesmi sem prijit destruktor !
     unsigned Dirty : 1;           // je potreba tuto polozku prekreslit? (pouze docasna platnost; mezi nastavenim bitu a prekreslenim panelu nesmi byt pumpovana message queue, jinak muze dojit k prekresleni ikonky (icon reader) a tim resetu bitu! v dusledku se neprekresli polozka)
     unsigned CutToClip : 1;       // je CUT-nutej na clipboardu? (je-li 1, ikonka je pruhlednejsi o 50% - ghosted)
     unsigned IconOverlayDone : 1; // jen pro potreby icon-reader-threadu: ziskavame nebo uz jsme ziskavali icon-overlay? (0 - ne, 1 - ano)
+    unsigned NameInArena : 1;     // je-li 1, Name a DosName nejsou samostatne alokovane (lezi ve spolecnem bloku jmen listingu panelu), nesmi se tedy uvolnovat ani realokovat (zkopirujte si je)
 };
 
 // konstanty urcujici platnost dat, ktera jsou primo ulozena v CFileData (velikost, pripona, atd.)
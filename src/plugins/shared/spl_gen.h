@@ -736,6 +736,18 @@ public:
     virtual void WINAPI GetDigest(void* dest) = 0;
 };
 
+// identifikace obsahu souboru pro perzistentni cache digestu (viz
+// CSalamanderGeneralAbstract::GetFileDigestKey); digest ulozeny v cache se pouzije jen pokud
+// se shoduje cela identifikace (velikost, cas posledniho zapisu i ID souboru na svazku)
+struct CSalamanderFileDigestKey
+{
+    CQuadWord Size;           // velikost souboru
+    FILETIME LastWrite;       // cas posledniho zapisu do souboru
+    DWORD VolumeSerialNumber; // seriove cislo svazku, na kterem soubor lezi
+    DWORD FileIndexHigh;      // ID souboru na svazku (horni DWORD)
+    DWORD FileIndexLow;       // ID souboru na svazku (dolni DWORD)
+};
+
 #define SALPNG_GETALPHA 0x00000002    // pri vytvareni DIB se nastavi take alpha kanal (jinak bude roven 0)
 #define SALPNG_PREMULTIPLE 0x00000004 // ma vyznam, pokud je nastaveno SALPNG_GETALPHA; prednasobi RGB slozky tak, aby bylo na bitmapu mozne zavolat AlphaBlend() s BLENDFUNCTION::AlphaFormat==AC_SRC_ALPHA
 
@@ -3450,6 +3462,31 @@ public:
     // pouziva se pri critical shutdown k odblokovani okna/dialogu, nad kterym jsou otevrene
     // modalni dialogy, hrozi-li vice vrstev, je nutne volat opakovane
     virtual void WINAPI CloseAllOwnedEnabledDialogs(HWND parent, DWORD tid = 0) = 0;
+
+    // zjisti identifikaci obsahu souboru otevreneho jako 'file' (handle musi mit aspon pravo
+    // cist atributy) pro perzistentni cache digestu; identifikaci je treba zjistit pri otevreni
+    // souboru, ze ktereho se digest pocita, a predat ji do GetCachedFileDigest() a StoreFileDigest();
+    // vraci FALSE pri chybe (digest pak nelze v cache hledat ani do ni ulozit)
+    // mozne volat z libovolneho threadu
+    virtual BOOL WINAPI GetFileDigestKey(HANDLE file, CSalamanderFileDigestKey* key) = 0;
+
+    // hleda v perzistentni cache digestu digest souboru 'fileName' (plne jmeno) s identifikaci
+    // 'key' spocitany algoritmem 'algorithm' (jmeno algoritmu, napr. "MD5" nebo "SHA1");
+    // pri uspechu vraci TRUE, digest v bufferu 'digest' o velikosti 'digestSize' bajtu a jeho
+    // delku v 'digestLen'; vraci FALSE, pokud digest v cache neni, soubor se od jeho ulozeni
+    // zmenil, cache je vypnuta (konfigurace) nebo nedostupna (napr. chybi sqlite.dll)
+    // mozne volat z libovolneho threadu
+    virtual BOOL WINAPI GetCachedFileDigest(const char* fileName, const CSalamanderFileDigestKey* key,
+                                            const char* algorithm, BYTE* digest, int digestSize,
+                                            int* digestLen) = 0;
+
+    // ulozi do perzistentni cache digestu digest 'digest' o delce 'digestLen' bajtu souboru
+    // 'fileName' (plne jmeno) s identifikaci 'key' spocitany algoritmem 'algorithm' (viz
+    // GetCachedFileDigest()); ukladat se smi jen digest celeho obsahu souboru; pri chybe nebo
+    // vypnute cache nic nedela
+    // mozne volat z libovolneho threadu
+    virtual void WINAPI StoreFileDigest(const char* fileName, const CSalamanderFileDigestKey* key,
+                                        const char* algorithm, const BYTE* digest, int digestLen) = 0;
 };
 
 #ifdef _MSC_VER
@@ -191,8 +191,9 @@
 //   101 - 4.0 beta 1 (DB177)
 //   102 - 4.0
 //   103 - 5.0
+//   104 - verze nasledujici po 5.0 (cache digestu v CSalamanderGeneralAbstract)
 
-#define LAST_VERSION_OF_SALAMANDER 103
-#define REQUIRE_LAST_VERSION_OF_SALAMANDER "This plugin requires Open Salamander 5.0 (" SAL_VER_PLATFORM ") or later."
+#define LAST_VERSION_OF_SALAMANDER 104
+#define REQUIRE_LAST_VERSION_OF_SALAMANDER "This plugin requires a newer version of Open Salamander than 5.0 (" SAL_VER_PLATFORM ")."
 
 #endif // __SPL_VERS_H
@@ -2,6 +2,7 @@
 
 #include "../dlldefs.h"
 #include "../fileio.h"
+#include "../parallel.h"
 #include "bzlib.h"
 #include "bzip.h"
 
@@ -9,8 +10,45 @@
 #include "..\tar.rh2"
 #include "..\lang\lang.rh"
 
+// kinds of boundaries in a bzip2 stream
+#define BZ_CHUNK_BLOCK 0 // compressed block
+#define BZ_CHUNK_END 1   // end of a stream, possibly followed by another stream
+
+// 48 bit magic numbers at the start of a block and at the end of a stream
+#define BZ_BLOCK_MAGIC ((unsigned __int64)0x314159265359)
+#define BZ_END_MAGIC ((unsigned __int64)0x177245385090)
+
+// decompresses the blocks of bzip2 streams on worker threads; the blocks do not
+// depend on each other, they start at arbitrary bits found by their magic numbers
+class CParallelBZip: public CParallelStream
+{
+  public:
+    CParallelBZip(CBZip *owner, HANDLE file, unsigned __int64 start, unsigned __int64 end,
+                  unsigned int combinedCRC, int blockSize);
+    virtual ~CParallelBZip() { Stop(); }
+
+    unsigned int GetCombinedCRC() { return CombinedCRC; }
+    int GetBlockSize() { return BlockSize; }
+
+  protected:
+    CBZip *Owner;
+    unsigned int CombinedCRC;   // of the blocks of the current stream before GetPos()
+    int BlockSize;              // of the current stream
+    unsigned char Shifts[256];  // bit N set: a magic number beginning at bit N of a byte
+                                // may continue with this byte
+
+    virtual BOOL FindBoundary(const unsigned char *data, unsigned int size, unsigned __int64 dataPos,
+                              BOOL last, unsigned __int64 &from, int &type);
+    virtual int Decompress(CParallelChunk *chunk);
+    virtual BOOL Accept(CParallelChunk *chunk);
+
+    int DecodeBlock(CParallelChunk *chunk);
+    int DecodeEnd(CParallelChunk *chunk);
+};
+
 CBZip::CBZip(const char *filename, HANDLE file, unsigned char *buffer, unsigned long start, unsigned long read, CQuadWord inputSize):
-  CZippedFile(filename, file, buffer, start, read, inputSize), BZStream(NULL), EndReached(FALSE)
+  CZippedFile(filename, file, buffer, start, read, inputSize), BZStream(NULL), EndReached(FALSE),
+  AtStreamStart(TRUE), CanParallel(FALSE), Parallel(NULL)
 {
   CALL_STACK_MESSAGE2("CBZip::CBZip(%s, , , )", filename);
   
@@ -66,12 +104,17 @@ CBZip::CBZip(const char *filename, HANDLE file, unsigned char *buffer, unsigned
     }
     return;
   }
+  // blocks are decompressed on worker threads if there are more processors
+  CanParallel = CParallelStream::GetThreadCount() > 1;
+  BZ2_bzDecompressStopAtBlocks(BZStream, CanParallel);
   // done
 }
 
 CBZip::~CBZip()
 {
   CALL_STACK_MESSAGE1("CBZip::~CBZip()");
+  if (Parallel != NULL)
+    delete Parallel;
   if (BZStream)
   {
     int ret = BZ2_bzDecompressEnd(BZStream);
@@ -85,54 +128,453 @@ CBZip::~CBZip()
 BOOL
 CBZip::DecompressBlock(unsigned short needed)
 {
-  if (EndReached)
-    return TRUE;
-  int ret = BZ_OK;
-  while (ret != BZ_STREAM_END && ExtrEnd < Window + BUFSIZE)
-  {
-    unsigned char *src = DataStart;
-    // at least one byte must already be buffered
-    if (DataEnd == DataStart)
-      src = (unsigned char *)FReadBlock(0);
-    if (src == NULL)
+  while (!EndReached && ExtrEnd < Window + BUFSIZE)
+  {
+    if (AtStreamStart)
+    {
+      // nothing of the stream was decompressed yet, worker threads can take over
+      // right behind its header
+      AtStreamStart = FALSE;
+      const unsigned char *header = CanParallel ? PeekInput(4) : NULL;
+      if (header != NULL && header[3] > '0' && header[3] <= '9')
+        StartParallel(StreamPos.Value * 8 + 32, 0, header[3] - '0');
+    }
+    if (!(Parallel != NULL ? ParallelBlock() : SequentialBlock()))
       return FALSE;
-    if (DataEnd == DataStart)
+  }
+  return TRUE;
+}
+
+BOOL
+CBZip::SequentialBlock()
+{
+  unsigned char *src = DataStart;
+  // at least one byte must already be buffered
+  if (DataEnd == DataStart)
+    src = (unsigned char *)FReadBlock(0);
+  if (src == NULL)
+    return FALSE;
+  if (DataEnd == DataStart)
+  {
+    Ok = FALSE;
+    ErrorCode = IDS_ERR_EOF;
+    return FALSE;
+  }
+  BZStream->next_in = (char *)DataStart;
+  BZStream->avail_in = (unsigned int)(DataEnd - DataStart);
+  BZStream->next_out = (char *)ExtrEnd;
+  BZStream->avail_out = BUFSIZE - (unsigned int)(ExtrEnd - Window);
+  int ret = BZ2_bzDecompress(BZStream);
+  if (ret != BZ_OK && ret != BZ_STREAM_END && ret != BZ_BLOCK_END)
+  {
+    Ok = FALSE;
+    switch (ret)
     {
-      Ok = FALSE;
-      ErrorCode = IDS_ERR_EOF;
+      case BZ_DATA_ERROR:
+      case BZ_DATA_ERROR_MAGIC:
+        ErrorCode = IDS_ERR_CORRUPT;
+        break;
+      case BZ_MEM_ERROR:
+        ErrorCode = IDS_ERR_MEMORY;
+        break;
+      case BZ_PARAM_ERROR:
+      default:
+        ErrorCode = IDS_ERR_INTERNAL;
+        break;
+    }
+    return FALSE;
+  }
+  // commit the consumed input bytes
+  FReadBlock((unsigned int)(BZStream->next_in - (char *)DataStart));
+  unsigned short extracted = (unsigned short)((unsigned char *)BZStream->next_out - ExtrEnd);
+  ExtrEnd = (unsigned char *)BZStream->next_out;
+  OutPos += CQuadWord(extracted, 0);
+  if (ret == BZ_BLOCK_END)
+  {
+    // we are between two blocks, the worker threads can continue from here
+    if (SeekIndex != NULL)
+      AddSeekPoint();
+    bz_block_pos pos;
+    if (CanParallel && BZ2_bzDecompressGetBlockPos(BZStream, &pos) == BZ_OK)
+      StartParallel(StreamPos.Value * 8 - pos.bsLive, pos.combinedCRC, pos.blockSize100k);
+  }
+  if (ret == BZ_STREAM_END)
+  {
+    // pbzip2 and others concatenate whole streams, go on with the next one
+    const unsigned char *header = PeekInput(4);
+    if (header != NULL && header[0] == 'B' && header[1] == 'Z' && header[2] == 'h' &&
+        header[3] > '0' && header[3] <= '9')
+    {
+      if (!RestartDecompressor(NULL))
+        return FALSE;
+      AtStreamStart = TRUE;
+    }
+    else
+      EndReached = TRUE;
+  }
+  return TRUE;
+}
+
+BOOL
+CBZip::ParallelBlock()
+{
+  int read = Parallel->Read(ExtrEnd, (int)(Window + BUFSIZE - ExtrEnd));
+  // the position of the block being read is good enough for the progress
+  CQuadWord pos;
+  pos.SetUI64(Parallel->GetPos() / 8);
+  if (pos > StreamPos)
+    StreamPos = pos;
+  if (read > 0)
+  {
+    ExtrEnd += read;
+    OutPos += CQuadWord(read, 0);
+    return TRUE;
+  }
+  if (read == PARALLEL_END)
+  {
+    delete Parallel;
+    Parallel = NULL;
+    EndReached = TRUE;
+    return TRUE;
+  }
+  if (read == PARALLEL_ERROR)
+  {
+    Ok = FALSE;
+    ErrorCode = Parallel->GetErrorCode();
+    LastError = Parallel->GetLastErr();
+    return FALSE;
+  }
+  // the workers could not handle the next block, decompress it here
+  unsigned __int64 start = Parallel->GetPos();
+  unsigned int combinedCRC = Parallel->GetCombinedCRC();
+  int blockSize = Parallel->GetBlockSize();
+  delete Parallel;
+  Parallel = NULL;
+  return ResumeAt(start, combinedCRC, blockSize);
+}
+
+BOOL
+CBZip::StartParallel(unsigned __int64 pos, unsigned int combinedCRC, int blockSize)
+{
+  CALL_STACK_MESSAGE1("CBZip::StartParallel()");
+  if (!CanParallel || InputSize.Value < pos / 8 + PARALLEL_MIN_INPUT)
+    return FALSE;
+  Parallel = new CParallelBZip(this, File, pos, InputSize.Value, combinedCRC, blockSize);
+  if (Parallel != NULL && Parallel->Start())
+    return TRUE;
+  // no threads, stay sequential
+  if (Parallel != NULL)
+    delete Parallel;
+  Parallel = NULL;
+  CanParallel = FALSE;
+  return FALSE;
+}
+
+// continues sequentially with the block starting at bit 'pos' of the archive file
+BOOL
+CBZip::ResumeAt(unsigned __int64 pos, unsigned int combinedCRC, int blockSize)
+{
+  CALL_STACK_MESSAGE1("CBZip::ResumeAt()");
+  if (!SeekInput(CQuadWord().SetUI64(pos / 8)))
+    return FALSE;
+  bz_block_pos blockPos;
+  blockPos.bsLive = pos % 8 == 0 ? 0 : 8 - (int)(pos % 8);
+  blockPos.bsBuff = 0;
+  if (blockPos.bsLive != 0)
+  {
+    unsigned char byte = FReadByte();
+    if (!Ok)
       return FALSE;
+    blockPos.bsBuff = byte & ((1 << blockPos.bsLive) - 1);
+  }
+  blockPos.combinedCRC = combinedCRC;
+  blockPos.blockSize100k = blockSize;
+  return RestartDecompressor(&blockPos);
+}
+
+// starts a fresh decompressor at the start of a stream (pos == NULL) or at a block
+BOOL
+CBZip::RestartDecompressor(const bz_block_pos *pos)
+{
+  BZ2_bzDecompressEnd(BZStream);
+  memset(BZStream, 0, sizeof(bz_stream));
+  int ret = BZ2_bzDecompressInit(BZStream, 0, 0);
+  if (ret == BZ_OK)
+    ret = BZ2_bzDecompressStopAtBlocks(BZStream, SeekIndex != NULL || CanParallel);
+  if (ret == BZ_OK && pos != NULL)
+    ret = BZ2_bzDecompressSetBlockPos(BZStream, pos);
+  if (ret != BZ_OK)
+  {
+    Ok = FALSE;
+    ErrorCode = ret == BZ_MEM_ERROR ? IDS_ERR_MEMORY : IDS_ERR_INTERNAL;
+    return FALSE;
+  }
+  return TRUE;
+}
+
+// returns the next 'count' bytes of the input without consuming them, NULL at the end
+const unsigned char *
+CBZip::PeekInput(unsigned int count)
+{
+  if ((unsigned int)(DataEnd - DataStart) < count)
+  {
+    if (FReadBlock(count) == NULL)
+    {
+      if (Ok)
+        ErrorCode = 0; // the end of the file is not an error here
+      return NULL;
     }
-    BZStream->next_in = (char *)DataStart;
-    BZStream->avail_in = (unsigned int)(DataEnd - DataStart);
-    BZStream->next_out = (char *)ExtrEnd;
-    BZStream->avail_out = BUFSIZE - (unsigned int)(ExtrEnd - Window);
-    ret = BZ2_bzDecompress(BZStream);
-    if (ret != BZ_OK && ret != BZ_STREAM_END)
+    // mark the data as unread again
+    DataStart -= count;
+    StreamPos -= CQuadWord(count, 0);
+  }
+  return DataStart;
+}
+
+void
+CBZip::SetSeekIndex(CSeekIndex *index)
+{
+  CZippedFile::SetSeekIndex(index);
+  BZ2_bzDecompressStopAtBlocks(BZStream, SeekIndex != NULL || CanParallel);
+}
+
+void
+CBZip::AddSeekPoint()
+{
+  if (!Ok || !SeekIndex->WantPoint(OutPos))
+    return;
+  // bzip2 blocks do not depend on each other, the point needs no window
+  CSeekPoint point;
+  bz_block_pos pos;
+  if (BZ2_bzDecompressGetBlockPos(BZStream, &pos) == BZ_OK)
+  {
+    point.Bits = pos.bsBuff;
+    point.BitCount = pos.bsLive;
+    point.Crc = pos.combinedCRC;
+    point.BlockSize = pos.blockSize100k;
+  }
+  else
+  {
+    // nothing was decompressed yet, the point is the start of the stream
+    if (OutPos.Value != 0)
+      return;
+    point.Bits = point.BitCount = point.Crc = 0;
+    point.BlockSize = 0;
+  }
+  point.Out = OutPos;
+  point.In = StreamPos;
+  point.MemberCnt.Set(0, 0);
+  point.Window = NULL;
+  SeekIndex->AddPoint(point, NULL, 0);
+}
+
+BOOL
+CBZip::RestoreSeekPoint(const CSeekPoint *point)
+{
+  CALL_STACK_MESSAGE1("CBZip::RestoreSeekPoint()");
+  if (Parallel != NULL)
+  {
+    delete Parallel;
+    Parallel = NULL;
+  }
+  // start over with a fresh decompressor
+  bz_block_pos pos;
+  pos.bsBuff = point->Bits;
+  pos.bsLive = point->BitCount;
+  pos.combinedCRC = point->Crc;
+  pos.blockSize100k = point->BlockSize;
+  if (!RestartDecompressor(point->BlockSize != 0 ? &pos : NULL))
+    return FALSE;
+  if (!SeekInput(point->In))
+    return FALSE;
+  EndReached = FALSE;
+  AtStreamStart = point->BlockSize == 0;
+  ExtrStart = Window;
+  ExtrEnd = Window;
+  OutPos = point->Out;
+  // the rest of the blocks can be decompressed by the worker threads again
+  if (point->BlockSize != 0)
+    StartParallel(point->In.Value * 8 - point->BitCount, point->Crc, point->BlockSize);
+  return TRUE;
+}
+
+//********************************************************
+//
+//  CParallelBZip
+//
+
+CParallelBZip::CParallelBZip(CBZip *owner, HANDLE file, unsigned __int64 start, unsigned __int64 end,
+                             unsigned int combinedCRC, int blockSize):
+  CParallelStream(file, start, end), Owner(owner), CombinedCRC(combinedCRC), BlockSize(blockSize)
+{
+  // second bytes of the magic numbers for each bit they can begin at
+  memset(Shifts, 0, sizeof(Shifts));
+  int shift;
+  for (shift = 0; shift < 8; shift++)
+  {
+    Shifts[(BZ_BLOCK_MAGIC >> (32 + shift)) & 0xFF] |= 1 << shift;
+    Shifts[(BZ_END_MAGIC >> (32 + shift)) & 0xFF] |= 1 << shift;
+  }
+}
+
+BOOL
+CParallelBZip::FindBoundary(const unsigned char *data, unsigned int size, unsigned __int64 dataPos,
+                            BOOL last, unsigned __int64 &from, int &type)
+{
+  // a magic number takes 48 bits and may begin at any bit of its first byte, so 7 bytes are needed
+  unsigned int i = (unsigned int)(from / 8 - dataPos);
+  unsigned int firstShifts = 0xFF << (from % 8);
+  for (; i + 7 <= size; i++, firstShifts = 0xFF)
+  {
+    unsigned int shifts = Shifts[data[i + 1]] & firstShifts;
+    if (shifts == 0)
+      continue;
+    unsigned __int64 bits = 0;
+    int j;
+    for (j = 0; j < 7; j++)
+      bits = (bits << 8) | data[i + j];
+    int shift;
+    for (shift = 0; shift < 8; shift++)
     {
-      Ok = FALSE;
-      switch (ret)
+      if ((shifts & (1 << shift)) == 0)
+        continue;
+      unsigned __int64 magic = (bits >> (8 - shift)) & 0xFFFFFFFFFFFF;
+      if (magic == BZ_BLOCK_MAGIC || magic == BZ_END_MAGIC)
       {
-        case BZ_DATA_ERROR:
-        case BZ_DATA_ERROR_MAGIC:
-          ErrorCode = IDS_ERR_CORRUPT;
-          break;
-        case BZ_MEM_ERROR:
-          ErrorCode = IDS_ERR_MEMORY;
-          break;
-        case BZ_PARAM_ERROR:
-        default:
-          ErrorCode = IDS_ERR_INTERNAL;
-          break;
+        type = magic == BZ_BLOCK_MAGIC ? BZ_CHUNK_BLOCK : BZ_CHUNK_END;
+        from = (dataPos + i) * 8 + shift;
+        return TRUE;
       }
-      return FALSE;
     }
-    // commit the consumed input bytes
-    FReadBlock((unsigned int)(BZStream->next_in - (char *)DataStart));
-    unsigned short extracted = (unsigned short)((unsigned char *)BZStream->next_out - ExtrEnd);
-    ExtrEnd = (unsigned char *)BZStream->next_out;
   }
-  if (ret == BZ_STREAM_END)
-    EndReached = TRUE;
+  // at the end of the file there is no room left for a block
+  unsigned __int64 examined = (dataPos + (last ? size : i)) * 8;
+  if (examined > from)
+    from = examined;
+  return FALSE;
+}
+
+int
+CParallelBZip::Decompress(CParallelChunk *chunk)
+{
+  if (chunk->Type == BZ_CHUNK_BLOCK)
+    return DecodeBlock(chunk);
+  return DecodeEnd(chunk);
+}
+
+int
+CParallelBZip::DecodeBlock(CParallelChunk *chunk)
+{
+  bz_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  if (BZ2_bzDecompressInit(&stream, 0, 0) != BZ_OK)
+    return CHUNK_ERROR;
+  // the block begins inside the first byte; its stream header is not known here,
+  // the largest block size fits all blocks
+  int skip = (int)(chunk->Start % 8);
+  bz_block_pos pos;
+  pos.bsLive = skip == 0 ? 0 : 8 - skip;
+  pos.bsBuff = skip == 0 ? 0 : chunk->In[0] & ((1 << pos.bsLive) - 1);
+  pos.combinedCRC = 0;
+  pos.blockSize100k = 9;
+  int firstBits = pos.bsLive;
+  int state = CHUNK_ERROR;
+  if (BZ2_bzDecompressStopAtBlocks(&stream, TRUE) == BZ_OK &&
+      BZ2_bzDecompressSetBlockPos(&stream, &pos) == BZ_OK)
+  {
+    stream.next_in = (char *)chunk->In + (skip == 0 ? 0 : 1);
+    stream.avail_in = chunk->InSize - (skip == 0 ? 0 : 1);
+    while (!IsTerminating())
+    {
+      if (chunk->OutSize == chunk->OutAlloc && !GrowOutput(chunk))
+        break;
+      stream.next_out = (char *)chunk->Out + chunk->OutSize;
+      stream.avail_out = chunk->OutAlloc - chunk->OutSize;
+      int ret = BZ2_bzDecompress(&stream);
+      chunk->OutSize = (unsigned int)((unsigned char *)stream.next_out - chunk->Out);
+      if (ret == BZ_BLOCK_END)
+      {
+        // starting with zero, the combined CRC of one block is its CRC
+        if (BZ2_bzDecompressGetBlockPos(&stream, &pos) == BZ_OK)
+        {
+          chunk->Crc = pos.combinedCRC;
+          chunk->Next = chunk->Start + firstBits + (unsigned __int64)stream.total_in_lo32 * 8 - pos.bsLive;
+          state = CHUNK_OK;
+        }
+        break;
+      }
+      if (ret != BZ_OK)
+        break;
+      if (stream.avail_in == 0 && stream.avail_out != 0)
+      {
+        state = CHUNK_INCOMPLETE;
+        break;
+      }
+    }
+  }
+  BZ2_bzDecompressEnd(&stream);
+  return state;
+}
+
+int
+CParallelBZip::DecodeEnd(CParallelChunk *chunk)
+{
+  // 48 bits of the magic number, 32 bits of the combined CRC, padding to a whole byte
+  unsigned int skip = (unsigned int)(chunk->Start % 8);
+  if (chunk->InSize * 8 < skip + 80)
+    return CHUNK_INCOMPLETE;
+  unsigned int crc = 0;
+  unsigned int bit;
+  for (bit = skip + 48; bit < skip + 80; bit++)
+    crc = (crc << 1) | ((chunk->In[bit / 8] >> (7 - bit % 8)) & 1);
+  chunk->Crc = crc;
+  // another stream may follow
+  unsigned int end = (skip + 80 + 7) / 8;
+  const unsigned char *header = chunk->In + end;
+  if (chunk->InSize >= end + 4 && header[0] == 'B' && header[1] == 'Z' && header[2] == 'h' &&
+      header[3] > '0' && header[3] <= '9')
+  {
+    chunk->Param = header[3] - '0';
+    chunk->Next = (chunk->Start / 8 + end + 4) * 8;
+  }
+  else
+  {
+    chunk->Last = TRUE;
+    chunk->Next = (chunk->Start / 8 + end) * 8;
+  }
+  return CHUNK_OK;
+}
+
+BOOL
+CParallelBZip::Accept(CParallelChunk *chunk)
+{
+  if (chunk->Type == BZ_CHUNK_BLOCK)
+  {
+    // the block begins here, the sequential decompressor could start here too
+    CSeekIndex *index = Owner->SeekIndex;
+    if (index != NULL && index->WantPoint(Owner->OutPos))
+    {
+      int skip = (int)(chunk->Start % 8);
+      CSeekPoint point;
+      point.Out = Owner->OutPos;
+      point.In.SetUI64(chunk->Start / 8 + (skip == 0 ? 0 : 1));
+      point.BitCount = skip == 0 ? 0 : 8 - skip;
+      point.Bits = skip == 0 ? 0 : chunk->In[0] & ((1 << point.BitCount) - 1);
+      point.Crc = CombinedCRC;
+      point.MemberCnt.Set(0, 0);
+      point.BlockSize = BlockSize;
+      point.Window = NULL;
+      index->AddPoint(point, NULL, 0);
+    }
+    CombinedCRC = ((CombinedCRC << 1) | (CombinedCRC >> 31)) ^ (unsigned int)chunk->Crc;
+    return TRUE;
+  }
+  // end of the stream; the sequential decompressor reports a broken one
+  if (chunk->Crc != CombinedCRC)
+    return FALSE;
+  CombinedCRC = 0;
+  if (!chunk->Last)
+    BlockSize = chunk->Param;
   return TRUE;
 }
 
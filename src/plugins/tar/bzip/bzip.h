@@ -1,6 +1,8 @@
 ﻿#ifndef __BZIP_H__
 #define __BZIP_H__
 
+class CParallelBZip;
+
 class CBZip: public CZippedFile
 {
   public:
@@ -8,14 +10,30 @@ class CBZip: public CZippedFile
     virtual ~CBZip();
 
     virtual BOOL BuggySize() { return TRUE; }
+    virtual BOOL CanIndex() { return TRUE; }
+    virtual void SetSeekIndex(CSeekIndex *index);
 
     static BOOL DetectArchive(const unsigned char *inBuffer, unsigned int inBufSize);
 
   protected:
     BOOL EndReached;          // set, when all data was extracted
+    BOOL AtStreamStart;       // the decompressor is about to read the header of a stream
+    BOOL CanParallel;         // worker threads may decompress the blocks
+    CParallelBZip *Parallel;  // decompresses the blocks on worker threads or NULL
 
     bz_stream *BZStream;
     virtual BOOL DecompressBlock(unsigned short needed);
+    virtual void AddSeekPoint();
+    virtual BOOL RestoreSeekPoint(const CSeekPoint *point);
+
+    BOOL SequentialBlock();
+    BOOL ParallelBlock();
+    BOOL StartParallel(unsigned __int64 pos, unsigned int combinedCRC, int blockSize);
+    BOOL ResumeAt(unsigned __int64 pos, unsigned int combinedCRC, int blockSize);
+    BOOL RestartDecompressor(const bz_block_pos *pos);
+    const unsigned char *PeekInput(unsigned int count);
+
+    friend class CParallelBZip;
 };
 
 #endif // __BZIP_H__
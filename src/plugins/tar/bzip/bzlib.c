@@ -533,6 +533,7 @@ int BZ_API(BZ2_bzDecompressInit)
    s->tt                    = NULL;
    s->currBlockNo           = 0;
    s->verbosity             = verbosity;
+   s->stopAtBlock           = False;
 
    return BZ_OK;
 }
@@ -844,6 +845,7 @@ int BZ_API(BZ2_bzDecompress) ( bz_stream *strm )
                     (s->calculatedCombinedCRC >> 31);
             s->calculatedCombinedCRC ^= s->calculatedBlockCRC;
             s->state = BZ_X_BLKHDR_1;
+            if (s->stopAtBlock) return BZ_BLOCK_END;
          } else {
             return BZ_OK;
          }
@@ -868,6 +870,84 @@ int BZ_API(BZ2_bzDecompress) ( bz_stream *strm )
 }
 
 
+/*---------------------------------------------------*/
+int BZ_API(BZ2_bzDecompressStopAtBlocks) ( bz_stream *strm, int stop )
+{
+   DState* s;
+   if (strm == NULL) return BZ_PARAM_ERROR;
+   s = strm->state;
+   if (s == NULL) return BZ_PARAM_ERROR;
+   if (s->strm != strm) return BZ_PARAM_ERROR;
+
+   s->stopAtBlock = (Bool)(stop != 0);
+   return BZ_OK;
+}
+
+
+/*---------------------------------------------------*/
+int BZ_API(BZ2_bzDecompressGetBlockPos) ( bz_stream *strm, 
+                                          bz_block_pos *pos )
+{
+   DState* s;
+   if (strm == NULL || pos == NULL) return BZ_PARAM_ERROR;
+   s = strm->state;
+   if (s == NULL) return BZ_PARAM_ERROR;
+   if (s->strm != strm) return BZ_PARAM_ERROR;
+   if (s->state != BZ_X_BLKHDR_1) return BZ_SEQUENCE_ERROR;
+
+   pos->bsBuff        = s->bsBuff & ((1 << s->bsLive) - 1);
+   pos->bsLive        = s->bsLive;
+   pos->combinedCRC   = s->calculatedCombinedCRC;
+   pos->blockSize100k = s->blockSize100k;
+   return BZ_OK;
+}
+
+
+/*---------------------------------------------------*/
+int BZ_API(BZ2_bzDecompressSetBlockPos) ( bz_stream *strm, 
+                                          const bz_block_pos *pos )
+{
+   DState* s;
+   char    header[4];
+   char*   next_in;
+   UInt32  avail_in, total_in_lo32, total_in_hi32;
+   Int32   ret;
+
+   if (strm == NULL || pos == NULL) return BZ_PARAM_ERROR;
+   s = strm->state;
+   if (s == NULL) return BZ_PARAM_ERROR;
+   if (s->strm != strm) return BZ_PARAM_ERROR;
+   if (s->state != BZ_X_MAGIC_1) return BZ_SEQUENCE_ERROR;
+   if (pos->blockSize100k < 1 || pos->blockSize100k > 9 ||
+       pos->bsLive < 0 || pos->bsLive > 31) return BZ_PARAM_ERROR;
+
+   /* let the decoder parse a stream header to set itself up, it then
+      waits for the first block header */
+   header[0] = BZ_HDR_B;
+   header[1] = BZ_HDR_Z;
+   header[2] = BZ_HDR_h;
+   header[3] = (char)(BZ_HDR_0 + pos->blockSize100k);
+   next_in       = strm->next_in;
+   avail_in      = strm->avail_in;
+   total_in_lo32 = strm->total_in_lo32;
+   total_in_hi32 = strm->total_in_hi32;
+   strm->next_in  = header;
+   strm->avail_in = 4;
+   ret = BZ2_decompress ( s );
+   strm->next_in       = next_in;
+   strm->avail_in      = avail_in;
+   strm->total_in_lo32 = total_in_lo32;
+   strm->total_in_hi32 = total_in_hi32;
+   if (ret != BZ_OK) return ret;
+   if (s->state != BZ_X_BLKHDR_1) return BZ_SEQUENCE_ERROR;
+
+   s->bsBuff                = pos->bsBuff;
+   s->bsLive                = pos->bsLive;
+   s->calculatedCombinedCRC = pos->combinedCRC;
+   return BZ_OK;
+}
+
+
 /*---------------------------------------------------*/
 int BZ_API(BZ2_bzDecompressEnd)  ( bz_stream *strm )
 {
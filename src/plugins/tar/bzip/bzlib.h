@@ -35,6 +35,7 @@ extern "C" {
 #define BZ_FLUSH_OK          2
 #define BZ_FINISH_OK         3
 #define BZ_STREAM_END        4
+#define BZ_BLOCK_END         5  /* Salamander: see BZ2_bzDecompressStopAtBlocks */
 #define BZ_SEQUENCE_ERROR    (-1)
 #define BZ_PARAM_ERROR       (-2)
 #define BZ_MEM_ERROR         (-3)
@@ -127,6 +128,39 @@ BZ_EXTERN int BZ_API(BZ2_bzDecompressEnd) (
       bz_stream *strm 
    );
 
+/*-- Salamander: resuming decompression at a block boundary --*/
+
+/* state of the decompressor between two blocks; the next block starts
+   with the bsLive low bits of bsBuff followed by the unread input */
+typedef 
+   struct {
+      unsigned int bsBuff;
+      int          bsLive;
+      unsigned int combinedCRC;
+      int          blockSize100k;
+   }
+   bz_block_pos;
+
+/* with stop != 0 BZ2_bzDecompress returns BZ_BLOCK_END whenever a block
+   has been completely written out and the next one was not started yet */
+BZ_EXTERN int BZ_API(BZ2_bzDecompressStopAtBlocks) ( 
+      bz_stream *strm,
+      int       stop
+   );
+
+/* valid right after BZ2_bzDecompress returned BZ_BLOCK_END */
+BZ_EXTERN int BZ_API(BZ2_bzDecompressGetBlockPos) ( 
+      bz_stream    *strm,
+      bz_block_pos *pos
+   );
+
+/* called on a freshly initialised stream instead of feeding it the stream
+   header; decompression then continues with the block described by pos */
+BZ_EXTERN int BZ_API(BZ2_bzDecompressSetBlockPos) ( 
+      bz_stream          *strm,
+      const bz_block_pos *pos
+   );
+
 
 
 /*-- High(er) level library functions --*/
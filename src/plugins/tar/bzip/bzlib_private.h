@@ -367,6 +367,7 @@ typedef
       Bool     smallDecompress;
       Int32    currBlockNo;
       Int32    verbosity;
+      Bool     stopAtBlock;    /* Salamander: return BZ_BLOCK_END between blocks */
 
       /* for undoing the Burrows-Wheeler transform */
       Int32    origPtr;
@@ -130,7 +130,7 @@ CDecompressFile::CreateInstance(LPCTSTR fileName, DWORD inputOffset, CQuadWord i
 
 // class constructor
 CDecompressFile::CDecompressFile(const char* filename, HANDLE file, unsigned char* buffer, unsigned long start, unsigned long read, CQuadWord inputSize) : FileName(filename), File(file), Buffer(buffer), DataStart(buffer), DataEnd(buffer + read),
-                                                                                                                                                           OldName(NULL), Ok(TRUE), StreamPos(start, 0), ErrorCode(0), LastError(0), FreeBufAndFile(TRUE)
+                                                                                                                                                           OldName(NULL), Ok(TRUE), StreamPos(start, 0), StreamStart(start, 0), ErrorCode(0), LastError(0), FreeBufAndFile(TRUE)
 {
     CALL_STACK_MESSAGE3("CDecompressFile::CDecompressFile(%s, , %u)", filename, read);
 
@@ -342,12 +342,62 @@ void CDecompressFile::GetFileInfo(FILETIME& lastWrite, CQuadWord& fileSize, DWOR
     fileAttr = 0;
 }
 
+BOOL CDecompressFile::SeekInput(CQuadWord pos)
+{
+    LONG high = (LONG)pos.HiDWord;
+    if (SetFilePointer(File, pos.LoDWord, &high, FILE_BEGIN) == INVALID_SET_FILE_POINTER &&
+        GetLastError() != NO_ERROR)
+    {
+        Ok = FALSE;
+        ErrorCode = IDS_GZERR_SEEK;
+        LastError = GetLastError();
+        return FALSE;
+    }
+    DataStart = Buffer;
+    DataEnd = Buffer;
+    StreamPos = pos;
+    return TRUE;
+}
+
+BOOL CDecompressFile::GetLastWrite(FILETIME& lastWrite)
+{
+    return GetFileTime(File, NULL, NULL, &lastWrite);
+}
+
+// an uncompressed stream is the data itself, we simply move in the file
+BOOL CDecompressFile::SeekTo(CQuadWord pos, CSeekIndex* index)
+{
+    CALL_STACK_MESSAGE2("CDecompressFile::SeekTo(%I64u, )", pos.Value);
+    if (!Ok || StreamStart.Value + pos.Value > InputSize.Value)
+        return FALSE;
+    return SeekInput(StreamStart + pos);
+}
+
+CSeekIndex*
+CDecompressFile::CreateSeekIndex()
+{
+    FILETIME lastWrite;
+    if (!CanIndex() || !GetLastWrite(lastWrite))
+        return NULL;
+    return new CSeekIndex(FileName, StreamStart, InputSize, lastWrite);
+}
+
+CSeekIndex*
+CDecompressFile::DetachSeekIndex()
+{
+    FILETIME lastWrite;
+    if (!CanIndex() || !GetLastWrite(lastWrite))
+        return NULL;
+    return SeekIndexCache.Detach(FileName, StreamStart, InputSize, lastWrite);
+}
+
 //********************************************************
 //
 //  CZippedFile
 //
 
-CZippedFile::CZippedFile(const char* filename, HANDLE file, unsigned char* buffer, unsigned long start, unsigned long read, CQuadWord inputSize) : CDecompressFile(filename, file, buffer, start, read, inputSize), Window(NULL), ExtrStart(NULL), ExtrEnd(NULL)
+CZippedFile::CZippedFile(const char* filename, HANDLE file, unsigned char* buffer, unsigned long start, unsigned long read, CQuadWord inputSize) : CDecompressFile(filename, file, buffer, start, read, inputSize), Window(NULL), ExtrStart(NULL), ExtrEnd(NULL),
+                                                                                                                                                   OutPos(0, 0), SeekIndex(NULL)
 {
     // if the parent constructor failed, bail out immediately
     if (!Ok)
@@ -440,6 +490,41 @@ CZippedFile::GetBlock(unsigned short size, unsigned short* read /* = NULL*/)
     return ret;
 }
 
+void CZippedFile::SetSeekIndex(CSeekIndex* index)
+{
+    SeekIndex = CanIndex() ? index : NULL;
+    // the start of the data is the first point, so that any position can be reached
+    if (SeekIndex != NULL && OutPos.Value == 0)
+        AddSeekPoint();
+}
+
+BOOL CZippedFile::SeekTo(CQuadWord pos, CSeekIndex* index)
+{
+    CALL_STACK_MESSAGE2("CZippedFile::SeekTo(%I64u, )", pos.Value);
+    if (!Ok || index == NULL || !CanIndex())
+        return FALSE;
+
+    // position of the first unread byte
+    unsigned __int64 current = OutPos.Value - (ExtrEnd - ExtrStart);
+    const CSeekPoint* point = index->FindPoint(pos);
+    if (current > pos.Value || (point != NULL && point->Out.Value > current))
+    {
+        // we would have to go back or the point is closer than we are
+        if (point == NULL || !RestoreSeekPoint(point))
+            return FALSE;
+        current = point->Out.Value;
+    }
+    // decompress the rest up to 'pos' and throw it away
+    while (current < pos.Value)
+    {
+        unsigned short size = (unsigned short)(pos.Value - current > BUFSIZE ? BUFSIZE : pos.Value - current);
+        if (GetBlock(size) == NULL)
+            return FALSE;
+        current += size;
+    }
+    return TRUE;
+}
+
 void CZippedFile::GetFileInfo(FILETIME& lastWrite, CQuadWord& fileSize, DWORD& fileAttr)
 {
     CALL_STACK_MESSAGE1("CZippedFile::GetFileInfo(,,)");
@@ -460,3 +545,158 @@ void CZippedFile::GetFileInfo(FILETIME& lastWrite, CQuadWord& fileSize, DWORD& f
         lastWrite.dwHighDateTime = 0;
     }
 }
+
+//********************************************************
+//
+//  CSeekIndex
+//
+
+CSeekIndex::CSeekIndex(const char* fileName, CQuadWord start, CQuadWord size, const FILETIME& lastWrite)
+    : Start(start), Size(size), LastWrite(lastWrite), Span(SEEK_SPAN, 0), Windows(0), Points(64, 64)
+{
+    FileName = _strdup(fileName);
+}
+
+CSeekIndex::~CSeekIndex()
+{
+    int i;
+    for (i = 0; i < Points.Count; i++)
+        if (Points[i].Window != NULL)
+            free(Points[i].Window);
+    if (FileName != NULL)
+        free(FileName);
+}
+
+BOOL CSeekIndex::IsFor(const char* fileName, CQuadWord start, CQuadWord size, const FILETIME& lastWrite)
+{
+    return FileName != NULL && _stricmp(FileName, fileName) == 0 && Start == start && Size == size &&
+           CompareFileTime(&LastWrite, &lastWrite) == 0;
+}
+
+BOOL CSeekIndex::IsFor(const CSeekIndex* index)
+{
+    return index->FileName != NULL && IsFor(index->FileName, index->Start, index->Size, index->LastWrite);
+}
+
+void CSeekIndex::AddPoint(const CSeekPoint& point, const unsigned char* window, unsigned int windowPos)
+{
+    CSeekPoint p = point;
+    p.Window = NULL;
+    if (window != NULL)
+    {
+        p.Window = (unsigned char*)malloc(BUFSIZE);
+        if (p.Window == NULL)
+            return; // the index is only less dense
+        // unroll the circular buffer
+        memcpy(p.Window, window + windowPos, BUFSIZE - windowPos);
+        memcpy(p.Window + BUFSIZE - windowPos, window, windowPos);
+    }
+    Points.Add(p);
+    if (!Points.IsGood())
+    {
+        Points.ResetState();
+        if (p.Window != NULL)
+            free(p.Window);
+        return;
+    }
+    if (p.Window != NULL)
+        Windows++;
+    if (Windows > SEEK_MAX_WINDOWS || Points.Count > SEEK_MAX_POINTS)
+        Thin();
+}
+
+void CSeekIndex::Thin()
+{
+    // keep the first point (start of the data) and every other point after it
+    int i;
+    int count = 1;
+    for (i = 1; i < Points.Count; i++)
+    {
+        if (i % 2 == 0)
+            Points[count++] = Points[i];
+        else if (Points[i].Window != NULL)
+        {
+            free(Points[i].Window);
+            Windows--;
+        }
+    }
+    Points.Delete(count, Points.Count - count);
+    Span.Value *= 2;
+}
+
+const CSeekPoint*
+CSeekIndex::FindPoint(CQuadWord out)
+{
+    // binary search for the last point with Out <= out
+    int left = 0;
+    int right = Points.Count - 1;
+    const CSeekPoint* found = NULL;
+    while (left <= right)
+    {
+        int middle = (left + right) / 2;
+        if (Points[middle].Out.Value <= out.Value)
+        {
+            found = &Points[middle];
+            left = middle + 1;
+        }
+        else
+            right = middle - 1;
+    }
+    return found;
+}
+
+//********************************************************
+//
+//  CSeekIndexCache
+//
+
+CSeekIndexCache SeekIndexCache;
+
+CSeekIndexCache::CSeekIndexCache()
+    : Indexes(SEEK_CACHE_SIZE, SEEK_CACHE_SIZE)
+{
+    InitializeCriticalSection(&CS);
+}
+
+CSeekIndexCache::~CSeekIndexCache()
+{
+    Indexes.DestroyMembers();
+    DeleteCriticalSection(&CS);
+}
+
+CSeekIndex*
+CSeekIndexCache::Detach(const char* fileName, CQuadWord start, CQuadWord size, const FILETIME& lastWrite)
+{
+    CSeekIndex* ret = NULL;
+    EnterCriticalSection(&CS);
+    int i;
+    for (i = 0; i < Indexes.Count; i++)
+    {
+        if (Indexes[i]->IsFor(fileName, start, size, lastWrite))
+        {
+            ret = Indexes[i];
+            Indexes.Detach(i);
+            break;
+        }
+    }
+    LeaveCriticalSection(&CS);
+    return ret;
+}
+
+void CSeekIndexCache::Attach(CSeekIndex* index)
+{
+    EnterCriticalSection(&CS);
+    int i;
+    for (i = Indexes.Count - 1; i >= 0; i--)
+        if (Indexes[i]->IsFor(index))
+            Indexes.Delete(i);
+    if (Indexes.Count >= SEEK_CACHE_SIZE)
+        Indexes.Delete(0);
+    Indexes.Add(index);
+    if (!Indexes.IsGood())
+    {
+        Indexes.ResetState();
+        delete index;
+    }
+    LeaveCriticalSection(&CS);
+}
@@ -6,6 +6,84 @@
 // size of file read buffer
 #define BUFSIZE 0x8000 // buffer will be 32 KB
 
+// minimal distance of two seek points in the decompressed data; doubled
+// whenever the index grows over SEEK_MAX_WINDOWS points with a window
+#define SEEK_SPAN (1024 * 1024)
+#define SEEK_MAX_WINDOWS 512  // 512 x 32 KB windows of gzip = 16 MB per archive
+#define SEEK_MAX_POINTS 16384 // bzip2 points carry no window
+#define SEEK_CACHE_SIZE 4     // number of archives whose index is kept in memory
+
+// state of a compressed stream from which decompression can be resumed
+// without decompressing the archive from its beginning
+struct CSeekPoint
+{
+    CQuadWord Out;          // position in the decompressed data
+    CQuadWord In;           // position of the next input byte in the archive file
+    unsigned long Bits;     // input bits already read but not consumed yet
+    unsigned long BitCount; // number of valid bits in Bits
+    unsigned long Crc;      // gzip: CRC of the current member; bzip2: combined CRC of the blocks
+    CQuadWord MemberCnt;    // gzip: bytes extracted from the current member
+    int BlockSize;          // bzip2: block size of the stream (1..9); 0 = start of the stream
+    unsigned char* Window;  // gzip: the last BUFSIZE bytes of output, oldest first; otherwise NULL
+};
+
+// seek points of one compressed archive, collected while the archive is listed
+class CSeekIndex
+{
+public:
+    CSeekIndex(const char* fileName, CQuadWord start, CQuadWord size, const FILETIME& lastWrite);
+    ~CSeekIndex();
+
+    // returns TRUE if the index was built for the given stream of the given archive
+    BOOL IsFor(const char* fileName, CQuadWord start, CQuadWord size, const FILETIME& lastWrite);
+    BOOL IsFor(const CSeekIndex* index);
+
+    // returns TRUE if a point at position 'out' of the decompressed data is worth storing
+    BOOL WantPoint(CQuadWord out)
+    {
+        return Points.Count == 0 || out.Value >= Points[Points.Count - 1].Out.Value + Span.Value;
+    }
+    // stores a copy of 'point'; for gzip 'window' is the circular output buffer
+    // and 'windowPos' the index of its oldest byte, for bzip2 'window' is NULL
+    void AddPoint(const CSeekPoint& point, const unsigned char* window, unsigned int windowPos);
+    // returns the last point at or before position 'out' or NULL
+    const CSeekPoint* FindPoint(CQuadWord out);
+
+protected:
+    // drops every other point and doubles Span
+    void Thin();
+
+    char* FileName;      // archive the index belongs to
+    CQuadWord Start;     // position of the compressed stream in the archive
+    CQuadWord Size;      // size and time of the archive, to notice it has changed
+    FILETIME LastWrite;
+    CQuadWord Span;      // minimal distance of two points
+    int Windows;         // number of points with a window
+    TDirectArray<CSeekPoint> Points;
+};
+
+// indexes built by the last listings; ListArchive and UnpackOneFile are called
+// with separate CArchive objects, so the index has to outlive them
+class CSeekIndexCache
+{
+public:
+    CSeekIndexCache();
+    ~CSeekIndexCache();
+
+    // takes the index of the given stream out of the cache, the caller becomes its owner;
+    // returns NULL if there is none
+    CSeekIndex* Detach(const char* fileName, CQuadWord start, CQuadWord size, const FILETIME& lastWrite);
+    // puts 'index' to the cache (drops an older index of the same stream and the oldest
+    // index if the cache is full)
+    void Attach(CSeekIndex* index);
+
+protected:
+    CRITICAL_SECTION CS;
+    TIndirectArray<CSeekIndex> Indexes; // the oldest first
+};
+
+extern CSeekIndexCache SeekIndexCache;
+
 class CDecompressFile
 {
 public:
@@ -40,7 +118,24 @@ public:
     virtual const unsigned char* GetBlock(unsigned short size, unsigned short* read = NULL);
     virtual void GetFileInfo(FILETIME& lastWrite, CQuadWord& fileSize, DWORD& fileAttr);
 
+    // returns TRUE if the stream can record seek points (CSeekIndex); uncompressed streams need none
+    virtual BOOL CanIndex() { return FALSE; }
+    // while the stream is read from its beginning, seek points are recorded to 'index'
+    // (NULL = stop recording); the index stays owned by the caller
+    virtual void SetSeekIndex(CSeekIndex* index) {}
+    // continues reading at position 'pos' of the (decompressed) data, compressed streams
+    // use 'index' for it; returns FALSE if the stream cannot seek there
+    virtual BOOL SeekTo(CQuadWord pos, CSeekIndex* index);
+    // creates an empty index for this stream, or NULL
+    CSeekIndex* CreateSeekIndex();
+    // takes the index of this stream out of SeekIndexCache, or returns NULL
+    CSeekIndex* DetachSeekIndex();
+
 protected:
+    // continues reading the input at absolute position 'pos' of the archive file
+    BOOL SeekInput(CQuadWord pos);
+    // retrieves the write time of the archive file
+    BOOL GetLastWrite(FILETIME& lastWrite);
     // reads a block from the file
     const unsigned char* FReadBlock(unsigned int number);
     // reads a byte from the file
@@ -55,6 +150,7 @@ protected:
     char* OldName;            // original file name before packing
     CQuadWord InputSize;      // archive size
     CQuadWord StreamPos;      // position in the archive (for progress)
+    CQuadWord StreamStart;    // position where the stream starts in the archive file
     HANDLE File;              // opened archive
     DWORD LastError;          // if there was a system error (I/O...), the details are here
     unsigned char* Buffer;    // read buffer for the file
@@ -75,11 +171,20 @@ public:
     virtual const unsigned char* GetBlock(unsigned short size, unsigned short* read);
     virtual void Rewind(unsigned short size);
 
+    virtual void SetSeekIndex(CSeekIndex* index);
+    virtual BOOL SeekTo(CQuadWord pos, CSeekIndex* index);
+
 protected:
     unsigned char* Window;    // output circular buffer
     unsigned char* ExtrStart; // start of unread data in circular buffer
     unsigned char* ExtrEnd;   // end of extracted data in circular buffer
+    CQuadWord OutPos;         // position of ExtrEnd in the decompressed data (kept by CanIndex streams)
+    CSeekIndex* SeekIndex;    // index being built while listing or NULL
 
     virtual BOOL DecompressBlock(unsigned short needed) = 0;
     virtual BOOL CompactBuffer();
+    // records the current state to SeekIndex if it is worth it; called between blocks
+    virtual void AddSeekPoint() {}
+    // restores the state stored by AddSeekPoint
+    virtual BOOL RestoreSeekPoint(const CSeekPoint* point) { return FALSE; }
 };
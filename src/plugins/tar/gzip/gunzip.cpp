@@ -5,12 +5,35 @@
 
 #include "../dlldefs.h"
 #include "../fileio.h"
+#include "../parallel.h"
 #include "gzip.h"
 
 #include "..\tar.rh"
 #include "..\tar.rh2"
 #include "..\lang\lang.rh"
 
+#define GZIP_MIN_CHUNK (256 * 1024) // members are decompressed on worker threads in groups of at least this size
+
+// decompresses the members of a gzip stream on worker threads (pigz -i, concatenated
+// gzip files); a member does not depend on the previous ones, it starts at a byte
+// found by its header
+class CParallelGZip : public CParallelStream
+{
+public:
+    CParallelGZip(HANDLE file, unsigned __int64 start, unsigned __int64 end);
+    virtual ~CParallelGZip() { Stop(); }
+
+protected:
+    CSalamanderZLIBAbstract* ZLIB;
+
+    virtual BOOL FindBoundary(const unsigned char* data, unsigned int size, unsigned __int64 dataPos,
+                              BOOL last, unsigned __int64& from, int& type);
+    virtual int Decompress(CParallelChunk* chunk);
+
+    // returns TRUE if 'data' look like a header of a member the sequential decompressor accepts
+    static BOOL IsHeader(const unsigned char* data);
+};
+
 // Constants
 // If BMAX needs to be larger than 16, then h and x[] should be ulg.
 #define BMAX 16   // maximum bit length of any code (16 for explode)
@@ -926,6 +949,7 @@ BOOL CGZip::InflateBlock()
     // update crc and extracted size
     unsigned short extracted = (unsigned short)(ExtrEnd - begin);
     TotalCnt += CQuadWord(extracted, 0);
+    OutPos += CQuadWord(extracted, 0);
     crc = UpdateCRC(crc, begin, extracted);
 
     if (ret != -1)
@@ -960,7 +984,12 @@ BOOL CGZip::InflateBlock()
             if (Ok)
             {
                 // check for next GZIP block
+                CQuadWord memberStart = StreamPos;
                 LastBlock = !Initialize(ErrorCode);
+                // more members follow, worker threads can decompress them (seek points
+                // need the state of the sequential decompressor, not while listing)
+                if (!LastBlock && SeekIndex == NULL)
+                    StartParallel(memberStart);
             }
         }
     }
@@ -972,7 +1001,8 @@ BOOL CGZip::InflateBlock()
 CGZip::CGZip(const char* filename, HANDLE file, unsigned char* buffer, unsigned long start, unsigned long read, CQuadWord inputSize) : CZippedFile(filename, file, buffer, start, read, inputSize), CopyInProgress(FALSE), LastBlock(FALSE), CopyCount(0),
                                                                                                                                        CopyDistance(0), BlockType(0), LiteralTable(NULL), LiteralBits(0), DistanceTable(NULL),
                                                                                                                                        DistanceBits(0), FixedLiteralTable(NULL), FixedLiteralBits(0), FixedDistanceTable(NULL),
-                                                                                                                                       FixedDistanceBits(0), StoredLen(0), BitBuffer(0), BitCount(0), InProgress(FALSE)
+                                                                                                                                       FixedDistanceBits(0), StoredLen(0), BitBuffer(0), BitCount(0), InProgress(FALSE),
+                                                                                                                                       CanParallel(CParallelStream::GetThreadCount() > 1), Parallel(NULL)
 {
     CALL_STACK_MESSAGE2("CGZip::CGZip(%s, , , )", filename);
 
@@ -1121,6 +1151,8 @@ CGZip::~CGZip()
 {
     CALL_STACK_MESSAGE1("CGZip::~CGZip()");
 
+    if (Parallel != NULL)
+        delete Parallel;
     HufTableFree(LiteralTable);
     HufTableFree(DistanceTable);
     HufTableFree(FixedLiteralTable);
@@ -1250,12 +1282,228 @@ BOOL CGZip::CompactBuffer()
 
 BOOL CGZip::DecompressBlock(unsigned short needed)
 {
-    unsigned char* begin = ExtrEnd;
     // fill the output buffer up to its capacity...
-    while ((InProgress || !LastBlock) && ExtrEnd < Window + BUFSIZE)
+    while (ExtrEnd < Window + BUFSIZE)
     {
+        if (Parallel != NULL)
+        {
+            if (!ParallelBlock())
+                return FALSE;
+            continue;
+        }
+        if (!InProgress && LastBlock)
+            break;
         if (!InflateBlock())
             return FALSE;
+        if (SeekIndex != NULL)
+            AddSeekPoint();
     }
     return (ExtrEnd - ExtrStart >= needed);
 }
+
+BOOL CGZip::StartParallel(CQuadWord memberStart)
+{
+    CALL_STACK_MESSAGE1("CGZip::StartParallel()");
+    if (!CanParallel || InputSize.Value < memberStart.Value + PARALLEL_MIN_INPUT)
+        return FALSE;
+    Parallel = new CParallelGZip(File, memberStart.Value * 8, InputSize.Value);
+    if (Parallel != NULL && Parallel->Start())
+        return TRUE;
+    // no threads, stay sequential
+    if (Parallel != NULL)
+        delete Parallel;
+    Parallel = NULL;
+    CanParallel = FALSE;
+    return FALSE;
+}
+
+BOOL CGZip::ParallelBlock()
+{
+    int read = Parallel->Read(ExtrEnd, (int)(Window + BUFSIZE - ExtrEnd));
+    // the position of the member being read is good enough for the progress
+    CQuadWord pos;
+    pos.SetUI64(Parallel->GetPos() / 8);
+    if (pos > StreamPos)
+        StreamPos = pos;
+    if (read > 0)
+    {
+        ExtrEnd += read;
+        OutPos += CQuadWord(read, 0);
+        return TRUE;
+    }
+    if (read == PARALLEL_ERROR)
+    {
+        Ok = FALSE;
+        ErrorCode = Parallel->GetErrorCode();
+        LastError = Parallel->GetLastErr();
+        return FALSE;
+    }
+    delete Parallel;
+    Parallel = NULL;
+    if (read == PARALLEL_END)
+    {
+        LastBlock = TRUE;
+        return TRUE;
+    }
+    // the workers could not handle the next member, decompress it here
+    if (!SeekInput(pos))
+        return FALSE;
+    BitBuffer = 0;
+    BitCount = 0;
+    if (FReadBlock(sizeof(SGZipHeader)) != NULL)
+    {
+        // only peek at the header, Initialize() will mark it as consumed
+        DataStart -= sizeof(SGZipHeader);
+        StreamPos -= CQuadWord(sizeof(SGZipHeader), 0);
+    }
+    LastBlock = !Initialize(ErrorCode);
+    return TRUE;
+}
+
+void CGZip::AddSeekPoint()
+{
+    // only between two deflate blocks, the state is then given by the input position,
+    // a few buffered bits and the last 32 KB of output (zran.c from zlib does the same)
+    if (!Ok || InProgress || LastBlock || !SeekIndex->WantPoint(OutPos))
+        return;
+    CSeekPoint point;
+    point.Out = OutPos;
+    point.In = StreamPos;
+    point.Bits = BitBuffer;
+    point.BitCount = BitCount;
+    point.Crc = crc;
+    point.MemberCnt = TotalCnt;
+    point.BlockSize = 0;
+    SeekIndex->AddPoint(point, Window, (unsigned int)(ExtrEnd - Window) % BUFSIZE);
+}
+
+BOOL CGZip::RestoreSeekPoint(const CSeekPoint* point)
+{
+    CALL_STACK_MESSAGE1("CGZip::RestoreSeekPoint()");
+    if (point->Window == NULL || !SeekInput(point->In))
+        return FALSE;
+
+    if (Parallel != NULL)
+    {
+        delete Parallel;
+        Parallel = NULL;
+    }
+
+    HufTableFree(LiteralTable);
+    LiteralTable = NULL;
+    HufTableFree(DistanceTable);
+    DistanceTable = NULL;
+    InProgress = FALSE;
+    CopyInProgress = FALSE;
+    LastBlock = FALSE;
+    CopyCount = 0;
+    CopyDistance = 0;
+    BitBuffer = point->Bits;
+    BitCount = point->BitCount;
+    crc = point->Crc;
+    TotalCnt = point->MemberCnt;
+    // the window is full and read, the next block continues at its beginning
+    memcpy(Window, point->Window, BUFSIZE);
+    ExtrStart = Window + BUFSIZE;
+    ExtrEnd = Window + BUFSIZE;
+    OutPos = point->Out;
+    return TRUE;
+}
+
+//********************************************************
+//
+//  CParallelGZip
+//
+
+CParallelGZip::CParallelGZip(HANDLE file, unsigned __int64 start, unsigned __int64 end)
+    : CParallelStream(file, start, end)
+{
+    MinChunk = GZIP_MIN_CHUNK;
+    ZLIB = SalamanderGeneral->GetSalamanderZLIB();
+}
+
+BOOL CParallelGZip::IsHeader(const unsigned char* data)
+{
+    // deflate, flags Initialize() accepts, known XFL and OS; the CRC of the data
+    // behind the header is checked when the member is decompressed
+    return data[0] == 0x1F && data[1] == 0x8B && data[2] == METHOD_DEFLATE &&
+           (data[3] & (CONTINUATION | ENCRYPTED | RESERVED)) == 0 &&
+           (data[8] == 0 || data[8] == 2 || data[8] == 4) && (data[9] <= 13 || data[9] == 255);
+}
+
+BOOL CParallelGZip::FindBoundary(const unsigned char* data, unsigned int size, unsigned __int64 dataPos,
+                                 BOOL last, unsigned __int64& from, int& type)
+{
+    // members start at whole bytes
+    unsigned int i = (unsigned int)((from + 7) / 8 - dataPos);
+    for (; i + sizeof(SGZipHeader) <= size; i++)
+    {
+        const unsigned char* found = (const unsigned char*)memchr(data + i, 0x1F, size - sizeof(SGZipHeader) + 1 - i);
+        if (found == NULL)
+        {
+            i = size - sizeof(SGZipHeader) + 1;
+            break;
+        }
+        i = (unsigned int)(found - data);
+        if (IsHeader(found))
+        {
+            type = 0;
+            from = (dataPos + i) * 8;
+            return TRUE;
+        }
+    }
+    // at the end of the file there is no room left for a member
+    unsigned __int64 examined = (dataPos + (last ? size : i)) * 8;
+    if (examined > from)
+        from = examined;
+    return FALSE;
+}
+
+int CParallelGZip::Decompress(CParallelChunk* chunk)
+{
+    // the chunk may contain more members, each of them is a complete gzip stream
+    unsigned int in = 0;
+    while (in < chunk->InSize)
+    {
+        if (chunk->InSize - in < sizeof(SGZipHeader) || !IsHeader(chunk->In + in))
+            return CHUNK_ERROR; // something else than a member, for the sequential decompressor
+
+        CSalZLIB z;
+        memset(&z, 0, sizeof(z));
+        if (ZLIB->InflateInit2(&z, 15 + 16) != SAL_Z_OK) // +16 = gzip header and trailer
+            return CHUNK_ERROR;
+        z.next_in = chunk->In + in;
+        z.avail_in = chunk->InSize - in;
+        int ret = SAL_Z_OK;
+        while (ret == SAL_Z_OK)
+        {
+            if (IsTerminating())
+            {
+                ret = SAL_Z_DATA_ERROR;
+                break;
+            }
+            if (chunk->OutSize == chunk->OutAlloc && !GrowOutput(chunk))
+            {
+                ret = SAL_Z_MEM_ERROR;
+                break;
+            }
+            z.next_out = chunk->Out + chunk->OutSize;
+            z.avail_out = chunk->OutAlloc - chunk->OutSize;
+            ret = ZLIB->Inflate(&z, SAL_Z_NO_FLUSH);
+            chunk->OutSize = (unsigned int)(z.next_out - chunk->Out);
+            if (ret == SAL_Z_BUF_ERROR && z.avail_in > 0)
+                ret = SAL_Z_OK; // no progress without more room for the output
+        }
+        ZLIB->InflateEnd(&z);
+        if (ret != SAL_Z_STREAM_END)
+        {
+            // the member goes on behind the chunk, its end was not a real boundary
+            if (ret == SAL_Z_BUF_ERROR && z.avail_in == 0)
+                return CHUNK_INCOMPLETE;
+            return CHUNK_ERROR;
+        }
+        in = (unsigned int)(z.next_in - chunk->In);
+    }
+    chunk->Next = (chunk->Start / 8 + in) * 8;
+    return CHUNK_OK;
+}
@@ -54,6 +54,7 @@ struct SGzipExtraHeader
 
 // forward declaration
 struct SHufTable;
+class CParallelGZip;
 
 class CGZip : public CZippedFile
 {
@@ -64,6 +65,7 @@ public:
     void Cleanup();
 
     virtual void GetFileInfo(FILETIME& lastWrite, CQuadWord& fileSize, DWORD& fileAttr);
+    virtual BOOL CanIndex() { return TRUE; }
 
 protected:
     CQuadWord TotalCnt; // total number of bytes extracted from archive
@@ -88,6 +90,9 @@ protected:
     unsigned long BitCount;  // bits in bit buffer
     unsigned long crc;
 
+    BOOL CanParallel;        // worker threads may decompress further members
+    CParallelGZip* Parallel; // decompresses the members on worker threads or NULL
+
     // internal, private functions
     BOOL InflateBlock();
     BOOL InflateStoredInit();
@@ -100,6 +105,11 @@ protected:
     int HufTableBuild(unsigned int* b, unsigned int n, unsigned int s,
                       unsigned short* d, unsigned short* e, SHufTable** t, int* m);
 
+    BOOL StartParallel(CQuadWord memberStart);
+    BOOL ParallelBlock();
+
     virtual BOOL CompactBuffer();
     virtual BOOL DecompressBlock(unsigned short needed);
+    virtual void AddSeekPoint();
+    virtual BOOL RestoreSeekPoint(const CSeekPoint* point);
 };
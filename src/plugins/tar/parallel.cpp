@@ -0,0 +1,376 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "precomp.h"
+
+#include "dlldefs.h"
+#include "parallel.h"
+
+#include "tar.rh"
+#include "tar.rh2"
+#include "lang\lang.rh"
+
+//********************************************************
+//
+//  CParallelChunk
+//
+
+CParallelChunk::CParallelChunk()
+{
+    Start = Next = 0;
+    Type = 0;
+    In = Out = NULL;
+    InSize = OutSize = OutAlloc = 0;
+    Crc = 0;
+    Param = 0;
+    Last = FALSE;
+    State = CHUNK_QUEUED;
+}
+
+CParallelChunk::~CParallelChunk()
+{
+    if (In != NULL)
+        free(In);
+    if (Out != NULL)
+        free(Out);
+}
+
+//********************************************************
+//
+//  CParallelStream
+//
+
+CParallelStream::CParallelStream(HANDLE file, unsigned __int64 start, unsigned __int64 end)
+    : MinChunk(0), File(file), End(end), Pos(start), ErrorCode(0), LastError(0), Finished(FALSE),
+      Pending(NULL), PendingSize(0), PendingAlloc(0), PendingPos(start / 8), ScanFrom(start),
+      ChunkStart(start), ChunkType(0), HaveChunk(FALSE), ScanDone(FALSE), Current(NULL), Taken(0),
+      Queue(64, 64), MaxQueue(0), WorkReady(NULL), ChunkDone(NULL), ThreadsCount(0), Terminate(FALSE)
+{
+    InitializeCriticalSection(&CS);
+}
+
+CParallelStream::~CParallelStream()
+{
+    CALL_STACK_MESSAGE1("CParallelStream::~CParallelStream()");
+    Stop();
+    if (WorkReady != NULL)
+        CloseHandle(WorkReady);
+    if (ChunkDone != NULL)
+        CloseHandle(ChunkDone);
+    if (Current != NULL)
+        delete Current;
+    if (Pending != NULL)
+        free(Pending);
+    DeleteCriticalSection(&CS);
+}
+
+void CParallelStream::Stop()
+{
+    if (ThreadsCount > 0)
+    {
+        // workers finish the chunk they are decompressing and leave
+        Terminate = TRUE;
+        ReleaseSemaphore(WorkReady, ThreadsCount, NULL);
+        WaitForMultipleObjects(ThreadsCount, Threads, TRUE, INFINITE);
+        int i;
+        for (i = 0; i < ThreadsCount; i++)
+            CloseHandle(Threads[i]);
+        ThreadsCount = 0;
+    }
+}
+
+int CParallelStream::GetThreadCount()
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return max(1, min(PARALLEL_MAX_THREADS, (int)si.dwNumberOfProcessors));
+}
+
+BOOL CParallelStream::Start()
+{
+    CALL_STACK_MESSAGE1("CParallelStream::Start()");
+    int threads = GetThreadCount();
+    if (threads < 2)
+        return FALSE;
+    WorkReady = CreateSemaphore(NULL, 0, 0x7FFFFFFF, NULL);
+    ChunkDone = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (WorkReady == NULL || ChunkDone == NULL)
+        return FALSE;
+    while (ThreadsCount < threads)
+    {
+        DWORD id;
+        Threads[ThreadsCount] = CreateThread(NULL, 0, WorkerThreadF, this, 0, &id);
+        if (Threads[ThreadsCount] == NULL)
+            break;
+        ThreadsCount++;
+    }
+    // the reading thread only waits for the chunks, so one worker per processor
+    MaxQueue = ThreadsCount * PARALLEL_CHUNKS_PER_THREAD;
+    return ThreadsCount > 1;
+}
+
+unsigned WINAPI CParallelStream::WorkerThreadBody(void* param)
+{
+    ((CParallelStream*)param)->Work();
+    return 0;
+}
+
+DWORD WINAPI CParallelStream::WorkerThreadF(void* param)
+{
+    return SalamanderDebug->CallWithCallStack(WorkerThreadBody, param);
+}
+
+void CParallelStream::Work()
+{
+    CALL_STACK_MESSAGE1("CParallelStream::Work()");
+    while (TRUE)
+    {
+        WaitForSingleObject(WorkReady, INFINITE);
+        if (Terminate)
+            break;
+        // take the first chunk nobody works on
+        CParallelChunk* chunk = NULL;
+        EnterCriticalSection(&CS);
+        int i;
+        for (i = 0; i < Queue.Count; i++)
+        {
+            if (Queue[i]->State == CHUNK_QUEUED)
+            {
+                chunk = Queue[i];
+                chunk->State = CHUNK_WORKING;
+                break;
+            }
+        }
+        LeaveCriticalSection(&CS);
+        if (chunk == NULL) // the reader dropped it meanwhile
+            continue;
+
+        int state = Decompress(chunk);
+        EnterCriticalSection(&CS);
+        chunk->State = state;
+        LeaveCriticalSection(&CS);
+        SetEvent(ChunkDone);
+    }
+}
+
+BOOL CParallelStream::GrowOutput(CParallelChunk* chunk)
+{
+    if (chunk->OutAlloc >= PARALLEL_MAX_OUTPUT)
+        return FALSE;
+    unsigned int size;
+    if (chunk->OutAlloc == 0)
+        size = max(64 * 1024u, min(PARALLEL_MAX_OUTPUT / 4u, chunk->InSize) * 4);
+    else
+        size = min(PARALLEL_MAX_OUTPUT + 0u, chunk->OutAlloc * 2);
+    unsigned char* out = (unsigned char*)realloc(chunk->Out, size);
+    if (out == NULL)
+        return FALSE;
+    chunk->Out = out;
+    chunk->OutAlloc = size;
+    return TRUE;
+}
+
+BOOL CParallelStream::ReadMore()
+{
+    // drop the data that will not be needed any more
+    unsigned __int64 keep = (HaveChunk ? ChunkStart : ScanFrom) / 8;
+    if (keep > PendingPos)
+    {
+        unsigned int drop = (unsigned int)min(keep - PendingPos, (unsigned __int64)PendingSize);
+        memmove(Pending, Pending + drop, PendingSize - drop);
+        PendingSize -= drop;
+        PendingPos += drop;
+    }
+    unsigned __int64 readPos = PendingPos + PendingSize;
+    DWORD size = (DWORD)min((unsigned __int64)PARALLEL_READ_SIZE, End - readPos);
+    if (PendingAlloc - PendingSize < size)
+    {
+        unsigned char* pending = (unsigned char*)realloc(Pending, PendingSize + size);
+        if (pending == NULL)
+        {
+            ErrorCode = IDS_ERR_MEMORY;
+            return FALSE;
+        }
+        Pending = pending;
+        PendingAlloc = PendingSize + size;
+    }
+    LONG high = (LONG)(readPos >> 32);
+    DWORD read;
+    if ((SetFilePointer(File, (LONG)(DWORD)readPos, &high, FILE_BEGIN) == INVALID_SET_FILE_POINTER &&
+         GetLastError() != NO_ERROR) ||
+        !ReadFile(File, Pending + PendingSize, size, &read, NULL))
+    {
+        ErrorCode = IDS_ERR_FREAD;
+        LastError = GetLastError();
+        return FALSE;
+    }
+    if (read < size)
+    {
+        // the file got shorter
+        ErrorCode = IDS_ERR_EOF;
+        return FALSE;
+    }
+    PendingSize += read;
+    return TRUE;
+}
+
+BOOL CParallelStream::AddChunk(unsigned __int64 end)
+{
+    CParallelChunk* chunk = new CParallelChunk;
+    if (chunk == NULL)
+    {
+        ErrorCode = IDS_ERR_MEMORY;
+        return FALSE;
+    }
+    chunk->Start = ChunkStart;
+    chunk->Next = end;
+    chunk->Type = ChunkType;
+    unsigned int from = (unsigned int)(ChunkStart / 8 - PendingPos);
+    chunk->InSize = (unsigned int)((end + 7) / 8 - ChunkStart / 8);
+    chunk->In = (unsigned char*)malloc(chunk->InSize);
+    if (chunk->In == NULL)
+    {
+        delete chunk;
+        ErrorCode = IDS_ERR_MEMORY;
+        return FALSE;
+    }
+    memcpy(chunk->In, Pending + from, chunk->InSize);
+
+    EnterCriticalSection(&CS);
+    Queue.Add(chunk);
+    BOOL ok = Queue.IsGood();
+    if (!ok)
+        Queue.ResetState();
+    LeaveCriticalSection(&CS);
+    if (!ok)
+    {
+        delete chunk;
+        ErrorCode = IDS_ERR_MEMORY;
+        return FALSE;
+    }
+    ReleaseSemaphore(WorkReady, 1, NULL);
+    return TRUE;
+}
+
+BOOL CParallelStream::Fill()
+{
+    while (!ScanDone && Queue.Count < MaxQueue)
+    {
+        unsigned __int64 from = ScanFrom;
+        if (HaveChunk && from < ChunkStart + (unsigned __int64)MinChunk * 8)
+            from = ChunkStart + (unsigned __int64)MinChunk * 8;
+        int type;
+        if (from < (PendingPos + PendingSize) * 8 &&
+            FindBoundary(Pending + (from / 8 - PendingPos), (unsigned int)(PendingPos + PendingSize - from / 8),
+                         from / 8, PendingPos + PendingSize == End, from, type))
+        {
+            // the chunk being cut ends here and the next one begins
+            if (HaveChunk && !AddChunk(from))
+                return FALSE;
+            ChunkStart = from;
+            ChunkType = type;
+            HaveChunk = TRUE;
+            ScanFrom = from + 1;
+            continue;
+        }
+        ScanFrom = max(ScanFrom, from);
+        if (PendingPos + PendingSize == End)
+        {
+            // the last chunk reaches the end of the stream
+            if (HaveChunk && !AddChunk(End * 8))
+                return FALSE;
+            ScanDone = TRUE;
+        }
+        else
+        {
+            if (HaveChunk && (PendingPos + PendingSize) - ChunkStart / 8 >= PARALLEL_MAX_CHUNK)
+            {
+                // no boundary far and wide, the rest is up to the sequential decompressor
+                ScanDone = TRUE;
+            }
+            else
+            {
+                if (!ReadMore())
+                    return FALSE;
+            }
+        }
+    }
+    return TRUE;
+}
+
+void CParallelStream::WaitChunk(CParallelChunk* chunk)
+{
+    while (TRUE)
+    {
+        EnterCriticalSection(&CS);
+        int state = chunk->State;
+        LeaveCriticalSection(&CS);
+        if (state >= CHUNK_OK)
+            break;
+        WaitForSingleObject(ChunkDone, INFINITE);
+    }
+}
+
+int CParallelStream::NextChunk()
+{
+    while (TRUE)
+    {
+        if (!Fill())
+            return PARALLEL_ERROR;
+        if (Queue.Count == 0)
+        {
+            // the stream ends here, unless there is something unknown after the chunks
+            return Pos == End * 8 ? PARALLEL_END : PARALLEL_FALLBACK;
+        }
+        CParallelChunk* chunk = Queue[0];
+        if (chunk->Start < Pos)
+        {
+            // a false boundary inside a chunk that has already been read
+            EnterCriticalSection(&CS);
+            if (chunk->State == CHUNK_QUEUED)
+                chunk->State = CHUNK_ERROR; // no worker takes it now
+            LeaveCriticalSection(&CS);
+            WaitChunk(chunk);
+            EnterCriticalSection(&CS);
+            Queue.Delete(0);
+            LeaveCriticalSection(&CS);
+            continue;
+        }
+        // data between two chunks or a failed chunk, only the sequential decompressor knows
+        if (chunk->Start != Pos)
+            return PARALLEL_FALLBACK;
+        WaitChunk(chunk);
+        if (chunk->State != CHUNK_OK || !Accept(chunk))
+            return PARALLEL_FALLBACK;
+        EnterCriticalSection(&CS);
+        Queue.Detach(0);
+        LeaveCriticalSection(&CS);
+        Current = chunk;
+        Taken = 0;
+        // keep the workers busy while the chunk is being read
+        return Fill() ? 1 : PARALLEL_ERROR;
+    }
+}
+
+int CParallelStream::Read(unsigned char* buffer, int size)
+{
+    while (Current == NULL || Taken == Current->OutSize)
+    {
+        if (Current != NULL)
+        {
+            Finished = Current->Last;
+            Pos = Current->Next;
+            delete Current;
+            Current = NULL;
+        }
+        if (Finished)
+            return PARALLEL_END;
+        int ret = NextChunk();
+        if (ret != 1)
+            return ret;
+    }
+    int count = (int)min((unsigned int)size, Current->OutSize - Taken);
+    memcpy(buffer, Current->Out + Taken, count);
+    Taken += count;
+    return count;
+}
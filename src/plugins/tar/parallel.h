@@ -0,0 +1,143 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#define PARALLEL_MAX_THREADS 16                 // upper limit of worker threads
+#define PARALLEL_CHUNKS_PER_THREAD 3            // chunks decompressed ahead of the reader per worker thread
+#define PARALLEL_READ_SIZE (1024 * 1024)        // the archive is read and scanned in blocks of this size
+#define PARALLEL_MIN_INPUT (2 * 1024 * 1024)    // shorter rest of the stream is not worth the threads
+#define PARALLEL_MAX_CHUNK (64 * 1024 * 1024)   // longer part without a boundary is decompressed sequentially
+#define PARALLEL_MAX_OUTPUT (128 * 1024 * 1024) // chunk expanding over this is decompressed sequentially
+
+// return values of CParallelStream::Read (besides the number of bytes read)
+#define PARALLEL_END 0        // end of the stream
+#define PARALLEL_ERROR -1     // read error, see GetErrorCode()
+#define PARALLEL_FALLBACK -2  // continue sequentially at GetPos()
+
+// states of a chunk
+#define CHUNK_QUEUED 0     // waiting for a worker thread
+#define CHUNK_WORKING 1    // being decompressed
+#define CHUNK_OK 2         // decompressed, Next is where the decompressed data ended
+#define CHUNK_INCOMPLETE 3 // the data ended sooner than the chunk (its end was not a real boundary)
+#define CHUNK_ERROR 4      // the data are not what the boundary promised
+
+// part of a compressed stream between two possible boundaries of its blocks or members
+class CParallelChunk
+{
+public:
+    CParallelChunk();
+    ~CParallelChunk();
+
+    unsigned __int64 Start; // bit position of the chunk in the archive file
+    unsigned __int64 Next;  // bit position where the decompressed part ended
+    int Type;               // kind of the boundary at Start, given by the format
+    unsigned char* In;      // compressed data, from the byte containing bit Start
+    unsigned int InSize;
+    unsigned char* Out; // decompressed data
+    unsigned int OutSize;
+    unsigned int OutAlloc;
+    unsigned long Crc; // format specific results of the decompression
+    int Param;
+    BOOL Last;  // the stream ends with this chunk, the rest of the file is ignored
+    int State;  // CHUNK_XXX; changed only inside CParallelStream::CS
+};
+
+// Decompresses a stream whose parts can be decompressed independently (bzip2 blocks,
+// gzip members) on worker threads. The thread calling Read reads the archive, splits
+// it at possible boundaries of the parts and takes the decompressed chunks in their
+// order. A boundary found in the compressed data may be false; such chunk fails or
+// ends elsewhere than expected, and if it cannot be skipped Read asks the caller to
+// continue with its sequential decompressor.
+class CParallelStream
+{
+public:
+    // 'file' is read from bit 'start' (a boundary) up to byte 'end'; the calling thread
+    // must not use it while the object exists
+    CParallelStream(HANDLE file, unsigned __int64 start, unsigned __int64 end);
+    virtual ~CParallelStream();
+
+    // returns the number of worker threads worth starting (1 = decompress sequentially)
+    static int GetThreadCount();
+
+    // starts the worker threads; returns FALSE if the stream has to be decompressed
+    // sequentially
+    BOOL Start();
+
+    // copies up to 'size' bytes of decompressed data to 'buffer'; returns the number
+    // of bytes copied or PARALLEL_XXX
+    int Read(unsigned char* buffer, int size);
+
+    // bit position of the chunk being read, or where the sequential decompression
+    // continues after PARALLEL_FALLBACK
+    unsigned __int64 GetPos() { return Pos; }
+
+    unsigned int GetErrorCode() { return ErrorCode; }
+    DWORD GetLastErr() { return LastError; }
+
+protected:
+    // looks for the first boundary at bit 'from' or later in 'data' ('size' bytes,
+    // starting at byte 'dataPos' of the file; 'last' = the file ends with them); returns
+    // TRUE with the boundary in 'from' and 'type', otherwise FALSE with the first bit
+    // that was not examined yet in 'from'
+    virtual BOOL FindBoundary(const unsigned char* data, unsigned int size, unsigned __int64 dataPos,
+                              BOOL last, unsigned __int64& from, int& type) = 0;
+    // decompresses 'chunk' to chunk->Out; called on worker threads, returns CHUNK_XXX
+    virtual int Decompress(CParallelChunk* chunk) = 0;
+    // called with the chunks in their order, before their data are read; returns FALSE
+    // if the chunk does not fit and the stream has to continue sequentially
+    virtual BOOL Accept(CParallelChunk* chunk) { return TRUE; }
+
+    // waits for the worker threads to leave; the destructor of a derived class has to
+    // call it, the workers may be in its Decompress
+    void Stop();
+
+    // for Decompress: makes room for more output in chunk->Out
+    BOOL GrowOutput(CParallelChunk* chunk);
+    // for Decompress: returns TRUE if the work should be abandoned
+    BOOL IsTerminating() { return Terminate; }
+
+    unsigned int MinChunk; // boundaries closer than this to the chunk start are ignored (bytes)
+
+private:
+    static unsigned WINAPI WorkerThreadBody(void* param);
+    static DWORD WINAPI WorkerThreadF(void* param);
+    void Work();
+
+    // reads and splits the archive until there are enough chunks queued
+    BOOL Fill();
+    BOOL ReadMore();
+    BOOL AddChunk(unsigned __int64 end);
+    // waits for the first chunk of the queue and makes it Current; returns 1 or PARALLEL_XXX
+    int NextChunk();
+    void WaitChunk(CParallelChunk* chunk);
+
+    HANDLE File;
+    unsigned __int64 End;      // end of the stream in the file (bytes)
+    unsigned __int64 Pos;      // see GetPos()
+    unsigned int ErrorCode;    // IDS_XXX of an error
+    DWORD LastError;           // and the system error code
+    BOOL Finished;             // the stream ended with the last accepted chunk
+
+    unsigned char* Pending;    // data read but not cut to chunks yet
+    unsigned int PendingSize;
+    unsigned int PendingAlloc;
+    unsigned __int64 PendingPos;  // byte position of Pending in the file
+    unsigned __int64 ScanFrom;    // first bit not examined by FindBoundary yet
+    unsigned __int64 ChunkStart;  // bit position of the chunk being cut
+    int ChunkType;
+    BOOL HaveChunk;               // ChunkStart is valid
+    BOOL ScanDone;                // no more chunks will be added
+
+    CParallelChunk* Current; // chunk being read
+    unsigned int Taken;      // bytes of Current->Out already read
+
+    CRITICAL_SECTION CS;                    // guards Queue and CParallelChunk::State
+    TIndirectArray<CParallelChunk> Queue;   // chunks in order of the file
+    int MaxQueue;
+    HANDLE WorkReady; // semaphore, released once for each queued chunk
+    HANDLE ChunkDone; // event, set whenever a worker finishes a chunk
+    HANDLE Threads[PARALLEL_MAX_THREADS];
+    int ThreadsCount;
+    volatile BOOL Terminate;
+};
@@ -27,5 +27,6 @@
 #include "spl_menu.h"
 #include "spl_vers.h"
 #include "spl_file.h"
+#include "spl_zlib.h"
 #include "dbg.h"
 #include "arraylt.h"
\ No newline at end of file
@@ -302,5 +302,6 @@ public:
     virtual const unsigned char* GetBlock(unsigned short size, unsigned short* read = NULL);
     virtual void Rewind(unsigned short size);
     virtual void GetFileInfo(FILETIME& lastWrite, CQuadWord& fileSize, DWORD& fileAttr);
+    virtual BOOL SeekTo(CQuadWord pos, CSeekIndex* index) { return FALSE; }
     // Should other functions be forwarded to Stream?????
 };
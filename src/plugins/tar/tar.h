@@ -287,6 +287,9 @@ private:
     DWORD Silent;
 
     BOOL ListStream(CSalamanderDirectoryAbstract* dir);
+    BOOL ListHeaders(const char* prefix, CSalamanderDirectoryAbstract* dir);
+    BOOL UnpackFromHeader(CQuadWord headerOffset, const char* nameInArchive, const char* targetPath,
+                          const char* newFileName, BOOL& result);
     BOOL UnpackStream(const char* targetPath, BOOL doProgress,
                       const char* nameInArchive, CNames* names, const char* newName);
     BOOL GetStreamHeader(SCommonHeader& header);
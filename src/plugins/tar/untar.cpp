@@ -207,9 +207,30 @@ BOOL CArchive::ListArchive(const char* prefix, CSalamanderDirectoryAbstract* dir
     if (!IsOk())
         return FALSE;
 
+    // while listing a compressed archive collect seek points, UnpackOneFile then
+    // does not have to decompress everything in front of the requested file
+    CSeekIndex* index = Stream->CreateSeekIndex();
+    Stream->SetSeekIndex(index);
+    BOOL ret = ListHeaders(prefix, dir);
+    Stream->SetSeekIndex(NULL);
+    if (index != NULL)
+    {
+        if (ret)
+            SeekIndexCache.Attach(index);
+        else
+            delete index;
+    }
+    return ret;
+}
+
+BOOL CArchive::ListHeaders(const char* prefix, CSalamanderDirectoryAbstract* dir)
+{
+    CALL_STACK_MESSAGE1("CArchive::ListHeaders( )");
+
     // first try to detect the archive and read the first header
     Silent = 0;
     Offset.Set(0, 0);
+    CQuadWord headerOffset(0, 0);
     SCommonHeader header;
     int ret = ReadArchiveHeader(header, TRUE);
 
@@ -249,7 +270,14 @@ BOOL CArchive::ListArchive(const char* prefix, CSalamanderDirectoryAbstract* dir
             // add either a new file or a directory
             if (!header.IsDir)
             {
-                // TODO: also add user data with the file position inside the archive to separate identically named files
+                // remember where the tar header starts (in 512 byte blocks, +1 so that
+                // zero means unknown); UnpackOneFile can jump right to it and it also
+                // separates identically named files
+                if ((header.Format == e_TarPosix || header.Format == e_TarOldGnu || header.Format == e_TarV7) &&
+                    headerOffset.Value % BLOCKSIZE == 0 && headerOffset.Value / BLOCKSIZE < (DWORD_PTR)-1)
+                {
+                    header.FileInfo.PluginData = (DWORD_PTR)(headerOffset.Value / BLOCKSIZE + 1);
+                }
                 // this is a file, add the file
                 if (!dir->AddFile(prefix ? path : header.Path, header.FileInfo, NULL))
                 {
@@ -284,6 +312,7 @@ BOOL CArchive::ListArchive(const char* prefix, CSalamanderDirectoryAbstract* dir
         }
 
         // prepare a new header for the next iteration
+        headerOffset = Offset;
         if (ReadArchiveHeader(header, FALSE) != TAR_OK)
             return FALSE;
 
@@ -301,8 +330,17 @@ BOOL CArchive::UnpackOneFile(const char* nameInArchive, const CFileData* fileDat
     if (!IsOk())
         return FALSE;
 
-    // first try to detect the archive and read the first header
     Silent = 0;
+    // ListArchive remembered where the header of the file is, try to jump right to it
+    BOOL result;
+    if (fileData != NULL && fileData->PluginData != 0 &&
+        UnpackFromHeader(CQuadWord().SetUI64((unsigned __int64)(fileData->PluginData - 1) * BLOCKSIZE),
+                         nameInArchive, targetPath, newFileName, result))
+    {
+        return result;
+    }
+
+    // first try to detect the archive and read the first header
     Offset.Set(0, 0);
     SCommonHeader header;
     int ret = ReadArchiveHeader(header, TRUE);
@@ -350,6 +388,50 @@ BOOL CArchive::UnpackOneFile(const char* nameInArchive, const CFileData* fileDat
     }
 }
 
+// extracts the file whose header starts at 'headerOffset' of the tar data; returns FALSE
+// if it did not work out and the archive has to be searched from its beginning (the stream
+// is there again), otherwise TRUE and the result of the extraction in 'result'
+BOOL CArchive::UnpackFromHeader(CQuadWord headerOffset, const char* nameInArchive, const char* targetPath,
+                                const char* newFileName, BOOL& result)
+{
+    CALL_STACK_MESSAGE3("CArchive::UnpackFromHeader(, %s, %s, , )", nameInArchive, targetPath);
+
+    // a compressed stream needs the index built by ListArchive
+    CSeekIndex* index = Stream->DetachSeekIndex();
+    if (index == NULL && Stream->IsCompressed())
+        return FALSE;
+
+    BOOL done = FALSE;
+    if (Stream->SeekTo(headerOffset, index))
+    {
+        Offset = headerOffset;
+        SCommonHeader header;
+        if (ReadArchiveHeader(header, TRUE) == TAR_OK && !header.Finished &&
+            header.Name != NULL && !strcmp(header.Name, nameInArchive))
+        {
+            int ret = WriteOutData(header, targetPath, newFileName ? newFileName : header.FileInfo.Name,
+                                  header.Ignored, FALSE);
+            result = ret == TAR_OK || ret == TAR_EOF;
+            done = TRUE;
+        }
+    }
+    // the archive is not what it was when listed; return to its beginning
+    if (!done && (!Stream->IsOk() || !Stream->SeekTo(CQuadWord(0, 0), index)))
+    {
+        if (Stream->IsOk())
+            SalamanderGeneral->ShowMessageBox(LoadStr(IDS_TARERR_UNKNOWN), LoadStr(IDS_TARERR_TITLE), MSGBOX_ERROR);
+        else
+            SalamanderGeneral->ShowMessageBox(LoadErr(Stream->GetErrorCode(), Stream->GetLastErr()),
+                                              LoadStr(IDS_TARERR_TITLE), MSGBOX_ERROR);
+        result = FALSE;
+        done = TRUE;
+    }
+    Offset.Set(0, 0);
+    if (index != NULL)
+        SeekIndexCache.Attach(index);
+    return done;
+}
+
 // extraction of selected files
 BOOL CArchive::UnpackArchive(const char* targetPath, const char* archiveRoot,
                              SalEnumSelection next, void* param)
@@ -24,6 +24,7 @@
 #include "common.h"
 #include "add_del.h"
 #include "deflate.h"
+#include "pdeflate.h"
 #include "crypt.h"
 #include "iosfxset.h"
 #include "sfxmake/sfxmake.h"
@@ -1392,6 +1393,8 @@ int CZipPack::PackFiles()
     int ret;
     __UINT64 writePos;
     CDeflate* defObj = new CDeflate();
+    CParallelDeflate* parDefObj = NULL; // large files and several small ones are compressed on more threads
+    int queued = 0;                     // files before this one were considered for compressing ahead
     int errorID = 0;
     char progrTextBuf[MAX_PATH + 32];
     char* progrText;
@@ -1432,8 +1435,38 @@ int CZipPack::PackFiles()
         writePos = ArchiveDataOffs;
     else
         writePos = /*EONewCentrDir.*/ NewCentrDirOffs;
+    if (Config.Level && CParallelDeflate::GetThreadCount() > 1)
+    {
+        parDefObj = new CParallelDeflate();
+        if (parDefObj != NULL && !parDefObj->Start())
+        {
+            delete parDefObj;
+            parDefObj = NULL;
+        }
+    }
+    // files with data descriptors cannot be turned into stored ones by CDeflate, the flag
+    // is set below the same way; a file compressed ahead with another flag is compressed again
+    ush aheadFlag = (Options.Action & PA_MULTIVOL) || Removable ||
+                            (Options.Encrypt && Config.EncryptMethod == EM_ZIP20)
+                        ? GPF_DATADESCR
+                        : 0;
     for (i = 0; i < AddFiles.Count && !errorID && !UserBreak; i++)
     {
+        // small files packed next are read and compressed ahead on the worker threads
+        if (queued < i)
+            queued = i;
+        while (parDefObj != NULL && queued < AddFiles.Count)
+        {
+            CAddInfo* ahead = AddFiles[queued];
+            if ((ahead->Action == AF_ADD || ahead->Action == AF_OVERWRITE) && !ahead->IsDir &&
+                ahead->Size.Value > 0 && ahead->Size.Value < PDEFLATE_MIN_SIZE &&
+                !parDefObj->QueueMember(queued, ahead->Name, (unsigned)ahead->Size.Value, Config.Level, aheadFlag))
+            {
+                break; // no room now, tried again for the next file
+            }
+            queued++;
+        }
+
         next = AddFiles[i];
         if (next->Action != AF_ADD && next->Action != AF_OVERWRITE)
             continue;
@@ -1710,8 +1743,42 @@ int CZipPack::PackFiles()
             {
                 ullg size = 0;
                 int method = next->Method;
-                errorID = defObj->Deflate(&next->InterAttr, &method, Config.Level, &next->Flag,
-                                          &size, WriteOutput, ReadInput, this);
+                CDeflateMember* member = NULL;
+                if (parDefObj != NULL && file.Size < PDEFLATE_MIN_SIZE)
+                {
+                    member = parDefObj->GetMember(i);
+                    if (member != NULL &&
+                        (member->Data.InSize != file.Size || CompareFileTime(&member->LastWrite, &file.LastWrite) != 0 ||
+                         (member->Flag & GPF_DATADESCR) != (next->Flag & GPF_DATADESCR)))
+                    {
+                        // the file changed after the worker read it or it is packed with another flag
+                        parDefObj->ReleaseMember(member);
+                        member = NULL;
+                    }
+                }
+                if (member != NULL)
+                {
+                    // compressed ahead, the same data CDeflate would give here
+                    if (!Salamander->ProgressAddSize(member->Data.InSize, TRUE))
+                        errorID = IDS_USERBREAK;
+                    else
+                    {
+                        Crc = member->Crc;
+                        next->InterAttr = member->Data.Attr;
+                        next->Flag |= member->Flag;
+                        if (member->Method == STORE)
+                            method = CM_STORED;
+                        size = member->Data.OutSize;
+                        errorID = WriteOutput(member->Data.Out, member->Data.OutSize, this);
+                    }
+                    parDefObj->ReleaseMember(member);
+                }
+                else if (parDefObj != NULL && file.Size >= PDEFLATE_MIN_SIZE)
+                    errorID = parDefObj->Deflate(&next->InterAttr, &method, Config.Level, &next->Flag,
+                                                 &size, WriteOutput, ReadInput, this);
+                else
+                    errorID = defObj->Deflate(&next->InterAttr, &method, Config.Level, &next->Flag,
+                                              &size, WriteOutput, ReadInput, this);
                 file.CompSize = size;
                 switch (errorID)
                 {
@@ -1794,6 +1861,8 @@ int CZipPack::PackFiles()
         /*EONewCentrDir.*/ NewCentrDirOffs = writePos;
     free(buffer);
     delete defObj;
+    if (parDefObj != NULL)
+        delete parDefObj;
     return errorID;
 }
 
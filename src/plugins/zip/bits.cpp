@@ -99,6 +99,9 @@ CDeflate::CDeflate()
         configuration_table[i] = _configuration_table[i];
 
     static_dtree[0].Len = 0; //ct_init not called
+
+    Chunked = 0;
+    LastChunk = 1;
 }
 
 #define GPF_ENCRYPTED 0x01
@@ -117,6 +120,8 @@ int CDeflate::Deflate(ush* internAttr, int* compMethod, int compLevel,
         ReadData = readFunc;
         Flag = *flag;
         level = compLevel;
+        Chunked = 0;
+        LastChunk = 1;
         //encrypted = *flag & GPF_ENCRYPTED ? true  : false;
         bi_init();
         ct_init(internAttr, compMethod);
@@ -130,6 +135,39 @@ int CDeflate::Deflate(ush* internAttr, int* compMethod, int compLevel,
     }
 }
 
+int CDeflate::DeflateChunk(ush* internAttr, int compLevel, int last,
+                           FWriteData writeFunc, FReadData readFunc, void* userData)
+{
+    try
+    {
+        int method = DEFLATE;
+        ush flag = 0;
+        UserData = userData;
+        WriteData = writeFunc;
+        ReadData = readFunc;
+        Flag = 0;
+        level = compLevel;
+        Chunked = 1;
+        LastChunk = last;
+        bi_init();
+        ct_init(internAttr, &method);
+        lm_init(level, &flag);
+        deflate();
+        if (!last)
+        {
+            // sync flush: an empty stored block aligns the output to a whole byte
+            // and the next part starts a new block
+            send_bits(STORED_BLOCK << 1, 3);
+            copy_block((char*)window, 0, 1);
+        }
+        return 0;
+    }
+    catch (int errorID)
+    {
+        return errorID;
+    }
+}
+
 void CDeflate::bi_init() /* output zip file, NULL for in-memory compression */
 {
     bi_buf = 0;
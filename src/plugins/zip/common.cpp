@@ -2068,14 +2068,7 @@ int InflateBuffer(char* sour, int sourSize, char* dest, int* destSize)
     decompress.Input = &input;
     decompress.Output = &output;
     decompress.UserData = &data;
-    decompress.fixed_tl64 = (huft*)NULL;
-    decompress.fixed_td64 = (huft*)NULL;
-    decompress.fixed_bl64 = 0;
-    decompress.fixed_bd64 = 0;
-    decompress.fixed_tl32 = (huft*)NULL;
-    decompress.fixed_td32 = (huft*)NULL;
-    decompress.fixed_bl32 = 0;
-    decompress.fixed_bd32 = 0;
+    decompress.InflateTables = NULL;
     decompress.HeapInfo = (void*)HeapCreate(HEAP_NO_SERIALIZE, INITIAL_HEAP_SIZE, MAXIMUM_HEAP_SIZE);
     if (!decompress.HeapInfo)
     {
@@ -19,6 +19,7 @@
 typedef unsigned __int8 uch;   // 8-bit unsigned type
 typedef unsigned __int16 ush;  // 16-bit unsigned type
 typedef unsigned int ulg;      // at least 32-bit type (usually processor register size)
+typedef size_t bitbuf_t;       // bit buffer of inflate (processor register size)
 typedef unsigned __int64 ullg; //
 
 //crypt.c
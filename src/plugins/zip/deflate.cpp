@@ -5,6 +5,7 @@
 #include <crtdbg.h>
 #include <ostream>
 #include <commctrl.h>
+#include <intrin.h>
 
 #ifdef ZIP_DLL
 #include "spl_base.h"
@@ -15,6 +16,38 @@
 //#include "zip.rh2"
 #include "deflate.h"
 
+#if defined(_M_X64) || defined(_M_ARM64)
+typedef unsigned __int64 match_word; /* compared at once by longest_match() */
+#define MATCH_BITSCAN _BitScanForward64
+#else
+typedef unsigned long match_word;
+#define MATCH_BITSCAN _BitScanForward
+#endif
+
+/* ===========================================================================
+ * Return the number of equal bytes at scan and match, at most 256. The strings
+ * are compared a word at a time; the first different byte of two words is given
+ * by the lowest set bit of their xor (the processor is little endian).
+ */
+static inline int compare256(const uch far* scan, const uch far* match)
+{
+    int len = 0;
+    do
+    {
+        match_word s, m;
+        memcpy(&s, scan + len, sizeof(s));
+        memcpy(&m, match + len, sizeof(m));
+        if (s != m)
+        {
+            unsigned long bit;
+            MATCH_BITSCAN(&bit, s ^ m);
+            return len + (int)(bit >> 3);
+        }
+        len += sizeof(match_word);
+    } while (len < MAX_MATCH - 2);
+    return len;
+}
+
 /* ===========================================================================
  * Initialize the "longest match" routines for a new file
  *
@@ -176,7 +209,6 @@ error:
     register ush scan_start = *(ush far*)scan;
     register ush scan_end = *(ush far*)(scan + best_len - 1);
 #else
-    uch far* strend = window + strstart + MAX_MATCH;
     uch scan_end1 = scan[best_len - 1];
     uch scan_end = scan[best_len];
 #endif
@@ -236,32 +268,16 @@ error:
         if (match[best_len] != scan_end ||
             match[best_len - 1] != scan_end1 ||
             *match != *scan ||
-            *++match != scan[1])
+            match[1] != scan[1])
             continue;
 
         /* The check at best_len-1 can be removed because it will be made
          * again later. (This heuristic is not always a win.)
-         * It is not necessary to compare scan[2] and match[2] since they
-         * are always equal when the other bytes match, given that
-         * the hash keys are equal and that HASH_BITS >= 8.
+         * scan[2] and match[2] are compared too, deflate_fast() uses a hash
+         * of four bytes that does not guarantee they are equal. The last
+         * compared byte is at strstart+257.
          */
-        scan += 2, match++;
-
-        /* We check for insufficient lookahead only every 8th comparison;
-         * the 256th check will be made at strstart+258.
-         */
-        do
-        {
-        } while (*++scan == *++match && *++scan == *++match &&
-                 *++scan == *++match && *++scan == *++match &&
-                 *++scan == *++match && *++scan == *++match &&
-                 *++scan == *++match && *++scan == *++match &&
-                 scan < strend);
-
-        Assert(scan <= window + (unsigned)(window_size - 1), "wild scan");
-
-        len = MAX_MATCH - (int)(strend - scan);
-        scan = strend - MAX_MATCH;
+        len = 2 + compare256(scan + 2, match + 2);
 
 #endif /* UNALIGNED_OK */
 
@@ -396,10 +412,10 @@ ullg CDeflate::deflate_fast()
     prev_length = MIN_MATCH - 1;
     while (lookahead != 0)
     {
-        /* Insert the string window[strstart .. strstart+2] in the
+        /* Insert the string window[strstart .. strstart+3] in the
          * dictionary, and set hash_head to the head of the hash chain:
          */
-        INSERT_STRING(strstart, hash_head);
+        INSERT_STRING4(strstart, hash_head);
 
         /* Find the longest match, discarding those <= prev_length.
          * At this point we have always match_length < MIN_MATCH
@@ -434,7 +450,7 @@ ullg CDeflate::deflate_fast()
                 do
                 {
                     strstart++;
-                    INSERT_STRING(strstart, hash_head);
+                    INSERT_STRING4(strstart, hash_head);
                     /* strstart never exceeds WSIZE-MAX_MATCH, so there are
                      * always MIN_MATCH bytes ahead. If lookahead < MIN_MATCH
                      * these bytes are garbage, but it does not matter since
@@ -445,13 +461,9 @@ ullg CDeflate::deflate_fast()
             }
             else
             {
+                /* the hash of four bytes needs no update */
                 strstart += match_length;
                 match_length = 0;
-                ins_h = window[strstart];
-                UPDATE_HASH(ins_h, window[strstart + 1]);
-#if MIN_MATCH != 3
-                Call UPDATE_HASH() MIN_MATCH - 3 more times
-#endif
             }
         }
         else
@@ -473,7 +485,7 @@ ullg CDeflate::deflate_fast()
         if (lookahead < MIN_LOOKAHEAD)
             fill_window();
     }
-    return FLUSH_BLOCK(1); /* eof */
+    return FLUSH_BLOCK(LastChunk); /* eof */
 }
 
 /* ===========================================================================
@@ -602,5 +614,5 @@ ullg CDeflate::deflate()
     if (match_available)
         ct_tally(0, window[strstart - 1]);
 
-    return FLUSH_BLOCK(1); /* eof */
+    return FLUSH_BLOCK(LastChunk); /* eof */
 }
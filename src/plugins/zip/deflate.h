@@ -348,6 +348,24 @@ typedef struct config
      prev[(s) & WMASK] = match_head = head[ins_h], \
      head[ins_h] = (s))
 
+/* ===========================================================================
+ * The same for the fast compression levels (deflate_fast), with a hash of the
+ * next four bytes computed at once: it spreads the strings better than the
+ * rolling hash of three bytes and needs no update when strings are skipped.
+ * Matches of three bytes are rarely found, which costs little at these levels.
+ * IN  assertion: the four bytes at s are in the window (the bytes after the
+ *    end of the input file are garbage, like for INSERT_STRING).
+ */
+#define HASH4(s) \
+    ((unsigned)(((unsigned)window[s] | ((unsigned)window[(s) + 1] << 8) | \
+                 ((unsigned)window[(s) + 2] << 16) | ((unsigned)window[(s) + 3] << 24)) * \
+                2654435761U) >> (32 - HASH_BITS))
+
+#define INSERT_STRING4(s, match_head) \
+    (ins_h = HASH4(s), \
+     prev[(s) & WMASK] = match_head = head[ins_h], \
+     head[ins_h] = (s))
+
 /* ===========================================================================
  * Flush the current block, with given end-of-file flag.
  * IN assertion: strstart is set to the end of the current match.
@@ -500,10 +518,11 @@ class CDeflate
      * the local header can be re-rewritten. This function always returns
      * true for in-memory compression.
      * IN assertion: the local header has already been written (ftell() > 0).
+     * A chunk of a file compressed in parts cannot become a stored file.
      */
     int seekable()
     {
-        return 1;
+        return !Chunked;
     }
 
     //********** TREES ***********
@@ -983,6 +1002,8 @@ class CDeflate
     FReadData ReadData;
     //bool        encrypted;
     ush Flag;
+    int Chunked;   /* only a part of the file is compressed, see DeflateChunk() */
+    int LastChunk; /* the part ends the file, its last block is marked final */
 
 public:
     CDeflate();
@@ -996,4 +1017,11 @@ public:
     int Deflate(ush* internAttr, int* compMethod, int compLevel,
                 ush* flag, ullg* compLen, FWriteData writeFunc,
                 FReadData readFunc, void* userData);
+
+    // Compresses one part of a file (see CParallelDeflate). The output ends byte
+    // aligned with an empty stored block unless 'last' is set, so the outputs of
+    // consecutive parts form a single deflate stream; 'internAttr' is updated from
+    // the part's data only. Returns an error code like Deflate().
+    int DeflateChunk(ush* internAttr, int compLevel, int last,
+                     FWriteData writeFunc, FReadData readFunc, void* userData);
 };
@@ -152,10 +152,7 @@ int CZipUnpack::UnpackOneFile(const char* nameInZip, const CFileData* fileData,
                 targetDir[targetDirLen - 1] = 0;
                 targetDirLen--;
             }
-            fixed_tl64 = NULL;
-            fixed_td64 = NULL;
-            fixed_tl32 = NULL;
-            fixed_td32 = NULL;
+            InflateTables = NULL;
             SkipAllIOErrors = 0;
             SkipAllLongNames = 0;
             SkipAllEncrypted = 0;
@@ -600,14 +597,7 @@ int CZipUnpack::InflateFile(CFileInfo* fileInfo, BOOL deflate64, int* errorID)
     decompress.Output = &output;
     decompress.UserData = this;
     decompress.HeapInfo = (void*)Heap;
-    decompress.fixed_tl64 = (huft*)fixed_tl64;
-    decompress.fixed_td64 = (huft*)fixed_td64;
-    decompress.fixed_bl64 = fixed_bl64;
-    decompress.fixed_bd64 = fixed_bd64;
-    decompress.fixed_tl32 = (huft*)fixed_tl32;
-    decompress.fixed_td32 = (huft*)fixed_td32;
-    decompress.fixed_bl32 = fixed_bl32;
-    decompress.fixed_bd32 = fixed_bd32;
+    decompress.InflateTables = (CInflateTables*)InflateTables;
     switch (Inflate(&decompress, deflate64))
     {
     case 1:;
@@ -669,14 +659,7 @@ int CZipUnpack::InflateFile(CFileInfo* fileInfo, BOOL deflate64, int* errorID)
         }
     }
     }
-    fixed_tl64 = decompress.fixed_tl64;
-    fixed_td64 = decompress.fixed_td64;
-    fixed_bl64 = decompress.fixed_bl64;
-    fixed_bd64 = decompress.fixed_bd64;
-    fixed_tl32 = decompress.fixed_tl32;
-    fixed_td32 = decompress.fixed_td32;
-    fixed_bl32 = decompress.fixed_bl32;
-    fixed_bd32 = decompress.fixed_bd32;
+    InflateTables = decompress.InflateTables;
     return exitCode;
 }
 
@@ -686,11 +669,9 @@ void CZipUnpack::InflateFreeFixedHufman()
     CDecompressionObject decompress;
 
     decompress.HeapInfo = (void*)Heap;
-    decompress.fixed_tl64 = (huft*)fixed_tl64;
-    decompress.fixed_td64 = (huft*)fixed_td64;
-    decompress.fixed_tl32 = (huft*)fixed_tl32;
-    decompress.fixed_td32 = (huft*)fixed_td32;
+    decompress.InflateTables = (CInflateTables*)InflateTables;
     FreeFixedHufman(&decompress);
+    InflateTables = NULL;
 }
 
 int CZipUnpack::UnStoreFile(CFileInfo* fileInfo, int* errorID)
@@ -1701,10 +1682,7 @@ int CZipUnpack::ExtractFiles(const char* targetDir)
         sour = LoadStr(Test ? IDS_TESTING : IDS_EXTRACTING);
         while (*sour)
             *progrText++ = *sour++;
-        fixed_tl64 = NULL; //for
-        fixed_td64 = NULL;
-        fixed_tl32 = NULL; //for
-        fixed_td32 = NULL;
+        InflateTables = NULL; //for
         DialogFlags = 0;
         SkipAllIOErrors = 0;
         SkipAllLongNames = 0;
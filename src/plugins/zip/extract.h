@@ -44,15 +44,8 @@ public:
     bool TestAllocateWholeFile;
 
     //inflate specifics
-    //fixed hufman trees
-    void* fixed_tl64; // !! must be NULL initialized
-    void* fixed_td64; //before calling inflate
-    int fixed_bl64,
-        fixed_bd64;
-    void* fixed_tl32; // !! must be NULL initialized
-    void* fixed_td32; //before calling inflate
-    int fixed_bl32,
-        fixed_bd32;
+    //decoding tables with the fixed hufman codes
+    void* InflateTables; // !! must be NULL initialized before calling inflate
 
     //file testing
     bool Test;
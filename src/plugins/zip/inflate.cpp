@@ -15,6 +15,7 @@
 
 /* inflate.c -- modified by Lucas Cerman 
    version 1.0b, August 1999
+   version 2.0: table driven decoder with a register-wide bit buffer
    
    based on file inflate.c distributed with infozip,
    writen by  Mark Adler
@@ -60,7 +61,7 @@
    The Huffman codes themselves are decoded using a multi-level table
    lookup, in order to maximize the speed of decoding plus the speed of
    building the decoding tables.  See the comments below that precede the
-   lbits and dbits tuning parameters.
+   LITLEN_TABLEBITS and DIST_TABLEBITS tuning parameters.
 
  */
 
@@ -143,34 +144,16 @@
            5  error in flush
 */
 
-/* marker for "unused" huft code, and corresponding check macro */
+/* marker for "unused" code in the tables from PKZIP's appnote.txt */
 #define INVALID_CODE 99
 #define IS_INVALID_CODE(c) ((c) == INVALID_CODE)
 
-int inflate_codes(CDecompressionObject* decompress,
-                  struct huft* tl, struct huft* td,
-                  int bl, int bd);
-static int inflate_stored(CDecompressionObject* decompress);
-static int inflate_fixed(CDecompressionObject* decompress);
-static int inflate_dynamic(CDecompressionObject* decompress);
-static int inflate_block(CDecompressionObject* decompress, int* e);
-int huft_free(CDecompressionObject* decompress, struct huft* t);
-
-int huft_build(CDecompressionObject* decompress,
-               const unsigned* b, /* code lengths in bits (all assumed <= BMAX) */
-               unsigned n,        /* number of codes (assumed <= N_MAX) */
-               unsigned s,        /* number of simple-valued codes (0..s-1) */
-               const ush* d,      /* list of base values for non-simple codes */
-               const uch* e,      /* list of extra bits for non-simple codes */
-               struct huft** t,   /* result: starting table */
-               int* m);
-
 /* The inflate algorithm uses a sliding 32K byte window on the uncompressed
    stream to find repeated byte strings.  This is implemented here as a
    circular buffer.  The index is updated simply by incrementing and then
    and'ing with 0x7fff (32K-1) (window size - 1). */
 // sliding window is defined in CDecompressionObject and could be
-// any size greater or equal 32K
+// any size greater or equal 32K (power of two)
 
 /* Tables for deflate from PKZIP's appnote.txt. */
 /* Order of the bit length code lengths */
@@ -226,301 +209,648 @@ static const uch cpdext32[] = {
 #define MAXDISTS 30
 #endif
 
+#define MAX_CODE_LEN 15 /* maximum bit length of any code in deflate */
+#define N_MAX 288       /* maximum number of codes in any set */
+
 /* And'ing with mask_bits[n] masks the lower n bits */
 const ush mask_bits[] = {
     0x0000,
     0x0001, 0x0003, 0x0007, 0x000f, 0x001f, 0x003f, 0x007f, 0x00ff,
     0x01ff, 0x03ff, 0x07ff, 0x0fff, 0x1fff, 0x3fff, 0x7fff, 0xffff};
 
+/*
+   Huffman code decoding is performed using a two-level table lookup.
+   The main table is indexed by the next TABLEBITS bits of the input and
+   decodes all codes of at most TABLEBITS bits in one step.  Longer codes
+   continue in subtables placed behind the main table, the main table
+   entry tells where the subtable starts and how many more bits index it.
+
+   Every table entry is a DWORD holding everything needed to decode the
+   symbol, so that the decoder does not have to look into other tables:
+     bits 0-7   number of bits consumed by the entry (code bits in this
+                table level + extra bits of length/distance); for a
+                subtable link the number of bits indexing the subtable
+     bits 8-11  number of code bits in this table level (for an invalid
+                code the number of bits needed to recognize it)
+     bits 12-15 HUFFDEC_xxx flags (0 = length or distance base)
+     bits 16-31 literal, length base, distance base, precode symbol or
+                subtable offset
+
+   The literal/length table codes 286 possible values, or in a flat code,
+   a little over eight bits; ten bits decode nearly all codes found in
+   practice in one step.  The distance table codes 30 possible values, or
+   a little less than five bits, flat, eight bits are plenty.
+ */
+
+#define LITLEN_TABLEBITS 10
+#define DIST_TABLEBITS 8
+#define PRECODE_TABLEBITS 7
+
+// size of the literal/length table (main table + subtables); complete codes (incomplete ones
+// are refused) need at most 1334 entries (computed by "enough 288 10 15" from zlib)
+#define LITLEN_ENOUGH 1334
+// size of the distance table; incomplete distance codes are accepted (PKZIP_BUG_WORKAROUND),
+// so the worst case is a subtable of 2^(15-DIST_TABLEBITS) entries for every code
+#define DIST_ENOUGH ((1 << DIST_TABLEBITS) + MAXDISTS * (1 << (MAX_CODE_LEN - DIST_TABLEBITS)))
+
+#define HUFFDEC_LITERAL 0x1000
+#define HUFFDEC_EOB 0x2000
+#define HUFFDEC_SUBTABLE 0x4000
+#define HUFFDEC_INVALID 0x8000
+
+#define ENTRY_BITS(entry) ((entry)&0xFF)
+#define ENTRY_CODELEN(entry) (((entry) >> 8) & 0xF)
+#define ENTRY_VALUE(entry) ((entry) >> 16)
+
+// decoding tables; allocated by the first Inflate() call and kept in the decompression object
+// until FreeFixedHufman() (the fixed tables are built once for all entries of the archive)
+struct CInflateTables
+{
+    DWORD LitLen[LITLEN_ENOUGH];
+    DWORD Dist[DIST_ENOUGH];
+    DWORD Precode[1 << PRECODE_TABLEBITS];
+
+    BOOL FixedReady[2]; // [deflate64]: TRUE = FixedLitLen and FixedDist are built
+    DWORD FixedLitLen[2][1 << LITLEN_TABLEBITS];
+    DWORD FixedDist[2][1 << DIST_TABLEBITS];
+};
+
 /* Macros for inflate() bit peeking and grabbing.
    The usage is:
 
+        REFILLBITS()
         NEEDBITS(j)
-        x = b & mask_bits[j];
+        x = BITS(j);
         DUMPBITS(j)
 
-   where NEEDBITS makes sure that b has at least j bits in it, and
-   DUMPBITS removes the bits from b.  The macros use the variable k
-   for the number of bits in b.  Normally, b and k are register
-   variables for speed and are initialized at the begining of a
-   routine that uses these macros from a global bit buffer and count.
-
-   In order to not ask for more bits than there are in the compressed
-   stream, the Huffman tables are constructed to only ask for just
-   enough bits to make up the end-of-block code (value 256).  Then no
-   bytes need to be "returned" to the buffer at the end of the last
-   block.  See the huft_build() routine.
+   where REFILLBITS fills the bit buffer b from the input buffer, so that
+   it contains at least BITBUF_NBITS - 8 bits if there are enough bytes
+   left in the input buffer (it never asks the input manager to refill the
+   buffer), NEEDBITS makes sure that b has at least j bits in it (it gets
+   them one byte after another, refilling the input buffer if needed) and
+   DUMPBITS removes the bits from b.  The macros use the variable k for
+   the number of bits in b, in for the next input byte and left for the
+   number of bytes left in the input buffer.  They are local variables
+   initialized by LOADBITS() from the decompression object and stored back
+   by SAVEBITS().
+
+   While at least sizeof(bitbuf_t) bytes are left in the input buffer, b
+   is refilled by one unaligned read; the bits above k are then not zero,
+   but they are the next bits of the input, so the following refill ORs
+   the same values into them.  Codes are looked up in the tables first and
+   only if the found entry is longer than the number of bits in b, more
+   bytes are requested; this way no more input is read than is needed to
+   decode the stream (the input ends right behind the compressed data).
  */
 
-//this function should replace NEXTBYTE macro
-#ifdef _DEBUG
-uch NextByte(CDecompressionObject* decompress)
-{
-    if (decompress->Input->BytesLeft)
-    {
-        decompress->Input->BytesLeft--;
-        return *decompress->Input->NextByte++;
+#define BITBUF_NBITS (8 * (unsigned)sizeof(bitbuf_t))
+
+#define LOADBITS() \
+    { \
+        b = decompress->Input->BitBuf; \
+        k = decompress->Input->BitCount; \
+        in = decompress->Input->NextByte; \
+        left = decompress->Input->BytesLeft; \
     }
-    else
-    {
-        decompress->Input->Refill(decompress);
-        decompress->Input->BytesLeft--;
-        return *decompress->Input->NextByte++;
+
+#define SAVEBITS() \
+    { \
+        decompress->Input->BitBuf = b; \
+        decompress->Input->BitCount = k; \
+        decompress->Input->NextByte = in; \
+        decompress->Input->BytesLeft = left; \
+    }
+
+#define REFILLBITS() \
+    { \
+        if (left >= sizeof(bitbuf_t)) \
+        { \
+            b |= *(UNALIGNED const bitbuf_t*)in << k; \
+            in += (BITBUF_NBITS - 1 - k) >> 3; \
+            left -= (BITBUF_NBITS - 1 - k) >> 3; \
+            k |= BITBUF_NBITS - 8; \
+        } \
+        else \
+        { \
+            while (k < BITBUF_NBITS - 8 && left) \
+            { \
+                b |= (bitbuf_t)*in++ << k; \
+                left--; \
+                k += 8; \
+            } \
+        } \
     }
-}
-#endif
 
 #ifndef CHECK_INPUT_ERROR
-#define NEEDBITS(n, decomp) \
+#define PULLBYTE() \
     { \
-        while (k < (n)) \
+        if (!left) \
         { \
-            b |= ((ulg)NextByte((decomp))) << k; \
-            k += 8; \
+            decompress->Input->NextByte = in; \
+            decompress->Input->BytesLeft = 0; \
+            decompress->Input->Refill(decompress); \
+            in = decompress->Input->NextByte; \
+            left = decompress->Input->BytesLeft; \
         } \
+        b |= (bitbuf_t)*in++ << k; \
+        left--; \
+        k += 8; \
     }
 #else
-#define NEEDBITS(n, decomp) \
+#define PULLBYTE() \
     { \
-        while (k < (n)) \
+        if (!left) \
         { \
-            b |= ((ulg)NextByte((decomp))) << k; \
-            k += 8; \
-            if ((decomp)->Input->Error) \
+            decompress->Input->NextByte = in; \
+            decompress->Input->BytesLeft = 0; \
+            decompress->Input->Refill(decompress); \
+            if (decompress->Input->Error) \
             { \
-                TRACE_I("NEEDBITS input error"); \
+                TRACE_I("PULLBYTE input error"); \
                 return 4; \
             } \
+            in = decompress->Input->NextByte; \
+            left = decompress->Input->BytesLeft; \
         } \
+        b |= (bitbuf_t)*in++ << k; \
+        left--; \
+        k += 8; \
     }
 #endif
 
+#define NEEDBITS(n) \
+    { \
+        while (k < (n)) \
+            PULLBYTE() \
+    }
+
+#define BITS(n) ((unsigned)b & ((1u << (n)) - 1))
+
 #define DUMPBITS(n) \
     { \
         b >>= (n); \
         k -= (n); \
     }
 
-/*
-   Huffman code decoding is performed using a multi-level table lookup.
-   The fastest way to decode is to simply build a lookup table whose
-   size is determined by the longest code.  However, the time it takes
-   to build this table can also be a factor if the data being decoded
-   are not very long.  The most common codes are necessarily the
-   shortest codes, so those codes dominate the decoding time, and hence
-   the speed.  The idea is you can have a shorter table that decodes the
-   shorter, more probable codes, and then point to subsidiary tables for
-   the longer codes.  The time it costs to decode the longer codes is
-   then traded against the time it takes to make longer tables.
-
-   This results of this trade are in the variables lbits and dbits
-   below.  lbits is the number of bits the first level table for literal/
-   length codes can decode in one step, and dbits is the same thing for
-   the distance codes.  Subsequent tables are also less than or equal to
-   those sizes.  These values may be adjusted either when all of the
-   codes are shorter than that, in which case the longest code length in
-   bits is used, or when the shortest code is *longer* than the requested
-   table size, in which case the length of the shortest code in bits is
-   used.
-
-   There are two different values for the two tables, since they code a
-   different number of possibilities each.  The literal/length table
-   codes 286 possible values, or in a flat code, a little over eight
-   bits.  The distance table codes 30 possible values, or a little less
-   than five bits, flat.  The optimum values for speed end up being
-   about one bit more than those, so lbits is 8+1 and dbits is 5+1.
-   The optimum values may differ though from machine to machine, and
-   possibly even between compilers.  Your mileage may vary.
- */
+// looks up the entry of the next code in the main table 'table' of 'tableBits' bits
+#define DECODE(entry, table, tableBits) \
+    { \
+        entry = (table)[BITS(tableBits)]; \
+        while (ENTRY_CODELEN(entry) > k) \
+        { \
+            PULLBYTE() \
+            entry = (table)[BITS(tableBits)]; \
+        } \
+    }
 
-static const int lbits = 9; /* bits in base literal/length lookup table */
-static const int dbits = 6; /* bits in base distance lookup table */
+// continues the decoding of a long code by the subtable the link 'entry' points to
+#define DECODESUB(entry, table) \
+    { \
+        DUMPBITS(ENTRY_CODELEN(entry)) \
+        const DWORD* sub = (table) + ENTRY_VALUE(entry); \
+        unsigned subBits = ENTRY_BITS(entry); \
+        entry = sub[BITS(subBits)]; \
+        while (ENTRY_CODELEN(entry) > k) \
+        { \
+            PULLBYTE() \
+            entry = sub[BITS(subBits)]; \
+        } \
+    }
+
+//this function should replace NEXTBYTE macro
+#ifdef _DEBUG
+uch NextByte(CDecompressionObject* decompress)
+{
+    if (decompress->Input->BytesLeft)
+    {
+        decompress->Input->BytesLeft--;
+        return *decompress->Input->NextByte++;
+    }
+    else
+    {
+        decompress->Input->Refill(decompress);
+        decompress->Input->BytesLeft--;
+        return *decompress->Input->NextByte++;
+    }
+}
+#endif
+
+// returns 'len' lowest bits of 'code' in reversed order
+static unsigned ReverseBits(unsigned code, unsigned len)
+{
+    unsigned rev = 0;
+    while (len--)
+    {
+        rev = (rev << 1) | (code & 1);
+        code >>= 1;
+    }
+    return rev;
+}
+
+// table entries of the symbols (without the numbers of bits, added by BuildDecodeTable())
+static DWORD GetLitLenEntry(unsigned sym, const ush* lens, const uch* ext)
+{
+    if (sym < 256)
+        return HUFFDEC_LITERAL | (sym << 16);
+    if (sym == 256)
+        return HUFFDEC_EOB;
+    if (IS_INVALID_CODE(ext[sym - 257]))
+        return HUFFDEC_INVALID;
+    return ((DWORD)lens[sym - 257] << 16) | ext[sym - 257];
+}
+
+static DWORD GetLitLenEntry32(unsigned sym)
+{
+    return GetLitLenEntry(sym, cplens32, cplext32);
+}
+
+static DWORD GetLitLenEntry64(unsigned sym)
+{
+    return GetLitLenEntry(sym, cplens64, cplext64);
+}
+
+static DWORD GetDistEntry32(unsigned sym)
+{
+#ifndef PKZIP_BUG_WORKAROUND
+    if (sym >= _countof(cpdext32))
+        return HUFFDEC_INVALID;
+#endif
+    if (IS_INVALID_CODE(cpdext32[sym]))
+        return HUFFDEC_INVALID;
+    return ((DWORD)cpdist[sym] << 16) | cpdext32[sym];
+}
+
+static DWORD GetDistEntry64(unsigned sym)
+{
+    return ((DWORD)cpdist[sym] << 16) | cpdext64[sym];
+}
+
+static DWORD GetPrecodeEntry(unsigned sym)
+{
+    return sym << 16;
+}
+
+/* Given a list of code lengths 'lens' of 'n' codes, make a table 'table'
+   ('tableSize' entries) with a main table of 'tableBits' bits to decode
+   that set of codes.  Return zero on success, one if the given code set
+   is incomplete (the table is still built in this case, unused codes
+   decode as HUFFDEC_INVALID), two if the input is invalid (oversubscribed
+   set of lengths or too many subtables).  The length of the longest code
+   is returned in 'maxLen' (zero if all lengths are zero). */
+static int BuildDecodeTable(DWORD* table, unsigned tableSize, unsigned tableBits,
+                            const uch* lens, unsigned n, DWORD (*getEntry)(unsigned),
+                            unsigned* maxLen)
+{
+    unsigned count[MAX_CODE_LEN + 1]; /* bit length count table */
+    unsigned offs[MAX_CODE_LEN + 2];  /* offsets of the lengths in 'sorted' */
+    ush sorted[N_MAX];                /* symbols sorted by code length */
+    ush codes[N_MAX];                 /* bit-reversed codes of symbols in 'sorted' */
+    unsigned i, j, len;
+
+    /* Generate counts for each bit length */
+    memset(count, 0, sizeof(count));
+    for (i = 0; i < n; i++)
+        count[lens[i]]++;
+    count[0] = 0;
+    *maxLen = 0;
+    for (len = MAX_CODE_LEN; len > 0; len--)
+    {
+        if (count[len] != 0)
+        {
+            *maxLen = len;
+            break;
+        }
+    }
+
+    /* Check that the lengths describe a prefix code */
+    int left = 1; /* number of unused codes */
+    for (len = 1; len <= MAX_CODE_LEN; len++)
+    {
+        left <<= 1;
+        left -= count[len];
+        if (left < 0)
+        {
+            TRACE_E("BuildDecodeTable: bad input: more codes than bits");
+            return 2;
+        }
+    }
+    BOOL incomplete = left > 0;
+
+    /* Sort symbols by code length (and by value for equal lengths) and assign
+       the canonical codes; deflate sends codes from the most significant bit,
+       the tables are indexed by bits in the order they come from input */
+    offs[1] = 0;
+    for (len = 1; len <= MAX_CODE_LEN; len++)
+        offs[len + 1] = offs[len] + count[len];
+    unsigned numCodes = offs[MAX_CODE_LEN + 1];
+    for (i = 0; i < n; i++)
+    {
+        if (lens[i] != 0)
+            sorted[offs[lens[i]]++] = (ush)i;
+    }
+    unsigned code = 0;
+    j = 0;
+    for (len = 1; len <= MAX_CODE_LEN; len++)
+    {
+        for (i = 0; i < count[len]; i++)
+            codes[j++] = (ush)ReverseBits(code++, len);
+        code <<= 1;
+    }
+
+    /* Fill the main table and the subtables; an unused code is recognized
+       by its first min(maxLen, tableBits) bits in the main table */
+    unsigned mainSize = 1 << tableBits;
+    if (incomplete)
+    {
+        DWORD invalid = HUFFDEC_INVALID | ((*maxLen < tableBits ? *maxLen : tableBits) << 8);
+        for (i = 0; i < mainSize; i++)
+            table[i] = invalid;
+    }
+    unsigned next = mainSize;   /* first free entry behind the main table */
+    unsigned prefix = mainSize; /* main table index of the current subtable (none yet) */
+    unsigned subOffset = 0;
+    unsigned subBits = 0;
+    for (j = 0; j < numCodes; j++)
+    {
+        len = lens[sorted[j]];
+        DWORD entry = getEntry(sorted[j]);
+        if (len <= tableBits)
+        {
+            entry += len | (len << 8);
+            for (i = codes[j]; i < mainSize; i += 1 << len)
+                table[i] = entry;
+        }
+        else
+        {
+            if ((codes[j] & (mainSize - 1)) != prefix)
+            {
+                /* codes with the same first tableBits bits follow each other (and are sorted
+                   by length), the subtable must decode the longest of them */
+                prefix = codes[j] & (mainSize - 1);
+                unsigned last = j;
+                while (last + 1 < numCodes && (codes[last + 1] & (mainSize - 1)) == prefix)
+                    last++;
+                subBits = lens[sorted[last]] - tableBits;
+                if (next + (1 << subBits) > tableSize)
+                {
+                    TRACE_E("BuildDecodeTable: bad input: too many subtables");
+                    return 2;
+                }
+                subOffset = next;
+                next += 1 << subBits;
+                table[prefix] = HUFFDEC_SUBTABLE | (subOffset << 16) | (tableBits << 8) | subBits;
+                if (incomplete)
+                {
+                    for (i = 0; i < (1u << subBits); i++)
+                        table[subOffset + i] = HUFFDEC_INVALID | (subBits << 8);
+                }
+            }
+            unsigned subLen = len - tableBits;
+            entry += subLen | (subLen << 8);
+            for (i = codes[j] >> tableBits; i < (1u << subBits); i += 1 << subLen)
+                table[subOffset + i] = entry;
+        }
+    }
+    return incomplete ? 1 : 0;
+}
 
-#ifndef ASM_INFLATECODES
+#define FLUSHWINDOW() \
+    { \
+        if (decompress->Output->Flush(w, decompress)) \
+        { \
+            TRACE_I("inflate_codes: flush returned error"); \
+            return 5; \
+        } \
+        w = 0; \
+    }
 
 /* inflate (decompress) the codes in a deflated (compressed) block.
    Return an error code or zero if it all goes ok. */
-int inflate_codes(CDecompressionObject* decompress,
-                  struct huft* tl, //literal/length
-                  struct huft* td, //distance decoder tables
-                  int bl, int bd)  //number of bits decoded by tl[] and td[]
+static int inflate_codes(CDecompressionObject* decompress,
+                         const DWORD* tl, //literal/length
+                         const DWORD* td) //distance decoder tables
 {
-    unsigned e;      /* table entry flag/number of extra bits */
-    unsigned n, d;   /* length and index for copy */
-    unsigned w;      /* current window position */
-    struct huft* t;  /* pointer to table entry */
-    unsigned ml, md; /* masks for bl and bd bits */
-    ulg b;           /* bit buffer */
-    unsigned k;      /* number of bits in bit buffer */
-
+    bitbuf_t b;     /* bit buffer */
+    unsigned k;     /* number of bits in bit buffer */
+    uch* in;        /* next input byte */
+    unsigned left;  /* number of bytes left in the input buffer */
+    DWORD entry;    /* table entry */
+    unsigned n, d;  /* length and distance for copy */
+    unsigned e;     /* number of bytes to copy in one step */
+    unsigned w;     /* current window position */
     uch* redirSlide;
     unsigned wsize;
 
     /* make local copies of globals */
-    b = decompress->Input->BitBuf; /* initialize bit buffer */
-    k = decompress->Input->BitCount;
+    LOADBITS()
     w = decompress->Output->WinPos; /* initialize window position */
     wsize = decompress->Output->WinSize;
     redirSlide = decompress->Output->SlideWin;
 
     /* inflate the coded data */
-    ml = mask_bits[bl]; /* precompute masks for speed */
-    md = mask_bits[bd];
     while (1) /* do until end of block */
     {
-        NEEDBITS((unsigned)bl, decompress)
-        t = tl + ((unsigned)b & ml);
-        while (1)
+        REFILLBITS()
+        DECODE(entry, tl, LITLEN_TABLEBITS)
+        if (entry & HUFFDEC_LITERAL)
         {
-            DUMPBITS(t->b)
-
-            if ((e = t->e) == 32) /* then it's a literal */
+#ifdef _WIN64
+            // literals usually come in runs; after a refill the 64-bit buffer mostly holds at
+            // least 56 bits, enough for three literals of the main table
+            if (wsize - w > 3 && k >= 3 * LITLEN_TABLEBITS) // the window cannot get full in between
             {
-                redirSlide[w++] = (uch)t->v.n;
-                if (w == wsize)
+                uch* out = redirSlide + w;
+                DUMPBITS(ENTRY_BITS(entry))
+                *out++ = (uch)ENTRY_VALUE(entry);
+                entry = tl[BITS(LITLEN_TABLEBITS)];
+                if (entry & HUFFDEC_LITERAL)
                 {
-                    if (decompress->Output->Flush(w, decompress))
+                    DUMPBITS(ENTRY_BITS(entry))
+                    *out++ = (uch)ENTRY_VALUE(entry);
+                    entry = tl[BITS(LITLEN_TABLEBITS)];
+                    if (entry & HUFFDEC_LITERAL)
                     {
-                        TRACE_I("inflate_codes: flush returned error");
-                        return 5;
+                        DUMPBITS(ENTRY_BITS(entry))
+                        *out++ = (uch)ENTRY_VALUE(entry);
+                        w = (unsigned)(out - redirSlide);
+                        continue;
                     }
-                    w = 0;
                 }
-                break;
+                w = (unsigned)(out - redirSlide);
+                // continue with decoding of 'entry' (at least LITLEN_TABLEBITS bits are left for it)
             }
-
-            if (e < 31) /* then it's a length */
+            else
+#endif
             {
-                /* get length of block to copy */
-                NEEDBITS(e, decompress)
-                n = t->v.n + ((unsigned)b & mask_bits[e]);
-                DUMPBITS(e)
-
-                /* decode distance of block to copy */
-                NEEDBITS((unsigned)bd, decompress)
-                t = td + ((unsigned)b & md);
-                while (1)
-                {
-                    DUMPBITS(t->b)
-                    if ((e = t->e) < 32)
-                        break;
-                    if (IS_INVALID_CODE(e))
-                    {
-                        TRACE_E("inflate_codes: invalid code");
-                        return 1;
-                    }
-                    e &= 31;
-                    NEEDBITS(e, decompress)
-                    t = t->v.t + ((unsigned)b & mask_bits[e]);
-                }
-                NEEDBITS(e, decompress)
-                d = w - t->v.n - ((unsigned)b & mask_bits[e]);
-                DUMPBITS(e)
-
-                /* do the copy */
-                do
-                {
-                    e = wsize - ((d &= (wsize - 1)) > w ? d : w);
-                    if (e > n)
-                        e = n;
-                    n -= e;
-#ifndef NOMEMCPY
-                    if (w - d >= e)
-                    /* (this test assumes unsigned comparison) */
-                    {
-                        memmove(redirSlide + w, redirSlide + d, e);
-                        w += e;
-                        d += e;
-                    }
-                    else /* do it slowly to avoid memcpy() overlap */
-#endif                   /* !NOMEMCPY */
-                        do
-                        {
-                            redirSlide[w++] = redirSlide[d++];
-                        } while (--e);
-                    if (w == wsize)
-                    {
-                        if (decompress->Output->Flush(w, decompress))
-                        {
-                            TRACE_I("inflate_codes: flush returned error");
-                            return 5;
-                        }
-                        w = 0;
-                    }
-                } while (n);
-                break;
+                DUMPBITS(ENTRY_BITS(entry))
+                redirSlide[w++] = (uch)ENTRY_VALUE(entry);
+                if (w == wsize)
+                    FLUSHWINDOW()
+                continue;
             }
-
-            if (e == 31) /* it's the EOB signal */
+        }
+        if (entry & HUFFDEC_SUBTABLE)
+        {
+            DECODESUB(entry, tl)
+            if (entry & HUFFDEC_LITERAL)
             {
-                /* sorry for this goto, but we have to exit two loops at once */
-                goto cleanup_decode;
+                DUMPBITS(ENTRY_BITS(entry))
+                redirSlide[w++] = (uch)ENTRY_VALUE(entry);
+                if (w == wsize)
+                    FLUSHWINDOW()
+                continue;
             }
-
-            if (IS_INVALID_CODE(e))
+        }
+        if (entry & (HUFFDEC_EOB | HUFFDEC_INVALID))
+        {
+            if (entry & HUFFDEC_INVALID)
             {
                 TRACE_E("inflate_codes: invalid code");
                 return 1;
             }
+            DUMPBITS(ENTRY_BITS(entry))
+            break; /* end of block */
+        }
 
-            e &= 31;
-            NEEDBITS(e, decompress)
-            t = t->v.t + ((unsigned)b & mask_bits[e]);
+        /* get length of block to copy */
+        DUMPBITS(ENTRY_CODELEN(entry))
+        e = ENTRY_BITS(entry) - ENTRY_CODELEN(entry); /* extra bits */
+        NEEDBITS(e)
+        n = ENTRY_VALUE(entry) + BITS(e);
+        DUMPBITS(e)
+
+        /* decode distance of block to copy */
+        REFILLBITS()
+        DECODE(entry, td, DIST_TABLEBITS)
+        if (entry & HUFFDEC_SUBTABLE)
+            DECODESUB(entry, td)
+        if (entry & HUFFDEC_INVALID)
+        {
+            TRACE_E("inflate_codes: invalid code");
+            return 1;
+        }
+        DUMPBITS(ENTRY_CODELEN(entry))
+        e = ENTRY_BITS(entry) - ENTRY_CODELEN(entry); /* extra bits */
+        NEEDBITS(e)
+        d = ENTRY_VALUE(entry) + BITS(e);
+        DUMPBITS(e)
+
+        /* do the copy */
+        if (d <= w && n <= wsize - w) /* the usual case: neither source nor target wraps around the window */
+        {
+            uch* dst = redirSlide + w;
+            const uch* src = dst - d;
+            w += n;
+            if (d >= sizeof(bitbuf_t)) /* copy by words, overlapping is harmless at this distance */
+            {
+                while (n >= sizeof(bitbuf_t))
+                {
+                    *(UNALIGNED bitbuf_t*)dst = *(UNALIGNED const bitbuf_t*)src;
+                    dst += sizeof(bitbuf_t);
+                    src += sizeof(bitbuf_t);
+                    n -= sizeof(bitbuf_t);
+                }
+                while (n--)
+                    *dst++ = *src++;
+            }
+            else
+            {
+                if (d == 1) /* run of one byte */
+                    memset(dst, *src, n);
+                else
+                {
+                    do
+                    {
+                        *dst++ = *src++;
+                    } while (--n);
+                }
+            }
+            if (w == wsize)
+                FLUSHWINDOW()
+        }
+        else
+        {
+            d = w - d;
+            do
+            {
+                e = wsize - ((d &= (wsize - 1)) > w ? d : w);
+                if (e > n)
+                    e = n;
+                n -= e;
+                if (w - d >= e)
+                /* (this test assumes unsigned comparison) */
+                {
+                    memmove(redirSlide + w, redirSlide + d, e);
+                    w += e;
+                    d += e;
+                }
+                else /* do it slowly to avoid memcpy() overlap */
+                    do
+                    {
+                        redirSlide[w++] = redirSlide[d++];
+                    } while (--e);
+                if (w == wsize)
+                    FLUSHWINDOW()
+            } while (n);
         }
     }
-cleanup_decode:
 
     /* restore the globals from the locals */
     decompress->Output->WinPos = w; /* restore global window pointer */
-    decompress->Input->BitBuf = b;  /* restore global bit buffer */
-    decompress->Input->BitCount = k;
+    SAVEBITS()
 
     /* done */
     return 0;
 }
 
-#endif /* ASM_INFLATECODES */
-
 // "decompress" an inflated type 0 (stored) block.
-int inflate_stored(CDecompressionObject* decompress)
+static int inflate_stored(CDecompressionObject* decompress)
 {
-    unsigned n; // number of bytes in block
-    ulg b;      // bit buffer
-    unsigned k; // number of bits in bit buffer
+    unsigned n;    // number of bytes in block
+    bitbuf_t b;    // bit buffer
+    unsigned k;    // number of bits in bit buffer
+    uch* in;       // next input byte
+    unsigned left; // number of bytes left in the input buffer
     unsigned outBytes,
         inBytes; //temporary variables
 
     // make local copies of globals
-    b = decompress->Input->BitBuf; // initialize bit buffer
-    k = decompress->Input->BitCount;
+    LOADBITS()
 
     // go to byte boundary
     n = k & 7;
     DUMPBITS(n);
 
     // get the length and its complement
-    NEEDBITS(16, decompress)
+    NEEDBITS(16)
     n = ((unsigned)b & 0xffff);
     DUMPBITS(16)
-    NEEDBITS(16, decompress)
+    NEEDBITS(16)
     if (n != (unsigned)((~b) & 0xffff))
         return 1; // error in compressed data
     DUMPBITS(16)
 
-    /* old copy routine, the new should be faster (I hope so)
-  // read and output the compressed data
-  while (n--)
-  {
-    NEEDBITS(8, decompress)
-    decompress->Output->SlideWin[w++] = (uch)b;
-    if (w == decompress->Output->WinSize)
+    // the bit buffer can hold whole bytes of the block read ahead
+    while (n && k)
     {
-      decompress->Output->Flush(w, decompress);
-      w = 0;
+        decompress->Output->SlideWin[decompress->Output->WinPos++] = (uch)b;
+        DUMPBITS(8)
+        n--;
+        if (decompress->Output->WinPos == decompress->Output->WinSize)
+        {
+            if (decompress->Output->Flush(decompress->Output->WinPos, decompress))
+            {
+                TRACE_I("inflate_stored: flush returned error");
+                return 5;
+            }
+            decompress->Output->WinPos = 0;
+        }
     }
-    DUMPBITS(8, decompress)
-  }
-*/
+    // the rest of the block is copied directly from the input, the bits read ahead are dropped
+    b &= ((bitbuf_t)1 << k) - 1;
+
+    // restore the globals from the locals
+    SAVEBITS()
 
     //copy bytes from intup to the output
     while (n)
@@ -533,6 +863,15 @@ int inflate_stored(CDecompressionObject* decompress)
         n -= outBytes;
         while (outBytes)
         {
+            if (!decompress->Input->BytesLeft)
+            {
+                decompress->Input->Refill(decompress);
+                if (decompress->Input->Error)
+                {
+                    TRACE_I("inflate_stored: input error");
+                    return 4;
+                }
+            }
             if (outBytes <= decompress->Input->BytesLeft)
                 inBytes = outBytes;
             else
@@ -544,15 +883,6 @@ int inflate_stored(CDecompressionObject* decompress)
             decompress->Input->BytesLeft -= inBytes;
             decompress->Output->WinPos += inBytes;
             outBytes -= inBytes;
-            if (!decompress->Input->BytesLeft && outBytes)
-            {
-                decompress->Input->Refill(decompress);
-                if (decompress->Input->Error)
-                {
-                    TRACE_I("inflate_stored: input error");
-                    return 4;
-                }
-            }
         }
 
         if (decompress->Output->WinPos == decompress->Output->WinSize)
@@ -565,23 +895,22 @@ int inflate_stored(CDecompressionObject* decompress)
             decompress->Output->WinPos = 0;
         }
     }
-
-    // restore the globals from the locals
-    decompress->Input->BitBuf = b; // restore global bit buffer
-    decompress->Input->BitCount = k;
     return 0;
 }
 
-// decompress an inflated type 1 (fixed Huffman codes) block.  We should
-// either replace this with a custom decoder, or at least precompute the
-// Huffman tables.
-int inflate_fixed(CDecompressionObject* decompress)
+// decompress an inflated type 1 (fixed Huffman codes) block; the tables
+// are built on first use and kept in decompress->InflateTables
+static int inflate_fixed(CDecompressionObject* decompress)
 {
+    CInflateTables* tables = decompress->InflateTables;
+    int deflate64 = decompress->Deflate64;
+
     // if first time, set up tables for fixed blocks
-    if (decompress->fixed_tl == (struct huft*)NULL)
+    if (!tables->FixedReady[deflate64])
     {
-        int i;           // temporary variable
-        unsigned l[288]; // length list for huft_build
+        int i; // temporary variable
+        unsigned maxLen;
+        uch l[288]; // length list for BuildDecodeTable
 
         // literal table
         for (i = 0; i < 144; i++)
@@ -592,67 +921,60 @@ int inflate_fixed(CDecompressionObject* decompress)
             l[i] = 7;
         for (; i < 288; i++) // make a complete, but wrong code set
             l[i] = 8;
-        decompress->fixed_bl = 7;
-        if ((i = huft_build(decompress, l, 288, 257,
-                            decompress->cplens, decompress->cplext,
-                            &decompress->fixed_tl, &decompress->fixed_bl)) != 0)
+        if ((i = BuildDecodeTable(tables->FixedLitLen[deflate64], _countof(tables->FixedLitLen[deflate64]),
+                                  LITLEN_TABLEBITS, l, 288, deflate64 ? GetLitLenEntry64 : GetLitLenEntry32,
+                                  &maxLen)) != 0)
         {
-            decompress->fixed_tl = (struct huft*)NULL;
-            TRACE_E("inflate_fixed: error in huft_build");
+            TRACE_E("inflate_fixed: error in BuildDecodeTable");
             return i;
         }
 
         // distance table
         for (i = 0; i < MAXDISTS; i++) // make an incomplete code set
             l[i] = 5;
-        decompress->fixed_bd = 5;
-        if ((i = huft_build(decompress, l, MAXDISTS, 0, cpdist, decompress->cpdext,
-                            &decompress->fixed_td, &decompress->fixed_bd)) > 1)
+        if ((i = BuildDecodeTable(tables->FixedDist[deflate64], _countof(tables->FixedDist[deflate64]),
+                                  DIST_TABLEBITS, l, MAXDISTS, deflate64 ? GetDistEntry64 : GetDistEntry32,
+                                  &maxLen)) > 1)
         {
-            huft_free(decompress, decompress->fixed_tl);
-            decompress->fixed_tl = (struct huft*)NULL;
-            TRACE_E("inflate_fixed: error in huft_build");
+            TRACE_E("inflate_fixed: error in BuildDecodeTable");
             return i;
         }
+        tables->FixedReady[deflate64] = TRUE;
     }
 
     // decompress until an end-of-block code
-    return inflate_codes(decompress, decompress->fixed_tl, decompress->fixed_td,
-                         decompress->fixed_bl, decompress->fixed_bd) != 0;
+    return inflate_codes(decompress, tables->FixedLitLen[deflate64], tables->FixedDist[deflate64]) != 0;
 }
 
 /* decompress an inflated type 2 (dynamic Huffman codes) block. */
-int inflate_dynamic(CDecompressionObject* decompress)
+static int inflate_dynamic(CDecompressionObject* decompress)
 {
+    CInflateTables* tables = decompress->InflateTables;
     int i; /* temporary variables */
     unsigned j;
-    unsigned l;                         /* last length */
-    unsigned m;                         /* mask for bit lengths table */
-    unsigned n;                         /* number of lengths to get */
-    struct huft* tl;                    /* literal/length code table */
-    struct huft* td;                    /* distance code table */
-    int bl;                             /* lookup bits for tl */
-    int bd;                             /* lookup bits for td */
-    unsigned nb;                        /* number of bit length codes */
-    unsigned nl;                        /* number of literal/length codes */
-    unsigned nd;                        /* number of distance codes */
-    unsigned ll[MAXLITLENS + MAXDISTS]; /* lit./length and distance code lengths */
-    ulg b;                              /* bit buffer */
-    unsigned k;                         /* number of bits in bit buffer */
+    unsigned l;                    /* last length */
+    unsigned n;                    /* number of lengths to get */
+    unsigned nb;                   /* number of bit length codes */
+    unsigned nl;                   /* number of literal/length codes */
+    unsigned nd;                   /* number of distance codes */
+    unsigned maxLen;               /* longest code in the built table */
+    DWORD entry;                   /* table entry */
+    uch ll[MAXLITLENS + MAXDISTS]; /* lit./length and distance code lengths */
+    bitbuf_t b;                    /* bit buffer */
+    unsigned k;                    /* number of bits in bit buffer */
+    uch* in;                       /* next input byte */
+    unsigned left;                 /* number of bytes left in the input buffer */
 
     /* make local bit buffer */
-    b = decompress->Input->BitBuf;
-    k = decompress->Input->BitCount;
+    LOADBITS()
 
     /* read in table lengths */
-    NEEDBITS(5, decompress)
-    nl = 257 + ((unsigned)b & 0x1f); /* number of literal/length codes */
+    NEEDBITS(14)
+    nl = 257 + BITS(5); /* number of literal/length codes */
     DUMPBITS(5)
-    NEEDBITS(5, decompress)
-    nd = 1 + ((unsigned)b & 0x1f); /* number of distance codes */
+    nd = 1 + BITS(5); /* number of distance codes */
     DUMPBITS(5)
-    NEEDBITS(4, decompress)
-    nb = 4 + ((unsigned)b & 0xf); /* number of bit length codes */
+    nb = 4 + BITS(4); /* number of bit length codes */
     DUMPBITS(4)
     if (nl > MAXLITLENS || nd > MAXDISTS)
         return 1; /* bad lengths */
@@ -660,42 +982,46 @@ int inflate_dynamic(CDecompressionObject* decompress)
     /* read in bit-length-code lengths */
     for (j = 0; j < nb; j++)
     {
-        NEEDBITS(3, decompress)
-        ll[border[j]] = (unsigned)b & 7;
+        NEEDBITS(3)
+        ll[border[j]] = (uch)BITS(3);
         DUMPBITS(3)
     }
     for (; j < 19; j++)
         ll[border[j]] = 0;
 
     /* build decoding table for trees--single level, 7 bit lookup */
-    bl = 7;
-    i = huft_build(decompress, ll, 19, 19, NULL, NULL, &tl, &bl);
-    if (bl == 0) /* no bit lengths */
+    i = BuildDecodeTable(tables->Precode, _countof(tables->Precode), PRECODE_TABLEBITS,
+                         ll, 19, GetPrecodeEntry, &maxLen);
+    if (i == 1 && maxLen == 1) /* a single one-bit code is not complete, but valid */
+        i = 0;
+    if (maxLen == 0) /* no bit lengths */
         i = 1;
     if (i)
     {
-        if (i == 1)
-            huft_free(decompress, tl);
-        TRACE_E("inflate_dynamic: error in huft_build");
+        TRACE_E("inflate_dynamic: error in BuildDecodeTable");
         return i; /* incomplete code set */
     }
 
     /* read in literal and distance code lengths */
     n = nl + nd;
-    m = mask_bits[bl];
     i = l = 0;
     while ((unsigned)i < n)
     {
-        NEEDBITS((unsigned)bl, decompress)
-        j = (td = tl + ((unsigned)b & m))->b;
-        DUMPBITS(j)
-        j = td->v.n;
-        if (j < 16)          /* length of code in bits (0..15) */
-            ll[i++] = l = j; /* save last length in l */
-        else if (j == 16)    /* repeat last length 3 to 6 times */
+        REFILLBITS()
+        DECODE(entry, tables->Precode, PRECODE_TABLEBITS)
+        if (entry & HUFFDEC_INVALID)
+        {
+            TRACE_E("inflate_dynamic: invalid code");
+            return 1;
+        }
+        DUMPBITS(ENTRY_BITS(entry))
+        j = ENTRY_VALUE(entry);
+        if (j < 16)                 /* length of code in bits (0..15) */
+            ll[i++] = (uch)(l = j); /* save last length in l */
+        else if (j == 16)           /* repeat last length 3 to 6 times */
         {
-            NEEDBITS(2, decompress)
-            j = 3 + ((unsigned)b & 3);
+            NEEDBITS(2)
+            j = 3 + BITS(2);
             DUMPBITS(2)
             if ((unsigned)i + j > n)
             {
@@ -703,12 +1029,12 @@ int inflate_dynamic(CDecompressionObject* decompress)
                 return 1;
             }
             while (j--)
-                ll[i++] = l;
+                ll[i++] = (uch)l;
         }
         else if (j == 17) /* 3 to 10 zero length codes */
         {
-            NEEDBITS(3, decompress)
-            j = 3 + ((unsigned)b & 7);
+            NEEDBITS(3)
+            j = 3 + BITS(3);
             DUMPBITS(3)
             if ((unsigned)i + j > n)
             {
@@ -721,8 +1047,8 @@ int inflate_dynamic(CDecompressionObject* decompress)
         }
         else /* j == 18: 11 to 138 zero length codes */
         {
-            NEEDBITS(7, decompress)
-            j = 11 + ((unsigned)b & 0x7f);
+            NEEDBITS(7)
+            j = 11 + BITS(7);
             DUMPBITS(7)
             if ((unsigned)i + j > n)
             {
@@ -735,33 +1061,28 @@ int inflate_dynamic(CDecompressionObject* decompress)
         }
     }
 
-    /* free decoding table for trees */
-    huft_free(decompress, tl);
-
     /* restore the global bit buffer */
-    decompress->Input->BitBuf = b;
-    decompress->Input->BitCount = k;
+    SAVEBITS()
 
     /* build the decoding tables for literal/length and distance codes */
-    bl = lbits;
-    i = huft_build(decompress, ll, nl, 257,
-                   decompress->cplens, decompress->cplext, &tl, &bl);
-    if (bl == 0) /* no literals or lengths */
+    i = BuildDecodeTable(tables->LitLen, _countof(tables->LitLen), LITLEN_TABLEBITS, ll, nl,
+                         decompress->Deflate64 ? GetLitLenEntry64 : GetLitLenEntry32, &maxLen);
+    if (i == 1 && maxLen == 1)
+        i = 0;
+    if (maxLen == 0) /* no literals or lengths */
         i = 1;
     if (i)
     {
         if (i == 1)
-        {
             TRACE_E("inflate_dynamic: incomplete l-tree");
-            huft_free(decompress, tl);
-        }
-        TRACE_E("inflate_dynamic: error in huft_build");
+        TRACE_E("inflate_dynamic: error in BuildDecodeTable");
         return i; /* incomplete code set */
     }
 
-    bd = dbits;
-    i = huft_build(decompress, ll + nl, nd, 0, cpdist,
-                   decompress->cpdext, &td, &bd);
+    i = BuildDecodeTable(tables->Dist, _countof(tables->Dist), DIST_TABLEBITS, ll + nl, nd,
+                         decompress->Deflate64 ? GetDistEntry64 : GetDistEntry32, &maxLen);
+    if (i == 1 && maxLen == 1)
+        i = 0;
 #ifdef PKZIP_BUG_WORKAROUND
     if (i == 1)
     {
@@ -769,55 +1090,44 @@ int inflate_dynamic(CDecompressionObject* decompress)
         TRACE_W("inflate_dynamic: incomplete d-tree, PKZIP_BUG_WORKAROUND -> continue");
     }
 #endif
-    if (bd == 0 && nl > 257) /* lengths but no distances */
+    if (maxLen == 0 && nl > 257) /* lengths but no distances */
         i = 1;
     if (i)
     {
         if (i == 1)
-        {
             TRACE_E("inflate_dynamic: incomplete d-tree");
-            huft_free(decompress, td);
-        }
-        huft_free(decompress, tl);
-        TRACE_E("inflate_dynamic: error in huft_build");
+        TRACE_E("inflate_dynamic: error in BuildDecodeTable");
         return i;
     }
 
     /* decompress until an end-of-block code */
-    if ((i = inflate_codes(decompress, tl, td, bl, bd)) != 0)
+    if ((i = inflate_codes(decompress, tables->LitLen, tables->Dist)) != 0)
         TRACE_I("inflate_dynamic: error in inflate_codes");
-
-    /* free the decoding tables, return */
-    huft_free(decompress, tl);
-    huft_free(decompress, td);
     return i;
 }
 
 /* decompress an inflated block */
-int inflate_block(CDecompressionObject* decompress, int* e)
+static int inflate_block(CDecompressionObject* decompress, int* e)
 //  int *e;
 {
-    unsigned t; /* block type */
-    ulg b;      /* bit buffer */
-    unsigned k; /* number of bits in bit buffer */
+    unsigned t;    /* block type */
+    bitbuf_t b;    /* bit buffer */
+    unsigned k;    /* number of bits in bit buffer */
+    uch* in;       /* next input byte */
+    unsigned left; /* number of bytes left in the input buffer */
 
     /* make local bit buffer */
-    b = decompress->Input->BitBuf;
-    k = decompress->Input->BitCount;
+    LOADBITS()
 
-    /* read in last block bit */
-    NEEDBITS(1, decompress)
-    *e = (int)b & 1;
+    /* read in last block bit and block type */
+    NEEDBITS(3)
+    *e = (int)BITS(1);
     DUMPBITS(1)
-
-    /* read in block type */
-    NEEDBITS(2, decompress)
-    t = (unsigned)b & 3;
+    t = BITS(2);
     DUMPBITS(2)
 
     /* restore the global bit buffer */
-    decompress->Input->BitBuf = b;
-    decompress->Input->BitCount = k;
+    SAVEBITS()
 
     /* inflate that block type */
     if (t == 2)
@@ -839,74 +1149,34 @@ int Inflate(CDecompressionObject* decompress, int deflate64)
     int e; /* last block flag */
     int r; /* result code */
 
-    /*
-#ifdef DEBUG
-  unsigned h = 0;       // maximum struct huft's malloc'ed
-#endif
-*/
+    if (decompress->InflateTables == NULL)
+    {
+        decompress->InflateTables = (CInflateTables*)MemAlloc(sizeof(CInflateTables), decompress->HeapInfo);
+        if (decompress->InflateTables == NULL)
+        {
+            TRACE_E("Inflate: low memory");
+            return 3;
+        }
+        decompress->InflateTables->FixedReady[0] = FALSE;
+        decompress->InflateTables->FixedReady[1] = FALSE;
+    }
 
     /* initialize window, bit buffer */
     decompress->Output->WinPos = 0;
     decompress->Input->BitCount = 0;
     decompress->Input->BitBuf = 0;
-
-    if (deflate64)
-    {
-        decompress->cplens = cplens64;
-        decompress->cplext = cplext64;
-        decompress->cpdext = cpdext64;
-        decompress->fixed_tl = decompress->fixed_tl64;
-        decompress->fixed_bl = decompress->fixed_bl64;
-        decompress->fixed_td = decompress->fixed_td64;
-        decompress->fixed_bd = decompress->fixed_bd64;
-    }
-    else
-    {
-        decompress->cplens = cplens32;
-        decompress->cplext = cplext32;
-        decompress->cpdext = cpdext32;
-        decompress->fixed_tl = decompress->fixed_tl32;
-        decompress->fixed_bl = decompress->fixed_bl32;
-        decompress->fixed_td = decompress->fixed_td32;
-        decompress->fixed_bd = decompress->fixed_bd32;
-    }
+    decompress->Deflate64 = deflate64 ? 1 : 0;
 
     /* decompress until the last block */
     do
     {
-        /*
-#ifdef DEBUG
-    G.hufts = 0;
-#endif
-*/
         if ((r = inflate_block(decompress, &e)) != 0)
         {
             TRACE_I("Inflate: error in inflate_block");
             break;
         }
-        /*
-#ifdef DEBUG
-    if (G.hufts > h)
-      h = G.hufts;
-#endif
-*/
     } while (!e);
 
-    if (deflate64)
-    {
-        decompress->fixed_tl64 = decompress->fixed_tl;
-        decompress->fixed_bl64 = decompress->fixed_bl;
-        decompress->fixed_td64 = decompress->fixed_td;
-        decompress->fixed_bd64 = decompress->fixed_bd;
-    }
-    else
-    {
-        decompress->fixed_tl32 = decompress->fixed_tl;
-        decompress->fixed_bl32 = decompress->fixed_bl;
-        decompress->fixed_td32 = decompress->fixed_td;
-        decompress->fixed_bd32 = decompress->fixed_bd;
-    }
-
     if (r == 0)
     {
         /* flush out remaining data in sliding window */
@@ -919,24 +1189,15 @@ int Inflate(CDecompressionObject* decompress, int deflate64)
     }
 
     /* return success */
-    //  Trace((stderr, "\n%u bytes in Huffman tables (%d/entry)\n",
-    //         h * sizeof(struct huft), sizeof(struct huft)));
     return r;
 }
 
 int FreeFixedHufman(CDecompressionObject* decompress)
 {
-    if (decompress->fixed_tl64 != (struct huft*)NULL)
-    {
-        huft_free(decompress, decompress->fixed_td64);
-        huft_free(decompress, decompress->fixed_tl64);
-        decompress->fixed_td64 = decompress->fixed_tl64 = (struct huft*)NULL;
-    }
-    if (decompress->fixed_tl32 != (struct huft*)NULL)
+    if (decompress->InflateTables != NULL)
     {
-        huft_free(decompress, decompress->fixed_td32);
-        huft_free(decompress, decompress->fixed_tl32);
-        decompress->fixed_td32 = decompress->fixed_tl32 = (struct huft*)NULL;
+        MemFree(decompress->InflateTables, decompress->HeapInfo);
+        decompress->InflateTables = NULL;
     }
     return 0;
 }
@@ -947,8 +1208,7 @@ int FreeFixedHufman(CDecompressionObject* decompress)
  */
 
 /* If BMAX needs to be larger than 16, then h and x[] should be ulg. */
-#define BMAX 16   /* maximum bit length of any code (16 for explode) */
-#define N_MAX 288 /* maximum number of codes in any set */
+#define BMAX 16 /* maximum bit length of any code (16 for explode) */
 
 int huft_build(CDecompressionObject* decompress,
                const unsigned* b, /* code lengths in bits (all assumed <= BMAX) */
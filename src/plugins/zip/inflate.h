@@ -17,6 +17,8 @@ struct huft
 struct tagCDecompressionObject;
 typedef tagCDecompressionObject CDecompressionObject;
 
+struct CInflateTables;
+
 //input manager for decompression
 
 typedef void (*FRefillInBuffer)(CDecompressionObject*);
@@ -34,7 +36,7 @@ typedef struct
                         //checked in NextByte() function (inflate.cpp)
 
     //internal fields
-    ulg BitBuf;        //bit buffer
+    bitbuf_t BitBuf;   //bit buffer (inflate fills it ahead from the input buffer)
     unsigned BitCount; //number of bits in bit buffer */
 
     //user function
@@ -81,15 +83,9 @@ struct tagCDecompressionObject
     void* UserData; //pointer to a user data
     void* HeapInfo; //passed to memory functions
 
-    //inflate: fixed hufman trees
-    struct huft* fixed_tl64; // !! must be NULL initialized
-    struct huft* fixed_td64; //before calling inflate
-    int fixed_bl64,
-        fixed_bd64;
-    struct huft* fixed_tl32; // !! must be NULL initialized
-    struct huft* fixed_td32; //before calling inflate
-    int fixed_bl32,
-        fixed_bd32;
+    //inflate: decoding tables, the fixed ones are kept for next calls
+    struct CInflateTables* InflateTables; // !! must be NULL initialized
+                                          //before calling inflate
 
     //explode + unreduce
     unsigned __int64 ucsize; //uncompressed size
@@ -105,14 +101,7 @@ struct tagCDecompressionObject
     int Method;
 
     // internal variables for inflate
-    struct huft* fixed_tl;
-    struct huft* fixed_td;
-    int fixed_bl,
-        fixed_bd;
-
-    const ush* cplens;
-    const uch* cplext;
-    const uch* cpdext;
+    int Deflate64;
 };
 
 int Inflate(CDecompressionObject* decompress, int deflate64);
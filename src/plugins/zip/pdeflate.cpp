@@ -0,0 +1,453 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "precomp.h"
+
+#include "common.h"
+#include "deflate.h"
+#include "pdeflate.h"
+
+#include "zip.rh"
+#include "zip.rh2"
+
+CParallelDeflate::CParallelDeflate()
+{
+    Level = 0;
+    memset(Chunks, 0, sizeof(Chunks));
+    ChunksCount = 0;
+    Head = 0;
+    Used = 0;
+    memset(Members, 0, sizeof(Members));
+    MembersCount = 0;
+    MembersHead = 0;
+    MembersUsed = 0;
+    MembersSize = 0;
+    MembersSizeLimit = 0;
+    WorkReady = NULL;
+    ChunkDone = NULL;
+    ThreadsCount = 0;
+    Terminate = FALSE;
+    InitializeCriticalSection(&CS);
+}
+
+CParallelDeflate::~CParallelDeflate()
+{
+    CALL_STACK_MESSAGE1("CParallelDeflate::~CParallelDeflate()");
+    if (ThreadsCount > 0)
+    {
+        // workers finish the part they are compressing and leave
+        Terminate = TRUE;
+        ReleaseSemaphore(WorkReady, ThreadsCount, NULL);
+        WaitForMultipleObjects(ThreadsCount, Threads, TRUE, INFINITE);
+        int i;
+        for (i = 0; i < ThreadsCount; i++)
+            CloseHandle(Threads[i]);
+    }
+    if (WorkReady != NULL)
+        CloseHandle(WorkReady);
+    if (ChunkDone != NULL)
+        CloseHandle(ChunkDone);
+    int i;
+    for (i = 0; i < ChunksCount; i++)
+    {
+        if (Chunks[i].In != NULL)
+            free(Chunks[i].In);
+        if (Chunks[i].Out != NULL)
+            free(Chunks[i].Out);
+    }
+    for (i = 0; i < MembersCount; i++)
+        FreeMember(&Members[i]);
+    DeleteCriticalSection(&CS);
+}
+
+int CParallelDeflate::GetThreadCount()
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return max(1, min(PDEFLATE_MAX_THREADS, (int)si.dwNumberOfProcessors));
+}
+
+BOOL CParallelDeflate::Start()
+{
+    CALL_STACK_MESSAGE1("CParallelDeflate::Start()");
+    int threads = GetThreadCount();
+    if (threads < 2)
+        return FALSE;
+    WorkReady = CreateSemaphore(NULL, 0, 0x7FFFFFFF, NULL);
+    ChunkDone = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (WorkReady == NULL || ChunkDone == NULL)
+        return FALSE;
+    // two parts per worker: one being compressed, one read ahead (allocated by the first
+    // large file); small files are queued while they fit into the same amount of memory
+    ChunksCount = 2 * threads;
+    MembersCount = min(PDEFLATE_MAX_MEMBERS, 4 * threads);
+    MembersSizeLimit = ChunksCount * PDEFLATE_CHUNK;
+    while (ThreadsCount < threads)
+    {
+        DWORD id;
+        Threads[ThreadsCount] = CreateThread(NULL, 0, WorkerThreadF, this, 0, &id);
+        if (Threads[ThreadsCount] == NULL)
+            break;
+        ThreadsCount++;
+    }
+    return ThreadsCount > 1;
+}
+
+unsigned WINAPI CParallelDeflate::WorkerThreadBody(void* param)
+{
+    ((CParallelDeflate*)param)->Work();
+    return 0;
+}
+
+DWORD WINAPI CParallelDeflate::WorkerThreadF(void* param)
+{
+    return SalamanderDebug->CallWithCallStack(WorkerThreadBody, param);
+}
+
+void CParallelDeflate::Work()
+{
+    CALL_STACK_MESSAGE1("CParallelDeflate::Work()");
+    // CDeflate is too big for the stack
+    CDeflate* deflate = new CDeflate();
+    while (TRUE)
+    {
+        WaitForSingleObject(WorkReady, INFINITE);
+        if (Terminate)
+            break;
+        // take the oldest part nobody works on, the calling thread waits for the parts;
+        // otherwise the oldest queued small file
+        CDeflateChunk* chunk = NULL;
+        CDeflateMember* member = NULL;
+        EnterCriticalSection(&CS);
+        int i;
+        for (i = 0; i < Used; i++)
+        {
+            CDeflateChunk* c = &Chunks[(Head + i) % ChunksCount];
+            if (c->State == PDCHUNK_QUEUED)
+            {
+                chunk = c;
+                chunk->State = PDCHUNK_WORKING;
+                break;
+            }
+        }
+        for (i = 0; chunk == NULL && i < MembersUsed; i++)
+        {
+            CDeflateMember* m = &Members[(MembersHead + i) % MembersCount];
+            if (m->State == PDMEMBER_QUEUED)
+            {
+                member = m;
+                member->State = PDMEMBER_WORKING;
+                break;
+            }
+        }
+        LeaveCriticalSection(&CS);
+        if (member != NULL)
+        {
+            int error = deflate != NULL ? CompressMember(deflate, member) : IDS_LOWMEM;
+            EnterCriticalSection(&CS);
+            member->Data.Error = error;
+            member->State = PDMEMBER_DONE;
+            LeaveCriticalSection(&CS);
+            SetEvent(ChunkDone);
+            continue;
+        }
+        if (chunk == NULL) // cancelled or dropped meanwhile
+            continue;
+
+        chunk->InPos = 0;
+        chunk->OutSize = 0;
+        chunk->Attr = (ush)UNKNOWN;
+        if (deflate != NULL)
+            chunk->Error = deflate->DeflateChunk(&chunk->Attr, Level, chunk->Last, WriteChunk, ReadChunk, chunk);
+        else
+            chunk->Error = IDS_LOWMEM;
+        EnterCriticalSection(&CS);
+        chunk->State = PDCHUNK_DONE;
+        LeaveCriticalSection(&CS);
+        SetEvent(ChunkDone);
+    }
+    if (deflate != NULL)
+        delete deflate;
+}
+
+int CParallelDeflate::ReadChunk(char* buffer, unsigned size, int* error, void* user)
+{
+    CDeflateChunk* chunk = (CDeflateChunk*)user;
+    unsigned read = min(size, chunk->InSize - chunk->InPos);
+    if (read == 0)
+        return EOF;
+    memcpy(buffer, chunk->In + chunk->InPos, read);
+    chunk->InPos += read;
+    return read;
+}
+
+int CParallelDeflate::WriteChunk(char* buffer, unsigned size, void* user)
+{
+    CDeflateChunk* chunk = (CDeflateChunk*)user;
+    if (chunk->OutAlloc - chunk->OutSize < size)
+    {
+        // incompressible data grow by a few bytes per stored block
+        unsigned alloc = max(chunk->OutSize + size, chunk->InSize + chunk->InSize / 8 + 1024);
+        char* out = (char*)realloc(chunk->Out, alloc);
+        if (out == NULL)
+            return IDS_LOWMEM;
+        chunk->Out = out;
+        chunk->OutAlloc = alloc;
+    }
+    memcpy(chunk->Out + chunk->OutSize, buffer, size);
+    chunk->OutSize += size;
+    return 0;
+}
+
+int CParallelDeflate::CompressMember(CDeflate* deflate, CDeflateMember* member)
+{
+    // read without asking the user anything: on an error the calling thread packs
+    // the file the usual way and reports the error then
+    HANDLE file = CreateFile(member->Name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                             FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return IDS_NODISPLAY;
+    CDeflateChunk* data = &member->Data;
+    data->InSize = 0;
+    BOOL ok = GetFileTime(file, NULL, NULL, &member->LastWrite);
+    if (ok)
+    {
+        // one byte more shows if the file grew
+        data->In = (char*)malloc(member->Size + 1);
+        ok = data->In != NULL;
+    }
+    while (ok && data->InSize <= member->Size)
+    {
+        DWORD read;
+        ok = ReadFile(file, data->In + data->InSize, member->Size + 1 - data->InSize, &read, NULL);
+        if (!ok || read == 0)
+            break;
+        data->InSize += read;
+    }
+    CloseHandle(file);
+    if (!ok || data->InSize != member->Size)
+        return IDS_NODISPLAY;
+
+    member->Crc = SalamanderGeneral->UpdateCrc32(data->In, data->InSize, INIT_CRC);
+    data->InPos = 0;
+    data->OutSize = 0;
+    data->Attr = (ush)UNKNOWN;
+    member->Method = DEFLATE;
+    ullg compLen;
+    return deflate->Deflate(&data->Attr, &member->Method, member->Level, &member->Flag, &compLen,
+                            WriteChunk, ReadChunk, data);
+}
+
+void CParallelDeflate::WaitMember(CDeflateMember* member, BOOL drop)
+{
+    while (TRUE)
+    {
+        EnterCriticalSection(&CS);
+        int state = member->State;
+        if (drop && state == PDMEMBER_QUEUED)
+            member->State = state = PDMEMBER_DONE; // no worker took it, none will
+        LeaveCriticalSection(&CS);
+        if (state == PDMEMBER_DONE)
+            break;
+        WaitForSingleObject(ChunkDone, INFINITE);
+    }
+}
+
+void CParallelDeflate::FreeMember(CDeflateMember* member)
+{
+    if (member->Data.In != NULL)
+        free(member->Data.In);
+    if (member->Data.Out != NULL)
+        free(member->Data.Out);
+    member->Data.In = NULL;
+    member->Data.Out = NULL;
+    member->Data.InSize = 0;
+    member->Data.OutSize = 0;
+    member->Data.OutAlloc = 0;
+}
+
+BOOL CParallelDeflate::QueueMember(int index, const char* name, unsigned size, int level, ush flag)
+{
+    if (MembersUsed == MembersCount || (MembersUsed > 0 && MembersSize + size > MembersSizeLimit))
+        return FALSE;
+    CDeflateMember* member = &Members[(MembersHead + MembersUsed) % MembersCount];
+    member->Index = index;
+    member->Name = name;
+    member->Size = size;
+    member->Level = level;
+    member->Flag = flag & GPF_DATADESCR;
+    member->Data.Error = 0;
+    MembersSize += size;
+    EnterCriticalSection(&CS);
+    member->State = PDMEMBER_QUEUED;
+    MembersUsed++;
+    LeaveCriticalSection(&CS);
+    ReleaseSemaphore(WorkReady, 1, NULL);
+    return TRUE;
+}
+
+CDeflateMember* CParallelDeflate::GetMember(int index)
+{
+    CALL_STACK_MESSAGE2("CParallelDeflate::GetMember(%d)", index);
+    while (MembersUsed > 0 && Members[MembersHead].Index <= index)
+    {
+        CDeflateMember* member = &Members[MembersHead];
+        WaitMember(member, member->Index < index);
+        if (member->Index == index && member->Data.Error == 0)
+            return member;
+        ReleaseMember(member); // a skipped file or a failure
+    }
+    return NULL;
+}
+
+void CParallelDeflate::ReleaseMember(CDeflateMember* member)
+{
+    // the members are released in the order of the files, 'member' is the oldest one
+    FreeMember(member);
+    MembersSize -= member->Size;
+    EnterCriticalSection(&CS);
+    member->State = PDMEMBER_FREE;
+    MembersHead = (MembersHead + 1) % MembersCount;
+    MembersUsed--;
+    LeaveCriticalSection(&CS);
+}
+
+int CParallelDeflate::ReadPart(CDeflateChunk* chunk, FReadData readFunc, void* userData, BOOL* eof)
+{
+    // the reading function updates the progress and the CRC of the file, so it
+    // gets the usual small blocks
+    chunk->InSize = 0;
+    while (chunk->InSize < PDEFLATE_CHUNK)
+    {
+        int error = 0;
+        int read = readFunc(chunk->In + chunk->InSize, min((unsigned)PDEFLATE_READ_SIZE, PDEFLATE_CHUNK - chunk->InSize),
+                            &error, userData);
+        if (error)
+            return error;
+        if (read == 0 || read == EOF)
+        {
+            *eof = TRUE;
+            break;
+        }
+        chunk->InSize += read;
+    }
+    return 0;
+}
+
+void CParallelDeflate::Queue(CDeflateChunk* chunk, BOOL last)
+{
+    chunk->Last = last;
+    EnterCriticalSection(&CS);
+    chunk->State = PDCHUNK_QUEUED;
+    LeaveCriticalSection(&CS);
+    ReleaseSemaphore(WorkReady, 1, NULL);
+}
+
+void CParallelDeflate::WaitChunk(CDeflateChunk* chunk)
+{
+    while (TRUE)
+    {
+        EnterCriticalSection(&CS);
+        int state = chunk->State;
+        LeaveCriticalSection(&CS);
+        if (state == PDCHUNK_DONE)
+            break;
+        WaitForSingleObject(ChunkDone, INFINITE);
+    }
+}
+
+void CParallelDeflate::Cancel()
+{
+    // parts nobody took yet are dropped, the others have to be finished
+    int i;
+    for (i = 0; i < Used; i++)
+    {
+        CDeflateChunk* chunk = &Chunks[(Head + i) % ChunksCount];
+        EnterCriticalSection(&CS);
+        BOOL working = chunk->State == PDCHUNK_WORKING;
+        if (!working)
+            chunk->State = PDCHUNK_FREE;
+        LeaveCriticalSection(&CS);
+        if (working)
+            WaitChunk(chunk);
+    }
+    EnterCriticalSection(&CS);
+    for (i = 0; i < ChunksCount; i++)
+        Chunks[i].State = PDCHUNK_FREE;
+    Head = 0;
+    Used = 0;
+    LeaveCriticalSection(&CS);
+}
+
+int CParallelDeflate::Deflate(ush* internAttr, int* compMethod, int compLevel,
+                              ush* flag, ullg* compLen, FWriteData writeFunc,
+                              FReadData readFunc, void* userData)
+{
+    CALL_STACK_MESSAGE2("CParallelDeflate::Deflate( , , %d, , , , , )", compLevel);
+    if (compLevel < 1 || compLevel > 9)
+        return 1;
+    // the same as CDeflate::lm_init() does
+    if (compLevel <= 2)
+        *flag |= FAST;
+    else if (compLevel >= 8)
+        *flag |= SLOW;
+    Level = compLevel;
+    *compLen = 0;
+    // the parts are allocated for the first large file
+    int i;
+    for (i = 0; i < ChunksCount; i++)
+    {
+        if (Chunks[i].In == NULL && (Chunks[i].In = (char*)malloc(PDEFLATE_CHUNK)) == NULL)
+            return IDS_LOWMEM;
+    }
+
+    int error = 0;
+    BOOL eof = FALSE;
+    BOOL first = TRUE;
+    while (!error)
+    {
+        // read ahead while there are free parts; the part read last waits until it is
+        // known whether the file continues
+        while (!eof && Used < ChunksCount)
+        {
+            CDeflateChunk* chunk = &Chunks[(Head + Used) % ChunksCount];
+            error = ReadPart(chunk, readFunc, userData, &eof);
+            if (error || chunk->InSize == 0)
+                break;
+            if (Used > 0)
+                Queue(&Chunks[(Head + Used - 1) % ChunksCount], FALSE);
+            EnterCriticalSection(&CS);
+            chunk->State = PDCHUNK_READ;
+            Used++;
+            LeaveCriticalSection(&CS);
+        }
+        if (error || Used == 0)
+            break;
+        CDeflateChunk* lastRead = &Chunks[(Head + Used - 1) % ChunksCount];
+        if (eof && lastRead->State == PDCHUNK_READ)
+            Queue(lastRead, TRUE);
+
+        // write the oldest part
+        CDeflateChunk* chunk = &Chunks[Head];
+        WaitChunk(chunk);
+        error = chunk->Error;
+        if (error)
+            break;
+        if (first)
+        {
+            // the beginning of the file tells best if it is a text
+            *internAttr = chunk->Attr;
+            first = FALSE;
+        }
+        if (chunk->OutSize > 0)
+            error = writeFunc(chunk->Out, chunk->OutSize, userData);
+        *compLen += chunk->OutSize;
+        EnterCriticalSection(&CS);
+        chunk->State = PDCHUNK_FREE;
+        Head = (Head + 1) % ChunksCount;
+        Used--;
+        LeaveCriticalSection(&CS);
+    }
+    Cancel();
+    return error;
+}
@@ -0,0 +1,136 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#define PDEFLATE_CHUNK (1024 * 1024)       // a file is compressed in parts of this size
+#define PDEFLATE_MIN_SIZE (4 * 1024 * 1024) // smaller files are compressed by a single CDeflate
+#define PDEFLATE_MAX_THREADS 16            // upper limit of worker threads
+#define PDEFLATE_READ_SIZE 0x10000         // the input is read in blocks of this size (progress)
+#define PDEFLATE_MAX_MEMBERS 64            // upper limit of small files compressed ahead (4 per thread)
+
+// states of a part
+#define PDCHUNK_FREE 0    // unused
+#define PDCHUNK_READ 1    // read, not given to the workers until it is known if it is the last one
+#define PDCHUNK_QUEUED 2  // waiting for a worker thread
+#define PDCHUNK_WORKING 3 // being compressed
+#define PDCHUNK_DONE 4    // compressed or failed (see Error)
+
+// states of a small file compressed ahead
+#define PDMEMBER_FREE 0    // unused
+#define PDMEMBER_QUEUED 1  // waiting for a worker thread
+#define PDMEMBER_WORKING 2 // being read and compressed
+#define PDMEMBER_DONE 3    // compressed or failed (see Data.Error)
+
+struct CDeflateChunk
+{
+    char* In; // PDEFLATE_CHUNK bytes of the file
+    unsigned InSize;
+    unsigned InPos; // read by the compressor so far
+    char* Out;      // compressed data
+    unsigned OutSize;
+    unsigned OutAlloc;
+    ush Attr;   // ASCII or BINARY, as found by the compressor
+    int Last;   // the part ends the file
+    int Error;  // error code of CDeflate::DeflateChunk
+    int State;  // PDCHUNK_XXX; changed only inside CParallelDeflate::CS
+};
+
+// small file compressed ahead by a worker thread (see CParallelDeflate::QueueMember)
+struct CDeflateMember
+{
+    int Index;          // index of the file in CZipPack::AddFiles
+    const char* Name;   // full name of the file
+    unsigned Size;      // size of the file when it was queued
+    int Level;          // compression level
+    ush Flag;           // GPF_DATADESCR given to CDeflate, FAST or SLOW added by it
+    int Method;         // DEFLATE, or STORE if CDeflate turned the file into a stored one
+    DWORD Crc;          // CRC of the data read
+    FILETIME LastWrite; // time of the last write of the file read
+    CDeflateChunk Data; // the whole file (In) and its compressed data (Out); State is not used
+    int State;          // PDMEMBER_XXX; changed only inside CParallelDeflate::CS
+};
+
+// Compresses a large file on worker threads (pigz without the shared dictionary):
+// the calling thread reads the file in parts of PDEFLATE_CHUNK bytes, each part is
+// deflated independently by its own CDeflate and the outputs are written in their
+// order. The parts are joined by empty stored blocks, the result is a single
+// deflate stream only slightly larger than the one from a single CDeflate.
+// Small files are compressed whole, several at once: the calling thread queues the
+// files it will pack next, a worker reads such file into memory and compresses it
+// and the calling thread then writes the result when it gets to the file. A worker
+// never asks the user anything, the file is packed the usual way if it cannot read
+// it (the calling thread then shows the error) or if the file changed meanwhile.
+class CParallelDeflate
+{
+public:
+    CParallelDeflate();
+    ~CParallelDeflate();
+
+    // returns the number of worker threads worth starting (1 = compress sequentially)
+    static int GetThreadCount();
+
+    // starts the worker threads; returns FALSE if files have to be compressed by CDeflate
+    BOOL Start();
+
+    // same as CDeflate::Deflate; the file is never turned into a stored one
+    int Deflate(ush* internAttr, int* compMethod, int compLevel,
+                ush* flag, ullg* compLen, FWriteData writeFunc,
+                FReadData readFunc, void* userData);
+
+    // queues a small file of 'size' bytes (below PDEFLATE_MIN_SIZE) packed as the file
+    // 'index' of the archive; 'flag' is the general purpose flag the file is going to be
+    // compressed with (only GPF_DATADESCR matters); returns FALSE if there is no room for
+    // it now (the memory for queued files is limited)
+    BOOL QueueMember(int index, const char* name, unsigned size, int level, ush flag);
+
+    // returns the compressed file 'index' (waits for it), NULL if the file was not queued
+    // or its reading or compression failed; the queued files of lower indexes are dropped
+    // (they were not packed); the member must be released by ReleaseMember()
+    CDeflateMember* GetMember(int index);
+
+    // frees the member returned by GetMember()
+    void ReleaseMember(CDeflateMember* member);
+
+private:
+    static unsigned WINAPI WorkerThreadBody(void* param);
+    static DWORD WINAPI WorkerThreadF(void* param);
+    void Work();
+
+    // FReadData and FWriteData of the workers, on CDeflateChunk
+    static int ReadChunk(char* buffer, unsigned size, int* error, void* user);
+    static int WriteChunk(char* buffer, unsigned size, void* user);
+
+    // reads and compresses a member on a worker thread; returns an error code (0 = success)
+    int CompressMember(CDeflate* deflate, CDeflateMember* member);
+    // waits until a worker finishes 'member'; 'drop' = a member no worker took is not compressed at all
+    void WaitMember(CDeflateMember* member, BOOL drop);
+    void FreeMember(CDeflateMember* member);
+
+    int ReadPart(CDeflateChunk* chunk, FReadData readFunc, void* userData, BOOL* eof);
+    void Queue(CDeflateChunk* chunk, BOOL last);
+    void WaitChunk(CDeflateChunk* chunk);
+    void Cancel();
+
+    int Level;
+
+    CDeflateChunk Chunks[2 * PDEFLATE_MAX_THREADS];
+    int ChunksCount;
+    int Head; // the oldest part, written next
+    int Used; // parts in use from Head on
+
+    CDeflateMember Members[PDEFLATE_MAX_MEMBERS];
+    int MembersCount;          // size of the ring of members
+    int MembersHead;           // the member of the lowest index
+    int MembersUsed;           // members in use from MembersHead on
+    unsigned MembersSize;      // sum of Size of the members in use
+    unsigned MembersSizeLimit; // more members are queued only while MembersSize is below
+
+    CRITICAL_SECTION CS; // guards the State of parts and members, Head, Used, MembersHead and MembersUsed
+                         // (changed only by the calling thread)
+    HANDLE WorkReady;    // semaphore, released once for each queued part or member
+    HANDLE ChunkDone;    // event, set whenever a worker finishes a part or a member
+    HANDLE Threads[PDEFLATE_MAX_THREADS];
+    int ThreadsCount;
+    volatile BOOL Terminate;
+};
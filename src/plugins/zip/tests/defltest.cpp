@@ -0,0 +1,296 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+//
+// ****************************************************************************
+// defltest - per-level tester of the ZIP packer's deflate (CDeflate: bits.cpp, deflate.cpp,
+// trees.cpp)
+//
+// The packer is compiled into this program. Every given file (or, without arguments, a generated
+// corpus: text, records, binary-like data and random bytes) is compressed at levels 1-9 by
+// CDeflate and by zlib (common\dep\zlib, raw deflate with the same window size) as the reference
+// implementation of the same algorithm. Each output of CDeflate is inflated back by zlib and must
+// give the input again. The compression ratio and speed (the best of several runs) of both are
+// printed for every level.
+//
+// Build (Visual Studio command prompt, in src\plugins\zip\tests):
+//   cl /nologo /O2 /EHsc /J /DNDEBUG /DCALLSTK_DISABLE /D_CRT_SECURE_NO_WARNINGS /I.. /I..\..\shared
+//      /I..\..\..\common\dep\zlib defltest.cpp ..\..\..\common\dep\zlib\adler32.c
+//      ..\..\..\common\dep\zlib\crc32.c ..\..\..\common\dep\zlib\deflate.c
+//      ..\..\..\common\dep\zlib\inffast.c ..\..\..\common\dep\zlib\inflate.c
+//      ..\..\..\common\dep\zlib\inftrees.c ..\..\..\common\dep\zlib\trees.c
+//      ..\..\..\common\dep\zlib\zutil.c
+//
+// Usage: defltest [file ...]
+
+#include "zlib.h"
+
+#include "precomp.h"
+
+#include "../bits.cpp"
+#include "../deflate.cpp"
+#include "../trees.cpp"
+
+static DWORD RandSeed = 1;
+
+static DWORD Rand()
+{
+    RandSeed = RandSeed * 1103515245 + 12345;
+    return RandSeed >> 8;
+}
+
+static double GetSeconds()
+{
+    LARGE_INTEGER c, f;
+    QueryPerformanceCounter(&c);
+    QueryPerformanceFrequency(&f);
+    return (double)c.QuadPart / (double)f.QuadPart;
+}
+
+struct CBuffer
+{
+    BYTE* Data;
+    DWORD Size;
+    DWORD Allocated;
+    DWORD ReadPos;
+};
+
+// CDeflate passes the same user data to both callbacks
+struct CStreams
+{
+    CBuffer* In;
+    CBuffer* Out;
+};
+
+static int ReadInput(char* buf, unsigned size, int* errorID, void* userData)
+{
+    CBuffer* in = ((CStreams*)userData)->In;
+    *errorID = 0;
+    DWORD count = in->Size - in->ReadPos;
+    if (count == 0)
+        return EOF;
+    if (count > size)
+        count = size;
+    memcpy(buf, in->Data + in->ReadPos, count);
+    in->ReadPos += count;
+    return (int)count;
+}
+
+static int WriteOutput(char* buf, unsigned size, void* userData)
+{
+    CBuffer* out = ((CStreams*)userData)->Out;
+    if (out->Size + size > out->Allocated)
+    {
+        DWORD allocated = 2 * (out->Size + size);
+        BYTE* data = (BYTE*)realloc(out->Data, allocated);
+        if (data == NULL)
+            return 1;
+        out->Data = data;
+        out->Allocated = allocated;
+    }
+    memcpy(out->Data + out->Size, buf, size);
+    out->Size += size;
+    return 0;
+}
+
+// compresses 'in' by CDeflate into 'out'; returns FALSE on error
+static BOOL PackDeflate(CDeflate* deflate, CBuffer* in, CBuffer* out, int level)
+{
+    in->ReadPos = 0;
+    out->Size = 0;
+    ush attr = (ush)UNKNOWN;
+    ush flag = 0;
+    int method = DEFLATE;
+    ullg compLen;
+    CStreams streams = {in, out};
+    return deflate->Deflate(&attr, &method, level, &flag, &compLen, WriteOutput, ReadInput, &streams) == 0 &&
+           method == DEFLATE && compLen == out->Size;
+}
+
+// compresses 'in' by zlib into 'out' (raw deflate, 32 KB window like CDeflate)
+static BOOL PackZlib(CBuffer* in, CBuffer* out, int level)
+{
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    if (deflateInit2(&strm, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return FALSE;
+    uLong bound = deflateBound(&strm, in->Size);
+    if (bound > out->Allocated)
+    {
+        free(out->Data);
+        out->Data = (BYTE*)malloc(bound);
+        out->Allocated = out->Data != NULL ? bound : 0;
+    }
+    strm.next_in = in->Data;
+    strm.avail_in = in->Size;
+    strm.next_out = out->Data;
+    strm.avail_out = out->Allocated;
+    int res = deflate(&strm, Z_FINISH);
+    out->Size = strm.total_out;
+    deflateEnd(&strm);
+    return res == Z_STREAM_END;
+}
+
+// inflates 'packed' by zlib and compares it with 'original'
+static BOOL CheckByZlib(CBuffer* packed, CBuffer* original, BYTE* unpacked)
+{
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    if (inflateInit2(&strm, -15) != Z_OK)
+        return FALSE;
+    strm.next_in = packed->Data;
+    strm.avail_in = packed->Size;
+    strm.next_out = unpacked;
+    strm.avail_out = original->Size + 1;
+    int res = inflate(&strm, Z_FINISH);
+    BOOL ok = res == Z_STREAM_END && strm.total_out == original->Size &&
+              memcmp(unpacked, original->Data, original->Size) == 0;
+    inflateEnd(&strm);
+    return ok;
+}
+
+static void Generate(CBuffer* buf, int kind, DWORD size)
+{
+    static const char* words[] = {"the", "of", "int", "return", "file", "directory", "if (", "else",
+                                  "Salamander", "archive", "{", "}", "    ", "\r\n", "NULL", "size", "="};
+    buf->Data = (BYTE*)malloc(size);
+    buf->Size = buf->Allocated = buf->Data != NULL ? size : 0;
+    DWORD pos = 0;
+    while (pos < buf->Size)
+    {
+        char piece[100];
+        int len;
+        switch (kind)
+        {
+        case 0: // text
+            len = sprintf(piece, "%s ", words[Rand() % ARRAYSIZE(words)]);
+            break;
+        case 1: // records
+            len = sprintf(piece, "%06u;%s;%u.%02u;2023-%02u-%02u\r\n", pos / 40, words[Rand() % 8], Rand() % 1000,
+                          Rand() % 100, 1 + Rand() % 12, 1 + Rand() % 28);
+            break;
+        case 2: // binary-like: small values, repeated sequences
+        {
+            len = 1 + Rand() % 16;
+            int i;
+            if (pos > 4096 && Rand() % 3 == 0)
+                memcpy(piece, buf->Data + pos - len - Rand() % 4096, len);
+            else
+            {
+                for (i = 0; i < len; i++)
+                    piece[i] = (char)(Rand() % 4 == 0 ? Rand() : Rand() % 8);
+            }
+            break;
+        }
+        default: // random
+            len = 4;
+            *(DWORD*)piece = Rand() ^ (Rand() << 16);
+            break;
+        }
+        if ((DWORD)len > buf->Size - pos)
+            len = buf->Size - pos;
+        memcpy(buf->Data + pos, piece, len);
+        pos += len;
+    }
+}
+
+static BOOL LoadFile(CBuffer* buf, const char* name)
+{
+    memset(buf, 0, sizeof(CBuffer));
+    FILE* f = fopen(name, "rb");
+    if (f == NULL)
+        return FALSE;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    buf->Data = (BYTE*)malloc(size > 0 ? size : 1);
+    if (buf->Data != NULL)
+        buf->Size = buf->Allocated = (DWORD)fread(buf->Data, 1, size, f);
+    fclose(f);
+    return buf->Data != NULL;
+}
+
+static int TestFile(CDeflate* deflate, CBuffer* in, const char* name)
+{
+    CBuffer out;
+    memset(&out, 0, sizeof(out));
+    BYTE* unpacked = (BYTE*)malloc(in->Size + 1);
+    int failures = 0;
+    int rounds = in->Size < 4 * 1024 * 1024 ? 5 : 2;
+    double mb = in->Size / (1024.0 * 1024.0);
+    int level;
+    for (level = 1; level <= 9; level++)
+    {
+        double timeDeflate = 0, timeZlib = 0;
+        DWORD sizeDeflate = 0, sizeZlib = 0;
+        int round;
+        for (round = 0; round < rounds; round++)
+        {
+            double t = GetSeconds();
+            BOOL ok = PackDeflate(deflate, in, &out, level);
+            t = GetSeconds() - t;
+            if (round == 0 || t < timeDeflate)
+                timeDeflate = t;
+            sizeDeflate = out.Size;
+            if (round == 0 && (!ok || unpacked == NULL || !CheckByZlib(&out, in, unpacked)))
+            {
+                printf("MISMATCH (%s, level %d): the output of CDeflate does not inflate to the input\n", name, level);
+                failures++;
+            }
+
+            t = GetSeconds();
+            PackZlib(in, &out, level);
+            t = GetSeconds() - t;
+            if (round == 0 || t < timeZlib)
+                timeZlib = t;
+            sizeZlib = out.Size;
+        }
+        printf("%-16s %5d %10.3f%% %10.1f %10.3f%% %10.1f\n", name, level,
+               in->Size > 0 ? 100.0 * sizeDeflate / in->Size : 0.0, timeDeflate > 0 ? mb / timeDeflate : 0.0,
+               in->Size > 0 ? 100.0 * sizeZlib / in->Size : 0.0, timeZlib > 0 ? mb / timeZlib : 0.0);
+    }
+    if (unpacked != NULL)
+        free(unpacked);
+    if (out.Data != NULL)
+        free(out.Data);
+    return failures;
+}
+
+int main(int argc, char* argv[])
+{
+    CDeflate* deflate = new CDeflate;
+    printf("%-16s %5s %11s %10s %11s %10s\n", "file", "level", "CDeflate", "MB/s", "zlib", "MB/s");
+    int failures = 0;
+    if (argc > 1)
+    {
+        int i;
+        for (i = 1; i < argc; i++)
+        {
+            CBuffer in;
+            if (!LoadFile(&in, argv[i]))
+            {
+                printf("Unable to read %s.\n", argv[i]);
+                failures++;
+                continue;
+            }
+            const char* name = strrchr(argv[i], '\\');
+            failures += TestFile(deflate, &in, name != NULL ? name + 1 : argv[i]);
+            free(in.Data);
+        }
+    }
+    else
+    {
+        static const char* kinds[] = {"(text)", "(records)", "(binary)", "(random)"};
+        int kind;
+        for (kind = 0; kind < (int)ARRAYSIZE(kinds); kind++)
+        {
+            CBuffer in;
+            Generate(&in, kind, 8 * 1024 * 1024);
+            failures += TestFile(deflate, &in, kinds[kind]);
+            free(in.Data);
+        }
+    }
+    delete deflate;
+    printf("%d mismatches\n", failures);
+    return failures == 0 ? 0 : 1;
+}
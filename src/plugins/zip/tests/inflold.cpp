@@ -0,0 +1,756 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+//
+// ****************************************************************************
+// inflold - the decoder of inflate.cpp before the table driven one (version 1.0b, the huft
+// tables built by huft_build()), kept as the reference for infltest
+//
+// It is included into infltest.cpp behind ../inflate.cpp (huft_build(), huft_free(), mask_bits
+// and NextByte() are shared with explode and stay there). The fixed trees and the tables of the
+// Deflate/Deflate64 mode were kept in CDecompressionObject, here they are in Trees. The calls
+// are qualified, the functions of inflate.cpp have the same names.
+
+namespace OldInflate
+{
+
+struct CTrees
+{
+    struct huft* fixed_tl64;
+    struct huft* fixed_td64;
+    int fixed_bl64,
+        fixed_bd64;
+    struct huft* fixed_tl32;
+    struct huft* fixed_td32;
+    int fixed_bl32,
+        fixed_bd32;
+
+    struct huft* fixed_tl;
+    struct huft* fixed_td;
+    int fixed_bl,
+        fixed_bd;
+
+    const ush* cplens;
+    const uch* cplext;
+    const uch* cpdext;
+};
+
+static CTrees Trees;
+
+
+/* Tables for deflate from PKZIP's appnote.txt. */
+/* Order of the bit length code lengths */
+static const unsigned border[] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+/* Copy lengths for literal codes 257..285 */
+static const ush cplens64[] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 3, 0, 0};
+/* For Deflate64, the code 285 is defined differently. */
+static const ush cplens32[] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258, 0, 0};
+/* note: see note #13 above about the 258 in this list. */
+
+/* Extra bits for literal codes 257..285 */
+static const uch cplext64[] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 16, INVALID_CODE, INVALID_CODE};
+static const uch cplext32[] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0, INVALID_CODE, INVALID_CODE};
+
+/* Copy offsets for distance codes 0..29 (0..31 for Deflate64) */
+static const ush cpdist[] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577, 32769, 49153};
+
+/* Extra bits for distance codes 0..29 (0..31 for Deflate64) */
+static const uch cpdext64[] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11,
+    12, 12, 13, 13, 14, 14};
+static const uch cpdext32[] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11,
+#ifdef PKZIP_BUG_WORKAROUND
+    12, 12, 13, 13, INVALID_CODE, INVALID_CODE};
+#else
+    12, 12, 13, 13};
+#endif
+
+#ifdef PKZIP_BUG_WORKAROUND
+#define MAXLITLENS 288
+#else
+#define MAXLITLENS 286
+#endif
+#ifdef PKZIP_BUG_WORKAROUND
+#define MAXDISTS 32
+#else
+#define MAXDISTS 30
+#endif
+
+
+/* Macros for inflate() bit peeking and grabbing.
+   The usage is:
+
+        NEEDBITS(j)
+        x = b & mask_bits[j];
+        DUMPBITS(j)
+
+   where NEEDBITS makes sure that b has at least j bits in it, and
+   DUMPBITS removes the bits from b.  The macros use the variable k
+   for the number of bits in b.  Normally, b and k are register
+   variables for speed and are initialized at the begining of a
+   routine that uses these macros from a global bit buffer and count.
+
+   In order to not ask for more bits than there are in the compressed
+   stream, the Huffman tables are constructed to only ask for just
+   enough bits to make up the end-of-block code (value 256).  Then no
+   bytes need to be "returned" to the buffer at the end of the last
+   block.  See the huft_build() routine.
+ */
+
+#ifndef CHECK_INPUT_ERROR
+#define NEEDBITS(n, decomp) \
+    { \
+        while (k < (n)) \
+        { \
+            b |= ((ulg)NextByte((decomp))) << k; \
+            k += 8; \
+        } \
+    }
+#else
+#define NEEDBITS(n, decomp) \
+    { \
+        while (k < (n)) \
+        { \
+            b |= ((ulg)NextByte((decomp))) << k; \
+            k += 8; \
+            if ((decomp)->Input->Error) \
+            { \
+                TRACE_I("NEEDBITS input error"); \
+                return 4; \
+            } \
+        } \
+    }
+#endif
+
+#define DUMPBITS(n) \
+    { \
+        b >>= (n); \
+        k -= (n); \
+    }
+
+
+static const int lbits = 9; /* bits in base literal/length lookup table */
+static const int dbits = 6; /* bits in base distance lookup table */
+
+
+/* inflate (decompress) the codes in a deflated (compressed) block.
+   Return an error code or zero if it all goes ok. */
+int inflate_codes(CDecompressionObject* decompress,
+                  struct huft* tl, //literal/length
+                  struct huft* td, //distance decoder tables
+                  int bl, int bd)  //number of bits decoded by tl[] and td[]
+{
+    unsigned e;      /* table entry flag/number of extra bits */
+    unsigned n, d;   /* length and index for copy */
+    unsigned w;      /* current window position */
+    struct huft* t;  /* pointer to table entry */
+    unsigned ml, md; /* masks for bl and bd bits */
+    ulg b;           /* bit buffer */
+    unsigned k;      /* number of bits in bit buffer */
+
+    uch* redirSlide;
+    unsigned wsize;
+
+    /* make local copies of globals */
+    b = (ulg)decompress->Input->BitBuf; /* initialize bit buffer */
+    k = decompress->Input->BitCount;
+    w = decompress->Output->WinPos; /* initialize window position */
+    wsize = decompress->Output->WinSize;
+    redirSlide = decompress->Output->SlideWin;
+
+    /* inflate the coded data */
+    ml = mask_bits[bl]; /* precompute masks for speed */
+    md = mask_bits[bd];
+    while (1) /* do until end of block */
+    {
+        NEEDBITS((unsigned)bl, decompress)
+        t = tl + ((unsigned)b & ml);
+        while (1)
+        {
+            DUMPBITS(t->b)
+
+            if ((e = t->e) == 32) /* then it's a literal */
+            {
+                redirSlide[w++] = (uch)t->v.n;
+                if (w == wsize)
+                {
+                    if (decompress->Output->Flush(w, decompress))
+                    {
+                        TRACE_I("inflate_codes: flush returned error");
+                        return 5;
+                    }
+                    w = 0;
+                }
+                break;
+            }
+
+            if (e < 31) /* then it's a length */
+            {
+                /* get length of block to copy */
+                NEEDBITS(e, decompress)
+                n = t->v.n + ((unsigned)b & mask_bits[e]);
+                DUMPBITS(e)
+
+                /* decode distance of block to copy */
+                NEEDBITS((unsigned)bd, decompress)
+                t = td + ((unsigned)b & md);
+                while (1)
+                {
+                    DUMPBITS(t->b)
+                    if ((e = t->e) < 32)
+                        break;
+                    if (IS_INVALID_CODE(e))
+                    {
+                        TRACE_E("inflate_codes: invalid code");
+                        return 1;
+                    }
+                    e &= 31;
+                    NEEDBITS(e, decompress)
+                    t = t->v.t + ((unsigned)b & mask_bits[e]);
+                }
+                NEEDBITS(e, decompress)
+                d = w - t->v.n - ((unsigned)b & mask_bits[e]);
+                DUMPBITS(e)
+
+                /* do the copy */
+                do
+                {
+                    e = wsize - ((d &= (wsize - 1)) > w ? d : w);
+                    if (e > n)
+                        e = n;
+                    n -= e;
+#ifndef NOMEMCPY
+                    if (w - d >= e)
+                    /* (this test assumes unsigned comparison) */
+                    {
+                        memmove(redirSlide + w, redirSlide + d, e);
+                        w += e;
+                        d += e;
+                    }
+                    else /* do it slowly to avoid memcpy() overlap */
+#endif                   /* !NOMEMCPY */
+                        do
+                        {
+                            redirSlide[w++] = redirSlide[d++];
+                        } while (--e);
+                    if (w == wsize)
+                    {
+                        if (decompress->Output->Flush(w, decompress))
+                        {
+                            TRACE_I("inflate_codes: flush returned error");
+                            return 5;
+                        }
+                        w = 0;
+                    }
+                } while (n);
+                break;
+            }
+
+            if (e == 31) /* it's the EOB signal */
+            {
+                /* sorry for this goto, but we have to exit two loops at once */
+                goto cleanup_decode;
+            }
+
+            if (IS_INVALID_CODE(e))
+            {
+                TRACE_E("inflate_codes: invalid code");
+                return 1;
+            }
+
+            e &= 31;
+            NEEDBITS(e, decompress)
+            t = t->v.t + ((unsigned)b & mask_bits[e]);
+        }
+    }
+cleanup_decode:
+
+    /* restore the globals from the locals */
+    decompress->Output->WinPos = w; /* restore global window pointer */
+    decompress->Input->BitBuf = b;  /* restore global bit buffer */
+    decompress->Input->BitCount = k;
+
+    /* done */
+    return 0;
+}
+
+
+// "decompress" an inflated type 0 (stored) block.
+int inflate_stored(CDecompressionObject* decompress)
+{
+    unsigned n; // number of bytes in block
+    ulg b;      // bit buffer
+    unsigned k; // number of bits in bit buffer
+    unsigned outBytes,
+        inBytes; //temporary variables
+
+    // make local copies of globals
+    b = (ulg)decompress->Input->BitBuf; // initialize bit buffer
+    k = decompress->Input->BitCount;
+
+    // go to byte boundary
+    n = k & 7;
+    DUMPBITS(n);
+
+    // get the length and its complement
+    NEEDBITS(16, decompress)
+    n = ((unsigned)b & 0xffff);
+    DUMPBITS(16)
+    NEEDBITS(16, decompress)
+    if (n != (unsigned)((~b) & 0xffff))
+        return 1; // error in compressed data
+    DUMPBITS(16)
+
+    /* old copy routine, the new should be faster (I hope so)
+  // read and output the compressed data
+  while (n--)
+  {
+    NEEDBITS(8, decompress)
+    decompress->Output->SlideWin[w++] = (uch)b;
+    if (w == decompress->Output->WinSize)
+    {
+      decompress->Output->Flush(w, decompress);
+      w = 0;
+    }
+    DUMPBITS(8, decompress)
+  }
+*/
+
+    //copy bytes from intup to the output
+    while (n)
+    {
+        if (n <= decompress->Output->WinSize - decompress->Output->WinPos)
+            outBytes = n;
+        else
+            outBytes = decompress->Output->WinSize - decompress->Output->WinPos;
+
+        n -= outBytes;
+        while (outBytes)
+        {
+            if (outBytes <= decompress->Input->BytesLeft)
+                inBytes = outBytes;
+            else
+                inBytes = decompress->Input->BytesLeft;
+
+            memcpy(decompress->Output->SlideWin + decompress->Output->WinPos,
+                   decompress->Input->NextByte, inBytes);
+            decompress->Input->NextByte += inBytes;
+            decompress->Input->BytesLeft -= inBytes;
+            decompress->Output->WinPos += inBytes;
+            outBytes -= inBytes;
+            if (!decompress->Input->BytesLeft && outBytes)
+            {
+                decompress->Input->Refill(decompress);
+                if (decompress->Input->Error)
+                {
+                    TRACE_I("inflate_stored: input error");
+                    return 4;
+                }
+            }
+        }
+
+        if (decompress->Output->WinPos == decompress->Output->WinSize)
+        {
+            if (decompress->Output->Flush(decompress->Output->WinPos, decompress))
+            {
+                TRACE_I("inflate_stored: flush returned error");
+                return 5;
+            }
+            decompress->Output->WinPos = 0;
+        }
+    }
+
+    // restore the globals from the locals
+    decompress->Input->BitBuf = b; // restore global bit buffer
+    decompress->Input->BitCount = k;
+    return 0;
+}
+
+// decompress an inflated type 1 (fixed Huffman codes) block.  We should
+// either replace this with a custom decoder, or at least precompute the
+// Huffman tables.
+int inflate_fixed(CDecompressionObject* decompress)
+{
+    // if first time, set up tables for fixed blocks
+    if (Trees.fixed_tl == (struct huft*)NULL)
+    {
+        int i;           // temporary variable
+        unsigned l[288]; // length list for huft_build
+
+        // literal table
+        for (i = 0; i < 144; i++)
+            l[i] = 8;
+        for (; i < 256; i++)
+            l[i] = 9;
+        for (; i < 280; i++)
+            l[i] = 7;
+        for (; i < 288; i++) // make a complete, but wrong code set
+            l[i] = 8;
+        Trees.fixed_bl = 7;
+        if ((i = huft_build(decompress, l, 288, 257,
+                            Trees.cplens, Trees.cplext,
+                            &Trees.fixed_tl, &Trees.fixed_bl)) != 0)
+        {
+            Trees.fixed_tl = (struct huft*)NULL;
+            TRACE_E("inflate_fixed: error in huft_build");
+            return i;
+        }
+
+        // distance table
+        for (i = 0; i < MAXDISTS; i++) // make an incomplete code set
+            l[i] = 5;
+        Trees.fixed_bd = 5;
+        if ((i = huft_build(decompress, l, MAXDISTS, 0, cpdist, Trees.cpdext,
+                            &Trees.fixed_td, &Trees.fixed_bd)) > 1)
+        {
+            huft_free(decompress, Trees.fixed_tl);
+            Trees.fixed_tl = (struct huft*)NULL;
+            TRACE_E("inflate_fixed: error in huft_build");
+            return i;
+        }
+    }
+
+    // decompress until an end-of-block code
+    return OldInflate::inflate_codes(decompress, Trees.fixed_tl, Trees.fixed_td,
+                         Trees.fixed_bl, Trees.fixed_bd) != 0;
+}
+
+/* decompress an inflated type 2 (dynamic Huffman codes) block. */
+int inflate_dynamic(CDecompressionObject* decompress)
+{
+    int i; /* temporary variables */
+    unsigned j;
+    unsigned l;                         /* last length */
+    unsigned m;                         /* mask for bit lengths table */
+    unsigned n;                         /* number of lengths to get */
+    struct huft* tl;                    /* literal/length code table */
+    struct huft* td;                    /* distance code table */
+    int bl;                             /* lookup bits for tl */
+    int bd;                             /* lookup bits for td */
+    unsigned nb;                        /* number of bit length codes */
+    unsigned nl;                        /* number of literal/length codes */
+    unsigned nd;                        /* number of distance codes */
+    unsigned ll[MAXLITLENS + MAXDISTS]; /* lit./length and distance code lengths */
+    ulg b;                              /* bit buffer */
+    unsigned k;                         /* number of bits in bit buffer */
+
+    /* make local bit buffer */
+    b = (ulg)decompress->Input->BitBuf;
+    k = decompress->Input->BitCount;
+
+    /* read in table lengths */
+    NEEDBITS(5, decompress)
+    nl = 257 + ((unsigned)b & 0x1f); /* number of literal/length codes */
+    DUMPBITS(5)
+    NEEDBITS(5, decompress)
+    nd = 1 + ((unsigned)b & 0x1f); /* number of distance codes */
+    DUMPBITS(5)
+    NEEDBITS(4, decompress)
+    nb = 4 + ((unsigned)b & 0xf); /* number of bit length codes */
+    DUMPBITS(4)
+    if (nl > MAXLITLENS || nd > MAXDISTS)
+        return 1; /* bad lengths */
+
+    /* read in bit-length-code lengths */
+    for (j = 0; j < nb; j++)
+    {
+        NEEDBITS(3, decompress)
+        ll[border[j]] = (unsigned)b & 7;
+        DUMPBITS(3)
+    }
+    for (; j < 19; j++)
+        ll[border[j]] = 0;
+
+    /* build decoding table for trees--single level, 7 bit lookup */
+    bl = 7;
+    i = huft_build(decompress, ll, 19, 19, NULL, NULL, &tl, &bl);
+    if (bl == 0) /* no bit lengths */
+        i = 1;
+    if (i)
+    {
+        if (i == 1)
+            huft_free(decompress, tl);
+        TRACE_E("inflate_dynamic: error in huft_build");
+        return i; /* incomplete code set */
+    }
+
+    /* read in literal and distance code lengths */
+    n = nl + nd;
+    m = mask_bits[bl];
+    i = l = 0;
+    while ((unsigned)i < n)
+    {
+        NEEDBITS((unsigned)bl, decompress)
+        j = (td = tl + ((unsigned)b & m))->b;
+        DUMPBITS(j)
+        j = td->v.n;
+        if (j < 16)          /* length of code in bits (0..15) */
+            ll[i++] = l = j; /* save last length in l */
+        else if (j == 16)    /* repeat last length 3 to 6 times */
+        {
+            NEEDBITS(2, decompress)
+            j = 3 + ((unsigned)b & 3);
+            DUMPBITS(2)
+            if ((unsigned)i + j > n)
+            {
+                TRACE_E("inflate_dynamic: incomplete code");
+                return 1;
+            }
+            while (j--)
+                ll[i++] = l;
+        }
+        else if (j == 17) /* 3 to 10 zero length codes */
+        {
+            NEEDBITS(3, decompress)
+            j = 3 + ((unsigned)b & 7);
+            DUMPBITS(3)
+            if ((unsigned)i + j > n)
+            {
+                TRACE_E("inflate_dynamic: incomplete code");
+                return 1;
+            }
+            while (j--)
+                ll[i++] = 0;
+            l = 0;
+        }
+        else /* j == 18: 11 to 138 zero length codes */
+        {
+            NEEDBITS(7, decompress)
+            j = 11 + ((unsigned)b & 0x7f);
+            DUMPBITS(7)
+            if ((unsigned)i + j > n)
+            {
+                TRACE_E("inflate_dynamic: incomplete code");
+                return 1;
+            }
+            while (j--)
+                ll[i++] = 0;
+            l = 0;
+        }
+    }
+
+    /* free decoding table for trees */
+    huft_free(decompress, tl);
+
+    /* restore the global bit buffer */
+    decompress->Input->BitBuf = b;
+    decompress->Input->BitCount = k;
+
+    /* build the decoding tables for literal/length and distance codes */
+    bl = lbits;
+    i = huft_build(decompress, ll, nl, 257,
+                   Trees.cplens, Trees.cplext, &tl, &bl);
+    if (bl == 0) /* no literals or lengths */
+        i = 1;
+    if (i)
+    {
+        if (i == 1)
+        {
+            TRACE_E("inflate_dynamic: incomplete l-tree");
+            huft_free(decompress, tl);
+        }
+        TRACE_E("inflate_dynamic: error in huft_build");
+        return i; /* incomplete code set */
+    }
+
+    bd = dbits;
+    i = huft_build(decompress, ll + nl, nd, 0, cpdist,
+                   Trees.cpdext, &td, &bd);
+#ifdef PKZIP_BUG_WORKAROUND
+    if (i == 1)
+    {
+        i = 0;
+        TRACE_W("inflate_dynamic: incomplete d-tree, PKZIP_BUG_WORKAROUND -> continue");
+    }
+#endif
+    if (bd == 0 && nl > 257) /* lengths but no distances */
+        i = 1;
+    if (i)
+    {
+        if (i == 1)
+        {
+            TRACE_E("inflate_dynamic: incomplete d-tree");
+            huft_free(decompress, td);
+        }
+        huft_free(decompress, tl);
+        TRACE_E("inflate_dynamic: error in huft_build");
+        return i;
+    }
+
+    /* decompress until an end-of-block code */
+    if ((i = OldInflate::inflate_codes(decompress, tl, td, bl, bd)) != 0)
+        TRACE_I("inflate_dynamic: error in inflate_codes");
+
+    /* free the decoding tables, return */
+    huft_free(decompress, tl);
+    huft_free(decompress, td);
+    return i;
+}
+
+/* decompress an inflated block */
+int inflate_block(CDecompressionObject* decompress, int* e)
+//  int *e;
+{
+    unsigned t; /* block type */
+    ulg b;      /* bit buffer */
+    unsigned k; /* number of bits in bit buffer */
+
+    /* make local bit buffer */
+    b = (ulg)decompress->Input->BitBuf;
+    k = decompress->Input->BitCount;
+
+    /* read in last block bit */
+    NEEDBITS(1, decompress)
+    *e = (int)b & 1;
+    DUMPBITS(1)
+
+    /* read in block type */
+    NEEDBITS(2, decompress)
+    t = (unsigned)b & 3;
+    DUMPBITS(2)
+
+    /* restore the global bit buffer */
+    decompress->Input->BitBuf = b;
+    decompress->Input->BitCount = k;
+
+    /* inflate that block type */
+    if (t == 2)
+        return OldInflate::inflate_dynamic(decompress);
+    if (t == 0)
+        return OldInflate::inflate_stored(decompress);
+    if (t == 1)
+        return OldInflate::inflate_fixed(decompress);
+
+    TRACE_E("inflate_block: bad block type");
+    /* bad block type */
+    return 2;
+}
+
+//decompress an inflated entry
+int Inflate(CDecompressionObject* decompress, int deflate64)
+{
+    CALL_STACK_MESSAGE2("Inflate( , int %d)", deflate64);
+    int e; /* last block flag */
+    int r; /* result code */
+
+    /*
+#ifdef DEBUG
+  unsigned h = 0;       // maximum struct huft's malloc'ed
+#endif
+*/
+
+    /* initialize window, bit buffer */
+    decompress->Output->WinPos = 0;
+    decompress->Input->BitCount = 0;
+    decompress->Input->BitBuf = 0;
+
+    if (deflate64)
+    {
+        Trees.cplens = cplens64;
+        Trees.cplext = cplext64;
+        Trees.cpdext = cpdext64;
+        Trees.fixed_tl = Trees.fixed_tl64;
+        Trees.fixed_bl = Trees.fixed_bl64;
+        Trees.fixed_td = Trees.fixed_td64;
+        Trees.fixed_bd = Trees.fixed_bd64;
+    }
+    else
+    {
+        Trees.cplens = cplens32;
+        Trees.cplext = cplext32;
+        Trees.cpdext = cpdext32;
+        Trees.fixed_tl = Trees.fixed_tl32;
+        Trees.fixed_bl = Trees.fixed_bl32;
+        Trees.fixed_td = Trees.fixed_td32;
+        Trees.fixed_bd = Trees.fixed_bd32;
+    }
+
+    /* decompress until the last block */
+    do
+    {
+        /*
+#ifdef DEBUG
+    G.hufts = 0;
+#endif
+*/
+        if ((r = OldInflate::inflate_block(decompress, &e)) != 0)
+        {
+            TRACE_I("Inflate: error in inflate_block");
+            break;
+        }
+        /*
+#ifdef DEBUG
+    if (G.hufts > h)
+      h = G.hufts;
+#endif
+*/
+    } while (!e);
+
+    if (deflate64)
+    {
+        Trees.fixed_tl64 = Trees.fixed_tl;
+        Trees.fixed_bl64 = Trees.fixed_bl;
+        Trees.fixed_td64 = Trees.fixed_td;
+        Trees.fixed_bd64 = Trees.fixed_bd;
+    }
+    else
+    {
+        Trees.fixed_tl32 = Trees.fixed_tl;
+        Trees.fixed_bl32 = Trees.fixed_bl;
+        Trees.fixed_td32 = Trees.fixed_td;
+        Trees.fixed_bd32 = Trees.fixed_bd;
+    }
+
+    if (r == 0)
+    {
+        /* flush out remaining data in sliding window */
+        if (decompress->Output->Flush(decompress->Output->WinPos,
+                                      decompress))
+        {
+            TRACE_I("Inflate: flush returned error");
+            return 5;
+        }
+    }
+
+    /* return success */
+    //  Trace((stderr, "\n%u bytes in Huffman tables (%d/entry)\n",
+    //         h * sizeof(struct huft), sizeof(struct huft)));
+    return r;
+}
+
+int FreeFixedHufman(CDecompressionObject* decompress)
+{
+    if (Trees.fixed_tl64 != (struct huft*)NULL)
+    {
+        huft_free(decompress, Trees.fixed_td64);
+        huft_free(decompress, Trees.fixed_tl64);
+        Trees.fixed_td64 = Trees.fixed_tl64 = (struct huft*)NULL;
+    }
+    if (Trees.fixed_tl32 != (struct huft*)NULL)
+    {
+        huft_free(decompress, Trees.fixed_td32);
+        huft_free(decompress, Trees.fixed_tl32);
+        Trees.fixed_td32 = Trees.fixed_tl32 = (struct huft*)NULL;
+    }
+    return 0;
+}
+#undef NEEDBITS
+#undef DUMPBITS
+
+} // namespace OldInflate
@@ -0,0 +1,513 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+//
+// ****************************************************************************
+// infltest - fuzz tester and benchmark of the ZIP unpacker's inflate (inflate.cpp)
+//
+// The table driven decoder of inflate.cpp and the huft decoder it replaced (inflold.cpp) are
+// compiled into this program. Streams packed by zlib (common\dep\zlib, all levels and
+// strategies) and streams written here with fixed codes and stored blocks (long Deflate64
+// lengths and distances included) are decoded by both in Deflate and Deflate64 mode, through
+// input buffers of various sizes. Both must return the same result and the same data, which
+// must be the original data where it is known. Then each stream is damaged a few times (flipped
+// bits, overwritten bytes, cut end) and both decoders must still agree: success or failure and
+// all data they flushed. At the end both are measured on big streams like those unpacked from
+// archives (16 KB input buffer, 64 KB window as in CZipUnpack::InflateFile).
+//
+// Build (Visual Studio command prompt, in src\plugins\zip\tests):
+//   cl /nologo /O2 /EHsc /J /DNDEBUG /DCALLSTK_DISABLE /D_CRT_SECURE_NO_WARNINGS /I.. /I..\..\shared
+//      /I..\..\..\common\dep\zlib infltest.cpp ..\..\..\common\dep\zlib\adler32.c
+//      ..\..\..\common\dep\zlib\crc32.c ..\..\..\common\dep\zlib\deflate.c
+//      ..\..\..\common\dep\zlib\inffast.c ..\..\..\common\dep\zlib\inflate.c
+//      ..\..\..\common\dep\zlib\inftrees.c ..\..\..\common\dep\zlib\trees.c
+//      ..\..\..\common\dep\zlib\zutil.c
+//
+// Usage: infltest [iterations [benchmark_MB]]
+
+#include "zlib.h"
+
+#include "precomp.h"
+
+#include "../memapi.cpp"
+#include "../inflate.cpp"
+#include "inflold.cpp"
+
+#define TEST_WINDOW_SIZE (64 * 1024)  // SLIDE_WINDOW_SIZE of the plugin
+#define TEST_INBUFFER_SIZE (16 * 1024) // DECOMPRESS_INBUFFER_SIZE of the plugin
+
+static DWORD RandSeed = 1;
+
+static DWORD Rand()
+{
+    RandSeed = RandSeed * 1103515245 + 12345;
+    return RandSeed >> 8;
+}
+
+static double GetSeconds()
+{
+    LARGE_INTEGER c, f;
+    QueryPerformanceCounter(&c);
+    QueryPerformanceFrequency(&f);
+    return (double)c.QuadPart / (double)f.QuadPart;
+}
+
+struct CBuffer
+{
+    BYTE* Data;
+    DWORD Size;
+    DWORD Allocated;
+};
+
+static BOOL Append(CBuffer* buf, const BYTE* data, DWORD size)
+{
+    if (buf->Size + size > buf->Allocated)
+    {
+        DWORD allocated = 2 * (buf->Size + size);
+        BYTE* newData = (BYTE*)realloc(buf->Data, allocated);
+        if (newData == NULL)
+            return FALSE;
+        buf->Data = newData;
+        buf->Allocated = allocated;
+    }
+    memcpy(buf->Data + buf->Size, data, size);
+    buf->Size += size;
+    return TRUE;
+}
+
+// input and output of one decoding, the user data of the decompression object
+struct CTestData
+{
+    const BYTE* In;
+    DWORD InSize;
+    DWORD InPos;
+    DWORD Chunk;  // number of bytes given by one Refill (the size of the input buffer)
+    BYTE* Buffer; // input buffer; behind an unsuccessful Refill the old decoder reads one more byte
+    CBuffer* Out;
+    DWORD OutLimit; // damaged streams can code a lot of data
+};
+
+// like Refill() of extract.cpp, including the error at the end of data
+static void TestRefill(CDecompressionObject* decompress)
+{
+    CTestData* data = (CTestData*)decompress->UserData;
+    if (data->InPos == data->InSize)
+    {
+        decompress->Input->Error = 1;
+        return;
+    }
+    DWORD count = data->InSize - data->InPos;
+    if (count > data->Chunk)
+        count = data->Chunk;
+    memcpy(data->Buffer, data->In + data->InPos, count);
+    data->InPos += count;
+    decompress->Input->NextByte = data->Buffer;
+    decompress->Input->BytesLeft = count;
+}
+
+static int TestFlush(unsigned bytes, CDecompressionObject* decompress)
+{
+    CTestData* data = (CTestData*)decompress->UserData;
+    if (data->Out->Size + bytes > data->OutLimit)
+        return 1;
+    return Append(data->Out, decompress->Output->SlideWin, bytes) ? 0 : 1;
+}
+
+static HANDLE Heap;
+static CInflateTables* Tables; // kept between the calls of the new decoder like in CZipUnpack
+static BYTE Window[TEST_WINDOW_SIZE];
+
+// decodes 'in' by the old or the new decoder into 'out'; returns the result of Inflate()
+static int Decode(BOOL old, const CBuffer* in, DWORD chunk, int deflate64, CBuffer* out, DWORD outLimit)
+{
+    CTestData data;
+    data.In = in->Data;
+    data.InSize = in->Size;
+    data.InPos = 0;
+    data.Chunk = chunk;
+    data.Buffer = (BYTE*)malloc(chunk + 16);
+    data.Out = out;
+    data.OutLimit = outLimit;
+    out->Size = 0;
+
+    CInputManager input;
+    COutputManager output;
+    CDecompressionObject decompress;
+    input.NextByte = data.Buffer;
+    input.BytesLeft = 0;
+    input.Error = 0;
+    input.Refill = TestRefill;
+    memset(Window, 0, sizeof(Window)); // damaged streams can refer behind the start of data
+    output.SlideWin = Window;
+    output.WinSize = TEST_WINDOW_SIZE;
+    output.Flush = TestFlush;
+    decompress.Input = &input;
+    decompress.Output = &output;
+    decompress.UserData = &data;
+    decompress.HeapInfo = Heap;
+    decompress.InflateTables = Tables;
+    int ret = old ? OldInflate::Inflate(&decompress, deflate64) : Inflate(&decompress, deflate64);
+    Tables = decompress.InflateTables;
+    free(data.Buffer);
+    return ret;
+}
+
+static void Generate(CBuffer* buf, int kind, DWORD size)
+{
+    static const char* words[] = {"the", "of", "int", "return", "file", "directory", "if (", "else",
+                                  "Salamander", "archive", "{", "}", "    ", "\r\n", "NULL", "size", "="};
+    buf->Data = (BYTE*)malloc(size > 0 ? size : 1);
+    buf->Size = buf->Allocated = buf->Data != NULL ? size : 0;
+    DWORD pos = 0;
+    while (pos < buf->Size)
+    {
+        char piece[100];
+        int len;
+        switch (kind)
+        {
+        case 0: // text
+            len = sprintf(piece, "%s ", words[Rand() % ARRAYSIZE(words)]);
+            break;
+        case 1: // records
+            len = sprintf(piece, "%06u;%s;%u.%02u;2023-%02u-%02u\r\n", pos / 40, words[Rand() % 8], Rand() % 1000,
+                          Rand() % 100, 1 + Rand() % 12, 1 + Rand() % 28);
+            break;
+        case 2: // binary-like: small values, repeated sequences
+        {
+            len = 1 + Rand() % 16;
+            int i;
+            if (pos > 4096 && Rand() % 3 == 0)
+                memcpy(piece, buf->Data + pos - len - Rand() % 4096, len);
+            else
+            {
+                for (i = 0; i < len; i++)
+                    piece[i] = (char)(Rand() % 4 == 0 ? Rand() : Rand() % 8);
+            }
+            break;
+        }
+        default: // random
+            len = 4;
+            *(DWORD*)piece = Rand() ^ (Rand() << 16);
+            break;
+        }
+        if ((DWORD)len > buf->Size - pos)
+            len = buf->Size - pos;
+        memcpy(buf->Data + pos, piece, len);
+        pos += len;
+    }
+}
+
+// packs 'in' by zlib into 'out' (raw deflate)
+static BOOL PackZlib(const CBuffer* in, CBuffer* out, int level, int strategy, int windowBits, int memLevel)
+{
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    if (deflateInit2(&strm, level, Z_DEFLATED, -windowBits, memLevel, strategy) != Z_OK)
+        return FALSE;
+    uLong bound = deflateBound(&strm, in->Size);
+    out->Data = (BYTE*)malloc(bound);
+    out->Size = 0;
+    out->Allocated = out->Data != NULL ? bound : 0;
+    strm.next_in = in->Data;
+    strm.avail_in = in->Size;
+    strm.next_out = out->Data;
+    strm.avail_out = out->Allocated;
+    int res = deflate(&strm, Z_FINISH);
+    out->Size = strm.total_out;
+    deflateEnd(&strm);
+    return res == Z_STREAM_END;
+}
+
+struct CBitWriter
+{
+    CBuffer* Out;
+    DWORD Bits;
+    unsigned Count;
+};
+
+static void PutBits(CBitWriter* w, DWORD value, unsigned n)
+{
+    while (n--)
+    {
+        w->Bits |= (value & 1) << w->Count;
+        value >>= 1;
+        if (++w->Count == 8)
+        {
+            BYTE b = (BYTE)w->Bits;
+            Append(w->Out, &b, 1);
+            w->Bits = 0;
+            w->Count = 0;
+        }
+    }
+}
+
+// Huffman codes are sent from the most significant bit
+static void PutCode(CBitWriter* w, DWORD code, unsigned len)
+{
+    while (len--)
+        PutBits(w, (code >> len) & 1, 1);
+}
+
+static void PutFixedSymbol(CBitWriter* w, unsigned sym)
+{
+    if (sym < 144)
+        PutCode(w, 0x30 + sym, 8);
+    else if (sym < 256)
+        PutCode(w, 0x190 + sym - 144, 9);
+    else if (sym < 280)
+        PutCode(w, sym - 256, 7);
+    else
+        PutCode(w, 0xC0 + sym - 280, 8);
+}
+
+// writes a stream of fixed code and stored blocks into 'packed' and the data it codes into
+// 'data'; Deflate64 streams use the long lengths (code 285) and distances (codes 30 and 31)
+static void GenerateStream(CBuffer* packed, CBuffer* data, int deflate64)
+{
+    memset(packed, 0, sizeof(CBuffer));
+    memset(data, 0, sizeof(CBuffer));
+    CBitWriter w = {packed, 0, 0};
+    const ush* lens = deflate64 ? cplens64 : cplens32;
+    const uch* lext = deflate64 ? cplext64 : cplext32;
+    const uch* dext = deflate64 ? cpdext64 : cpdext32;
+    DWORD window = deflate64 ? 65536 : 32768;
+    int blocks = 1 + Rand() % 4;
+    int block;
+    for (block = 0; block < blocks; block++)
+    {
+        PutBits(&w, block == blocks - 1, 1);
+        if (Rand() % 5 == 0) // stored
+        {
+            PutBits(&w, 0, 2);
+            if (w.Count > 0)
+                PutBits(&w, 0, 8 - w.Count);
+            DWORD len = Rand() % 3 == 0 ? Rand() % 65536 : Rand() % 300;
+            PutBits(&w, len, 16);
+            PutBits(&w, ~len & 0xffff, 16);
+            DWORD i;
+            for (i = 0; i < len; i++)
+            {
+                BYTE b = (BYTE)Rand();
+                Append(packed, &b, 1);
+                Append(data, &b, 1);
+            }
+            continue;
+        }
+        PutBits(&w, 1, 2); // fixed codes
+        int tokens = Rand() % 3000;
+        int t;
+        for (t = 0; t < tokens; t++)
+        {
+            if (data->Size == 0 || Rand() % 3 == 0) // literal
+            {
+                BYTE b = (BYTE)(Rand() % 4 == 0 ? Rand() : 'a' + Rand() % 4);
+                PutFixedSymbol(&w, b);
+                Append(data, &b, 1);
+                continue;
+            }
+            unsigned code = Rand() % 29;
+            DWORD extra = lext[code] == 16 ? Rand() % (1 << (Rand() % 17)) : lext[code] > 0 ? Rand() % (1 << lext[code]) : 0;
+            DWORD len = lens[code] + extra;
+            PutFixedSymbol(&w, 257 + code);
+            PutBits(&w, extra, lext[code]);
+
+            // distance; far ones more often than in real data
+            DWORD maxDist = data->Size < window ? data->Size : window;
+            unsigned dcode;
+            do
+            {
+                dcode = Rand() % 2 == 0 ? Rand() % (deflate64 ? 32 : 30) : (deflate64 ? 26 : 24) + Rand() % 6;
+            } while (cpdist[dcode] > maxDist);
+            DWORD range = maxDist - cpdist[dcode] + 1;
+            if (range > (1u << dext[dcode]))
+                range = 1 << dext[dcode];
+            DWORD dextra = Rand() % range;
+            PutCode(&w, dcode, 5);
+            PutBits(&w, dextra, dext[dcode]);
+            DWORD dist = cpdist[dcode] + dextra;
+            DWORD i;
+            for (i = 0; i < len; i++)
+            {
+                BYTE b = data->Data[data->Size - dist];
+                Append(data, &b, 1);
+            }
+        }
+        PutFixedSymbol(&w, 256);
+    }
+    if (w.Count > 0)
+        PutBits(&w, 0, 8 - w.Count);
+}
+
+static BOOL SameData(const CBuffer* b1, const CBuffer* b2)
+{
+    return b1->Size == b2->Size && memcmp(b1->Data, b2->Data, b1->Size) == 0;
+}
+
+// decodes 'packed' by both decoders; returns FALSE if they differ or if the new one does not
+// give 'expected' (if it is not NULL)
+static BOOL Compare(const CBuffer* packed, DWORD chunk, int deflate64, const CBuffer* expected, const char* what,
+                    int iteration, int* codeDiffs)
+{
+    static CBuffer outOld, outNew;
+    DWORD limit = (expected != NULL ? expected->Size : 0) + 4 * 1024 * 1024;
+    int retOld = Decode(TRUE, packed, chunk, deflate64, &outOld, limit);
+    int retNew = Decode(FALSE, packed, chunk, deflate64, &outNew, limit);
+    if ((retOld == 0) != (retNew == 0) || !SameData(&outOld, &outNew))
+    {
+        printf("MISMATCH (iteration %d, %s, %s, input buffer %u): old decoder returns %d with %u bytes, new %d with %u bytes\n",
+               iteration, what, deflate64 ? "Deflate64" : "Deflate", chunk, retOld, outOld.Size, retNew, outNew.Size);
+        return FALSE;
+    }
+    if (retOld != retNew)
+        (*codeDiffs)++; // both failed, the error can be found at another point
+    if (expected != NULL && (retNew != 0 || !SameData(&outNew, expected)))
+    {
+        printf("MISMATCH (iteration %d, %s, %s, input buffer %u): returns %d with %u bytes instead of %u bytes of data\n",
+               iteration, what, deflate64 ? "Deflate64" : "Deflate", chunk, retNew, outNew.Size, expected->Size);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static void Damage(CBuffer* buf)
+{
+    if (buf->Size == 0)
+        return;
+    int i;
+    switch (Rand() % 4)
+    {
+    case 0: // flipped bits
+        for (i = 1 + Rand() % 3; i > 0; i--)
+            buf->Data[Rand() % buf->Size] ^= (BYTE)(1 << Rand() % 8);
+        break;
+    case 1: // overwritten bytes
+        for (i = 1 + Rand() % 3; i > 0; i--)
+            buf->Data[Rand() % buf->Size] = (BYTE)Rand();
+        break;
+    case 2: // cut end
+        buf->Size = Rand() % buf->Size;
+        break;
+    default: // damaged beginning (block headers, code lengths)
+        buf->Data[Rand() % (buf->Size < 64 ? buf->Size : 64)] ^= (BYTE)(1 << Rand() % 8);
+        break;
+    }
+}
+
+static int TestDecoders(int iterations)
+{
+    static const int strategies[] = {Z_DEFAULT_STRATEGY, Z_FILTERED, Z_HUFFMAN_ONLY, Z_RLE, Z_FIXED};
+    int failures = 0;
+    int codeDiffs = 0;
+    int damaged = 0;
+    int it;
+    for (it = 0; it < iterations && failures < 10; it++)
+    {
+        CBuffer data, packed;
+        int deflate64;
+        const char* what;
+        BOOL known; // 'data' is what the stream codes in 'deflate64' mode
+        if (Rand() % 3 == 0)
+        {
+            deflate64 = Rand() % 2;
+            GenerateStream(&packed, &data, deflate64);
+            what = "generated";
+            known = TRUE;
+        }
+        else
+        {
+            DWORD size = Rand() % 4 == 0 ? Rand() % 300000 : Rand() % 5000;
+            Generate(&data, Rand() % 4, size);
+            if (!PackZlib(&data, &packed, Rand() % 10, strategies[Rand() % ARRAYSIZE(strategies)], 9 + Rand() % 7,
+                          1 + Rand() % 9))
+            {
+                printf("Unable to pack data by zlib.\n");
+                failures++;
+                free(data.Data);
+                free(packed.Data);
+                continue;
+            }
+            // zlib streams decoded as Deflate64 give other data (length code 285), but both decoders
+            // must still give the same
+            deflate64 = Rand() % 4 == 0;
+            what = "zlib";
+            known = !deflate64;
+        }
+        DWORD chunk = Rand() % 3 == 0 ? 1 + Rand() % 64 : TEST_INBUFFER_SIZE;
+        if (!Compare(&packed, chunk, deflate64, known ? &data : NULL, what, it, &codeDiffs))
+            failures++;
+
+        int i;
+        for (i = 0; i < 4; i++)
+        {
+            CBuffer copy;
+            copy.Data = (BYTE*)malloc(packed.Size > 0 ? packed.Size : 1);
+            copy.Size = copy.Allocated = packed.Size;
+            memcpy(copy.Data, packed.Data, packed.Size);
+            Damage(&copy);
+            if (!Compare(&copy, chunk, deflate64, NULL, "damaged", it, &codeDiffs))
+                failures++;
+            damaged++;
+            free(copy.Data);
+        }
+        free(data.Data);
+        free(packed.Data);
+    }
+    printf("fuzz: %d streams, %d damaged streams, %d mismatches (%d failures with other error codes)\n", it, damaged,
+           failures, codeDiffs);
+    return failures;
+}
+
+static void Benchmark(DWORD size)
+{
+    static const char* kinds[] = {"(text)", "(records)", "(binary)", "(random)", "(text, fixed)"};
+    printf("\n%-16s %10s %12s %12s %8s\n", "stream", "packed KB", "old MB/s", "new MB/s", "speedup");
+    int kind;
+    for (kind = 0; kind < (int)ARRAYSIZE(kinds); kind++)
+    {
+        CBuffer data, packed, out;
+        memset(&out, 0, sizeof(out));
+        Generate(&data, kind < 4 ? kind : 0, size);
+        PackZlib(&data, &packed, 6, kind < 4 ? Z_DEFAULT_STRATEGY : Z_FIXED, 15, 8);
+        double times[2] = {0, 0};
+        int round;
+        for (round = 0; round < 5; round++) // the best of five runs
+        {
+            int old;
+            for (old = 1; old >= 0; old--)
+            {
+                double t = GetSeconds();
+                int ret = Decode(old, &packed, TEST_INBUFFER_SIZE, 0, &out, size);
+                t = GetSeconds() - t;
+                if (ret != 0 || !SameData(&out, &data))
+                    printf("benchmark: %s decoder failed\n", old ? "old" : "new");
+                if (round == 0 || t < times[old])
+                    times[old] = t;
+            }
+        }
+        double mb = size / (1024.0 * 1024.0);
+        printf("%-16s %10u %12.1f %12.1f %8.2f\n", kinds[kind], packed.Size / 1024, times[1] > 0 ? mb / times[1] : 0.0,
+               times[0] > 0 ? mb / times[0] : 0.0, times[0] > 0 ? times[1] / times[0] : 0.0);
+        free(data.Data);
+        free(packed.Data);
+        free(out.Data);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 3000;
+    int benchmarkMB = argc > 2 ? atoi(argv[2]) : 16;
+
+    Heap = HeapCreate(HEAP_NO_SERIALIZE, INITIAL_HEAP_SIZE, MAXIMUM_HEAP_SIZE);
+    int failures = TestDecoders(iterations);
+    if (benchmarkMB > 0)
+        Benchmark(benchmarkMB * 1024 * 1024);
+
+    CDecompressionObject decompress;
+    decompress.HeapInfo = Heap;
+    decompress.InflateTables = Tables;
+    FreeFixedHufman(&decompress);
+    OldInflate::FreeFixedHufman(&decompress);
+    HeapDestroy(Heap);
+    return failures == 0 ? 0 : 1;
+}
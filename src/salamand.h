@@ -25,13 +25,49 @@ void ReleaseConstGraphics();
 
 class CMenuPopup;
 
+//****************************************************************************
+//
+// CNamesArena
+//
+// allocator of names (CFileData::Name and DosName) for a panel listing: the names are
+// stored one after another in big blocks and all are released at once by Release();
+// a single name cannot be released
+//
+
+#define NAMES_ARENA_BLOCK_SIZE (64 * 1024) // size of one block including its header
+
+class CNamesArena
+{
+protected:
+    struct CBlock
+    {
+        CBlock* Next; // previously allocated block
+        int Used;     // number of used bytes in the block (including the header)
+    };
+
+    CBlock* Blocks; // the last allocated block (the blocks are chained through Next)
+
+public:
+    CNamesArena() { Blocks = NULL; }
+    ~CNamesArena() { Release(); }
+
+    BOOL IsEmpty() { return Blocks == NULL; }
+
+    // returns a buffer of 'size' bytes (at most 2 * MAX_PATH), returns NULL on low memory
+    char* Alloc(int size);
+
+    // releases all blocks (and thus all names allocated by Alloc)
+    void Release();
+};
+
 //
 // ****************************************************************************
 
 class CFilesArray : public TDirectArray<CFileData>
 {
 protected:
-    BOOL DeleteData; // should destructors of removed elements be called?
+    BOOL DeleteData;        // should destructors of removed elements be called?
+    CNamesArena NamesArena; // names of items with CFileData::NameInArena==1 (see AllocName)
 
 public:
     // j.r. is increasing the delta to 800 because when entering larger directories (several thousand files)
@@ -41,10 +77,18 @@ public:
 
     void SetDeleteData(BOOL deleteData) { DeleteData = deleteData; }
 
+    // allocates a name (or DOS name) for an item of this array in NamesArena; the item must have
+    // CFileData::NameInArena set to 1 and its names are then released together with the array;
+    // usable only if the array owns the data (see SetDeleteData); returns NULL on low memory
+    char* AllocName(int size) { return NamesArena.Alloc(size); }
+
     void DestroyMembers()
     {
         if (DeleteData)
+        {
             TDirectArray<CFileData>::DestroyMembers();
+            NamesArena.Release();
+        }
         else
             TDirectArray<CFileData>::DetachMembers();
     }
@@ -54,6 +98,7 @@ public:
         if (!DeleteData)
             DetachMembers();
         TDirectArray<CFileData>::Destroy();
+        NamesArena.Release();
     }
 
     void Delete(int index)
@@ -70,9 +115,12 @@ public:
         if (!DeleteData)
             TRACE_E("Unexpected situation in CFilesArray::CallDestructor()");
 #endif // _DEBUG
-        free(member.Name);
-        if (member.DosName != NULL)
-            free(member.DosName);
+        if (NamesArena.IsEmpty() || !member.NameInArena) // names from NamesArena are released in one go
+        {
+            free(member.Name);
+            if (member.DosName != NULL)
+                free(member.DosName);
+        }
     }
 };
 
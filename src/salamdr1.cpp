@@ -40,6 +40,7 @@ extern "C"
 }
 #include "salshlib.h"
 #include "shiconov.h"
+#include "hashcach.h"
 #include "salmoncl.h"
 #include "jumplist.h"
 #include "usermenu.h"
@@ -678,115 +679,6 @@ COLORREF CustomColors[NUMBER_OF_CUSTOMCOLORS] =
         RGB(255, 255, 255),
 };
 
-//*****************************************************************************
-//
-// CRC32
-//
-
-static DWORD Crc32Tab[256];
-static BOOL Crc32TabInitialized = FALSE;
-
-void MakeCrc32Table(DWORD* crcTab)
-{
-    DWORD c;
-    DWORD poly = 0xedb88320L; //polynomial exclusive-or pattern
-
-    /*
-  // generate crc polonomial, using precomputed poly should be faster
-  // terms of polynomial defining this crc (except x^32):
-  static const Byte p[] = {0,1,2,4,5,7,8,10,11,12,16,22,23,26};
-
-  // make exclusive-or pattern from polynomial (0xedb88320L)
-  poly = 0L;
-  for (n = 0; n < sizeof(p)/sizeof(Byte); n++)
-    poly |= 1L << (31 - p[n]);
-*/
-    int n;
-    for (n = 0; n < 256; n++)
-    {
-        c = (UINT32)n;
-
-        int k;
-        for (k = 0; k < 8; k++)
-            c = c & 1 ? poly ^ (c >> 1) : c >> 1;
-
-        crcTab[n] = c;
-    }
-}
-
-DWORD UpdateCrc32(const void* buffer, DWORD count, DWORD crcVal)
-{
-    CALL_STACK_MESSAGE_NONE
-
-    if (buffer == NULL)
-        return 0;
-
-    if (!Crc32TabInitialized)
-    {
-        MakeCrc32Table(Crc32Tab);
-        Crc32TabInitialized = TRUE;
-    }
-
-    BYTE* p = (BYTE*)buffer;
-    DWORD c = crcVal ^ 0xFFFFFFFF;
-
-    if (count)
-        do
-        {
-            c = Crc32Tab[((int)c ^ (*p++)) & 0xff] ^ (c >> 8);
-        } while (--count);
-
-    // Honza: meril jsem nasledujici optimalizace a nemaji zadny vyznam;
-    // jedina sance by bylo prepsani do ASM a cteni pameti po DWORDech,
-    // ze kterych by pak bylo mozne vyzobavat jednotlive bajty;
-    // pri soucasnem nastaveni release verze neni prekladac schopen tuto
-    // optimalizaci provest za nas.
-    /*
-  int remain = count % 8;
-  count -= remain;
-  while (remain)
-  {
-    c = Crc32Tab[((int)c ^ (*p++)) & 0xff] ^ (c >> 8);
-    remain--;
-  }
-  while (count)
-  {
-    c = Crc32Tab[((int)c ^ (*p++)) & 0xff] ^ (c >> 8);
-    c = Crc32Tab[((int)c ^ (*p++)) & 0xff] ^ (c >> 8);
-    c = Crc32Tab[((int)c ^ (*p++)) & 0xff] ^ (c >> 8);
-    c = Crc32Tab[((int)c ^ (*p++)) & 0xff] ^ (c >> 8);
-    c = Crc32Tab[((int)c ^ (*p++)) & 0xff] ^ (c >> 8);
-    c = Crc32Tab[((int)c ^ (*p++)) & 0xff] ^ (c >> 8);
-    c = Crc32Tab[((int)c ^ (*p++)) & 0xff] ^ (c >> 8);
-    c = Crc32Tab[((int)c ^ (*p++)) & 0xff] ^ (c >> 8);
-    count -= 8;
-  }
-*/
-    /*
-  int remain = count % 4;
-  count -= remain;
-  while (remain > 0)
-  {
-    c = Crc32Tab[((int)c ^ (*p++)) & 0xff] ^ (c >> 8);
-    remain--;
-  }
-
-
-  DWORD *pdw = (DWORD*)p;
-  DWORD dw;
-  while (count > 0)
-  {
-    dw = *pdw++;
-    c = Crc32Tab[((int)c ^ ((BYTE)(dw))) & 0xFF] ^ (c >> 8);
-    c = Crc32Tab[((int)c ^ ((BYTE)(dw >> 8))) & 0xFF] ^ (c >> 8);
-    c = Crc32Tab[((int)c ^ ((BYTE)(dw >> 16))) & 0xFF] ^ (c >> 8);
-    c = Crc32Tab[((int)c ^ ((BYTE)(dw >> 24))) & 0xFF] ^ (c >> 8);
-    count -= 4;
-  }
-*/
-    return c ^ 0xFFFFFFFF; /* (instead of ~c for 64-bit machines) */
-}
-
 BOOL IsRemoteSession(void)
 {
     return GetSystemMetrics(SM_REMOTESESSION);
@@ -4676,6 +4568,8 @@ MENU_TEMPLATE_ITEM MsgBoxButtons[] =
     TerminateThread();
     ReleaseFileNamesEnumForViewers();
     ReleaseShellIconOverlays();
+    FileHashCache.Release();
+    ThumbnailDiskCache.Release();
     ReleaseSalShLib();
     ReleaseWorker();
     ReleaseViewer();
@@ -572,6 +572,41 @@ char* PrintTimeLeft(char* buf, CQuadWord const& secs)
     return buf;
 }
 
+//
+// ****************************************************************************
+// CNamesArena
+//
+
+char* CNamesArena::Alloc(int size)
+{
+    size = (size + sizeof(void*) - 1) & ~(int)(sizeof(void*) - 1); // keep the names aligned
+    if (Blocks == NULL || Blocks->Used + size > NAMES_ARENA_BLOCK_SIZE)
+    {
+        CBlock* block = (CBlock*)malloc(NAMES_ARENA_BLOCK_SIZE);
+        if (block == NULL)
+        {
+            TRACE_E(LOW_MEMORY);
+            return NULL;
+        }
+        block->Next = Blocks;
+        block->Used = sizeof(CBlock);
+        Blocks = block;
+    }
+    char* ret = (char*)Blocks + Blocks->Used;
+    Blocks->Used += size;
+    return ret;
+}
+
+void CNamesArena::Release()
+{
+    while (Blocks != NULL)
+    {
+        CBlock* next = Blocks->Next;
+        free(Blocks);
+        Blocks = next;
+    }
+}
+
 //
 // ****************************************************************************
 // CNames
@@ -0,0 +1,207 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "precomp.h"
+#include <intrin.h>
+#include <immintrin.h>
+
+#include "cpufeat.h"
+
+//*****************************************************************************
+//
+// CRC32
+//
+
+static DWORD Crc32Tab[8][256]; // [0] je klasicka tabulka, [1..7] pro zpracovani po 8 bajtech (slice-by-8)
+static BOOL Crc32TabInitialized = FALSE;
+static BOOL Crc32UseCLMUL = FALSE; // TRUE = CPU umi PCLMULQDQ + SSE4.1
+
+void MakeCrc32Table(DWORD* crcTab)
+{
+    DWORD c;
+    DWORD poly = 0xedb88320L; //polynomial exclusive-or pattern
+
+    /*
+  // generate crc polonomial, using precomputed poly should be faster
+  // terms of polynomial defining this crc (except x^32):
+  static const Byte p[] = {0,1,2,4,5,7,8,10,11,12,16,22,23,26};
+
+  // make exclusive-or pattern from polynomial (0xedb88320L)
+  poly = 0L;
+  for (n = 0; n < sizeof(p)/sizeof(Byte); n++)
+    poly |= 1L << (31 - p[n]);
+*/
+    int n;
+    for (n = 0; n < 256; n++)
+    {
+        c = (UINT32)n;
+
+        int k;
+        for (k = 0; k < 8; k++)
+            c = c & 1 ? poly ^ (c >> 1) : c >> 1;
+
+        crcTab[n] = c;
+    }
+}
+
+static void InitCrc32Tables()
+{
+    MakeCrc32Table(Crc32Tab[0]);
+    // Crc32Tab[k][n] = CRC bajtu 'n' nasledovaneho k nulovymi bajty
+    int n;
+    for (n = 0; n < 256; n++)
+    {
+        DWORD c = Crc32Tab[0][n];
+        int k;
+        for (k = 1; k < 8; k++)
+        {
+            c = Crc32Tab[0][c & 0xff] ^ (c >> 8);
+            Crc32Tab[k][n] = c;
+        }
+    }
+
+    // SSE4.1 kvuli _mm_extract_epi32
+    Crc32UseCLMUL = (GetCPUFeatures() & (CPUF_PCLMULQDQ | CPUF_SSE41)) == (CPUF_PCLMULQDQ | CPUF_SSE41);
+    _ReadWriteBarrier(); // tabulky musi byt zapsane drive nez Crc32TabInitialized
+    Crc32TabInitialized = TRUE;
+}
+
+// slice-by-8: zpracuje 8 bajtu najednou pomoci osmi tabulek; 'c' je invertovane CRC
+static DWORD UpdateCrc32Slice8(const BYTE* p, DWORD count, DWORD c)
+{
+    while (count > 0 && ((ULONG_PTR)p & 3) != 0)
+    {
+        c = Crc32Tab[0][(c ^ *p++) & 0xff] ^ (c >> 8);
+        count--;
+    }
+    while (count >= 8)
+    {
+        DWORD one = *(const DWORD*)p ^ c;
+        DWORD two = *(const DWORD*)(p + 4);
+        c = Crc32Tab[7][one & 0xff] ^ Crc32Tab[6][(one >> 8) & 0xff] ^
+            Crc32Tab[5][(one >> 16) & 0xff] ^ Crc32Tab[4][one >> 24] ^
+            Crc32Tab[3][two & 0xff] ^ Crc32Tab[2][(two >> 8) & 0xff] ^
+            Crc32Tab[1][(two >> 16) & 0xff] ^ Crc32Tab[0][two >> 24];
+        p += 8;
+        count -= 8;
+    }
+    while (count > 0)
+    {
+        c = Crc32Tab[0][(c ^ *p++) & 0xff] ^ (c >> 8);
+        count--;
+    }
+    return c;
+}
+
+// skladani ("folding") 128-bitovych bloku pomoci PCLMULQDQ podle Intel white paperu
+// "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction";
+// 'count' musi byt nasobek 16 a aspon 64; 'c' je invertovane CRC
+static DWORD UpdateCrc32CLMUL(const BYTE* p, DWORD count, DWORD c)
+{
+    // konstanty pro bitove obracenou (reflected) domenu: x^(4*128+32), x^(4*128-32),
+    // x^(128+32), x^(128-32), x^64 mod P a Barrettova redukce (P a mu)
+    static const __declspec(align(16)) unsigned __int64 k1k2[2] = {0x0154442bd4, 0x01c6e41596};
+    static const __declspec(align(16)) unsigned __int64 k3k4[2] = {0x01751997d0, 0x00ccaa009e};
+    static const __declspec(align(16)) unsigned __int64 k5k0[2] = {0x0163cd6124, 0x0000000000};
+    static const __declspec(align(16)) unsigned __int64 poly[2] = {0x01db710641, 0x01f7011641};
+
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+    x1 = _mm_loadu_si128((const __m128i*)(p + 0x00));
+    x2 = _mm_loadu_si128((const __m128i*)(p + 0x10));
+    x3 = _mm_loadu_si128((const __m128i*)(p + 0x20));
+    x4 = _mm_loadu_si128((const __m128i*)(p + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)c));
+    x0 = _mm_load_si128((const __m128i*)k1k2);
+    p += 64;
+    count -= 64;
+
+    // skladani ctyr bloku paralelne
+    while (count >= 64)
+    {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i*)(p + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i*)(p + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i*)(p + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i*)(p + 0x30)));
+        p += 64;
+        count -= 64;
+    }
+
+    // slozeni ctyr bloku do jednoho
+    x0 = _mm_load_si128((const __m128i*)k3k4);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    // zbyvajici 16-bajtove bloky
+    while (count >= 16)
+    {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i*)p)), x5);
+        p += 16;
+        count -= 16;
+    }
+
+    // 128 -> 64 bitu
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+    x0 = _mm_loadl_epi64((const __m128i*)k5k0);
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrettova redukce na 32 bitu
+    x0 = _mm_load_si128((const __m128i*)poly);
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+    return (DWORD)_mm_extract_epi32(x1, 1);
+}
+
+DWORD UpdateCrc32(const void* buffer, DWORD count, DWORD crcVal)
+{
+    CALL_STACK_MESSAGE_NONE
+
+    if (buffer == NULL)
+        return 0;
+
+    if (!Crc32TabInitialized)
+        InitCrc32Tables(); // pripadny soubeh vice threadu nevadi, vsechny zapisou totez
+
+    const BYTE* p = (const BYTE*)buffer;
+    DWORD c = crcVal ^ 0xFFFFFFFF;
+
+    // rozbaleni bajtove smycky nemelo zadny vyznam (prekladac neumi cist po DWORDech),
+    // proto slice-by-8 (cte po 8 bajtech, zadne pozadavky na CPU) a pro delsi bloky
+    // PCLMULQDQ (skladani po 64 bajtech, radove rychlejsi)
+    if (count >= 256 && Crc32UseCLMUL)
+    {
+        DWORD blocks = count & ~15;
+        c = UpdateCrc32CLMUL(p, blocks, c);
+        p += blocks;
+        count -= blocks;
+    }
+    c = UpdateCrc32Slice8(p, count, c);
+
+    return c ^ 0xFFFFFFFF; /* (instead of ~c for 64-bit machines) */
+}
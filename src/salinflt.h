@@ -7,25 +7,12 @@
 typedef unsigned __int8 uch;  //8-bit unsigned type
 typedef unsigned __int16 ush; //16-bit unsigned type
 typedef unsigned int ulg;     //at least 32-bit type (usually processor register size)
+typedef size_t bitbuf_t;      //bit buffer type (processor register size)
 
 //PKZIP 1.93a problem--live with it
 #define PKZIP_BUG_WORKAROUND
 
-//check Error field of CInputManager after calling NextByte() in
-//NEEDBITS() macro
-//2-3% speed penalty
-#define CHECK_INPUT_ERROR
-
-struct huft
-{
-    uch e; /* number of extra bits or operation */
-    uch b; /* number of bits in this code or subcode */
-    union
-    {
-        ush n;          /* literal, length base, or distance base */
-        struct huft* t; /* pointer to next level of table */
-    } v;
-};
+struct CInflateTables;
 
 //decompression object
 
@@ -48,44 +35,16 @@ struct CDecompressionObject
     //internal fields
     unsigned WinPos; //current position in sliding window
 
-    ulg BitBuf;        //bit buffer
-    unsigned BitCount; //number of bits in bit buffer */
+    bitbuf_t BitBuf;   //bit buffer (it is filled ahead from the input)
+    unsigned BitCount; //number of bits in bit buffer
+    unsigned Overread; //number of zero bytes added to bit buffer behind the end of input
 
     // internal variables for inflate
-    struct huft* fixed_tl;
-    struct huft* fixed_td;
-    int fixed_bl,
-        fixed_bd;
+    struct CInflateTables* Tables; // decoding tables; !! must be NULL initialized before
+                                   // calling Inflate(), released by FreeFixedHufman()
 
     int Flush(unsigned bytes);
 };
 
 int Inflate(CDecompressionObject* decompress);
 int FreeFixedHufman(CDecompressionObject* decompress);
-
-int huft_build(CDecompressionObject* decompress,
-               const unsigned* b, /* code lengths in bits (all assumed <= BMAX) */
-               unsigned n,        /* number of codes (assumed <= N_MAX) */
-               unsigned s,        /* number of simple-valued codes (0..s-1) */
-               const ush* d,      /* list of base values for non-simple codes */
-               const uch* e,      /* list of extra bits for non-simple codes */
-               struct huft** t,   /* result: starting table */
-               int* m);           /* maximum lookup bits, returns actual */
-
-int huft_free(CDecompressionObject* decompress, struct huft* t);
-
-#ifdef _DEBUG
-uch NextByte(CDecompressionObject* decompress);
-#else
-__forceinline uch NextByte(CDecompressionObject* decompress)
-{
-    if (decompress->DataPtr < decompress->DataEnd)
-        return *decompress->DataPtr++;
-    else
-    {
-        if (decompress->DataPtr == decompress->DataEnd)
-            decompress->DataPtr++; // the error state occurs only when decompress->DataPtr > decompress->DataEnd
-        return 0 /* error */;
-    }
-}
-#endif //_DEBUG
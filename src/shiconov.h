@@ -6,6 +6,9 @@
 void InitShellIconOverlays();
 void ReleaseShellIconOverlays();
 
+// vraci plne jmeno sqlite.dll (lezi v podadresari "utils" adresare se salamand.exe)
+BOOL GetSQLitePath(char* path, int pathSize);
+
 struct CSQLite3DynLoadBase
 {
     BOOL OK; // TRUE pokud je SQLite3 uspesne nahrany a pripraveny k pouziti
@@ -257,6 +257,398 @@ int RegSetStrCmpEx(const char* s1, int l1, const char* s2, int l2, BOOL* numeric
     }
 }
 
+//
+//*****************************************************************************
+// Razeni pres predpocitane klice
+//
+// Misto prehazovani celych CFileData a opakovaneho cteni Configuration v kazdem porovnani
+// se radi pole kompaktnich zaznamu s predpocitanymi klici a pole 'files' se pak jednou
+// prehazi podle vysledku. Predpocitane klice davaji vzdy stejny vysledek jako puvodni
+// Less* funkce, pri shode klicu se pouzije CmpNameExt (CmpExtName). SortKeysAux je stejny
+// QuickSort jako puvodni Sort*Aux, takze i polozky, ktere jsou podle porovnavacich funkci
+// shodne (stejna jmena v archivech), skonci ve stejnem poradi jako drive. Pri razeni ve vice
+// threadech to zarucit nelze, proto se v tom pripade (jen pokud shodne polozky existuji)
+// radi znovu v jednom threadu.
+
+#define SORT_PARALLEL_MIN_ITEMS 20000 // od tohoto poctu polozek se radi ve vice threadech
+#define SORT_MAX_THREADS 8            // max. pocet threadu pro razeni
+
+enum CSortKeyType
+{
+    sktName,
+    sktExt,
+    sktTime,
+    sktSize,
+    sktAttr
+};
+
+struct CSortKeyItem
+{
+    unsigned __int64 Primary; // primarni klic (cas, velikost nebo atributy), pro sktName a sktExt vzdy 0
+    unsigned __int64 Prefix;  // prvnich 8 znaku jmena (pro sktExt pripony) prevedenych pres LowerCase (big-endian, doplneno nulami)
+    const CFileData* File;    // razena polozka (ukazuje do puvodniho pole)
+};
+
+struct CSortKeyContext
+{
+    CSortKeyType Type;
+    BOOL Reverse;     // obracene razeni
+    BOOL TimeReverse; // obracene razeni podle casu (Reverse ^ Configuration.SortNewerOnTop)
+    BOOL UsePrefix;   // TRUE = jmena se porovnavaji pres StrICmpEx, lze tedy pouzit Prefix
+};
+
+// prevod atributu na klic pro razeni, viz LessAttrNameExt
+DWORD GetAttrSortKey(DWORD attr)
+{
+    // okopcim FILE_ATTRIBUTE_READONLY na nejvyznamejsi bit
+    //  DWORD sortAttr = attr;
+    //  if (attr & FILE_ATTRIBUTE_READONLY) sortAttr |= 0x80000000;
+
+    // pokud podporime zobrazovani dalsiho atributu,
+    // je treba rozsirit masku DISPLAYED_ATTRIBUTES
+
+    // prejdeme na abecedni razeni, jako ma explorer a speed commander
+    DWORD sortAttr = 0;
+    if (attr & FILE_ATTRIBUTE_ARCHIVE)
+        sortAttr |= 0x00000001;
+    if (attr & FILE_ATTRIBUTE_COMPRESSED)
+        sortAttr |= 0x00000002;
+    if (attr & FILE_ATTRIBUTE_ENCRYPTED)
+        sortAttr |= 0x00000004;
+    if (attr & FILE_ATTRIBUTE_HIDDEN)
+        sortAttr |= 0x00000008;
+    if (attr & FILE_ATTRIBUTE_READONLY)
+        sortAttr |= 0x00000010;
+    if (attr & FILE_ATTRIBUTE_SYSTEM)
+        sortAttr |= 0x00000020;
+    if (attr & FILE_ATTRIBUTE_TEMPORARY)
+        sortAttr |= 0x00000040;
+    return sortAttr;
+}
+
+void FillSortKeyItem(CSortKeyItem* item, const CFileData* f, const CSortKeyContext& ctx)
+{
+    switch (ctx.Type)
+    {
+    case sktName:
+    case sktExt:
+        item->Primary = 0;
+        break;
+    case sktTime:
+        item->Primary = ((unsigned __int64)f->LastWrite.dwHighDateTime << 32) | f->LastWrite.dwLowDateTime; // stejne poradi jako CompareFileTime
+        break;
+    case sktSize:
+        item->Primary = f->Size.Value;
+        break;
+    case sktAttr:
+        item->Primary = GetAttrSortKey(f->Attr);
+        break;
+    }
+    unsigned __int64 prefix = 0;
+    if (ctx.UsePrefix)
+    {
+        // kratsi jmeno se doplni nulami, takze je mensi nez kazde delsi jmeno se stejnym zacatkem,
+        // presne jako v StrICmpEx (znak s kodem 0 ve jmene byt nemuze)
+        const char* name = f->Name;
+        int len = f->NameLen;
+        if (ctx.Type == sktExt)
+        {
+            name = f->Ext;
+            len = f->NameLen - (int)(f->Ext - f->Name);
+        }
+        int i;
+        for (i = 0; i < 8; i++)
+            prefix = (prefix << 8) | (i < len ? LowerCase[(BYTE)name[i]] : 0);
+    }
+    item->Prefix = prefix;
+    item->File = f;
+}
+
+BOOL LessSortKeys(const CSortKeyItem& k1, const CSortKeyItem& k2, const CSortKeyContext& ctx)
+{
+    //--- nejprve podle primarniho klice
+    if (k1.Primary != k2.Primary)
+    {
+        BOOL reverse = ctx.Type == sktTime ? ctx.TimeReverse : ctx.Reverse;
+        return reverse ? k1.Primary > k2.Primary : k1.Primary < k2.Primary;
+    }
+    //--- podle nej se rovnaji, dale Name nebo Ext (zacatek staci, pokud se lisi)
+    int res;
+    if (ctx.UsePrefix && k1.Prefix != k2.Prefix)
+        res = k1.Prefix < k2.Prefix ? -1 : 1;
+    else
+        res = ctx.Type == sktExt ? CmpExtName(*k1.File, *k2.File) : CmpNameExt(*k1.File, *k2.File);
+    return ctx.Reverse ? res > 0 : res < 0;
+}
+
+void SortKeysAux(CSortKeyItem* keys, int left, int right, const CSortKeyContext& ctx)
+{
+
+LABEL_SortKeysAux:
+
+    int i = left, j = right;
+    CSortKeyItem pivot = keys[(i + j) / 2];
+
+    do
+    {
+        while (LessSortKeys(keys[i], pivot, ctx) && i < right)
+            i++;
+        while (LessSortKeys(pivot, keys[j], ctx) && j > left)
+            j--;
+
+        if (i <= j)
+        {
+            CSortKeyItem swap = keys[i];
+            keys[i] = keys[j];
+            keys[j] = swap;
+            i++;
+            j--;
+        }
+    } while (i <= j);
+
+    if (left < j)
+    {
+        if (i < right)
+        {
+            if (j - left < right - i) // je potreba seradit obe "poloviny", tedy do rekurze posleme tu mensi, tu druhou zpracujeme pres "goto"
+            {
+                SortKeysAux(keys, left, j, ctx);
+                left = i;
+                goto LABEL_SortKeysAux;
+            }
+            else
+            {
+                SortKeysAux(keys, i, right, ctx);
+                right = j;
+                goto LABEL_SortKeysAux;
+            }
+        }
+        else
+        {
+            right = j;
+            goto LABEL_SortKeysAux;
+        }
+    }
+    else
+    {
+        if (i < right)
+        {
+            left = i;
+            goto LABEL_SortKeysAux;
+        }
+    }
+}
+
+// slije serazene useky src[left..mid-1] a src[mid..right-1] do dst[left..right-1]
+void MergeSortKeys(const CSortKeyItem* src, CSortKeyItem* dst, int left, int mid, int right,
+                   const CSortKeyContext& ctx)
+{
+    int i = left, j = mid, k = left;
+    while (i < mid && j < right)
+    {
+        if (LessSortKeys(src[j], src[i], ctx))
+            dst[k++] = src[j++];
+        else
+            dst[k++] = src[i++];
+    }
+    while (i < mid)
+        dst[k++] = src[i++];
+    while (j < right)
+        dst[k++] = src[j++];
+}
+
+struct CSortKeysChunk
+{
+    CSortKeyItem* Keys;
+    int Left;
+    int Right;
+    const CSortKeyContext* Context;
+};
+
+unsigned SortKeysThreadBody(void* param)
+{
+    CALL_STACK_MESSAGE1("SortKeysThreadBody()");
+    CSortKeysChunk* chunk = (CSortKeysChunk*)param;
+    SortKeysAux(chunk->Keys, chunk->Left, chunk->Right, *chunk->Context);
+    return 0;
+}
+
+unsigned SortKeysThreadEH(void* param)
+{
+#ifndef CALLSTK_DISABLE
+    __try
+    {
+#endif // CALLSTK_DISABLE
+        return SortKeysThreadBody(param);
+#ifndef CALLSTK_DISABLE
+    }
+    __except (CCallStack::HandleException(GetExceptionInformation()))
+    {
+        TRACE_I("Thread PanelSort: calling ExitProcess(1).");
+        //    ExitProcess(1);
+        TerminateProcess(GetCurrentProcess(), 1); // tvrdsi exit (tenhle jeste neco vola)
+        return 1;
+    }
+#endif // CALLSTK_DISABLE
+}
+
+DWORD WINAPI SortKeysThreadF(void* param)
+{
+#ifndef CALLSTK_DISABLE
+    CCallStack stack;
+#endif // CALLSTK_DISABLE
+    SetThreadNameInVCAndTrace("PanelSort");
+    return SortKeysThreadEH(param);
+}
+
+// seradi 'count' zaznamu v 'keys'; pri 'threads' > 1 je rozdeli na useky, ktere se radi ve
+// 'threads' threadech a pak se slevaji pres 'tmp' (alokovane na 'count' zaznamu); vraci ukazatel
+// na pole se serazenymi zaznamy (bud 'keys' nebo 'tmp'); vraci NULL, pokud se radilo ve vice
+// threadech a mezi zaznamy jsou shodne (poradi v 'keys' je pak zmenene, je potreba ho
+// znovu naplnit a seradit pres SortKeysAux)
+CSortKeyItem* SortKeys(CSortKeyItem* keys, CSortKeyItem* tmp, int count, int threads, const CSortKeyContext& ctx)
+{
+    if (threads < 2)
+    {
+        SortKeysAux(keys, 0, count - 1, ctx);
+        return keys;
+    }
+
+    CSortKeysChunk chunks[SORT_MAX_THREADS];
+    int bounds[SORT_MAX_THREADS + 1];
+    int i;
+    for (i = 0; i <= threads; i++)
+        bounds[i] = (int)(((__int64)count * i) / threads);
+    HANDLE threadHandles[SORT_MAX_THREADS];
+    int started = 0;
+    for (i = 0; i < threads; i++)
+    {
+        chunks[i].Keys = keys;
+        chunks[i].Left = bounds[i];
+        chunks[i].Right = bounds[i + 1] - 1;
+        chunks[i].Context = &ctx;
+        if (i == 0)
+            continue; // prvni usek seradime v tomto threadu
+        DWORD threadID;
+        threadHandles[started] = HANDLES(CreateThread(NULL, 0, SortKeysThreadF, &chunks[i], 0, &threadID));
+        if (threadHandles[started] == NULL)
+        {
+            TRACE_E("Unable to start panel sorting thread.");
+            SortKeysAux(keys, chunks[i].Left, chunks[i].Right, ctx); // seradime ho tady
+        }
+        else
+            started++;
+    }
+    SortKeysAux(keys, chunks[0].Left, chunks[0].Right, ctx);
+    if (started > 0)
+    {
+        WaitForMultipleObjects(started, threadHandles, TRUE, INFINITE);
+        for (i = 0; i < started; i++)
+            HANDLES(CloseHandle(threadHandles[i]));
+    }
+
+    // slevame sousedni useky, dokud nezbude jediny
+    CSortKeyItem* src = keys;
+    CSortKeyItem* dst = tmp;
+    int parts = threads;
+    while (parts > 1)
+    {
+        int newParts = 0;
+        for (i = 0; i < parts; i += 2)
+        {
+            if (i + 1 < parts)
+                MergeSortKeys(src, dst, bounds[i], bounds[i + 1], bounds[i + 2], ctx);
+            else
+                memcpy(dst + bounds[i], src + bounds[i], (bounds[i + 1] - bounds[i]) * sizeof(CSortKeyItem));
+            bounds[newParts++] = bounds[i];
+        }
+        bounds[newParts] = count;
+        parts = newParts;
+        CSortKeyItem* swap = src;
+        src = dst;
+        dst = swap;
+    }
+
+    // shodne polozky by po slevani byly v jinem poradi nez po QuickSortu (neni stabilni)
+    for (i = 0; i + 1 < count; i++)
+    {
+        if (!LessSortKeys(src[i], src[i + 1], ctx))
+            return NULL;
+    }
+    return src;
+}
+
+// pocet threadu pro razeni 'count' polozek
+int GetSortThreads(int count)
+{
+    int threads = 1;
+    if (count >= SORT_PARALLEL_MIN_ITEMS)
+    {
+        SYSTEM_INFO si;
+        GetSystemInfo(&si);
+        threads = (int)si.dwNumberOfProcessors;
+        if (threads > SORT_MAX_THREADS)
+            threads = SORT_MAX_THREADS;
+    }
+    return threads;
+}
+
+// seradi polozky files[left..right] pres predpocitane klice; vraci FALSE, pokud je potreba
+// pouzit puvodni QuickSort (pole 'files' se pak nezmeni): pri nedostatku pameti a v jednom
+// threadu i tam, kde klice porovnani nezkrati (kazde by jen navic cetlo polozku pres File,
+// merenim v tests\sorttest.cpp vychazi pomalejsi nez QuickSort primo nad 'files')
+BOOL SortWithKeys(CFilesArray& files, int left, int right, CSortKeyType type, BOOL reverse)
+{
+    int count = right - left + 1;
+    if (count < 2)
+        return TRUE;
+
+    CSortKeyContext ctx;
+    ctx.Type = type;
+    ctx.Reverse = reverse;
+    ctx.TimeReverse = reverse ^ Configuration.SortNewerOnTop;
+    ctx.UsePrefix = !Configuration.SortDetectNumbers && !Configuration.SortUsesLocale;
+
+    int threads = GetSortThreads(count);
+    if (threads < 2 && (!ctx.UsePrefix || (type != sktName && type != sktAttr)))
+        return FALSE;
+
+    CSortKeyItem* keys = (CSortKeyItem*)malloc(2 * count * sizeof(CSortKeyItem));
+    CFileData* data = (CFileData*)malloc(count * sizeof(CFileData));
+    if (keys == NULL || data == NULL)
+    {
+        TRACE_E(LOW_MEMORY);
+        if (keys != NULL)
+            free(keys);
+        if (data != NULL)
+            free(data);
+        return FALSE;
+    }
+
+    CFileData* items = files.GetData() + left;
+    int i;
+    for (i = 0; i < count; i++)
+        FillSortKeyItem(&keys[i], &items[i], ctx);
+
+    CSortKeyItem* sorted = SortKeys(keys, keys + count, count, threads, ctx);
+    if (sorted == NULL) // shodne polozky, radime znovu v tomto threadu (stejne poradi jako drive)
+    {
+        for (i = 0; i < count; i++)
+            FillSortKeyItem(&keys[i], &items[i], ctx);
+        SortKeysAux(keys, 0, count - 1, ctx);
+        sorted = keys;
+    }
+
+    // jednorazove prehazeni polozek podle serazenych klicu
+    for (i = 0; i < count; i++)
+        data[i] = *sorted[i].File;
+    memcpy(items, data, count * sizeof(CFileData));
+
+    free(data);
+    free(keys);
+    return TRUE;
+}
+
 //
 //*****************************************************************************
 // QuickSort   1.klic Name, 2.klic Ext
@@ -398,7 +790,8 @@ LABEL_SortNameExtAux:
 
 void SortNameExt(CFilesArray& files, int left, int right, BOOL reverse)
 {
-    SortNameExtAux(files, left, right, reverse);
+    if (!SortWithKeys(files, left, right, sktName, reverse))
+        SortNameExtAux(files, left, right, reverse);
 }
 
 //
@@ -406,7 +799,7 @@ void SortNameExt(CFilesArray& files, int left, int right, BOOL reverse)
 // QuickSort   1.klic Ext, 2.klic Name
 //
 
-BOOL LessExtName(const CFileData& f1, const CFileData& f2, BOOL reverse)
+int CmpExtName(const CFileData& f1, const CFileData& f2)
 {
     //--- nejprve podle Ext
     BOOL numericalyEqual1;
@@ -414,14 +807,14 @@ BOOL LessExtName(const CFileData& f1, const CFileData& f2, BOOL reverse)
                                f2.Ext, f2.NameLen - (int)(f2.Ext - f2.Name),
                                &numericalyEqual1);
     if (!numericalyEqual1)
-        return reverse ? res1 > 0 : res1 < 0; // pripony se lisi (nejsou shodne ani numericky shodne)
-                                              //--- podle Ext se rovnaji, rozhodne Name
+        return res1; // pripony se lisi (nejsou shodne ani numericky shodne)
+                     //--- podle Ext se rovnaji, rozhodne Name
     BOOL numericalyEqual2;
     int res2 = RegSetStrICmpEx(f1.Name, (*f1.Ext != 0) ? (int)(f1.Ext - 1 - f1.Name) : f1.NameLen,
                                f2.Name, (*f2.Ext != 0) ? (int)(f2.Ext - 1 - f2.Name) : f2.NameLen,
                                &numericalyEqual2);
     if (numericalyEqual2 && res1 != 0)
-        return reverse ? res1 > 0 : res1 < 0; // pripony jsou shodne nebo numericky shodne a jmena jsou jen numericky shodna (porovnani jmen je prioritnejsi)
+        return res1; // pripony jsou shodne nebo numericky shodne a jmena jsou jen numericky shodna (porovnani jmen je prioritnejsi)
     else
     {
         if (res2 == 0 && f1.Name != f2.Name) // shodna jmena (archivy nebo FS) - zkusime jestli se nelisi aspon ve velikosti pismen
@@ -430,18 +823,24 @@ BOOL LessExtName(const CFileData& f1, const CFileData& f2, BOOL reverse)
                                   f2.Ext, f2.NameLen - (int)(f2.Ext - f2.Name),
                                   &numericalyEqual1);
             if (!numericalyEqual1)
-                return reverse ? res1 > 0 : res1 < 0; // pripony se lisi (nejsou shodne ani numericky shodne)
+                return res1; // pripony se lisi (nejsou shodne ani numericky shodne)
             //--- podle Ext se opet rovnaji, rozhodne Name
             res2 = RegSetStrCmpEx(f1.Name, (*f1.Ext != 0) ? (int)(f1.Ext - 1 - f1.Name) : f1.NameLen,
                                   f2.Name, (*f2.Ext != 0) ? (int)(f2.Ext - 1 - f2.Name) : f2.NameLen,
                                   &numericalyEqual2);
             if (numericalyEqual2 && res1 != 0)
-                return reverse ? res1 > 0 : res1 < 0; // jmena jsou shodna nebo numericky shodna a pripony jsou jen numericky shodne (porovnani pripon je prioritnejsi)
+                return res1; // jmena jsou shodna nebo numericky shodna a pripony jsou jen numericky shodne (porovnani pripon je prioritnejsi)
         }
-        return reverse ? res2 > 0 : res2 < 0;
+        return res2;
     }
 }
 
+BOOL LessExtName(const CFileData& f1, const CFileData& f2, BOOL reverse)
+{
+    int res = CmpExtName(f1, f2);
+    return reverse ? res > 0 : res < 0;
+}
+
 void SortExtNameAux(CFilesArray& files, int left, int right, BOOL reverse)
 {
 
@@ -506,7 +905,8 @@ LABEL_SortExtNameAux:
 
 void SortExtName(CFilesArray& files, int left, int right, BOOL reverse)
 {
-    SortExtNameAux(files, left, right, reverse);
+    if (!SortWithKeys(files, left, right, sktExt, reverse))
+        SortExtNameAux(files, left, right, reverse);
 }
 
 //
@@ -589,7 +989,8 @@ LABEL_SortTimeNameExtAux:
 
 void SortTimeNameExt(CFilesArray& files, int left, int right, BOOL reverse)
 {
-    SortTimeNameExtAux(files, left, right, reverse);
+    if (!SortWithKeys(files, left, right, sktTime, reverse))
+        SortTimeNameExtAux(files, left, right, reverse);
 }
 
 //
@@ -671,7 +1072,8 @@ LABEL_SortSizeNameExtAux:
 
 void SortSizeNameExt(CFilesArray& files, int left, int right, BOOL reverse)
 {
-    SortSizeNameExtAux(files, left, right, reverse);
+    if (!SortWithKeys(files, left, right, sktSize, reverse))
+        SortSizeNameExtAux(files, left, right, reverse);
 }
 
 //
@@ -681,47 +1083,8 @@ void SortSizeNameExt(CFilesArray& files, int left, int right, BOOL reverse)
 
 BOOL LessAttrNameExt(const CFileData& f1, const CFileData& f2, BOOL reverse)
 {
-    // okopcim FILE_ATTRIBUTE_READONLY na nejvyznamejsi bit
-    //  DWORD f1Attr = f1.Attr;
-    //  DWORD f2Attr = f2.Attr;
-    //  if (f1.Attr & FILE_ATTRIBUTE_READONLY) f1Attr |= 0x80000000;
-    //  if (f2.Attr & FILE_ATTRIBUTE_READONLY) f2Attr |= 0x80000000;
-
-    // pokud podporime zobrazovani dalsiho atributu,
-    // je treba rozsirit masku DISPLAYED_ATTRIBUTES
-
-    // prejdeme na abecedni razeni, jako ma explorer a speed commander
-    DWORD f1Attr = 0;
-    DWORD f2Attr = 0;
-    if (f1.Attr & FILE_ATTRIBUTE_ARCHIVE)
-        f1Attr |= 0x00000001;
-    if (f1.Attr & FILE_ATTRIBUTE_COMPRESSED)
-        f1Attr |= 0x00000002;
-    if (f1.Attr & FILE_ATTRIBUTE_ENCRYPTED)
-        f1Attr |= 0x00000004;
-    if (f1.Attr & FILE_ATTRIBUTE_HIDDEN)
-        f1Attr |= 0x00000008;
-    if (f1.Attr & FILE_ATTRIBUTE_READONLY)
-        f1Attr |= 0x00000010;
-    if (f1.Attr & FILE_ATTRIBUTE_SYSTEM)
-        f1Attr |= 0x00000020;
-    if (f1.Attr & FILE_ATTRIBUTE_TEMPORARY)
-        f1Attr |= 0x00000040;
-
-    if (f2.Attr & FILE_ATTRIBUTE_ARCHIVE)
-        f2Attr |= 0x00000001;
-    if (f2.Attr & FILE_ATTRIBUTE_COMPRESSED)
-        f2Attr |= 0x00000002;
-    if (f2.Attr & FILE_ATTRIBUTE_ENCRYPTED)
-        f2Attr |= 0x00000004;
-    if (f2.Attr & FILE_ATTRIBUTE_HIDDEN)
-        f2Attr |= 0x00000008;
-    if (f2.Attr & FILE_ATTRIBUTE_READONLY)
-        f2Attr |= 0x00000010;
-    if (f2.Attr & FILE_ATTRIBUTE_SYSTEM)
-        f2Attr |= 0x00000020;
-    if (f2.Attr & FILE_ATTRIBUTE_TEMPORARY)
-        f2Attr |= 0x00000040;
+    DWORD f1Attr = GetAttrSortKey(f1.Attr);
+    DWORD f2Attr = GetAttrSortKey(f2.Attr);
 
     //--- nejprve podle Attr
     if (f1Attr != f2Attr)
@@ -795,7 +1158,8 @@ LABEL_SortAttrNameExtAux:
 
 void SortAttrNameExt(CFilesArray& files, int left, int right, BOOL reverse)
 {
-    SortAttrNameExtAux(files, left, right, reverse);
+    if (!SortWithKeys(files, left, right, sktAttr, reverse))
+        SortAttrNameExtAux(files, left, right, reverse);
 }
 
 //
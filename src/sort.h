@@ -29,6 +29,8 @@ typedef BOOL (*CLessFunction)(const CFileData&, const CFileData&, BOOL);
 // porovnani pro dva soubory, 1. klic jmeno, 2. klic pripona, vraci -1, 0, 1 ala strcmp
 int CmpNameExt(const CFileData& f1, const CFileData& f2);
 int CmpNameExtIgnCase(const CFileData& f1, const CFileData& f2); // ignore-case varianta
+// porovnani pro dva soubory, 1. klic pripona, 2. klic jmeno, vraci -1, 0, 1 ala strcmp
+int CmpExtName(const CFileData& f1, const CFileData& f2);
 
 // POZOR: sort-kody v RefreshDirectory, ChangeSortType a CompareDirectories si musi odpovidat!!!
 
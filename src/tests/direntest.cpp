@@ -0,0 +1,287 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+//
+// ****************************************************************************
+// direntest - tester of the batched listing of disk directories (CDiskDirEnumerator)
+//
+// direnum.cpp is compiled into this program. A directory is listed by FindFirstFile/FindNextFile
+// and by CDiskDirEnumerator and both listings must contain the same entries with the same
+// WIN32_FIND_DATA content (names, short names, attributes, times, sizes, reparse tags); the
+// errors reported for a missing directory must be the same too. Then the listing of the
+// directory is measured both ways. Without the directory argument a directory with the given
+// number of files (long and short names, subdirectories, various attributes and sizes) is
+// created in TEMP and deleted at the end; pass a directory on a network share to measure
+// the listing of shares.
+//
+// Build (Visual Studio command prompt, in src\tests):
+//   cl /nologo /O2 /EHsc /J /DNDEBUG /DMESSAGES_DISABLE /DCALLSTK_DISABLE /I.. /I..\common
+//      /I..\common\dep /I..\plugins\shared direntest.cpp
+//
+// Usage: direntest [directory|- [files [rounds]]]
+
+#include "precomp.h"
+
+#include "direnum.h"
+
+// the only thing direnum.cpp needs from the rest of Salamander
+const char* LOW_MEMORY = "Low memory.";
+
+#include "../direnum.cpp"
+
+static DWORD RandSeed = 1;
+
+static DWORD Rand()
+{
+    RandSeed = RandSeed * 1103515245 + 12345;
+    return RandSeed >> 8;
+}
+
+static double GetSeconds()
+{
+    LARGE_INTEGER c, f;
+    QueryPerformanceCounter(&c);
+    QueryPerformanceFrequency(&f);
+    return (double)c.QuadPart / (double)f.QuadPart;
+}
+
+// listing of one directory; 'batched' = through CDiskDirEnumerator, otherwise FindFirstFile
+static TDirectArray<WIN32_FIND_DATA>* ListDirectory(const char* dir, BOOL batched, DWORD* error)
+{
+    char pattern[MAX_PATH];
+    _snprintf_s(pattern, _TRUNCATE, "%s\\*", dir);
+    TDirectArray<WIN32_FIND_DATA>* list = new TDirectArray<WIN32_FIND_DATA>(1000, 10000);
+    WIN32_FIND_DATA data;
+    *error = ERROR_SUCCESS;
+    if (batched)
+    {
+        CDiskDirEnumerator enumerator;
+        BOOL ok = enumerator.FindFirst(pattern, &data);
+        while (ok)
+        {
+            list->Add(data);
+            ok = enumerator.FindNext(&data);
+        }
+        *error = GetLastError();
+    }
+    else
+    {
+        HANDLE find = FindFirstFile(pattern, &data);
+        if (find == INVALID_HANDLE_VALUE)
+            *error = GetLastError();
+        else
+        {
+            do
+            {
+                list->Add(data);
+            } while (FindNextFile(find, &data));
+            *error = GetLastError();
+            FindClose(find);
+        }
+    }
+    return list;
+}
+
+static int CompareFindData(const void* d1, const void* d2)
+{
+    return strcmp(((const WIN32_FIND_DATA*)d1)->cFileName, ((const WIN32_FIND_DATA*)d2)->cFileName);
+}
+
+static BOOL SameTime(const FILETIME& t1, const FILETIME& t2)
+{
+    return t1.dwLowDateTime == t2.dwLowDateTime && t1.dwHighDateTime == t2.dwHighDateTime;
+}
+
+static int CompareListings(const char* dir)
+{
+    DWORD errorOld, errorNew;
+    TDirectArray<WIN32_FIND_DATA>* oldList = ListDirectory(dir, FALSE, &errorOld);
+    TDirectArray<WIN32_FIND_DATA>* newList = ListDirectory(dir, TRUE, &errorNew);
+    int failures = 0;
+    if (errorOld != errorNew)
+    {
+        printf("MISMATCH (%s): FindFirstFile ends with error %u, CDiskDirEnumerator with %u\n", dir, errorOld, errorNew);
+        failures++;
+    }
+    if (oldList->Count != newList->Count)
+    {
+        printf("MISMATCH (%s): FindFirstFile returns %d entries, CDiskDirEnumerator %d\n", dir, oldList->Count,
+               newList->Count);
+        failures++;
+    }
+    else
+    {
+        // both return the order of the file system, but do not rely on it
+        qsort(oldList->GetData(), oldList->Count, sizeof(WIN32_FIND_DATA), CompareFindData);
+        qsort(newList->GetData(), newList->Count, sizeof(WIN32_FIND_DATA), CompareFindData);
+        int i;
+        for (i = 0; i < oldList->Count && failures < 10; i++)
+        {
+            const WIN32_FIND_DATA& o = oldList->At(i);
+            const WIN32_FIND_DATA& n = newList->At(i);
+            const char* what = NULL;
+            if (strcmp(o.cFileName, n.cFileName) != 0)
+                what = "name";
+            else if (strcmp(o.cAlternateFileName, n.cAlternateFileName) != 0)
+                what = "short name";
+            else if (o.dwFileAttributes != n.dwFileAttributes)
+                what = "attributes";
+            else if (!SameTime(o.ftCreationTime, n.ftCreationTime) || !SameTime(o.ftLastWriteTime, n.ftLastWriteTime) ||
+                     !SameTime(o.ftLastAccessTime, n.ftLastAccessTime))
+                what = "times";
+            else if (o.nFileSizeLow != n.nFileSizeLow || o.nFileSizeHigh != n.nFileSizeHigh)
+                what = "size";
+            else if ((o.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) && o.dwReserved0 != n.dwReserved0)
+                what = "reparse tag";
+            if (what != NULL)
+            {
+                printf("MISMATCH (%s): %s of \"%s\" differs (\"%s\" in the batched listing)\n", dir, what,
+                       o.cFileName, n.cFileName);
+                failures++;
+            }
+        }
+    }
+    printf("%s: %d entries, %d mismatches\n", dir, oldList->Count, failures);
+    delete oldList;
+    delete newList;
+    return failures;
+}
+
+// creates 'files' files and a few subdirectories in 'dir'; returns FALSE on error
+static BOOL CreateTestDirectory(const char* dir, int files)
+{
+    static const char* parts[] = {"a", "Document", "report 2023", "x", "longer file name", "IMG_", "~tmp", "1"};
+    static const char* exts[] = {"", ".txt", ".jpeg", ".c", ".tar.gz", ".html", ".1"};
+    if (!CreateDirectory(dir, NULL))
+    {
+        printf("Unable to create directory %s (error %u).\n", dir, GetLastError());
+        return FALSE;
+    }
+    char buf[4096];
+    memset(buf, 'x', sizeof(buf));
+    int i;
+    for (i = 0; i < files; i++)
+    {
+        char name[MAX_PATH];
+        _snprintf_s(name, _TRUNCATE, "%s\\%s%d%s", dir, parts[Rand() % ARRAYSIZE(parts)], i, exts[Rand() % ARRAYSIZE(exts)]);
+        if (i % 100 == 0)
+        {
+            CreateDirectory(name, NULL);
+            continue;
+        }
+        DWORD attr = Rand() % 5 == 0 ? FILE_ATTRIBUTE_HIDDEN : Rand() % 5 == 0 ? FILE_ATTRIBUTE_READONLY : FILE_ATTRIBUTE_NORMAL;
+        HANDLE file = CreateFile(name, GENERIC_WRITE, 0, NULL, CREATE_NEW, attr, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            printf("Unable to create file %s (error %u).\n", name, GetLastError());
+            return FALSE;
+        }
+        DWORD size = Rand() % 3 == 0 ? 0 : Rand() % sizeof(buf);
+        DWORD written;
+        WriteFile(file, buf, size, &written, NULL);
+        CloseHandle(file);
+    }
+    // an empty subdirectory (FindFirstFile returns just "." and "..")
+    char empty[MAX_PATH];
+    _snprintf_s(empty, _TRUNCATE, "%s\\empty", dir);
+    CreateDirectory(empty, NULL);
+    return TRUE;
+}
+
+static void DeleteTestDirectory(const char* dir)
+{
+    char pattern[MAX_PATH];
+    _snprintf_s(pattern, _TRUNCATE, "%s\\*", dir);
+    WIN32_FIND_DATA data;
+    HANDLE find = FindFirstFile(pattern, &data);
+    if (find != INVALID_HANDLE_VALUE)
+    {
+        do
+        {
+            if (strcmp(data.cFileName, ".") == 0 || strcmp(data.cFileName, "..") == 0)
+                continue;
+            char name[MAX_PATH];
+            _snprintf_s(name, _TRUNCATE, "%s\\%s", dir, data.cFileName);
+            if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+                RemoveDirectory(name);
+            else
+            {
+                SetFileAttributes(name, FILE_ATTRIBUTE_NORMAL);
+                DeleteFile(name);
+            }
+        } while (FindNextFile(find, &data));
+        FindClose(find);
+    }
+    RemoveDirectory(dir);
+}
+
+static void Benchmark(const char* dir, int rounds)
+{
+    printf("\n%-22s %10s %12s %14s\n", "listing", "entries", "ms/listing", "entries/s");
+    double times[2] = {0, 0};
+    int entries = 0;
+    int round;
+    for (round = 0; round < rounds; round++)
+    {
+        int batched;
+        for (batched = 0; batched < 2; batched++) // alternately, so both get the same caches
+        {
+            DWORD error;
+            double t = GetSeconds();
+            TDirectArray<WIN32_FIND_DATA>* list = ListDirectory(dir, batched, &error);
+            t = GetSeconds() - t;
+            if (round == 0 || t < times[batched]) // the best run
+                times[batched] = t;
+            entries = list->Count;
+            delete list;
+        }
+    }
+    int batched;
+    for (batched = 0; batched < 2; batched++)
+    {
+        printf("%-22s %10d %12.1f %14.0f\n", batched ? "CDiskDirEnumerator" : "FindFirstFile", entries,
+               times[batched] * 1000, times[batched] > 0 ? entries / times[batched] : 0.0);
+    }
+    if (times[1] > 0)
+        printf("speedup: %.2f\n", times[0] / times[1]);
+}
+
+int main(int argc, char* argv[])
+{
+    const char* dirArg = argc > 1 ? argv[1] : "-";
+    int files = argc > 2 ? atoi(argv[2]) : 20000;
+    int rounds = argc > 3 ? atoi(argv[3]) : 5;
+
+    char dir[MAX_PATH];
+    BOOL created = strcmp(dirArg, "-") == 0;
+    if (created)
+    {
+        char temp[MAX_PATH];
+        GetTempPath(MAX_PATH, temp);
+        _snprintf_s(dir, _TRUNCATE, "%sdirentest.%u", temp, GetCurrentProcessId());
+        printf("creating %d files in %s\n", files, dir);
+        if (!CreateTestDirectory(dir, files))
+        {
+            DeleteTestDirectory(dir);
+            return 1;
+        }
+    }
+    else
+        lstrcpyn(dir, dirArg, MAX_PATH);
+
+    int failures = CompareListings(dir);
+    if (created)
+    {
+        char sub[MAX_PATH];
+        _snprintf_s(sub, _TRUNCATE, "%s\\empty", dir);
+        failures += CompareListings(sub);
+        _snprintf_s(sub, _TRUNCATE, "%s\\does not exist", dir);
+        failures += CompareListings(sub);
+    }
+    if (rounds > 0)
+        Benchmark(dir, rounds);
+
+    if (created)
+        DeleteTestDirectory(dir);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,292 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+//
+// ****************************************************************************
+// dirtest - tester of the hash index of subdirectory names in CSalamanderDirectory
+//
+// CSalamanderDirectory (salamdir.cpp) is compiled into this program. Directories with random
+// names (case variants, duplicates, nested paths) are built by AddDir and AddFile like archive
+// listings are, then FindDirIndex (which uses the index from SALDIR_INDEX_MIN_DIRS
+// subdirectories on) is compared with the linear search of Dirs that was used before, in case
+// sensitive and insensitive directories and after SetFlags switches between them. Then the
+// build of wide directories and the searching of their subdirectories is measured.
+//
+// Build (Visual Studio command prompt, in src\tests):
+//   cl /nologo /O2 /EHsc /J /DNDEBUG /DMESSAGES_DISABLE /DCALLSTK_DISABLE /I.. /I..\common
+//      /I..\common\dep /I..\plugins\shared dirtest.cpp ..\common\str.cpp user32.lib
+//
+// Usage: dirtest [iterations [benchmark_dirs]]
+
+#include "precomp.h"
+
+#include "cfgdlg.h"
+#include "plugins.h"
+#include "zip.h"
+
+// the few things salamdir.cpp needs from the rest of Salamander
+const char* LOW_MEMORY = "Low memory.";
+const char* STR_NONE = "(none)";
+
+void EnterPlugin() {}
+void LeavePlugin() {}
+
+int DeltaForTotalCount(int total)
+{
+    int delta = total / 10;
+    if (delta < 1)
+        delta = 1;
+    else if (delta > 10000)
+        delta = 10000;
+    return delta;
+}
+
+void CPluginDataInterfaceEncapsulation::ReleaseFilesOrDirs(CFilesArray* filesOrDirs, BOOL areDirs)
+{
+    // no plugin data are used here
+}
+
+void CNamesArena::Release()
+{
+    while (Blocks != NULL)
+    {
+        CBlock* next = Blocks->Next;
+        free(Blocks);
+        Blocks = next;
+    }
+}
+
+struct CTesterConfiguration
+{
+    BOOL SortDirsByExt;
+};
+
+CTesterConfiguration TesterConfiguration = {FALSE};
+
+#define Configuration TesterConfiguration
+
+#include "../salamdir.cpp"
+
+class CTestDirectory : public CSalamanderDirectory
+{
+public:
+    CTestDirectory(DWORD flags) : CSalamanderDirectory(FALSE, VALID_DATA_NONE, flags) {}
+
+    int Find(const char* name, int nameLen) { return FindDirIndex(name, nameLen); }
+
+    // the search of subdirectories before the index was added
+    int FindLinear(const char* name, int nameLen)
+    {
+        int i;
+        for (i = 0; i < Dirs.Count; i++)
+        {
+            if (SalDirStrCmpEx(Dirs[i].Name, Dirs[i].NameLen, name, nameLen) == 0)
+                return i;
+        }
+        return -1;
+    }
+
+    BOOL HasIndex() { return DirsIndex != NULL; }
+};
+
+static DWORD RandSeed = 1;
+
+static DWORD Rand()
+{
+    RandSeed = RandSeed * 1103515245 + 12345;
+    return RandSeed >> 8;
+}
+
+static double GetSeconds()
+{
+    LARGE_INTEGER c, f;
+    QueryPerformanceCounter(&c);
+    QueryPerformanceFrequency(&f);
+    return (double)c.QuadPart / (double)f.QuadPart;
+}
+
+static BOOL AddTestDir(CSalamanderDirectory* dir, const char* path, const char* name)
+{
+    CFileData data;
+    memset(&data, 0, sizeof(data));
+    data.Name = DupStr(name);
+    if (data.Name == NULL)
+        return FALSE;
+    data.NameLen = (unsigned)strlen(name);
+    data.Ext = data.Name + data.NameLen;
+    if (!dir->AddDir(path, data, NULL))
+    {
+        free(data.Name);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static BOOL AddTestFile(CSalamanderDirectory* dir, const char* path, const char* name)
+{
+    CFileData data;
+    memset(&data, 0, sizeof(data));
+    data.Name = DupStr(name);
+    if (data.Name == NULL)
+        return FALSE;
+    data.NameLen = (unsigned)strlen(name);
+    data.Ext = data.Name + data.NameLen;
+    if (!dir->AddFile(path, data, NULL))
+    {
+        free(data.Name);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// random name from a small alphabet (so there are duplicates and case variants)
+static void RandomName(char* name, int maxLen)
+{
+    static const char chars[] = "abAB01._\xe1\xc1";
+    int len = 1 + Rand() % maxLen;
+    int i;
+    for (i = 0; i < len; i++)
+        name[i] = chars[Rand() % (sizeof(chars) - 1)];
+    name[len] = 0;
+}
+
+static int CompareSearches(CTestDirectory* dir, char names[][16], int namesCount, const char* state)
+{
+    int failures = 0;
+    int i;
+    for (i = 0; i < namesCount + 50; i++)
+    {
+        char name[16];
+        if (i < namesCount)
+        {
+            strcpy(name, names[i]);
+            if (Rand() % 2 == 0) // the same name in another case
+            {
+                char* s;
+                for (s = name; *s != 0; s++)
+                    *s = (char)(Rand() % 2 == 0 ? LowerCase[(BYTE)*s] : UpperCase[(BYTE)*s]);
+            }
+        }
+        else
+            RandomName(name, 6); // mostly names which are not there
+        int nameLen = (int)strlen(name);
+        int found = dir->Find(name, nameLen);
+        int expected = dir->FindLinear(name, nameLen);
+        if (found != expected)
+        {
+            printf("MISMATCH (%s, %d subdirectories, index %s): \"%s\" found at %d, expected %d\n", state,
+                   dir->GetDirsCount(), dir->HasIndex() ? "used" : "not used", name, found, expected);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+static int TestCorrectness(int iterations)
+{
+    static char names[600][16];
+    int failures = 0;
+    int it;
+    for (it = 0; it < iterations && failures < 10; it++)
+    {
+        DWORD flags = Rand() % 4; // SALDIRFLAG_CASESENSITIVE, SALDIRFLAG_IGNOREDUPDIRS
+        CTestDirectory dir(flags);
+        int namesCount = Rand() % (it % 4 == 0 ? 600 : 80);
+        int i;
+        for (i = 0; i < namesCount; i++)
+        {
+            RandomName(names[i], 5);
+            BOOL ok;
+            if (Rand() % 3 == 0)
+            {
+                // the subdirectory is created by adding a file (or a directory) into it
+                char path[40];
+                sprintf(path, "%s\\%s", names[i], Rand() % 2 == 0 ? "sub" : "sub\\deeper");
+                ok = Rand() % 2 == 0 ? AddTestFile(&dir, path, "file.txt") : AddTestDir(&dir, path, "dir");
+            }
+            else
+                ok = AddTestDir(&dir, "", names[i]);
+            if (!ok)
+            {
+                printf("Unable to add \"%s\".\n", names[i]);
+                failures++;
+            }
+        }
+        failures += CompareSearches(&dir, names, namesCount, flags & SALDIRFLAG_CASESENSITIVE ? "case sensitive" : "ignore case");
+
+        // the hashes depend on SALDIRFLAG_CASESENSITIVE
+        dir.SetFlags(flags ^ SALDIRFLAG_CASESENSITIVE);
+        failures += CompareSearches(&dir, names, namesCount, "after SetFlags");
+
+        // directories added to an existing index
+        for (i = 0; i < 40 && namesCount < 600; i++)
+        {
+            RandomName(names[namesCount], 8);
+            AddTestDir(&dir, "", names[namesCount++]);
+        }
+        failures += CompareSearches(&dir, names, namesCount, "after AddDir");
+    }
+    printf("correctness: %d iterations, %d mismatches\n", it, failures);
+    return failures;
+}
+
+static void Benchmark(int maxDirs)
+{
+    printf("\n%10s %12s %16s %16s %8s\n", "dirs", "build ms", "indexed ns/find", "linear ns/find", "speedup");
+    int count;
+    for (count = 100; count <= maxDirs; count *= 10)
+    {
+        // like an archive listing: every subdirectory is created by its first file, the other
+        // files of it come later (so each AddFile searches the subdirectory by name)
+        CTestDirectory dir(0);
+        char path[40];
+        double t = GetSeconds();
+        int round;
+        for (round = 0; round < 3; round++)
+        {
+            int i;
+            for (i = 0; i < count; i++)
+            {
+                sprintf(path, "Directory %07d", i);
+                char name[20];
+                sprintf(name, "file%d.dat", round);
+                AddTestFile(&dir, path, name);
+            }
+        }
+        double build = GetSeconds() - t;
+
+        int finds = count < 5000 ? count : 5000;
+        int step = count / finds;
+        int found = 0;
+        t = GetSeconds();
+        int i;
+        for (i = 0; i < finds; i++)
+        {
+            sprintf(path, "directory %07d", i * step);
+            found += dir.Find(path, (int)strlen(path)) >= 0;
+        }
+        double indexed = GetSeconds() - t;
+        t = GetSeconds();
+        for (i = 0; i < finds; i++)
+        {
+            sprintf(path, "directory %07d", i * step);
+            found += dir.FindLinear(path, (int)strlen(path)) >= 0;
+        }
+        double linear = GetSeconds() - t;
+        if (found != 2 * finds)
+            printf("benchmark: some directories were not found\n");
+        printf("%10d %12.1f %16.0f %16.0f %8.1f\n", count, build * 1000, indexed * 1e9 / finds, linear * 1e9 / finds,
+               indexed > 0 ? linear / indexed : 0.0);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 2000;
+    int maxDirs = argc > 2 ? atoi(argv[2]) : 100000;
+
+    int failures = TestCorrectness(iterations);
+    if (maxDirs > 0)
+        Benchmark(maxDirs);
+    return failures == 0 ? 0 : 1;
+}
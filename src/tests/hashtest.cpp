@@ -0,0 +1,266 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+//
+// ****************************************************************************
+// hashtest - tester of the accelerated CRC-32, SHA-1 and SHA-256 kernels
+//
+// UpdateCrc32 (salcrc.cpp), SHA1Update (common/dep/crypt/sha1.c) and sha256_process (the
+// Checksum plugin's tomcrypt/sha256.cpp) are compiled into this program, so their internal
+// switches can be turned off and the fast paths (PCLMULQDQ folding, SHA extensions) can be
+// compared with the portable ones: CRC-32 with a bitwise reference, both SHA kernels with
+// the portable transforms, on random data with random chunking and alignment, and with the
+// known test vectors. Then the throughput of every path is measured.
+//
+// Build (Visual Studio command prompt, in src\tests):
+//   cl /nologo /O2 /EHsc /J /DNDEBUG /DMESSAGES_DISABLE /DCALLSTK_DISABLE /I.. /I..\common
+//      /I..\common\dep /I..\plugins\shared hashtest.cpp
+//
+// Usage: hashtest [iterations [benchmark_MB]]
+
+#include "precomp.h"
+
+#include "../salcrc.cpp"
+
+#include "../common/dep/crypt/sha1.c"
+
+#include "../plugins/checksum/tomcrypt/sha256.cpp"
+
+static DWORD RandSeed = 1;
+
+static DWORD Rand()
+{
+    RandSeed = RandSeed * 1103515245 + 12345;
+    return RandSeed >> 8;
+}
+
+static double GetSeconds()
+{
+    LARGE_INTEGER c, f;
+    QueryPerformanceCounter(&c);
+    QueryPerformanceFrequency(&f);
+    return (double)c.QuadPart / (double)f.QuadPart;
+}
+
+static DWORD RefCrc32(const BYTE* p, DWORD count, DWORD crc)
+{
+    crc = ~crc;
+    while (count--)
+    {
+        crc ^= *p++;
+        int k;
+        for (k = 0; k < 8; k++)
+            crc = (crc & 1) ? 0xedb88320 ^ (crc >> 1) : crc >> 1;
+    }
+    return ~crc;
+}
+
+// hashes 'data' in random pieces (at most 'maxPiece' bytes)
+static void Sha1Chunked(const BYTE* data, DWORD size, DWORD maxPiece, BYTE* digest)
+{
+    SHA1_CTX ctx;
+    SHA1Init(&ctx);
+    DWORD pos = 0;
+    while (pos < size)
+    {
+        DWORD piece = Rand() % (maxPiece + 1);
+        if (piece > size - pos)
+            piece = size - pos;
+        SHA1Update(&ctx, data + pos, piece);
+        pos += piece;
+    }
+    SHA1Final(digest, &ctx);
+}
+
+static void Sha256Chunked(const BYTE* data, DWORD size, DWORD maxPiece, BYTE* digest)
+{
+    hash_state md;
+    sha256_init(&md);
+    DWORD pos = 0;
+    while (pos < size)
+    {
+        DWORD piece = Rand() % (maxPiece + 1);
+        if (piece > size - pos)
+            piece = size - pos;
+        sha256_process(&md, data + pos, piece);
+        pos += piece;
+    }
+    sha256_done(&md, digest);
+}
+
+static void ToHex(const BYTE* digest, int len, char* hex)
+{
+    int i;
+    for (i = 0; i < len; i++)
+        sprintf(hex + 2 * i, "%02x", digest[i]);
+}
+
+static int TestVectors()
+{
+    int failures = 0;
+    char hex[65];
+    BYTE digest[32];
+    int fast;
+    for (fast = 0; fast < 2; fast++)
+    {
+        Crc32UseCLMUL = fast && (GetCPUFeatures() & (CPUF_PCLMULQDQ | CPUF_SSE41)) == (CPUF_PCLMULQDQ | CPUF_SSE41);
+        SHA1SHANI = fast ? -1 : 0;
+        sha256_shani = fast ? -1 : 0;
+
+        if (UpdateCrc32("123456789", 9, 0) != 0xcbf43926)
+        {
+            printf("CRC-32 test vector failed\n");
+            failures++;
+        }
+        SHA1_CTX ctx;
+        SHA1Init(&ctx);
+        SHA1Update(&ctx, (const unsigned char*)"abc", 3);
+        SHA1Final(digest, &ctx);
+        ToHex(digest, 20, hex);
+        if (strcmp(hex, "a9993e364706816aba3e25717850c26c9cd0d89d") != 0)
+        {
+            printf("SHA-1 test vector failed: %s\n", hex);
+            failures++;
+        }
+        hash_state md;
+        sha256_init(&md);
+        sha256_process(&md, (const unsigned char*)"abc", 3);
+        sha256_done(&md, digest);
+        ToHex(digest, 32, hex);
+        if (strcmp(hex, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad") != 0)
+        {
+            printf("SHA-256 test vector failed: %s\n", hex);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+static int TestRandom(int iterations)
+{
+    const DWORD maxSize = 70000;
+    BYTE* buf = (BYTE*)malloc(maxSize + 64);
+    if (buf == NULL)
+        return 1;
+    DWORD i;
+    for (i = 0; i < maxSize + 64; i++)
+        buf[i] = (BYTE)Rand();
+
+    BOOL clmul = (GetCPUFeatures() & (CPUF_PCLMULQDQ | CPUF_SSE41)) == (CPUF_PCLMULQDQ | CPUF_SSE41);
+    int failures = 0;
+    int it;
+    for (it = 0; it < iterations && failures < 10; it++)
+    {
+        const BYTE* data = buf + Rand() % 64; // any alignment
+        DWORD size = Rand() % (it % 2 == 0 ? 600 : maxSize);
+        DWORD seed = Rand();
+
+        DWORD ref = RefCrc32(data, size, seed);
+        Crc32UseCLMUL = FALSE;
+        DWORD slice8 = UpdateCrc32(data, size, seed);
+        Crc32UseCLMUL = clmul;
+        DWORD fast = UpdateCrc32(data, size, seed);
+        if (slice8 != ref || fast != ref)
+        {
+            printf("CRC-32 MISMATCH (size %u): reference %08x, slice-by-8 %08x, CLMUL %08x\n", size, ref, slice8, fast);
+            failures++;
+        }
+
+        // the chunking depends on Rand(), so both runs get the same sequence of pieces
+        DWORD maxPiece = Rand() % 3 == 0 ? 70 : 5000;
+        DWORD pieceSeed = Rand();
+        BYTE d1[32], d2[32];
+        RandSeed = pieceSeed;
+        SHA1SHANI = 0;
+        Sha1Chunked(data, size, maxPiece, d1);
+        RandSeed = pieceSeed;
+        SHA1SHANI = -1;
+        Sha1Chunked(data, size, maxPiece, d2);
+        if (memcmp(d1, d2, 20) != 0)
+        {
+            printf("SHA-1 MISMATCH (size %u, pieces up to %u)\n", size, maxPiece);
+            failures++;
+        }
+        RandSeed = pieceSeed;
+        sha256_shani = 0;
+        Sha256Chunked(data, size, maxPiece, d1);
+        RandSeed = pieceSeed;
+        sha256_shani = -1;
+        Sha256Chunked(data, size, maxPiece, d2);
+        if (memcmp(d1, d2, 32) != 0)
+        {
+            printf("SHA-256 MISMATCH (size %u, pieces up to %u)\n", size, maxPiece);
+            failures++;
+        }
+    }
+    free(buf);
+    printf("random inputs: %d iterations, %d mismatches\n", it, failures);
+    return failures;
+}
+
+static void Benchmark(int megabytes)
+{
+    DWORD size = megabytes * 1024 * 1024;
+    BYTE* buf = (BYTE*)malloc(size);
+    if (buf == NULL)
+        return;
+    DWORD i;
+    for (i = 0; i < size; i++)
+        buf[i] = (BYTE)(i * 7 + (i >> 11));
+
+    BOOL clmul = (GetCPUFeatures() & (CPUF_PCLMULQDQ | CPUF_SSE41)) == (CPUF_PCLMULQDQ | CPUF_SSE41);
+    printf("\n%-10s %-22s %10s\n", "algorithm", "path", "MB/s");
+    double t;
+    int fast;
+    for (fast = 0; fast < 2; fast++)
+    {
+        Crc32UseCLMUL = fast && clmul;
+        t = GetSeconds();
+        UpdateCrc32(buf, size, 0);
+        t = GetSeconds() - t;
+        printf("%-10s %-22s %10.0f\n", "CRC-32", fast ? (clmul ? "PCLMULQDQ" : "PCLMULQDQ (n/a)") : "slice-by-8", megabytes / t);
+    }
+    for (fast = 0; fast < 2; fast++)
+    {
+        SHA1SHANI = fast ? -1 : 0;
+        BYTE digest[32];
+        SHA1_CTX ctx;
+        t = GetSeconds();
+        SHA1Init(&ctx);
+        SHA1Update(&ctx, buf, size);
+        SHA1Final(digest, &ctx);
+        t = GetSeconds() - t;
+        printf("%-10s %-22s %10.0f\n", "SHA-1", fast ? (SHA1HasSHANI() ? "SHA extensions" : "SHA extensions (n/a)") : "portable", megabytes / t);
+    }
+    for (fast = 0; fast < 2; fast++)
+    {
+        sha256_shani = fast ? -1 : 0;
+        BYTE digest[32];
+        hash_state md;
+        t = GetSeconds();
+        sha256_init(&md);
+        sha256_process(&md, buf, size);
+        sha256_done(&md, digest);
+        t = GetSeconds() - t;
+        printf("%-10s %-22s %10.0f\n", "SHA-256", fast ? (sha256_has_shani() ? "SHA extensions" : "SHA extensions (n/a)") : "portable", megabytes / t);
+    }
+    free(buf);
+}
+
+int main(int argc, char* argv[])
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 20000;
+    int megabytes = argc > 2 ? atoi(argv[2]) : 256;
+
+    unsigned int features = GetCPUFeatures();
+    printf("CPU: PCLMULQDQ %s, SSE4.1 %s, SHA extensions %s\n", (features & CPUF_PCLMULQDQ) ? "yes" : "no",
+           (features & CPUF_SSE41) ? "yes" : "no", (features & CPUF_SHA) ? "yes" : "no");
+
+    InitCrc32Tables(); // later calls of UpdateCrc32 must not overwrite Crc32UseCLMUL
+
+    int failures = TestVectors();
+    failures += TestRandom(iterations);
+    if (megabytes > 0)
+        Benchmark(megabytes);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,251 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+//
+// ****************************************************************************
+// sorttest - tester of the panel sorting through precomputed sort keys (sort.cpp)
+//
+// sort.cpp is compiled into this program. Random listings (names with digits, case variants,
+// identical names as in archives, few distinct times, sizes and attributes) are sorted by
+// name, extension, time, size and attributes, forward and reverse, in all modes of name
+// comparison (StrICmpEx, locale, numbers detection), by the original in-place QuickSorts
+// (Sort*Aux) and by the key path (Sort*). Both must give exactly the same order, including
+// the order of items the comparison functions consider equal, also for listings big enough
+// to be sorted in several threads. Then both are measured on a big listing.
+//
+// Build (Visual Studio command prompt, in src\tests):
+//   cl /nologo /O2 /EHsc /J /DNDEBUG /DMESSAGES_DISABLE /DCALLSTK_DISABLE /I.. /I..\common
+//      /I..\common\dep /I..\plugins\shared sorttest.cpp ..\common\str.cpp user32.lib
+//
+// Usage: sorttest [iterations [benchmark_items]]
+
+#include "precomp.h"
+
+#include "cfgdlg.h"
+
+// the few things sort.cpp needs from the rest of Salamander
+const char* LOW_MEMORY = "Low memory.";
+BOOL WindowsVistaAndLater = TRUE; // numbers detection splits names also at dots
+
+void SetThreadNameInVCAndTrace(const char* name) {}
+
+CSystemPolicies::CSystemPolicies()
+    : RestrictRunList(10, 50), DisallowRunList(10, 50)
+{
+    NoDotBreakInLogicalCompare = 0;
+}
+
+CSystemPolicies::~CSystemPolicies()
+{
+}
+
+CSystemPolicies SystemPolicies;
+
+void CNamesArena::Release()
+{
+    while (Blocks != NULL)
+    {
+        CBlock* next = Blocks->Next;
+        free(Blocks);
+        Blocks = next;
+    }
+}
+
+struct CTesterConfiguration
+{
+    BOOL SortDetectNumbers;
+    BOOL SortUsesLocale;
+    BOOL SortNewerOnTop;
+};
+
+CTesterConfiguration TesterConfiguration = {FALSE, FALSE, FALSE};
+
+#define Configuration TesterConfiguration
+
+#include "../sort.cpp"
+
+typedef void (*CSortFunction)(CFilesArray& files, int left, int right, BOOL reverse);
+
+static const char* SortNames[] = {"name", "extension", "time", "size", "attributes"};
+static const CSortFunction OldSorts[] = {SortNameExtAux, SortExtNameAux, SortTimeNameExtAux, SortSizeNameExtAux,
+                                         SortAttrNameExtAux};
+static const CSortFunction NewSorts[] = {SortNameExt, SortExtName, SortTimeNameExt, SortSizeNameExt, SortAttrNameExt};
+
+static const char* ModeNames[] = {"StrICmpEx", "locale", "numbers"};
+
+static DWORD RandSeed = 1;
+
+static DWORD Rand()
+{
+    RandSeed = RandSeed * 1103515245 + 12345;
+    return RandSeed >> 8;
+}
+
+static double GetSeconds()
+{
+    LARGE_INTEGER c, f;
+    QueryPerformanceCounter(&c);
+    QueryPerformanceFrequency(&f);
+    return (double)c.QuadPart / (double)f.QuadPart;
+}
+
+static void SetMode(int mode, BOOL newerOnTop)
+{
+    TesterConfiguration.SortUsesLocale = mode == 1;
+    TesterConfiguration.SortDetectNumbers = mode == 2;
+    TesterConfiguration.SortNewerOnTop = newerOnTop;
+}
+
+// fills 'items' with a random listing; 'distinct' = all names differ (a directory on disk),
+// otherwise there are identical names (an archive) and names differing only in case
+static void MakeListing(CFileData* items, int count, BOOL distinct)
+{
+    static const char* stems[] = {"a", "A", "file", "File", "readme", "x1", "x01", "x10", "x2", "Setup", "z"};
+    static const char* exts[] = {"", ".txt", ".TXT", ".c", ".cpp", ".h", ".tar.gz", ".1", ".01", ".10", ".bak"};
+    static const DWORD attrs[] = {FILE_ATTRIBUTE_ARCHIVE, FILE_ATTRIBUTE_HIDDEN, FILE_ATTRIBUTE_READONLY,
+                                  FILE_ATTRIBUTE_SYSTEM, FILE_ATTRIBUTE_COMPRESSED, FILE_ATTRIBUTE_TEMPORARY};
+    int i;
+    for (i = 0; i < count; i++)
+    {
+        char name[MAX_PATH];
+        const char* stem = stems[Rand() % ARRAYSIZE(stems)];
+        const char* ext = exts[Rand() % ARRAYSIZE(exts)];
+        if (distinct)
+            sprintf(name, "%s%d%s", stem, i, ext);
+        else if (Rand() % 3 == 0)
+            sprintf(name, "%s%s", stem, ext);
+        else
+            sprintf(name, "%s%u%s", stem, Rand() % 20, ext);
+        CFileData* f = &items[i];
+        memset(f, 0, sizeof(CFileData));
+        f->NameLen = (unsigned)strlen(name);
+        f->Name = (char*)malloc(f->NameLen + 1);
+        memcpy(f->Name, name, f->NameLen + 1);
+        char* s = f->Name + f->NameLen;
+        while (--s >= f->Name && *s != '.')
+            ;
+        f->Ext = s >= f->Name ? s + 1 : f->Name + f->NameLen;
+        f->Size.Value = Rand() % 4 == 0 ? Rand() % 3 : Rand() % 100000;
+        f->LastWrite.dwHighDateTime = 30000000 + Rand() % 3;
+        f->LastWrite.dwLowDateTime = Rand() % 2 == 0 ? 0 : Rand();
+        f->Attr = attrs[Rand() % ARRAYSIZE(attrs)] | (Rand() % 2 == 0 ? attrs[Rand() % ARRAYSIZE(attrs)] : 0);
+    }
+}
+
+static void FillArray(CFilesArray& array, const CFileData* items, int count)
+{
+    array.DestroyMembers();
+    int i;
+    for (i = 0; i < count; i++)
+        array.Add(items[i]);
+}
+
+static int TestOrder(int iterations)
+{
+    CFilesArray oldArray, newArray;
+    oldArray.SetDeleteData(FALSE); // the names belong to 'items'
+    newArray.SetDeleteData(FALSE);
+    int failures = 0;
+    int big = 0;
+    int it;
+    for (it = 0; it < iterations && failures < 10; it++)
+    {
+        // every 25th listing is big enough to be sorted in several threads (if the CPU has more cores)
+        int count = it % 25 == 24 ? SORT_PARALLEL_MIN_ITEMS + Rand() % 20000 : Rand() % 400;
+        BOOL distinct = Rand() % 2 == 0;
+        if (count >= SORT_PARALLEL_MIN_ITEMS)
+            big++;
+        CFileData* items = (CFileData*)malloc((count + 1) * sizeof(CFileData));
+        MakeListing(items, count, distinct);
+
+        int mode = Rand() % 3;
+        SetMode(mode, Rand() % 2);
+        int type = Rand() % ARRAYSIZE(OldSorts);
+        BOOL reverse = Rand() % 2;
+
+        FillArray(oldArray, items, count);
+        FillArray(newArray, items, count);
+        if (count > 0)
+        {
+            OldSorts[type](oldArray, 0, count - 1, reverse);
+            NewSorts[type](newArray, 0, count - 1, reverse);
+        }
+        int i;
+        for (i = 0; i < count; i++)
+        {
+            if (oldArray[i].Name != newArray[i].Name)
+            {
+                printf("MISMATCH (by %s%s, %s, %d %s items): position %d: \"%s\" instead of \"%s\"\n",
+                       SortNames[type], reverse ? " reverse" : "", ModeNames[mode], count,
+                       distinct ? "distinct" : "repeated", i, newArray[i].Name, oldArray[i].Name);
+                failures++;
+                break;
+            }
+        }
+
+        for (i = 0; i < count; i++)
+            free(items[i].Name);
+        free(items);
+    }
+    oldArray.DestroyMembers();
+    newArray.DestroyMembers();
+    printf("order: %d listings (%d of at least %d items), %d mismatches\n", it, big, SORT_PARALLEL_MIN_ITEMS, failures);
+    return failures;
+}
+
+static void Benchmark(int count)
+{
+    CFileData* items = (CFileData*)malloc(count * sizeof(CFileData));
+    if (items == NULL)
+        return;
+    MakeListing(items, count, TRUE);
+    CFilesArray array;
+    array.SetDeleteData(FALSE);
+
+    printf("\n%d items, %d threads\n%-12s %-10s %12s %12s %8s\n", count, GetSortThreads(count), "sort by", "mode",
+           "old ms", "new ms", "speedup");
+    int mode;
+    for (mode = 0; mode < 3; mode++)
+    {
+        SetMode(mode, FALSE);
+        int type;
+        for (type = 0; type < (int)ARRAYSIZE(OldSorts); type++)
+        {
+            double tOld = 0, tNew = 0;
+            int round;
+            for (round = 0; round < 3; round++) // the best of three runs
+            {
+                FillArray(array, items, count);
+                double t = GetSeconds();
+                OldSorts[type](array, 0, count - 1, FALSE);
+                t = GetSeconds() - t;
+                if (round == 0 || t < tOld)
+                    tOld = t;
+                FillArray(array, items, count);
+                t = GetSeconds();
+                NewSorts[type](array, 0, count - 1, FALSE);
+                t = GetSeconds() - t;
+                if (round == 0 || t < tNew)
+                    tNew = t;
+            }
+            printf("%-12s %-10s %12.1f %12.1f %8.2f\n", SortNames[type], ModeNames[mode], tOld * 1000, tNew * 1000,
+                   tNew > 0 ? tOld / tNew : 0.0);
+        }
+    }
+    array.DestroyMembers();
+    int i;
+    for (i = 0; i < count; i++)
+        free(items[i].Name);
+    free(items);
+}
+
+int main(int argc, char* argv[])
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 5000;
+    int count = argc > 2 ? atoi(argv[2]) : 500000;
+
+    int failures = TestOrder(iterations);
+    if (count > 0)
+        Benchmark(count);
+    return failures == 0 ? 0 : 1;
+}
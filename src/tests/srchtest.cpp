@@ -0,0 +1,232 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+//
+// ****************************************************************************
+// srchtest - tester of CSearchData (common/moore.cpp)
+//
+// Compares the SIMD literal search (SSE2 and, if the CPU has it, AVX2) with the Boyer-Moore
+// search and with a naive reference on random texts and patterns (case sensitive and
+// insensitive, forward and backward, embedded zero bytes), then measures the throughput
+// of all variants on a generated text.
+//
+// Build (Visual Studio command prompt, in src\tests):
+//   cl /nologo /O2 /EHsc /J /DNDEBUG /DMESSAGES_DISABLE /DCALLSTK_DISABLE /I.. /I..\common
+//      /I..\common\dep /I..\plugins\shared srchtest.cpp ..\common\moore.cpp ..\common\str.cpp
+//      user32.lib
+//
+// Usage: srchtest [iterations [benchmark_MB]]
+
+#include "precomp.h"
+
+#include "str.h"
+#include "moore.h"
+
+class CTestSearchData : public CSearchData
+{
+public:
+    void DisableSIMD() { UseSIMD = FALSE; }
+    static void SetSIMDLevel(int level) { SIMDLevel = level; }
+};
+
+static DWORD RandSeed = 1;
+
+static DWORD Rand()
+{
+    RandSeed = RandSeed * 1103515245 + 12345;
+    return RandSeed >> 8;
+}
+
+static double GetSeconds()
+{
+    LARGE_INTEGER c, f;
+    QueryPerformanceCounter(&c);
+    QueryPerformanceFrequency(&f);
+    return (double)c.QuadPart / (double)f.QuadPart;
+}
+
+static BOOL MatchAt(const BYTE* text, const BYTE* pattern, int length, BOOL caseSensitive)
+{
+    int i;
+    for (i = 0; i < length; i++)
+    {
+        if (caseSensitive ? text[i] != pattern[i] : LowerCase[text[i]] != LowerCase[pattern[i]])
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static int RefForward(const char* text, int length, int start, const char* pattern, int patLen, BOOL caseSensitive)
+{
+    int p;
+    for (p = start; p + patLen <= length; p++)
+    {
+        if (MatchAt((const BYTE*)text + p, (const BYTE*)pattern, patLen, caseSensitive))
+            return p;
+    }
+    return -1;
+}
+
+static int RefBackward(const char* text, int length, const char* pattern, int patLen, BOOL caseSensitive)
+{
+    int p;
+    for (p = length - patLen; p >= 0; p--)
+    {
+        if (MatchAt((const BYTE*)text + p, (const BYTE*)pattern, patLen, caseSensitive))
+            return p;
+    }
+    return -1;
+}
+
+// level: 0 = Boyer-Moore, 1 = SSE2, 2 = AVX2
+static void SetSearch(CTestSearchData& data, int level, const char* pattern, int patLen, WORD flags)
+{
+    CTestSearchData::SetSIMDLevel(level == 0 ? 1 : level);
+    data.Set(pattern, patLen, flags);
+    if (level == 0)
+        data.DisableSIMD();
+}
+
+static const char* LevelNames[] = {"Boyer-Moore", "SSE2", "AVX2"};
+
+static int TestCorrectness(int iterations, int maxLevel)
+{
+    static const char* alphabets[] = {"ab", "aAbB", "abcdefghijklmnopqrstuvwxyz ", "xX\xe1\xc1\x9a\x8a"};
+    char text[4096];
+    char pattern[80];
+    int failures = 0;
+    int it;
+    for (it = 0; it < iterations && failures < 10; it++)
+    {
+        // text: one of the alphabets, all 256 characters or zero bytes among them
+        int kind = Rand() % 6;
+        int length = Rand() % (it % 10 == 0 ? 4000 : 300);
+        int i;
+        for (i = 0; i < length; i++)
+        {
+            if (kind < 4)
+                text[i] = alphabets[kind][Rand() % strlen(alphabets[kind])];
+            else if (kind == 4)
+                text[i] = (char)Rand();
+            else
+                text[i] = Rand() % 4 == 0 ? 0 : 'a' + Rand() % 3;
+        }
+        text[length] = 0;
+
+        // pattern: a part of the text (often with changed case) or random
+        int patLen = 1 + Rand() % (Rand() % 4 == 0 ? 70 : 12);
+        if (length >= patLen && Rand() % 3 != 0)
+        {
+            memcpy(pattern, text + Rand() % (length - patLen + 1), patLen);
+            if (Rand() % 2 == 0)
+            {
+                for (i = 0; i < patLen; i++)
+                    pattern[i] = (char)(Rand() % 2 == 0 ? LowerCase[(BYTE)pattern[i]] : (BYTE)pattern[i]);
+            }
+        }
+        else
+        {
+            for (i = 0; i < patLen; i++)
+                pattern[i] = kind < 4 ? alphabets[kind][Rand() % strlen(alphabets[kind])] : (char)Rand();
+        }
+        pattern[patLen] = 0;
+
+        BOOL caseSensitive = Rand() % 2 == 0;
+        WORD flags = caseSensitive ? sfCaseSensitive : 0;
+        int start = length > 0 ? Rand() % (length + 1) : 0;
+        int refFwd = RefForward(text, length, start, pattern, patLen, caseSensitive);
+        int refBwd = RefBackward(text, length, pattern, patLen, caseSensitive);
+
+        int level;
+        for (level = 0; level <= maxLevel; level++)
+        {
+            CTestSearchData fwd, bwd;
+            SetSearch(fwd, level, pattern, patLen, flags | sfForward);
+            SetSearch(bwd, level, pattern, patLen, flags);
+            int resFwd = fwd.SearchForward(text, length, start);
+            int resBwd = bwd.SearchBackward(text, length);
+            if (resFwd != refFwd || resBwd != refBwd)
+            {
+                printf("MISMATCH (%s, iteration %d, text %d, pattern %d, %s): forward %d (expected %d), "
+                       "backward %d (expected %d)\n",
+                       LevelNames[level], it, length, patLen, caseSensitive ? "case sensitive" : "ignore case",
+                       resFwd, refFwd, resBwd, refBwd);
+                failures++;
+            }
+        }
+    }
+    printf("correctness: %d iterations, %d mismatches\n", it, failures);
+    return failures;
+}
+
+static void Benchmark(int megabytes, int maxLevel)
+{
+    static const char* words[] = {"the", "of", "file", "directory", "panel", "Salamander", "search",
+                                  "archive", "viewer", "and", "plugin", "ERROR", "Warning", "0x1F",
+                                  "C:\\Windows\\System32", "path", "copy", "SIZE"};
+    int length = megabytes * 1024 * 1024;
+    char* text = (char*)malloc(length + 1);
+    if (text == NULL)
+    {
+        printf("benchmark: low memory\n");
+        return;
+    }
+    int pos = 0;
+    while (pos < length)
+    {
+        const char* w = words[Rand() % ARRAYSIZE(words)];
+        while (*w != 0 && pos < length)
+            text[pos++] = *w++;
+        if (pos < length)
+            text[pos++] = Rand() % 12 == 0 ? '\n' : ' ';
+    }
+    text[length] = 0;
+
+    static const char* patterns[] = {"xyz", "panel", "performance", "Salamander viewer", "C:\\Windows\\System32\\drivers"};
+    printf("\n%-30s %-12s %-12s %8s %10s\n", "pattern", "case", "variant", "matches", "MB/s");
+    int p;
+    for (p = 0; p < (int)ARRAYSIZE(patterns); p++)
+    {
+        int cs;
+        for (cs = 1; cs >= 0; cs--)
+        {
+            int level;
+            for (level = 0; level <= maxLevel; level++)
+            {
+                CTestSearchData data;
+                SetSearch(data, level, patterns[p], (int)strlen(patterns[p]), (cs ? sfCaseSensitive : 0) | sfForward);
+                int matches = 0;
+                double t = GetSeconds();
+                int found = 0;
+                while ((found = data.SearchForward(text, length, found)) != -1)
+                {
+                    matches++;
+                    found++;
+                }
+                t = GetSeconds() - t;
+                printf("%-30s %-12s %-12s %8d %10.0f\n", patterns[p], cs ? "sensitive" : "ignore",
+                       LevelNames[level], matches, t > 0 ? megabytes / t : 0.0);
+            }
+        }
+    }
+    free(text);
+}
+
+int main(int argc, char* argv[])
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : 200000;
+    int megabytes = argc > 2 ? atoi(argv[2]) : 64;
+
+    int maxLevel = CSearchData::GetSIMDLevel();
+    printf("SIMD level of this CPU: %d (%s)\n", maxLevel, maxLevel > 0 ? LevelNames[maxLevel] : "none");
+    if (maxLevel == 0)
+    {
+        printf("The SIMD search is not used on this CPU, nothing to compare.\n");
+        return 0;
+    }
+
+    int failures = TestCorrectness(iterations, maxLevel);
+    if (megabytes > 0)
+        Benchmark(megabytes, maxLevel);
+    return failures == 0 ? 0 : 1;
+}
@@ -3,10 +3,15 @@
 
 #include "precomp.h"
 
+#include <intrin.h>
+#include <smmintrin.h>
+
 #include "plugins.h"
 #include "fileswnd.h"
 #include "thumbnl.h"
 #include "cfgdlg.h"
+#include "hashcach.h"
+#include "cpufeat.h"
 
 //******************************************************************************
 //
@@ -30,11 +35,11 @@ void CShrinkImage::Cleanup()
     RowCoeff = NULL;
     ColCoeff = NULL;
     YCoeff = NULL;
-    NormCoeff = 0;
     Y = 0;
     YBndr = 0;
     OutLine = NULL;
     Buff = NULL;
+    RowSums = NULL;
     OrigHeight = 0;
     NewWidth = 0;
     ProcessTopDown = TRUE;
@@ -56,24 +61,27 @@ BOOL CShrinkImage::Alloc(DWORD origWidth, DWORD origHeight,
     // alokujeme a inicializujeme koeficienty
     RowCoeff = CreateCoeff(origWidth, newWidth, NormCoeffX);
     ColCoeff = CreateCoeff(origHeight, newHeight, NormCoeffY);
-    // alokujeme a vycistime buffer
-    Buff = (DWORD*)malloc(3 * newWidth * sizeof(DWORD));
-    if (RowCoeff == NULL || ColCoeff == NULL || Buff == NULL)
+    // alokujeme a vycistime buffery
+    Buff = (DWORD*)malloc(4 * newWidth * sizeof(DWORD));
+    RowSums = (DWORD*)malloc(4 * newWidth * sizeof(DWORD));
+    if (RowCoeff == NULL || ColCoeff == NULL || Buff == NULL || RowSums == NULL)
     {
         TRACE_E(LOW_MEMORY);
         Destroy();
         return FALSE;
     }
 
-    ZeroMemory(Buff, 3 * newWidth * sizeof(DWORD));
+    ZeroMemory(Buff, 4 * newWidth * sizeof(DWORD));
+    ZeroMemory(RowSums, 4 * newWidth * sizeof(DWORD));
+
+    if (SIMDLevel == -1)
+        SIMDLevel = (GetCPUFeatures() & CPUF_SSE41) != 0 ? 1 : 0;
 
     OrigHeight = origHeight;
     NewWidth = newWidth;
     ProcessTopDown = processTopDown;
 
     YCoeff = ColCoeff;
-    // koeficienty pro stredove a pravy pixel pro pripadne dalsi kolo
-    NormCoeff = NormCoeffY * NormCoeffX;
     // y-ova hranice sekce
     YBndr = *YCoeff++;
     // preskocime koeficient pro prvni radek
@@ -96,6 +104,8 @@ void CShrinkImage::Destroy()
         free(ColCoeff);
     if (Buff != NULL)
         free(Buff);
+    if (RowSums != NULL)
+        free(RowSums);
     Cleanup();
 }
 
@@ -139,36 +149,113 @@ CShrinkImage::CreateCoeff(DWORD origLen, WORD newLen, DWORD& norm)
     return res;
 }
 
-void CShrinkImage::ProcessRows(DWORD* inBuff, DWORD rowCount)
+// Zmensovani je rozdelene na vodorovny pruchod radkem (SumRow) a svisle skladani radku
+// (ProcessRows). Vsechny vypocty probihaji v DWORDech modulo 2^32, takze vynasobeni souctu
+// pixelu koeficientem dava presne stejny vysledek jako puvodni nasobeni kazdeho pixelu zvlast;
+// SSE4.1 varianta pocita vsechny tri kanaly pixelu naraz a vysledek je bit po bitu shodny.
+
+int CShrinkImage::SIMDLevel = -1;
+
+// vodorovny pruchod radkem pres SSE4.1, viz CShrinkImage::SumRow
+static DWORD* SumRowSSE41(DWORD* inBuff, const DWORD* coeff, WORD newWidth, DWORD normCoeffX, DWORD* sums)
 {
-    DWORD* ptrXCoeff;
-    DWORD xCoeff, yCoeff, xNewCoeff;
-    DWORD x1, x2, xBndr;
-    DWORD* currPix;
-    BYTE r, g, b;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i mask = _mm_set1_epi32(0x00FFFFFF); // alfa kanal (ctvrty bajt) se ignoruje
+    const __m128i normX = _mm_set1_epi32(normCoeffX);
+    __m128i left = zero; // vazeny levy krajni pixel (u prvniho pixelu zadny neni)
+    DWORD x2 = 0;
+    WORD x1;
+    for (x1 = 0; x1 < newWidth; x1++)
+    {
+        DWORD xBndr = coeff[0];
+        __m128i acc = zero;
+        // stredni cast scitame po ctyrech pixelech
+        for (; x2 + 4 <= xBndr; x2 += 4)
+        {
+            __m128i pix = _mm_and_si128(_mm_loadu_si128((const __m128i*)(inBuff + x2)), mask);
+            __m128i sum16 = _mm_add_epi16(_mm_unpacklo_epi8(pix, zero),  // pixely 0 a 1
+                                          _mm_unpackhi_epi8(pix, zero)); // pixely 2 a 3
+            acc = _mm_add_epi32(acc, _mm_add_epi32(_mm_unpacklo_epi16(sum16, zero),
+                                                   _mm_unpackhi_epi16(sum16, zero)));
+        }
+        for (; x2 < xBndr; x2++)
+            acc = _mm_add_epi32(acc, _mm_cvtepu8_epi32(_mm_cvtsi32_si128(inBuff[x2] & 0x00FFFFFF)));
+        // nejpravejsi pixel
+        __m128i right = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(inBuff[x2++] & 0x00FFFFFF));
+        __m128i res = _mm_add_epi32(_mm_mullo_epi32(acc, normX),
+                                    _mm_mullo_epi32(right, _mm_set1_epi32(coeff[2])));
+        _mm_storeu_si128((__m128i*)sums, _mm_add_epi32(res, left));
+        // nejpravejsi pixel je zaroven nejlevejsim pixelem dalsi sekce
+        if (x1 + 1 < newWidth)
+            left = _mm_mullo_epi32(right, _mm_set1_epi32(coeff[4]));
+        coeff += 3;
+        sums += 4;
+    }
+    return inBuff + x2;
+}
+
+DWORD* CShrinkImage::SumRow(DWORD* inBuff)
+{
+    if (SIMDLevel > 0)
+        return SumRowSSE41(inBuff, RowCoeff, NewWidth, NormCoeffX, RowSums);
+
+    DWORD* sums = RowSums;
+    DWORD* ptrXCoeff = RowCoeff;
+    DWORD leftR = 0, leftG = 0, leftB = 0; // vazeny levy krajni pixel (u prvniho pixelu zadny neni)
+    DWORD x2 = 0;
     DWORD rgb;
+    WORD x1;
+    for (x1 = 0; x1 < NewWidth; x1++)
+    {
+        DWORD xBndr = ptrXCoeff[0];
+        DWORD r = 0;
+        DWORD g = 0;
+        DWORD b = 0;
+        // projedem stredni cast
+        for (; x2 < xBndr; x2++)
+        {
+            rgb = inBuff[x2];
+            r += GetRValue(rgb);
+            g += GetGValue(rgb);
+            b += GetBValue(rgb);
+        }
+        // vytahneme nejpravejsi pixel
+        rgb = inBuff[x2++];
+        DWORD xCoeff = ptrXCoeff[2];
+        sums[0] = NormCoeffX * r + xCoeff * GetRValue(rgb) + leftR;
+        sums[1] = NormCoeffX * g + xCoeff * GetGValue(rgb) + leftG;
+        sums[2] = NormCoeffX * b + xCoeff * GetBValue(rgb) + leftB;
+        // nejpravejsi pixel je zaroven nejlevejsim pixelem dalsi sekce
+        if (x1 + 1 < NewWidth)
+        {
+            xCoeff = ptrXCoeff[4];
+            leftR = xCoeff * GetRValue(rgb);
+            leftG = xCoeff * GetGValue(rgb);
+            leftB = xCoeff * GetBValue(rgb);
+        }
+        ptrXCoeff += 3;
+        sums += 4;
+    }
+    return inBuff + x2;
+}
 
+void CShrinkImage::ProcessRows(DWORD* inBuff, DWORD rowCount)
+{
     // jedem pres vsechny radky
     DWORD y;
     for (y = Y; y < Y + rowCount; y++)
     {
-        // nainicializujeme pointery do bufferu
-        currPix = Buff;
-        // nainicializujem pointer do pole koeficientu
-        ptrXCoeff = RowCoeff;
-        // maximalni x-ova souradnice
-        xBndr = *ptrXCoeff++;
-        // levej koeficient je na zacatku radku stejnej jako stredni
-        ptrXCoeff++;
-        // pravej koeficient
-        xCoeff = *ptrXCoeff++;
-
-        x2 = 0;
+        inBuff = SumRow(inBuff);
+
+        DWORD* currPix = Buff;
+        DWORD* sums = RowSums;
+        WORD x1;
         // rozdeleni podle polohy radku v sekci (stredni nebo posledni)
         if (y == YBndr)
         {
             // vytahneme koeficient pro posledni radek
             DWORD yLastCoeff = *YCoeff++;
+            DWORD yCoeff;
             // vytahneme koeficient pro prvni radek dalsi sekce (je-li nejaka)
             if (y + 1 < OrigHeight)
             {
@@ -180,102 +267,41 @@ void CShrinkImage::ProcessRows(DWORD* inBuff, DWORD rowCount)
                 YBndr = 0; // nova y-ova hranice sekce
                 yCoeff = 0;
             }
-            // koeficienty pro stredove a pravy pixel
-            xNewCoeff = yCoeff * xCoeff;
-            xCoeff *= yLastCoeff;
-            // koeficienty pro dalsi radek
-            DWORD midNewCoeff = yCoeff * NormCoeffX;
-            DWORD midCoeff = yLastCoeff * NormCoeffX;
-            // pomocne promenne pro pixel dalsiho radku
-            DWORD nextR = 0;
-            DWORD nextG = 0;
-            DWORD nextB = 0;
-            // a predpocitavame dalsi
-            for (x1 = 0; x1 + 1 < NewWidth; x1++)
+            if (SIMDLevel > 0)
             {
-                // jsme-li na poslednim radku, aktualni ukladame do vysledku
-                // projedem stredni cast
-                for (; x2 < xBndr; x2++)
+                __m128i last = _mm_set1_epi32(yLastCoeff);
+                __m128i next = _mm_set1_epi32(yCoeff);
+                for (x1 = 0; x1 < NewWidth; x1++)
                 {
-                    // vytahneme pixel
-                    rgb = *inBuff++;
-                    r = GetRValue(rgb);
-                    g = GetGValue(rgb);
-                    b = GetBValue(rgb);
-                    // pripocitame ho do bufferu
-                    currPix[0] += midCoeff * r;
-                    currPix[1] += midCoeff * g;
-                    currPix[2] += midCoeff * b;
-                    // a pripravime i pixel z pristiho radku
-                    nextR += midNewCoeff * r;
-                    nextG += midNewCoeff * g;
-                    nextB += midNewCoeff * b;
+                    __m128i s = _mm_loadu_si128((const __m128i*)sums);
+                    // napocitany pixel posleme na vystup
+                    __m128i pix = _mm_srli_epi32(_mm_add_epi32(_mm_loadu_si128((const __m128i*)currPix),
+                                                               _mm_mullo_epi32(s, last)),
+                                                 24);
+                    pix = _mm_packus_epi32(pix, pix);
+                    *OutLine++ = (DWORD)_mm_cvtsi128_si32(_mm_packus_epi16(pix, pix));
+                    // a pripravime pixel pro dalsi radek
+                    _mm_storeu_si128((__m128i*)currPix, _mm_mullo_epi32(s, next));
+                    currPix += 4;
+                    sums += 4;
                 }
-                // vytahneme nejpravejsi pixel
-                rgb = *inBuff++;
-                r = GetRValue(rgb);
-                g = GetGValue(rgb);
-                b = GetBValue(rgb);
-                // napocitany pixel uz muzem poslat na vystup
-                *OutLine++ = RGB((currPix[0] + xCoeff * r) >> 24,
-                                 (currPix[1] + xCoeff * g) >> 24,
-                                 (currPix[2] + xCoeff * b) >> 24);
-                // pripravime pixel pro dalsi radek
-                currPix[0] = nextR + xNewCoeff * r;
-                currPix[1] = nextG + xNewCoeff * g;
-                currPix[2] = nextB + xNewCoeff * b;
-                // zvetsime souradnici
-                x2++;
-                // soupnem se ve vystupu na dalsi pixel
-                currPix += 3;
-                // nova maximalni x-ova souradnice
-                xBndr = *ptrXCoeff++;
-                // novej levej koeficient pro oba radky
-                xNewCoeff = yCoeff * *ptrXCoeff;
-                xCoeff = yLastCoeff * *ptrXCoeff++;
-                // a taky ho pripocitame do bufferu pro dalsi pixel
-                currPix[0] += xCoeff * r;
-                currPix[1] += xCoeff * g;
-                currPix[2] += xCoeff * b;
-                // a pripravime i pixel z pristiho radku
-                nextR = xNewCoeff * r;
-                nextG = xNewCoeff * g;
-                nextB = xNewCoeff * b;
-                // a novej pravej koeficient
-                xNewCoeff = yCoeff * *ptrXCoeff;
-                xCoeff = yLastCoeff * *ptrXCoeff++;
             }
-            // pro posledni pixel musime vynechat vypocet leve casti
-            // dalsiho pixelu (zadnej neni)
-            for (; x2 < xBndr; x2++)
+            else
             {
-                // vytahneme pixel
-                rgb = *inBuff++;
-                r = GetRValue(rgb);
-                g = GetGValue(rgb);
-                b = GetBValue(rgb);
-                // pripocitame ho do bufferu
-                currPix[0] += midCoeff * r;
-                currPix[1] += midCoeff * g;
-                currPix[2] += midCoeff * b;
-                // a pripravime i pixel z pristiho radku
-                nextR += midNewCoeff * r;
-                nextG += midNewCoeff * g;
-                nextB += midNewCoeff * b;
+                for (x1 = 0; x1 < NewWidth; x1++)
+                {
+                    // napocitany pixel posleme na vystup
+                    *OutLine++ = RGB((currPix[0] + yLastCoeff * sums[0]) >> 24,
+                                     (currPix[1] + yLastCoeff * sums[1]) >> 24,
+                                     (currPix[2] + yLastCoeff * sums[2]) >> 24);
+                    // a pripravime pixel pro dalsi radek
+                    currPix[0] = yCoeff * sums[0];
+                    currPix[1] = yCoeff * sums[1];
+                    currPix[2] = yCoeff * sums[2];
+                    currPix += 4;
+                    sums += 4;
+                }
             }
-            // vytahneme nejpravejsi pixel
-            rgb = *inBuff++;
-            r = GetRValue(rgb);
-            g = GetGValue(rgb);
-            b = GetBValue(rgb);
-            // napocitany pixel uz muzem poslat na vystup
-            *OutLine++ = RGB((currPix[0] + xCoeff * r) >> 24,
-                             (currPix[1] + xCoeff * g) >> 24,
-                             (currPix[2] + xCoeff * b) >> 24);
-            // pripravime pixel pro dalsi radek
-            currPix[0] = nextR + xNewCoeff * r;
-            currPix[1] = nextG + xNewCoeff * g;
-            currPix[2] = nextB + xNewCoeff * b;
             // mame hotovej celej radek
 
             // pokud jedem odspodu, pokracujem o radek vys
@@ -284,71 +310,30 @@ void CShrinkImage::ProcessRows(DWORD* inBuff, DWORD rowCount)
         }
         else
         {
-            // pravej koeficient
-            xCoeff *= NormCoeffY;
-            // jsme-li na stredovych pixelech, pocitame normalne
-            for (x1 = 0; x1 + 1 < NewWidth; x1++)
+            // jsme-li na stredovych radcich, jen pricteme radek do bufferu
+            if (SIMDLevel > 0)
             {
-                // projedem stredni cast
-                for (; x2 < xBndr; x2++)
+                __m128i normY = _mm_set1_epi32(NormCoeffY);
+                for (x1 = 0; x1 < NewWidth; x1++)
                 {
-                    // vytahneme pixel
-                    rgb = *inBuff++;
-                    r = GetRValue(rgb);
-                    g = GetGValue(rgb);
-                    b = GetBValue(rgb);
-                    // pripocitame ho do bufferu
-                    currPix[0] += NormCoeff * r;
-                    currPix[1] += NormCoeff * g;
-                    currPix[2] += NormCoeff * b;
+                    _mm_storeu_si128((__m128i*)currPix,
+                                     _mm_add_epi32(_mm_loadu_si128((const __m128i*)currPix),
+                                                   _mm_mullo_epi32(_mm_loadu_si128((const __m128i*)sums), normY)));
+                    currPix += 4;
+                    sums += 4;
                 }
-                // vytahneme nejpravejsi pixel
-                rgb = *inBuff++;
-                r = GetRValue(rgb);
-                g = GetGValue(rgb);
-                b = GetBValue(rgb);
-                // a taky ho pripocitame do bufferu
-                currPix[0] += xCoeff * r;
-                currPix[1] += xCoeff * g;
-                currPix[2] += xCoeff * b;
-                // zvetsime souradnici
-                x2++;
-                // soupnem se ve vystupu na dalsi pixel
-                currPix += 3;
-                // nova maximalni x-ova souradnice
-                xBndr = *ptrXCoeff++;
-                // novej levej koeficient
-                xCoeff = NormCoeffY * *ptrXCoeff++;
-                // a taky ho pripocitame do bufferu pro dalsi pixel
-                currPix[0] += xCoeff * r;
-                currPix[1] += xCoeff * g;
-                currPix[2] += xCoeff * b;
-                // a novej pravej koeficient
-                xCoeff = NormCoeffY * *ptrXCoeff++;
             }
-            // pro posledni pixel musime vynechat vypocet leve casti
-            for (; x2 < xBndr; x2++)
+            else
             {
-                // vytahneme pixel
-                rgb = *inBuff++;
-                r = GetRValue(rgb);
-                g = GetGValue(rgb);
-                b = GetBValue(rgb);
-                // pripocitame ho do bufferu
-                currPix[0] += NormCoeff * r;
-                currPix[1] += NormCoeff * g;
-                currPix[2] += NormCoeff * b;
+                for (x1 = 0; x1 < NewWidth; x1++)
+                {
+                    currPix[0] += NormCoeffY * sums[0];
+                    currPix[1] += NormCoeffY * sums[1];
+                    currPix[2] += NormCoeffY * sums[2];
+                    currPix += 4;
+                    sums += 4;
+                }
             }
-            // vytahneme nejpravejsi pixel
-            rgb = *inBuff++;
-            r = GetRValue(rgb);
-            g = GetGValue(rgb);
-            b = GetBValue(rgb);
-            // a taky ho pripocitame do bufferu
-            currPix[0] += xCoeff * r;
-            currPix[1] += xCoeff * g;
-            currPix[2] += xCoeff * b;
-            // mame hotovej celej radek
         }
     }
     Y += rowCount;
@@ -421,6 +406,8 @@ void CSalamanderThumbnailMaker::Clear(int thumbnailMaxSize)
 
     ShrinkImage = FALSE;
     Shrinker.Destroy();
+
+    Incomplete = FALSE;
 }
 
 // vraci TRUE pokud je v tomto objektu pripraveny cely thumbnail (povedlo se
@@ -602,6 +589,7 @@ void CSalamanderThumbnailMaker::HandleIncompleteImages()
             int maxRowsInBuf = BufferSize / OriginalWidth / sizeof(DWORD);
             if (maxRowsInBuf > 0)
             {
+                Incomplete = TRUE;
                 while (NextLine < OriginalHeight)
                 {
                     if (!ProcessBuffer(Buffer, min(maxRowsInBuf, OriginalHeight - NextLine)))
@@ -614,6 +602,57 @@ void CSalamanderThumbnailMaker::HandleIncompleteImages()
     }
 }
 
+BOOL CSalamanderThumbnailMaker::LoadFromDiskCache(const char* fileName, const CQuadWord& fileSize,
+                                                  const FILETIME& lastWrite)
+{
+    if (Configuration.ThumbnailCacheMaxSize == 0 || ThumbnailMaxWidth < 1 || ThumbnailMaxHeight < 1)
+        return FALSE; // cache je vypnuta nebo jeste nezname velikost thumbnailu
+
+    // buffery alokujeme stejne jako SetParameters() (pouzivaji se i pro thumbnaily od pluginu)
+    if (ThumbnailBuffer == NULL)
+        ThumbnailBuffer = (DWORD*)malloc(ThumbnailMaxWidth * ThumbnailMaxHeight * sizeof(DWORD));
+    if (AuxTransformBuffer == NULL)
+        AuxTransformBuffer = (DWORD*)malloc(ThumbnailMaxWidth * ThumbnailMaxHeight * sizeof(DWORD));
+    if (ThumbnailBuffer == NULL || AuxTransformBuffer == NULL)
+    {
+        if (ThumbnailBuffer != NULL)
+            free(ThumbnailBuffer);
+        if (AuxTransformBuffer != NULL)
+            free(AuxTransformBuffer);
+        ThumbnailBuffer = NULL;
+        AuxTransformBuffer = NULL;
+        TRACE_E(LOW_MEMORY);
+        return FALSE;
+    }
+
+    // thumbnail je v cache ulozeny az po transformaci a pro velikost ThumbnailMaxWidth (= ThumbnailMaxHeight)
+    int width, height;
+    if (!ThumbnailDiskCache.Lookup(fileName, fileSize, lastWrite, ThumbnailMaxWidth, ThumbnailBuffer,
+                                   ThumbnailMaxWidth * ThumbnailMaxHeight, &width, &height))
+    {
+        return FALSE;
+    }
+    ThumbnailRealWidth = width;
+    ThumbnailRealHeight = height;
+    OriginalWidth = width; // thumbnail je hotovy, viz ThumbnailReady()
+    OriginalHeight = height;
+    NextLine = height;
+    PictureFlags = 0; // zadna transformace, zadny nahled
+    Error = FALSE;
+    return TRUE;
+}
+
+void CSalamanderThumbnailMaker::StoreToDiskCache(const char* fileName, const CQuadWord& fileSize,
+                                                 const FILETIME& lastWrite)
+{
+    if (Configuration.ThumbnailCacheMaxSize != 0 && !IsOnlyPreview() && !Incomplete &&
+        ThumbnailReady() && ThumbnailRealWidth <= ThumbnailMaxWidth && ThumbnailRealHeight <= ThumbnailMaxHeight)
+    {
+        ThumbnailDiskCache.Store(fileName, fileSize, lastWrite, ThumbnailMaxWidth, ThumbnailBuffer,
+                                 ThumbnailRealWidth, ThumbnailRealHeight);
+    }
+}
+
 // *********************************************************************************
 // metody rozhrani CSalamanderThumbnailMakerAbstract
 // *********************************************************************************
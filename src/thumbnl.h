@@ -15,14 +15,16 @@ protected:
     DWORD* RowCoeff;
     DWORD* ColCoeff;
     DWORD* YCoeff;
-    DWORD NormCoeff;
     DWORD Y, YBndr;
     DWORD* OutLine;
-    DWORD* Buff;
+    DWORD* Buff;    // rozpracovane pixely thumbnailu (po ctyrech DWORDech: R, G, B, nevyuzito)
+    DWORD* RowSums; // vodorovne vazene soucty pixelu zpracovavaneho radku (stejny format jako Buff)
     DWORD OrigHeight;
     WORD NewWidth;
     BOOL ProcessTopDown;
 
+    static int SIMDLevel; // 0 = bez SIMD, 1 = SSE4.1; -1 = jeste nezjisteno
+
 public:
     CShrinkImage();
     ~CShrinkImage();
@@ -41,6 +43,10 @@ public:
 protected:
     DWORD* CreateCoeff(DWORD origLen, WORD newLen, DWORD& norm);
     void Cleanup();
+
+    // vodorovny pruchod radkem 'inBuff': do RowSums ulozi pro kazdy pixel thumbnailu vazeny
+    // soucet pixelu radku; vraci ukazatel na nasledujici radek
+    DWORD* SumRow(DWORD* inBuff);
 };
 
 //******************************************************************************
@@ -76,6 +82,8 @@ protected:
     CShrinkImage Shrinker; // zajistuje zmensovani obrazku
     BOOL ShrinkImage;
 
+    BOOL Incomplete; // TRUE = zbytek thumbnailu doplnila HandleIncompleteImages() (neukladame ho do ThumbnailDiskCache)
+
 public:
     CSalamanderThumbnailMaker(CFilesWindow* window);
     ~CSalamanderThumbnailMaker();
@@ -105,6 +113,15 @@ public:
 
     BOOL IsOnlyPreview() { return (PictureFlags & SSTHUMB_ONLY_PREVIEW) != 0; }
 
+    // zkusi ziskat thumbnail souboru 'fileName' (plne jmeno) o velikosti 'fileSize' a case
+    // posledniho zapisu 'lastWrite' z ThumbnailDiskCache; pri uspechu vraci TRUE a thumbnail
+    // je pripraveny (viz ThumbnailReady(), transformace uz je provedena)
+    BOOL LoadFromDiskCache(const char* fileName, const CQuadWord& fileSize, const FILETIME& lastWrite);
+
+    // ulozi hotovy (uz transformovany) thumbnail souboru 'fileName' do ThumbnailDiskCache;
+    // nahledy (viz IsOnlyPreview()) a nekompletni thumbnaily se neukladaji
+    void StoreToDiskCache(const char* fileName, const CQuadWord& fileSize, const FILETIME& lastWrite);
+
     // *********************************************************************************
     // metody rozhrani CSalamanderThumbnailMakerAbstract
     // *********************************************************************************
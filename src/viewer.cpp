@@ -486,6 +486,7 @@ void CViewerGoToOffsetDialog::Validate(CTransferInfo& ti)
 void CViewerGoToOffsetDialog::Transfer(CTransferInfo& ti)
 {
     ti.CheckBox(IDC_VGTO_HEX, Configuration.GoToOffsetIsHex);
+    ti.CheckBox(IDC_VGTO_LINE, Configuration.GoToOffsetIsLine);
     ti.EditLine(IDE_VGTO_OFFSET, *Offset, TRUE, TRUE, Configuration.GoToOffsetIsHex);
 }
 
@@ -509,6 +510,30 @@ CViewerGoToOffsetDialog::DialogProc(UINT uMsg, WPARAM wParam, LPARAM lParam)
                 ti2.EditLine(IDE_VGTO_OFFSET, off, FALSE, TRUE, h);
             }
         }
+        if (LOWORD(wParam) == IDC_VGTO_LINE && HIWORD(wParam) == BN_CLICKED)
+        { // switching Line = convert the offset to a line number and back (only if the line index already has it)
+            BOOL h = IsDlgButtonChecked(HWindow, IDC_VGTO_HEX) != BST_UNCHECKED;
+            BOOL line = IsDlgButtonChecked(HWindow, IDC_VGTO_LINE) != BST_UNCHECKED;
+            CTransferInfo ti(HWindow, ttDataFromWindow);
+            __int64 val;
+            ti.EditLine(IDE_VGTO_OFFSET, val, TRUE, TRUE, h, FALSE, TRUE); // do not show an error; just skip conversion
+            if (ti.IsGood())
+            {
+                BOOL converted;
+                if (line)
+                {
+                    converted = LineIndex->GetOffsetLine(val, val);
+                    val++; // lines are numbered from 1 in the dialog
+                }
+                else
+                    converted = LineIndex->GetLineOffset(val - 1, val);
+                if (converted)
+                {
+                    CTransferInfo ti2(HWindow, ttDataToWindow);
+                    ti2.EditLine(IDE_VGTO_OFFSET, val, FALSE, TRUE, h);
+                }
+            }
+        }
         break;
     }
     }
@@ -791,6 +816,7 @@ void CViewerWindow::Paint(HDC dc)
         r.top = 0;
         r.bottom = Height;
         FillRect(dc, &r, BkgndBrush); // clear the columns to the left of the text
+        PaintHitMap(dc);              // marks of the background search hits
         RECT fullLine;
         fullLine.left = 0;
         fullLine.top = 0;
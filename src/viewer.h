@@ -16,6 +16,16 @@
 
 #define VIEWER_HISTORY_SIZE 30 // number of remembered strings
 
+#define LINE_INDEX_STEP 4096                      // the line index stores the offset of every LINE_INDEX_STEP-th line
+#define LINE_INDEX_VIEW_SIZE (16 * 1024 * 1024) // size of one mapped view of the file scanned by the line index
+
+#define VIEWER_SEARCH_CHUNK_SIZE (1024 * 1024) // the background search reads the file in chunks of this size
+#define VIEWER_SEARCH_MAX_HITS 10000000         // the background search stops collecting hits at this count
+#define VIEWER_SEARCH_HIT_BLOCK_SHIFT 14        // hits are stored in blocks of (1 << VIEWER_SEARCH_HIT_BLOCK_SHIFT) items
+#define VIEWER_SEARCH_HIT_BLOCK (1 << VIEWER_SEARCH_HIT_BLOCK_SHIFT)
+#define VIEWER_SEARCH_MAX_HIT_BLOCKS ((VIEWER_SEARCH_MAX_HITS + VIEWER_SEARCH_HIT_BLOCK - 1) / VIEWER_SEARCH_HIT_BLOCK)
+#define VIEWER_HIT_MAP_SIZE 4096                // number of file sections in the hit map
+
 // menu positions - redo when the menu changes!
 #define VIEWER_FILE_MENU_INDEX 0         // in the viewer main menu
 #define VIEWER_FILE_MENU_OTHFILESINDEX 3 // in the File submenu of the viewer main menu
@@ -24,7 +34,8 @@
 #define CODING_MENU_INDEX 4              // in the viewer main menu
 #define OPTIONS_MENU_INDEX 5             // in the viewer main menu
 
-#define WM_USER_VIEWERREFRESH WM_APP + 201 // [0, 0] - perform a refresh
+#define WM_USER_VIEWERREFRESH WM_APP + 201        // [0, 0] - perform a refresh
+#define WM_USER_VIEWERSEARCHPROGRESS WM_APP + 202 // [0, 0] - the background search found more hits or finished
 
 #ifndef INSIDE_SALAMANDER
 char* LoadStr(int resID);
@@ -88,13 +99,205 @@ protected:
         CancelRegular;
 };
 
+// ****************************************************************************
+// CViewerLineIndex
+//
+// sparse index of line beginnings in the viewed file: stores the offset of every
+// LINE_INDEX_STEP-th line; it is built (only for Go To, see CM_GOTOOFFSET and
+// Configuration.GoToOffsetIsLine) by a background thread which scans the file
+// through sliding memory-mapped views; when the file grows (a followed log), only
+// the appended part is scanned; the remaining lines between two stored offsets are
+// counted on demand, so finding a line or the line number of an offset costs at most
+// LINE_INDEX_STEP lines of scanning
+
+class CViewerLineIndex
+{
+protected:
+    CRITICAL_SECTION CS; // guards Offsets, IndexedSize, TargetSize and Running
+
+    char* FileName;          // indexed file (NULL = index is not started)
+    HANDLE Thread;           // indexing thread (NULL = not started yet)
+    volatile BOOL Terminate; // TRUE = the indexing thread should end as soon as possible
+    BOOL Running;            // TRUE = the indexing thread has not finished yet
+    BOOL Failed;             // TRUE = reading of the file failed, the index is incomplete
+
+    TDirectArray<__int64> Offsets; // Offsets[i] = offset of the beginning of line i * LINE_INDEX_STEP
+    __int64 IndexedSize;           // number of bytes scanned from the start of the file
+    __int64 TargetSize;            // file size the indexing thread should reach
+
+    // scanning state at IndexedSize (used only by the indexing thread)
+    __int64 ScanLines; // number of line beginnings found so far (line 0 is not counted)
+    int ScanCR;        // 0 = no pending '\r', 1 = pending EOL '\r', 2 = pending '\r' which is an EOL only before '\n'
+
+    // snapshot of the EOL settings and code table the index was built with
+    BOOL EOL_CRLF, EOL_CR, EOL_LF, EOL_NULL;
+    unsigned char CharClass[256]; // 0 = ordinary character, 1 = '\r', 2 = '\n', 3 = '\0' (after applying the code table)
+
+public:
+    CViewerLineIndex();
+    ~CViewerLineIndex();
+
+    // starts indexing 'fileName' from the beginning; 'fileSize' is the current size
+    // of the file; 'codeTable' is the code table used by the viewer (NULL = none)
+    void Start(const char* fileName, __int64 fileSize, const char* codeTable);
+
+    // the viewed file has grown to 'fileSize'; only the appended part is indexed
+    void Extend(__int64 fileSize);
+
+    // stops the indexing thread and releases the index
+    void Stop();
+
+    // returns TRUE if the index was built for 'fileName' with the current EOL settings and 'codeTable'
+    BOOL Matches(const char* fileName, const char* codeTable);
+
+    // returns TRUE if the index is still being built
+    BOOL IsIndexing();
+
+    // finds the offset 'offset' of the beginning of line 'line' (counted from 0); if the file has
+    // fewer lines, returns the beginning of the last line; returns FALSE if the index has not
+    // reached the line yet or on a read error
+    BOOL GetLineOffset(__int64 line, __int64& offset);
+
+    // finds the number 'line' (counted from 0) of the line containing 'offset'; returns FALSE
+    // if the index has not reached the offset yet or on a read error
+    BOOL GetOffsetLine(__int64 offset, __int64& line);
+
+protected:
+    void SetCharClass(const char* codeTable);
+    BOOL StartThread();
+    void WaitForThread();
+
+    // scans the file from 'pos' to 'to' (or up to the end of the file if 'to' is -1); 'lines'
+    // and 'cr' are the scanning state at 'pos', all three are updated as scanning proceeds;
+    // stores the offsets of every LINE_INDEX_STEP-th line into Offsets if 'addOffsets' is TRUE;
+    // stops when line 'stopLine' is found or before a line beginning greater than 'maxBegin'
+    // (-1 = no limit); 'lastBegin' (may be NULL) receives the last line beginning found;
+    // returns FALSE on a read error
+    BOOL ScanFile(__int64& pos, __int64 to, __int64& lines, int& cr, BOOL addOffsets,
+                  __int64 stopLine, __int64 maxBegin, __int64* lastBegin);
+
+    // scans one block of a mapped view, see ScanFile(); returns TRUE if the scanning should stop
+    BOOL ScanBlock(const unsigned char* s, const unsigned char* end, __int64 base, __int64& lines,
+                   int& cr, BOOL addOffsets, __int64 stopLine, __int64 maxBegin, __int64* lastBegin);
+
+    friend unsigned ViewerLineIndexThreadBody(void* param);
+};
+
+// ****************************************************************************
+// CViewerSearchIndex
+//
+// background search of the whole viewed file: a worker thread reads the file in large
+// chunks and collects the offsets of all hits in ascending order (so they form a sorted
+// index); Find Next/Previous then take the nearest hit from the index instead of reading
+// the file; the viewer is notified about the progress via WM_USER_VIEWERSEARCHPROGRESS;
+// hits are found the same way as by the search in CViewerWindow::WindowProc (code table,
+// whole words, lines of regular expressions limited by FIND_LINE_LEN)
+
+class CViewerSearchIndex
+{
+protected:
+    CRITICAL_SECTION CS; // guards HitCount, HitMap, ScannedSize, Running, Failed and Truncated
+
+    HANDLE Thread;           // search thread (NULL = not started)
+    volatile BOOL Terminate; // TRUE = the search thread should end as soon as possible
+    BOOL Running;            // TRUE = the search thread has not finished yet
+    BOOL Failed;             // TRUE = read error, low memory or empty match; the index is incomplete
+    BOOL Truncated;          // TRUE = VIEWER_SEARCH_MAX_HITS was reached; the index is incomplete
+    HWND NotifyWindow;       // receives WM_USER_VIEWERSEARCHPROGRESS
+    DWORD LastNotify;        // GetTickCount() of the last notification
+
+    // search parameters (read-only while the search thread runs)
+    char* FileName;                // searched file (NULL = no search)
+    __int64 FileSize;              // size of the file when the search started; the rest is not searched
+    char* Pattern;                 // searched text (possibly converted from hex) or regular expression
+    int PatternLen;                // length of Pattern
+    BOOL Regular;                  // TRUE = Pattern is a regular expression
+    BOOL CaseSensitive;            // TRUE = case sensitive search
+    BOOL WholeWords;               // TRUE = whole words only
+    BOOL UseCodeTable;             // TRUE = the file is converted by CodeTable before searching
+    char CodeTable[256];           // code table of the viewer
+    BOOL EOL_CRLF, EOL_CR, EOL_LF; // line endings for regular expressions (EOL_NULL is always used)
+
+    // hits in ascending order of their offsets, stored in blocks that are never moved, so adding
+    // a hit does not copy the previous ones; only the search thread writes them, the items below
+    // HitCount do not change any more
+    __int64* HitOffsets[VIEWER_SEARCH_MAX_HIT_BLOCKS]; // offsets of hits (NULL = block not allocated yet)
+    int* HitLengths[VIEWER_SEARCH_MAX_HIT_BLOCKS];     // lengths of hits (regular expressions only, other hits have PatternLen)
+    int HitCount;                                      // number of hits in HitOffsets
+    __int64 ScannedSize;                               // all hits beginning before this offset are in HitOffsets
+    BYTE HitMap[VIEWER_HIT_MAP_SIZE]; // non-zero = there is a hit in this part of the file
+    __int64 HitMapBucket;             // number of bytes of the file per HitMap item
+
+public:
+    CViewerSearchIndex();
+    ~CViewerSearchIndex();
+
+    // starts searching 'pattern' (length 'patternLen') in 'fileName' of size 'fileSize'; 'codeTable'
+    // is the code table used by the viewer (NULL = none); progress is reported to 'notifyWindow'
+    void Start(HWND notifyWindow, const char* fileName, __int64 fileSize, const char* pattern, int patternLen,
+               BOOL regular, BOOL caseSensitive, BOOL wholeWords, const char* codeTable);
+
+    // stops the search thread and releases the index
+    void Stop();
+
+    // returns TRUE if the index belongs to the given search (the parameters are the same as for Start())
+    BOOL Matches(const char* fileName, __int64 fileSize, const char* pattern, int patternLen,
+                 BOOL regular, BOOL caseSensitive, BOOL wholeWords, const char* codeTable);
+
+    BOOL IsStarted() { return FileName != NULL; }
+
+    // finds the first hit beginning at or after 'offset' ('forward' is TRUE) or the last hit ending
+    // at or before 'offset' ('forward' is FALSE); returns 1 if the hit was found ('hitOffset' and
+    // 'hitLen'), 0 if there is no such hit and -1 if the index does not cover that part of the file
+    int FindHit(__int64 offset, BOOL forward, __int64& hitOffset, int& hitLen);
+
+    // returns the number of hits found so far in 'count', TRUE in 'complete' if the whole file has been
+    // searched and the number of the hit beginning at 'offset' in 'current' (from 1, 0 = no such hit);
+    // returns FALSE if no search was started
+    BOOL GetHitCount(__int64 offset, __int64& current, __int64& count, BOOL& complete);
+
+    // paints the hit map into the strip 'x' to 'x' + 'width' and 0 to 'height' of 'dc' with 'brush'
+    void PaintHitMap(HDC dc, int x, int width, int height, HBRUSH brush);
+
+protected:
+    // reads the next chunk of the file from 'readPos' and appends it to 'buf' (containing 'bufLen'
+    // bytes); sets 'eof' to TRUE at the end of the searched part; returns FALSE on a read error
+    BOOL ReadChunk(HANDLE file, __int64& readPos, char* buf, int& bufLen, BOOL& eof);
+
+    // searches the file for plain text / a regular expression; return FALSE on an error
+    BOOL SearchText(HANDLE file, char* buf);
+    BOOL SearchRegular(HANDLE file, char* buf);
+
+    // adds a hit to the index; returns FALSE if no more hits can be added
+    BOOL AddHit(__int64 offset, int len);
+
+    __int64 GetHitOffset(int i) { return HitOffsets[i >> VIEWER_SEARCH_HIT_BLOCK_SHIFT][i & (VIEWER_SEARCH_HIT_BLOCK - 1)]; }
+    int GetHitLen(int i) { return Regular ? HitLengths[i >> VIEWER_SEARCH_HIT_BLOCK_SHIFT][i & (VIEWER_SEARCH_HIT_BLOCK - 1)] : PatternLen; }
+
+    // returns the index of the first hit beginning at or after 'offset' (HitCount if there is none);
+    // must be called inside CS
+    int FindFirstHit(__int64 offset);
+
+    // releases the blocks of hits
+    void FreeHits();
+
+    void SetScannedSize(__int64 size);
+    void Notify(BOOL force);
+
+    friend unsigned ViewerSearchIndexThreadBody(void* param);
+};
+
 // ****************************************************************************
 
 class CViewerGoToOffsetDialog : public CCommonDialog
 {
 public:
-    CViewerGoToOffsetDialog(HWND parent, __int64* offset)
-        : CCommonDialog(HLanguage, IDD_VIEWERGOTOOFFSET, IDD_VIEWERGOTOOFFSET, parent) { Offset = offset; }
+    CViewerGoToOffsetDialog(HWND parent, __int64* offset, CViewerLineIndex* lineIndex)
+        : CCommonDialog(HLanguage, IDD_VIEWERGOTOOFFSET, IDD_VIEWERGOTOOFFSET, parent)
+    {
+        Offset = offset;
+        LineIndex = lineIndex;
+    }
 
     virtual void Validate(CTransferInfo& ti);
     virtual void Transfer(CTransferInfo& ti);
@@ -103,7 +306,8 @@ protected:
     virtual INT_PTR DialogProc(UINT uMsg, WPARAM wParam, LPARAM lParam);
 
 protected:
-    __int64* Offset;
+    __int64* Offset;              // offset or line number (from 1) according to Configuration.GoToOffsetIsLine
+    CViewerLineIndex* LineIndex; // for converting between an offset and a line number
 };
 
 // ****************************************************************************
@@ -194,6 +398,17 @@ protected:
     // when switching to hex mode
     __int64 FindSeekBefore(__int64 seek, int lines, BOOL& fatalErr, __int64* firstLineEndOff = NULL,
                            __int64* firstLineCharLen = NULL, BOOL addLineIfSeekIsWrap = FALSE);
+    // finds the offset of the beginning of line 'line' (counted from 0) using LineIndex; waits
+    // for the index if it has not reached the line yet; returns FALSE if the user cancelled
+    // waiting or on a read error
+    BOOL FindLineOffset(__int64 line, __int64& offset);
+
+    // starts the background search for the pattern of FindDialog unless it already runs or finished
+    void StartSearchIndex();
+
+    // paints the hit map of SearchIndex into the column to the left of the text
+    void PaintHitMap(HDC dc);
+
     // 'hFile' parameter, see the comment for Prepare(); if a read error occurs, fatalErr == TRUE;
     // ExitTextMode does not arise here (it does not become TRUE)
     BOOL FindNextEOL(HANDLE* hFile, __int64 seek, __int64 maxSeek, __int64& lineEnd, __int64& nextLineBegin, BOOL& fatalErr);
@@ -326,6 +541,7 @@ protected:
                                       // if it is -1, the optimization is skipped
     __int64 EndSelectionPrefX;        // preferred x coordinate when dragging the block end via Shift+up/down arrows (-1 = none)
     TDirectArray<__int64> LineOffset; // array with offsets of line beginnings and ends (without EOL) + lengths in displayed characters (a triple per line)
+    CViewerLineIndex LineIndex;       // sparse index of line beginnings in the whole file (for Go To Line)
     BOOL WrapIsBeforeFirstLine;       // text view only in wrap mode: the line before the first view line is a wrap (not an EOL)
     BOOL MouseDrag;                   // is the block being dragged with the mouse?
     BOOL ChangingSelWithShiftKey;     // is the selection being changed via Shift+key (arrows, End, Home)
@@ -333,6 +549,7 @@ protected:
     CFindSetDialog FindDialog;
     CSearchData SearchData;
     CRegularExpression RegExp;
+    CViewerSearchIndex SearchIndex; // hits of the current search in the whole file (searched in the background)
     __int64 FindOffset,              // seek from which to search
         LastFindSeekY,               // seek of the first screen line after searching, for detecting back-and-forth movement
         LastFindOffset;              // seek from which to search (set after searching), for detecting back-and-forth movement
@@ -817,6 +817,11 @@ void CViewerWindow::FileChanged(HANDLE file, BOOL testOnlyFileSize, BOOL& fatalE
                 ReleaseMouseDrag();
                 FirstLineSize = LastLineSize = ViewSize = 0;
                 LastFindSeekY = -1;
+                if (SearchIndex.IsStarted()) // hits of the background search are no longer valid
+                {
+                    SearchIndex.Stop();
+                    SetViewerCaption();
+                }
 
                 if (detectFileType)
                 {
@@ -906,6 +911,21 @@ void CViewerWindow::FileChanged(HANDLE file, BOOL testOnlyFileSize, BOOL& fatalE
                     }
                 }
 
+                // the line index is built only when Go To uses line numbers or after the first Go To
+                // in this file (see CM_GOTOOFFSET), then it is kept in sync with the file; when the
+                // file only grew (e.g. a followed log), just the appended part gets indexed
+                if (!fatalErr && Type == vtText)
+                {
+                    const char* codeTable = UseCodeTable ? CodeTable : NULL;
+                    BOOL indexUsed = LineIndex.Matches(FileName, codeTable);
+                    if (indexUsed && testOnlyFileSize && FileSize > oldFS)
+                        LineIndex.Extend(FileSize);
+                    else if (indexUsed || Configuration.GoToOffsetIsLine)
+                        LineIndex.Start(FileName, FileSize, codeTable);
+                    else
+                        LineIndex.Stop(); // another file or its content changed, started again by Go To
+                }
+
                 if (!fatalErr)
                 {
                     HeightChanged(fatalErr);
@@ -49,9 +49,64 @@ void CViewerWindow::SetViewerCaption()
             sprintf(caption + strlen(caption), " - [%s]", codeName);
         }
     }
+    __int64 current, count;
+    BOOL complete;
+    if (SearchIndex.GetHitCount(min(StartSelection, EndSelection), current, count, complete))
+    {
+        char num1[50];
+        char num2[50];
+        NumberToStr(num2, CQuadWord().SetUI64(count));
+        if (!complete)
+            strcat(num2, "+"); // the search has not finished yet
+        char hits[200];
+        if (StartSelection != EndSelection && SelectionIsFindResult && current > 0)
+        {
+            NumberToStr(num1, CQuadWord().SetUI64(current));
+            _snprintf_s(hits, _TRUNCATE, LoadStr(IDS_VIEWER_SEARCHHIT), num1, num2);
+        }
+        else
+            _snprintf_s(hits, _TRUNCATE, LoadStr(IDS_VIEWER_SEARCHHITS), num2);
+        sprintf(caption + strlen(caption), " - [%s]", hits);
+    }
     SetWindowText(HWindow, caption);
 }
 
+void CViewerWindow::StartSearchIndex()
+{
+    if (FileName == NULL || FindDialog.Text[0] == 0)
+        return;
+    const char* pattern;
+    int patternLen;
+    if (FindDialog.Regular)
+    {
+        if (!RegExp.IsGood())
+            return;
+        pattern = RegExp.GetPattern();
+        patternLen = (int)strlen(pattern);
+    }
+    else
+    {
+        if (!SearchData.IsGood())
+            return;
+        pattern = SearchData.GetPattern();
+        patternLen = SearchData.GetLength();
+    }
+    const char* codeTable = UseCodeTable ? CodeTable : NULL;
+    if (!SearchIndex.Matches(FileName, FileSize, pattern, patternLen, FindDialog.Regular,
+                             FindDialog.CaseSensitive, FindDialog.WholeWords, codeTable))
+    {
+        SearchIndex.Start(HWindow, FileName, FileSize, pattern, patternLen, FindDialog.Regular,
+                          FindDialog.CaseSensitive, FindDialog.WholeWords, codeTable);
+        InvalidateRect(HWindow, NULL, FALSE); // clear the old hit map
+    }
+}
+
+void CViewerWindow::PaintHitMap(HDC dc)
+{
+    if (SearchIndex.IsStarted())
+        SearchIndex.PaintHitMap(dc, 0, BORDER_WIDTH, Height, BkgndBrushSel);
+}
+
 //
 //*****************************************************************************
 // CViewerWindow
@@ -69,6 +124,55 @@ void CViewerWindow::SetCodeType(int c)
     SetViewerCaption();
 }
 
+BOOL CViewerWindow::FindLineOffset(__int64 line, __int64& offset)
+{
+    CALL_STACK_MESSAGE1("CViewerWindow::FindLineOffset()");
+    if (LineIndex.GetLineOffset(line, offset))
+        return TRUE;
+
+    // the line index has not reached the line yet, wait for it
+    BOOL setWait = (GetCursor() != LoadCursor(NULL, IDC_WAIT)); // is it already waiting?
+    HCURSOR oldCur;
+    if (setWait)
+        oldCur = SetCursor(LoadCursor(NULL, IDC_WAIT));
+
+    CreateSafeWaitWindow(LoadStr(IDS_INDEXINGLINESESC), LoadStr(IDS_VIEWERTITLE), 1000, TRUE, HWindow);
+    GetAsyncKeyState(VK_ESCAPE); // init GetAsyncKeyState - see help
+
+    BOOL ret = FALSE;
+    BOOL readErr = FALSE;
+    while (1)
+    {
+        BOOL indexing = LineIndex.IsIndexing(); // must be tested before GetLineOffset()
+        if (LineIndex.GetLineOffset(line, offset))
+        {
+            ret = TRUE;
+            break;
+        }
+        if (!indexing) // the index stays incomplete (read error)
+        {
+            readErr = TRUE;
+            break;
+        }
+        if ((GetAsyncKeyState(VK_ESCAPE) & 0x8001) && ViewerActive(HWindow) ||
+            GetSafeWaitWindowClosePressed())
+        {
+            break;
+        }
+        Sleep(50);
+    }
+
+    DestroySafeWaitWindow();
+    if (setWait)
+        SetCursor(oldCur);
+    if (readErr)
+    {
+        SalMessageBoxViewerPaintBlocked(HWindow, LoadStr(IDS_VIEWER_UNKNOWNERR), LoadStr(IDS_ERRORREADINGFILE),
+                                        MB_OK | MB_ICONEXCLAMATION);
+    }
+    return ret;
+}
+
 void CViewerWindow::OnVScroll()
 {
     if (VScrollWParam != -1 && VScrollWParam != VScrollWParamOld)
@@ -1008,6 +1112,12 @@ CViewerWindow::WindowProc(UINT uMsg, WPARAM wParam, LPARAM lParam)
             BOOL noNotFound = FALSE;
             BOOL escPressed = FALSE;
 
+            // the background search may already know the answer
+            StartSearchIndex();
+            __int64 hitOffset;
+            int hitLen;
+            int indexRes = SearchIndex.FindHit(FindOffset, forward, hitOffset, hitLen);
+
             BOOL setWait = (GetCursor() != LoadCursor(NULL, IDC_WAIT)); // is it already waiting?
             HCURSOR oldCur;
             if (setWait)
@@ -1022,7 +1132,25 @@ CViewerWindow::WindowProc(UINT uMsg, WPARAM wParam, LPARAM lParam)
 
             BOOL fatalErr = FALSE;
             FindingSoDonotSwitchToHex = TRUE; // during searching disable switching to "hex" when a line has more than 10000 characters
-            if (FindDialog.Regular)
+            if (indexRes != -1) // the background search has covered the searched part of the file
+            {
+                if (indexRes == 1)
+                {
+                    if (forward)
+                    {
+                        StartSelection = hitOffset;
+                        FindOffset = EndSelection = hitOffset + hitLen;
+                    }
+                    else
+                    {
+                        FindOffset = StartSelection = hitOffset;
+                        EndSelection = hitOffset + hitLen;
+                    }
+                    SelectionIsFindResult = TRUE;
+                    found = 0;
+                }
+            }
+            else if (FindDialog.Regular)
             {
                 if (RegExp.SetFlags(flags))
                 {
@@ -1486,6 +1614,7 @@ CViewerWindow::WindowProc(UINT uMsg, WPARAM wParam, LPARAM lParam)
             // remember the position of the last search to detect moving back and forth
             LastFindSeekY = SeekY;
             LastFindOffset = FindOffset;
+            SetViewerCaption(); // number of the found match
 
             return 0;
         }
@@ -1787,9 +1916,19 @@ CViewerWindow::WindowProc(UINT uMsg, WPARAM wParam, LPARAM lParam)
         {
             if (MouseDrag || FileName == NULL)
                 return 0;
+            const char* codeTable = UseCodeTable ? CodeTable : NULL;
+            if (!LineIndex.Matches(FileName, codeTable)) // e.g. hex mode or another code page
+                LineIndex.Start(FileName, FileSize, codeTable);
             __int64 offset = SeekY;
-            if (CViewerGoToOffsetDialog(HWindow, &offset).Execute() == IDOK)
+            if (Configuration.GoToOffsetIsLine)
+            {
+                __int64 line;
+                offset = LineIndex.GetOffsetLine(SeekY, line) ? line + 1 : 1;
+            }
+            if (CViewerGoToOffsetDialog(HWindow, &offset, &LineIndex).Execute() == IDOK)
             {
+                if (Configuration.GoToOffsetIsLine && !FindLineOffset(offset - 1, offset))
+                    return 0; // cancelled by the user or a read error
                 EndSelectionRow = -1; // disable the optimization
                 SeekY = offset;
                 SeekY = min(SeekY, MaxSeekY);
@@ -2846,6 +2985,21 @@ CViewerWindow::WindowProc(UINT uMsg, WPARAM wParam, LPARAM lParam)
         break;
     }
 
+    case WM_USER_VIEWERSEARCHPROGRESS:
+    {
+        SetViewerCaption();
+        HDC dc = HANDLES(GetDC(HWindow));
+        RECT r;
+        r.left = 0;
+        r.right = BORDER_WIDTH;
+        r.top = 0;
+        r.bottom = Height;
+        FillRect(dc, &r, BkgndBrush);
+        PaintHitMap(dc);
+        HANDLES(ReleaseDC(HWindow, dc));
+        return 0;
+    }
+
     case WM_TIMER:
     {
         if (wParam == IDT_THUMBSCROLL)
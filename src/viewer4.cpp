@@ -0,0 +1,1059 @@
+﻿// SPDX-FileCopyrightText: 2023 Open Salamander Authors
+// SPDX-License-Identifier: GPL-2.0-or-later
+// CommentsTranslationProject: TRANSLATED
+
+#include "precomp.h"
+
+#include "cfgdlg.h"
+#include "viewer.h"
+
+#define LINE_INDEX_CHUNK_SIZE (1024 * 1024) // how often the scanning tests CViewerLineIndex::Terminate
+
+//
+//*****************************************************************************
+// CViewerLineIndex
+//
+
+unsigned ViewerLineIndexThreadBody(void* param)
+{
+    CALL_STACK_MESSAGE1("ViewerLineIndexThreadBody()");
+    CViewerLineIndex* index = (CViewerLineIndex*)param;
+    while (!index->Terminate)
+    {
+        EnterCriticalSection(&index->CS);
+        __int64 pos = index->IndexedSize;
+        __int64 to = index->TargetSize;
+        if (pos >= to) // everything is indexed; Extend() will start a new thread if the file grows
+        {
+            index->Running = FALSE;
+            LeaveCriticalSection(&index->CS);
+            return 0;
+        }
+        LeaveCriticalSection(&index->CS);
+
+        BOOL ok = index->ScanFile(pos, to, index->ScanLines, index->ScanCR, TRUE, -1, -1, NULL);
+
+        EnterCriticalSection(&index->CS);
+        index->IndexedSize = pos;
+        if (!ok || index->Failed) // read error or low memory
+        {
+            TRACE_I("ViewerLineIndexThreadBody(): unable to index the file, the line index stays incomplete.");
+            index->Failed = TRUE;
+            index->Running = FALSE;
+            LeaveCriticalSection(&index->CS);
+            return 0;
+        }
+        LeaveCriticalSection(&index->CS);
+    }
+    EnterCriticalSection(&index->CS);
+    index->Running = FALSE;
+    LeaveCriticalSection(&index->CS);
+    return 0;
+}
+
+unsigned ViewerLineIndexThreadEH(void* param)
+{
+#ifndef CALLSTK_DISABLE
+    __try
+    {
+#endif // CALLSTK_DISABLE
+        return ViewerLineIndexThreadBody(param);
+#ifndef CALLSTK_DISABLE
+    }
+    __except (CCallStack::HandleException(GetExceptionInformation()))
+    {
+        TRACE_I("Thread ViewerLineIndex: calling ExitProcess(1).");
+        //    ExitProcess(1);
+        TerminateProcess(GetCurrentProcess(), 1); // more forceful exit (this variant still executes some handlers)
+        return 1;
+    }
+#endif // CALLSTK_DISABLE
+}
+
+DWORD WINAPI ViewerLineIndexThreadF(void* param)
+{
+#ifndef CALLSTK_DISABLE
+    CCallStack stack;
+#endif // CALLSTK_DISABLE
+    SetThreadNameInVCAndTrace("ViewerLineIndex");
+    return ViewerLineIndexThreadEH(param);
+}
+
+CViewerLineIndex::CViewerLineIndex() : Offsets(1000, 1000)
+{
+    HANDLES(InitializeCriticalSection(&CS));
+    FileName = NULL;
+    Thread = NULL;
+    Terminate = FALSE;
+    Running = FALSE;
+    Failed = FALSE;
+    IndexedSize = 0;
+    TargetSize = 0;
+    ScanLines = 0;
+    ScanCR = 0;
+    EOL_CRLF = EOL_CR = EOL_LF = EOL_NULL = FALSE;
+    memset(CharClass, 0, sizeof(CharClass));
+}
+
+CViewerLineIndex::~CViewerLineIndex()
+{
+    Stop();
+    HANDLES(DeleteCriticalSection(&CS));
+}
+
+void CViewerLineIndex::SetCharClass(const char* codeTable)
+{
+    int i;
+    for (i = 0; i < 256; i++)
+    {
+        unsigned char c = codeTable != NULL ? (unsigned char)codeTable[i] : (unsigned char)i;
+        switch (c)
+        {
+        case '\r':
+            CharClass[i] = 1;
+            break;
+        case '\n':
+            CharClass[i] = 2;
+            break;
+        case 0:
+            CharClass[i] = 3;
+            break;
+        default:
+            CharClass[i] = 0;
+            break;
+        }
+    }
+}
+
+BOOL CViewerLineIndex::StartThread()
+{
+    DWORD id;
+    Thread = HANDLES(CreateThread(NULL, 0, ViewerLineIndexThreadF, this, 0, &id));
+    if (Thread == NULL)
+    {
+        TRACE_E("Unable to start ViewerLineIndex thread.");
+        return FALSE;
+    }
+    SetThreadPriority(Thread, THREAD_PRIORITY_BELOW_NORMAL); // the viewer itself must stay responsive
+    return TRUE;
+}
+
+void CViewerLineIndex::WaitForThread()
+{
+    if (Thread != NULL)
+    {
+        WaitForSingleObject(Thread, INFINITE);
+        HANDLES(CloseHandle(Thread));
+        Thread = NULL;
+    }
+}
+
+void CViewerLineIndex::Start(const char* fileName, __int64 fileSize, const char* codeTable)
+{
+    CALL_STACK_MESSAGE2("CViewerLineIndex::Start(%s, , )", fileName);
+    Stop();
+    FileName = DupStr(fileName);
+    if (FileName == NULL)
+        return; // low memory, the index stays unavailable
+
+    EOL_CRLF = Configuration.EOL_CRLF;
+    EOL_CR = Configuration.EOL_CR;
+    EOL_LF = Configuration.EOL_LF;
+    EOL_NULL = Configuration.EOL_NULL;
+    SetCharClass(codeTable);
+
+    Offsets.Add(0); // line 0 always begins at offset 0
+    if (!Offsets.IsGood())
+    {
+        Offsets.ResetState();
+        Failed = TRUE;
+        return;
+    }
+    IndexedSize = 0;
+    TargetSize = fileSize;
+    ScanLines = 0;
+    ScanCR = 0;
+    Failed = FALSE;
+    Terminate = FALSE;
+    Running = TRUE;
+    if (!StartThread())
+    {
+        Running = FALSE;
+        Failed = TRUE;
+    }
+}
+
+void CViewerLineIndex::Extend(__int64 fileSize)
+{
+    CALL_STACK_MESSAGE1("CViewerLineIndex::Extend()");
+    if (FileName == NULL)
+        return;
+    EnterCriticalSection(&CS);
+    if (fileSize > TargetSize)
+        TargetSize = fileSize;
+    // a running thread picks up the new TargetSize itself; a finished one must be started again
+    BOOL restart = !Running && !Failed && IndexedSize < TargetSize;
+    if (restart)
+        Running = TRUE;
+    LeaveCriticalSection(&CS);
+    if (restart)
+    {
+        WaitForThread();
+        if (!StartThread())
+        {
+            EnterCriticalSection(&CS);
+            Running = FALSE;
+            Failed = TRUE;
+            LeaveCriticalSection(&CS);
+        }
+    }
+}
+
+void CViewerLineIndex::Stop()
+{
+    Terminate = TRUE;
+    WaitForThread();
+    Terminate = FALSE;
+    if (FileName != NULL)
+    {
+        free(FileName);
+        FileName = NULL;
+    }
+    Offsets.DestroyMembers();
+    Running = FALSE;
+    Failed = FALSE;
+    IndexedSize = TargetSize = 0;
+}
+
+BOOL CViewerLineIndex::Matches(const char* fileName, const char* codeTable)
+{
+    if (FileName == NULL || fileName == NULL || StrICmp(FileName, fileName) != 0 ||
+        EOL_CRLF != Configuration.EOL_CRLF || EOL_CR != Configuration.EOL_CR ||
+        EOL_LF != Configuration.EOL_LF || EOL_NULL != Configuration.EOL_NULL)
+    {
+        return FALSE;
+    }
+    int i;
+    for (i = 0; i < 256; i++)
+    {
+        unsigned char c = codeTable != NULL ? (unsigned char)codeTable[i] : (unsigned char)i;
+        unsigned char cls = c == '\r' ? 1 : c == '\n' ? 2 : c == 0 ? 3 : 0;
+        if (CharClass[i] != cls)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+BOOL CViewerLineIndex::IsIndexing()
+{
+    EnterCriticalSection(&CS);
+    BOOL ret = Running;
+    LeaveCriticalSection(&CS);
+    return ret;
+}
+
+// called for every line beginning found by ScanBlock()
+#define LINE_INDEX_FOUND_BEGIN(begin) \
+    { \
+        if (maxBegin != -1 && (begin) > maxBegin) \
+            return TRUE; \
+        lines++; \
+        if (lastBegin != NULL) \
+            *lastBegin = (begin); \
+        if (addOffsets && (lines % LINE_INDEX_STEP) == 0) \
+        { \
+            EnterCriticalSection(&CS); \
+            Offsets.Add(begin); \
+            BOOL lowMem = !Offsets.IsGood(); \
+            if (lowMem) \
+            { \
+                Offsets.ResetState(); \
+                Failed = TRUE; \
+            } \
+            LeaveCriticalSection(&CS); \
+            if (lowMem) \
+                return TRUE; \
+        } \
+        if (lines == stopLine) \
+            return TRUE; \
+    }
+
+BOOL CViewerLineIndex::ScanBlock(const unsigned char* s, const unsigned char* end, __int64 base, __int64& lines,
+                                 int& cr, BOOL addOffsets, __int64 stopLine, __int64 maxBegin, __int64* lastBegin)
+{
+    // the line endings are interpreted the same way as in CViewerWindow::FindNextEOL()
+    const unsigned char* start = s;
+    while (s < end)
+    {
+        if (cr == 0)
+        {
+            while (s < end && CharClass[*s] == 0) // skip ordinary characters quickly
+                s++;
+            if (s == end)
+                break;
+        }
+        int cls = CharClass[*s];
+        if (cr != 0)
+        {
+            __int64 off = base + (s - start);
+            if (cls == 2 && EOL_CRLF) // "\r\n"
+            {
+                cr = 0;
+                s++;
+                LINE_INDEX_FOUND_BEGIN(off + 1);
+                continue;
+            }
+            if (cr == 1) // a single '\r' is the end of line
+            {
+                cr = 0;
+                LINE_INDEX_FOUND_BEGIN(off);
+            }
+            cr = 0;
+        }
+        s++;
+        switch (cls)
+        {
+        case 1:
+        {
+            if (EOL_CR)
+                cr = 1;
+            else
+            {
+                if (EOL_CRLF)
+                    cr = 2;
+            }
+            break;
+        }
+
+        case 2:
+        {
+            if (EOL_LF)
+                LINE_INDEX_FOUND_BEGIN(base + (s - start));
+            break;
+        }
+
+        case 3:
+        {
+            if (EOL_NULL)
+                LINE_INDEX_FOUND_BEGIN(base + (s - start));
+            break;
+        }
+        }
+    }
+    return FALSE;
+}
+
+BOOL CViewerLineIndex::ScanFile(__int64& pos, __int64 to, __int64& lines, int& cr, BOOL addOffsets,
+                                __int64 stopLine, __int64 maxBegin, __int64* lastBegin)
+{
+    CALL_STACK_MESSAGE_NONE // __try below does not allow objects with destructors in this function
+    HANDLE file = HANDLES_Q(CreateFile(FileName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                                       OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL));
+    if (file == INVALID_HANDLE_VALUE)
+        return FALSE;
+
+    BOOL ok = TRUE;
+    CQuadWord size;
+    DWORD err;
+    if (SalGetFileSize(file, size, err))
+    {
+        if (to == -1 || (unsigned __int64)to > size.Value)
+            to = (__int64)size.Value;
+        if (pos < to)
+        {
+            // the mapping covers the file as it is now, so it may have grown meanwhile but never shrunk
+            HANDLE mapping = HANDLES(CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL));
+            if (mapping != NULL)
+            {
+                BOOL stop = FALSE;
+                while (!stop && ok && !Terminate && pos < to)
+                {
+                    __int64 viewStart = pos - pos % AllocationGranularity;
+                    DWORD viewSize = (DWORD)min((__int64)LINE_INDEX_VIEW_SIZE, to - viewStart);
+                    unsigned char* view = (unsigned char*)HANDLES(MapViewOfFile(mapping, FILE_MAP_READ,
+                                                                                (DWORD)(viewStart >> 32),
+                                                                                (DWORD)viewStart, viewSize));
+                    if (view == NULL)
+                    {
+                        ok = FALSE;
+                        break;
+                    }
+                    __try
+                    {
+                        while (!Terminate && pos < viewStart + viewSize)
+                        {
+                            __int64 chunkEnd = min(pos + LINE_INDEX_CHUNK_SIZE, viewStart + viewSize);
+                            if (ScanBlock(view + (pos - viewStart), view + (chunkEnd - viewStart), pos,
+                                          lines, cr, addOffsets, stopLine, maxBegin, lastBegin))
+                            {
+                                stop = TRUE;
+                                break;
+                            }
+                            pos = chunkEnd;
+                        }
+                    }
+                    __except (HandleFileException(GetExceptionInformation(), (char*)view, viewSize))
+                    {
+                        ok = FALSE; // read error, the scanning state is no longer valid
+                    }
+                    HANDLES(UnmapViewOfFile(view));
+                }
+                HANDLES(CloseHandle(mapping));
+            }
+            else
+                ok = FALSE;
+        }
+    }
+    else
+        ok = FALSE;
+    HANDLES(CloseHandle(file));
+    return ok;
+}
+
+BOOL CViewerLineIndex::GetLineOffset(__int64 line, __int64& offset)
+{
+    CALL_STACK_MESSAGE1("CViewerLineIndex::GetLineOffset()");
+    if (FileName == NULL)
+        return FALSE;
+    if (line < 0)
+        line = 0;
+
+    EnterCriticalSection(&CS);
+    if (Offsets.Count == 0) // low memory in Start()
+    {
+        LeaveCriticalSection(&CS);
+        return FALSE;
+    }
+    __int64 i = line / LINE_INDEX_STEP;
+    if (i >= Offsets.Count)
+    {
+        if (Running || Failed) // the line has not been indexed yet
+        {
+            LeaveCriticalSection(&CS);
+            return FALSE;
+        }
+        i = Offsets.Count - 1; // the file has fewer lines, look for the last one
+    }
+    __int64 pos = Offsets[(int)i];
+    LeaveCriticalSection(&CS);
+
+    // count the remaining lines from the nearest stored line beginning
+    __int64 lines = i * LINE_INDEX_STEP;
+    __int64 lastBegin = pos;
+    int cr = 0;
+    if (lines < line && !ScanFile(pos, -1, lines, cr, FALSE, line, -1, &lastBegin))
+        return FALSE;
+    offset = lastBegin;
+    return TRUE;
+}
+
+BOOL CViewerLineIndex::GetOffsetLine(__int64 offset, __int64& line)
+{
+    CALL_STACK_MESSAGE1("CViewerLineIndex::GetOffsetLine()");
+    if (FileName == NULL)
+        return FALSE;
+    if (offset < 0)
+        offset = 0;
+
+    EnterCriticalSection(&CS);
+    if (Offsets.Count == 0 ||                          // low memory in Start()
+        offset >= IndexedSize && (Running || Failed)) // the offset has not been indexed yet
+    {
+        LeaveCriticalSection(&CS);
+        return FALSE;
+    }
+    // find the last stored line beginning at or before 'offset'
+    int l = 0, r = Offsets.Count - 1;
+    while (l < r)
+    {
+        int m = (l + r + 1) / 2;
+        if (Offsets[m] <= offset)
+            l = m;
+        else
+            r = m - 1;
+    }
+    __int64 pos = Offsets[l];
+    LeaveCriticalSection(&CS);
+
+    __int64 lines = (__int64)l * LINE_INDEX_STEP;
+    int cr = 0;
+    if (pos < offset && !ScanFile(pos, offset + 1, lines, cr, FALSE, -1, offset, NULL))
+        return FALSE;
+    line = lines;
+    return TRUE;
+}
+
+//
+//*****************************************************************************
+// CViewerSearchIndex
+//
+
+unsigned ViewerSearchIndexThreadBody(void* param)
+{
+    CALL_STACK_MESSAGE1("ViewerSearchIndexThreadBody()");
+    CViewerSearchIndex* index = (CViewerSearchIndex*)param;
+
+    BOOL ok = FALSE;
+    char* buf = (char*)malloc(VIEWER_SEARCH_CHUNK_SIZE + FIND_LINE_LEN + 2); // chunk + the rest of the previous one
+    if (buf != NULL)
+    {
+        HANDLE file = HANDLES_Q(CreateFile(index->FileName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                                           OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL));
+        if (file != INVALID_HANDLE_VALUE)
+        {
+            if (index->Regular)
+                ok = index->SearchRegular(file, buf);
+            else
+                ok = index->SearchText(file, buf);
+            HANDLES(CloseHandle(file));
+        }
+        free(buf);
+    }
+    else
+        TRACE_E(LOW_MEMORY);
+
+    EnterCriticalSection(&index->CS);
+    if (!ok)
+        index->Failed = TRUE;
+    else
+    {
+        if (!index->Terminate && !index->Truncated)
+            index->ScannedSize = index->FileSize; // the whole file has been searched
+    }
+    index->Running = FALSE;
+    LeaveCriticalSection(&index->CS);
+    if (!index->Terminate)
+        index->Notify(TRUE);
+    return 0;
+}
+
+unsigned ViewerSearchIndexThreadEH(void* param)
+{
+#ifndef CALLSTK_DISABLE
+    __try
+    {
+#endif // CALLSTK_DISABLE
+        return ViewerSearchIndexThreadBody(param);
+#ifndef CALLSTK_DISABLE
+    }
+    __except (CCallStack::HandleException(GetExceptionInformation()))
+    {
+        TRACE_I("Thread ViewerSearchIndex: calling ExitProcess(1).");
+        //    ExitProcess(1);
+        TerminateProcess(GetCurrentProcess(), 1); // more forceful exit (this variant still executes some handlers)
+        return 1;
+    }
+#endif // CALLSTK_DISABLE
+}
+
+DWORD WINAPI ViewerSearchIndexThreadF(void* param)
+{
+#ifndef CALLSTK_DISABLE
+    CCallStack stack;
+#endif // CALLSTK_DISABLE
+    SetThreadNameInVCAndTrace("ViewerSearchIndex");
+    return ViewerSearchIndexThreadEH(param);
+}
+
+// returns TRUE if 'c' is a part of a word (the same test as in CViewerWindow::WindowProc)
+inline BOOL IsViewerWordChar(char c)
+{
+    return c == '_' || IsCharAlpha(c) || IsCharAlphaNumeric(c);
+}
+
+CViewerSearchIndex::CViewerSearchIndex()
+{
+    HANDLES(InitializeCriticalSection(&CS));
+    Thread = NULL;
+    Terminate = FALSE;
+    Running = FALSE;
+    Failed = FALSE;
+    Truncated = FALSE;
+    NotifyWindow = NULL;
+    LastNotify = 0;
+    FileName = NULL;
+    FileSize = 0;
+    Pattern = NULL;
+    PatternLen = 0;
+    Regular = CaseSensitive = WholeWords = FALSE;
+    UseCodeTable = FALSE;
+    EOL_CRLF = EOL_CR = EOL_LF = FALSE;
+    memset(HitOffsets, 0, sizeof(HitOffsets));
+    memset(HitLengths, 0, sizeof(HitLengths));
+    HitCount = 0;
+    ScannedSize = 0;
+    memset(HitMap, 0, sizeof(HitMap));
+    HitMapBucket = 1;
+}
+
+CViewerSearchIndex::~CViewerSearchIndex()
+{
+    Stop();
+    HANDLES(DeleteCriticalSection(&CS));
+}
+
+void CViewerSearchIndex::Start(HWND notifyWindow, const char* fileName, __int64 fileSize, const char* pattern,
+                               int patternLen, BOOL regular, BOOL caseSensitive, BOOL wholeWords,
+                               const char* codeTable)
+{
+    CALL_STACK_MESSAGE2("CViewerSearchIndex::Start(, %s, , , , , , , )", fileName);
+    Stop();
+    FileName = DupStr(fileName);
+    Pattern = (char*)malloc(patternLen + 1); // CSearchData::Set() needs a null-terminated pattern
+    if (FileName == NULL || Pattern == NULL)
+    {
+        if (Pattern == NULL)
+            TRACE_E(LOW_MEMORY);
+        Stop();
+        return;
+    }
+    memcpy(Pattern, pattern, patternLen);
+    Pattern[patternLen] = 0;
+    PatternLen = patternLen;
+    NotifyWindow = notifyWindow;
+    FileSize = fileSize;
+    Regular = regular;
+    CaseSensitive = caseSensitive;
+    WholeWords = wholeWords;
+    UseCodeTable = codeTable != NULL;
+    if (UseCodeTable)
+        memcpy(CodeTable, codeTable, 256);
+    EOL_CRLF = Configuration.EOL_CRLF;
+    EOL_CR = Configuration.EOL_CR;
+    EOL_LF = Configuration.EOL_LF;
+    ScannedSize = 0;
+    memset(HitMap, 0, sizeof(HitMap));
+    HitMapBucket = FileSize / VIEWER_HIT_MAP_SIZE + 1;
+    LastNotify = GetTickCount();
+    Failed = Truncated = FALSE;
+    Terminate = FALSE;
+    Running = TRUE;
+
+    DWORD id;
+    Thread = HANDLES(CreateThread(NULL, 0, ViewerSearchIndexThreadF, this, 0, &id));
+    if (Thread == NULL)
+    {
+        TRACE_E("Unable to start ViewerSearchIndex thread.");
+        Running = FALSE;
+        Failed = TRUE;
+    }
+    else
+        SetThreadPriority(Thread, THREAD_PRIORITY_BELOW_NORMAL); // the viewer itself must stay responsive
+}
+
+void CViewerSearchIndex::Stop()
+{
+    if (Thread != NULL)
+    {
+        Terminate = TRUE;
+        WaitForSingleObject(Thread, INFINITE);
+        HANDLES(CloseHandle(Thread));
+        Thread = NULL;
+        Terminate = FALSE;
+    }
+    if (FileName != NULL)
+    {
+        free(FileName);
+        FileName = NULL;
+    }
+    if (Pattern != NULL)
+    {
+        free(Pattern);
+        Pattern = NULL;
+    }
+    PatternLen = 0;
+    FreeHits();
+    Running = Failed = Truncated = FALSE;
+    ScannedSize = 0;
+}
+
+BOOL CViewerSearchIndex::Matches(const char* fileName, __int64 fileSize, const char* pattern, int patternLen,
+                                 BOOL regular, BOOL caseSensitive, BOOL wholeWords, const char* codeTable)
+{
+    if (FileName == NULL || StrICmp(FileName, fileName) != 0 || FileSize != fileSize ||
+        PatternLen != patternLen || memcmp(Pattern, pattern, patternLen) != 0 ||
+        Regular != regular || CaseSensitive != caseSensitive || WholeWords != wholeWords ||
+        UseCodeTable != (codeTable != NULL) || UseCodeTable && memcmp(CodeTable, codeTable, 256) != 0)
+    {
+        return FALSE;
+    }
+    if (Regular && (EOL_CRLF != Configuration.EOL_CRLF || EOL_CR != Configuration.EOL_CR ||
+                    EOL_LF != Configuration.EOL_LF))
+    {
+        return FALSE; // lines of the file have changed
+    }
+    return TRUE;
+}
+
+void CViewerSearchIndex::Notify(BOOL force)
+{
+    DWORD ti = GetTickCount();
+    if (force || ti - LastNotify >= 300)
+    {
+        LastNotify = ti;
+        PostMessage(NotifyWindow, WM_USER_VIEWERSEARCHPROGRESS, 0, 0);
+    }
+}
+
+void CViewerSearchIndex::SetScannedSize(__int64 size)
+{
+    EnterCriticalSection(&CS);
+    ScannedSize = size;
+    LeaveCriticalSection(&CS);
+    Notify(FALSE);
+}
+
+void CViewerSearchIndex::FreeHits()
+{
+    int i;
+    for (i = 0; i < VIEWER_SEARCH_MAX_HIT_BLOCKS && HitOffsets[i] != NULL; i++)
+    {
+        free(HitOffsets[i]);
+        HitOffsets[i] = NULL;
+        if (HitLengths[i] != NULL)
+        {
+            free(HitLengths[i]);
+            HitLengths[i] = NULL;
+        }
+    }
+    HitCount = 0;
+}
+
+BOOL CViewerSearchIndex::AddHit(__int64 offset, int len)
+{
+    // only this (search) thread changes HitCount and the blocks, so it reads them without CS;
+    // the hit is stored (and a new block allocated) outside CS, the viewer reads only the hits
+    // below HitCount, which is increased inside CS after the hit is stored
+    BOOL ret = HitCount < VIEWER_SEARCH_MAX_HITS;
+    int block = HitCount >> VIEWER_SEARCH_HIT_BLOCK_SHIFT;
+    int item = HitCount & (VIEWER_SEARCH_HIT_BLOCK - 1);
+    if (ret && HitOffsets[block] == NULL)
+    {
+        HitOffsets[block] = (__int64*)malloc(VIEWER_SEARCH_HIT_BLOCK * sizeof(__int64));
+        if (HitOffsets[block] != NULL && Regular)
+        {
+            HitLengths[block] = (int*)malloc(VIEWER_SEARCH_HIT_BLOCK * sizeof(int));
+            if (HitLengths[block] == NULL)
+            {
+                free(HitOffsets[block]);
+                HitOffsets[block] = NULL;
+            }
+        }
+        if (HitOffsets[block] == NULL)
+        {
+            TRACE_E(LOW_MEMORY);
+            ret = FALSE;
+        }
+    }
+    if (ret)
+    {
+        HitOffsets[block][item] = offset;
+        if (Regular)
+            HitLengths[block][item] = len;
+    }
+
+    EnterCriticalSection(&CS);
+    if (ret)
+    {
+        HitCount++;
+        HitMap[offset / HitMapBucket] = 1;
+    }
+    else
+    {
+        Truncated = TRUE;
+        ScannedSize = offset; // hits from this one on are not known
+    }
+    LeaveCriticalSection(&CS);
+    return ret;
+}
+
+BOOL CViewerSearchIndex::ReadChunk(HANDLE file, __int64& readPos, char* buf, int& bufLen, BOOL& eof)
+{
+    DWORD toRead = (DWORD)min((__int64)VIEWER_SEARCH_CHUNK_SIZE, FileSize - readPos);
+    DWORD read = 0;
+    if (toRead > 0 && (!ReadFile(file, buf + bufLen, toRead, &read, NULL) || read != toRead))
+    {
+        TRACE_I("CViewerSearchIndex::ReadChunk(): unable to read the file.");
+        return FALSE;
+    }
+    if (UseCodeTable)
+    {
+        unsigned char* s = (unsigned char*)buf + bufLen - 1;
+        unsigned char* end = (unsigned char*)buf + bufLen + read;
+        while (++s < end)
+            *s = CodeTable[*s];
+    }
+    bufLen += read;
+    readPos += read;
+    eof = readPos >= FileSize;
+    return TRUE;
+}
+
+BOOL CViewerSearchIndex::SearchText(HANDLE file, char* buf)
+{
+    CALL_STACK_MESSAGE1("CViewerSearchIndex::SearchText()");
+    CSearchData searchData;
+    searchData.Set(Pattern, PatternLen, (WORD)(sfForward | (CaseSensitive ? sfCaseSensitive : 0)));
+    if (!searchData.IsGood())
+        return FALSE;
+    int len = searchData.GetLength();
+
+    __int64 readPos = 0;
+    __int64 bufStart = 0; // file offset of buf[0]
+    int bufLen = 0;
+    int searchFrom = 0; // first position in buf where a hit may begin (earlier ones were tested already)
+    BOOL eof = FileSize == 0;
+    while (!Terminate)
+    {
+        if (!eof && !ReadChunk(file, readPos, buf, bufLen, eof))
+            return FALSE;
+
+        // one character behind a hit is needed to test a whole word, unless it is the end of the file
+        int limit = eof ? bufLen : bufLen - 1;
+        int pos = searchFrom;
+        int found;
+        while (pos + len <= limit && (found = searchData.SearchForward(buf, limit, pos)) != -1)
+        {
+            BOOL fail = FALSE;
+            if (WholeWords)
+            {
+                if (bufStart + found > 0) // buf always keeps one character before searchFrom
+                    fail |= IsViewerWordChar(buf[found - 1]);
+                if (found + len < bufLen)
+                    fail |= IsViewerWordChar(buf[found + len]);
+            }
+            if (!fail && !AddHit(bufStart + found, len))
+                return TRUE; // too many hits, the index stays incomplete
+            pos = found + 1;
+        }
+        if (eof)
+            break;
+
+        // keep the part where a hit may still begin plus one character before it
+        int next = max(searchFrom, limit - len + 1);
+        int keep = next > 0 ? next - 1 : 0;
+        memmove(buf, buf + keep, bufLen - keep);
+        bufStart += keep;
+        bufLen -= keep;
+        searchFrom = next - keep;
+        SetScannedSize(bufStart + searchFrom);
+    }
+    return TRUE;
+}
+
+BOOL CViewerSearchIndex::SearchRegular(HANDLE file, char* buf)
+{
+    CALL_STACK_MESSAGE1("CViewerSearchIndex::SearchRegular()");
+    CRegularExpression regExp;
+    if (!regExp.Set(Pattern, (WORD)(sfForward | (CaseSensitive ? sfCaseSensitive : 0))))
+        return FALSE;
+
+    __int64 readPos = 0;
+    __int64 bufStart = 0; // file offset of buf[0]
+    int bufLen = 0;
+    BOOL eof = FileSize == 0;
+    while (!Terminate)
+    {
+        if (!eof && !ReadChunk(file, readPos, buf, bufLen, eof))
+            return FALSE;
+
+        int lineBegin = 0;
+        while (lineBegin < bufLen)
+        {
+            // find the end of the line the same way as CViewerWindow::FindNextEOL() does (the search
+            // always uses EOL_NULL); lines longer than FIND_LINE_LEN are split
+            int maxEnd = min(bufLen, lineBegin + FIND_LINE_LEN + 1);
+            int lineEnd = -1;
+            int nextLineBegin = -1;
+            int s;
+            for (s = lineBegin; s < maxEnd; s++)
+            {
+                unsigned char c = buf[s];
+                if (c > '\r')
+                    continue;
+                if (c == '\r')
+                {
+                    if (s + 1 >= bufLen && !eof)
+                        break; // the next character is needed to recognize "\r\n"
+                    BOOL crlf = EOL_CRLF && s + 1 < bufLen && buf[s + 1] == '\n';
+                    if (EOL_CR || crlf)
+                    {
+                        lineEnd = s;
+                        nextLineBegin = crlf ? s + 2 : s + 1;
+                        break;
+                    }
+                }
+                else
+                {
+                    if (c == '\n' && EOL_LF || c == 0)
+                    {
+                        lineEnd = s;
+                        nextLineBegin = s + 1;
+                        break;
+                    }
+                }
+            }
+            if (lineEnd == -1)
+            {
+                if (s == lineBegin + FIND_LINE_LEN + 1) // too long line
+                    lineEnd = nextLineBegin = lineBegin + FIND_LINE_LEN;
+                else
+                {
+                    if (eof && s >= bufLen) // the last line of the file
+                        lineEnd = nextLineBegin = bufLen;
+                    else
+                        break; // the rest of the line has not been read yet
+                }
+            }
+
+            if (lineBegin < lineEnd)
+            {
+                if (!regExp.SetLine(buf + lineBegin, buf + lineEnd))
+                    return FALSE; // low memory
+                int lineLen = lineEnd - lineBegin;
+                int start = 0;
+                int found, foundLen;
+                while (start < lineLen && (found = regExp.SearchForward(start, foundLen)) != -1)
+                {
+                    if (WholeWords &&
+                        (found > 0 && IsViewerWordChar(buf[lineBegin + found - 1]) ||
+                         found + foundLen < lineLen && IsViewerWordChar(buf[lineBegin + found + foundLen])))
+                    {
+                        start = found + 1;
+                        continue;
+                    }
+                    if (foundLen == 0)
+                        return FALSE; // empty match; the search in the viewer reports it
+                    if (!AddHit(bufStart + lineBegin + found, foundLen))
+                        return TRUE; // too many hits, the index stays incomplete
+                    start = found + foundLen;
+                }
+            }
+            lineBegin = nextLineBegin;
+        }
+        if (eof)
+            break;
+
+        // keep the unfinished line for the next chunk
+        memmove(buf, buf + lineBegin, bufLen - lineBegin);
+        bufStart += lineBegin;
+        bufLen -= lineBegin;
+        SetScannedSize(bufStart);
+    }
+    return TRUE;
+}
+
+int CViewerSearchIndex::FindFirstHit(__int64 offset)
+{
+    int l = 0, r = HitCount;
+    while (l < r)
+    {
+        int m = (l + r) / 2;
+        if (GetHitOffset(m) < offset)
+            l = m + 1;
+        else
+            r = m;
+    }
+    return l;
+}
+
+int CViewerSearchIndex::FindHit(__int64 offset, BOOL forward, __int64& hitOffset, int& hitLen)
+{
+    if (FileName == NULL)
+        return -1;
+    int ret = -1;
+    EnterCriticalSection(&CS);
+    int l = FindFirstHit(offset);
+    if (forward)
+    {
+        if (l < HitCount)
+        {
+            hitOffset = GetHitOffset(l);
+            hitLen = GetHitLen(l);
+            ret = 1;
+        }
+        else
+        {
+            if (ScannedSize >= FileSize && !Running && !Failed && !Truncated)
+                ret = 0;
+        }
+    }
+    else
+    {
+        if (ScannedSize >= offset) // all hits ending at or before 'offset' are known
+        {
+            ret = 0;
+            int i;
+            for (i = l - 1; i >= 0; i--) // hits beginning before 'offset', from the last one
+            {
+                int len = GetHitLen(i);
+                if (GetHitOffset(i) + len <= offset)
+                {
+                    hitOffset = GetHitOffset(i);
+                    hitLen = len;
+                    ret = 1;
+                    break;
+                }
+            }
+        }
+    }
+    LeaveCriticalSection(&CS);
+    return ret;
+}
+
+BOOL CViewerSearchIndex::GetHitCount(__int64 offset, __int64& current, __int64& count, BOOL& complete)
+{
+    if (FileName == NULL)
+        return FALSE;
+    EnterCriticalSection(&CS);
+    count = HitCount;
+    complete = !Running && !Failed && !Truncated;
+    current = 0;
+    int l = FindFirstHit(offset);
+    if (l < HitCount && GetHitOffset(l) == offset)
+        current = l + 1;
+    LeaveCriticalSection(&CS);
+    return TRUE;
+}
+
+void CViewerSearchIndex::PaintHitMap(HDC dc, int x, int width, int height, HBRUSH brush)
+{
+    if (FileName == NULL || FileSize == 0 || height <= 0)
+        return;
+    EnterCriticalSection(&CS);
+    RECT r;
+    r.left = x;
+    r.right = x + width;
+    r.top = -1; // no mark is being drawn
+    int y;
+    for (y = 0; y <= height; y++)
+    {
+        BOOL mark = FALSE;
+        if (y < height)
+        {
+            // the part of the file corresponding to row 'y' (the same proportion as the scrollbar)
+            int first = (int)((__int64)((double)FileSize * y / height) / HitMapBucket);
+            int last = (int)((__int64)((double)FileSize * (y + 1) / height - 1) / HitMapBucket);
+            if (last >= VIEWER_HIT_MAP_SIZE)
+                last = VIEWER_HIT_MAP_SIZE - 1;
+            int i;
+            for (i = first; i <= last; i++)
+            {
+                if (HitMap[i])
+                {
+                    mark = TRUE;
+                    break;
+                }
+            }
+        }
+        if (mark && r.top == -1)
+            r.top = y;
+        if (!mark && r.top != -1) // paint the mark from r.top to y
+        {
+            r.bottom = y;
+            FillRect(dc, &r, brush);
+            r.top = -1;
+        }
+    }
+    LeaveCriticalSection(&CS);
+}
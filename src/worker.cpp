@@ -7797,6 +7797,432 @@ BOOL DoChangeAttrs(HWND hProgressDlg, char* name, const CQuadWord& size, DWORD a
     }
 }
 
+//
+// ****************************************************************************
+// CParallelCopyPool
+//
+// Helper threads used by the worker to copy small files of consecutive ocCopyFile
+// operations in parallel: copying lots of small files between local SSD/NVMe disks
+// is bound by the latency of opening/closing files, not by the transfer speed.
+// Helpers handle only the simplest case: the target file does not exist yet and no
+// error occurs. Everything else (overwrite confirmations, errors with Retry/Skip
+// dialogs, etc.) is returned to the worker thread, which processes the operation
+// through DoCopyFile in script order as before. The worker also keeps doing all
+// accounting (totalDone, TFS, speed meters), so progress stays exact.
+// Files copied ahead of the worker are only committed when the worker consumes them:
+// while the worker handles a file the helpers gave up on (error or confirmation
+// dialog), no other file is started, and when the operation ends (cancel, error)
+// the copied but not consumed files are removed again.
+
+#define PARALLEL_COPY_MAX_THREADS 8                  // upper limit for the number of helper threads
+#define PARALLEL_COPY_WINDOW 32                      // max. number of operations dispatched to helpers and not yet consumed by the worker
+#define PARALLEL_COPY_MAX_FILE_SIZE OPERATION_BUFFER // only files up to this size are copied in parallel (larger files gain nothing here)
+#define PARALLEL_COPY_BUF_SIZE (64 * 1024)           // copy buffer of each helper thread
+
+enum CParallelCopyItemState
+{
+    pcisFree,     // slot is unused
+    pcisWaiting,  // operation waits for a helper thread
+    pcisCopying,  // helper thread copies the file
+    pcisDone,     // file was copied, the worker only accounts it
+    pcisFallback, // file was not copied (target exists, error, cancel, etc.), the worker uses DoCopyFile
+};
+
+struct CParallelCopyItem
+{
+    CParallelCopyItemState State;
+    int Index;        // index of the operation in the script
+    COperation* Op;   // operation from the script
+    DWORD Attr;       // attributes of the target file (Op->Attr & clearReadonlyMask)
+    CQuadWord Copied; // number of copied bytes (valid in state pcisDone)
+};
+
+class CParallelCopyPool
+{
+protected:
+    CRITICAL_SECTION CS;                           // critical section of the object (guards Items, Queue* and Terminate)
+    CParallelCopyItem Items[PARALLEL_COPY_WINDOW]; // operation with script index 'i' uses slot Items[i % PARALLEL_COPY_WINDOW]
+    int Queue[PARALLEL_COPY_WINDOW];               // circular queue of slots in state pcisWaiting (in script order)
+    int QueueFirst;                                // index of the first slot in Queue
+    int QueueCount;                                // number of slots in Queue
+    BOOL Terminate;                                // TRUE = helper threads should end
+    BOOL Paused;                                   // TRUE = helper threads do not start new items (the worker handles a fallback)
+
+    HANDLE ItemWaiting;  // semaphore: number of items in Queue (+ wake-ups for ending threads)
+    HANDLE ItemFinished; // auto-reset event: some item reached pcisDone or pcisFallback
+
+    HANDLE Threads[PARALLEL_COPY_MAX_THREADS];
+    int ThreadsCount;
+
+    HANDLE WorkerNotSuspended; // copy of CProgressDlgData::WorkerNotSuspended
+    BOOL* CancelWorker;        // copy of CProgressDlgData::CancelWorker
+
+    int NextDispatch; // index of the next script operation to consider in Dispatch()
+
+public:
+    CParallelCopyPool(CProgressDlgData& dlgData);
+    ~CParallelCopyPool();
+
+    // returns TRUE if the helper threads are running (object is usable)
+    BOOL IsGood() { return ThreadsCount > 0; }
+
+    // returns TRUE if operation 'op' may be copied by a helper thread
+    static BOOL CanCopyInParallel(COperations* script, COperation* op);
+
+    // hands over ocCopyFile operations following 'index' (including) to the helper threads;
+    // stops at the first other operation (ocCreateDir, ocCopyDirTime, etc. are barriers:
+    // nothing behind them is started before the worker processes them)
+    void Dispatch(COperations* script, int index, DWORD clearReadonlyMask);
+
+    // waits until operation 'index' is processed by a helper thread; returns TRUE if
+    // the file was copied (in 'copied' returns its size), FALSE if the worker has to copy it
+    // itself (the operation was not dispatched or the helper did not finish it); if the
+    // helper gave up on the file, the helpers are paused until Resume() is called (the
+    // worker is going to show an error or a confirmation, the user may cancel)
+    BOOL GetResult(int index, CQuadWord* copied);
+
+    // lets the helper threads continue after GetResult() paused them
+    void Resume();
+
+protected:
+    static DWORD WINAPI ThreadF(void* param);
+    static unsigned ThreadEH(void* param);
+    unsigned ThreadBody();
+
+    // copies the file of 'item' using 'buffer'; returns TRUE on success, in 'copied'
+    // returns the number of copied bytes; on failure the target file is removed
+    BOOL CopyItem(CParallelCopyItem* item, void* buffer, CQuadWord* copied);
+
+    // removes the target file of 'item' copied by a helper thread
+    void RemoveTarget(CParallelCopyItem* item);
+};
+
+CParallelCopyPool::CParallelCopyPool(CProgressDlgData& dlgData)
+{
+    HANDLES(InitializeCriticalSection(&CS));
+    memset(Items, 0, sizeof(Items)); // all slots are pcisFree
+    QueueFirst = 0;
+    QueueCount = 0;
+    Terminate = FALSE;
+    Paused = FALSE;
+    ThreadsCount = 0;
+    WorkerNotSuspended = dlgData.WorkerNotSuspended;
+    CancelWorker = dlgData.CancelWorker;
+    NextDispatch = 0;
+
+    ItemWaiting = HANDLES(CreateSemaphore(NULL, 0, 0x7FFFFFFF, NULL));
+    ItemFinished = HANDLES(CreateEvent(NULL, FALSE, FALSE, NULL));
+    if (ItemWaiting == NULL || ItemFinished == NULL)
+    {
+        TRACE_E("CParallelCopyPool::CParallelCopyPool(): unable to create synchronization objects!");
+        return;
+    }
+
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    int threads = (int)si.dwNumberOfProcessors;
+    if (threads < 2)
+        threads = 2; // the work is mostly waiting for the disk, so even a single CPU gains from two threads
+    if (threads > PARALLEL_COPY_MAX_THREADS)
+        threads = PARALLEL_COPY_MAX_THREADS;
+    int i;
+    for (i = 0; i < threads; i++)
+    {
+        DWORD threadID;
+        Threads[ThreadsCount] = HANDLES(CreateThread(NULL, 0, ThreadF, this, 0, &threadID));
+        if (Threads[ThreadsCount] == NULL)
+        {
+            TRACE_E("CParallelCopyPool::CParallelCopyPool(): unable to start helper thread.");
+            break;
+        }
+        ThreadsCount++;
+    }
+}
+
+CParallelCopyPool::~CParallelCopyPool()
+{
+    if (ThreadsCount > 0)
+    {
+        HANDLES(EnterCriticalSection(&CS));
+        Terminate = TRUE; // waiting items are left alone; the one being copied is finished or cancelled
+        HANDLES(LeaveCriticalSection(&CS));
+        ReleaseSemaphore(ItemWaiting, ThreadsCount, NULL);
+        WaitForMultipleObjects(ThreadsCount, Threads, TRUE, INFINITE);
+        int i;
+        for (i = 0; i < ThreadsCount; i++)
+            HANDLES(CloseHandle(Threads[i]));
+        // files the worker did not get to (cancel, error) must not stay in the target,
+        // the sequential copy would not have created them
+        for (i = 0; i < PARALLEL_COPY_WINDOW; i++)
+        {
+            if (Items[i].State == pcisDone)
+                RemoveTarget(&Items[i]);
+        }
+    }
+    if (ItemWaiting != NULL)
+        HANDLES(CloseHandle(ItemWaiting));
+    if (ItemFinished != NULL)
+        HANDLES(CloseHandle(ItemFinished));
+    HANDLES(DeleteCriticalSection(&CS));
+}
+
+BOOL CParallelCopyPool::CanCopyInParallel(COperations* script, COperation* op)
+{
+    BOOL useSpeedLimit;
+    DWORD speedLimit;
+    script->GetSpeedLimit(&useSpeedLimit, &speedLimit);
+    return op->Opcode == ocCopyFile &&
+           op->FileSize <= CQuadWord(PARALLEL_COPY_MAX_FILE_SIZE, 0) &&
+           (op->OpFlags & (OPFL_COPY_ADS | OPFL_AS_ENCRYPTED)) == 0 &&
+           (op->OpFlags & OPFL_SRCPATH_IS_FAST) && (op->OpFlags & OPFL_TGTPATH_IS_FAST) && // local disks only (Lantastic check, async algorithm, etc. concern network paths)
+           !script->RemovableSrcDisk && !script->RemovableTgtDisk &&
+           !script->CopyAttrs && !script->CopySecurity &&
+           !useSpeedLimit && !script->ChangeSpeedLimit &&
+           !FileNameIsInvalid(op->SourceName, TRUE) && !FileNameIsInvalid(op->TargetName, TRUE);
+}
+
+void CParallelCopyPool::Dispatch(COperations* script, int index, DWORD clearReadonlyMask)
+{
+    if (NextDispatch < index)
+        NextDispatch = index; // operations in front of 'index' were processed by the worker (barriers, skipped dirs, etc.)
+    int added = 0;
+    HANDLES(EnterCriticalSection(&CS));
+    while (!Paused && NextDispatch < script->Count && NextDispatch < index + PARALLEL_COPY_WINDOW)
+    {
+        COperation* op = &script->At(NextDispatch);
+        if (op->Opcode != ocCopyFile)
+            break; // barrier: we wait until the worker gets here
+        if (CanCopyInParallel(script, op))
+        {
+            int slot = NextDispatch % PARALLEL_COPY_WINDOW;
+            CParallelCopyItem* item = &Items[slot];
+            if (item->State != pcisFree)
+            {
+                TRACE_E("CParallelCopyPool::Dispatch(): unexpected state of slot " << slot << ": " << item->State);
+                break;
+            }
+            item->State = pcisWaiting;
+            item->Index = NextDispatch;
+            item->Op = op;
+            item->Attr = op->Attr & clearReadonlyMask;
+            item->Copied = CQuadWord(0, 0);
+            Queue[(QueueFirst + QueueCount) % PARALLEL_COPY_WINDOW] = slot;
+            QueueCount++;
+            added++;
+        }
+        NextDispatch++;
+    }
+    HANDLES(LeaveCriticalSection(&CS));
+    if (added > 0)
+        ReleaseSemaphore(ItemWaiting, added, NULL);
+}
+
+BOOL CParallelCopyPool::GetResult(int index, CQuadWord* copied)
+{
+    CParallelCopyItem* item = &Items[index % PARALLEL_COPY_WINDOW];
+    BOOL ret = FALSE;
+    HANDLES(EnterCriticalSection(&CS));
+    if (item->State != pcisFree && item->Index == index)
+    {
+        if (item->State == pcisWaiting) // nobody took it yet, the worker copies it itself (avoids waiting for a helper)
+        {
+            int i;
+            for (i = 0; i < QueueCount; i++)
+            {
+                int* q = &Queue[(QueueFirst + i) % PARALLEL_COPY_WINDOW];
+                if (*q == index % PARALLEL_COPY_WINDOW)
+                {
+                    for (; i + 1 < QueueCount; i++) // remove it from the queue (keeping the order of the rest)
+                    {
+                        int* next = &Queue[(QueueFirst + i + 1) % PARALLEL_COPY_WINDOW];
+                        *q = *next;
+                        q = next;
+                    }
+                    QueueCount--;
+                    break;
+                }
+            }
+            // ItemWaiting stays one higher than QueueCount, the helper that takes it finds an empty queue
+        }
+        else
+        {
+            while (item->State == pcisCopying)
+            {
+                HANDLES(LeaveCriticalSection(&CS));
+                WaitForSingleObject(ItemFinished, INFINITE);
+                HANDLES(EnterCriticalSection(&CS));
+            }
+            if (item->State == pcisDone)
+            {
+                *copied = item->Copied;
+                ret = TRUE;
+            }
+            else
+                Paused = TRUE; // nothing more is copied ahead until the worker is done with this file
+        }
+        item->State = pcisFree;
+    }
+    HANDLES(LeaveCriticalSection(&CS));
+    return ret;
+}
+
+void CParallelCopyPool::Resume()
+{
+    HANDLES(EnterCriticalSection(&CS));
+    int waiting = Paused ? QueueCount : 0;
+    Paused = FALSE;
+    HANDLES(LeaveCriticalSection(&CS));
+    if (waiting > 0) // wake-ups consumed by the helpers while paused
+        ReleaseSemaphore(ItemWaiting, waiting, NULL);
+}
+
+DWORD WINAPI CParallelCopyPool::ThreadF(void* param)
+{
+    CCallStack stack;
+    return ThreadEH(param);
+}
+
+unsigned CParallelCopyPool::ThreadEH(void* param)
+{
+#ifndef CALLSTK_DISABLE
+    __try
+    {
+#endif // CALLSTK_DISABLE
+        return ((CParallelCopyPool*)param)->ThreadBody();
+#ifndef CALLSTK_DISABLE
+    }
+    __except (CCallStack::HandleException(GetExceptionInformation()))
+    {
+        TRACE_I("Thread Parallel Copy: calling ExitProcess(1).");
+        //    ExitProcess(1);
+        TerminateProcess(GetCurrentProcess(), 1); // harsher exit (this one still invokes something)
+        return 1;
+    }
+#endif // CALLSTK_DISABLE
+}
+
+unsigned CParallelCopyPool::ThreadBody()
+{
+    CALL_STACK_MESSAGE1("CParallelCopyPool::ThreadBody()");
+    SetThreadNameInVCAndTrace("ParallelCopy");
+
+    void* buffer = malloc(PARALLEL_COPY_BUF_SIZE);
+    if (buffer == NULL)
+        TRACE_E(LOW_MEMORY); // we keep taking items and returning them to the worker
+    while (1)
+    {
+        WaitForSingleObject(ItemWaiting, INFINITE);
+
+        HANDLES(EnterCriticalSection(&CS));
+        if (Terminate)
+        {
+            HANDLES(LeaveCriticalSection(&CS));
+            break;
+        }
+        if (QueueCount == 0 || Paused) // the worker took the item back (see GetResult) or paused us (see Resume)
+        {
+            HANDLES(LeaveCriticalSection(&CS));
+            continue;
+        }
+        CParallelCopyItem* item = &Items[Queue[QueueFirst]];
+        QueueFirst = (QueueFirst + 1) % PARALLEL_COPY_WINDOW;
+        QueueCount--;
+        item->State = pcisCopying;
+        HANDLES(LeaveCriticalSection(&CS));
+
+        CQuadWord copied(0, 0);
+        BOOL ok = buffer != NULL && CopyItem(item, buffer, &copied);
+
+        HANDLES(EnterCriticalSection(&CS));
+        item->Copied = copied;
+        item->State = ok ? pcisDone : pcisFallback;
+        HANDLES(LeaveCriticalSection(&CS));
+        SetEvent(ItemFinished);
+    }
+    if (buffer != NULL)
+        free(buffer);
+    return 0;
+}
+
+BOOL CParallelCopyPool::CopyItem(CParallelCopyItem* item, void* buffer, CQuadWord* copied)
+{
+    COperation* op = item->Op;
+    *copied = CQuadWord(0, 0);
+
+    WaitForSingleObject(WorkerNotSuspended, INFINITE); // if we should be in suspend mode, wait ...
+    if (*CancelWorker)
+        return FALSE;
+
+    HANDLE in = HANDLES_Q(CreateFile(op->SourceName, GENERIC_READ,
+                                     FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                                     OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL));
+    if (in == INVALID_HANDLE_VALUE)
+        return FALSE; // the worker reports the error
+    // CREATE_NEW: existing target (overwrite confirmation, conflict with DOS name, etc.) is left to DoCopyFile
+    HANDLE out = HANDLES_Q(CreateFile(op->TargetName, GENERIC_WRITE, 0, NULL,
+                                      CREATE_NEW, FILE_FLAG_SEQUENTIAL_SCAN, NULL));
+    if (out == INVALID_HANDLE_VALUE)
+    {
+        HANDLES(CloseHandle(in));
+        return FALSE;
+    }
+
+    BOOL ok = TRUE;
+    DWORD read, written;
+    while (1)
+    {
+        if (!ReadFile(in, buffer, PARALLEL_COPY_BUF_SIZE, &read, NULL))
+        {
+            ok = FALSE;
+            break;
+        }
+        if (read == 0)
+            break; // EOF
+        if (!WriteFile(out, buffer, read, &written, NULL) || read != written)
+        {
+            ok = FALSE;
+            break;
+        }
+        *copied += CQuadWord(read, 0);
+
+        WaitForSingleObject(WorkerNotSuspended, INFINITE); // if we should be in suspend mode, wait ...
+        if (*CancelWorker)
+        {
+            ok = FALSE;
+            break;
+        }
+    }
+
+    FILETIME lastWrite;
+    if (ok && (!GetFileTime(in, NULL, NULL, &lastWrite) || !SetFileTime(out, NULL, NULL, &lastWrite)))
+        ok = FALSE; // the worker offers Retry/Ignore/Skip
+    HANDLES(CloseHandle(in));
+    if (!HANDLES(CloseHandle(out)))
+        ok = FALSE;
+
+    if (ok)
+        SetFileAttributes(op->TargetName, item->Attr | FILE_ATTRIBUTE_ARCHIVE); // same as DoCopyFile without script->CopyAttrs
+    else
+    {
+        if (DeleteFile(op->TargetName) == 0)
+        {
+            DWORD err = GetLastError();
+            TRACE_E("CParallelCopyPool::CopyItem(): Unable to remove newly created file: " << op->TargetName << ", error: " << GetErrorText(err));
+        }
+    }
+    return ok;
+}
+
+void CParallelCopyPool::RemoveTarget(CParallelCopyItem* item)
+{
+    ClearReadOnlyAttr(item->Op->TargetName, item->Attr | FILE_ATTRIBUTE_ARCHIVE);
+    if (DeleteFile(item->Op->TargetName) == 0)
+    {
+        DWORD err = GetLastError();
+        TRACE_E("CParallelCopyPool::RemoveTarget(): Unable to remove copied file: " << item->Op->TargetName << ", error: " << GetErrorText(err));
+    }
+}
+
 unsigned ThreadWorkerBody(void* parameter)
 {
     CALL_STACK_MESSAGE1("ThreadWorkerBody()");
@@ -7879,6 +8305,8 @@ unsigned ThreadWorkerBody(void* parameter)
     BOOL novellRenamePatch = FALSE; // TRUE when the read-only attribute must be cleared before MoveFile (required on Novell)
     char* tgtBuffer = NULL;         // conversion buffer for ocConvert
     CAsyncCopyParams* asyncPar = NULL;
+    CParallelCopyPool* parallelCopy = NULL; // created on the first ocCopyFile suitable for parallel copying
+    BOOL parallelCopyFailed = FALSE;        // TRUE = helper threads for parallel copying could not be started
     if (buffer != NULL)
     {
         // prefetch strings so we do not load them for every operation individually (fills the LoadStr buffer quickly + throttles)
@@ -7916,6 +8344,32 @@ unsigned ThreadWorkerBody(void* parameter)
 
                 SetProgress(hProgressDlg, 0, CaclProg(totalDone, script->TotalSize), dlgData);
 
+                if (parallelCopy == NULL && !parallelCopyFailed && Configuration.UseParallelCopy &&
+                    CParallelCopyPool::CanCopyInParallel(script, op))
+                {
+                    parallelCopy = new CParallelCopyPool(dlgData);
+                    if (!parallelCopy->IsGood()) // no helper threads, do not try it again
+                    {
+                        delete parallelCopy;
+                        parallelCopy = NULL;
+                        parallelCopyFailed = TRUE;
+                    }
+                }
+                if (parallelCopy != NULL)
+                {
+                    parallelCopy->Dispatch(script, i, clearReadonlyMask);
+                    CQuadWord copied;
+                    if (parallelCopy->GetResult(i, &copied)) // copied by a helper thread, only account it (like DoCopyFile)
+                    {
+                        script->AddBytesToSpeedMetersAndTFSandPS((DWORD)copied.Value, FALSE, OPERATION_BUFFER);
+                        if (copied < COPY_MIN_FILE_SIZE) // zero/small files take at least as long as files of size COPY_MIN_FILE_SIZE
+                            script->AddBytesToSpeedMetersAndTFSandPS((DWORD)(COPY_MIN_FILE_SIZE - copied).Value, TRUE, 0, NULL, MAX_OP_FILESIZE);
+                        totalDone += op->Size;
+                        script->SetProgressSize(totalDone);
+                        break;
+                    }
+                }
+
                 BOOL lantasticCheck = IsLantasticDrive(op->TargetName, lastLantasticCheckRoot, lastIsLantasticPath);
 
                 Error = !DoCopyFile(op, hProgressDlg, buffer, script, totalDone,
@@ -7924,6 +8378,8 @@ unsigned ThreadWorkerBody(void* parameter)
                                     (op->OpFlags & OPFL_COPY_ADS) != 0,
                                     (op->OpFlags & OPFL_AS_ENCRYPTED) != 0,
                                     FALSE, asyncPar);
+                if (parallelCopy != NULL && !Error)
+                    parallelCopy->Resume();
                 break;
             }
 
@@ -8183,6 +8639,8 @@ unsigned ThreadWorkerBody(void* parameter)
             }
         }
     }
+    if (parallelCopy != NULL)
+        delete parallelCopy; // waits for the helper threads (the files being copied are finished or removed)
     if (asyncPar != NULL)
         delete asyncPar;
     if (tgtBuffer != NULL)
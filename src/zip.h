@@ -146,6 +146,13 @@ struct CSalamanderDirectoryAddCache
     CSalamanderDirectory* Dir; // pointer to the CSalamanderDirectory to which files and directories with the 'Path' path are being added
 };
 
+// item of the hash index of subdirectory names (see CSalamanderDirectory::DirsIndex)
+struct CSalamanderDirectoryIndexItem
+{
+    DWORD Hash; // hash of the directory name (see CSalamanderDirectory::GetDirNameHash)
+    int Index;  // index in CSalamanderDirectory::Dirs; -1 = empty item
+};
+
 class CSalamanderDirectory : public CSalamanderDirectoryAbstract
 {
 protected:
@@ -156,6 +163,8 @@ protected:
     DWORD Flags;                                   // object flags (see SALDIRFLAG_XXX)
     BOOL IsForFS;                                  // TRUE if this is a sal-dir for FS, FALSE if it is a sal-dir for archives
     CSalamanderDirectoryAddCache* AddCache;        // if not NULL, used to optimize adding files via AddFile; otherwise unused
+    CSalamanderDirectoryIndexItem* DirsIndex;      // if not NULL, hash index of names in Dirs (open addressing); built on first search in a directory with many subdirectories
+    int DirsIndexSize;                             // number of items in DirsIndex (power of two)
 
 public:
     CSalamanderDirectory(BOOL isForFS, DWORD validData = VALID_DATA_ALL_FS_ARC, DWORD flags = -1 /* set according to isForFS */);
@@ -248,6 +257,18 @@ protected:
     BOOL FindDir(const char* path, const char*& s, int& i, const CFileData& file,
                  CPluginDataInterfaceAbstract* pluginData, const char* archivePath);
 
+    // returns the index of the first subdirectory (in Dirs) with the name 'name' of length 'nameLen',
+    // returns -1 if there is no such subdirectory; in directories with many subdirectories
+    // it uses (and builds if needed) the hash index DirsIndex
+    int FindDirIndex(const char* name, int nameLen);
+
+    // hash index of subdirectory names: the hash respects SALDIRFLAG_CASESENSITIVE; the index is
+    // just an optimization, if its allocation fails, the subdirectories are searched linearly
+    DWORD GetDirNameHash(const char* name, int nameLen);
+    BOOL BuildDirsIndex();
+    void AddToDirsIndex(int index); // must be called after adding a directory to the end of Dirs
+    void ReleaseDirsIndex();        // must be called after any other change of Dirs
+
     // the AddFileInt and AddDirInt methods return a pointer to CSalamanderDirectory on success,
     // into which the item was added; otherwise they return NULL
     CSalamanderDirectory* AddFileInt(const char* path, CFileData& file,